@@ -0,0 +1,176 @@
+#include "AlgoBuilder.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTimer>
+
+#include "AssertMacros.h"
+#include "ProcessUtilities.h"
+
+namespace mms {
+
+AlgoBuilder::AlgoBuilder(const QVector<Target> &targets, int maxJobs,
+                         QTextStream *log, QObject *parent)
+    : QObject(parent),
+      m_targets(QVector<Target>()),
+      m_maxJobs(maxJobs),
+      m_log(log),
+      m_nextIndex(0),
+      m_numRunning(0),
+      m_failures(0) {
+  ASSERT_LT(0, m_maxJobs);
+  ASSERT_FA(m_log == nullptr);
+  // Tournaments often run several algos from one build
+  for (const Target &target : targets) {
+    bool isDuplicate = false;
+    for (const Target &other : m_targets) {
+      isDuplicate = isDuplicate || (other.directory == target.directory &&
+                                    other.buildCommand == target.buildCommand);
+    }
+    if (!isDuplicate) {
+      m_targets.append(target);
+    }
+  }
+}
+
+void AlgoBuilder::start() {
+  // Wait for the event loop, so that finished() isn't emitted before it starts
+  QTimer::singleShot(0, this, &AlgoBuilder::startBuilds);
+}
+
+void AlgoBuilder::startBuilds() {
+  while (m_numRunning < m_maxJobs && m_nextIndex < m_targets.size()) {
+    m_nextIndex += 1;
+    startBuild(m_nextIndex - 1);
+  }
+  if (m_numRunning == 0 && m_nextIndex == m_targets.size()) {
+    emit finished(m_failures == 0 ? 0 : 1);
+  }
+}
+
+void AlgoBuilder::startBuild(int index) {
+  const Target &target = m_targets.at(index);
+  if (target.buildCommand.isEmpty()) {
+    *m_log << QString("%1 has no build command.").arg(target.name)
+           << Qt::endl;
+    return;
+  }
+
+  // Skipped if the directory is just as the last successful build left it
+  QByteArray manifest = getManifest(target.directory, target.buildCommand);
+  QString manifestPath =
+      getManifestPath(target.directory, target.buildCommand);
+  QFile manifestFile(manifestPath);
+  if (!manifest.isEmpty() && !manifestPath.isEmpty() &&
+      manifestFile.open(QFile::ReadOnly) &&
+      manifestFile.readAll() == manifest) {
+    *m_log << QString("%1 is up to date.").arg(target.name) << Qt::endl;
+    return;
+  }
+
+  Build *build = new Build();
+  build->index = index;
+  build->process = new QProcess();
+  build->manifest = manifest;
+  build->process->setProcessChannelMode(QProcess::MergedChannels);
+  connect(build->process,
+          static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+              &QProcess::finished),
+          this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+            onBuildExit(build, exitCode, exitStatus);
+          });
+  if (!ProcessUtilities::start(target.buildCommand, target.directory,
+                               build->process)) {
+    *m_log << QString("Could not start the build of %1: %2")
+                  .arg(target.name)
+                  .arg(build->process->errorString())
+           << Qt::endl;
+    m_failures += 1;
+    build->process->disconnect(this);
+    delete build->process;
+    delete build;
+    return;
+  }
+  m_numRunning += 1;
+}
+
+void AlgoBuilder::onBuildExit(Build *build, int exitCode,
+                              QProcess::ExitStatus exitStatus) {
+  const Target &target = m_targets.at(build->index);
+  if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+    *m_log << QString("Built %1.").arg(target.name) << Qt::endl;
+    // The manifest is of the directory as the build left it, so that its own
+    // output doesn't make the next batch build it again
+    QString manifestPath =
+        getManifestPath(target.directory, target.buildCommand);
+    QByteArray manifest = getManifest(target.directory, target.buildCommand);
+    if (!manifestPath.isEmpty() && !manifest.isEmpty() &&
+        QDir().mkpath(QFileInfo(manifestPath).path())) {
+      QSaveFile file(manifestPath);
+      if (file.open(QIODevice::WriteOnly)) {
+        file.write(manifest);
+        file.commit();
+      }
+    }
+  } else {
+    *m_log << QString("Could not build %1:").arg(target.name) << Qt::endl;
+    *m_log << QString::fromLocal8Bit(build->process->readAll()) << Qt::flush;
+    m_failures += 1;
+  }
+
+  // The process may still be emitting signals, so defer deletion
+  build->process->disconnect(this);
+  build->process->deleteLater();
+  delete build;
+  m_numRunning -= 1;
+
+  // Start more builds from the event loop, not from within a signal handler
+  QTimer::singleShot(0, this, &AlgoBuilder::startBuilds);
+}
+
+QByteArray AlgoBuilder::getManifest(const QString &directory,
+                                    const QString &buildCommand) {
+  QDir root(directory);
+  if (!root.exists()) {
+    return QByteArray();
+  }
+  // Sorted, since the order of iteration depends on the file system
+  QStringList lines;
+  QDirIterator iterator(directory, QDir::Files | QDir::Hidden,
+                        QDirIterator::Subdirectories);
+  while (iterator.hasNext()) {
+    iterator.next();
+    QFileInfo info = iterator.fileInfo();
+    lines.append(QString("%1,%2,%3")
+                     .arg(root.relativeFilePath(info.filePath()))
+                     .arg(info.size())
+                     .arg(info.lastModified().toMSecsSinceEpoch()));
+  }
+  lines.sort();
+  lines.prepend(buildCommand);
+  return QCryptographicHash::hash(lines.join('\n').toUtf8(),
+                                  QCryptographicHash::Sha1)
+      .toHex();
+}
+
+QString AlgoBuilder::getManifestPath(const QString &directory,
+                                     const QString &buildCommand) {
+  QString cache =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (cache.isEmpty()) {
+    return QString();
+  }
+  QByteArray key = QCryptographicHash::hash(
+      (QDir(directory).absolutePath() + '\n' + buildCommand).toUtf8(),
+      QCryptographicHash::Sha1);
+  return QDir(cache).filePath(QString("builds/%1").arg(QString(key.toHex())));
+}
+
+}  // namespace mms
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+namespace mms {
+
+// The AlgoBuilder builds every algo of a batch (or tournament) before any of
+// them are run, with up to a given number of builds at once. An algo whose
+// directory hasn't changed since its last successful build, by the size and
+// modification time of every file in it, is skipped; the state of each
+// directory after its build is kept in a manifest in the cache location, not
+// in the directory itself, so that the manifest never changes the algo.
+class AlgoBuilder : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Target {
+    QString name;
+    QString directory;
+    QString buildCommand;
+  };
+
+  // Targets with the same directory and build command are only built once.
+  // A line is written to the log (which isn't owned by the builder) for each
+  // target, along with the output of any build that fails.
+  AlgoBuilder(const QVector<Target> &targets, int maxJobs, QTextStream *log,
+              QObject *parent = nullptr);
+
+  void start();
+
+ signals:
+  // The exit code is nonzero if any of the builds failed
+  void finished(int exitCode);
+
+ private:
+  struct Build {
+    int index;  // of the target
+    QProcess *process;
+    QByteArray manifest;  // the state of the directory before the build
+  };
+
+  QVector<Target> m_targets;
+  int m_maxJobs;
+  QTextStream *m_log;
+
+  int m_nextIndex;
+  int m_numRunning;
+  int m_failures;
+
+  void startBuilds();
+  void startBuild(int index);
+  void onBuildExit(Build *build, int exitCode,
+                   QProcess::ExitStatus exitStatus);
+
+  // A hash of the build command and of the path, size, and modification time
+  // of every file under the directory; empty if the directory can't be read
+  static QByteArray getManifest(const QString &directory,
+                                const QString &buildCommand);
+
+  // Empty if there's nowhere to keep manifests
+  static QString getManifestPath(const QString &directory,
+                                 const QString &buildCommand);
+};
+
+}  // namespace mms
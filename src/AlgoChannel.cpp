@@ -0,0 +1,223 @@
+#include "AlgoChannel.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+
+#include "ProcessUtilities.h"
+
+namespace mms {
+
+AlgoChannel::AlgoChannel(QObject *parent)
+    : QIODevice(parent),
+      m_numProcessed(0),
+      m_processId(0),
+      m_process(new QProcess()),
+      m_script(nullptr),
+      m_parser(CommandParser()),
+      m_isKilled(false),
+      m_isAwaitingHandshake(false),
+      m_pendingBytes(QByteArray()),
+      m_numHandedOver(0),
+      m_numAllowed(0) {
+  // Using the process as the context runs these on the channel's thread
+  connect(m_process, &QProcess::readyReadStandardOutput, m_process,
+          [=]() { readOutput(); });
+  connect(m_process, &QProcess::readyReadStandardError, m_process,
+          [=]() { emit standardErrorRead(m_process->readAllStandardError()); });
+  connect(m_process,
+          static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+              &QProcess::finished),
+          m_process, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+            if (m_isKilled) {
+              return;
+            }
+            // Commands always arrive before the exit
+            readOutput();
+            emit finished(exitCode, exitStatus);
+          });
+  m_process->moveToThread(&m_thread);
+  m_thread.start();
+}
+
+AlgoChannel::~AlgoChannel() {
+  if (m_script != nullptr) {
+    m_script->interrupt();
+  }
+  QMetaObject::invokeMethod(
+      m_process,
+      [=]() {
+        // By now, the script has returned
+        delete m_script;
+        if (m_process->state() != QProcess::NotRunning) {
+          m_isKilled = true;
+          m_process->kill();
+          m_process->waitForFinished();
+        }
+        delete m_process;
+      },
+      Qt::BlockingQueuedConnection);
+  m_thread.quit();
+  m_thread.wait();
+}
+
+bool AlgoChannel::start(const QString &command, const QString &directory) {
+  if (ScriptAlgo::isScript(command)) {
+    return startScript(QDir(directory).absoluteFilePath(command.trimmed()));
+  }
+  bool started = false;
+  QString error;
+  qint64 processId = 0;
+  QMetaObject::invokeMethod(
+      m_process,
+      [&]() {
+        started = ProcessUtilities::start(command, directory, m_process);
+        error = m_process->errorString();
+        processId = m_process->processId();
+      },
+      Qt::BlockingQueuedConnection);
+  if (!started) {
+    setErrorString(error);
+    return false;
+  }
+  m_processId = processId;
+  return open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+void AlgoChannel::kill() {
+  if (m_script != nullptr) {
+    m_script->interrupt();
+    // Blocks until the script has returned
+    QMetaObject::invokeMethod(m_process, []() {},
+                              Qt::BlockingQueuedConnection);
+    close();
+    emit finished(0, QProcess::CrashExit);
+    return;
+  }
+  int exitCode = 0;
+  QProcess::ExitStatus exitStatus = QProcess::CrashExit;
+  QMetaObject::invokeMethod(
+      m_process,
+      [&]() {
+        m_isKilled = true;
+        m_process->kill();
+        m_process->waitForFinished();
+        exitCode = m_process->exitCode();
+        exitStatus = m_process->exitStatus();
+      },
+      Qt::BlockingQueuedConnection);
+  close();
+  emit finished(exitCode, exitStatus);
+}
+
+qint64 AlgoChannel::getProcessId() const { return m_processId; }
+
+void AlgoChannel::resolveHandshake(bool accepted) {
+  if (m_script != nullptr) {
+    m_script->resolveHandshake(accepted);
+    return;
+  }
+  QMetaObject::invokeMethod(m_process, [=]() {
+    // As with a single-threaded simulation, text after the request is
+    // dropped if the handshake is accepted
+    if (accepted) {
+      m_parser.useBinaryProtocol();
+    }
+    m_isAwaitingHandshake = false;
+    m_parser.append(m_pendingBytes);
+    m_pendingBytes.clear();
+    parseOutput();
+  });
+}
+
+void AlgoChannel::allowCommands(int numProcessed, int room) {
+  // Since the room is as of now, it doesn't account for batches that are
+  // still in flight, but those were handed over, and so count against the
+  // total, before they were processed
+  m_numProcessed += numProcessed;
+  qint64 numAllowed = m_numProcessed + room;
+  if (m_script != nullptr) {
+    m_script->allowCommands(numAllowed);
+    return;
+  }
+  QMetaObject::invokeMethod(m_process, [=]() {
+    if (m_numAllowed < numAllowed) {
+      m_numAllowed = numAllowed;
+      if (!m_isAwaitingHandshake) {
+        parseOutput();
+      }
+    }
+  });
+}
+
+bool AlgoChannel::isSequential() const { return true; }
+
+qint64 AlgoChannel::readData(char *, qint64) {
+  // Output is only ever handed over as parsed commands
+  return -1;
+}
+
+qint64 AlgoChannel::writeData(const char *data, qint64 maxSize) {
+  QByteArray bytes(data, static_cast<int>(maxSize));
+  if (m_script != nullptr) {
+    m_script->addResponses(bytes);
+    return maxSize;
+  }
+  QMetaObject::invokeMethod(m_process, [=]() { m_process->write(bytes); });
+  return maxSize;
+}
+
+bool AlgoChannel::startScript(const QString &path) {
+  if (!QFileInfo(path).isFile()) {
+    setErrorString(QString("No such script: %1").arg(path));
+    return false;
+  }
+  m_script = new ScriptAlgo(path);
+  connect(m_script, &ScriptAlgo::commandsParsed, this,
+          &AlgoChannel::commandsParsed, Qt::DirectConnection);
+  connect(m_script, &ScriptAlgo::standardErrorRead, this,
+          &AlgoChannel::standardErrorRead, Qt::DirectConnection);
+  connect(
+      m_script, &ScriptAlgo::finished, this,
+      [=](int exitCode) { emit finished(exitCode, QProcess::NormalExit); },
+      Qt::DirectConnection);
+  m_script->moveToThread(&m_thread);
+  QMetaObject::invokeMethod(m_script, [=]() { m_script->run(); });
+  return open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+void AlgoChannel::readOutput() {
+  QByteArray bytes = m_process->readAllStandardOutput();
+  if (m_isAwaitingHandshake) {
+    m_pendingBytes.append(bytes);
+    return;
+  }
+  m_parser.append(bytes);
+  parseOutput();
+}
+
+void AlgoChannel::parseOutput() {
+  QVector<Command> commands;
+  CommandParser::Status status = CommandParser::Status::NONE;
+  do {
+    // The rest is parsed once more commands are allowed
+    qint64 room = m_numAllowed - m_numHandedOver;
+    if (room <= 0) {
+      break;
+    }
+    commands.clear();
+    status = m_parser.parse(&commands, static_cast<int>(room));
+    if (commands.isEmpty() && status == CommandParser::Status::NONE) {
+      break;
+    }
+    m_numHandedOver += commands.size();
+    emit commandsParsed(commands, status);
+    if (status == CommandParser::Status::HANDSHAKE) {
+      // The protocol of what follows depends on the simulation's answer
+      m_isAwaitingHandshake = true;
+      break;
+    }
+  } while (status != CommandParser::Status::NONE);
+}
+
+}  // namespace mms
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QProcess>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+#include "Command.h"
+#include "CommandParser.h"
+#include "ScriptAlgo.h"
+
+namespace mms {
+
+// Runs an algo process on a thread of its own. The algo's stdout is read and
+// parsed on that thread, and only the parsed commands are handed over, in
+// batches, to the thread that created the channel, where the simulation
+// runs; responses written to the channel are forwarded to the algo's stdin.
+// That way the GUI thread never does pipe I/O or parsing, and the algo's
+// output keeps being drained while the GUI thread is busy with a frame.
+//
+// Only as many commands are handed over as the simulation has room for (see
+// allowCommands), so an algo that gets ahead, e.g., while the simulation is
+// paused, has the rest of its output held as unparsed bytes rather than as
+// commands queued in the simulation.
+//
+// If the run command is just the path of a script (see ScriptAlgo), the
+// script is run on the channel's thread instead of a process, and its
+// commands are handed over in just the same way.
+class AlgoChannel : public QIODevice {
+  Q_OBJECT
+
+ public:
+  AlgoChannel(QObject *parent = nullptr);
+
+  // Kills the algo if it's still running
+  ~AlgoChannel();
+
+  // Blocks until the algo has started, returns false (see errorString) if it
+  // couldn't be. Once started, the channel is open for writing responses.
+  bool start(const QString &command, const QString &directory);
+
+  // Blocks until the algo has been killed, then emits finished, even if the
+  // algo had already exited (and so finished may already be on its way)
+  void kill();
+
+  // The algo process's id once started, or 0 if the algo is a script; the
+  // id stays set after the process exits, see ProcessUtilities::getUsage
+  qint64 getProcessId() const;
+
+  // Must be called after each batch that stopped at a handshake, with
+  // whether the simulation accepted it; until then, nothing more is parsed
+  void resolveHandshake(bool accepted);
+
+  // Allows commands to be handed over until there are as many in flight as
+  // the given room in the simulation's queue (see
+  // Simulation::getCommandQueueRoom), beyond those that were processed. Must
+  // be called once the algo has started, after processing each batch, with
+  // the number of commands in it, and whenever the simulation emits
+  // readyForCommands; nothing is handed over until it's first called.
+  void allowCommands(int numProcessed, int room);
+
+  bool isSequential() const override;
+
+ signals:
+  void commandsParsed(const QVector<Command> &commands,
+                      CommandParser::Status status);
+  void standardErrorRead(const QByteArray &bytes);
+  void finished(int exitCode, QProcess::ExitStatus exitStatus);
+
+ protected:
+  qint64 readData(char *data, qint64 maxSize) override;
+  qint64 writeData(const char *data, qint64 maxSize) override;
+
+ private:
+  QThread m_thread;
+
+  // The commands that were processed, and the process's id, which are only
+  // touched on the thread that created the channel
+  qint64 m_numProcessed;
+  qint64 m_processId;
+
+  // Lives on the channel's thread, as does everything below it, which must
+  // only be touched there
+  QProcess *m_process;
+
+  // Only set if the algo is a script, in which case the rest is unused, and
+  // the script is only ever handed things under its own lock
+  ScriptAlgo *m_script;
+
+  CommandParser m_parser;
+  bool m_isKilled;
+
+  // Output that arrived while waiting for a handshake to be resolved
+  bool m_isAwaitingHandshake;
+  QByteArray m_pendingBytes;
+
+  // Commands are handed over until the total reaches the total allowed
+  qint64 m_numHandedOver;
+  qint64 m_numAllowed;
+
+  bool startScript(const QString &path);
+  void readOutput();
+  void parseOutput();
+};
+
+}  // namespace mms
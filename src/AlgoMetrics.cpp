@@ -0,0 +1,136 @@
+#include "AlgoMetrics.h"
+
+#include <limits>
+
+#include <QStringList>
+#include <QtNumeric>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int AlgoMetrics::CAPACITY = 4096;
+const int AlgoMetrics::MAX_NAME_LENGTH = 64;
+
+AlgoMetrics::AlgoMetrics()
+    : m_series(QVector<Series>()), m_indices(QHash<QString, int>()) {}
+
+bool AlgoMetrics::isValidName(QStringView name) {
+  if (name.isEmpty() || MAX_NAME_LENGTH < name.size()) {
+    return false;
+  }
+  for (QChar c : name) {
+    bool isAscii = c.unicode() < 0x80;
+    if (!isAscii || (!c.isLetterOrNumber() && c != '_' && c != '.' &&
+                     c != '-' && c != '/')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AlgoMetrics::add(const QString &name, qint64 microseconds,
+                      double value) {
+  auto it = m_indices.constFind(name);
+  int metric = 0;
+  if (it == m_indices.constEnd()) {
+    ASSERT_TR(isValidName(name));
+    metric = m_series.size();
+    m_indices.insert(name, metric);
+    m_series.append({name, QVector<double>(CAPACITY, 0.0),
+                     QVector<qint64>(CAPACITY, 0), 0, 0, 0.0, value, value});
+  } else {
+    metric = *it;
+  }
+  Series &series = m_series[metric];
+  series.values[series.next] = value;
+  series.microseconds[series.next] = microseconds;
+  series.next = (series.next + 1) % CAPACITY;
+  series.total += 1;
+  series.sum += value;
+  series.min = qMin(series.min, value);
+  series.max = qMax(series.max, value);
+}
+
+int AlgoMetrics::getCount() const { return m_series.size(); }
+
+QString AlgoMetrics::getName(int metric) const {
+  return m_series.at(metric).name;
+}
+
+qint64 AlgoMetrics::getTotal(int metric) const {
+  return m_series.at(metric).total;
+}
+
+double AlgoMetrics::getLast(int metric) const {
+  const Series &series = m_series.at(metric);
+  return series.values.at((series.next + CAPACITY - 1) % CAPACITY);
+}
+
+double AlgoMetrics::getMin(int metric) const {
+  return m_series.at(metric).min;
+}
+
+double AlgoMetrics::getMax(int metric) const {
+  return m_series.at(metric).max;
+}
+
+double AlgoMetrics::getMean(int metric) const {
+  const Series &series = m_series.at(metric);
+  return series.sum / series.total;
+}
+
+void AlgoMetrics::getEnvelope(int metric, int spans, QVector<double> *mins,
+                              QVector<double> *maxes) const {
+  ASSERT_LT(0, spans);
+  const Series &series = m_series.at(metric);
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  mins->fill(nan, spans);
+  maxes->fill(nan, spans);
+  int size = getSize(metric);
+  for (int i = 0; i < size; i += 1) {
+    int span = static_cast<int>(static_cast<qint64>(i) * spans / size);
+    double value = series.values.at(getBufferIndex(metric, i));
+    if (qIsNaN(mins->at(span))) {
+      (*mins)[span] = value;
+      (*maxes)[span] = value;
+    } else {
+      (*mins)[span] = qMin(mins->at(span), value);
+      (*maxes)[span] = qMax(maxes->at(span), value);
+    }
+  }
+}
+
+qint64 AlgoMetrics::getFirstMicroseconds(int metric) const {
+  return m_series.at(metric).microseconds.at(getBufferIndex(metric, 0));
+}
+
+qint64 AlgoMetrics::getLastMicroseconds(int metric) const {
+  return m_series.at(metric).microseconds.at(
+      getBufferIndex(metric, getSize(metric) - 1));
+}
+
+QString AlgoMetrics::getSummary() const {
+  QStringList metrics;
+  for (int i = 0; i < getCount(); i += 1) {
+    metrics.append(QString("%1=%2/%3/%4")
+                       .arg(getName(i))
+                       .arg(getMean(i))
+                       .arg(getMin(i))
+                       .arg(getMax(i)));
+  }
+  return metrics.join(";");
+}
+
+int AlgoMetrics::getSize(int metric) const {
+  return static_cast<int>(qMin<qint64>(m_series.at(metric).total, CAPACITY));
+}
+
+int AlgoMetrics::getBufferIndex(int metric, int i) const {
+  // Until the buffer is full, the oldest sample is at the front
+  const Series &series = m_series.at(metric);
+  int oldest = series.total < CAPACITY ? 0 : series.next;
+  return (oldest + i) % CAPACITY;
+}
+
+}  // namespace mms
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <QtGlobal>
+
+namespace mms {
+
+// The metrics that an algo reports about itself with the metric command,
+// e.g., the time its planner takes or the size of its queue. Each metric
+// keeps its latest samples in a ring buffer of fixed capacity, allocated
+// when the metric is first reported, so that a sample costs a hash lookup
+// and a couple of stores however many arrive, along with running totals
+// over every sample of the run.
+class AlgoMetrics {
+ public:
+  AlgoMetrics();
+
+  // Names are up to 64 letters, digits, and "_.-/", so that they can be
+  // written in CSV as they are
+  static bool isValidName(QStringView name);
+
+  // The name must be valid
+  void add(const QString &name, qint64 microseconds, double value);
+
+  int getCount() const;
+  QString getName(int metric) const;
+
+  // Over every sample of the run, not just the buffered ones
+  qint64 getTotal(int metric) const;
+  double getLast(int metric) const;
+  double getMin(int metric) const;
+  double getMax(int metric) const;
+  double getMean(int metric) const;
+
+  // The buffered samples, oldest first, split into the given number of equal
+  // spans, each reduced to its minimum and maximum, e.g., a span per pixel
+  // of a plot; spans without samples are NaN
+  void getEnvelope(int metric, int spans, QVector<double> *mins,
+                   QVector<double> *maxes) const;
+
+  // The virtual time of the oldest and newest buffered samples
+  qint64 getFirstMicroseconds(int metric) const;
+  qint64 getLastMicroseconds(int metric) const;
+
+  // "name=mean/min/max" for each metric, in the order they were first
+  // reported, separated by semicolons, e.g., for a row of a batch
+  QString getSummary() const;
+
+ private:
+  static const int CAPACITY;
+  static const int MAX_NAME_LENGTH;
+
+  struct Series {
+    QString name;
+    QVector<double> values;
+    QVector<qint64> microseconds;
+    int next;  // the index of the next sample, and once full, the oldest
+    qint64 total;
+    double sum;
+    double min;
+    double max;
+  };
+
+  QVector<Series> m_series;
+  QHash<QString, int> m_indices;
+
+  int getSize(int metric) const;
+
+  // The index into the buffers of the ith oldest buffered sample
+  int getBufferIndex(int metric, int i) const;
+};
+
+}  // namespace mms
@@ -0,0 +1,51 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace mms {
+
+thread_local qint64 AllocationCounter::ALLOCATIONS = 0;
+thread_local qint64 AllocationCounter::BYTES = 0;
+
+AllocationCounter::AllocationCounter()
+    : m_allocations(ALLOCATIONS), m_bytes(BYTES) {}
+
+bool AllocationCounter::isEnabled() {
+#if defined(MMS_COUNT_ALLOCATIONS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+qint64 AllocationCounter::getAllocations() const {
+  return ALLOCATIONS - m_allocations;
+}
+
+qint64 AllocationCounter::getBytes() const { return BYTES - m_bytes; }
+
+void AllocationCounter::count(std::size_t bytes) {
+  ALLOCATIONS += 1;
+  BYTES += static_cast<qint64>(bytes);
+}
+
+}  // namespace mms
+
+#if defined(MMS_COUNT_ALLOCATIONS)
+
+// Only the plain forms are replaced: the default array, nothrow, and sized
+// forms all call these, while the aligned forms, which don't, allocate and
+// free with each other and so go uncounted
+void *operator new(std::size_t size) {
+  mms::AllocationCounter::count(size);
+  void *pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+#endif
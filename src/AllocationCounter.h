@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+#include <QtGlobal>
+
+namespace mms {
+
+// Counts the heap allocations made by the current thread, and their bytes,
+// via replacements of the global operator new and delete. The replacements
+// only exist in builds configured with CONFIG+=count_allocations (see
+// mms.pro), since they cost a little on every allocation; in other builds
+// nothing is counted and isEnabled() is false. A counter counts the
+// allocations made since it was constructed, on the thread that
+// constructed it.
+class AllocationCounter {
+ public:
+  AllocationCounter();
+
+  static bool isEnabled();
+
+  qint64 getAllocations() const;
+  qint64 getBytes() const;
+
+  // Called by the replacement operator new
+  static void count(std::size_t bytes);
+
+ private:
+  static thread_local qint64 ALLOCATIONS;
+  static thread_local qint64 BYTES;
+
+  qint64 m_allocations;
+  qint64 m_bytes;
+};
+
+}  // namespace mms
@@ -0,0 +1,1844 @@
+#include "BatchRunner.h"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QThread>
+#include <QtConcurrent>
+
+#include "AssertMacros.h"
+#include "MazeCorpus.h"
+#include "MazePool.h"
+#include "ProcessUtilities.h"
+#include "ResultCache.h"
+#include "ScoringPolicy.h"
+#include "ScriptAlgo.h"
+#include "SimulationCheckpoint.h"
+
+namespace mms {
+
+const int BatchRunner::SAVE_INTERVAL_MILLISECONDS = 10000;
+const int BatchRunner::SOCKET_READ_BUFFER_SIZE = 64 * 1024;
+
+// Enough to stay ahead of short runs, even if every run is of another maze
+const int BatchRunner::PREFETCH_MAZES = 4;
+
+// Often enough that little is missed of an algo that exits on its own
+const int BatchRunner::USAGE_INTERVAL_MILLISECONDS = 100;
+
+const double BatchRunner::CPU_TIMEOUT_REAL_TIME_FACTOR = 10.0;
+
+BatchRunner::BatchRunner(const QStringList &mazeFiles, const QString &directory,
+                         const QString &runCommand, double timeoutSeconds,
+                         int maxJobs, bool useSharedMemory,
+                         PluginAlgo *plugin, const QString &recordDirectory,
+                         QTextStream *output, QObject *parent)
+    : QObject(parent),
+      m_mazeFiles(mazeFiles),
+      m_algos(QVector<Algo>()),
+      m_isTournament(false),
+      m_timeoutSeconds(timeoutSeconds),
+      m_hangTimeoutSeconds(0.0),
+      m_isCpuTimed(false),
+      m_isLatencyTracked(false),
+      m_isUsageTracked(false),
+      m_scoringPolicies(QStringList()),
+      m_resetInjection(ResetInjection()),
+      m_seed(0),
+      m_algoCores(QVector<int>()),
+      m_coreLoads(QVector<int>()),
+      m_isAlgoPriorityRaised(false),
+      m_baseline(nullptr),
+      m_baselineName(QString()),
+      m_maxJobs(maxJobs),
+      m_isJobTuned(false),
+      m_jobTuner(QThread::idealThreadCount(), maxJobs),
+      m_clock(QElapsedTimer()),
+      m_useSharedMemory(useSharedMemory),
+      m_plugin(plugin),
+      m_recordDirectory(recordDirectory),
+      m_heatmapDirectory(QString()),
+      m_traceDirectory(QString()),
+      m_resumeDirectory(QString()),
+      m_output(output),
+      m_repeats(1),
+      m_numSpares(0),
+      m_summary(nullptr),
+      m_isJsonSummary(false),
+      m_resultCacheDirectory(QString()),
+      m_database(nullptr),
+      m_sequentialTest(nullptr),
+      m_algoHashes(QVector<QByteArray>()),
+      m_nextIndex(0),
+      m_numRunning(0),
+      m_nextRowIndex(0),
+      m_failures(0),
+      m_isFinished(false),
+      m_pendingRows(QMap<int, QString>()),
+      m_cellAggregates(QMap<int, StatsAggregate>()),
+      m_scoreDifferences(QMap<int, double>()),
+      m_numScoredRuns(QMap<int, int>()),
+      m_numSummaries(0),
+      m_mazeMetrics(QMap<int, MazeMetrics>()),
+      m_mazes(QMap<int, QSharedPointer<const Maze>>()),
+      m_prefetches(QMap<int, QFuture<Prefetch>>()),
+      m_baselineFields(QMap<int, QString>()),
+      m_scriptRuns(QMap<int, Run *>()),
+      m_pluginRuns(QMap<int, Run *>()),
+      m_pluginScheduler(nullptr),
+      m_liveFeed(nullptr),
+      m_algoServer(nullptr),
+      m_awaitingRuns(QList<Run *>()),
+      m_server(nullptr),
+      m_coordinator(nullptr) {
+  ASSERT_LT(0, m_maxJobs);
+  ASSERT_FA(m_output == nullptr);
+  m_algos.append({QString(), directory, runCommand});
+
+  // Loading mazes is mostly waiting on files, so one thread keeps up
+  m_prefetchPool.setMaxThreadCount(1);
+}
+
+void BatchRunner::setRepeats(int repeats) {
+  ASSERT_LT(0, repeats);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_repeats = repeats;
+}
+
+void BatchRunner::setHangTimeout(double seconds) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_hangTimeoutSeconds = seconds;
+}
+
+void BatchRunner::setCpuTimeout(bool isCpuTimed) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_isCpuTimed = isCpuTimed;
+}
+
+void BatchRunner::setLatencyColumns(bool isLatencyTracked) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_isLatencyTracked = isLatencyTracked;
+}
+
+void BatchRunner::setUsageColumns(bool isUsageTracked) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_isUsageTracked = isUsageTracked;
+}
+
+void BatchRunner::setJobTuning(bool isJobTuned) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_isJobTuned = isJobTuned;
+}
+
+void BatchRunner::setResetInjection(const ResetInjection &injection) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_resetInjection = injection;
+}
+
+void BatchRunner::setSeed(quint32 seed) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_seed = seed;
+}
+
+void BatchRunner::setAlgoPlacement(const QVector<int> &cores,
+                                   bool isPriorityRaised) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_algoCores = cores;
+  m_coreLoads = QVector<int>(cores.size(), 0);
+  m_isAlgoPriorityRaised = isPriorityRaised;
+}
+
+void BatchRunner::setScoringColumns(const QStringList &policies) {
+  ASSERT_EQ(m_nextIndex, 0);
+  for (const QString &policy : policies) {
+    ASSERT_TR(STRING_TO_SCORING().contains(policy));
+  }
+  m_scoringPolicies = policies;
+}
+
+void BatchRunner::setHeatmapDirectory(const QString &directory) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_heatmapDirectory = directory;
+}
+
+void BatchRunner::setTraceDirectory(const QString &directory) {
+  ASSERT_EQ(m_nextIndex, 0);
+  m_traceDirectory = directory;
+}
+
+void BatchRunner::setResumeDirectory(const QString &directory) {
+  ASSERT_TR(m_plugin == nullptr);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_resumeDirectory = directory;
+}
+
+void BatchRunner::setBaseline(PluginAlgo *baseline, const QString &name) {
+  ASSERT_FA(baseline == nullptr);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_baseline = baseline;
+  m_baselineName = name;
+}
+
+void BatchRunner::setSpareAlgos(int numSpares) {
+  ASSERT_LE(0, numSpares);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_numSpares = numSpares;
+}
+
+void BatchRunner::setTournament(const QVector<Algo> &algos) {
+  ASSERT_FA(algos.isEmpty());
+  ASSERT_TR(m_plugin == nullptr);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_algos = algos;
+  m_isTournament = true;
+}
+
+bool BatchRunner::setCheckpoint(const QString &path, QString *error) {
+  ASSERT_TR(m_summary == nullptr);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_checkpoint.setFileName(path);
+  QString key = getCheckpointKey();
+  if (m_checkpoint.exists()) {
+    if (!m_checkpoint.open(QFile::ReadOnly)) {
+      *error = QString("Could not open \"%1\".").arg(path);
+      return false;
+    }
+    // The first line identifies the batch, and each of the others is the
+    // index and status of a run, followed by its row
+    QTextStream stream(&m_checkpoint);
+    QString line;
+    if (stream.readLineInto(&line) && line != key) {
+      *error = QString("\"%1\" is the checkpoint of another batch.")
+                   .arg(path);
+      return false;
+    }
+    while (stream.readLineInto(&line)) {
+      int first = line.indexOf(',');
+      int second = line.indexOf(',', first + 1);
+      bool ok = false;
+      int index = line.left(first).toInt(&ok);
+      if (second == -1 || !ok || index < 0 || getNumRuns() <= index) {
+        // Probably cut short when the batch was interrupted
+        continue;
+      }
+      if (line.mid(first + 1, second - first - 1) != "complete") {
+        m_failures += 1;
+      }
+      m_checkpointedRows.insert(index, line.mid(second + 1));
+    }
+    m_checkpoint.close();
+  }
+  if (!m_checkpoint.open(QFile::WriteOnly | QFile::Append)) {
+    *error = QString("Could not open \"%1\".").arg(path);
+    return false;
+  }
+  if (m_checkpoint.size() == 0) {
+    m_checkpoint.write((key + "\n").toUtf8());
+    m_checkpoint.flush();
+  }
+  return true;
+}
+
+void BatchRunner::setResultCache(const QString &directory) {
+  ASSERT_TR(m_plugin == nullptr);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_resultCacheDirectory = directory;
+  m_algoHashes.clear();
+  for (const Algo &algo : m_algos) {
+    m_algoHashes.append(
+        ResultCache::getAlgoHash(algo.directory, algo.runCommand));
+  }
+}
+
+bool BatchRunner::setResultsDatabase(const QString &path, QString *error) {
+  ASSERT_EQ(m_nextIndex, 0);
+  ASSERT_TR(m_database == nullptr);
+  m_database = ResultsDatabase::open(path, error, this);
+  return m_database != nullptr;
+}
+
+void BatchRunner::setSequentialTest(SequentialTest *test) {
+  ASSERT_EQ(m_nextIndex, 0);
+  ASSERT_TR(m_isTournament);
+  ASSERT_EQ(m_algos.size(), 2);
+  ASSERT_FA(m_checkpoint.isOpen());
+  m_sequentialTest = test;
+}
+
+void BatchRunner::setSummary(QTextStream *summary, bool isJson) {
+  ASSERT_EQ(m_nextIndex, 0);
+  ASSERT_FA(m_checkpoint.isOpen());
+  m_summary = summary;
+  m_isJsonSummary = isJson;
+}
+
+int BatchRunner::getNumRuns() const {
+  return m_mazeFiles.size() * m_algos.size() * m_repeats;
+}
+
+int BatchRunner::getCellIndex(int index) const { return index / m_repeats; }
+
+int BatchRunner::getMazeIndex(int index) const {
+  return getCellIndex(index) / m_algos.size();
+}
+
+int BatchRunner::getAlgoIndex(int index) const {
+  if (m_coordinator != nullptr) {
+    // A worker's algos are only known from its jobs
+    const RemoteProtocol::Job &job = m_jobs[index];
+    for (int i = 0; i < m_algos.size(); i += 1) {
+      if (m_algos.at(i).directory == job.directory &&
+          m_algos.at(i).runCommand == job.runCommand) {
+        return i;
+      }
+    }
+    ASSERT_NEVER_RUNS();
+  }
+  return getCellIndex(index) % m_algos.size();
+}
+
+QString BatchRunner::getMazeFile(int index) const {
+  return m_mazeFiles.at(getMazeIndex(index));
+}
+
+QString BatchRunner::getResumePath(int index) const {
+  return QDir(m_resumeDirectory).filePath(getRunName(index) + ".mmsc");
+}
+
+QString BatchRunner::getRunName(int index) const {
+  QString name = QString::number(getMazeIndex(index));
+  if (m_isTournament) {
+    name += QString("-algo%1").arg(getAlgoIndex(index));
+  }
+  if (1 < m_repeats) {
+    name += QString("-%1").arg(index % m_repeats);
+  }
+  return name;
+}
+
+bool BatchRunner::hasNextIndex() {
+  // Once the comparison is decided, the runs in flight are the last
+  if (m_sequentialTest != nullptr && m_sequentialTest->isDecided()) {
+    return false;
+  }
+
+  // Runs from the checkpoint are written as soon as the rows before them are
+  while (m_nextIndex < getNumRuns() &&
+         m_checkpointedRows.contains(m_nextIndex)) {
+    m_pendingRows.insert(m_nextIndex, m_checkpointedRows.take(m_nextIndex));
+    m_nextIndex += 1;
+  }
+  writeRows();
+  return m_nextIndex < getNumRuns();
+}
+
+int BatchRunner::takeNextIndex() {
+  if (!hasNextIndex()) {
+    return -1;
+  }
+  int index = m_nextIndex;
+  m_nextIndex += 1;
+  return index;
+}
+
+void BatchRunner::start() {
+  m_clock.start();
+  writeHeader();
+  if (m_summary != nullptr) {
+    writeSummaryHeader();
+  }
+
+  // Wait for the event loop, so that finished() isn't emitted before it starts
+  QTimer::singleShot(0, this, &BatchRunner::startRuns);
+}
+
+bool BatchRunner::serve(quint16 port, QString *error) {
+  ASSERT_TR(m_plugin == nullptr);
+  m_server = new QTcpServer(this);
+  if (!m_server->listen(QHostAddress::Any, port)) {
+    *error = QString("Could not listen on port %1: %2")
+                 .arg(port)
+                 .arg(m_server->errorString());
+    return false;
+  }
+  connect(m_server, &QTcpServer::newConnection, this,
+          &BatchRunner::onWorkerConnected);
+  start();
+  return true;
+}
+
+bool BatchRunner::work(const QString &host, quint16 port, QString *error) {
+  ASSERT_TR(m_plugin == nullptr);
+  m_coordinator = new QTcpSocket(this);
+  m_coordinator->connectToHost(host, port);
+  if (!m_coordinator->waitForConnected()) {
+    *error = QString("Could not connect to %1:%2: %3")
+                 .arg(host)
+                 .arg(port)
+                 .arg(m_coordinator->errorString());
+    return false;
+  }
+  // The algos are registered as jobs arrive
+  m_algos.clear();
+  connect(m_coordinator, &QTcpSocket::readyRead, this,
+          &BatchRunner::onCoordinatorReadyRead);
+  connect(m_coordinator, &QTcpSocket::disconnected, this, [=]() {
+    // The coordinator went away without saying that the batch is done
+    emit finished(1);
+  });
+  m_coordinator->write(RemoteProtocol::encodeHello(m_maxJobs));
+  return true;
+}
+
+void BatchRunner::startRuns() {
+  if (m_coordinator != nullptr) {
+    // A worker's runs only start when the coordinator sends them
+    return;
+  }
+  if (m_server != nullptr) {
+    for (Worker *worker : m_workers) {
+      sendJobs(worker);
+    }
+  } else {
+    int maxJobs = m_isJobTuned ? m_jobTuner.getJobs() : m_maxJobs;
+    while (m_numRunning < maxJobs && hasNextIndex()) {
+      startRun(takeNextIndex());
+    }
+    if (m_plugin == nullptr) {
+      startSpareAlgos();
+    }
+  }
+  prefetchMazes();
+  if (m_numRunning == 0 && m_retryIndices.isEmpty() && !hasNextIndex() &&
+      !m_isFinished) {
+    ASSERT_EQ(m_nextRowIndex, m_nextIndex);
+    m_isFinished = true;
+
+    // The workers exit once they're told, and must be told before the event
+    // loop stops
+    for (Worker *worker : m_workers) {
+      worker->socket->write(RemoteProtocol::encodeDone());
+      worker->socket->waitForBytesWritten();
+    }
+
+    // Spares can outnumber the runs that were left, if warm algos took some
+    // of them; deleting a process kills it
+    for (const WarmAlgo &algo : m_spareAlgos) {
+      algo.process->disconnect(this);
+      delete algo.process;
+      delete algo.transport;
+    }
+    m_spareAlgos.clear();
+    if (m_algoServer != nullptr) {
+      m_algoServer->close();
+    }
+    if (m_summary != nullptr) {
+      writeSummaryFooter();
+    }
+    if (m_database != nullptr && !m_database->commit()) {
+      m_failures += 1;
+    }
+    emit finished(m_failures == 0 ? 0 : 1);
+  }
+}
+
+void BatchRunner::startRun(int index, const WarmAlgo *algo) {
+  m_numRunning += 1;
+
+  // A warm algo has already been told to start over, so it needs the run
+  Run *run = createRun(index);
+  run->startNanoseconds = m_clock.nsecsElapsed();
+  run->maze = loadMaze(index);
+  if (algo == nullptr && run->maze != nullptr && finishFromCache(run)) {
+    return;
+  }
+
+  // A spare algo is already running, and is waiting for its first response
+  WarmAlgo spare;
+  for (int i = 0; algo == nullptr && i < m_spareAlgos.size(); i += 1) {
+    if (m_spareAlgos.at(i).algoIndex == getAlgoIndex(index)) {
+      spare = m_spareAlgos.takeAt(i);
+      spare.process->disconnect(this);
+      algo = &spare;
+    }
+  }
+
+  run->process = algo == nullptr ? nullptr : algo->process;
+  run->transport = algo == nullptr ? nullptr : algo->transport;
+  if (run->maze == nullptr) {
+    // A warm algo may have already been told to start over, so it's stopped
+    // along with the run, and the next run starts a fresh one
+    finishRun(run, "invalid-maze");
+    return;
+  }
+
+  // Each run gets fresh stats and a fresh mouse
+  run->stats = new Stats();
+  run->stats->resetAll();
+  bool isRecorded = m_coordinator == nullptr ? !m_recordDirectory.isEmpty()
+                                             : m_jobs[index].isRecorded;
+  if (isRecorded) {
+    run->replayLog = new ReplayLog(run->maze.data());
+  }
+  bool isTraced = m_coordinator == nullptr ? !m_traceDirectory.isEmpty()
+                                           : m_jobs[index].isTraced;
+  if (isTraced) {
+    run->trace = new RunTrace();
+  }
+  if (m_plugin != nullptr) {
+    runPlugin(run);
+    return;
+  }
+  if (m_algoServer != nullptr) {
+    // The run starts once an algo connects
+    m_awaitingRuns.append(run);
+    acceptAlgos();
+    return;
+  }
+  if (algo == nullptr && isScript(getAlgoIndex(index))) {
+    startScript(run);
+    return;
+  }
+  if (algo == nullptr) {
+    WarmAlgo started;
+    bool ok = startAlgo(getAlgoIndex(index), &started);
+    run->process = started.process;
+    run->transport = started.transport;
+    if (!ok) {
+      finishRun(run, "error");
+      return;
+    }
+  }
+  startSimulation(run, algo);
+}
+
+void BatchRunner::startSimulation(Run *run, const WarmAlgo *algo) {
+  double timeoutSeconds = m_timeoutSeconds;
+  bool isCpuTimed = m_isCpuTimed;
+  double hangTimeoutSeconds = m_hangTimeoutSeconds;
+  bool isLatencyTracked = m_isLatencyTracked || isJobTuned();
+  bool isUsageTracked = m_isUsageTracked || isJobTuned();
+  ResetInjection resetInjection = m_resetInjection;
+  if (m_coordinator != nullptr) {
+    const RemoteProtocol::Job &job = m_jobs[run->index];
+    timeoutSeconds = job.timeoutSeconds;
+    isCpuTimed = job.isCpuTimed;
+    hangTimeoutSeconds = job.hangTimeoutSeconds;
+    isLatencyTracked = job.isLatencyTracked;
+    isUsageTracked = job.isUsageTracked;
+
+    // The coordinator only sends schedules that it parsed, and an invalid
+    // one leaves the worker's own, which is empty
+    QString error;
+    ResetInjection::fromSpec(job.resetInjection, &resetInjection, &error);
+  }
+
+  // Only the followed run has a view, since nothing else would ever read it
+  MazeGraphic *view = nullptr;
+  if (m_liveFeed != nullptr && !m_liveFeed->isFollowing()) {
+    run->view = new MazeView(run->maze.data(), false);
+    view = run->view->getMazeGraphic();
+  }
+  if (run->socket != nullptr) {
+    run->simulation =
+        new Simulation(run->maze.data(), view, run->stats, run->socket);
+    run->socket->setReadBufferSize(SOCKET_READ_BUFFER_SIZE);
+    connect(run->socket, &QIODevice::readyRead, this,
+            [=]() { readOutput(run); });
+  } else if (run->channel != nullptr) {
+    run->simulation =
+        new Simulation(run->maze.data(), view, run->stats, run->channel);
+    AlgoChannel *channel = run->channel;
+    int index = run->index;
+    connect(channel, &AlgoChannel::commandsParsed, this,
+            [=](const QVector<Command> &commands,
+                CommandParser::Status status) {
+              if (!m_scriptRuns.contains(index)) {
+                return;
+              }
+              // A handshake behind queued commands is accepted later
+              if (run->simulation->processCommands(commands, status)) {
+                channel->resolveHandshake(true);
+              }
+              channel->allowCommands(commands.size(),
+                                     run->simulation->getCommandQueueRoom());
+            });
+    connect(run->simulation, &Simulation::handshakeAccepted, channel,
+            [=]() { channel->resolveHandshake(true); });
+  } else if (m_useSharedMemory) {
+    run->simulation =
+        new Simulation(run->maze.data(), view, run->stats, run->transport);
+    run->simulation->useBinaryProtocol();
+    connect(run->transport, &QIODevice::readyRead, this,
+            [=]() { readOutput(run); });
+  } else {
+    run->simulation =
+        new Simulation(run->maze.data(), view, run->stats, run->process);
+    if (algo != nullptr && algo->isBinary) {
+      run->simulation->useBinaryProtocol();
+    }
+    connect(run->process, &QProcess::readyReadStandardOutput, this,
+            [=]() { readOutput(run); });
+  }
+  connect(run->simulation, &Simulation::readyForCommands, this,
+          [=]() { readOutput(run); });
+  run->simulation->setInstant(true);
+  if (run->view != nullptr) {
+    m_liveFeed->follow(run->maze.data(), view, run->simulation->getMouse());
+  }
+  run->simulation->setReplayLog(run->replayLog);
+  run->simulation->setTrace(run->trace);
+  run->simulation->setLatencyTracking(isLatencyTracked);
+  run->simulation->setRandomKey(getRandomKey(run));
+  run->simulation->setResetInjection(resetInjection);
+  if ((isUsageTracked || (isCpuTimed && 0 < timeoutSeconds)) &&
+      run->process != nullptr) {
+    startMeasuring(run);
+  }
+
+  // The algo may be stuck, e.g., waiting on a response that it already got,
+  // in which case it would otherwise hold a job until the timeout, if any
+  run->simulation->setHangTimeout(hangTimeoutSeconds);
+  connect(run->simulation, &Simulation::hung, this, [=]() {
+    run->hung = true;
+    stopAlgo(run);
+  });
+
+  // Algos that ask for another maze are kept running for the next run;
+  // answered from the event loop, since the simulation is deleted with the run.
+  // A connected algo is only ever given one maze, so it reconnects for the
+  // next one.
+  if (run->socket != nullptr) {
+    connect(run->simulation, &Simulation::nextMazeRequested, this,
+            [=]() { run->simulation->answerNextMaze(false); });
+  } else {
+    connect(
+        run->simulation, &Simulation::nextMazeRequested, this,
+        [=]() { onNextMazeRequested(run); }, Qt::QueuedConnection);
+  }
+
+  // Clean up on exit, or once a connected algo hangs up
+  if (run->socket != nullptr) {
+    connect(run->socket, &QAbstractSocket::disconnected, this, [=]() {
+      run->simulation->processOutput(run->socket->readAll());
+      onRunExit(run, 0, QProcess::NormalExit);
+    });
+  } else if (run->channel != nullptr) {
+    int index = run->index;
+    connect(run->channel, &AlgoChannel::finished, this,
+            [=](int exitCode, QProcess::ExitStatus exitStatus) {
+              if (m_scriptRuns.contains(index)) {
+                onRunExit(run, exitCode, exitStatus);
+              }
+            });
+  } else {
+    connect(run->process,
+            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+                &QProcess::finished),
+            this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+              onRunExit(run, exitCode, exitStatus);
+            });
+  }
+
+  // Many algos never exit on their own, so cut the run short, by the CPU
+  // time that it took if it can be measured
+  if (0 < timeoutSeconds && isCpuTimed && run->isUsageMeasured) {
+    run->cpuTimeoutSeconds = timeoutSeconds;
+    timeoutSeconds *= CPU_TIMEOUT_REAL_TIME_FACTOR;
+  }
+  if (0 < timeoutSeconds) {
+    run->timeoutTimer = new QTimer();
+    run->timeoutTimer->setSingleShot(true);
+    connect(run->timeoutTimer, &QTimer::timeout, this, [=]() {
+      run->timedOut = true;
+      stopAlgo(run);
+    });
+    run->timeoutTimer->start(timeoutSeconds * 1000);
+  }
+
+  // Before any commands arrive, so that they apply to the resumed state
+  if (!m_resumeDirectory.isEmpty() && m_coordinator == nullptr) {
+    startSaving(run);
+  }
+
+  // A warm or spare algo may already have sent commands, which belong to
+  // this run
+  if (algo != nullptr) {
+    QByteArray output = m_useSharedMemory
+                            ? run->transport->readAll()
+                            : run->process->readAllStandardOutput();
+    if (!output.isEmpty()) {
+      run->simulation->processOutput(output);
+    }
+  }
+
+  // Nothing is handed over by a script's channel until it's first allowed
+  if (run->channel != nullptr) {
+    run->channel->allowCommands(0, run->simulation->getCommandQueueRoom());
+  }
+
+  // Likewise, a connected algo may have sent commands, or even hung up,
+  // while it waited for a run
+  if (run->socket != nullptr) {
+    if (0 < run->socket->bytesAvailable()) {
+      run->simulation->processOutput(run->socket->readAll());
+    }
+    if (run->socket->state() != QAbstractSocket::ConnectedState) {
+      onRunExit(run, 0, QProcess::NormalExit);
+    }
+  }
+}
+
+void BatchRunner::readOutput(Run *run) {
+  // Leave the output unread while the simulation has no room for it, so that
+  // it backs up to the algo, which blocks once the socket's buffers (or the
+  // ring) fill up; a process's pipe is always drained by QProcess, though
+  if (run->channel != nullptr) {
+    run->channel->allowCommands(0, run->simulation->getCommandQueueRoom());
+    return;
+  }
+  if (run->simulation->getCommandQueueRoom() == 0) {
+    return;
+  }
+  if (run->socket != nullptr) {
+    run->simulation->processOutput(run->socket->readAll());
+  } else if (m_useSharedMemory) {
+    run->simulation->processOutput(run->transport->readAll());
+  } else {
+    run->simulation->processOutput(run->process->readAllStandardOutput());
+  }
+}
+
+void BatchRunner::stopAlgo(Run *run) {
+  // Aborting a connection finishes the run right away, which mustn't happen
+  // from within a signal of the run, so it waits for the event loop, as the
+  // exit of a killed process would
+  if (run->socket != nullptr) {
+    QMetaObject::invokeMethod(run->socket, &QAbstractSocket::abort,
+                              Qt::QueuedConnection);
+  } else if (run->channel != nullptr) {
+    QMetaObject::invokeMethod(run->channel, &AlgoChannel::kill,
+                              Qt::QueuedConnection);
+  } else {
+    measureAlgo(run);
+    run->process->kill();
+  }
+}
+
+void BatchRunner::startMeasuring(Run *run) {
+  // If even the start can't be measured, e.g., on another platform, the
+  // fields are left empty
+  run->startUsage = {0.0, 0.0, 0, 0};
+  run->isUsageMeasured = ProcessUtilities::getUsage(
+      run->process->processId(), &run->startUsage);
+  run->lastUsage = run->startUsage;
+  run->usageTimer = new QTimer();
+  connect(run->usageTimer, &QTimer::timeout, this, [=]() {
+    measureAlgo(run);
+    checkCpuTimeout(run);
+  });
+  run->usageTimer->start(USAGE_INTERVAL_MILLISECONDS);
+}
+
+void BatchRunner::measureAlgo(Run *run) {
+  ProcessUtilities::Usage usage;
+  if (run->isUsageMeasured && run->process != nullptr &&
+      ProcessUtilities::getUsage(run->process->processId(), &usage)) {
+    run->lastUsage = usage;
+  }
+}
+
+void BatchRunner::checkCpuTimeout(Run *run) {
+  // Once stopped, the algo is only waited on to exit
+  if (run->cpuTimeoutSeconds <= 0.0 || run->timedOut || run->hung) {
+    return;
+  }
+  double cpuSeconds =
+      run->lastUsage.userSeconds - run->startUsage.userSeconds +
+      run->lastUsage.systemSeconds - run->startUsage.systemSeconds;
+  double movementSeconds =
+      run->stats->getState().values[static_cast<int>(StatsEnum::TOTAL_TIME)];
+  if (run->cpuTimeoutSeconds <= cpuSeconds + movementSeconds) {
+    run->timedOut = true;
+    stopAlgo(run);
+  }
+}
+
+bool BatchRunner::isJobTuned() const {
+  return m_isJobTuned && m_server == nullptr && m_coordinator == nullptr;
+}
+
+void BatchRunner::tuneJobs(Run *run) {
+  // The algo's CPU time is unknown unless its process was sampled, e.g., not
+  // for plugins and scripts, and whatever the simulator didn't spend serving
+  // it, the run spent waiting on the algo, or on the protocol
+  double algoSeconds = -1.0;
+  if (run->usageTimer != nullptr && run->isUsageMeasured) {
+    measureAlgo(run);
+    algoSeconds =
+        run->lastUsage.userSeconds - run->startUsage.userSeconds +
+        run->lastUsage.systemSeconds - run->startUsage.systemSeconds;
+  }
+  const LatencyHistogram &serviceTimes = run->simulation->getServiceTimes();
+  double serviceSeconds = static_cast<double>(serviceTimes.getMean()) *
+                          serviceTimes.getCount() / 1e9;
+  qint64 now = m_clock.nsecsElapsed();
+  m_jobTuner.addRun(now / 1e9, (now - run->startNanoseconds) / 1e9,
+                    algoSeconds, serviceSeconds);
+}
+
+bool BatchRunner::listenForAlgos(quint16 port, QString *error) {
+  ASSERT_TR(m_plugin == nullptr);
+  ASSERT_FA(m_useSharedMemory);
+  ASSERT_FA(m_isTournament);
+  ASSERT_EQ(m_numSpares, 0);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_algoServer = new QTcpServer(this);
+  if (!m_algoServer->listen(QHostAddress::Any, port)) {
+    *error = QString("Could not listen on port %1: %2")
+                 .arg(port)
+                 .arg(m_algoServer->errorString());
+    return false;
+  }
+  connect(m_algoServer, &QTcpServer::newConnection, this,
+          &BatchRunner::acceptAlgos);
+  return true;
+}
+
+bool BatchRunner::setLiveFeed(quint16 port, QString *error) {
+  ASSERT_TR(m_liveFeed == nullptr);
+  ASSERT_EQ(m_nextIndex, 0);
+  m_liveFeed = new LiveFeed(this);
+  return m_liveFeed->listen(port, error);
+}
+
+void BatchRunner::acceptAlgos() {
+  // Connections are paired with runs in the order that both arrive; the
+  // others wait in the server's backlog until there's a run for them
+  while (!m_awaitingRuns.isEmpty() && m_algoServer->hasPendingConnections()) {
+    Run *run = m_awaitingRuns.takeFirst();
+    run->socket = m_algoServer->nextPendingConnection();
+
+    // Responses are already written a batch at a time (see Simulation), so
+    // each batch should be sent as soon as it's written rather than held
+    // back for more, which would cost a round trip per command
+    run->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    startSimulation(run, nullptr);
+  }
+}
+
+void BatchRunner::startSaving(Run *run) {
+  // A saved state that can't be restored, e.g., of a maze that has since
+  // changed, is ignored, and the run starts over
+  QString path = getResumePath(run->index);
+  QString error;
+  if (QFile::exists(path)) {
+    SimulationCheckpoint::fromFile(path, run->maze.data(), run->simulation,
+                                   nullptr, &error);
+  }
+
+  // The state is only saved between commands, which is most of the time for
+  // an algo that waits on each response
+  run->saveTimer = new QTimer();
+  connect(run->saveTimer, &QTimer::timeout, this, [=]() {
+    if (run->simulation->isIdle()) {
+      SimulationCheckpoint::toFile(path, run->maze.data(), run->simulation,
+                                   nullptr);
+    }
+  });
+  run->saveTimer->start(SAVE_INTERVAL_MILLISECONDS);
+}
+
+bool BatchRunner::finishFromCache(Run *run) {
+  QByteArray key = getCacheKey(run);
+  RemoteProtocol::Result result;
+  if (key.isEmpty() ||
+      !ResultCache::load(m_resultCacheDirectory, key, &result)) {
+    return false;
+  }
+  if (!m_recordDirectory.isEmpty()) {
+    run->replayLog = ReplayLog::fromBytes(result.replay);
+    if (run->replayLog == nullptr) {
+      // Cached by a batch that didn't record, so it must be run after all
+      return false;
+    }
+  }
+  if ((!m_heatmapDirectory.isEmpty() && result.heatmap.isEmpty()) ||
+      (!m_traceDirectory.isEmpty() && result.trace.isEmpty())) {
+    return false;
+  }
+  run->stats = new Stats();
+  run->stats->setState(result.stats);
+  run->latency = result.latency;
+  run->usage = result.usage;
+  run->resets = result.resets;
+  run->algoMetrics = result.algoMetrics;
+  run->heatmap = result.heatmap;
+  run->traceCsv = result.trace;
+  run->isCached = true;
+  finishRun(run, result.status);
+  return true;
+}
+
+QByteArray BatchRunner::getCacheKey(const Run *run) const {
+  // Empty if caching is off, or if the algo's directory couldn't be hashed
+  if (m_algoHashes.isEmpty() ||
+      m_algoHashes.at(getAlgoIndex(run->index)).isEmpty()) {
+    return QByteArray();
+  }
+  return ResultCache::getKey(m_algoHashes.at(getAlgoIndex(run->index)),
+                             run->maze.data(), run->index % m_repeats,
+                             m_timeoutSeconds, m_isCpuTimed, m_seed,
+                             m_resetInjection.getSpec());
+}
+
+quint64 BatchRunner::getRandomKey(const Run *run) const {
+  if (m_coordinator != nullptr) {
+    return m_jobs[run->index].randomKey;
+  }
+  const Algo &algo = m_algos.at(getAlgoIndex(run->index));
+  QByteArray identity = QString("%1\n%2\n%3\n%4\n")
+                            .arg(m_seed)
+                            .arg(run->index % m_repeats)
+                            .arg(algo.directory, algo.runCommand)
+                            .toUtf8();
+  identity.append(run->maze->toBinary());
+  return RandomStream::getKey(identity);
+}
+
+BatchRunner::Run *BatchRunner::createRun(int index) {
+  Run *run = new Run();
+  run->index = index;
+  run->stats = nullptr;
+  run->simulation = nullptr;
+  run->process = nullptr;
+  run->transport = nullptr;
+  run->socket = nullptr;
+  run->channel = nullptr;
+  run->instance = nullptr;
+  run->replayLog = nullptr;
+  run->trace = nullptr;
+  run->view = nullptr;
+  run->timeoutTimer = nullptr;
+  run->saveTimer = nullptr;
+  run->startNanoseconds = 0;
+  run->usageTimer = nullptr;
+  run->isUsageMeasured = false;
+  run->cpuTimeoutSeconds = 0.0;
+  run->timedOut = false;
+  run->hung = false;
+  run->isCached = false;
+  return run;
+}
+
+QSharedPointer<const Maze> BatchRunner::loadMaze(int index) const {
+  if (m_coordinator != nullptr) {
+    return MazePool::fromBinary(m_jobs.value(index).maze);
+  }
+  int mazeIndex = getMazeIndex(index);
+  if (!m_mazes.contains(mazeIndex)) {
+    // Usually prefetched by now, in which case this doesn't wait
+    if (m_prefetches.contains(mazeIndex)) {
+      Prefetch prefetched = m_prefetches.take(mazeIndex).result();
+      m_mazes.insert(mazeIndex, prefetched.maze);
+      if (!prefetched.maze.isNull()) {
+        m_mazeMetrics.insert(mazeIndex, prefetched.metrics);
+      }
+    } else {
+      m_mazes.insert(mazeIndex, MazePool::fromFile(getMazeFile(index)));
+    }
+  }
+  return m_mazes.value(mazeIndex);
+}
+
+void BatchRunner::prefetchMazes() {
+  if (m_nextIndex == getNumRuns()) {
+    return;
+  }
+  int first = getMazeIndex(m_nextIndex);
+  int end = qMin(first + PREFETCH_MAZES, m_mazeFiles.size());
+  for (int mazeIndex = first; mazeIndex < end; mazeIndex += 1) {
+    if (!m_mazes.contains(mazeIndex) && !m_prefetches.contains(mazeIndex)) {
+      QString mazeFile = m_mazeFiles.at(mazeIndex);
+      m_prefetches.insert(mazeIndex,
+                          QtConcurrent::run(&m_prefetchPool, [=]() {
+                            return prefetch(mazeFile);
+                          }));
+    }
+  }
+}
+
+BatchRunner::Prefetch BatchRunner::prefetch(const QString &mazeFile) {
+  // Loading the maze also computes its distances, see Maze
+  Prefetch prefetched;
+  prefetched.maze = MazePool::fromFile(mazeFile);
+  if (!prefetched.maze.isNull()) {
+    prefetched.metrics =
+        computeMazeMetrics(mazeFile, prefetched.maze.data());
+  }
+  return prefetched;
+}
+
+bool BatchRunner::startAlgo(int algoIndex, WarmAlgo *algo) {
+  algo->algoIndex = algoIndex;
+  algo->process = new QProcess();
+  algo->transport = nullptr;
+  algo->isBinary = false;
+
+  // Logs aren't displayed anywhere, so drop them
+  algo->process->setStandardErrorFile(QProcess::nullDevice());
+
+  if (m_useSharedMemory) {
+    // Commands arrive through shared memory, so stdout is just logs too
+    algo->transport = new SharedMemoryTransport();
+    if (!algo->transport->create()) {
+      return false;
+    }
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(SharedMemoryTransport::ENVIRONMENT_VARIABLE,
+                       algo->transport->path());
+    algo->process->setProcessEnvironment(environment);
+    algo->process->setStandardOutputFile(QProcess::nullDevice());
+  }
+  const Algo &config = m_algos.at(algoIndex);
+  if (!ProcessUtilities::start(config.runCommand, config.directory,
+                               algo->process)) {
+    return false;
+  }
+  placeAlgo(algo->process);
+  return true;
+}
+
+void BatchRunner::placeAlgo(QProcess *process) {
+  // Placement is best effort, e.g., raising the priority may take privileges
+  // that the simulator doesn't have, so the run goes ahead regardless
+  if (m_isAlgoPriorityRaised) {
+    ProcessUtilities::raisePriority(process->processId());
+  }
+  if (m_algoCores.isEmpty()) {
+    return;
+  }
+  int index = 0;
+  for (int i = 1; i < m_coreLoads.size(); i += 1) {
+    if (m_coreLoads.at(i) < m_coreLoads.at(index)) {
+      index = i;
+    }
+  }
+  ProcessUtilities::setAffinity(process->processId(),
+                                {m_algoCores.at(index)});
+
+  // However the process is done with, e.g., as a spare, its core is freed
+  m_coreLoads[index] += 1;
+  connect(process, &QObject::destroyed, this,
+          [=]() { m_coreLoads[index] -= 1; });
+}
+
+void BatchRunner::startSpareAlgos() {
+  // Spares are only started for the next runs, which will need them, and the
+  // pool is refilled as runs take from it, so that starting a process (and
+  // warming up its runtime) overlaps with the runs in flight
+  QVector<int> numSpares(m_algos.size(), 0);
+  for (const WarmAlgo &algo : m_spareAlgos) {
+    numSpares[algo.algoIndex] += 1;
+  }
+  for (int index = m_nextIndex;
+       index < getNumRuns() && index < m_nextIndex + m_numSpares &&
+       m_spareAlgos.size() < m_numSpares;
+       index += 1) {
+    int algoIndex = getAlgoIndex(index);
+    if (m_checkpointedRows.contains(index) || isScript(algoIndex)) {
+      continue;
+    }
+    if (0 < numSpares.at(algoIndex)) {
+      numSpares[algoIndex] -= 1;
+      continue;
+    }
+    WarmAlgo algo;
+    if (!startAlgo(algoIndex, &algo)) {
+      // The run that would have used it reports the error instead
+      delete algo.transport;
+      delete algo.process;
+      return;
+    }
+    QProcess *process = algo.process;
+    connect(process,
+            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+                &QProcess::finished),
+            this, [=]() { onSpareAlgoExit(process); });
+    m_spareAlgos.append(algo);
+  }
+}
+
+void BatchRunner::onSpareAlgoExit(QProcess *process) {
+  // An algo that exits before it's given a maze is useless, so it's replaced
+  for (int i = 0; i < m_spareAlgos.size(); i += 1) {
+    if (m_spareAlgos.at(i).process == process) {
+      delete m_spareAlgos.at(i).transport;
+      m_spareAlgos.removeAt(i);
+      break;
+    }
+  }
+  process->disconnect(this);
+  process->deleteLater();
+}
+
+bool BatchRunner::isScript(int algoIndex) const {
+  return ScriptAlgo::isScript(m_algos.at(algoIndex).runCommand);
+}
+
+void BatchRunner::startScript(Run *run) {
+  // Its commands arrive already parsed, on this thread, just as in the GUI;
+  // logs are dropped, as they are for processes
+  const Algo &config = m_algos.at(getAlgoIndex(run->index));
+  run->channel = new AlgoChannel();
+  m_scriptRuns.insert(run->index, run);
+  if (!run->channel->start(config.runCommand, config.directory)) {
+    finishRun(run, "error");
+    return;
+  }
+  startSimulation(run, nullptr);
+}
+
+void BatchRunner::runPlugin(Run *run) {
+  // The plugin answers commands directly, so there's nothing to respond to
+  run->simulation =
+      new Simulation(run->maze.data(), nullptr, run->stats, nullptr);
+  run->simulation->setInstant(true);
+  run->simulation->setReplayLog(run->replayLog);
+  run->simulation->setTrace(run->trace);
+  run->simulation->setRandomKey(getRandomKey(run));
+  run->simulation->setResetInjection(m_resetInjection);
+  if (!m_plugin->isResumable()) {
+    bool completed = m_plugin->run(run->simulation, m_timeoutSeconds);
+    finishRun(run, completed ? "complete" : "timeout");
+    return;
+  }
+
+  // A resumable plugin gives control back at each movement, so its runs are
+  // interleaved on a thread per core, a few movements at a time, with up to
+  // the maximum number of jobs in flight, e.g., thousands of them, or as many
+  // as are tuned (see setJobTuning)
+  if (m_pluginScheduler == nullptr) {
+    int numThreads = qMin(QThread::idealThreadCount(), m_maxJobs);
+    m_pluginScheduler = new PluginScheduler(qMax(1, numThreads), this);
+    connect(m_pluginScheduler, &PluginScheduler::finished, this,
+            &BatchRunner::onPluginFinished);
+  }
+  run->instance = m_plugin->start(run->simulation, m_timeoutSeconds);
+  m_pluginRuns.insert(run->index, run);
+  m_pluginScheduler->add(run->instance, run->index);
+}
+
+void BatchRunner::onPluginFinished(int index) {
+  // Queued from the scheduler's threads, which are done with the run
+  Run *run = m_pluginRuns.take(index);
+  ASSERT_FA(run == nullptr);
+  finishRun(run, run->instance->isTimedOut() ? "timeout" : "complete");
+}
+
+void BatchRunner::onNextMazeRequested(Run *run) {
+  // In a tournament, the next run may be of another algo
+  int algoIndex = getAlgoIndex(run->index);
+  if (!hasNextIndex() || getAlgoIndex(m_nextIndex) != algoIndex) {
+    // Nothing is left, so the algo exits just as it would have otherwise
+    run->simulation->answerNextMaze(false);
+    return;
+  }
+
+  // The algo is done with this maze, so the run is complete, but the process
+  // carries on with the next run instead of exiting
+  measureAlgo(run);
+  WarmAlgo algo = {algoIndex, run->process, run->transport,
+                   run->simulation->isBinaryProtocol()};
+  algo.process->disconnect(this);
+  if (algo.transport != nullptr) {
+    algo.transport->disconnect(this);
+  }
+  run->simulation->answerNextMaze(true);
+  run->process = nullptr;
+  run->transport = nullptr;
+  int index = takeNextIndex();
+  finishRun(run, "complete");
+  startRun(index, &algo);
+}
+
+void BatchRunner::onRunExit(Run *run, int exitCode,
+                            QProcess::ExitStatus exitStatus) {
+  if (run->timedOut) {
+    finishRun(run, "timeout");
+  } else if (run->hung) {
+    finishRun(run, "hung");
+  } else if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+    finishRun(run, "complete");
+  } else {
+    finishRun(run, "failed");
+  }
+}
+
+void BatchRunner::finishRun(Run *run, QString status) {
+  if (run->simulation != nullptr) {
+    run->simulation->stop();
+    emit simulationFinished(run->simulation);
+    bool isLatencyTracked = m_coordinator == nullptr
+                                ? m_isLatencyTracked
+                                : m_jobs[run->index].isLatencyTracked;
+    if (isLatencyTracked) {
+      run->latency = getLatencyFields(run->simulation);
+    }
+    bool isUsageTracked = m_coordinator == nullptr
+                              ? m_isUsageTracked
+                              : m_jobs[run->index].isUsageTracked;
+    if (run->usageTimer != nullptr && isUsageTracked) {
+      measureAlgo(run);
+      run->usage = getUsageFields(run);
+    }
+    if (isJobTuned()) {
+      tuneJobs(run);
+    }
+    bool isReset = m_coordinator == nullptr
+                       ? !m_resetInjection.isEmpty()
+                       : !m_jobs[run->index].resetInjection.isEmpty();
+    if (isReset) {
+      run->resets = getResetFields(run->simulation);
+    }
+    run->algoMetrics = run->simulation->getAlgoMetrics()->getSummary();
+    bool isHeatmapped = m_coordinator == nullptr
+                            ? !m_heatmapDirectory.isEmpty()
+                            : m_jobs[run->index].isHeatmapped;
+    if (isHeatmapped) {
+      run->heatmap = run->simulation->getVisitCounts()->toCsv().toUtf8();
+    }
+    if (run->trace != nullptr) {
+      run->traceCsv = run->trace->toCsv().toUtf8();
+    }
+  }
+  if (m_coordinator != nullptr) {
+    sendResult(run, status);
+  } else {
+    recordRun(run, status);
+  }
+
+  // The process and timer may still be emitting signals, so defer deletion
+  if (run->process != nullptr) {
+    run->process->disconnect(this);
+    run->process->deleteLater();
+  }
+  if (run->socket != nullptr) {
+    run->socket->disconnect(this);
+    run->socket->disconnectFromHost();
+    run->socket->deleteLater();
+  }
+  if (run->channel != nullptr) {
+    // This may be called from within the channel's kill
+    m_scriptRuns.remove(run->index);
+    run->channel->disconnect(this);
+    run->channel->deleteLater();
+  }
+  if (run->timeoutTimer != nullptr) {
+    run->timeoutTimer->stop();
+    run->timeoutTimer->disconnect(this);
+    run->timeoutTimer->deleteLater();
+  }
+  if (run->saveTimer != nullptr) {
+    run->saveTimer->stop();
+    run->saveTimer->disconnect(this);
+    run->saveTimer->deleteLater();
+    QFile::remove(getResumePath(run->index));
+  }
+  if (run->usageTimer != nullptr) {
+    run->usageTimer->stop();
+    run->usageTimer->disconnect(this);
+    run->usageTimer->deleteLater();
+  }
+  if (run->view != nullptr) {
+    m_liveFeed->unfollow();
+  }
+  delete run->instance;
+  delete run->simulation;
+  delete run->view;
+  delete run->transport;
+  delete run->replayLog;
+  delete run->trace;
+  delete run->stats;
+  delete run;
+  m_numRunning -= 1;
+  ASSERT_LE(0, m_numRunning);
+
+  // Start more runs from the event loop, not from within a signal handler
+  QTimer::singleShot(0, this, &BatchRunner::startRuns);
+}
+
+void BatchRunner::recordRun(Run *run, QString status) {
+  // Only complete runs are cached, since the others may depend on the
+  // machine, e.g., on how fast the algo is in real time
+  if (status == "complete" && run->maze != nullptr && !run->isCached) {
+    QByteArray key = getCacheKey(run);
+    if (!key.isEmpty()) {
+      RemoteProtocol::Result result;
+      result.index = run->index;
+      result.status = status;
+      result.stats = run->stats->getState();
+      if (run->replayLog != nullptr) {
+        result.replay = run->replayLog->toBytes();
+      }
+      result.latency = run->latency;
+      result.usage = run->usage;
+      result.resets = run->resets;
+      result.algoMetrics = run->algoMetrics;
+      result.heatmap = run->heatmap;
+      result.trace = run->traceCsv;
+      ResultCache::store(m_resultCacheDirectory, key, result);
+    }
+  }
+  if (run->replayLog != nullptr) {
+    QString path =
+        QDir(m_recordDirectory).filePath(getRunName(run->index) + ".mmsr");
+    if (!run->replayLog->toFile(path)) {
+      status = "error";
+    }
+  }
+  if (!m_heatmapDirectory.isEmpty() && !run->heatmap.isEmpty()) {
+    QFile file(
+        QDir(m_heatmapDirectory).filePath(getRunName(run->index) + ".csv"));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) ||
+        file.write(run->heatmap) != run->heatmap.size()) {
+      status = "error";
+    }
+  }
+  if (!m_traceDirectory.isEmpty() && !run->traceCsv.isEmpty()) {
+    QFile file(
+        QDir(m_traceDirectory).filePath(getRunName(run->index) + ".csv"));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) ||
+        file.write(run->traceCsv) != run->traceCsv.size()) {
+      status = "error";
+    }
+  }
+  if (m_database != nullptr && !addToDatabase(run, status)) {
+    status = "error";
+  }
+  if (m_sequentialTest != nullptr) {
+    scoreRun(run);
+  }
+  if (status != "complete") {
+    m_failures += 1;
+  }
+  if (m_summary != nullptr) {
+    m_cellAggregates[getCellIndex(run->index)].add(status, run->stats);
+    m_totalAggregate.add(status, run->stats);
+  }
+  // Metrics are empty if the maze couldn't be loaded at all
+  MazeMetrics metrics;
+  QString baseline;
+  if (run->maze != nullptr) {
+    metrics = getMazeMetrics(getMazeIndex(run->index), run->maze.data());
+    if (m_baseline != nullptr) {
+      baseline = getBaselineFields(getMazeIndex(run->index), run->maze.data());
+    }
+  }
+  QString row = getRow(run->index, status, run->stats,
+                       run->maze == nullptr ? nullptr : &metrics,
+                       run->latency, run->usage, run->resets, baseline,
+                       run->algoMetrics);
+  if (m_checkpoint.isOpen()) {
+    // Flushed right away, so that nothing is lost if the batch is killed
+    m_checkpoint.write(
+        QString("%1,%2,%3\n").arg(run->index).arg(status).arg(row).toUtf8());
+    m_checkpoint.flush();
+  }
+  m_pendingRows.insert(run->index, row);
+  writeRows();
+}
+
+void BatchRunner::scoreRun(const Run *run) {
+  // An invalid maze has no stats, so it's a tie
+  int mazeIndex = getMazeIndex(run->index);
+  if (run->stats != nullptr) {
+    double score = run->stats->getValue(StatsEnum::SCORE);
+    m_scoreDifferences[mazeIndex] +=
+        getAlgoIndex(run->index) == 0 ? score : -score;
+  }
+  m_numScoredRuns[mazeIndex] += 1;
+  if (m_numScoredRuns.value(mazeIndex) == m_repeats * m_algos.size()) {
+    m_numScoredRuns.remove(mazeIndex);
+    m_sequentialTest->add(m_scoreDifferences.take(mazeIndex) / m_repeats);
+  }
+}
+
+bool BatchRunner::addToDatabase(const Run *run, const QString &status) {
+  const Algo &algo = m_algos.at(getAlgoIndex(run->index));
+  ResultsDatabase::Run row;
+  row.algoName = algo.name;
+  row.algoDirectory = algo.directory;
+  row.algoRunCommand = algo.runCommand;
+  row.mazeFile = getMazeFile(run->index);
+  if (run->maze != nullptr) {
+    row.mazeHash = QCryptographicHash::hash(run->maze->toBinary(),
+                                            QCryptographicHash::Sha1);
+  }
+  row.repeat = run->index % m_repeats;
+  row.status = status;
+  if (run->stats != nullptr) {
+    for (const QString &name : STRING_TO_STAT().keys()) {
+      row.stats.insert(name, run->stats->getStat(STRING_TO_STAT().value(name)));
+    }
+  }
+  row.usage = run->usage;
+  return m_database->addRun(row);
+}
+
+void BatchRunner::sendResult(Run *run, const QString &status) {
+  RemoteProtocol::Result result;
+  result.index = run->index;
+  result.status = status;
+  result.stats = run->stats == nullptr ? Stats().getState()
+                                       : run->stats->getState();
+  if (run->replayLog != nullptr) {
+    result.replay = run->replayLog->toBytes();
+  }
+  result.latency = run->latency;
+  result.usage = run->usage;
+  result.resets = run->resets;
+  result.algoMetrics = run->algoMetrics;
+  result.heatmap = run->heatmap;
+  result.trace = run->traceCsv;
+  m_coordinator->write(RemoteProtocol::encode(result));
+  m_jobs.remove(run->index);
+}
+
+void BatchRunner::onCoordinatorReadyRead() {
+  m_coordinatorBuffer.append(m_coordinator->readAll());
+  RemoteProtocol::Message message;
+  RemoteProtocol::Status status;
+  while ((status = RemoteProtocol::take(&m_coordinatorBuffer, &message)) ==
+         RemoteProtocol::Status::MESSAGE) {
+    if (message.type == RemoteProtocol::MessageType::DONE) {
+      m_coordinator->disconnect(this);
+      emit finished(0);
+      return;
+    }
+    if (message.type != RemoteProtocol::MessageType::JOB) {
+      continue;
+    }
+    const RemoteProtocol::Job &job = message.job;
+    m_jobs.insert(job.index, job);
+    bool isKnown = false;
+    for (const Algo &algo : m_algos) {
+      isKnown = isKnown || (algo.directory == job.directory &&
+                            algo.runCommand == job.runCommand);
+    }
+    if (!isKnown) {
+      m_algos.append({QString(), job.directory, job.runCommand});
+    }
+    startRun(job.index);
+  }
+  if (status == RemoteProtocol::Status::INVALID) {
+    m_coordinator->disconnect(this);
+    m_coordinator->abort();
+    emit finished(1);
+  }
+}
+
+void BatchRunner::onWorkerConnected() {
+  while (m_server->hasPendingConnections()) {
+    Worker *worker = new Worker();
+    worker->socket = m_server->nextPendingConnection();
+    worker->maxJobs = 0;  // until it says hello
+    m_workers.append(worker);
+    connect(worker->socket, &QTcpSocket::readyRead, this,
+            [=]() { onWorkerReadyRead(worker); });
+    connect(worker->socket, &QTcpSocket::disconnected, this,
+            [=]() { onWorkerDisconnected(worker); });
+  }
+}
+
+void BatchRunner::onWorkerReadyRead(Worker *worker) {
+  worker->buffer.append(worker->socket->readAll());
+  RemoteProtocol::Message message;
+  RemoteProtocol::Status status;
+  while ((status = RemoteProtocol::take(&worker->buffer, &message)) ==
+         RemoteProtocol::Status::MESSAGE) {
+    if (message.type == RemoteProtocol::MessageType::HELLO) {
+      worker->maxJobs = message.maxJobs;
+      if (m_isFinished) {
+        worker->socket->write(RemoteProtocol::encodeDone());
+      } else {
+        sendJobs(worker);
+      }
+      continue;
+    }
+    if (message.type != RemoteProtocol::MessageType::RESULT ||
+        !worker->indices.remove(message.result.index)) {
+      continue;
+    }
+    // The maze is loaded again, rather than kept while the job is out, so
+    // that its metrics can be computed
+    const RemoteProtocol::Result &result = message.result;
+    Run *run = createRun(result.index);
+    run->maze = loadMaze(result.index);
+    QString runStatus = result.status;
+    run->latency = result.latency;
+    run->usage = result.usage;
+    run->resets = result.resets;
+    run->algoMetrics = result.algoMetrics;
+    run->heatmap = result.heatmap;
+    run->traceCsv = result.trace;
+    if (run->maze != nullptr) {
+      run->stats = new Stats();
+      run->stats->setState(result.stats);
+    }
+    if (!m_recordDirectory.isEmpty() && run->maze != nullptr) {
+      run->replayLog = ReplayLog::fromBytes(result.replay);
+      if (run->replayLog == nullptr) {
+        runStatus = "error";
+      }
+    }
+    finishRun(run, runStatus);
+  }
+  if (status == RemoteProtocol::Status::INVALID) {
+    // Its runs are handed to the other workers
+    worker->socket->abort();
+  }
+}
+
+void BatchRunner::onWorkerDisconnected(Worker *worker) {
+  for (int index : worker->indices) {
+    m_retryIndices.append(index);
+    m_numRunning -= 1;
+  }
+  std::sort(m_retryIndices.begin(), m_retryIndices.end());
+  m_workers.removeOne(worker);
+  worker->socket->disconnect(this);
+  worker->socket->deleteLater();
+  delete worker;
+  QTimer::singleShot(0, this, &BatchRunner::startRuns);
+}
+
+void BatchRunner::sendJobs(Worker *worker) {
+  while (worker->indices.size() < worker->maxJobs &&
+         (!m_retryIndices.isEmpty() || hasNextIndex())) {
+    int index = m_retryIndices.isEmpty() ? takeNextIndex()
+                                         : m_retryIndices.takeFirst();
+    m_numRunning += 1;
+    Run *run = createRun(index);
+    run->maze = loadMaze(index);
+    if (run->maze == nullptr) {
+      finishRun(run, "invalid-maze");
+      continue;
+    }
+    if (finishFromCache(run)) {
+      continue;
+    }
+    const Algo &algo = m_algos.at(getAlgoIndex(index));
+    RemoteProtocol::Job job;
+    job.index = index;
+    job.directory = algo.directory;
+    job.runCommand = algo.runCommand;
+    job.timeoutSeconds = m_timeoutSeconds;
+    job.isCpuTimed = m_isCpuTimed;
+    job.hangTimeoutSeconds = m_hangTimeoutSeconds;
+    job.isRecorded = !m_recordDirectory.isEmpty();
+    job.isLatencyTracked = m_isLatencyTracked;
+    job.isUsageTracked = m_isUsageTracked;
+    job.isHeatmapped = !m_heatmapDirectory.isEmpty();
+    job.isTraced = !m_traceDirectory.isEmpty();
+    job.resetInjection = m_resetInjection.getSpec();
+    job.randomKey = getRandomKey(run);
+    job.maze = run->maze->toBinary();
+    delete run;
+    worker->socket->write(RemoteProtocol::encode(job));
+    worker->indices.insert(index);
+  }
+}
+
+void BatchRunner::writeHeader() {
+  QStringList fields = {"maze", "status"};
+  if (m_isTournament) {
+    fields.prepend("algo");
+  }
+  fields.append(STRING_TO_STAT().keys());
+  fields.append(MazeMetrics::getCsvHeader());
+  if (m_isLatencyTracked) {
+    fields.append(getLatencyHeader());
+  }
+  if (m_isUsageTracked) {
+    fields.append(getUsageHeader());
+  }
+  if (!m_resetInjection.isEmpty()) {
+    fields.append(getResetHeader());
+  }
+  if (m_baseline != nullptr) {
+    fields.append(getBaselineHeader());
+  }
+  for (const QString &policy : m_scoringPolicies) {
+    fields.append("score-" + policy);
+  }
+  fields.append("algo-metrics");
+  *m_output << fields.join(",") << Qt::endl;
+}
+
+void BatchRunner::writeRows() {
+  // Keep the output in the same order as the input
+  while (m_pendingRows.contains(m_nextRowIndex)) {
+    *m_output << m_pendingRows.take(m_nextRowIndex) << Qt::endl;
+    m_nextRowIndex += 1;
+
+    // Once every repeat of a cell is written, its aggregate is complete too,
+    // and once every cell of a maze is, its metrics are no longer needed
+    int index = m_nextRowIndex - 1;
+    if (m_nextRowIndex % m_repeats == 0 && m_summary != nullptr) {
+      writeSummary(getCellIndex(index),
+                   m_cellAggregates.take(getCellIndex(index)));
+    }
+    if (m_nextRowIndex % (m_repeats * m_algos.size()) == 0) {
+      m_mazeMetrics.remove(getMazeIndex(index));
+      m_mazes.remove(getMazeIndex(index));
+      m_baselineFields.remove(getMazeIndex(index));
+    }
+  }
+}
+
+QString BatchRunner::getRow(int index, const QString &status, Stats *stats,
+                            const MazeMetrics *metrics,
+                            const QString &latency,
+                            const QString &usage,
+                            const QString &resets,
+                            const QString &baseline,
+                            const QString &algoMetrics) const {
+  QStringList fields = {toCsvField(getMazeFile(index)), status};
+  if (m_isTournament) {
+    fields.prepend(toCsvField(m_algos.at(getAlgoIndex(index)).name));
+  }
+  for (StatsEnum stat : STRING_TO_STAT().values()) {
+    // Stats are empty if the maze couldn't be run at all
+    fields.append(stats == nullptr ? "" : stats->getStat(stat));
+  }
+  if (metrics == nullptr) {
+    for (int i = 0; i < MazeMetrics::getCsvHeader().size(); i += 1) {
+      fields.append("");
+    }
+  } else {
+    fields.append(metrics->getCsvFields());
+  }
+  if (m_isLatencyTracked) {
+    // Empty if the algo never ran
+    fields.append(latency.isEmpty()
+                      ? QStringList(getLatencyHeader().size(), QString())
+                      : latency.split(','));
+  }
+  if (m_isUsageTracked) {
+    // Empty if the algo isn't a process, or couldn't be measured
+    fields.append(usage.isEmpty()
+                      ? QStringList(getUsageHeader().size(), QString())
+                      : usage.split(','));
+  }
+  if (!m_resetInjection.isEmpty()) {
+    fields.append(resets.isEmpty()
+                      ? QStringList(getResetHeader().size(), QString())
+                      : resets.split(','));
+  }
+  if (m_baseline != nullptr) {
+    // Empty if the maze couldn't be loaded
+    fields.append(baseline.isEmpty()
+                      ? QStringList(getBaselineHeader().size(), QString())
+                      : baseline.split(','));
+  }
+  if (!m_scoringPolicies.isEmpty()) {
+    // Every policy scores the same final stats
+    Stats::State state = stats == nullptr ? Stats::State() : stats->getState();
+    for (const QString &policy : m_scoringPolicies) {
+      fields.append(stats == nullptr ? QString()
+                                     : QString::number(STRING_TO_SCORING()
+                                                           .value(policy)(
+                                                               state)));
+    }
+  }
+  // Empty if the algo reported no metrics
+  fields.append(toCsvField(algoMetrics));
+  return fields.join(",");
+}
+
+QStringList BatchRunner::getLatencyHeader() {
+  return {"think-p50-us",   "think-p99-us",   "think-max-us",
+          "service-p50-us", "service-p99-us", "service-max-us",
+          "queue-max"};
+}
+
+QString BatchRunner::getLatencyFields(const Simulation *simulation) {
+  QStringList fields;
+  for (const LatencyHistogram *histogram :
+       {&simulation->getThinkTimes(), &simulation->getServiceTimes()}) {
+    fields.append(QString::number(histogram->getPercentile(0.50) / 1000));
+    fields.append(QString::number(histogram->getPercentile(0.99) / 1000));
+    fields.append(QString::number(histogram->getMax() / 1000));
+  }
+  fields.append(QString::number(simulation->getMaxQueuedCommands()));
+  return fields.join(",");
+}
+
+QStringList BatchRunner::getUsageHeader() {
+  return {"algo-user-s", "algo-system-s", "algo-peak-rss-kib"};
+}
+
+QString BatchRunner::getUsageFields(const Run *run) {
+  if (!run->isUsageMeasured) {
+    return QString();
+  }
+  return QStringList(
+             {QString::number(run->lastUsage.userSeconds -
+                              run->startUsage.userSeconds),
+              QString::number(run->lastUsage.systemSeconds -
+                              run->startUsage.systemSeconds),
+              QString::number(run->lastUsage.peakResidentBytes / 1024)})
+      .join(",");
+}
+
+QStringList BatchRunner::getResetHeader() {
+  return {"resets-injected", "resets-acknowledged", "recovery-moves"};
+}
+
+QString BatchRunner::getResetFields(const Simulation *simulation) {
+  // The recovery is empty if the mouse never made it back to the center
+  int recovery = simulation->getRecoveryMovements();
+  return QStringList({QString::number(simulation->getNumInjectedResets()),
+                      QString::number(simulation->getNumAcknowledgedResets()),
+                      recovery < 0 ? QString() : QString::number(recovery)})
+      .join(",");
+}
+
+QString BatchRunner::getCheckpointKey() const {
+  // Everything that determines which run an index refers to
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  for (const Algo &algo : m_algos) {
+    hash.addData(QString("%1\n%2\n%3\n")
+                     .arg(algo.name, algo.directory, algo.runCommand)
+                     .toUtf8());
+  }
+  hash.addData(m_mazeFiles.join("\n").toUtf8());
+  hash.addData(QByteArray::number(m_repeats));
+  hash.addData(QByteArray::number(m_seed));
+  hash.addData(QByteArray::number(m_isCpuTimed));
+
+  // As well as the columns of the rows
+  hash.addData(QByteArray::number(m_isLatencyTracked));
+  hash.addData(QByteArray::number(m_isUsageTracked));
+  hash.addData(m_baselineName.toUtf8());
+  hash.addData(m_scoringPolicies.join(",").toUtf8());
+  hash.addData(m_resetInjection.getSpec().toUtf8());
+  return QString("mms-checkpoint,%1").arg(QString(hash.result().toHex()));
+}
+
+QStringList BatchRunner::getBaselineHeader() {
+  return {"baseline-status", "baseline-total-distance",
+          "baseline-best-run-distance", "baseline-us"};
+}
+
+QString BatchRunner::getBaselineFields(int mazeIndex, const Maze *maze) {
+  if (!m_baselineFields.contains(mazeIndex)) {
+    // Run in the same way as a plugin, see runPlugin
+    Stats stats;
+    Simulation simulation(maze, nullptr, &stats, nullptr);
+    simulation.setInstant(true);
+    QElapsedTimer timer;
+    timer.start();
+    bool completed = m_baseline->run(&simulation, m_timeoutSeconds);
+    qint64 microseconds = timer.nsecsElapsed() / 1000;
+    m_baselineFields.insert(
+        mazeIndex, QStringList({completed ? "complete" : "timeout",
+                                stats.getStat(StatsEnum::TOTAL_DISTANCE),
+                                stats.getStat(StatsEnum::BEST_RUN_DISTANCE),
+                                QString::number(microseconds)})
+                       .join(","));
+  }
+  return m_baselineFields.value(mazeIndex);
+}
+
+MazeMetrics BatchRunner::getMazeMetrics(int mazeIndex, const Maze *maze) {
+  if (!m_mazeMetrics.contains(mazeIndex)) {
+    m_mazeMetrics.insert(mazeIndex,
+                         computeMazeMetrics(m_mazeFiles.at(mazeIndex), maze));
+  }
+  return m_mazeMetrics.value(mazeIndex);
+}
+
+MazeMetrics BatchRunner::computeMazeMetrics(const QString &mazeFile,
+                                            const Maze *maze) {
+  MazeMetrics metrics;
+  QString path;
+  int index = 0;
+  if (!MazeCorpus::parseEntryPath(mazeFile, &path, &index) ||
+      !MazeCorpus::getMetrics(path, index, &metrics)) {
+    metrics = MazeMetrics::fromMaze(maze);
+  }
+  return metrics;
+}
+
+void BatchRunner::writeSummaryHeader() {
+  if (m_isJsonSummary) {
+    *m_summary << "{\"mazes\": [" << Qt::endl;
+    return;
+  }
+  QStringList fields = {"maze"};
+  if (m_isTournament) {
+    fields.prepend("algo");
+  }
+  fields.append(StatsAggregate::getCsvHeader());
+  *m_summary << fields.join(",") << Qt::endl;
+}
+
+void BatchRunner::writeSummary(int cellIndex,
+                               const StatsAggregate &aggregate) {
+  ASSERT_EQ(aggregate.getNumRuns(), m_repeats);
+  int index = cellIndex * m_repeats;
+  QString mazeFile = getMazeFile(index);
+  QString algoName = m_algos.at(getAlgoIndex(index)).name;
+  if (m_isJsonSummary) {
+    QJsonObject object = aggregate.toJson();
+    object.insert("maze", mazeFile);
+    if (m_isTournament) {
+      object.insert("algo", algoName);
+    }
+    if (0 < m_numSummaries) {
+      *m_summary << "," << Qt::endl;
+    }
+    *m_summary << QJsonDocument(object).toJson(QJsonDocument::Compact);
+  } else {
+    QStringList fields = {toCsvField(mazeFile)};
+    if (m_isTournament) {
+      fields.prepend(toCsvField(algoName));
+    }
+    fields.append(aggregate.getCsvFields());
+    *m_summary << fields.join(",") << Qt::endl;
+  }
+  m_numSummaries += 1;
+}
+
+void BatchRunner::writeSummaryFooter() {
+  // The whole batch is summarized last, as its own object or row
+  if (m_isJsonSummary) {
+    *m_summary << Qt::endl
+               << "], \"overall\": "
+               << QJsonDocument(m_totalAggregate.toJson())
+                      .toJson(QJsonDocument::Compact)
+               << "}" << Qt::endl;
+    return;
+  }
+  QStringList fields = {"*"};
+  if (m_isTournament) {
+    fields.prepend("*");
+  }
+  fields.append(m_totalAggregate.getCsvFields());
+  *m_summary << fields.join(",") << Qt::endl;
+}
+
+QString BatchRunner::toCsvField(QString text) {
+  if (!text.contains(',') && !text.contains('"')) {
+    return text;
+  }
+  return "\"" + text.replace("\"", "\"\"") + "\"";
+}
+
+}  // namespace mms
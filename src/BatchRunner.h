@@ -0,0 +1,542 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFuture>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QProcess>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include "AlgoChannel.h"
+#include "JobTuner.h"
+#include "LiveFeed.h"
+#include "Maze.h"
+#include "MazeMetrics.h"
+#include "MazeView.h"
+#include "PluginAlgo.h"
+#include "PluginScheduler.h"
+#include "ProcessUtilities.h"
+#include "RandomStream.h"
+#include "RemoteProtocol.h"
+#include "ReplayLog.h"
+#include "ResetInjection.h"
+#include "ResultsDatabase.h"
+#include "RunTrace.h"
+#include "SequentialTest.h"
+#include "SharedMemoryTransport.h"
+#include "Simulation.h"
+#include "Stats.h"
+#include "StatsAggregate.h"
+
+namespace mms {
+
+// The BatchRunner runs a mouse algo (or, in a tournament, each of several
+// algos) against each of a list of mazes without a GUI, with up to a given
+// number of algo processes running at once. Runs are started from a single
+// queue whenever a process finishes, so a slow maze never holds up the rest.
+// A CSV row of stats is written for each run, in the order that the mazes were
+// given, along with the metrics of its maze, and the stats of each maze (and
+// of the whole batch) can also be summarized.
+class BatchRunner : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Algo {
+    QString name;
+    QString directory;
+    QString runCommand;
+  };
+
+  // A non-positive timeout means that runs are never cut short. If shared
+  // memory is used, algos communicate via SharedMemoryTransport rather than
+  // stdin/stdout. If a plugin is given, it's run in-process, one maze at a
+  // time (or, if it's resumable, with many mazes at once on a few threads, see
+  // PluginScheduler), instead of the run command. If a record directory is
+  // given, a replay log of each run is written to it, named by the index of
+  // the maze.
+  // Neither the plugin nor the output stream is owned by the runner.
+  BatchRunner(const QStringList &mazeFiles, const QString &directory,
+              const QString &runCommand, double timeoutSeconds, int maxJobs,
+              bool useSharedMemory, PluginAlgo *plugin,
+              const QString &recordDirectory, QTextStream *output,
+              QObject *parent = nullptr);
+
+  // Each maze is run the given number of times, one after another, e.g., to
+  // average over an algo's randomness; must be called before start()
+  void setRepeats(int repeats);
+
+  // Runs each of the algos, rather than the one given to the constructor,
+  // against every maze, each maze's runs of every algo one after another. Rows
+  // and summaries start with the name of the algo. Must be called before
+  // start(), and can't be used with a plugin.
+  void setTournament(const QVector<Algo> &algos);
+
+  // Every finished run is appended to the checkpoint file, and any runs that
+  // the file already has are skipped, with their rows written as they were,
+  // so that an interrupted batch can be resumed. Returns false if the file
+  // couldn't be opened, or is the checkpoint of a different batch. Must be
+  // called after the repeats and tournament are set, and can't be combined
+  // with a summary, since the stats of skipped runs aren't kept.
+  bool setCheckpoint(const QString &path, QString *error);
+
+  // Results of complete runs are stored in the cache directory, and a run
+  // whose algo, maze, and settings are all unchanged is answered from the
+  // cache rather than run again, which assumes that the algos are
+  // deterministic (see ResultCache). Must be called after the tournament is
+  // set, since every algo's directory is hashed, and can't be used with a
+  // plugin.
+  void setResultCache(const QString &directory);
+
+  // Every finished run is also inserted into the results database (see
+  // ResultsDatabase), as part of a new batch; runs that were skipped, e.g.,
+  // by a checkpoint, aren't. Returns false if the database couldn't be
+  // opened.
+  bool setResultsDatabase(const QString &path, QString *error);
+
+  // Stops a tournament of two algos as soon as the test is decided by the
+  // mazes whose runs have all finished (see SequentialTest): no more runs are
+  // started, and the rows end with those that already were. Each maze's
+  // difference is the mean of the first algo's scores minus the second's.
+  // Must be called after the tournament is set, and can't be combined with a
+  // checkpoint, whose runs aren't scored. The test isn't owned by the runner.
+  void setSequentialTest(SequentialTest *test);
+
+  // If positive, a run whose algo keeps the simulator waiting for a command
+  // for this long is killed and marked as hung; unlike the timeout, this
+  // catches algos that are stuck rather than slow. Must be called before
+  // start().
+  void setHangTimeout(double seconds);
+
+  // If set, the timeout is of the CPU time that the algo process spends
+  // during the run (see ProcessUtilities::getUsage) plus the time that a real
+  // mouse would take to drive its moves (the total-time stat, see
+  // MotionProfile), rather than of real time, so that a run times out the
+  // same on a loaded machine as on an idle one. The process is sampled every
+  // so often, so a run may overshoot by a sample's worth of CPU time. Algos
+  // that aren't processes, e.g., plugins and scripts, or that can't be
+  // measured, keep the real-time timeout. Must be called before start().
+  void setCpuTimeout(bool isCpuTimed);
+
+  // If set, each row also has percentiles of the algo's think time and the
+  // simulator's service time for each command (see
+  // Simulation::setLatencyTracking); must be called before start()
+  void setLatencyColumns(bool isLatencyTracked);
+
+  // If set, each row also has the CPU time, in seconds, that the algo process
+  // spent in user and in system mode during the run, and the peak of its
+  // resident memory, in KiB, over its life, as of the run's end (see
+  // ProcessUtilities::getUsage); they're empty for algos that aren't
+  // processes, e.g., plugins and scripts. Must be called before start().
+  void setUsageColumns(bool isUsageTracked);
+
+  // If set, the maximum number of jobs is only a ceiling, and the number of
+  // runs in flight is tuned as they finish (see JobTuner), from the real
+  // time of each run, the CPU time of its algo, and the simulator's service
+  // time, which are measured whether or not their columns are written; for
+  // a resumable plugin, this is the number of its runs interleaved at once.
+  // Only runs of a local batch are tuned, not those that are served to
+  // workers, or run as one. Must be called before start().
+  void setJobTuning(bool isJobTuned);
+
+  // Each row also has the score of each of the named policies (see
+  // STRING_TO_SCORING), computed from the run's final stats, e.g., to compare
+  // rule sets without running the batch again; must be called before start()
+  void setScoringColumns(const QStringList &policies);
+
+  // If set, resets are injected into every run as scheduled (see
+  // ResetInjection), and each row also has the number of resets that were
+  // injected and acknowledged, and how many movements the algo took to reach
+  // the center again after the first one; must be called before start()
+  void setResetInjection(const ResetInjection &injection);
+
+  // Everything random in a run, e.g., sensor noise, is drawn from streams of
+  // a key of the seed, the algo, the maze, and the repeat (see RandomStream),
+  // so a run draws the same numbers in any batch, on any worker, and however
+  // many runs are in flight. The seed is zero unless it's set; must be called
+  // before start().
+  void setSeed(quint32 seed);
+
+  // If cores are given, each algo process is pinned to one of them, the one
+  // with the fewest algos on it as it starts, so that concurrent runs don't
+  // migrate between cores or contend for one (see
+  // ProcessUtilities::setAffinity), and if raised, each is given a higher
+  // priority than ordinary work. Must be called before start().
+  void setAlgoPlacement(const QVector<int> &cores, bool isPriorityRaised);
+
+  // If set, the visit counts of each run (see VisitCounts) are written to the
+  // directory as CSV, named like replays, e.g., to tell where an algo spent
+  // its search; must be called before start()
+  void setHeatmapDirectory(const QString &directory);
+
+  // Likewise, the trace of each run (see RunTrace), a row per command,
+  // response, and reset, e.g., to load a whole batch into a dataframe
+  void setTraceDirectory(const QString &directory);
+
+  // If set, the state of each run in progress is saved to the directory every
+  // so often (see SimulationCheckpoint), named like replays, and a run whose
+  // state is already there resumes from it rather than starting over, e.g.,
+  // after the batch was interrupted; a run's state is removed once it
+  // finishes. Must be called before start(), and can't be used with a plugin.
+  void setResumeDirectory(const QString &directory);
+
+  // If set, the baseline algo (see ReferenceAlgo) is also run once on each
+  // maze, in-process, and each row ends with its status, a few of its stats,
+  // and how long it took, in microseconds, e.g., to tell how much of an
+  // algo's time is the simulator's. The baseline isn't owned by the runner.
+  // Must be called before start().
+  void setBaseline(PluginAlgo *baseline, const QString &name);
+
+  // Up to this many algo processes are started ahead of the runs that will
+  // use them, so that each run starts with an algo that's already running;
+  // must be called before start()
+  void setSpareAlgos(int numSpares);
+
+  // If set, the stats of every run of each maze, and then of every run in
+  // the batch, are aggregated and written to the stream (which isn't owned by
+  // the runner) as CSV or JSON; must be called before start()
+  void setSummary(QTextStream *summary, bool isJson);
+
+  // Instead of starting the run command, each run waits for an algo to
+  // connect to the port, e.g., from a dev board or another machine, and talks
+  // to it over the connection in either protocol, just as it would over
+  // stdin/stdout; the run is complete once the algo hangs up. Must be called
+  // before start(), and can't be combined with a plugin, shared memory, a
+  // tournament, or spares. Returns false if the port can't be listened on.
+  bool listenForAlgos(quint16 port, QString *error);
+
+  // Publishes a run at a time to the viewers that connect to the port (see
+  // LiveFeed): whichever run starts while no other is followed is given a
+  // view, which is published until the run finishes. Runs of a plugin have
+  // no simulation of their own to follow. Must be called before start() or
+  // work(); returns false if the port can't be listened on.
+  bool setLiveFeed(quint16 port, QString *error);
+
+  void start();
+
+  // Instead of running anything itself, the runner listens on the port for
+  // workers and hands the runs out to them, up to each one's number of jobs;
+  // rows, summaries, and replays are written here, as if the runs were local.
+  // The runs of a worker that goes away are handed to the others. Called
+  // instead of start(); returns false if the port can't be listened on.
+  bool serve(quint16 port, QString *error);
+
+  // Instead of running a batch of its own, the runner connects to a
+  // coordinator (see serve) and runs whatever it's sent, up to the maximum
+  // number of jobs at once; finished is emitted once the coordinator says
+  // that the batch is done. Called instead of start(); returns false if the
+  // coordinator can't be reached.
+  bool work(const QString &host, quint16 port, QString *error);
+
+  // Quotes the text if it can't be a CSV field as it is
+  static QString toCsvField(QString text);
+
+ signals:
+  // Emitted once every maze has been run; the exit code is nonzero if any of
+  // the runs did not complete successfully
+  void finished(int exitCode);
+
+  // Emitted as the simulation of each run finishes, while it still exists,
+  // e.g., to gather the latencies of every run (see SoakTest)
+  void simulationFinished(const Simulation *simulation);
+
+ private:
+  static const int SAVE_INTERVAL_MILLISECONDS;
+  static const int SOCKET_READ_BUFFER_SIZE;
+  static const int PREFETCH_MAZES;
+  static const int USAGE_INTERVAL_MILLISECONDS;
+
+  // A run whose timeout is of CPU time is still stopped after this many
+  // times the timeout in real time, e.g., if the algo sleeps
+  static const double CPU_TIMEOUT_REAL_TIME_FACTOR;
+
+  // All of the state for a single maze; each run has its own mouse, stats,
+  // and algo process, so runs are completely independent, and only the maze,
+  // which is read-only, is shared with the other runs on it (see MazePool)
+  struct Run {
+    int index;  // of the run, not the maze
+    QSharedPointer<const Maze> maze;
+    Stats *stats;
+    Simulation *simulation;
+    QProcess *process;
+    SharedMemoryTransport *transport;
+    QTcpSocket *socket;  // of an algo that connected, see listenForAlgos
+    AlgoChannel *channel;  // of an algo that is a script, see ScriptAlgo
+    PluginAlgo::Instance *instance;  // of a resumable plugin, see runPlugin
+    ReplayLog *replayLog;
+    RunTrace *trace;  // null unless traced
+    MazeView *view;   // null unless followed by the live feed
+    QTimer *timeoutTimer;
+    QTimer *saveTimer;  // null unless runs are saved, see setResumeDirectory
+    qint64 startNanoseconds;  // as of the batch's clock, see setJobTuning
+
+    // The algo process is measured as the run starts, since a warm one has
+    // already used some resources on earlier runs, and then every so often,
+    // since it can't be measured once it exits (see setUsageColumns)
+    QTimer *usageTimer;  // null unless usage is tracked
+    bool isUsageMeasured;
+    ProcessUtilities::Usage startUsage;
+    ProcessUtilities::Usage lastUsage;
+    double cpuTimeoutSeconds;  // zero unless the timeout is of CPU time
+    bool timedOut;
+    bool hung;
+    bool isCached;    // if it was answered from the result cache
+    QString latency;  // the CSV fields, if latency was tracked
+    QString usage;    // the CSV fields, if usage was tracked
+    QString resets;   // the CSV fields, if resets were injected
+    QString algoMetrics;  // see AlgoMetrics::getSummary
+    QByteArray heatmap;  // the CSV of the visit counts, if written
+    QByteArray traceCsv;  // the CSV of the trace, if written
+  };
+
+  // An algo process that isn't tied to a run, either because it's done with
+  // one maze and moves on to the next rather than exiting (see
+  // Simulation::answerNextMaze), or because it's a spare
+  struct WarmAlgo {
+    int algoIndex;
+    QProcess *process;
+    SharedMemoryTransport *transport;
+    bool isBinary;
+  };
+
+  QStringList m_mazeFiles;
+  QVector<Algo> m_algos;
+  bool m_isTournament;
+  double m_timeoutSeconds;
+  double m_hangTimeoutSeconds;
+  bool m_isCpuTimed;
+  bool m_isLatencyTracked;
+  bool m_isUsageTracked;
+  QStringList m_scoringPolicies;
+  ResetInjection m_resetInjection;
+  quint32 m_seed;
+  QVector<int> m_algoCores;
+  QVector<int> m_coreLoads;  // the number of algos on each core, by index
+  bool m_isAlgoPriorityRaised;
+  PluginAlgo *m_baseline;
+  QString m_baselineName;
+  int m_maxJobs;
+  bool m_isJobTuned;
+  JobTuner m_jobTuner;
+  QElapsedTimer m_clock;  // since the batch started
+  bool m_useSharedMemory;
+  PluginAlgo *m_plugin;
+  QString m_recordDirectory;
+  QString m_heatmapDirectory;
+  QString m_traceDirectory;
+  QString m_resumeDirectory;
+  QTextStream *m_output;
+  int m_repeats;
+  int m_numSpares;
+  QTextStream *m_summary;
+  bool m_isJsonSummary;
+  QString m_resultCacheDirectory;
+  ResultsDatabase *m_database;  // null unless set, owned by the runner
+  SequentialTest *m_sequentialTest;  // null unless set
+  QVector<QByteArray> m_algoHashes;  // by algo index, empty if not cached
+
+  int m_nextIndex;     // the next run to start
+  int m_numRunning;    // the number of runs in flight
+  int m_nextRowIndex;  // the next row to write
+  int m_failures;
+  bool m_isFinished;
+
+  // Rows of runs that were read from the checkpoint, by index, and the file
+  // that finished runs are appended to
+  QMap<int, QString> m_checkpointedRows;
+  QFile m_checkpoint;
+
+  // Algos that have been started but haven't been given a maze yet
+  QList<WarmAlgo> m_spareAlgos;
+
+  // Rows of runs that finished before some earlier run
+  QMap<int, QString> m_pendingRows;
+
+  // Aggregates of cells whose rows haven't all been written yet, by the index
+  // of the cell, so that only the cells in flight are held in memory
+  QMap<int, StatsAggregate> m_cellAggregates;
+
+  // The sums of the score differences of mazes that haven't been added to the
+  // sequential test yet, and their numbers of finished runs, by maze index
+  QMap<int, double> m_scoreDifferences;
+  QMap<int, int> m_numScoredRuns;
+  StatsAggregate m_totalAggregate;
+  int m_numSummaries;  // the number of cells summarized so far
+
+  // Metrics of mazes whose rows haven't all been written yet, by the index of
+  // the maze, so that they're only computed once however often it's run
+  QMap<int, MazeMetrics> m_mazeMetrics;
+
+  // Likewise, the mazes themselves, and the mazes of the next few runs, which
+  // are loaded and measured on a thread of their own while the current runs
+  // are in flight, so that starting a run never waits on a maze file
+  struct Prefetch {
+    QSharedPointer<const Maze> maze;
+    MazeMetrics metrics;
+  };
+  QMap<int, QSharedPointer<const Maze>> m_mazes;
+  QMap<int, QFuture<Prefetch>> m_prefetches;
+  QThreadPool m_prefetchPool;
+
+  // Likewise, the CSV fields of the baseline's run of each maze
+  QMap<int, QString> m_baselineFields;
+
+  // The runs of scripts, by index, since their channels' batches (and exits)
+  // can still be in flight once a run is over
+  QMap<int, Run *> m_scriptRuns;
+
+  // The runs of a resumable plugin, by index, and the threads that resume
+  // them, which are only started once there's a run
+  QMap<int, Run *> m_pluginRuns;
+  PluginScheduler *m_pluginScheduler;
+
+  // When listening for algos, the runs that are waiting for one to connect
+  LiveFeed *m_liveFeed;  // null unless set
+
+  QTcpServer *m_algoServer;
+  QList<Run *> m_awaitingRuns;
+
+  // A connection to a worker, and the runs that it has been sent
+  struct Worker {
+    QTcpSocket *socket;
+    QByteArray buffer;  // of messages that haven't all arrived yet
+    int maxJobs;
+    QSet<int> indices;
+  };
+
+  // When serving, the workers, and the runs of any that went away, which are
+  // sent again before any new ones
+  QTcpServer *m_server;
+  QList<Worker *> m_workers;
+  QList<int> m_retryIndices;
+
+  // When working, the coordinator, and the jobs in flight, by index
+  QTcpSocket *m_coordinator;
+  QByteArray m_coordinatorBuffer;
+  QMap<int, RemoteProtocol::Job> m_jobs;
+
+  // Runs are numbered by maze, then by algo, then by repeat; a cell is every
+  // repeat of one algo on one maze
+  int getNumRuns() const;
+  int getCellIndex(int index) const;
+  int getMazeIndex(int index) const;
+  int getAlgoIndex(int index) const;
+  QString getMazeFile(int index) const;
+
+  // The name of the files of a run, e.g., its replay, which is the index of
+  // the maze, then of the algo in a tournament, then of the repeat if there
+  // are several
+  QString getRunName(int index) const;
+  QString getResumePath(int index) const;
+
+  // Resumes the run from its saved state, if there is any, and starts saving
+  // it periodically
+  void startSaving(Run *run);
+
+  // Claims the next run that isn't in the checkpoint, or returns -1
+  int takeNextIndex();
+  bool hasNextIndex();
+
+  void startRuns();
+  void startRun(int index, const WarmAlgo *algo = nullptr);
+
+  // Starts the simulation of a run whose algo is running, or connected
+  void startSimulation(Run *run, const WarmAlgo *algo);
+
+  // Scripts run in-process, on a thread of the run's own, instead of as a
+  // process; there are never spare or warm scripts
+  bool isScript(int algoIndex) const;
+  void startScript(Run *run);
+  void readOutput(Run *run);
+  void stopAlgo(Run *run);
+  void startMeasuring(Run *run);
+  void measureAlgo(Run *run);
+  void checkCpuTimeout(Run *run);
+
+  // Whether the runs in flight are tuned, i.e., it was set and the batch is
+  // local, and if so, feeds the tuner a run that's finishing
+  bool isJobTuned() const;
+  void tuneJobs(Run *run);
+
+  void acceptAlgos();
+  Run *createRun(int index);
+  QSharedPointer<const Maze> loadMaze(int index);
+
+  // Starts loading the mazes of the next runs, up to PREFETCH_MAZES of them,
+  // that haven't been loaded yet
+  void prefetchMazes();
+  static Prefetch prefetch(const QString &mazeFile);
+
+  // Finishes the run, whose maze must be loaded, with its cached result if
+  // there is one; otherwise returns false
+  bool finishFromCache(Run *run);
+  QByteArray getCacheKey(const Run *run) const;
+
+  // See setSeed; the run's maze must be loaded
+  quint64 getRandomKey(const Run *run) const;
+  void runPlugin(Run *run);
+  void onPluginFinished(int index);
+  void onNextMazeRequested(Run *run);
+
+  // Returns false if the algo couldn't be started, in which case the process
+  // and transport still need to be deleted
+  bool startAlgo(int algoIndex, WarmAlgo *algo);
+  void placeAlgo(QProcess *process);
+  void startSpareAlgos();
+  void onSpareAlgoExit(QProcess *process);
+  void onRunExit(Run *run, int exitCode, QProcess::ExitStatus exitStatus);
+  void finishRun(Run *run, QString status);
+
+  // Writes the replay and row of a finished run, or, on a worker, sends them
+  // to the coordinator
+  void recordRun(Run *run, QString status);
+  void scoreRun(const Run *run);
+  bool addToDatabase(const Run *run, const QString &status);
+  void sendResult(Run *run, const QString &status);
+
+  void onCoordinatorReadyRead();
+  void onWorkerConnected();
+  void onWorkerReadyRead(Worker *worker);
+  void onWorkerDisconnected(Worker *worker);
+  void sendJobs(Worker *worker);
+
+  void writeHeader();
+  void writeRows();
+  QString getRow(int index, const QString &status, Stats *stats,
+                 const MazeMetrics *metrics, const QString &latency,
+                 const QString &usage, const QString &resets,
+                 const QString &baseline,
+                 const QString &algoMetrics) const;
+  static QStringList getLatencyHeader();
+  static QString getLatencyFields(const Simulation *simulation);
+  static QStringList getUsageHeader();
+  static QString getUsageFields(const Run *run);
+  static QStringList getResetHeader();
+  static QString getResetFields(const Simulation *simulation);
+  static QStringList getBaselineHeader();
+  QString getBaselineFields(int mazeIndex, const Maze *maze);
+  QString getCheckpointKey() const;
+
+  // Read from the corpus, if the maze is an entry of one that has them, and
+  // otherwise computed from the maze
+  MazeMetrics getMazeMetrics(int mazeIndex, const Maze *maze);
+  static MazeMetrics computeMazeMetrics(const QString &mazeFile,
+                                        const Maze *maze);
+
+  void writeSummaryHeader();
+  void writeSummary(int cellIndex, const StatsAggregate &aggregate);
+  void writeSummaryFooter();
+};
+
+}  // namespace mms
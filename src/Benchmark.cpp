@@ -0,0 +1,347 @@
+#include "Benchmark.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+
+#include "AllocationCounter.h"
+#include "BinaryProtocol.h"
+#include "Dimensions.h"
+#include "MazeCollision.h"
+#include "MazeView.h"
+#include "Mouse.h"
+#include "Polygon.h"
+#include "Simulation.h"
+#include "Stats.h"
+
+namespace mms {
+
+const double Benchmark::MIN_SECONDS = 0.25;
+const int Benchmark::COMMANDS_PER_BATCH = 100;
+const QVector<int> Benchmark::VIEW_SIZES = {16, 32, 64, 256};
+BenchmarkHistory::Results Benchmark::RESULTS;
+
+int Benchmark::run(const QStringList &mazeFiles, const QString &historyFile,
+                   const QString &label, QTextStream *output) {
+  QTextStream err(stderr);
+
+  // The history is read up front, so that a bad file doesn't waste a run
+  BenchmarkHistory history(historyFile);
+  QString error;
+  if (!historyFile.isEmpty() && !history.load(&error)) {
+    err << error << Qt::endl;
+    return 1;
+  }
+  RESULTS.clear();
+  *output << "benchmark,iterations,nanoseconds,allocations,bytes"
+          << Qt::endl;
+
+  // Parsing, for each of the bundled mazes as well as the given ones
+  QStringList files = mazeFiles;
+  for (const auto &info :
+       QDir(":/resources/mazes/").entryInfoList(QDir::Files)) {
+    files.append(info.filePath());
+  }
+  for (const QString &file : files) {
+    QScopedPointer<Maze> maze(Maze::fromFile(file));
+    if (maze.isNull()) {
+      err << QString("Invalid maze \"%1\".").arg(file) << Qt::endl;
+      return 1;
+    }
+    report("Maze::fromFile/" + QFileInfo(file).fileName(), 1,
+           [&]() { delete Maze::fromFile(file); }, output);
+  }
+
+  // Wall queries and dispatch, against a real maze
+  QScopedPointer<Maze> maze(Maze::fromFile(":/resources/mazes/example1.num"));
+  benchmarkWallQueries(maze.data(), output);
+  benchmarkDispatch(maze.data(), output);
+
+  // Triangulation, which is lazy, so a fresh polygon is needed each time
+  QVector<Coordinate> vertices = Mouse().getCurrentBodyPolygon().getVertices();
+  report("Polygon::getTriangles/mouse-body", 1,
+         [&]() { Polygon(vertices).getTriangles(); }, output);
+  QVector<Triangle> triangles(vertices.size() - 2);
+  report("Polygon::triangulate/mouse-body", 1,
+         [&]() {
+           Polygon::triangulate(vertices.constData(), vertices.size(),
+                                triangles.data());
+         },
+         output);
+
+  // Collision of the mouse with the walls around it, at the center of every
+  // tile, swept over a half-step to the north
+  Polygon body = Mouse().getCurrentBodyPolygon();
+  QVector<Polygon> bodies;
+  for (int x = 0; x < maze->getWidth(); x += 1) {
+    for (int y = 0; y < maze->getHeight(); y += 1) {
+      bodies.append(body.translate(Coordinate::Cartesian(
+          Dimensions::tileLength() * x, Dimensions::tileLength() * y)));
+    }
+  }
+  Coordinate halfStep =
+      Coordinate::Cartesian(Distance(), Dimensions::halfTileLength());
+  report("MazeCollision::isColliding/mouse-body", bodies.size(),
+         [&]() {
+           for (const Polygon &polygon : bodies) {
+             MazeCollision::isColliding(maze.data(), polygon, halfStep);
+           }
+         },
+         output);
+
+  // View construction, which scales with the number of tiles
+  for (int size : VIEW_SIZES) {
+    QScopedPointer<Maze> empty(getEmptyMaze(size));
+    if (empty.isNull()) {
+      err << QString("Could not create a %1x%1 maze.").arg(size) << Qt::endl;
+      return 1;
+    }
+    report(QString("MazeView/%1x%1").arg(size), 1,
+           [&]() { MazeView view(empty.data(), false); }, output);
+  }
+  if (historyFile.isEmpty()) {
+    return 0;
+  }
+  int regressions = history.compare(RESULTS, &err);
+  if (!history.append(label, RESULTS, &error)) {
+    err << error << Qt::endl;
+    return 1;
+  }
+  return regressions == 0 ? 0 : 1;
+}
+
+void Benchmark::report(const QString &name, int operationsPerCall,
+                       const std::function<void()> &function,
+                       QTextStream *output) {
+  // Warm up caches and lazily initialized statics, then double the number of
+  // calls until the total time is long enough to be meaningful
+  function();
+  qint64 calls = 1;
+  qint64 nanoseconds = 0;
+  qint64 allocations = 0;
+  qint64 bytes = 0;
+  while (true) {
+    AllocationCounter counter;
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < calls; i += 1) {
+      function();
+    }
+    nanoseconds = timer.nsecsElapsed();
+    allocations = counter.getAllocations();
+    bytes = counter.getBytes();
+    if (MIN_SECONDS * 1e9 <= nanoseconds) {
+      break;
+    }
+    calls *= 2;
+  }
+
+  // The allocation columns are empty unless they're counted
+  qint64 operations = calls * operationsPerCall;
+  double mean = static_cast<double>(nanoseconds) / operations;
+  RESULTS.append({name, mean});
+  QStringList fields = {
+      name,
+      QString::number(operations),
+      QString::number(mean, 'f', 1),
+      "",
+      "",
+  };
+  if (AllocationCounter::isEnabled()) {
+    fields[3] =
+        QString::number(static_cast<double>(allocations) / operations, 'f', 2);
+    fields[4] =
+        QString::number(static_cast<double>(bytes) / operations, 'f', 1);
+  }
+  *output << fields.join(",") << Qt::endl;
+}
+
+void Benchmark::benchmarkWallQueries(const Maze *maze, QTextStream *output) {
+  Stats stats;
+  stats.resetAll();
+  Simulation simulation(maze, nullptr, &stats, nullptr);
+  simulation.setInstant(true);
+
+  // Every semi-position that the mouse can occupy, facing every direction;
+  // the mouse is teleported to each, which is included in the time
+  QVector<Simulation::Snapshot> snapshots;
+  for (int x = 1; x < 2 * maze->getWidth(); x += 1) {
+    for (int y = 1; y < 2 * maze->getHeight(); y += 1) {
+      if (x % 2 == 0 && y % 2 == 0) {
+        continue;
+      }
+      for (int i = 0; i < 8; i += 1) {
+        snapshots.append({{x, y}, static_cast<SemiDirection>(i), false, 0,
+                          stats.getState()});
+      }
+    }
+  }
+  QVector<CommandType> types = {
+      CommandType::WALL_FRONT,       CommandType::WALL_RIGHT,
+      CommandType::WALL_LEFT,        CommandType::WALL_BACK,
+      CommandType::WALL_FRONT_RIGHT, CommandType::WALL_FRONT_LEFT,
+      CommandType::WALL_BACK_RIGHT,  CommandType::WALL_BACK_LEFT,
+  };
+  report("Simulation::execute/wall-queries", snapshots.size() * types.size(),
+         [&]() {
+           for (const Simulation::Snapshot &snapshot : snapshots) {
+             simulation.restoreSnapshot(snapshot);
+             for (CommandType type : types) {
+               Command command = {type};
+               command.n = 1;
+               simulation.execute(command);
+             }
+           }
+         },
+         output);
+}
+
+void Benchmark::benchmarkDispatch(const Maze *maze, QTextStream *output) {
+  // Visualization commands need a view, and responses need somewhere to go
+  MazeView view(maze, false);
+  Stats stats;
+  stats.resetAll();
+  QBuffer responses;
+  responses.open(QBuffer::ReadWrite);
+  Simulation simulation(maze, view.getMazeGraphic(), &stats, &responses);
+  simulation.useBinaryProtocol();
+  simulation.setInstant(true);
+
+  // Movements are each followed by an about-face, so that the mouse returns
+  // to where it started every other batch rather than crashing
+  Command turn = {CommandType::TURN_RIGHT_90};
+  QByteArray aboutFace =
+      BinaryProtocol::encode(turn) + BinaryProtocol::encode(turn);
+  for (const auto &pair : getCommands()) {
+    const Command &command = pair.second;
+    bool isMovement = command.type == CommandType::MOVE_FORWARD ||
+                      command.type == CommandType::MOVE_FORWARD_HALF;
+    QByteArray batch;
+    for (int i = 0; i < COMMANDS_PER_BATCH; i += 1) {
+      batch.append(BinaryProtocol::encode(command));
+      if (isMovement) {
+        batch.append(aboutFace);
+      }
+    }
+    report("Simulation::processOutput/" + pair.first, COMMANDS_PER_BATCH,
+           [&]() {
+             // As if each batch were followed by a frame
+             simulation.processOutput(batch);
+             view.flush();
+             responses.buffer().clear();
+             responses.seek(0);
+           },
+           output);
+  }
+}
+
+QVector<QPair<QString, Command>> Benchmark::getCommands() {
+  QVector<QPair<QString, Command>> commands;
+  auto add = [&](const QString &name, CommandType type) -> Command * {
+    commands.append({name, {type}});
+    return &commands.last().second;
+  };
+  add("mazeWidth", CommandType::MAZE_WIDTH);
+  add("mazeHeight", CommandType::MAZE_HEIGHT);
+  add("wallFront", CommandType::WALL_FRONT)->n = 1;
+  add("wallRight", CommandType::WALL_RIGHT)->n = 1;
+  add("wallLeft", CommandType::WALL_LEFT)->n = 1;
+  add("wallBack", CommandType::WALL_BACK)->n = 1;
+  add("wallFrontRight", CommandType::WALL_FRONT_RIGHT)->n = 1;
+  add("wallFrontLeft", CommandType::WALL_FRONT_LEFT)->n = 1;
+  add("wallBackRight", CommandType::WALL_BACK_RIGHT)->n = 1;
+  add("wallBackLeft", CommandType::WALL_BACK_LEFT)->n = 1;
+  add("walls", CommandType::WALLS)->n = 1;
+  add("sensorScan", CommandType::SENSOR_SCAN);
+  add("readSensors", CommandType::READ_SENSORS);
+  Command *command = add("setSensors", CommandType::SET_SENSORS);
+  command->values = {40, 20, 0, 250, 5, 40, -20, 0, 250, 5};
+  add("moveForward", CommandType::MOVE_FORWARD)->n = 1;
+  add("moveForwardHalf", CommandType::MOVE_FORWARD_HALF)->n = 1;
+  add("turnRight", CommandType::TURN_RIGHT_90);
+  add("turnLeft", CommandType::TURN_LEFT_90);
+  add("turnRight45", CommandType::TURN_RIGHT_45);
+  add("turnLeft45", CommandType::TURN_LEFT_45);
+
+  // Out and back, so that the mouse ends where it started
+  command = add("moveSequence", CommandType::MOVE_SEQUENCE);
+  int forward = static_cast<int>(CommandType::MOVE_FORWARD);
+  int turn = static_cast<int>(CommandType::TURN_RIGHT_90);
+  command->values = {forward, 1, turn, 0, turn, 0,
+                     forward, 1, turn, 0, turn, 0};
+  command = add("setWall", CommandType::SET_WALL);
+  command->c = 'n';
+  command = add("clearWall", CommandType::CLEAR_WALL);
+  command->c = 'n';
+  command = add("setColor", CommandType::SET_COLOR);
+  command->c = 'G';
+  add("clearColor", CommandType::CLEAR_COLOR);
+  add("clearAllColor", CommandType::CLEAR_ALL_COLOR);
+  command = add("setText", CommandType::SET_TEXT);
+  command->text = "abc";
+  add("clearText", CommandType::CLEAR_TEXT);
+  add("clearAllText", CommandType::CLEAR_ALL_TEXT);
+
+  // The batched commands cover the first row of tiles
+  command = add("setWalls", CommandType::SET_WALLS);
+  for (int x = 0; x < 16; x += 1) {
+    command->cells.append({x, 0, 'n', ""});
+  }
+  command = add("setColors", CommandType::SET_COLORS);
+  for (int x = 0; x < 16; x += 1) {
+    command->cells.append({x, 0, 'G', ""});
+  }
+  command = add("setTexts", CommandType::SET_TEXTS);
+  for (int x = 0; x < 16; x += 1) {
+    command->cells.append({x, 0, ' ', "abc"});
+  }
+  command = add("drawPath", CommandType::DRAW_PATH);
+  command->c = 'G';
+  for (int x = 0; x < 16; x += 1) {
+    command->cells.append({2 * x + 1, 1, ' ', ""});
+  }
+  add("clearPath", CommandType::CLEAR_PATH);
+
+  // The grids cover every tile of a 16x16 maze
+  command = add("setColorGrid", CommandType::SET_COLOR_GRID);
+  command->text = QString(16 * 16, 'G');
+  command = add("setTextGrid", CommandType::SET_TEXT_GRID);
+  command->n = 3;
+  command->text = QString("abc").repeated(16 * 16);
+  command = add("setWallMask", CommandType::SET_WALL_MASK);
+  command->n = 0x9;
+  command = add("setWallGrid", CommandType::SET_WALL_GRID);
+  command->text = QString(16 * 16, '9');
+  add("wasReset", CommandType::WAS_RESET);
+  add("wasResumed", CommandType::WAS_RESUMED);
+  add("ackReset", CommandType::ACK_RESET);
+  command = add("getStat", CommandType::GET_STAT);
+  command->stat = StatsEnum::SCORE;
+  command = add("metric", CommandType::METRIC);
+  command->text = "planner-us";
+  command->value = 12.5;
+  return commands;
+}
+
+Maze *Benchmark::getEmptyMaze(int size) {
+  // Written as a map file, so that it's parsed like any other maze
+  QString border = "+" + QString("---+").repeated(size) + "\n";
+  QString posts = "+" + QString("   +").repeated(size) + "\n";
+  QString row = "|" + QString("    ").repeated(size - 1) + "   |\n";
+  QString text = border;
+  for (int y = 0; y < size; y += 1) {
+    text += row + (y + 1 < size ? posts : border);
+  }
+  QTemporaryFile file;
+  if (!file.open()) {
+    return nullptr;
+  }
+  file.write(text.toUtf8());
+  file.close();
+  return Maze::fromFile(file.fileName());
+}
+
+}  // namespace mms
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include "BenchmarkHistory.h"
+#include "Command.h"
+#include "Maze.h"
+
+namespace mms {
+
+// Microbenchmarks of the paths that the simulator's speed depends on: maze
+// parsing, wall queries, command dispatch, triangulation, collision
+// detection, and view construction. Each is run until enough time has passed
+// for a stable mean, and a CSV row of the mean time per operation is written
+// for each, along with its mean allocations and bytes, in builds that count
+// them (see AllocationCounter).
+class Benchmark {
+ public:
+  // The Benchmark class is not constructible
+  Benchmark() = delete;
+
+  // The given maze files are parsed along with the bundled mazes. If a
+  // history file is given, the results are compared to its baseline, with
+  // the report written to stderr, and then appended to it under the label
+  // (see BenchmarkHistory). Returns a nonzero exit code if any benchmark
+  // couldn't be set up, if the history couldn't be read or written, or if
+  // any benchmark regressed.
+  static int run(const QStringList &mazeFiles, const QString &historyFile,
+                 const QString &label, QTextStream *output);
+
+ private:
+  static const double MIN_SECONDS;
+  static const int COMMANDS_PER_BATCH;
+  static const QVector<int> VIEW_SIZES;
+
+  // Of the benchmarks run so far, in order, for the history
+  static BenchmarkHistory::Results RESULTS;
+
+  // Calls the function, which performs the given number of operations,
+  // until at least MIN_SECONDS have passed, then writes the row; the
+  // allocations are those of the timed calls
+  static void report(const QString &name, int operationsPerCall,
+                     const std::function<void()> &function,
+                     QTextStream *output);
+
+  static void benchmarkWallQueries(const Maze *maze, QTextStream *output);
+  static void benchmarkDispatch(const Maze *maze, QTextStream *output);
+
+  // A representative instance of every command, by name, for dispatch
+  static QVector<QPair<QString, Command>> getCommands();
+
+  // An empty, enclosed maze, i.e., one with only the border walls
+  static Maze *getEmptyMaze(int size);
+};
+
+}  // namespace mms
@@ -0,0 +1,145 @@
+#include "BenchmarkHistory.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QSaveFile>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int BenchmarkHistory::BASELINE_RUNS = 5;
+
+// The median absolute deviation, scaled by 1.4826, estimates the standard
+// deviation of normal noise, so three of them is well outside of it
+const double BenchmarkHistory::NOISE_DEVIATIONS = 3.0 * 1.4826;
+const double BenchmarkHistory::MIN_CHANGE_FRACTION = 0.05;
+
+BenchmarkHistory::BenchmarkHistory(const QString &path)
+    : m_path(path), m_runs(QJsonArray()) {}
+
+bool BenchmarkHistory::load(QString *error) {
+  QFile file(m_path);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QFile::ReadOnly)) {
+    *error = QString("Could not open \"%1\".").arg(m_path);
+    return false;
+  }
+  QJsonParseError parseError;
+  QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (parseError.error != QJsonParseError::NoError || !document.isObject() ||
+      !document.object().value("runs").isArray()) {
+    *error = QString("Invalid benchmark history \"%1\".").arg(m_path);
+    return false;
+  }
+  m_runs = document.object().value("runs").toArray();
+  return true;
+}
+
+int BenchmarkHistory::compare(const Results &results,
+                              QTextStream *output) const {
+  *output << QString("%1 %2 %3 %4 %5")
+                 .arg("benchmark", -50)
+                 .arg("baseline", 12)
+                 .arg("now", 12)
+                 .arg("change", 8)
+                 .arg("verdict")
+          << Qt::endl;
+  int regressions = 0;
+  for (const auto &result : results) {
+    QVector<double> baseline = getBaselineResults(result.first);
+    QString row = QString("%1 ").arg(result.first, -50);
+    if (baseline.isEmpty()) {
+      *output << row
+              << QString("%1 %2 %3 new")
+                     .arg("", 12)
+                     .arg(result.second, 12, 'f', 1)
+                     .arg("", 8)
+              << Qt::endl;
+      continue;
+    }
+    double median = getMedian(baseline);
+    QVector<double> deviations;
+    for (double value : baseline) {
+      deviations.append(std::fabs(value - median));
+    }
+    double noise = NOISE_DEVIATIONS * getMedian(deviations);
+    double tolerance = qMax(noise, MIN_CHANGE_FRACTION * median);
+    double change = result.second - median;
+    QString verdict = "ok";
+    if (tolerance < change) {
+      verdict = "regression";
+      regressions += 1;
+    } else if (change < -tolerance) {
+      verdict = "improvement";
+    }
+    *output << row
+            << QString("%1 %2 %3% %4")
+                   .arg(median, 12, 'f', 1)
+                   .arg(result.second, 12, 'f', 1)
+                   .arg(0.0 < median ? 100.0 * change / median : 0.0, 7, 'f',
+                        1)
+                   .arg(verdict)
+            << Qt::endl;
+  }
+  *output << "(all times in nanoseconds per operation)" << Qt::endl;
+  return regressions;
+}
+
+bool BenchmarkHistory::append(const QString &label, const Results &results,
+                              QString *error) {
+  QJsonObject values;
+  for (const auto &result : results) {
+    values.insert(result.first, result.second);
+  }
+  QJsonObject run;
+  run.insert("label", label);
+  run.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  run.insert("results", values);
+  m_runs.append(run);
+
+  // Written whole, and atomically, so that an interrupted run can't corrupt
+  // the history
+  QSaveFile file(m_path);
+  QJsonObject document;
+  document.insert("runs", m_runs);
+  if (!file.open(QFile::WriteOnly) ||
+      file.write(QJsonDocument(document).toJson()) < 0 || !file.commit()) {
+    *error = QString("Could not write \"%1\".").arg(m_path);
+    return false;
+  }
+  return true;
+}
+
+QVector<double> BenchmarkHistory::getBaselineResults(
+    const QString &name) const {
+  QVector<double> values;
+  for (int i = m_runs.size() - 1;
+       0 <= i && values.size() < BASELINE_RUNS; i -= 1) {
+    QJsonValue value =
+        m_runs.at(i).toObject().value("results").toObject().value(name);
+    if (value.isDouble()) {
+      values.prepend(value.toDouble());
+    }
+  }
+  return values;
+}
+
+double BenchmarkHistory::getMedian(QVector<double> values) {
+  ASSERT_FA(values.isEmpty());
+  std::sort(values.begin(), values.end());
+  int middle = values.size() / 2;
+  return values.size() % 2 == 1
+             ? values.at(middle)
+             : (values.at(middle - 1) + values.at(middle)) / 2;
+}
+
+}  // namespace mms
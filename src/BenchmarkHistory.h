@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QPair>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+namespace mms {
+
+// The results of past runs of the benchmarks (see Benchmark), kept in a JSON
+// file, oldest first, each labeled, e.g., by the commit that was measured.
+// A new run is compared, benchmark by benchmark, to a rolling baseline: the
+// median of the last few runs that have the benchmark. A benchmark has only
+// regressed (or improved) if it moved by more than the noise of those runs,
+// measured by their median absolute deviation, and by more than a minimum
+// fraction, so that benchmarks that are always noisy don't cry wolf.
+class BenchmarkHistory {
+ public:
+  // The mean nanoseconds per operation of each benchmark, by name
+  typedef QVector<QPair<QString, double>> Results;
+
+  explicit BenchmarkHistory(const QString &path);
+
+  // A missing file is an empty history; returns false if the file is invalid
+  bool load(QString *error);
+
+  // Writes a report of the results against the baseline, and returns the
+  // number of benchmarks that regressed
+  int compare(const Results &results, QTextStream *output) const;
+
+  // Appends the run to the history, which is then saved; returns false if
+  // it couldn't be
+  bool append(const QString &label, const Results &results, QString *error);
+
+ private:
+  static const int BASELINE_RUNS;
+  static const double NOISE_DEVIATIONS;
+  static const double MIN_CHANGE_FRACTION;
+
+  QString m_path;
+  QJsonArray m_runs;
+
+  // The results of the benchmark in the last BASELINE_RUNS runs that have it,
+  // oldest first
+  QVector<double> getBaselineResults(const QString &name) const;
+  static double getMedian(QVector<double> values);
+};
+
+}  // namespace mms
@@ -0,0 +1,401 @@
+#include "BinaryProtocol.h"
+
+#include <QtEndian>
+#include <QtNumeric>
+
+#include "AssertMacros.h"
+#include "ProtocolSchema.h"
+
+namespace mms {
+
+const char BinaryProtocol::RESPONSE_INVALID =
+    static_cast<char>(MMS_RESPONSE_INVALID);
+const char BinaryProtocol::RESPONSE_FALSE = MMS_RESPONSE_FALSE;
+const char BinaryProtocol::RESPONSE_TRUE = MMS_RESPONSE_TRUE;
+const char BinaryProtocol::RESPONSE_ACK = MMS_RESPONSE_ACK;
+const char BinaryProtocol::RESPONSE_CRASH = MMS_RESPONSE_CRASH;
+
+int BinaryProtocol::parse(const QByteArray &bytes, int position,
+                          Command *command) {
+  int available = bytes.size() - position;
+  ASSERT_LT(0, available);
+  const CommandSchema *schema =
+      getCommandSchema(static_cast<unsigned char>(bytes.at(position)));
+  if (schema == nullptr) {
+    return -1;
+  }
+  command->type = schema->type;
+
+  // Determine the size of the arguments, or parse the ones of variable size
+  int size = 0;
+  switch (schema->args) {
+    case Args::NONE:
+      break;
+    case Args::STAT:
+      size = 1;
+      break;
+    case Args::COUNT:
+      size = 2;
+      break;
+    case Args::POSITION:
+      size = 4;
+      break;
+    case Args::POSITION_AND_CHAR:
+    case Args::POSITION_AND_INTEGER:
+      size = 5;
+      break;
+    case Args::POSITION_AND_TEXT:
+      // Length-prefixed UTF-8 text follows the position
+      size = 5;
+      if (available >= 1 + size) {
+        size += static_cast<unsigned char>(bytes.at(position + 5));
+      }
+      break;
+    case Args::INTEGERS:
+      return parseSensors(bytes, position, command);
+    case Args::CELLS_AND_CHARS:
+    case Args::CELLS_AND_TEXTS:
+    case Args::CHAR_AND_CELLS:
+      return parseCells(bytes, position, command);
+    case Args::GRID_OF_CHARS:
+    case Args::GRID_OF_TEXTS:
+      return parseGrid(bytes, position, command);
+    case Args::MOVES:
+      return parseMoves(bytes, position, command);
+    case Args::NAME_AND_NUMBER:
+      return parseMetric(bytes, position, command);
+  }
+  if (available < 1 + size) {
+    return 0;
+  }
+
+  // Read the arguments
+  int args = position + 1;
+  if (schema->args == Args::STAT) {
+    int stat = static_cast<unsigned char>(bytes.at(args));
+    if (NUM_STATS <= stat) {
+      return -1;
+    }
+    command->stat = static_cast<StatsEnum>(stat);
+  } else if (schema->args == Args::COUNT) {
+    command->n = readUInt16(bytes, args);
+  } else if (schema->args != Args::NONE) {
+    command->x = readUInt16(bytes, args);
+    command->y = readUInt16(bytes, args + 2);
+    if (schema->args == Args::POSITION_AND_TEXT) {
+      command->text = QString::fromUtf8(bytes.mid(args + 5, size - 5));
+    } else if (schema->args == Args::POSITION_AND_INTEGER) {
+      command->n = static_cast<unsigned char>(bytes.at(args + 4));
+    } else if (schema->args == Args::POSITION_AND_CHAR) {
+      command->c = QChar(bytes.at(args + 4));
+    }
+  }
+  return 1 + size;
+}
+
+QByteArray BinaryProtocol::encode(const Response &response) {
+  QByteArray bytes;
+  append(response, &bytes);
+  return bytes;
+}
+
+void BinaryProtocol::append(const Response &response, QByteArray *bytes) {
+  switch (response.type) {
+    case ResponseType::ACK:
+      // A movement also says which walls are around the mouse, if asked to
+      bytes->append(RESPONSE_ACK);
+      if (!response.values.isEmpty()) {
+        appendUInt16(bytes, response.values.first());
+      }
+      break;
+    case ResponseType::CRASH:
+      // A move sequence also says which of its steps crashed
+      bytes->append(RESPONSE_CRASH);
+      if (!response.values.isEmpty()) {
+        appendUInt16(bytes, response.values.first());
+      }
+      break;
+    case ResponseType::BOOL:
+      bytes->append(response.value ? RESPONSE_TRUE : RESPONSE_FALSE);
+      break;
+    case ResponseType::INTEGER: {
+      int start = bytes->size();
+      bytes->resize(start + 2);
+      qToLittleEndian<quint16>(response.value, bytes->data() + start);
+      break;
+    }
+    case ResponseType::FLOAT: {
+      int start = bytes->size();
+      bytes->resize(start + 4);
+      qToLittleEndian<float>(response.value, bytes->data() + start);
+      break;
+    }
+    case ResponseType::INTEGERS: {
+      int start = bytes->size();
+      bytes->resize(start + 2 * response.values.size());
+      for (int i = 0; i < response.values.size(); i += 1) {
+        qToLittleEndian<quint16>(response.values.at(i),
+                                 bytes->data() + start + 2 * i);
+      }
+      break;
+    }
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+QByteArray BinaryProtocol::encode(const Command &command) {
+  QByteArray bytes(1, static_cast<char>(command.type));
+  switch (getCommandSchema(command.type).args) {
+    case Args::NONE:
+      break;
+    case Args::STAT:
+      bytes.append(static_cast<char>(command.stat));
+      break;
+    case Args::COUNT:
+      appendUInt16(&bytes, command.n);
+      break;
+    case Args::POSITION:
+      appendUInt16(&bytes, command.x);
+      appendUInt16(&bytes, command.y);
+      break;
+    case Args::POSITION_AND_CHAR:
+      appendUInt16(&bytes, command.x);
+      appendUInt16(&bytes, command.y);
+      bytes.append(command.c.toLatin1());
+      break;
+    case Args::POSITION_AND_INTEGER:
+      appendUInt16(&bytes, command.x);
+      appendUInt16(&bytes, command.y);
+      bytes.append(static_cast<char>(command.n));
+      break;
+    case Args::POSITION_AND_TEXT:
+      appendUInt16(&bytes, command.x);
+      appendUInt16(&bytes, command.y);
+      appendText(&bytes, command.text);
+      break;
+    case Args::CELLS_AND_CHARS:
+    case Args::CELLS_AND_TEXTS:
+      appendUInt16(&bytes, command.cells.size());
+      for (const Cell &cell : command.cells) {
+        appendUInt16(&bytes, cell.x);
+        appendUInt16(&bytes, cell.y);
+        if (command.type == CommandType::SET_TEXTS) {
+          appendText(&bytes, cell.text);
+        } else {
+          bytes.append(cell.c.toLatin1());
+        }
+      }
+      break;
+    case Args::CHAR_AND_CELLS:
+      bytes.append(command.c.toLatin1());
+      appendUInt16(&bytes, command.cells.size());
+      for (const Cell &cell : command.cells) {
+        appendUInt16(&bytes, cell.x);
+        appendUInt16(&bytes, cell.y);
+      }
+      break;
+    case Args::INTEGERS:
+      // Negative values wrap around, as two's complement
+      appendUInt16(&bytes, command.values.size() / 5);
+      for (int i = 0; i < command.values.size() / 5 * 5; i += 1) {
+        appendUInt16(&bytes, command.values.at(i));
+      }
+      break;
+    case Args::MOVES:
+      appendUInt16(&bytes, command.values.size() / 2);
+      for (int i = 0; i + 1 < command.values.size(); i += 2) {
+        bytes.append(static_cast<char>(command.values.at(i)));
+        appendUInt16(&bytes, command.values.at(i + 1));
+      }
+      break;
+    case Args::GRID_OF_CHARS:
+      appendUInt16(&bytes, command.text.size());
+      bytes.append(command.text.toLatin1());
+      break;
+    case Args::GRID_OF_TEXTS: {
+      int width = qBound(1, command.n, 255);
+      int count = command.text.size() / width;
+      bytes.append(static_cast<char>(width));
+      appendUInt16(&bytes, count);
+      bytes.append(command.text.toLatin1().left(count * width));
+      break;
+    }
+    case Args::NAME_AND_NUMBER:
+      appendDouble(&bytes, command.value);
+      appendText(&bytes, command.text);
+      break;
+  }
+  return bytes;
+}
+
+int BinaryProtocol::parseCells(const QByteArray &bytes, int position,
+                               Command *command) {
+  // A count is followed by that many cells; each cell is a position followed
+  // by either a char, or by length-prefixed text. Paths are instead a char
+  // (the color) followed by a count of bare positions.
+  int offset = position + 1;
+  bool isPath = getCommandSchema(command->type).args == Args::CHAR_AND_CELLS;
+  if (isPath) {
+    if (bytes.size() < offset + 1) {
+      return 0;
+    }
+    command->c = QChar(bytes.at(offset));
+    offset += 1;
+  }
+  if (bytes.size() < offset + 2) {
+    return 0;
+  }
+  int count = readUInt16(bytes, offset);
+  offset += 2;
+  bool hasText =
+      getCommandSchema(command->type).args == Args::CELLS_AND_TEXTS;
+  command->cells.reserve(count);
+  for (int i = 0; i < count; i += 1) {
+    if (bytes.size() < offset + (isPath ? 4 : 5)) {
+      return 0;
+    }
+    Cell cell;
+    cell.x = readUInt16(bytes, offset);
+    cell.y = readUInt16(bytes, offset + 2);
+    if (isPath) {
+      offset += 4;
+    } else if (hasText) {
+      int length = static_cast<unsigned char>(bytes.at(offset + 4));
+      if (bytes.size() < offset + 5 + length) {
+        return 0;
+      }
+      cell.text = QString::fromUtf8(bytes.mid(offset + 5, length));
+      offset += 5 + length;
+    } else {
+      cell.c = QChar(bytes.at(offset + 4));
+      offset += 5;
+    }
+    command->cells.append(cell);
+  }
+  return offset - position;
+}
+
+int BinaryProtocol::parseGrid(const QByteArray &bytes, int position,
+                              Command *command) {
+  // A count of tiles is followed by a char for each one, or, for text, by a
+  // fixed-width field for each one, whose width comes before the count
+  int offset = position + 1;
+  command->n = 1;
+  if (getCommandSchema(command->type).args == Args::GRID_OF_TEXTS) {
+    if (bytes.size() < offset + 1) {
+      return 0;
+    }
+    command->n = static_cast<unsigned char>(bytes.at(offset));
+    offset += 1;
+  }
+  if (bytes.size() < offset + 2) {
+    return 0;
+  }
+  int size = command->n * readUInt16(bytes, offset);
+  offset += 2;
+  if (bytes.size() < offset + size) {
+    return 0;
+  }
+  command->text = QString::fromLatin1(bytes.constData() + offset, size);
+  return offset + size - position;
+}
+
+int BinaryProtocol::parseSensors(const QByteArray &bytes, int position,
+                                 Command *command) {
+  // A count of sensors is followed by five signed integers for each one
+  int offset = position + 1;
+  if (bytes.size() < offset + 2) {
+    return 0;
+  }
+  int size = 5 * 2 * readUInt16(bytes, offset);
+  offset += 2;
+  if (bytes.size() < offset + size) {
+    return 0;
+  }
+  command->values.reserve(size / 2);
+  for (int i = 0; i < size; i += 2) {
+    command->values.append(qFromLittleEndian<qint16>(bytes.constData() +
+                                                     offset + i));
+  }
+  return offset + size - position;
+}
+
+int BinaryProtocol::parseMoves(const QByteArray &bytes, int position,
+                               Command *command) {
+  // A count of steps is followed by the opcode of each one's movement and
+  // its distance, which turns ignore; there must be at least one step
+  int offset = position + 1;
+  if (bytes.size() < offset + 2) {
+    return 0;
+  }
+  int count = readUInt16(bytes, offset);
+  offset += 2;
+  if (count == 0) {
+    return -1;
+  }
+  if (bytes.size() < offset + 3 * count) {
+    return 0;
+  }
+  command->values.reserve(2 * count);
+  for (int i = 0; i < count; i += 1) {
+    CommandType type = static_cast<CommandType>(bytes.at(offset));
+    if (type != CommandType::MOVE_FORWARD &&
+        type != CommandType::MOVE_FORWARD_HALF &&
+        type != CommandType::TURN_RIGHT_90 &&
+        type != CommandType::TURN_LEFT_90 &&
+        type != CommandType::TURN_RIGHT_45 &&
+        type != CommandType::TURN_LEFT_45) {
+      return -1;
+    }
+    command->values.append(static_cast<int>(type));
+    command->values.append(readUInt16(bytes, offset + 1));
+    offset += 3;
+  }
+  return offset - position;
+}
+
+int BinaryProtocol::parseMetric(const QByteArray &bytes, int position,
+                                Command *command) {
+  // The value, as a little-endian double, is followed by the length-prefixed
+  // name, which, like every number, must be valid (see TextProtocol)
+  int offset = position + 1;
+  if (bytes.size() < offset + 9) {
+    return 0;
+  }
+  int length = static_cast<unsigned char>(bytes.at(offset + 8));
+  if (bytes.size() < offset + 9 + length) {
+    return 0;
+  }
+  command->value = qFromLittleEndian<double>(bytes.constData() + offset);
+  if (length == 0 || !qIsFinite(command->value)) {
+    return -1;
+  }
+  command->text = QString::fromLatin1(bytes.constData() + offset + 9, length);
+  return 1 + 9 + length;
+}
+
+int BinaryProtocol::readUInt16(const QByteArray &bytes, int position) {
+  return qFromLittleEndian<quint16>(bytes.constData() + position);
+}
+
+void BinaryProtocol::appendUInt16(QByteArray *bytes, int value) {
+  char buffer[2];
+  qToLittleEndian<quint16>(value, buffer);
+  bytes->append(buffer, 2);
+}
+
+void BinaryProtocol::appendDouble(QByteArray *bytes, double value) {
+  char buffer[8];
+  qToLittleEndian<double>(value, buffer);
+  bytes->append(buffer, 8);
+}
+
+void BinaryProtocol::appendText(QByteArray *bytes, const QString &text) {
+  // The length prefix is a single byte
+  QByteArray utf8 = text.toUtf8().left(255);
+  bytes->append(static_cast<char>(utf8.size()));
+  bytes->append(utf8);
+}
+
+}  // namespace mms
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+
+#include "Command.h"
+
+namespace mms {
+
+// An optional, compact alternative to the text protocol. Each command is a
+// one-byte opcode (see CommandType) followed by fixed-width little-endian
+// arguments; see the README for the layout of each command and response.
+class BinaryProtocol {
+ public:
+  BinaryProtocol() = delete;
+
+  // Sent in response to a command that couldn't be parsed
+  static const char RESPONSE_INVALID;
+
+  // The other single-byte responses, e.g., to decode them (see ScriptAlgo)
+  static const char RESPONSE_FALSE;
+  static const char RESPONSE_TRUE;
+  static const char RESPONSE_ACK;
+  static const char RESPONSE_CRASH;
+
+  // Parses the command starting at the given position. Returns the number of
+  // bytes consumed, zero if the command is incomplete, or -1 if invalid.
+  static int parse(const QByteArray &bytes, int position, Command *command);
+
+  static QByteArray encode(const Response &response);
+
+  // Appends the encoded response, e.g., to a batch of responses, without
+  // allocating a temporary array for each one
+  static void append(const Response &response, QByteArray *bytes);
+
+  // The inverse of parse, e.g., to record commands that arrived as text.
+  // Arguments are truncated to the widths of their fields.
+  static QByteArray encode(const Command &command);
+
+ private:
+  static int parseCells(const QByteArray &bytes, int position,
+                        Command *command);
+  static int parseGrid(const QByteArray &bytes, int position,
+                       Command *command);
+  static int parseSensors(const QByteArray &bytes, int position,
+                          Command *command);
+  static int parseMoves(const QByteArray &bytes, int position,
+                        Command *command);
+  static int parseMetric(const QByteArray &bytes, int position,
+                         Command *command);
+  static int readUInt16(const QByteArray &bytes, int position);
+  static void appendUInt16(QByteArray *bytes, int value);
+  static void appendDouble(QByteArray *bytes, double value);
+  static void appendText(QByteArray *bytes, const QString &text);
+};
+
+}  // namespace mms
@@ -1,21 +1,91 @@
 #include "BufferInterface.h"
 
-#include "RGB.h"
+#include "AssertMacros.h"
 #include "SimUtilities.h"
+#include "Triangle.h"
 
 namespace mms {
 
-BufferInterface::BufferInterface(QPair<int, int> mazeSize,
-                                 QVector<TriangleGraphic> *graphicCpuBuffer,
-                                 QVector<TriangleTexture> *textureCpuBuffer)
+// Blank glyphs are empty triangles, whose positions and u values don't matter
+// until they're set by updateTileGraphicText, but whose v values never change
+const TriangleTexture BufferInterface::BLANK_GLYPH[2] = {
+    {
+        // x    y    u    v
+        {0.0, 0.0, 0.0, 0.0},
+        {0.0, 0.0, 0.0, 1.0},
+        {0.0, 0.0, 0.0, 1.0},
+    },
+    {
+        {0.0, 0.0, 0.0, 0.0},
+        {0.0, 0.0, 0.0, 1.0},
+        {0.0, 0.0, 0.0, 0.0},
+    },
+};
+
+BufferInterface::BufferInterface(
+    QPair<int, int> mazeSize, MazeGeometry *geometry,
+    QVector<VertexColor> *graphicCpuBuffer,
+    QVector<TileGraphicState> *tileGraphicStateBuffer,
+    QVector<TriangleTexture> *textureCpuBuffer,
+    QVector<VertexGraphic> *pathCpuBuffer)
     : m_mazeSize(mazeSize),
+      m_geometry(geometry),
+      m_isBuildingGeometry(geometry->polygonStartingVertices.isEmpty()),
       m_graphicCpuBuffer(graphicCpuBuffer),
-      m_textureCpuBuffer(textureCpuBuffer) {}
+      m_tileGraphicStateBuffer(tileGraphicStateBuffer),
+      m_textureCpuBuffer(textureCpuBuffer),
+      m_pathCpuBuffer(pathCpuBuffer),
+      m_isPathDirty(false),
+      m_numPolygons(0) {
+  // Every polygon is a rectangle, i.e., four distinct vertices and two
+  // triangles, and there's one for each tile, each wall, and each post, so
+  // the buffers can be sized up front
+  int width = m_mazeSize.first;
+  int height = m_mazeSize.second;
+  int numTiles = width * height;
+  int numWalls = width * (height + 1) + (width + 1) * height;
+  int numCorners = (width + 1) * (height + 1);
+  int numPolygons = numTiles + numWalls + numCorners;
+  m_graphicCpuBuffer->reserve(4 * numPolygons);
+  m_tileGraphicStateBuffer->reserve(numTiles);
+  if (!m_isBuildingGeometry) {
+    ASSERT_TR(m_geometry->mazeSize == m_mazeSize);
+    return;
+  }
+  m_geometry->mazeSize = m_mazeSize;
+  m_geometry->positions.reserve(2 * 4 * numPolygons);
+  m_geometry->indices.reserve(3 * 2 * numPolygons);
+  m_geometry->numIndicesWithoutCorners = 0;
+  m_geometry->stateCoordinates.reserve(2 * 4 * numPolygons);
+  m_geometry->polygonStartingVertices.reserve(polygonsPerTile() * numTiles +
+                                              1);
+  m_geometry->polygonStartingVertices.append(0);
+  m_geometry->baseColumnStarts.reserve(width + 1);
+  m_geometry->wallColumnStarts.reserve(width + 1);
+  m_geometry->cornerColumnStarts.reserve(width + 1);
+  m_wallIndexBuffer.reserve(3 * 2 * numWalls);
+  m_cornerIndexBuffer.reserve(3 * 2 * numCorners);
+}
 
 void BufferInterface::initTileGraphicText(
     const Distance &wallLength, const Distance &wallWidth,
     QPair<int, int> tileGraphicTextMaxSize) {
   m_tileGraphicTextCache.init(wallLength, wallWidth, tileGraphicTextMaxSize);
+  clearTileGraphicText();
+}
+
+void BufferInterface::clearTileGraphicText() {
+  m_textureCpuBuffer->clear();
+  m_tileTextSlots.fill(-1, m_mazeSize.first * m_mazeSize.second);
+  m_columnTextSlots.fill(0, m_mazeSize.first + 1);
+  m_textureDirtyRanges.clear();
+}
+
+int BufferInterface::getTileGraphicTextColumnStart(int column) const {
+  QPair<int, int> maxRowsAndCols =
+      m_tileGraphicTextCache.getTileGraphicTextMaxSize();
+  return 2 * maxRowsAndCols.first * maxRowsAndCols.second *
+         m_columnTextSlots.at(column);
 }
 
 QPair<int, int> BufferInterface::getTileGraphicTextMaxSize() {
@@ -24,60 +94,91 @@ QPair<int, int> BufferInterface::getTileGraphicTextMaxSize() {
 
 void BufferInterface::insertIntoGraphicCpuBuffer(const Polygon &polygon,
                                                  Color color,
-                                                 unsigned char alpha) {
-  QVector<TriangleGraphic> tgs =
-      SimUtilities::polygonToTriangleGraphics(polygon, color, alpha);
-  for (int i = 0; i < tgs.size(); i += 1) {
-    m_graphicCpuBuffer->append(tgs.at(i));
-  }
-}
-
-void BufferInterface::insertIntoTextureCpuBuffer() {
-  // Here we just insert dummy TriangleTexture objects. All of the actual
-  // values of the objects will be set on calls to the update method.
-  // However, we do intentionally insert the appropriate 'v' values, since
-  // these will never change.
-  TriangleTexture t1{
-      // x    y    u    v
-      {0.0, 0.0, 0.0, 0.0},
-      {0.0, 0.0, 0.0, 1.0},
-      {0.0, 0.0, 0.0, 1.0},
-  };
-  TriangleTexture t2{
-      {0.0, 0.0, 0.0, 0.0},
-      {0.0, 0.0, 0.0, 1.0},
-      {0.0, 0.0, 0.0, 0.0},
-  };
-  m_textureCpuBuffer->append(t1);
-  m_textureCpuBuffer->append(t2);
-}
-
-void BufferInterface::updateTileGraphicBaseColor(int x, int y, Color color) {
-  int index = getTileGraphicBaseStartingIndex(x, y);
-  RGB rgb = COLOR_TO_RGB().value(color);
-  for (int i = 0; i < 2; i += 1) {
-    TriangleGraphic *triangleGraphic = &(*m_graphicCpuBuffer)[index + i];
-    triangleGraphic->p1.rgb = rgb;
-    triangleGraphic->p2.rgb = rgb;
-    triangleGraphic->p3.rgb = rgb;
+                                                 unsigned char alpha,
+                                                 ThemeColor theme) {
+  int polygonIndex = m_numPolygons;
+  m_numPolygons += 1;
+  if (m_isBuildingGeometry) {
+    insertIntoGeometry(polygon, polygonIndex);
+  }
+
+  // Each of the polygon's vertices has a color, set below
+  int start = m_graphicCpuBuffer->size();
+  int end = m_geometry->polygonStartingVertices.at(polygonIndex + 1);
+  ASSERT_EQ(start, m_geometry->polygonStartingVertices.at(polygonIndex));
+  m_graphicCpuBuffer->resize(end);
+  m_graphicDirtyRanges.insert(start, end - start);
+
+  // The first polygon of each tile starts a new tile graphic state
+  int tileIndex = polygonIndex / polygonsPerTile();
+  if (tileIndex == m_tileGraphicStateBuffer->size()) {
+    m_tileGraphicStateBuffer->append(TileGraphicState());
+  }
+  updatePolygonColor(polygonIndex, color, alpha, theme);
+}
+
+bool BufferInterface::isBuildingGeometry() const {
+  return m_isBuildingGeometry;
+}
+
+void BufferInterface::insertEmptyIntoGraphicCpuBuffer() {
+  m_numPolygons += 1;
+  if (m_isBuildingGeometry) {
+    m_geometry->polygonStartingVertices.append(m_geometry->positions.size() /
+                                               2);
+  }
+}
+
+void BufferInterface::finishGraphicIndexBuffer() {
+  ASSERT_EQ(m_numPolygons, m_geometry->polygonStartingVertices.size() - 1);
+  if (!m_isBuildingGeometry) {
+    return;
+  }
+
+  // Walls and corners span the edges between tiles, so they're drawn over
+  // the bases of every tile that they touch. They never overlap each other,
+  // so their order among themselves doesn't matter.
+  QVector<unsigned int> *indices = &m_geometry->indices;
+  int numBaseIndices = indices->size();
+  m_geometry->baseColumnStarts.append(numBaseIndices);
+  m_geometry->wallColumnStarts.append(m_wallIndexBuffer.size());
+  m_geometry->cornerColumnStarts.append(m_cornerIndexBuffer.size());
+  indices->append(m_wallIndexBuffer);
+  m_geometry->numIndicesWithoutCorners = indices->size();
+  indices->append(m_cornerIndexBuffer);
+
+  // The column starts of the walls and corners were recorded before they
+  // were moved after the bases
+  for (int &start : m_geometry->wallColumnStarts) {
+    start += numBaseIndices;
+  }
+  for (int &start : m_geometry->cornerColumnStarts) {
+    start += m_geometry->numIndicesWithoutCorners;
   }
+  ASSERT_EQ(m_geometry->baseColumnStarts.size(), m_mazeSize.first + 1);
+  m_wallIndexBuffer.clear();
+  m_wallIndexBuffer.squeeze();
+  m_cornerIndexBuffer.clear();
+  m_cornerIndexBuffer.squeeze();
+  m_isBuildingGeometry = false;
+}
+
+int BufferInterface::getNumGraphicIndicesWithoutCorners() const {
+  return m_geometry->numIndicesWithoutCorners;
+}
+
+void BufferInterface::updateTileGraphicBaseColor(int x, int y, Color color,
+                                                 ThemeColor theme) {
+  updatePolygonColor(getTileGraphicBasePolygonIndex(x, y), color, 255, theme);
 }
 
 void BufferInterface::updateTileGraphicWallColor(int x, int y,
                                                  Direction direction,
                                                  Color color,
-                                                 unsigned char alpha) {
-  int index = getTileGraphicWallStartingIndex(x, y, direction);
-  RGB rgb = COLOR_TO_RGB().value(color);
-  for (int i = 0; i < 2; i += 1) {
-    TriangleGraphic *triangleGraphic = &(*m_graphicCpuBuffer)[index + i];
-    triangleGraphic->p1.rgb = rgb;
-    triangleGraphic->p2.rgb = rgb;
-    triangleGraphic->p3.rgb = rgb;
-    triangleGraphic->p1.a = alpha;
-    triangleGraphic->p2.a = alpha;
-    triangleGraphic->p3.a = alpha;
-  }
+                                                 unsigned char alpha,
+                                                 ThemeColor theme) {
+  updatePolygonColor(getTileGraphicWallPolygonIndex(x, y, direction), color,
+                     alpha, theme);
 }
 
 void BufferInterface::updateTileGraphicText(int x, int y, int numRows,
@@ -91,71 +192,265 @@ void BufferInterface::updateTileGraphicText(int x, int y, int numRows,
   //    | /         |    | /       /         |
   //   [LL]---------+   [p1]     [p1]------[p3]
 
-  QPair<double, double> fontImageCharacterPosition =
-      m_tileGraphicTextCache.getFontImageCharacterPosition(c);
+  // Tiles without glyphs are already blank
+  if (m_tileTextSlots.at(m_mazeSize.second * x + y) < 0 && c == ' ') {
+    return;
+  }
+  const TileGraphicTextCache::Glyph &glyph =
+      m_tileGraphicTextCache.getFontImageGlyph(c);
+  const TileGraphicTextCache::Quad &quad =
+      m_tileGraphicTextCache.getTileGraphicTextQuad(numRows, numCols, row, col);
 
-  QPair<Coordinate, Coordinate> LL_UR =
-      m_tileGraphicTextCache.getTileGraphicTextPosition(x, y, numRows, numCols,
-                                                        row, col);
+  // Offset the quad from the starting tile to this one
+  double tileLength = m_tileGraphicTextCache.getTileLengthMeters();
+  float left = quad.left + tileLength * x;
+  float bottom = quad.bottom + tileLength * y;
+  float right = quad.right + tileLength * x;
+  float top = quad.top + tileLength * y;
 
   int triangleTextureIndex = getTileGraphicTextStartingIndex(x, y, row, col);
+  m_textureDirtyRanges.insert(triangleTextureIndex, 2);
   TriangleTexture *t1 = &(*m_textureCpuBuffer)[triangleTextureIndex];
   TriangleTexture *t2 = &(*m_textureCpuBuffer)[triangleTextureIndex + 1];
 
-  t1->p1.x = LL_UR.first.getX().getMeters();
-  t1->p1.y = LL_UR.first.getY().getMeters();
-  t1->p1.u = fontImageCharacterPosition.first;
-  t1->p2.x = LL_UR.first.getX().getMeters();
-  t1->p2.y = LL_UR.second.getY().getMeters();
-  t1->p2.u = fontImageCharacterPosition.first;
-  t1->p3.x = LL_UR.second.getX().getMeters();
-  t1->p3.y = LL_UR.second.getY().getMeters();
-  t1->p3.u = fontImageCharacterPosition.second;
-
-  t2->p1.x = LL_UR.first.getX().getMeters();
-  t2->p1.y = LL_UR.first.getY().getMeters();
-  t2->p1.u = fontImageCharacterPosition.first;
-  t2->p2.x = LL_UR.second.getX().getMeters();
-  t2->p2.y = LL_UR.second.getY().getMeters();
-  t2->p2.u = fontImageCharacterPosition.second;
-  t2->p3.x = LL_UR.second.getX().getMeters();
-  t2->p3.y = LL_UR.first.getY().getMeters();
-  t2->p3.u = fontImageCharacterPosition.second;
-}
-
-int BufferInterface::trianglesPerTile() {
+  // The v values never change
+  t1->p1 = {left, bottom, glyph.start, t1->p1.v};
+  t1->p2 = {left, top, glyph.start, t1->p2.v};
+  t1->p3 = {right, top, glyph.end, t1->p3.v};
+  t2->p1 = {left, bottom, glyph.start, t2->p1.v};
+  t2->p2 = {right, top, glyph.end, t2->p2.v};
+  t2->p3 = {right, bottom, glyph.end, t2->p3.v};
+}
+
+void BufferInterface::updatePath(const QVector<Coordinate> &points,
+                                 Color color) {
+  int paletteIndex = TilePalette::getIndex(color, ThemeColor::NONE);
+  m_pathCpuBuffer->clear();
+  m_pathCpuBuffer->reserve(points.size());
+  for (const Coordinate &point : points) {
+    m_pathCpuBuffer->append(
+        SimUtilities::toVertexGraphic(point, paletteIndex, 255));
+  }
+  m_isPathDirty = true;
+}
+
+const DirtyRanges &BufferInterface::getGraphicDirtyRanges() const {
+  return m_graphicDirtyRanges;
+}
+
+const DirtyRanges &BufferInterface::getTextureDirtyRanges() const {
+  return m_textureDirtyRanges;
+}
+
+const DirtyRanges &BufferInterface::getTileGraphicStateDirtyRanges() const {
+  return m_tileGraphicStateDirtyRanges;
+}
+
+bool BufferInterface::isPathDirty() const { return m_isPathDirty; }
+
+void BufferInterface::clearDirtyRanges() {
+  m_graphicDirtyRanges.clear();
+  m_textureDirtyRanges.clear();
+  m_tileGraphicStateDirtyRanges.clear();
+  m_isPathDirty = false;
+}
+
+QPair<int, int> BufferInterface::getTileGraphicStateTextureSize() const {
+  return {6 * m_mazeSize.second, m_mazeSize.first};
+}
+
+qint64 BufferInterface::getMemoryBytes() const {
+  // The dirty ranges are coalesced, so they stay small
+  return sizeof(int) * (m_tileTextSlots.capacity() +
+                        m_columnTextSlots.capacity()) +
+         sizeof(unsigned int) * (m_wallIndexBuffer.capacity() +
+                                 m_cornerIndexBuffer.capacity());
+}
+
+qint64 BufferInterface::getTextCacheMemoryBytes() const {
+  return m_tileGraphicTextCache.getMemoryBytes();
+}
+
+int BufferInterface::polygonsPerTile() {
   // This value must be predetermined, and was done so as follows:
-  // Base polygon:      2 (2 triangles x 1 polygon  per tile)
-  // Wall polygon:      8 (2 triangles x 4 polygons per tile)
-  // Corner polygon:    8 (2 triangles x 4 polygons per tile)
+  // Base polygon:      1
+  // Wall polygon:      4
+  // Corner polygon:    4
   // --------------------
-  // Total             18
-  return 18;
+  // Total              9
+  // Walls and corners that are held by a neighboring tile take up an index,
+  // but have no vertices.
+  return 9;
+}
+
+int BufferInterface::getTileGraphicBasePolygonIndex(int x, int y) {
+  return 0 + polygonsPerTile() * (m_mazeSize.second * x + y);
 }
 
-int BufferInterface::getTileGraphicBaseStartingIndex(int x, int y) {
-  return 0 + trianglesPerTile() * (m_mazeSize.second * x + y);
+int BufferInterface::getTileGraphicWallPolygonIndex(int x, int y,
+                                                    Direction direction) {
+  // A wall between two tiles is held by the tile to its south or west (see
+  // Tile::ownsWall); the other tile's polygon for it is empty
+  if (direction == Direction::WEST && 0 < x) {
+    x -= 1;
+    direction = Direction::EAST;
+  } else if (direction == Direction::SOUTH && 0 < y) {
+    y -= 1;
+    direction = Direction::NORTH;
+  }
+  return 1 + polygonsPerTile() * (m_mazeSize.second * x + y) +
+         CARDINAL_DIRECTIONS().indexOf(direction);
+}
+
+bool BufferInterface::isWallPolygon(int polygonIndex) {
+  int index = polygonIndex % polygonsPerTile();
+  return 1 <= index && index < 5;
+}
+
+bool BufferInterface::isCornerPolygon(int polygonIndex) {
+  return 5 <= polygonIndex % polygonsPerTile();
+}
+
+int BufferInterface::getTileGraphicCornerPolygonIndex(int x, int y,
+                                                      int cornerNumber) {
+  return 5 + polygonsPerTile() * (m_mazeSize.second * x + y) + cornerNumber;
+}
+
+void BufferInterface::insertIntoGeometry(const Polygon &polygon,
+                                         int polygonIndex) {
+  // Triangles of the same polygon share vertices (e.g., the two triangles of a
+  // rectangle share two of them), so only insert each distinct vertex once.
+  // Vertices are never shared between polygons, since their colors differ.
+  const QVector<Triangle> triangles = polygon.getTriangles();
+  QVector<float> *positions = &m_geometry->positions;
+  int start = positions->size() / 2;
+
+  // Each column starts with the base of its first tile, which is never empty
+  if (polygonIndex % (polygonsPerTile() * m_mazeSize.second) == 0) {
+    m_geometry->baseColumnStarts.append(m_geometry->indices.size());
+    m_geometry->wallColumnStarts.append(m_wallIndexBuffer.size());
+    m_geometry->cornerColumnStarts.append(m_cornerIndexBuffer.size());
+  }
+
+  // Walls and corners are indexed after the bases of every tile (see
+  // finishGraphicIndexBuffer)
+  QVector<unsigned int> *indexBuffer = &m_geometry->indices;
+  if (isWallPolygon(polygonIndex)) {
+    indexBuffer = &m_wallIndexBuffer;
+  } else if (isCornerPolygon(polygonIndex)) {
+    indexBuffer = &m_cornerIndexBuffer;
+  }
+  for (const Triangle &triangle : triangles) {
+    for (const Coordinate *point : {&triangle.p1, &triangle.p2, &triangle.p3}) {
+      float x = static_cast<float>(point->getX().getMeters());
+      float y = static_cast<float>(point->getY().getMeters());
+      int index = start;
+      while (2 * index < positions->size() &&
+             (positions->at(2 * index) != x ||
+              positions->at(2 * index + 1) != y)) {
+        index += 1;
+      }
+      if (2 * index == positions->size()) {
+        positions->append(x);
+        positions->append(y);
+      }
+      indexBuffer->append(index);
+    }
+  }
+  int end = positions->size() / 2;
+  m_geometry->polygonStartingVertices.append(end);
+
+  // Sample from the center of the texel, so that there's no bleeding
+  int tileIndex = polygonIndex / polygonsPerTile();
+  QPair<int, int> textureSize = getTileGraphicStateTextureSize();
+  int column = 6 * (tileIndex % m_mazeSize.second) +
+               getTileGraphicStateColorIndex(polygonIndex);
+  int row = tileIndex / m_mazeSize.second;
+  for (int i = start; i < end; i += 1) {
+    m_geometry->stateCoordinates.append((column + 0.5) / textureSize.first);
+    m_geometry->stateCoordinates.append((row + 0.5) / textureSize.second);
+  }
 }
 
-int BufferInterface::getTileGraphicWallStartingIndex(int x, int y,
-                                                     Direction direction) {
-  return 2 + trianglesPerTile() * (m_mazeSize.second * x + y) +
-         (2 * CARDINAL_DIRECTIONS().indexOf(direction));
+void BufferInterface::updatePolygonColor(int polygonIndex, Color color,
+                                         unsigned char alpha,
+                                         ThemeColor theme) {
+  const QVector<int> &startingVertices = m_geometry->polygonStartingVertices;
+  ASSERT_LT(polygonIndex + 1, startingVertices.size());
+  int paletteIndex = TilePalette::getIndex(color, theme);
+  if (TilePalette::hasThemeAlpha(theme)) {
+    alpha = 255;
+  }
+  int start = startingVertices.at(polygonIndex);
+  int end = startingVertices.at(polygonIndex + 1);
+  m_graphicDirtyRanges.insert(start, end - start);
+  for (int i = start; i < end; i += 1) {
+    VertexColor *vertexColor = &(*m_graphicCpuBuffer)[i];
+    vertexColor->paletteIndex = paletteIndex;
+    vertexColor->a = alpha;
+  }
+
+  int tileIndex = polygonIndex / polygonsPerTile();
+  m_tileGraphicStateDirtyRanges.insert(tileIndex, 1);
+  TileGraphicState *state = &(*m_tileGraphicStateBuffer)[tileIndex];
+  unsigned char *entry =
+      state->colors[getTileGraphicStateColorIndex(polygonIndex)];
+  entry[0] = paletteIndex;
+  entry[3] = alpha;
 }
 
-int BufferInterface::getTileGraphicCornerStartingIndex(int x, int y,
-                                                       int cornerNumber) {
-  return 10 + trianglesPerTile() * (m_mazeSize.second * x + y) +
-         (2 * cornerNumber);
+int BufferInterface::getTileGraphicStateColorIndex(int polygonIndex) {
+  // The base and walls each have their own color, but the corners share one
+  return qMin(polygonIndex % polygonsPerTile(), 5);
 }
 
 int BufferInterface::getTileGraphicTextStartingIndex(int x, int y, int row,
                                                      int col) {
+  if (m_tileTextSlots.at(m_mazeSize.second * x + y) < 0) {
+    insertTileGraphicText(x, y);
+  }
   QPair<int, int> maxRowsAndCols = getTileGraphicTextMaxSize();
-  int triangleTexturesPerTile =
-      2 * maxRowsAndCols.first * maxRowsAndCols.second;
-  return triangleTexturesPerTile * (m_mazeSize.second * x + y) +
+  return getTrianglesPerTileGraphicText() *
+             m_tileTextSlots.at(m_mazeSize.second * x + y) +
          2 * (row * maxRowsAndCols.second + col);
 }
 
+int BufferInterface::getTrianglesPerTileGraphicText() {
+  QPair<int, int> maxRowsAndCols = getTileGraphicTextMaxSize();
+  return 2 * maxRowsAndCols.first * maxRowsAndCols.second;
+}
+
+void BufferInterface::insertTileGraphicText(int x, int y) {
+  // The glyphs go after those of the tiles before this one, which is almost
+  // always at the end, since text tends to be set column by column, e.g.,
+  // by setTextGrid; otherwise, the glyphs after them move up
+  int index = m_mazeSize.second * x + y;
+  int slot = m_columnTextSlots.at(x);
+  for (int i = index - y; i < index; i += 1) {
+    if (0 <= m_tileTextSlots.at(i)) {
+      slot += 1;
+    }
+  }
+  for (int i = index + 1;
+       slot < m_columnTextSlots.last() && i < m_tileTextSlots.size();
+       i += 1) {
+    if (0 <= m_tileTextSlots.at(i)) {
+      m_tileTextSlots[i] += 1;
+    }
+  }
+  m_tileTextSlots[index] = slot;
+  for (int i = x + 1; i < m_columnTextSlots.size(); i += 1) {
+    m_columnTextSlots[i] += 1;
+  }
+
+  int count = getTrianglesPerTileGraphicText();
+  int start = count * slot;
+  m_textureCpuBuffer->insert(start, count, BLANK_GLYPH[0]);
+  TriangleTexture *triangles = m_textureCpuBuffer->data() + start;
+  for (int i = 1; i < count; i += 2) {
+    triangles[i] = BLANK_GLYPH[1];
+  }
+  m_textureDirtyRanges.insert(start, m_textureCpuBuffer->size() - start);
+}
+
 }  // namespace mms
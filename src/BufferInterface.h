@@ -6,60 +6,169 @@
 
 #include "Color.h"
 #include "Direction.h"
+#include "DirtyRanges.h"
+#include "MazeGeometry.h"
 #include "Polygon.h"
+#include "TileGraphicState.h"
 #include "TileGraphicTextCache.h"
-#include "TriangleGraphic.h"
+#include "TilePalette.h"
 #include "TriangleTexture.h"
+#include "VertexColor.h"
+#include "VertexGraphic.h"
 
 namespace mms {
 
 class BufferInterface {
  public:
-  BufferInterface(QPair<int, int> mazeSize,
-                  QVector<TriangleGraphic> *graphicCpuBuffer,
-                  QVector<TriangleTexture> *textureCpuBuffer);
+  // If the geometry is empty, it's built as the polygons are inserted, and
+  // otherwise it must be for a maze of the same size, and only the colors of
+  // the polygons are inserted
+  BufferInterface(QPair<int, int> mazeSize, MazeGeometry *geometry,
+                  QVector<VertexColor> *graphicCpuBuffer,
+                  QVector<TileGraphicState> *tileGraphicStateBuffer,
+                  QVector<TriangleTexture> *textureCpuBuffer,
+                  QVector<VertexGraphic> *pathCpuBuffer);
 
   // Initializes and caches all possible tile text positions. We need this
   // extra initialization function since the max size is from the algorithm.
+  // The texture cpu buffer is emptied, as by clearTileGraphicText.
   void initTileGraphicText(const Distance &wallLength,
                            const Distance &wallWidth,
                            QPair<int, int> tileGraphicTextMaxSize);
 
+  // The texture cpu buffer only holds the glyphs of the tiles that have had
+  // text, in the same order as the tiles, each tile's glyphs inserted (all
+  // blank) the first time that one of them isn't, so it costs nothing to
+  // upload or draw the text of views without any. Emptying it forgets every
+  // tile's glyphs, e.g., once all of the text has been cleared.
+  void clearTileGraphicText();
+
+  // Where the triangles of each column's text start in the texture cpu
+  // buffer; the column after the last is the size of the buffer
+  int getTileGraphicTextColumnStart(int column) const;
+
   // Returns the maximum number of rows and columns of text in a tile graphic
   QPair<int, int> getTileGraphicTextMaxSize();
 
-  // Fills the graphic cpu buffer and texture cpu buffer
+  // Fills the graphic cpu buffer and texture cpu buffer. The graphic cpu
+  // buffer holds the colors of the distinct vertices of each polygon, whose
+  // positions and triangles are in the geometry. Alongside the vertices, this
+  // fills the tile graphic state buffer, which holds the same colors once per
+  // tile rather than once per vertex.
+  // The theme color, if any, is what the tile state buffer refers to, so
+  // that it follows changes of theme; see TilePalette.
   void insertIntoGraphicCpuBuffer(const Polygon &polygon, Color color,
-                                  unsigned char alpha);
-  void insertIntoTextureCpuBuffer();
+                                  unsigned char alpha, ThemeColor theme);
+
+  // Whether the polygons inserted above are used, i.e., whether the geometry
+  // is still being built; otherwise it was built by another view of the same
+  // maze, and the polygons can be empty
+  bool isBuildingGeometry() const;
+
+  // Takes up a polygon index without drawing anything, e.g., for a wall that
+  // is drawn by the neighboring tile
+  void insertEmptyIntoGraphicCpuBuffer();
+
+  // Must be called once every polygon has been inserted. Afterwards, the
+  // triangles of the wall polygons follow those of the bases in the graphic
+  // index buffer, and the triangles of the corner polygons are at the end, so
+  // that the rest of the maze can be drawn on its own, e.g., when the corners
+  // would be too small to see.
+  void finishGraphicIndexBuffer();
+  int getNumGraphicIndicesWithoutCorners() const;
 
   // These methods are inexpensive, and may be called many times
-  void updateTileGraphicBaseColor(int x, int y, Color color);
+  void updateTileGraphicBaseColor(int x, int y, Color color,
+                                  ThemeColor theme);
   void updateTileGraphicWallColor(int x, int y, Direction direction,
-                                  Color color, unsigned char alpha);
+                                  Color color, unsigned char alpha,
+                                  ThemeColor theme);
   void updateTileGraphicText(int x, int y, int numRows, int numCols, int row,
                              int col, QChar c);
 
+  // Replaces the vertices of the path cpu buffer, which are drawn as a single
+  // line strip on top of the maze; the path is cleared if there are none
+  void updatePath(const QVector<Coordinate> &points, Color color);
+
+  // The vertices of the graphic cpu buffer and the triangles of the texture
+  // cpu buffer that have been inserted or updated since the last call to
+  // clearDirtyRanges(), i.e., that need to be uploaded, and whether the path
+  // changed since then; paths are small, so they're uploaded whole
+  const DirtyRanges &getGraphicDirtyRanges() const;
+  const DirtyRanges &getTextureDirtyRanges() const;
+  const DirtyRanges &getTileGraphicStateDirtyRanges() const;
+  bool isPathDirty() const;
+  void clearDirtyRanges();
+
+  // The tile graphic state buffer, viewed as a texture, has a row for each
+  // column of the maze, and the colors of each tile are adjacent in that row
+  QPair<int, int> getTileGraphicStateTextureSize() const;
+
+  // The heap memory of the interface's own bookkeeping, i.e., not the
+  // buffers that it fills, nor the text cache, which is counted on its own
+  qint64 getMemoryBytes() const;
+  qint64 getTextCacheMemoryBytes() const;
+
  private:
   // The width and height of the maze
   QPair<int, int> m_mazeSize;
 
-  // CPU-side buffers
-  QVector<TriangleGraphic> *m_graphicCpuBuffer;
+  // CPU-side buffers; the geometry is only written while it's being built
+  MazeGeometry *m_geometry;
+  bool m_isBuildingGeometry;
+  QVector<VertexColor> *m_graphicCpuBuffer;
+  QVector<TileGraphicState> *m_tileGraphicStateBuffer;
   QVector<TriangleTexture> *m_textureCpuBuffer;
+  QVector<VertexGraphic> *m_pathCpuBuffer;
+  DirtyRanges m_graphicDirtyRanges;
+  DirtyRanges m_textureDirtyRanges;
+  DirtyRanges m_tileGraphicStateDirtyRanges;
+  bool m_isPathDirty;
 
   // A cache for tile graphic text information
   TileGraphicTextCache m_tileGraphicTextCache;
 
-  // Retrieve the indices into the graphic cpu buffer,
-  // for each specific type of Tile triangle
-  int trianglesPerTile();
-  int getTileGraphicBaseStartingIndex(int x, int y);
-  int getTileGraphicWallStartingIndex(int x, int y, Direction direction);
-  int getTileGraphicCornerStartingIndex(int x, int y, int cornerNumber);
+  // The two triangles of a blank glyph
+  static const TriangleTexture BLANK_GLYPH[2];
+
+  // By tile index, the position of the tile's glyphs among those in the
+  // texture cpu buffer, or -1 if it has none, and the position of the first
+  // glyphs of each column, plus the number of tiles with glyphs
+  QVector<int> m_tileTextSlots;
+  QVector<int> m_columnTextSlots;
+
+  // The number of polygons inserted so far, including empty ones
+  int m_numPolygons;
+
+  // The indices of the triangles of the wall and corner polygons, until
+  // they're appended to the geometry's indices
+  QVector<unsigned int> m_wallIndexBuffer;
+  QVector<unsigned int> m_cornerIndexBuffer;
+
+  // Appends the vertices and triangles of the polygon to the geometry
+  void insertIntoGeometry(const Polygon &polygon, int polygonIndex);
+
+  // Retrieve the indices of polygons, for each specific type of Tile polygon
+  int polygonsPerTile();
+  int getTileGraphicBasePolygonIndex(int x, int y);
+  int getTileGraphicWallPolygonIndex(int x, int y, Direction direction);
+  int getTileGraphicCornerPolygonIndex(int x, int y, int cornerNumber);
+  bool isWallPolygon(int polygonIndex);
+  bool isCornerPolygon(int polygonIndex);
+
+  // Sets the color of every vertex of a polygon, and the palette entry of its
+  // tile graphic state
+  void updatePolygonColor(int polygonIndex, Color color, unsigned char alpha,
+                          ThemeColor theme);
+
+  // Retrieve the index of a polygon's color within its tile graphic state
+  int getTileGraphicStateColorIndex(int polygonIndex);
 
-  // Retrieve the indices into the texture cpu buffer
+  // Retrieve the indices into the texture cpu buffer, inserting the tile's
+  // glyphs if it has none yet
   int getTileGraphicTextStartingIndex(int x, int y, int row, int col);
+  int getTrianglesPerTileGraphicText();
+  void insertTileGraphicText(int x, int y);
 };
 
 }  // namespace mms
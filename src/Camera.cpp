@@ -0,0 +1,65 @@
+#include "Camera.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const double Camera::MIN_ZOOM = 1.0;
+const double Camera::MAX_ZOOM = 64.0;
+
+Camera::Camera() : m_zoom(MIN_ZOOM), m_pan(0.0, 0.0), m_isFollowing(false) {}
+
+void Camera::reset() {
+  m_zoom = MIN_ZOOM;
+  m_pan = QPointF(0.0, 0.0);
+  m_isFollowing = false;
+}
+
+double Camera::getZoom() const { return m_zoom; }
+
+void Camera::zoomAt(QPointF point, double factor) {
+  ASSERT_LT(0.0, factor);
+  QPointF fitted = toFitted(point);
+  m_zoom = qBound(MIN_ZOOM, m_zoom * factor, MAX_ZOOM);
+  m_pan = point - m_zoom * fitted;
+  clampPan();
+}
+
+void Camera::pan(QPointF offset) {
+  m_pan += offset;
+  clampPan();
+}
+
+void Camera::centerOn(QPointF fittedPoint) {
+  m_pan = QPointF(0.5, 0.5) - m_zoom * fittedPoint;
+  clampPan();
+}
+
+void Camera::setFollowing(bool following) { m_isFollowing = following; }
+
+bool Camera::isFollowing() const { return m_isFollowing; }
+
+QPointF Camera::toFitted(QPointF point) const {
+  return (point - m_pan) / m_zoom;
+}
+
+QMatrix4x4 Camera::getMatrix() const {
+  // A point p of the fitted map is at zoom * p + pan in the view, and OpenGL
+  // coordinates are 2 * p - 1, so the offset also makes up for the zoom
+  // having moved the origin
+  double x = m_zoom - 1.0 + 2.0 * m_pan.x();
+  double y = m_zoom - 1.0 + 2.0 * m_pan.y();
+  return QMatrix4x4(m_zoom, 0.0, 0.0, x,
+                    0.0, m_zoom, 0.0, y,
+                    0.0, 0.0, 1.0, 0.0,
+                    0.0, 0.0, 0.0, 1.0);
+}
+
+void Camera::clampPan() {
+  // The fitted map, scaled by the zoom, must cover the whole view
+  double min = 1.0 - m_zoom;
+  m_pan.setX(qBound(min, m_pan.x(), 0.0));
+  m_pan.setY(qBound(min, m_pan.y(), 0.0));
+}
+
+}  // namespace mms
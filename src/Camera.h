@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QPointF>
+
+namespace mms {
+
+// The Camera zooms and pans a view of the map. Points are in units of the
+// view, from (0, 0) at its lower left to (1, 1) at its upper right, so that
+// what's visible doesn't change when the view is resized. Without a camera,
+// the whole maze is fitted to the view (see TransformationMatrix); the camera
+// scales that fitted map by the zoom and then offsets it by the pan, which is
+// clamped so that the view never leaves the fitted map. At the minimum zoom,
+// the whole maze is shown, just as without a camera.
+class Camera {
+ public:
+  Camera();
+
+  static const double MIN_ZOOM;
+  static const double MAX_ZOOM;
+
+  // Shows the whole maze again, and stops following
+  void reset();
+
+  double getZoom() const;
+
+  // Zooms by the factor, keeping the point of the view where it is, e.g.,
+  // the one under the cursor
+  void zoomAt(QPointF point, double factor);
+
+  // Moves the map by the offset, e.g., that the cursor was dragged by
+  void pan(QPointF offset);
+
+  // Pans so that the point of the fitted map is at the center of the view,
+  // or as close to it as the clamping allows
+  void centerOn(QPointF fittedPoint);
+
+  // If following, the view is centered on the first mouse before every frame
+  // (see MapRenderer)
+  void setFollowing(bool following);
+  bool isFollowing() const;
+
+  // The point of the fitted map that's at the point of the view
+  QPointF toFitted(QPointF point) const;
+
+  // Applied to an OpenGL coordinate of the fitted map, after the
+  // transformation matrix, gives its coordinate in the view
+  QMatrix4x4 getMatrix() const;
+
+ private:
+  double m_zoom;
+  QPointF m_pan;
+  bool m_isFollowing;
+
+  void clampPan();
+};
+
+}  // namespace mms
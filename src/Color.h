@@ -28,6 +28,18 @@ enum class Color {
 };
 
 const QMap<QChar, Color> &CHAR_TO_COLOR();
-const QMap<Color, RGB> &COLOR_TO_RGB();
+
+// Inline and indexed by value, since it's called for every polygon update
+inline RGB COLOR_TO_RGB(Color color) {
+  // In the order of the enum
+  static constexpr RGB rgbs[] = {
+      {0, 0, 0},      {0, 0, 179},   {0, 102, 102}, {179, 179, 179},
+      {0, 179, 0},    {179, 102, 0}, {204, 0, 0},   {255, 255, 255},
+      {179, 179, 0},  {0, 0, 51},    {0, 51, 51},   {26, 26, 26},
+      {0, 77, 0},     {51, 26, 0},   {77, 0, 0},    {51, 0, 51},
+      {51, 51, 0},
+  };
+  return rgbs[static_cast<int>(color)];
+}
 
 }  // namespace mms
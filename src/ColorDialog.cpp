@@ -27,7 +27,7 @@ ColorDialog::ColorDialog(QChar tileBaseColor, QChar tileWallColor,
        {m_tileBaseColor, m_tileWallColor, m_mouseBodyColor, m_mouseWheelColor,
         m_tileWallIsSetColor}) {
     for (auto it = map.begin(); it != map.end(); it++) {
-      RGB rgb = COLOR_TO_RGB().value(it.value());
+      RGB rgb = COLOR_TO_RGB(it.value());
       QPixmap pixmap(32, 32);
       pixmap.fill(QColor(rgb.r, rgb.g, rgb.b));
       comboBox->addItem(QIcon(pixmap), it.key());
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QChar>
+#include <QString>
+#include <QVector>
+
+#include "../util/mms-protocol.h"
+#include "Stats.h"
+
+namespace mms {
+
+// The commands that an algo can issue, as listed by the protocol's schema
+// (see ProtocolSchema.h). The values double as the opcodes of the binary
+// protocol, so they must never change.
+#define MMS_COMMAND_TYPE(name, opcode, text, args, reply) name = opcode,
+enum class CommandType : unsigned char {
+  MMS_PROTOCOL_COMMANDS(MMS_COMMAND_TYPE)
+};
+#undef MMS_COMMAND_TYPE
+
+// The arguments for a single cell of a batched command
+struct Cell {
+  int x;
+  int y;
+  QChar c;  // direction for walls, color for colors
+  QString text;
+};
+
+// A parsed command, independent of the protocol that it arrived in. Only the
+// fields relevant to the command's type are meaningful.
+struct Command {
+  CommandType type;
+  int x;
+  int y;
+  int n;    // half-steps away for wall queries, distance for movements, the
+            // width of each field for text grids, and the walls of a mask
+  QChar c;  // direction for walls, color for colors and paths
+  QString text;  // also the packed tiles of grids
+  StatsEnum stat;
+  QVector<Cell> cells;  // for batched commands, and the points of paths
+  QVector<int> values;  // five for each sensor of setSensors, and the type
+                        // and distance of each step of a move sequence
+  double value;         // of a metric, whose name is the text
+};
+
+enum class ResponseType {
+  NONE,  // the command is still in progress, e.g., a movement
+  ACK,
+  CRASH,
+  BOOL,
+  INTEGER,
+  FLOAT,
+  INTEGERS,  // e.g., the distances of a sensor scan, or sensor readings
+};
+
+// A response to a command, independent of the protocol that it's sent in
+struct Response {
+  ResponseType type;
+  double value;
+  QVector<int> values;  // for INTEGERS, the step that a sequence crashed on,
+                        // for the CRASH of a move sequence, and the walls
+                        // around the mouse, for the ACK of a movement with
+                        // wall acks
+};
+
+}  // namespace mms
@@ -0,0 +1,94 @@
+#include "CommandParser.h"
+
+#include "BinaryProtocol.h"
+#include "TextProtocol.h"
+
+namespace mms {
+
+CommandParser::CommandParser()
+    : m_isBinary(false), m_lines(LineBuffer()), m_binaryBytes(QByteArray()) {}
+
+void CommandParser::append(const QByteArray &bytes) {
+  if (m_isBinary) {
+    m_binaryBytes.append(bytes);
+  } else {
+    m_lines.append(bytes);
+  }
+}
+
+CommandParser::Status CommandParser::parse(QVector<Command> *commands,
+                                           int maxCommands) {
+  if (m_isBinary) {
+    return parseBinary(commands, maxCommands);
+  }
+  return parseText(commands, maxCommands);
+}
+
+void CommandParser::useBinaryProtocol() {
+  m_isBinary = true;
+  m_lines.clear();
+}
+
+bool CommandParser::isBinary() const { return m_isBinary; }
+
+bool CommandParser::isEmpty() const {
+  return m_lines.isEmpty() && m_binaryBytes.isEmpty();
+}
+
+void CommandParser::clear() {
+  m_lines.clear();
+  m_binaryBytes.clear();
+}
+
+CommandParser::Status CommandParser::parseText(QVector<Command> *commands,
+                                               int maxCommands) {
+  int numParsed = 0;
+  QByteArrayView line;
+  while (true) {
+    if (numParsed == maxCommands) {
+      return Status::LIMIT;
+    }
+    if (!m_lines.nextLine(&line)) {
+      break;
+    }
+    if (line == TextProtocol::BINARY_HANDSHAKE) {
+      return Status::HANDSHAKE;
+    }
+    Command command;
+    if (TextProtocol::parse(line, &command)) {
+      commands->append(command);
+      numParsed += 1;
+    }
+  }
+  return Status::NONE;
+}
+
+CommandParser::Status CommandParser::parseBinary(QVector<Command> *commands,
+                                                 int maxCommands) {
+  Status status = Status::NONE;
+  int numParsed = 0;
+  int position = 0;
+  while (position < m_binaryBytes.size()) {
+    if (numParsed == maxCommands) {
+      status = Status::LIMIT;
+      break;
+    }
+    Command command;
+    int size = BinaryProtocol::parse(m_binaryBytes, position, &command);
+    if (size == 0) {
+      // Wait for the rest of the command
+      break;
+    }
+    if (size < 0) {
+      m_binaryBytes.clear();
+      return Status::INVALID;
+    }
+    position += size;
+    commands->append(command);
+    numParsed += 1;
+  }
+  m_binaryBytes.remove(0, position);
+  return status;
+}
+
+}  // namespace mms
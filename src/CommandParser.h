@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+#include "Command.h"
+#include "LineBuffer.h"
+
+namespace mms {
+
+// Turns an algo's output into commands, in whichever protocol the algo is
+// using. It holds no other simulation state, so output can be parsed apart
+// from the simulation that executes the commands, e.g., on another thread.
+class CommandParser {
+ public:
+  CommandParser();
+
+  // Why parsing stopped
+  enum class Status {
+    NONE,       // all of the complete commands have been parsed
+    HANDSHAKE,  // the algo asked for the binary protocol; everything after
+                // the request is left buffered until it's accepted or not
+    INVALID,    // the binary framing couldn't be recovered, so everything
+                // that was buffered has been dropped
+    LIMIT,      // the most commands that were asked for have been parsed, and
+                // there may be more left buffered
+  };
+
+  void append(const QByteArray &bytes);
+
+  // Appends complete commands, in order, until one of the above happens. If
+  // a handshake is rejected, call parse again to continue in text. At most
+  // maxCommands are appended, if given, so that whoever executes them can
+  // leave the rest of the output unparsed until there's room for it.
+  Status parse(QVector<Command> *commands, int maxCommands = -1);
+
+  // Accepts a handshake (or skips it, e.g., for shared memory). The algo must
+  // wait for the ack before sending binary commands, so any text that's
+  // still buffered is dropped.
+  void useBinaryProtocol();
+  bool isBinary() const;
+
+  // Whether there's no buffered output, not even an incomplete command
+  bool isEmpty() const;
+  void clear();
+
+ private:
+  bool m_isBinary;
+
+  // Incomplete output is only parsed once it's terminated with a newline
+  // (text) or once the whole command has arrived (binary)
+  LineBuffer m_lines;
+  QByteArray m_binaryBytes;
+
+  Status parseText(QVector<Command> *commands, int maxCommands);
+  Status parseBinary(QVector<Command> *commands, int maxCommands);
+};
+
+}  // namespace mms
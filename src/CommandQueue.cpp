@@ -0,0 +1,54 @@
+#include "CommandQueue.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+CommandQueue::CommandQueue(int capacity)
+    : m_commands(capacity), m_head(0), m_size(0), m_maxSize(0) {
+  ASSERT_LT(0, capacity);
+}
+
+int CommandQueue::getCapacity() const { return m_commands.size(); }
+
+int CommandQueue::size() const { return m_size; }
+
+bool CommandQueue::isEmpty() const { return m_size == 0; }
+
+bool CommandQueue::isFull() const { return m_size == m_commands.size(); }
+
+void CommandQueue::enqueue(const Command &command) {
+  ASSERT_FA(isFull());
+  m_commands[(m_head + m_size) % m_commands.size()] = command;
+  m_size += 1;
+  m_maxSize = qMax(m_maxSize, m_size);
+}
+
+const Command &CommandQueue::head() const {
+  ASSERT_FA(isEmpty());
+  return m_commands.at(m_head);
+}
+
+void CommandQueue::dequeue() {
+  ASSERT_FA(isEmpty());
+  // Release the command's text and cells rather than holding them until the
+  // slot is reused
+  m_commands[m_head] = Command();
+  m_head = (m_head + 1) % m_commands.size();
+  m_size -= 1;
+}
+
+void CommandQueue::clear() {
+  while (!isEmpty()) {
+    dequeue();
+  }
+  m_head = 0;
+}
+
+int CommandQueue::getMaxSize() const { return m_maxSize; }
+
+qint64 CommandQueue::getMemoryBytes() const {
+  return sizeof(Command) * m_commands.capacity();
+}
+
+}  // namespace mms
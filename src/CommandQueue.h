@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QVector>
+
+#include "Command.h"
+
+namespace mms {
+
+// The commands that are waiting for a response, oldest first, in a ring of
+// fixed capacity that's allocated up front, so that the memory held by a
+// simulation doesn't depend on how far ahead of it the algo gets. It's up to
+// the owner to stop enqueueing once it's full, e.g., by leaving the algo's
+// output unparsed until a command is answered.
+class CommandQueue {
+ public:
+  explicit CommandQueue(int capacity);
+
+  int getCapacity() const;
+  int size() const;
+  bool isEmpty() const;
+  bool isFull() const;
+
+  // The queue must not be full, and must not be empty, respectively
+  void enqueue(const Command &command);
+  const Command &head() const;
+  void dequeue();
+  void clear();
+
+  // The most commands that were ever queued at once, e.g., to tell how far
+  // ahead an algo pipelines its commands
+  int getMaxSize() const;
+
+  // The ring itself, not what the queued commands hold, e.g., their text
+  qint64 getMemoryBytes() const;
+
+ private:
+  QVector<Command> m_commands;
+  int m_head;  // the index of the oldest command
+  int m_size;
+  int m_maxSize;
+};
+
+}  // namespace mms
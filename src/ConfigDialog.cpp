@@ -30,6 +30,9 @@ ConfigDialog::ConfigDialog(QString name, QString directory,
   appendRow(gridLayout, "Directory", m_directory);
   appendRow(gridLayout, "Build Command", m_buildCommand);
   appendRow(gridLayout, "Run Command", m_runCommand);
+  m_runCommand->setToolTip(
+      "The command that runs the algorithm, or the path of a JavaScript\n"
+      "file (ending in .js) to run inside the simulator instead");
 
   // Enforce nonempty name field
   connect(m_name, &QLineEdit::textChanged, this, &ConfigDialog::validate);
@@ -0,0 +1,150 @@
+#include "Daemon.h"
+
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QJsonValue>
+
+#include "MazePool.h"
+
+namespace mms {
+
+const int Daemon::MAX_JOB_SIZE = 16 * 1024 * 1024;
+const int Daemon::MAX_CACHED_MAZES = 4096;
+
+Daemon::Daemon(QObject *parent)
+    : QObject(parent),
+      m_server(new QTcpServer(this)),
+      m_clients(QList<Client *>()),
+      m_mazes(QHash<QString, QSharedPointer<const Maze>>()) {
+  connect(m_server, &QTcpServer::newConnection, this,
+          &Daemon::acceptClients);
+}
+
+bool Daemon::listen(quint16 port, QString *error) {
+  // Jobs name algos to run, so only this machine may submit them
+  if (!m_server->listen(QHostAddress::LocalHost, port)) {
+    *error = QString("Could not listen on port %1: %2")
+                 .arg(port)
+                 .arg(m_server->errorString());
+    return false;
+  }
+  return true;
+}
+
+void Daemon::acceptClients() {
+  while (m_server->hasPendingConnections()) {
+    Client *client = new Client();
+    client->socket = m_server->nextPendingConnection();
+    client->output = nullptr;
+    client->runner = nullptr;
+    m_clients.append(client);
+    connect(client->socket, &QTcpSocket::readyRead, this,
+            [=]() { readJob(client); });
+
+    // A job that's started runs to the end, even if nobody is left to read
+    // its rows, since its algos can't be stopped partway
+    connect(client->socket, &QTcpSocket::disconnected, this, [=]() {
+      if (client->runner == nullptr) {
+        m_clients.removeOne(client);
+        client->socket->deleteLater();
+        delete client;
+      }
+    });
+  }
+}
+
+void Daemon::readJob(Client *client) {
+  if (client->runner != nullptr) {
+    client->socket->readAll();
+    return;
+  }
+  client->buffer.append(client->socket->readAll());
+  int newline = client->buffer.indexOf('\n');
+  if (newline < 0) {
+    if (MAX_JOB_SIZE < client->buffer.size()) {
+      finishJob(client, {{"error", "The job is too big"}});
+    }
+    return;
+  }
+  QJsonParseError parseError;
+  QJsonDocument document =
+      QJsonDocument::fromJson(client->buffer.left(newline), &parseError);
+  QString error;
+  if (!document.isObject()) {
+    error = QString("The job isn't a JSON object: %1")
+                .arg(parseError.errorString());
+  } else if (startJob(client, document.object(), &error)) {
+    return;
+  }
+  finishJob(client, {{"error", error}});
+}
+
+bool Daemon::startJob(Client *client, const QJsonObject &job,
+                      QString *error) {
+  // The fields are named like the options of --headless
+  QStringList mazeFiles;
+  for (const QJsonValue &value : job.value("mazes").toArray()) {
+    mazeFiles.append(value.toString());
+  }
+  QString directory = job.value("directory").toString();
+  QString runCommand = job.value("run").toString();
+  double timeoutSeconds = job.value("timeout").toDouble(0.0);
+  int maxJobs = job.value("jobs").toInt(1);
+  int repeats = job.value("repeats").toInt(1);
+  int numSpares = job.value("prestart").toInt(0);
+  if (mazeFiles.isEmpty() || directory.isEmpty() || runCommand.isEmpty()) {
+    *error = "A job needs \"mazes\", \"directory\", and \"run\"";
+    return false;
+  }
+  if (maxJobs < 1 || repeats < 1 || numSpares < 0) {
+    *error = "Invalid \"jobs\", \"repeats\", or \"prestart\"";
+    return false;
+  }
+  cacheMazes(mazeFiles);
+
+  client->output = new QTextStream(client->socket);
+  client->runner =
+      new BatchRunner(mazeFiles, directory, runCommand, timeoutSeconds,
+                      maxJobs, false, nullptr, QString(), client->output, this);
+  client->runner->setRepeats(repeats);
+  client->runner->setSpareAlgos(numSpares);
+  client->runner->setSeed(job.value("seed").toInt(0));
+  client->runner->setHangTimeout(job.value("hang-timeout").toDouble(0.0));
+  connect(client->runner, &BatchRunner::finished, this,
+          [=](int exitCode) { finishJob(client, {{"exitCode", exitCode}}); });
+  client->runner->start();
+  return true;
+}
+
+void Daemon::finishJob(Client *client, const QJsonObject &result) {
+  client->socket->disconnect(this);
+  client->socket->write(QJsonDocument(result).toJson(QJsonDocument::Compact));
+  client->socket->write("\n");
+  client->socket->disconnectFromHost();
+  m_clients.removeOne(client);
+  client->socket->deleteLater();
+  if (client->runner != nullptr) {
+    // The runner may be emitting the signal
+    client->runner->deleteLater();
+  }
+  delete client->output;
+  delete client;
+}
+
+void Daemon::cacheMazes(const QStringList &mazeFiles) {
+  // Holding the mazes keeps them in the pool between jobs; a file that
+  // changed since is parsed again, since the pool is keyed by contents
+  if (MAX_CACHED_MAZES < m_mazes.size() + mazeFiles.size()) {
+    m_mazes.clear();
+  }
+  for (const QString &path : mazeFiles) {
+    QSharedPointer<const Maze> maze = MazePool::fromFile(path);
+    if (!maze.isNull()) {
+      m_mazes.insert(path, maze);
+    }
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+
+#include "BatchRunner.h"
+#include "Maze.h"
+
+namespace mms {
+
+// A headless simulator that keeps running, e.g., on a CI machine, and runs
+// whatever batches are submitted to it over a port on the loopback interface,
+// rather than being started for every batch. Each connection submits a single
+// job, a line of JSON, and is sent the batch's CSV, exactly as --headless
+// writes it, a row at a time as the runs finish, then a line of JSON with the
+// exit code (or the error, if the job was invalid), and is then closed. Jobs
+// run at once, each in a BatchRunner of its own.
+//
+// The mazes of every job are kept loaded (see MazePool), so a maze that's
+// used by job after job is only ever parsed once.
+class Daemon : public QObject {
+  Q_OBJECT
+
+ public:
+  Daemon(QObject *parent = nullptr);
+
+  // Returns false if the port can't be listened on
+  bool listen(quint16 port, QString *error);
+
+ private:
+  static const int MAX_JOB_SIZE;
+  static const int MAX_CACHED_MAZES;
+
+  struct Client {
+    QTcpSocket *socket;
+    QByteArray buffer;      // of the job, until its line is complete
+    QTextStream *output;    // onto the socket, once the job starts
+    BatchRunner *runner;    // null until the job starts
+  };
+
+  QTcpServer *m_server;
+  QList<Client *> m_clients;
+  QHash<QString, QSharedPointer<const Maze>> m_mazes;  // by file
+
+  void acceptClients();
+  void readJob(Client *client);
+  bool startJob(Client *client, const QJsonObject &job, QString *error);
+  void finishJob(Client *client, const QJsonObject &result);
+  void cacheMazes(const QStringList &mazeFiles);
+};
+
+}  // namespace mms
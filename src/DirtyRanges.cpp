@@ -0,0 +1,56 @@
+#include "DirtyRanges.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+void DirtyRanges::insert(int start, int count) {
+  ASSERT_LE(0, start);
+  ASSERT_LE(0, count);
+  if (count == 0) {
+    return;
+  }
+  int end = start + count;
+
+  // Absorb the preceding range if it overlaps or touches this one
+  QMap<int, int>::iterator it = m_ranges.lowerBound(start);
+  if (it != m_ranges.begin()) {
+    QMap<int, int>::iterator previous = it;
+    previous--;
+    if (start <= previous.value()) {
+      start = previous.key();
+      end = qMax(end, previous.value());
+      m_ranges.erase(previous);
+    }
+  }
+
+  // Absorb all of the following ranges that overlap or touch this one
+  it = m_ranges.lowerBound(start);
+  while (it != m_ranges.end() && it.key() <= end) {
+    end = qMax(end, it.value());
+    it = m_ranges.erase(it);
+  }
+
+  m_ranges.insert(start, end);
+}
+
+void DirtyRanges::insert(const DirtyRanges &other) {
+  for (auto it = other.m_ranges.constBegin(); it != other.m_ranges.constEnd();
+       it++) {
+    insert(it.key(), it.value() - it.key());
+  }
+}
+
+void DirtyRanges::clear() { m_ranges.clear(); }
+
+bool DirtyRanges::isEmpty() const { return m_ranges.isEmpty(); }
+
+QVector<QPair<int, int>> DirtyRanges::getRanges() const {
+  QVector<QPair<int, int>> ranges;
+  for (auto it = m_ranges.constBegin(); it != m_ranges.constEnd(); it++) {
+    ranges.append({it.key(), it.value() - it.key()});
+  }
+  return ranges;
+}
+
+}  // namespace mms
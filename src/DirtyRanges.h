@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QMap>
+#include <QPair>
+#include <QVector>
+
+namespace mms {
+
+// A set of index ranges within a buffer that have changed since the buffer was
+// last uploaded. Overlapping and adjacent ranges are merged as they're added,
+// so the ranges are always disjoint and sorted.
+class DirtyRanges {
+ public:
+  void insert(int start, int count);
+
+  // Adds every range of the other set, e.g., to combine the changes of
+  // several frames
+  void insert(const DirtyRanges &other);
+  void clear();
+  bool isEmpty() const;
+
+  // Returns (start, count) pairs, in increasing order of start
+  QVector<QPair<int, int>> getRanges() const;
+
+ private:
+  // Maps the start of each range to its (exclusive) end
+  QMap<int, int> m_ranges;
+};
+
+}  // namespace mms
@@ -1,11 +1,54 @@
 #include "Driver.h"
 
+#include <algorithm>
+
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QRandomGenerator>
+#include <QScopedPointer>
+#include <QSet>
+#include <QSurfaceFormat>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
 
+#include "AlgoBuilder.h"
 #include "AssertMacros.h"
+#include "BatchRunner.h"
+#include "Benchmark.h"
 #include "ColorManager.h"
+#include "Daemon.h"
+#include "EnvServer.h"
+#include "FrameExporter.h"
+#include "GpuMazeMetrics.h"
+#include "JobTuner.h"
+#include "LiveViewer.h"
+#include "LockstepRunner.h"
 #include "Logging.h"
+#include "Maze.h"
+#include "MazeArchive.h"
+#include "MazeCorpus.h"
+#include "MazeGenerator.h"
+#include "MazeSampler.h"
+#include "MazeSolver.h"
+#include "MemoryReport.h"
+#include "PathScorer.h"
+#include "PluginAlgo.h"
+#include "ProcessUtilities.h"
+#include "Profiler.h"
+#include "ReplayLog.h"
+#include "ResetInjection.h"
+#include "ScoringPolicy.h"
+#include "SequentialTest.h"
 #include "Settings.h"
+#include "SettingsMouseAlgos.h"
+#include "SoakTest.h"
 #include "Window.h"
 
 namespace mms {
@@ -14,20 +57,1208 @@ int Driver::drive(int argc, char *argv[]) {
   // Make sure that this function is called just once
   ASSERT_RUNS_JUST_ONCE();
 
+  // Sections are only timed if requested, see Profiler.h
+  Profiler::init();
+
+  // Headless mode must be detected before any QApplication is created
+  QString watchedAddress;
+  for (int i = 1; i < argc; i += 1) {
+    if (QString(argv[i]) == "--headless") {
+      return driveHeadless(argc, argv);
+    }
+    if (QString(argv[i]) == "--watch" && i + 1 < argc) {
+      watchedAddress = QString(argv[i + 1]);
+    }
+  }
+
+  // Sync frames to the display's refresh rate, so that they don't tear; this
+  // must be done before the application is created
+  QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+  format.setSwapInterval(1);
+
+  // Ask for a core profile, whose programs share their uniforms through
+  // uniform buffers (see MapRenderer); if the driver falls back to an older
+  // context, the map is drawn with GLSL 1.x, as before. OpenGL ES contexts
+  // support both without asking.
+#if !QT_CONFIG(opengles2)
+  format.setVersion(3, 3);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+#endif
+  QSurfaceFormat::setDefaultFormat(format);
+
+  // Every widget's context shares with the others, so that the maps of all
+  // of the windows share their programs and font atlas (see MapResources)
+  QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
   // Initialize Qt
   QApplication app(argc, argv);
+  Profiler::markEventLoopTurns();
 
   // Initialize singletons
   Logging::init();
   Settings::init();
   ColorManager::init();
 
+  // Watch a live feed (see LiveFeed), if requested, rather than show the main
+  // window
+  if (!watchedAddress.isNull()) {
+    int colon = watchedAddress.lastIndexOf(':');
+    bool ok = false;
+    uint port = watchedAddress.mid(colon + 1).toUInt(&ok);
+    if (colon < 1 || !ok || port < 1 || 0xffff < port) {
+      QTextStream(stderr) << "Invalid live feed address, which must be "
+                             "host:port."
+                          << Qt::endl;
+      return 1;
+    }
+    LiveViewer viewer;
+    viewer.show();
+    viewer.connectToFeed(watchedAddress.left(colon), port);
+    int exitCode = app.exec();
+    Profiler::finish();
+    Logging::finish();
+    return exitCode;
+  }
+
   // Create the main window
   Window window;
   window.show();
 
   // Start the event loop
-  return app.exec();
+  int exitCode = app.exec();
+  Profiler::finish();
+  Logging::finish();
+  return exitCode;
+}
+
+int Driver::driveHeadless(int argc, char *argv[]) {
+  // Initialize Qt, without a GUI; rendering and GPU metrics need OpenGL, and
+  // so a platform plugin, but no windows are ever shown
+  QScopedPointer<QCoreApplication> app;
+  bool isUsingOpenGL = false;
+  for (int i = 1; i < argc; i += 1) {
+    isUsingOpenGL |= QString(argv[i]) == "--render" ||
+                     QString(argv[i]) == "--gpu-metrics";
+  }
+  if (isUsingOpenGL) {
+    app.reset(new QGuiApplication(argc, argv));
+  } else {
+    app.reset(new QCoreApplication(argc, argv));
+  }
+  Profiler::markEventLoopTurns();
+
+  // Initialize singletons; logging is left alone so that only the results
+  // are written to stdout
+  Settings::init();
+
+  // Parse the command line
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Runs a mouse algo against each of the given mazes, without a GUI, and "
+      "writes the resulting stats as CSV");
+  parser.addHelpOption();
+  parser.addPositionalArgument("mazes", "Maze files to run the algo on",
+                               "[mazes...]");
+  QCommandLineOption headlessOption("headless", "Run without a GUI");
+  QCommandLineOption algoOption(
+      "algo",
+      "Name of a mouse algo configured in the GUI, may be repeated with "
+      "--tournament", "name");
+  QCommandLineOption tournamentOption(
+      "tournament",
+      "Run each --algo, or every configured algo if none is given, against "
+      "every maze");
+  QCommandLineOption earlyStopOption(
+      "early-stop",
+      "Run the mazes of a tournament of two algos in random order, and stop "
+      "once their scores show which is better, or that neither is, with this "
+      "confidence", "confidence");
+  QCommandLineOption checkpointOption(
+      "checkpoint",
+      "File to record finished runs in, so that an interrupted batch resumes "
+      "where it left off", "file");
+  QCommandLineOption directoryOption(
+      "directory", "Directory of the mouse algo, overrides --algo", "path");
+  QCommandLineOption runCommandOption(
+      "run-command", "Run command of the mouse algo, overrides --algo",
+      "command");
+  QCommandLineOption buildOption(
+      "build",
+      "Build each algo, in parallel, before running any, skipping those whose "
+      "directories haven't changed since their last build");
+  QCommandLineOption buildCommandOption(
+      "build-command", "Build command of the mouse algo, overrides --algo",
+      "command");
+  QCommandLineOption pluginOption(
+      "plugin",
+      "Shared library of the mouse algo, see util/mms-plugin.h, overrides "
+      "--algo", "file");
+  QCommandLineOption referenceOption(
+      "reference",
+      "Built-in mouse algo to run in-process, like a plugin: wall-follow, "
+      "flood-fill, or dijkstra, overrides --algo", "name");
+  QCommandLineOption baselineOption(
+      "baseline",
+      "Built-in mouse algo to also run once on each maze, in-process, for the "
+      "baseline columns of each row, see --reference", "name");
+  QCommandLineOption mazesOption(
+      "mazes", "File containing maze file paths, one per line", "file");
+  QCommandLineOption corpusOption(
+      "corpus", "Corpus file containing mazes, see --pack", "file");
+  QCommandLineOption sampleOption(
+      "sample",
+      "Run a sample of the mazes, stratified by size, dead end density, and "
+      "distance to the center, picked by the run seed", "count");
+  QCommandLineOption packOption(
+      "pack", "Pack the mazes into a corpus file, rather than running them",
+      "file");
+  QCommandLineOption archiveOption(
+      "archive",
+      "Pack the mazes of a tar, compressed tar, or zip archive into the "
+      "--pack corpus, streamed without extracting it, - for a tar on stdin",
+      "file");
+  QCommandLineOption gpuMetricsOption(
+      "gpu-metrics",
+      "Compute the distances, dead ends, and branching factors of the --pack "
+      "corpus with an OpenGL compute shader");
+  QCommandLineOption generateOption(
+      "generate",
+      "Generate random mazes into the --pack corpus, rather than running an "
+      "algo, with one of: dfs, prim, kruskal, competition", "algorithm");
+  QCommandLineOption sizeOption(
+      "size", "Size of the generated mazes", "WIDTHxHEIGHT", "16x16");
+  QCommandLineOption countOption(
+      "count", "Number of mazes to generate", "count", "1000");
+  QCommandLineOption seedOption(
+      "seed", "Seed of the first generated maze, defaults to a random one",
+      "seed");
+  QCommandLineOption runSeedOption(
+      "run-seed",
+      "Seed of the random streams of every run, e.g., of sensor noise, "
+      "defaults to zero", "seed", "0");
+  QCommandLineOption solveOption(
+      "solve",
+      "Write the fastest run through each of the mazes, as text API "
+      "commands, rather than running an algo");
+  QCommandLineOption scorePathsOption(
+      "score-paths",
+      "Score the runs in the file, one moveSequence's steps per line, on "
+      "each of the mazes, rather than running an algo", "file");
+  QCommandLineOption envServerOption(
+      "env-server",
+      "Step episodes on the mazes for the client that created the file, "
+      "rather than running an algo, see util/mms_env.py", "file");
+  QCommandLineOption outputOption(
+      "output", "File to write the CSV to, defaults to stdout", "file");
+  QCommandLineOption summaryOption(
+      "summary",
+      "File to write stats aggregated per maze and overall to, as JSON if it "
+      "ends in .json and CSV otherwise", "file");
+  QCommandLineOption repeatOption(
+      "repeat", "Number of times to run each maze", "count", "1");
+  QCommandLineOption timeoutOption(
+      "timeout", "Seconds before a run is stopped, zero means never",
+      "seconds", "0");
+  QCommandLineOption cpuTimeoutOption(
+      "cpu-timeout",
+      "Measure --timeout in the algo process's CPU time plus the time that "
+      "its mouse would take to drive its moves, rather than in real time");
+  QCommandLineOption hangTimeoutOption(
+      "hang-timeout",
+      "Seconds that an algo may keep the simulator waiting for a command "
+      "before its run is stopped as hung, zero means never", "seconds", "0");
+  QCommandLineOption latencyOption(
+      "latency",
+      "Add the percentiles of the algo's think time and the simulator's "
+      "service time per command to each row");
+  QCommandLineOption usageOption(
+      "usage",
+      "Add the CPU time and peak memory of the algo process to each row");
+  QCommandLineOption scoringOption(
+      "scoring",
+      "Comma-separated scoring policies whose scores of each run are added "
+      "as columns, e.g., \"time\"", "names");
+  QCommandLineOption injectResetsOption(
+      "inject-resets",
+      "Comma-separated triggers of resets to inject into every run, as if "
+      "the reset button were pressed: moves:N, tile:X:Y, or random:P",
+      "triggers");
+  QCommandLineOption jobsOption(
+      "jobs", "Number of algo processes to run at once, defaults to the "
+      "number of cores; for a batch, \"auto\" tunes it as runs finish",
+      "count", QString::number(QThread::idealThreadCount()));
+  QCommandLineOption algoCpusOption(
+      "algo-cpus",
+      "Cores to pin the algo processes to, one apiece, e.g., \"0-7\" for "
+      "those of one socket", "list");
+  QCommandLineOption simCpusOption(
+      "sim-cpus", "Cores to pin the simulator's thread to", "list");
+  QCommandLineOption highPriorityOption(
+      "high-priority",
+      "Raise the priority of the algo processes and the simulator's thread");
+  QCommandLineOption prestartOption(
+      "prestart",
+      "Number of algo processes to start ahead of the runs that will use "
+      "them", "count", "0");
+  QCommandLineOption lockstepBatchOption(
+      "lockstep-batch",
+      "Number of runs of a batched plugin to step at once, which --jobs "
+      "auto doesn't tune", "count",
+      QString::number(LockstepRunner::DEFAULT_BATCH_SIZE));
+  QCommandLineOption recordOption(
+      "record", "Directory to write a replay log of each run to", "path");
+  QCommandLineOption heatmapsOption(
+      "heatmaps",
+      "Directory to write the number of visits to each tile and edge of "
+      "each run to, as CSV", "path");
+  QCommandLineOption tracesOption(
+      "traces",
+      "Directory to write a trace of each run to, as CSV: a row per command, "
+      "response, and reset, with the time, pose, and stats", "path");
+  QCommandLineOption resumeOption(
+      "resume",
+      "Directory to save the state of each run in progress to, every few "
+      "seconds, and to resume the runs that were saved there from", "path");
+  QCommandLineOption benchmarkOption(
+      "benchmark",
+      "Run the microbenchmarks, with the given mazes in addition to the "
+      "bundled ones, rather than an algo");
+  QCommandLineOption benchmarkHistoryOption(
+      "benchmark-history",
+      "Compare the benchmarks to the baseline of the history file, then add "
+      "them to it, and fail if any regressed", "file");
+  QCommandLineOption benchmarkLabelOption(
+      "benchmark-label",
+      "Label of the benchmarks in the history, e.g., the commit, defaults to "
+      "the time", "label");
+  QCommandLineOption soakOption(
+      "soak",
+      "Run the mazes over and over, in a new order each time, for the given "
+      "number of seconds, writing a time series of the simulator's memory "
+      "and latency rather than rows, and fail if either drifts",
+      "seconds");
+  QCommandLineOption memoryReportOption(
+      "memory-report",
+      "Report the memory of each subsystem for the given mazes, or for a "
+      "generated maze of --size, and for a batch of --jobs runs, rather "
+      "than running an algo");
+  QCommandLineOption sharedMemoryOption(
+      "shared-memory",
+      "Communicate with the algo via shared memory, see util/mms-shm.h");
+  QCommandLineOption algoPortOption(
+      "algo-port",
+      "Wait for each run's algo to connect to the port, e.g., from another "
+      "machine, rather than starting it", "port");
+  QCommandLineOption renderOption(
+      "render",
+      "Render the frames of a replay log, rather than running an algo, to "
+      "--frames or --video", "file");
+  QCommandLineOption framesOption(
+      "frames", "Directory to write the rendered frames to, as PNGs", "path");
+  QCommandLineOption videoOption(
+      "video", "Video file to encode the rendered frames to, with ffmpeg",
+      "file");
+  QCommandLineOption fpsOption(
+      "fps", "Frames per second of virtual time to render", "fps", "30");
+  QCommandLineOption frameSizeOption(
+      "frame-size", "Size of the rendered frames", "WIDTHxHEIGHT",
+      "1280x720");
+  QCommandLineOption resultCacheOption(
+      "result-cache",
+      "Directory to cache the results of complete runs in, so that runs whose "
+      "algo, maze, and settings are unchanged are skipped", "path");
+  QCommandLineOption resultsDbOption(
+      "results-db",
+      "SQLite database to add the result of every run to, for querying "
+      "across batches", "file");
+  QCommandLineOption serveOption(
+      "serve",
+      "Hand the runs out to --worker processes that connect to the port, "
+      "rather than running them here", "port");
+  QCommandLineOption workerOption(
+      "worker",
+      "Run whatever a --serve process sends, with --jobs at once, rather than "
+      "a batch of its own", "host:port");
+  QCommandLineOption daemonOption(
+      "daemon",
+      "Keep running, and run the batches that are submitted to the port on "
+      "this machine, as lines of JSON, rather than a batch of its own",
+      "port");
+  QCommandLineOption livePortOption(
+      "live-port",
+      "Publish a run at a time to the viewers (mms --watch host:port) that "
+      "connect to the port", "port");
+  parser.addOptions({headlessOption, algoOption, tournamentOption,
+                     earlyStopOption, checkpointOption, directoryOption,
+                     buildOption, buildCommandOption, runCommandOption,
+                     pluginOption, referenceOption, baselineOption, mazesOption,
+                     corpusOption, sampleOption, packOption, archiveOption,
+                     gpuMetricsOption, generateOption,
+                     sizeOption, countOption, seedOption, runSeedOption,
+                     solveOption, scorePathsOption, envServerOption,
+                     outputOption,
+                     summaryOption, repeatOption,
+                     timeoutOption, cpuTimeoutOption, hangTimeoutOption,
+                     latencyOption, usageOption, scoringOption,
+                     injectResetsOption, jobsOption, algoCpusOption,
+                     simCpusOption, highPriorityOption, prestartOption,
+                     lockstepBatchOption,
+                     recordOption, heatmapsOption, tracesOption, resumeOption,
+                     sharedMemoryOption, algoPortOption, benchmarkOption,
+                     memoryReportOption, soakOption, benchmarkHistoryOption,
+                     benchmarkLabelOption,
+                     renderOption, framesOption, videoOption, fpsOption,
+                     frameSizeOption, resultCacheOption, resultsDbOption,
+                     serveOption, workerOption, daemonOption,
+                     livePortOption});
+  parser.process(*app);
+
+  QTextStream err(stderr);
+
+  // The benchmarks build views, which need colors, but no algo
+  if (parser.isSet(benchmarkOption)) {
+    ColorManager::init();
+    QTextStream output(stdout);
+    QString label = parser.isSet(benchmarkLabelOption)
+                        ? parser.value(benchmarkLabelOption)
+                        : QDateTime::currentDateTime().toString(Qt::ISODate);
+    return Benchmark::run(parser.positionalArguments(),
+                          parser.value(benchmarkHistoryOption), label,
+                          &output);
+  }
+
+  // Likewise for the memory report
+  if (parser.isSet(memoryReportOption)) {
+    QStringList size = parser.value(sizeOption).split('x');
+    bool widthOk = false;
+    bool heightOk = false;
+    int width = size.first().toInt(&widthOk);
+    int height = size.last().toInt(&heightOk);
+    if (size.size() != 2 || !widthOk || !heightOk || width < 1 ||
+        height < 1 || Maze::MAX_SIZE < width || Maze::MAX_SIZE < height) {
+      err << "Invalid maze size, see --help." << Qt::endl;
+      return 1;
+    }
+    bool ok = true;
+    int jobs = parser.value(jobsOption).toInt(&ok);
+    if (!ok || jobs < 1) {
+      err << "Invalid number of jobs, see --help." << Qt::endl;
+      return 1;
+    }
+    ColorManager::init();
+    QTextStream output(stdout);
+    return MemoryReport::run(parser.positionalArguments(), {width, height},
+                             jobs, &output);
+  }
+
+  // Render a replay, if requested, instead of running an algo
+  if (parser.isSet(renderOption)) {
+    QScopedPointer<ReplayLog> log(
+        ReplayLog::fromFile(parser.value(renderOption)));
+    if (log.isNull()) {
+      err << QString("Invalid replay \"%1\".").arg(parser.value(renderOption))
+          << Qt::endl;
+      return 1;
+    }
+    if (parser.isSet(framesOption) == parser.isSet(videoOption)) {
+      err << "Exactly one of --frames and --video is required, see --help."
+          << Qt::endl;
+      return 1;
+    }
+    bool ok = true;
+    double fps = parser.value(fpsOption).toDouble(&ok);
+    if (!ok || fps <= 0.0) {
+      err << "Invalid frame rate, see --help." << Qt::endl;
+      return 1;
+    }
+    QStringList size = parser.value(frameSizeOption).split('x');
+    bool widthOk = false;
+    bool heightOk = false;
+    int width = size.first().toInt(&widthOk);
+    int height = size.last().toInt(&heightOk);
+    if (size.size() != 2 || !widthOk || !heightOk || width < 1 ||
+        height < 1) {
+      err << "Invalid frame size, see --help." << Qt::endl;
+      return 1;
+    }
+    ColorManager::init();
+    FrameExporter exporter(log.data(), QSize(width, height), fps,
+                           parser.value(framesOption),
+                           parser.value(videoOption));
+    QString error;
+    if (!exporter.start(&error)) {
+      err << QString("Could not render: %1").arg(error) << Qt::endl;
+      return 1;
+    }
+    QObject::connect(&exporter, &FrameExporter::finished, app.data(),
+                     &QCoreApplication::exit);
+    int exitCode = app->exec();
+    Profiler::finish();
+    return exitCode;
+  }
+
+  // Compute the grid metrics of packed mazes on the GPU, if requested
+  QScopedPointer<GpuMazeMetrics> gpuMetrics;
+  if (parser.isSet(gpuMetricsOption)) {
+    if (!parser.isSet(packOption)) {
+      err << "GPU metrics are computed for --pack, see --help." << Qt::endl;
+      return 1;
+    }
+    gpuMetrics.reset(new GpuMazeMetrics());
+    QString error;
+    if (!gpuMetrics->initialize(&error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  }
+
+  // Generate mazes, if requested, instead of running any
+  if (parser.isSet(generateOption)) {
+    QString name = parser.value(generateOption);
+    if (!STRING_TO_MAZE_ALGORITHM().contains(name)) {
+      err << QString("Unknown maze algorithm \"%1\".").arg(name) << Qt::endl;
+      return 1;
+    }
+    QStringList size = parser.value(sizeOption).split('x');
+    bool widthOk = false;
+    bool heightOk = false;
+    int width = size.first().toInt(&widthOk);
+    int height = size.last().toInt(&heightOk);
+    if (size.size() != 2 || !widthOk || !heightOk || width < 1 ||
+        height < 1 || Maze::MAX_SIZE < width || Maze::MAX_SIZE < height) {
+      err << "Invalid maze size, see --help." << Qt::endl;
+      return 1;
+    }
+    bool ok = true;
+    int count = parser.value(countOption).toInt(&ok);
+    if (!ok || count < 1) {
+      err << "Invalid number of mazes, see --help." << Qt::endl;
+      return 1;
+    }
+    quint32 seed = QRandomGenerator::global()->generate();
+    if (parser.isSet(seedOption)) {
+      seed = parser.value(seedOption).toUInt(&ok);
+      if (!ok) {
+        err << "Invalid seed, see --help." << Qt::endl;
+        return 1;
+      }
+    }
+    if (!parser.isSet(packOption)) {
+      err << "Generated mazes are written to --pack, see --help." << Qt::endl;
+      return 1;
+    }
+    QVector<QByteArray> mazes =
+        MazeGenerator::generate(STRING_TO_MAZE_ALGORITHM().value(name), width,
+                                height, count, seed);
+    if (!MazeCorpus::write(parser.value(packOption), mazes,
+                           gpuMetrics.data())) {
+      err << QString("Could not write \"%1\".").arg(parser.value(packOption))
+          << Qt::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // Pack the mazes of an archive, if requested, as they're streamed out of it
+  if (parser.isSet(archiveOption)) {
+    if (!parser.isSet(packOption)) {
+      err << "Archived mazes are packed with --pack, see --help." << Qt::endl;
+      return 1;
+    }
+    MazeArchive::Contents contents;
+    QString error;
+    if (!MazeArchive::read(parser.value(archiveOption), &contents, &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+    if (0 < contents.numInvalid) {
+      err << QString("Skipped %1 entries that aren't valid mazes.")
+                 .arg(contents.numInvalid)
+          << Qt::endl;
+    }
+    if (0 < contents.numDuplicates) {
+      err << QString("Skipped %1 copies of other mazes.")
+                 .arg(contents.numDuplicates)
+          << Qt::endl;
+    }
+    if (contents.mazes.isEmpty()) {
+      err << "None of the mazes are valid." << Qt::endl;
+      return 1;
+    }
+    if (!MazeCorpus::write(parser.value(packOption), contents.mazes,
+                           gpuMetrics.data())) {
+      err << QString("Could not write \"%1\".").arg(parser.value(packOption))
+          << Qt::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // Pin the simulator where its latency won't be disturbed, and determine
+  // where the algos go
+  QVector<int> algoCores;
+  if (parser.isSet(algoCpusOption) &&
+      !ProcessUtilities::parseCores(parser.value(algoCpusOption),
+                                    &algoCores)) {
+    err << "Invalid algo cores, see --help." << Qt::endl;
+    return 1;
+  }
+  if (parser.isSet(simCpusOption)) {
+    QVector<int> simCores;
+    if (!ProcessUtilities::parseCores(parser.value(simCpusOption),
+                                      &simCores)) {
+      err << "Invalid simulator cores, see --help." << Qt::endl;
+      return 1;
+    }
+    if (!ProcessUtilities::setAffinity(0, simCores)) {
+      err << "Could not pin the simulator to its cores." << Qt::endl;
+      return 1;
+    }
+  }
+  bool isPriorityRaised = parser.isSet(highPriorityOption);
+  if (isPriorityRaised && !ProcessUtilities::raisePriority(0)) {
+    err << "Could not raise the simulator's priority, continuing without."
+        << Qt::endl;
+  }
+
+  // Run the batches that are submitted, if requested; the mazes and algos
+  // are in the jobs
+  if (parser.isSet(daemonOption)) {
+    bool ok = false;
+    uint port = parser.value(daemonOption).toUInt(&ok);
+    if (!ok || port < 1 || 0xffff < port) {
+      err << "Invalid daemon port, see --help." << Qt::endl;
+      return 1;
+    }
+    Daemon daemon;
+    QString error;
+    if (!daemon.listen(port, &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+    int exitCode = app->exec();
+    Profiler::finish();
+    return exitCode;
+  }
+
+  // The live feed's views need colors, like the benchmarks
+  uint livePort = 0;
+  if (parser.isSet(livePortOption)) {
+    bool ok = false;
+    livePort = parser.value(livePortOption).toUInt(&ok);
+    if (!ok || livePort < 1 || 0xffff < livePort) {
+      err << "Invalid live port, see --help." << Qt::endl;
+      return 1;
+    }
+    ColorManager::init();
+  }
+
+  // Work for a coordinator, if requested; the mazes and algos are in the jobs
+  if (parser.isSet(workerOption)) {
+    QString address = parser.value(workerOption);
+    int colon = address.lastIndexOf(':');
+    bool ok = false;
+    uint port = address.mid(colon + 1).toUInt(&ok);
+    if (colon < 1 || !ok || port < 1 || 0xffff < port) {
+      err << "Invalid coordinator address, see --help." << Qt::endl;
+      return 1;
+    }
+    int maxJobs = parser.value(jobsOption).toInt(&ok);
+    if (!ok || maxJobs < 1) {
+      err << "Invalid number of jobs, see --help." << Qt::endl;
+      return 1;
+    }
+    QTextStream output(stdout);
+    BatchRunner runner(QStringList(), QString(), QString(), 0.0, maxJobs,
+                       parser.isSet(sharedMemoryOption), nullptr, QString(),
+                       &output);
+    runner.setAlgoPlacement(algoCores, isPriorityRaised);
+    QString error;
+    if (0 < livePort && !runner.setLiveFeed(livePort, &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+    if (!runner.work(address.left(colon), port, &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+    QObject::connect(&runner, &BatchRunner::finished, app.data(),
+                     &QCoreApplication::exit);
+    int exitCode = app->exec();
+    Profiler::finish();
+    return exitCode;
+  }
+
+  // Determine the mazes
+  QStringList mazeFiles = parser.positionalArguments();
+  if (parser.isSet(mazesOption)) {
+    QFile file(parser.value(mazesOption));
+    if (!file.open(QFile::ReadOnly)) {
+      err << QString("Could not open \"%1\".").arg(file.fileName())
+          << Qt::endl;
+      return 1;
+    }
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+      line = line.trimmed();
+      if (!line.isEmpty()) {
+        mazeFiles.append(line);
+      }
+    }
+  }
+  if (parser.isSet(corpusOption)) {
+    QString path = parser.value(corpusOption);
+    int size = MazeCorpus::getSize(path);
+    if (size < 0) {
+      err << QString("Could not open corpus \"%1\".").arg(path) << Qt::endl;
+      return 1;
+    }
+    for (int i = 0; i < size; i += 1) {
+      mazeFiles.append(MazeCorpus::getEntryPath(path, i));
+    }
+  }
+  if (mazeFiles.isEmpty()) {
+    err << "No maze files given, see --help." << Qt::endl;
+    return 1;
+  }
+  bool isRunSeedValid = false;
+  quint32 runSeed = parser.value(runSeedOption).toUInt(&isRunSeedValid);
+  if (!isRunSeedValid) {
+    err << "Invalid run seed, see --help." << Qt::endl;
+    return 1;
+  }
+  if (parser.isSet(sampleOption)) {
+    bool ok = false;
+    int count = parser.value(sampleOption).toInt(&ok);
+    if (!ok || count <= 0) {
+      err << "Invalid sample size, see --help." << Qt::endl;
+      return 1;
+    }
+    mazeFiles = MazeSampler::sample(mazeFiles, count, runSeed);
+    if (mazeFiles.isEmpty()) {
+      err << "None of the mazes are valid." << Qt::endl;
+      return 1;
+    }
+  }
+
+  // Pack the mazes, if requested, instead of running them; copies of a maze,
+  // even rotated or mirrored ones, are only packed once
+  if (parser.isSet(packOption)) {
+    QVector<QByteArray> mazes;
+    QSet<QByteArray> hashes;
+    int numDuplicates = 0;
+    for (const QString &mazeFile : mazeFiles) {
+      Maze *maze = Maze::fromFile(mazeFile);
+      if (maze == nullptr) {
+        err << QString("Invalid maze \"%1\".").arg(mazeFile) << Qt::endl;
+        return 1;
+      }
+      QByteArray hash = maze->getCanonicalHash();
+      if (hashes.contains(hash)) {
+        numDuplicates += 1;
+      } else {
+        hashes.insert(hash);
+        mazes.append(maze->toBinary());
+      }
+      delete maze;
+    }
+    if (0 < numDuplicates) {
+      err << QString("Skipped %1 copies of other mazes.").arg(numDuplicates)
+          << Qt::endl;
+    }
+    if (!MazeCorpus::write(parser.value(packOption), mazes,
+                           gpuMetrics.data())) {
+      err << QString("Could not write \"%1\".").arg(parser.value(packOption))
+          << Qt::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // Determine the output
+  QFile outputFile;
+  if (parser.isSet(outputOption)) {
+    outputFile.setFileName(parser.value(outputOption));
+    if (!outputFile.open(QFile::WriteOnly | QFile::Truncate)) {
+      err << QString("Could not open \"%1\".").arg(outputFile.fileName())
+          << Qt::endl;
+      return 1;
+    }
+  } else {
+    outputFile.open(stdout, QFile::WriteOnly);
+  }
+  QTextStream output(&outputFile);
+
+  // Solve the mazes, if requested, instead of running an algo
+  if (parser.isSet(solveOption)) {
+    QStringList rows = QtConcurrent::blockingMapped(
+        mazeFiles, [](const QString &mazeFile) {
+          QStringList fields = {BatchRunner::toCsvField(mazeFile)};
+          Maze *maze = Maze::fromFile(mazeFile);
+          if (maze == nullptr) {
+            fields.append({"", "", ""});
+          } else {
+            MazeSolver::Solution solution = MazeSolver::solve(maze);
+            fields.append(QString::number(solution.cost));
+            fields.append(MazeSolver::toCommands(solution.moves).join(";"));
+            fields.append(solution.isSolved
+                              ? QString::number(
+                                    MazeSolver::getSeconds(solution.moves))
+                              : "");
+            delete maze;
+          }
+          return fields.join(",");
+        });
+    output << "maze,optimal-cost,moves,seconds" << Qt::endl;
+    for (const QString &row : rows) {
+      output << row << Qt::endl;
+    }
+    return 0;
+  }
+
+  // Score the paths instead, if requested; they're parsed once, and each
+  // maze's wall tables are built once and shared by the threads scoring them
+  if (parser.isSet(scorePathsOption)) {
+    QFile file(parser.value(scorePathsOption));
+    if (!file.open(QFile::ReadOnly)) {
+      err << QString("Could not open \"%1\".").arg(file.fileName())
+          << Qt::endl;
+      return 1;
+    }
+    QVector<QVector<MazeSolver::Move>> paths;
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+      QVector<MazeSolver::Move> steps;
+      if (!PathScorer::parse(line.trimmed(), &steps)) {
+        err << QString("Invalid path on line %1.").arg(paths.size() + 1)
+            << Qt::endl;
+        return 1;
+      }
+      paths.append(steps);
+    }
+    output << "maze,path,crash-step,finished,progress,seconds" << Qt::endl;
+    for (const QString &mazeFile : mazeFiles) {
+      Maze *maze = Maze::fromFile(mazeFile);
+      if (maze == nullptr) {
+        err << QString("Invalid maze \"%1\".").arg(mazeFile) << Qt::endl;
+        return 1;
+      }
+      QVector<PathScorer::Score> scores = PathScorer(maze).scoreAll(paths);
+      delete maze;
+      for (int i = 0; i < scores.size(); i += 1) {
+        const PathScorer::Score &score = scores.at(i);
+        output << QStringList({BatchRunner::toCsvField(mazeFile),
+                               QString::number(i),
+                               QString::number(score.crashStep),
+                               score.isFinished ? "1" : "0",
+                               QString::number(score.progress),
+                               QString::number(score.seconds)})
+                      .join(",")
+               << Qt::endl;
+      }
+    }
+    return 0;
+  }
+
+  // Serve an env to a client, if requested; it steps the mazes itself
+  if (parser.isSet(envServerOption)) {
+    return EnvServer::run(parser.value(envServerOption), mazeFiles, &err);
+  }
+
+  // Determine the algos of a tournament, or else the algo
+  QVector<BatchRunner::Algo> algos;
+  if (parser.isSet(tournamentOption)) {
+    QStringList names = parser.values(algoOption);
+    if (names.isEmpty()) {
+      names = SettingsMouseAlgos::names();
+    }
+    for (const QString &name : names) {
+      if (!SettingsMouseAlgos::names().contains(name)) {
+        err << QString("Unknown mouse algo \"%1\".").arg(name) << Qt::endl;
+        return 1;
+      }
+      algos.append({name, SettingsMouseAlgos::getDirectory(name),
+                    SettingsMouseAlgos::getRunCommand(name)});
+    }
+    if (algos.isEmpty() || parser.isSet(pluginOption) ||
+        parser.isSet(referenceOption)) {
+      err << "A tournament needs configured algos, and no plugin, see --help."
+          << Qt::endl;
+      return 1;
+    }
+  }
+  QString directory;
+  QString buildCommand;
+  QString runCommand;
+  if (algos.isEmpty() && parser.isSet(algoOption)) {
+    QString name = parser.value(algoOption);
+    if (!SettingsMouseAlgos::names().contains(name)) {
+      err << QString("Unknown mouse algo \"%1\".").arg(name) << Qt::endl;
+      return 1;
+    }
+    directory = SettingsMouseAlgos::getDirectory(name);
+    buildCommand = SettingsMouseAlgos::getBuildCommand(name);
+    runCommand = SettingsMouseAlgos::getRunCommand(name);
+  }
+  if (parser.isSet(directoryOption)) {
+    directory = parser.value(directoryOption);
+  }
+  if (parser.isSet(buildCommandOption)) {
+    buildCommand = parser.value(buildCommandOption);
+  }
+  if (parser.isSet(runCommandOption)) {
+    runCommand = parser.value(runCommandOption);
+  }
+  QScopedPointer<PluginAlgo> plugin;
+  if (parser.isSet(pluginOption)) {
+    QString error;
+    plugin.reset(PluginAlgo::load(parser.value(pluginOption), &error));
+    if (plugin.isNull()) {
+      err << QString("Could not load plugin: %1").arg(error) << Qt::endl;
+      return 1;
+    }
+  } else if (parser.isSet(referenceOption)) {
+    QString error;
+    plugin.reset(
+        PluginAlgo::getReference(parser.value(referenceOption), &error));
+    if (plugin.isNull()) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  } else if (algos.isEmpty() && !parser.isSet(algoPortOption) &&
+             (directory.isEmpty() || runCommand.isEmpty())) {
+    err << "A directory and run command are required, see --help."
+        << Qt::endl;
+    return 1;
+  }
+  // A batched plugin's runs are only counted, see LockstepBatch
+  if (!plugin.isNull() && plugin->isBatched() &&
+      (parser.isSet(recordOption) || parser.isSet(heatmapsOption) ||
+       parser.isSet(tracesOption) ||
+       parser.isSet(latencyOption) || parser.isSet(usageOption) ||
+       parser.isSet(scoringOption) || parser.isSet(injectResetsOption) ||
+       parser.isSet(baselineOption) || parser.isSet(summaryOption) ||
+       parser.isSet(checkpointOption) || parser.isSet(resultsDbOption))) {
+    err << "A batched plugin can't be combined with --record, --heatmaps, "
+           "--traces, --latency, --usage, --scoring, --inject-resets, "
+           "--baseline, --summary, --checkpoint, or --results-db."
+        << Qt::endl;
+    return 1;
+  }
+  ResetInjection resetInjection;
+  if (parser.isSet(injectResetsOption)) {
+    QString error;
+    if (!ResetInjection::fromSpec(parser.value(injectResetsOption),
+                                  &resetInjection, &error)) {
+      err << error << "." << Qt::endl;
+      return 1;
+    }
+  }
+  QStringList scoringPolicies;
+  if (parser.isSet(scoringOption)) {
+    scoringPolicies = parser.value(scoringOption).split(',');
+    for (const QString &policy : scoringPolicies) {
+      if (!STRING_TO_SCORING().contains(policy)) {
+        err << "Unknown scoring policy: " << policy << "." << Qt::endl;
+        return 1;
+      }
+    }
+  }
+  QScopedPointer<PluginAlgo> baseline;
+  if (parser.isSet(baselineOption)) {
+    QString error;
+    baseline.reset(
+        PluginAlgo::getReference(parser.value(baselineOption), &error));
+    if (baseline.isNull()) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  }
+
+  // Determine the timeouts
+  bool ok = true;
+  double timeoutSeconds = parser.value(timeoutOption).toDouble(&ok);
+  if (!ok) {
+    err << "Invalid timeout, see --help." << Qt::endl;
+    return 1;
+  }
+  double hangTimeoutSeconds = parser.value(hangTimeoutOption).toDouble(&ok);
+  if (!ok || hangTimeoutSeconds < 0.0) {
+    err << "Invalid hang timeout, see --help." << Qt::endl;
+    return 1;
+  }
+
+  // Determine the number of concurrent runs, or the most that tuning allows
+  bool isJobTuned = parser.value(jobsOption) == "auto";
+  int maxJobs = isJobTuned
+                    ? JobTuner::MAX_JOBS_PER_CORE * QThread::idealThreadCount()
+                    : parser.value(jobsOption).toInt(&ok);
+  if (!ok || maxJobs < 1) {
+    err << "Invalid number of jobs, see --help." << Qt::endl;
+    return 1;
+  }
+
+  // Only the batch's runs are tuned, so builds and soaks run one per core
+  int fixedJobs = isJobTuned ? QThread::idealThreadCount() : maxJobs;
+
+  // Determine the number of runs of each maze
+  int repeats = parser.value(repeatOption).toInt(&ok);
+  if (!ok || repeats < 1) {
+    err << "Invalid number of repeats, see --help." << Qt::endl;
+    return 1;
+  }
+
+  // Determine the number of spare algo processes
+  int numSpares = parser.value(prestartOption).toInt(&ok);
+  if (!ok || numSpares < 0) {
+    err << "Invalid number of processes to prestart, see --help." << Qt::endl;
+    return 1;
+  }
+
+  // Make sure that replays can be recorded
+  if (parser.isSet(recordOption) &&
+      !QDir().mkpath(parser.value(recordOption))) {
+    err << QString("Could not create \"%1\".").arg(parser.value(recordOption))
+        << Qt::endl;
+    return 1;
+  }
+
+  // Likewise for the heatmaps
+  if (parser.isSet(heatmapsOption) &&
+      !QDir().mkpath(parser.value(heatmapsOption))) {
+    err << QString("Could not create \"%1\".").arg(parser.value(heatmapsOption))
+        << Qt::endl;
+    return 1;
+  }
+  if (parser.isSet(tracesOption) &&
+      !QDir().mkpath(parser.value(tracesOption))) {
+    err << QString("Could not create \"%1\".").arg(parser.value(tracesOption))
+        << Qt::endl;
+    return 1;
+  }
+
+  // Plugins are run in-process, so there's no directory to hash
+  if (parser.isSet(resultCacheOption) && !plugin.isNull()) {
+    err << "A result cache can't be combined with --plugin." << Qt::endl;
+    return 1;
+  }
+
+  // Plugins can't be restarted part way through a run
+  if (parser.isSet(resumeOption) && !plugin.isNull()) {
+    err << "--resume can't be combined with --plugin." << Qt::endl;
+    return 1;
+  }
+  if (parser.isSet(resumeOption) &&
+      !QDir().mkpath(parser.value(resumeOption))) {
+    err << QString("Could not create \"%1\".").arg(parser.value(resumeOption))
+        << Qt::endl;
+    return 1;
+  }
+
+  // Determine the port to serve the runs on
+  uint port = 0;
+  if (parser.isSet(serveOption)) {
+    port = parser.value(serveOption).toUInt(&ok);
+    if (!ok || port < 1 || 0xffff < port || !plugin.isNull()) {
+      err << "Invalid port, or a plugin, which can't be served, see --help."
+          << Qt::endl;
+      return 1;
+    }
+  }
+
+  // Determine the port to accept algos on, which are then whatever connects,
+  // so there's nothing to start ahead of time, or to hash
+  uint algoPort = 0;
+  if (parser.isSet(algoPortOption)) {
+    algoPort = parser.value(algoPortOption).toUInt(&ok);
+    if (!ok || algoPort < 1 || 0xffff < algoPort || !plugin.isNull() ||
+        parser.isSet(sharedMemoryOption) || !algos.isEmpty() ||
+        0 < numSpares || parser.isSet(resultCacheOption) ||
+        parser.isSet(serveOption)) {
+      err << "Invalid algo port, or an option that needs the algo to be "
+             "started here, see --help."
+          << Qt::endl;
+      return 1;
+    }
+  }
+
+  // The mazes are shuffled by the run seed, so that the comparison doesn't
+  // depend on how the corpus happens to be sorted, e.g., by size
+  QScopedPointer<SequentialTest> sequentialTest;
+  if (parser.isSet(earlyStopOption)) {
+    bool ok = false;
+    double confidence = parser.value(earlyStopOption).toDouble(&ok);
+    if (!ok || confidence <= 0.5 || 1.0 <= confidence ||
+        algos.size() != 2 || parser.isSet(checkpointOption)) {
+      err << "Early stopping needs a confidence between 0.5 and 1, a "
+             "tournament of two algos, and no checkpoint, see --help."
+          << Qt::endl;
+      return 1;
+    }
+    sequentialTest.reset(new SequentialTest(confidence));
+    QRandomGenerator generator(runSeed);
+    std::shuffle(mazeFiles.begin(), mazeFiles.end(), generator);
+  }
+
+  // Skipped runs have no stats to summarize
+  if (parser.isSet(checkpointOption) && parser.isSet(summaryOption)) {
+    err << "A checkpoint can't be combined with --summary." << Qt::endl;
+    return 1;
+  }
+
+  QFile summaryFile;
+  if (parser.isSet(summaryOption)) {
+    summaryFile.setFileName(parser.value(summaryOption));
+    if (!summaryFile.open(QFile::WriteOnly | QFile::Truncate)) {
+      err << QString("Could not open \"%1\".").arg(summaryFile.fileName())
+          << Qt::endl;
+      return 1;
+    }
+  }
+  QTextStream summary(&summaryFile);
+
+  // A batched plugin steps all of its mice at once, so there's no batch
+  if (!plugin.isNull() && plugin->isBatched()) {
+    int batchSize = parser.value(lockstepBatchOption).toInt(&ok);
+    if (!ok || batchSize < 1) {
+      err << "Invalid lockstep batch size, see --help." << Qt::endl;
+      return 1;
+    }
+    return LockstepRunner::run(mazeFiles, repeats, plugin.data(),
+                               timeoutSeconds, batchSize, &output);
+  }
+
+  // Build the algos, if requested, before any of them are run
+  if (parser.isSet(buildOption) && plugin.isNull()) {
+    QVector<AlgoBuilder::Target> targets;
+    for (const BatchRunner::Algo &algo : algos) {
+      targets.append({algo.name, algo.directory,
+                      SettingsMouseAlgos::getBuildCommand(algo.name)});
+    }
+    if (algos.isEmpty()) {
+      QString name = parser.isSet(algoOption) ? parser.value(algoOption)
+                                              : directory;
+      targets.append({name, directory, buildCommand});
+    }
+    AlgoBuilder builder(targets, fixedJobs, &err);
+    QObject::connect(&builder, &AlgoBuilder::finished, app.data(),
+                     &QCoreApplication::exit);
+    builder.start();
+    if (app->exec() != 0) {
+      err << "Not every algo could be built." << Qt::endl;
+      return 1;
+    }
+  }
+
+  // Soak, if requested, rather than running the batch just once
+  if (parser.isSet(soakOption)) {
+    double soakSeconds = parser.value(soakOption).toDouble(&ok);
+    if (!ok || soakSeconds <= 0.0 || !plugin.isNull() || !algos.isEmpty() ||
+        parser.isSet(serveOption) || parser.isSet(algoPortOption)) {
+      err << "Invalid soak duration, or an option that doesn't soak, see "
+             "--help."
+          << Qt::endl;
+      return 1;
+    }
+    SoakTest soak(mazeFiles, directory, runCommand, timeoutSeconds,
+                  fixedJobs, parser.isSet(sharedMemoryOption), soakSeconds,
+                  &output);
+    QObject::connect(&soak, &SoakTest::finished, app.data(),
+                     &QCoreApplication::exit);
+    soak.start();
+    int exitCode = app->exec();
+    Profiler::finish();
+    return exitCode;
+  }
+
+  // Run the batch, then quit
+  BatchRunner runner(mazeFiles, directory, runCommand, timeoutSeconds, maxJobs,
+                     parser.isSet(sharedMemoryOption), plugin.data(),
+                     parser.value(recordOption), &output);
+  runner.setRepeats(repeats);
+  runner.setHangTimeout(hangTimeoutSeconds);
+  runner.setCpuTimeout(parser.isSet(cpuTimeoutOption));
+  runner.setLatencyColumns(parser.isSet(latencyOption));
+  runner.setUsageColumns(parser.isSet(usageOption));
+  runner.setJobTuning(isJobTuned);
+  runner.setScoringColumns(scoringPolicies);
+  runner.setResetInjection(resetInjection);
+  runner.setSeed(runSeed);
+  runner.setAlgoPlacement(algoCores, isPriorityRaised);
+  runner.setHeatmapDirectory(parser.value(heatmapsOption));
+  runner.setTraceDirectory(parser.value(tracesOption));
+  if (parser.isSet(resumeOption)) {
+    runner.setResumeDirectory(parser.value(resumeOption));
+  }
+  if (!baseline.isNull()) {
+    runner.setBaseline(baseline.data(), parser.value(baselineOption));
+  }
+  runner.setSpareAlgos(numSpares);
+  if (!algos.isEmpty()) {
+    runner.setTournament(algos);
+  }
+  if (parser.isSet(resultCacheOption)) {
+    runner.setResultCache(parser.value(resultCacheOption));
+  }
+  if (parser.isSet(checkpointOption)) {
+    QString error;
+    if (!runner.setCheckpoint(parser.value(checkpointOption), &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  }
+  if (parser.isSet(resultsDbOption)) {
+    QString error;
+    if (!runner.setResultsDatabase(parser.value(resultsDbOption), &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  }
+  if (!sequentialTest.isNull()) {
+    runner.setSequentialTest(sequentialTest.data());
+  }
+  if (summaryFile.isOpen()) {
+    runner.setSummary(&summary, summaryFile.fileName().endsWith(
+                                    ".json", Qt::CaseInsensitive));
+  }
+  if (0 < livePort) {
+    QString error;
+    if (!runner.setLiveFeed(livePort, &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  }
+  QObject::connect(&runner, &BatchRunner::finished, app.data(),
+                   &QCoreApplication::exit);
+  if (parser.isSet(serveOption)) {
+    QString error;
+    if (!runner.serve(port, &error)) {
+      err << error << Qt::endl;
+      return 1;
+    }
+  } else {
+    if (parser.isSet(algoPortOption)) {
+      QString error;
+      if (!runner.listenForAlgos(algoPort, &error)) {
+        err << error << Qt::endl;
+        return 1;
+      }
+    }
+    runner.start();
+  }
+
+  // Start the event loop
+  int exitCode = app->exec();
+  Profiler::finish();
+  if (!sequentialTest.isNull()) {
+    err << QString("%1 vs. %2: %3")
+               .arg(algos.at(0).name, algos.at(1).name,
+                    sequentialTest->getDescription())
+        << Qt::endl;
+  }
+  return exitCode;
 }
 
 }  // namespace mms
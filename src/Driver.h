@@ -6,6 +6,10 @@ class Driver {
  public:
   Driver() = delete;
   static int drive(int argc, char *argv[]);
+
+ private:
+  // Runs an algo against a batch of mazes, without a GUI
+  static int driveHeadless(int argc, char *argv[]);
 };
 
 }  // namespace mms
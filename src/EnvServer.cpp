@@ -0,0 +1,119 @@
+#include "EnvServer.h"
+
+#include <QFile>
+#include <QThread>
+#include <QVector>
+
+#include "Maze.h"
+#include "VectorEnv.h"
+
+namespace mms {
+
+// Layout (all integers are little-endian and 32 bits):
+//   [0, 64)   magic, count, max steps, command, request, response, mazes
+//   [64, ...) arrays of count entries each: actions, then the observations in
+//             the order of VectorEnv::Observations (the rewards are floats)
+// The client writes the header, then the magic last, before it starts the
+// server; after that, it writes the actions and the command, then bumps the
+// request, and the server handles the command and sets the response to the
+// request, so each side reads the other's arrays only while it's waiting.
+const quint32 EnvServer::MAGIC = 0x45534d4d;  // "MMSE"
+const int EnvServer::HEADER_SIZE = 64;
+const int EnvServer::NUM_ARRAYS = 8;
+const int EnvServer::MAX_BUSY_POLLS = 1000;
+
+int EnvServer::run(const QString &path, const QStringList &mazeFiles,
+                   QTextStream *err) {
+  QFile file(path);
+  if (!file.open(QFile::ReadWrite) || file.size() < HEADER_SIZE) {
+    *err << QString("Could not open \"%1\".").arg(path) << Qt::endl;
+    return 1;
+  }
+  uchar *memory = file.map(0, file.size());
+  if (memory == nullptr ||
+      atomicAt(memory, 0)->load(std::memory_order_acquire) != MAGIC) {
+    *err << QString("Invalid env file \"%1\".").arg(path) << Qt::endl;
+    return 1;
+  }
+  int count = static_cast<int>(atomicAt(memory, 4)->load());
+  int maxSteps = static_cast<int>(atomicAt(memory, 8)->load());
+  if (count <= 0 || maxSteps <= 0 ||
+      file.size() < HEADER_SIZE + NUM_ARRAYS * 4 * static_cast<qint64>(count)) {
+    *err << QString("Invalid env file \"%1\".").arg(path) << Qt::endl;
+    return 1;
+  }
+
+  // Each maze is loaded once, and only its tables are kept (see VectorEnv)
+  QVector<Maze *> loaded;
+  for (const QString &mazeFile : mazeFiles) {
+    Maze *maze = Maze::fromFile(mazeFile);
+    if (maze == nullptr) {
+      *err << QString("Invalid maze \"%1\".").arg(mazeFile) << Qt::endl;
+      qDeleteAll(loaded);
+      return 1;
+    }
+    loaded.append(maze);
+  }
+  QVector<const Maze *> mazes;
+  for (int i = 0; i < count; i += 1) {
+    mazes.append(loaded.at(i % loaded.size()));
+  }
+  VectorEnv env(mazes, maxSteps);
+  qDeleteAll(loaded);
+  atomicAt(memory, 24)->store(mazeFiles.size(), std::memory_order_relaxed);
+
+  auto array = [=](int index) {
+    return memory + HEADER_SIZE + 4 * count * index;
+  };
+  const int *actions = reinterpret_cast<const int *>(array(0));
+  VectorEnv::Observations observations = {
+      reinterpret_cast<int *>(array(1)),   reinterpret_cast<int *>(array(2)),
+      reinterpret_cast<int *>(array(3)),   reinterpret_cast<int *>(array(4)),
+      reinterpret_cast<float *>(array(5)), reinterpret_cast<int *>(array(6)),
+      reinterpret_cast<int *>(array(7)),
+  };
+
+  // As with the shared-memory transport, cross-process wakeups aren't
+  // portable, so poll for requests: eagerly while the client is stepping,
+  // then backing off once it goes quiet, e.g., while it trains
+  std::atomic<quint32> *request = atomicAt(memory, 16);
+  std::atomic<quint32> *response = atomicAt(memory, 20);
+  quint32 handled = response->load(std::memory_order_relaxed);
+  int idlePolls = 0;
+  while (true) {
+    quint32 next = request->load(std::memory_order_acquire);
+    if (next == handled) {
+      if (idlePolls < MAX_BUSY_POLLS) {
+        idlePolls += 1;
+        QThread::yieldCurrentThread();
+      } else {
+        QThread::msleep(1);
+      }
+      continue;
+    }
+    idlePolls = 0;
+    Command command = static_cast<Command>(atomicAt(memory, 12)->load());
+    if (command == Command::RESET) {
+      env.reset(observations);
+    } else if (command == Command::STEP) {
+      env.step(actions, observations);
+    }
+    handled = next;
+    response->store(handled, std::memory_order_release);
+    if (command != Command::RESET && command != Command::STEP) {
+      break;
+    }
+  }
+  file.unmap(memory);
+  return 0;
+}
+
+std::atomic<quint32> *EnvServer::atomicAt(uchar *memory, int offset) {
+  // The client's atomics are plain aligned words, as for the shared-memory
+  // transport's, which requires the atomics to be lock-free
+  static_assert(ATOMIC_INT_LOCK_FREE == 2,
+                "shared memory requires lock-free atomics");
+  return reinterpret_cast<std::atomic<quint32> *>(memory + offset);
+}
+
+}  // namespace mms
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <atomic>
+
+namespace mms {
+
+// Serves a VectorEnv to another process, e.g., a training script, through a
+// memory-mapped file that the client creates (see util/mms_env.py). The
+// client writes its actions into the file and bumps a counter, and the
+// server steps every episode and writes their observations back, so that a
+// call costs two cache-line handoffs however many episodes there are,
+// rather than a line of text per command, as with an algo.
+class EnvServer {
+ public:
+  // The EnvServer class is not constructible
+  EnvServer() = delete;
+
+  // Episode i is run on the (i modulo the number of mazes)th maze; returns
+  // once the client closes the env, or a nonzero exit code on failure
+  static int run(const QString &path, const QStringList &mazeFiles,
+                 QTextStream *err);
+
+ private:
+  // The layout is shared with the client, so it must never change
+  static const quint32 MAGIC;
+  static const int HEADER_SIZE;
+  static const int NUM_ARRAYS;
+  static const int MAX_BUSY_POLLS;
+
+  enum class Command {
+    RESET,
+    STEP,
+    CLOSE,
+  };
+
+  static std::atomic<quint32> *atomicAt(uchar *memory, int offset);
+};
+
+}  // namespace mms
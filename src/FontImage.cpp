@@ -1,7 +1,21 @@
 #include "FontImage.h"
 
+#include <QColor>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QtMath>
+
+#include "Profiler.h"
+
 namespace mms {
 
+const int FontImage::DISTANCE_FIELD_SPREAD = 3;
+
 QString FontImage::path() { return ":/resources/fonts/Unispace-Bold.png"; }
 
 QString FontImage::characters() {
@@ -13,19 +27,83 @@ QString FontImage::characters() {
       "`abcdefghijklmnopqrstuvwxyz{|}~");
 }
 
-QMap<QChar, QPair<double, double>> FontImage::positions() {
-  static QMap<QChar, QPair<double, double>> map;
-  if (map.isEmpty()) {
-    // Map from char to fractional position in the image (from 0.0 to 1.0)
-    QString chars = characters();
-    int size = chars.size();
-    for (int i = 0; i < size; i += 1) {
-      double start = static_cast<double>(i) / static_cast<double>(size);
-      double end = static_cast<double>(i + 1) / static_cast<double>(size);
-      map.insert(chars.at(i), {start, end});
+QImage FontImage::loadDistanceField() {
+  PROFILE_SCOPE("FontImage::loadDistanceField");
+  QString path = getCachePath();
+  if (!path.isEmpty()) {
+    QImage cached(path);
+    if (!cached.isNull()) {
+      return cached.convertToFormat(QImage::Format_ARGB32);
+    }
+  }
+  QImage image = computeDistanceField();
+  if (!image.isNull() && !path.isEmpty() &&
+      QDir().mkpath(QFileInfo(path).path())) {
+    // Written under a temporary name and then renamed, as with thumbnails
+    // (see MazeThumbnail), so that a partial field is never read
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG")) {
+      file.commit();
+    }
+  }
+  return image;
+}
+
+QImage FontImage::computeDistanceField() {
+  QImage image =
+      QImage(path()).mirrored().convertToFormat(QImage::Format_ARGB32);
+  if (image.isNull()) {
+    return image;
+  }
+  int width = image.width();
+  int height = image.height();
+  QVector<bool> isInside(width * height);
+  for (int y = 0; y < height; y += 1) {
+    for (int x = 0; x < width; x += 1) {
+      isInside[width * y + x] = 128 <= qAlpha(image.pixel(x, y));
+    }
+  }
+
+  // The glyphs are small, so a brute force search of each texel's
+  // neighborhood for the nearest texel on the other side of an edge is fast
+  int spread = DISTANCE_FIELD_SPREAD;
+  for (int y = 0; y < height; y += 1) {
+    for (int x = 0; x < width; x += 1) {
+      bool inside = isInside.at(width * y + x);
+      double distance = spread;
+      for (int dy = -spread; dy <= spread; dy += 1) {
+        for (int dx = -spread; dx <= spread; dx += 1) {
+          int nx = x + dx;
+          int ny = y + dy;
+          if (0 <= nx && nx < width && 0 <= ny && ny < height &&
+              isInside.at(width * ny + nx) != inside) {
+            // The edge is halfway between the centers of the two texels
+            distance = qMin(distance, qSqrt(dx * dx + dy * dy) - 0.5);
+          }
+        }
+      }
+      double signedDistance = inside ? distance : -distance;
+      double alpha = qBound(0.0, 0.5 + signedDistance / (2 * spread), 1.0);
+      QRgb pixel = image.pixel(x, y);
+      image.setPixel(x, y, qRgba(qRed(pixel), qGreen(pixel), qBlue(pixel),
+                                 qRound(255 * alpha)));
     }
   }
-  return map;
+  return image;
+}
+
+QString FontImage::getCachePath() {
+  QString directory =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  QFile file(path());
+  if (directory.isEmpty() || !file.open(QFile::ReadOnly)) {
+    return QString();
+  }
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(file.readAll());
+  hash.addData(QByteArray::number(DISTANCE_FIELD_SPREAD));
+  return QDir(directory).filePath(
+      QString("fonts/%1.png").arg(QString::fromLatin1(hash.result().toHex())));
 }
 
 }  // namespace mms
@@ -1,8 +1,7 @@
 #pragma once
 
-#include <QChar>
-#include <QMap>
-#include <QPair>
+#include <QImage>
+#include <QString>
 
 namespace mms {
 
@@ -11,7 +10,22 @@ class FontImage {
   FontImage() = delete;
   static QString path();
   static QString characters();
-  static QMap<QChar, QPair<double, double>> positions();
+
+  // Loads the font image, flipped for OpenGL, with its alpha channel replaced
+  // by a signed distance field of the glyphs: 0.5 at the edge of a glyph,
+  // rising inside and falling outside, so that edges stay sharp however much
+  // the glyphs are scaled. Returns a null image if the file doesn't exist.
+  // The field is cached on disk, since computing it takes a while.
+  static QImage loadDistanceField();
+
+ private:
+  // The distance, in texels, at which the field saturates
+  static const int DISTANCE_FIELD_SPREAD;
+
+  static QImage computeDistanceField();
+
+  // Keyed by the font image and the spread; empty if there's no cache
+  static QString getCachePath();
 };
 
 }  // namespace mms
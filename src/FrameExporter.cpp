@@ -0,0 +1,293 @@
+#include "FrameExporter.h"
+
+#include <cstring>
+
+#include <QDir>
+#include <QMetaObject>
+#include <QOpenGLFunctions>
+#include <QPair>
+#include <QStringList>
+#include <QSurfaceFormat>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int FrameExporter::MAX_PENDING_FRAMES = 8;
+
+FrameExporter::FrameExporter(const ReplayLog *log, QSize frameSize,
+                             double framesPerSecond,
+                             const QString &framesDirectory,
+                             const QString &videoFile, QObject *parent)
+    : QObject(parent),
+      m_log(log),
+      m_frameSize(frameSize),
+      m_framesPerSecond(framesPerSecond),
+      m_framesDirectory(framesDirectory),
+      m_videoFile(videoFile),
+      m_maze(nullptr),
+      m_stats(nullptr),
+      m_view(nullptr),
+      m_player(nullptr),
+      m_simulation(nullptr),
+      m_mouseGraphic(nullptr),
+      m_isPlayerFinished(false),
+      m_numFrames(0),
+      m_framebuffer(nullptr),
+      m_usePixelBuffers(false),
+      m_encoder(nullptr),
+      m_ffmpeg(nullptr),
+      m_freeFrames(MAX_PENDING_FRAMES),
+      m_hasEncoderFailed(false) {
+  ASSERT_FA(m_log == nullptr);
+  ASSERT_LT(0, m_frameSize.width());
+  ASSERT_LT(0, m_frameSize.height());
+  ASSERT_LT(0.0, m_framesPerSecond);
+  m_pixelBuffers[0] = QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+  m_pixelBuffers[1] = QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+}
+
+FrameExporter::~FrameExporter() {
+  m_encoderThread.quit();
+  m_encoderThread.wait();
+  delete m_encoder;
+  if (m_player != nullptr) {
+    m_player->stop();
+  }
+  if (m_context.makeCurrent(&m_surface)) {
+    m_pixelBuffers[0].destroy();
+    m_pixelBuffers[1].destroy();
+    delete m_framebuffer;
+    m_context.doneCurrent();
+  }
+  delete m_mouseGraphic;
+  delete m_simulation;
+  delete m_player;
+  delete m_view;
+  delete m_stats;
+  delete m_maze;
+}
+
+bool FrameExporter::start(QString *error) {
+  ASSERT_FA(error == nullptr);
+  ASSERT_TR(m_maze == nullptr);
+
+  m_maze = Maze::fromBinary(m_log->getMaze());
+  if (m_maze == nullptr) {
+    *error = "The replay's maze is invalid.";
+    return false;
+  }
+  if (m_videoFile.isEmpty() && !QDir().mkpath(m_framesDirectory)) {
+    *error = QString("Could not create \"%1\".").arg(m_framesDirectory);
+    return false;
+  }
+
+  // Frames are rendered into a framebuffer object, so the surface itself is
+  // never drawn to and can be of any size
+  m_surface.setFormat(QSurfaceFormat::defaultFormat());
+  m_surface.create();
+  m_context.setFormat(m_surface.requestedFormat());
+  m_context.setShareContext(QOpenGLContext::globalShareContext());
+  if (!m_context.create() || !m_context.makeCurrent(&m_surface)) {
+    *error = "Could not create an OpenGL context.";
+    return false;
+  }
+  m_framebuffer = new QOpenGLFramebufferObject(m_frameSize);
+  if (!m_framebuffer->isValid()) {
+    *error = "Could not create an OpenGL framebuffer.";
+    return false;
+  }
+
+  // Mapping a pixel buffer for reading requires glMapBufferRange
+  QPair<int, int> version = m_context.format().version();
+  m_usePixelBuffers = version >= qMakePair(3, 0);
+  int frameBytes = m_frameSize.width() * m_frameSize.height() * 4;
+  for (int i = 0; m_usePixelBuffers && i < 2; i += 1) {
+    m_pixelBuffers[i].setUsagePattern(QOpenGLBuffer::StreamRead);
+    m_usePixelBuffers = m_pixelBuffers[i].create();
+    if (m_usePixelBuffers) {
+      m_pixelBuffers[i].bind();
+      m_pixelBuffers[i].allocate(frameBytes);
+      m_pixelBuffers[i].release();
+    }
+  }
+
+  // The replay is played into the mouse's view, just as it is in the GUI
+  m_stats = new Stats();
+  m_view = new MazeView(m_maze, false);
+  m_player = new ReplayPlayer(m_log);
+  m_simulation = new Simulation(m_maze, m_view->getMazeGraphic(), m_stats,
+                                m_player->getOutput());
+  m_mouseGraphic = new MouseGraphic(m_simulation->getMouse());
+  m_renderer.initialize();
+  m_renderer.setMaze(m_maze);
+  m_renderer.setView(m_view);
+  m_renderer.setMouseGraphics({m_mouseGraphic});
+
+  // The player keeps going after a seek finishes, until it needs a response;
+  // pausing the simulation holds it there until the frame has been rendered
+  connect(m_player, &ReplayPlayer::seekFinished, this,
+          &FrameExporter::onSeekFinished);
+  connect(m_player, &ReplayPlayer::finished, this,
+          [=]() { m_isPlayerFinished = true; });
+
+  m_encoder = new QObject();
+  m_encoder->moveToThread(&m_encoderThread);
+  m_encoderThread.start();
+  if (!m_videoFile.isEmpty()) {
+    bool started = false;
+    QMetaObject::invokeMethod(
+        m_encoder, [&]() { started = startFfmpeg(); },
+        Qt::BlockingQueuedConnection);
+    if (!started) {
+      *error = "Could not start ffmpeg.";
+      return false;
+    }
+  }
+
+  m_player->start(m_simulation);
+  seekNextFrame();
+  return true;
+}
+
+void FrameExporter::seekNextFrame() {
+  // Frames are sampled at fixed steps of virtual time, but a frame can't be
+  // before the position that the player has already reached
+  qint64 microseconds =
+      qMax(qRound64(m_numFrames * 1e6 / m_framesPerSecond),
+           m_player->getPosition());
+  if (m_isPlayerFinished || m_log->getDuration() < microseconds) {
+    finish();
+    return;
+  }
+  m_simulation->setPaused(false);
+  m_player->seek(microseconds);
+}
+
+void FrameExporter::onSeekFinished() {
+  // Called from within the player, which mustn't be re-entered
+  m_simulation->setPaused(true);
+  QMetaObject::invokeMethod(this, &FrameExporter::renderFrame,
+                            Qt::QueuedConnection);
+}
+
+void FrameExporter::renderFrame() {
+  m_context.makeCurrent(&m_surface);
+  m_framebuffer->bind();
+  m_renderer.render(m_frameSize.width(), m_frameSize.height(), 1.0);
+
+  if (m_usePixelBuffers) {
+    // Start copying this frame, then encode the one before it, whose copy
+    // should have finished while this frame was being drawn
+    QOpenGLBuffer *pixelBuffer = &m_pixelBuffers[m_numFrames % 2];
+    pixelBuffer->bind();
+    m_context.functions()->glReadPixels(
+        0, 0, m_frameSize.width(), m_frameSize.height(), GL_RGBA,
+        GL_UNSIGNED_BYTE, nullptr);
+    pixelBuffer->release();
+    if (0 < m_numFrames) {
+      readPixelBuffer(m_numFrames - 1);
+    }
+  } else {
+    encode(m_framebuffer->toImage(false), m_numFrames);
+  }
+
+  m_framebuffer->release();
+  m_numFrames += 1;
+  seekNextFrame();
+}
+
+void FrameExporter::readPixelBuffer(int index) {
+  QOpenGLBuffer *pixelBuffer = &m_pixelBuffers[index % 2];
+  QImage frame(m_frameSize, QImage::Format_RGBA8888);
+  pixelBuffer->bind();
+  void *pixels =
+      pixelBuffer->mapRange(0, frame.sizeInBytes(), QOpenGLBuffer::RangeRead);
+  if (pixels != nullptr) {
+    memcpy(frame.bits(), pixels, frame.sizeInBytes());
+    pixelBuffer->unmap();
+  } else {
+    frame.fill(Qt::black);
+  }
+  pixelBuffer->release();
+  encode(frame, index);
+}
+
+void FrameExporter::finish() {
+  // The last frame is still in its pixel buffer
+  if (m_usePixelBuffers && 0 < m_numFrames) {
+    m_context.makeCurrent(&m_surface);
+    readPixelBuffer(m_numFrames - 1);
+  }
+  m_player->stop();
+  QMetaObject::invokeMethod(
+      m_encoder,
+      [=]() {
+        if (m_ffmpeg != nullptr && !finishFfmpeg()) {
+          m_hasEncoderFailed = true;
+        }
+        int exitCode = m_hasEncoderFailed ? 1 : 0;
+        QMetaObject::invokeMethod(
+            this, [=]() { emit finished(exitCode); }, Qt::QueuedConnection);
+      },
+      Qt::QueuedConnection);
+}
+
+void FrameExporter::encode(const QImage &frame, int index) {
+  // Wait for the encoder, if it's behind, so that frames don't pile up
+  m_freeFrames.acquire();
+  QMetaObject::invokeMethod(
+      m_encoder,
+      [=]() {
+        writeFrame(frame, index);
+        m_freeFrames.release();
+      },
+      Qt::QueuedConnection);
+}
+
+bool FrameExporter::startFfmpeg() {
+  m_ffmpeg = new QProcess(m_encoder);
+  m_ffmpeg->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+  m_ffmpeg->start(
+      "ffmpeg",
+      {"-y", "-loglevel", "error", "-f", "rawvideo", "-pixel_format", "rgb24",
+       "-video_size",
+       QString("%1x%2").arg(m_frameSize.width()).arg(m_frameSize.height()),
+       "-framerate", QString::number(m_framesPerSecond), "-i", "-",
+       "-pix_fmt", "yuv420p", m_videoFile});
+  return m_ffmpeg->waitForStarted();
+}
+
+void FrameExporter::writeFrame(const QImage &frame, int index) {
+  if (m_hasEncoderFailed) {
+    return;
+  }
+  // OpenGL's rows start at the bottom
+  QImage image = frame.mirrored().convertToFormat(QImage::Format_RGB888);
+  if (m_ffmpeg == nullptr) {
+    QString path = QDir(m_framesDirectory)
+                       .filePath(QString("frame-%1.png")
+                                     .arg(index, 6, 10, QChar('0')));
+    m_hasEncoderFailed = !image.save(path);
+    return;
+  }
+  // Rows may be padded, so they're written one at a time
+  int rowBytes = image.width() * 3;
+  for (int y = 0; y < image.height() && !m_hasEncoderFailed; y += 1) {
+    const char *row = reinterpret_cast<const char *>(image.constScanLine(y));
+    m_hasEncoderFailed = m_ffmpeg->write(row, rowBytes) != rowBytes;
+  }
+  // Keep the pipe's buffer from growing without bound
+  while (!m_hasEncoderFailed && 0 < m_ffmpeg->bytesToWrite()) {
+    m_hasEncoderFailed = !m_ffmpeg->waitForBytesWritten(-1);
+  }
+}
+
+bool FrameExporter::finishFfmpeg() {
+  m_ffmpeg->closeWriteChannel();
+  return m_ffmpeg->waitForFinished(-1) &&
+         m_ffmpeg->exitStatus() == QProcess::NormalExit &&
+         m_ffmpeg->exitCode() == 0;
+}
+
+}  // namespace mms
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QImage>
+#include <QObject>
+#include <QOffscreenSurface>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QProcess>
+#include <QSemaphore>
+#include <QSize>
+#include <QString>
+#include <QThread>
+
+#include "MapRenderer.h"
+#include "Maze.h"
+#include "MazeView.h"
+#include "MouseGraphic.h"
+#include "ReplayLog.h"
+#include "ReplayPlayer.h"
+#include "Simulation.h"
+#include "Stats.h"
+
+namespace mms {
+
+// The FrameExporter renders a replay without a window: the log is played, as
+// in the GUI, but it's paused at fixed steps of virtual time, at which the
+// mouse's view is rendered offscreen. Frames are read back asynchronously,
+// via a pair of pixel buffers where they're supported, and are encoded on a
+// worker thread, either as numbered PNGs or by piping them to ffmpeg, so
+// that playing and rendering never wait on the disk.
+class FrameExporter : public QObject {
+  Q_OBJECT
+
+ public:
+  // If a video file is given, frames are encoded to it by ffmpeg, which must
+  // be on the path; otherwise they're written to the frames directory. The
+  // log isn't owned by the exporter.
+  FrameExporter(const ReplayLog *log, QSize frameSize,
+                double framesPerSecond, const QString &framesDirectory,
+                const QString &videoFile, QObject *parent = nullptr);
+  ~FrameExporter();
+
+  // Returns false, with the reason, if frames can't be rendered or encoded,
+  // e.g., if there's no OpenGL; otherwise finished is emitted once every
+  // frame has been encoded
+  bool start(QString *error);
+
+ signals:
+  // The exit code is nonzero if any frame couldn't be encoded
+  void finished(int exitCode);
+
+ private:
+  // Frames that have been read back but not yet encoded; beyond this many,
+  // rendering waits for the encoder, so that memory use is bounded
+  static const int MAX_PENDING_FRAMES;
+
+  const ReplayLog *m_log;
+  QSize m_frameSize;
+  double m_framesPerSecond;
+  QString m_framesDirectory;
+  QString m_videoFile;
+
+  // The replay, played into the mouse's view, as in the GUI
+  Maze *m_maze;
+  Stats *m_stats;
+  MazeView *m_view;
+  ReplayPlayer *m_player;
+  Simulation *m_simulation;
+  MouseGraphic *m_mouseGraphic;
+  bool m_isPlayerFinished;
+  int m_numFrames;  // rendered so far
+
+  // The offscreen target; frame i is read into pixel buffer i % 2, and is
+  // only mapped once frame i + 1 has been rendered, by which time the copy
+  // has usually finished, so the read never stalls the pipeline
+  QOffscreenSurface m_surface;
+  QOpenGLContext m_context;
+  QOpenGLFramebufferObject *m_framebuffer;
+  MapRenderer m_renderer;
+  QOpenGLBuffer m_pixelBuffers[2];
+  bool m_usePixelBuffers;
+
+  // The encoder runs on its own thread, and its state is only touched there
+  QThread m_encoderThread;
+  QObject *m_encoder;
+  QProcess *m_ffmpeg;
+  QSemaphore m_freeFrames;
+  bool m_hasEncoderFailed;
+
+  void seekNextFrame();
+  void onSeekFinished();
+  void renderFrame();
+  void readPixelBuffer(int index);  // of the frame
+  void finish();
+
+  // Encodes the frame, which is upside down, as read from OpenGL
+  void encode(const QImage &frame, int index);
+  bool startFfmpeg();
+  void writeFrame(const QImage &frame, int index);
+  bool finishFfmpeg();
+};
+
+}  // namespace mms
@@ -0,0 +1,152 @@
+#include "FrameTimer.h"
+
+#include <QOpenGLContext>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int FrameTimer::NUM_SLOTS = 3;
+const int FrameTimer::MAX_SAMPLES = 120;
+
+FrameTimer::FrameTimer()
+    : m_isInitialized(false),
+      m_hasGpu(false),
+      m_slots(QVector<Slot>(NUM_SLOTS)),
+      m_currentSlot(0),
+      m_phase(NUM_PHASES),
+      m_samples(QVector<Sample>()),
+      m_nextSample(0) {
+  for (Slot &slot : m_slots) {
+    slot.isPending = false;
+    slot.numQueries = 0;
+  }
+}
+
+FrameTimer::~FrameTimer() {
+  for (Slot &slot : m_slots) {
+    qDeleteAll(slot.queries);
+  }
+}
+
+void FrameTimer::beginFrame() {
+  if (!m_isInitialized) {
+    // Queries are created on first use, since they need a current context
+    m_isInitialized = true;
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    m_hasGpu = context != nullptr && !context->isOpenGLES() &&
+               (context->format().version() >= qMakePair(3, 3) ||
+                context->hasExtension("GL_ARB_timer_query"));
+  }
+  Slot *slot = &m_slots[m_currentSlot];
+  if (slot->isPending) {
+    collect(slot);
+  }
+  for (int i = 0; i < NUM_PHASES; i += 1) {
+    slot->sample.cpuMilliseconds[i] = 0.0;
+    slot->sample.gpuMilliseconds[i] = 0.0;
+  }
+  slot->sample.hasGpu = false;
+  slot->phases.clear();
+  slot->numQueries = 0;
+  m_frameClock.start();
+}
+
+void FrameTimer::beginPhase(Phase phase) {
+  ASSERT_EQ(m_phase, NUM_PHASES);
+  m_phase = phase;
+  Slot *slot = &m_slots[m_currentSlot];
+  if (m_hasGpu) {
+    while (slot->queries.size() < slot->numQueries + 2) {
+      QOpenGLTimerQuery *query = new QOpenGLTimerQuery();
+      if (!query->create()) {
+        // Timer queries aren't supported after all
+        delete query;
+        m_hasGpu = false;
+        break;
+      }
+      slot->queries.append(query);
+    }
+  }
+  if (m_hasGpu) {
+    slot->queries.at(slot->numQueries)->recordTimestamp();
+    slot->phases.append(phase);
+  }
+  m_phaseClock.start();
+}
+
+void FrameTimer::endPhase() {
+  ASSERT_LT(m_phase, NUM_PHASES);
+  Slot *slot = &m_slots[m_currentSlot];
+  slot->sample.cpuMilliseconds[m_phase] += m_phaseClock.nsecsElapsed() / 1e6;
+  if (m_hasGpu && slot->numQueries < 2 * slot->phases.size()) {
+    slot->queries.at(slot->numQueries + 1)->recordTimestamp();
+    slot->numQueries += 2;
+  }
+  m_phase = NUM_PHASES;
+}
+
+void FrameTimer::endFrame() {
+  ASSERT_EQ(m_phase, NUM_PHASES);
+  Slot *slot = &m_slots[m_currentSlot];
+  slot->sample.cpuTotalMilliseconds = m_frameClock.nsecsElapsed() / 1e6;
+  if (0 < slot->numQueries) {
+    slot->isPending = true;
+  } else {
+    addSample(slot->sample);
+  }
+  m_currentSlot = (m_currentSlot + 1) % NUM_SLOTS;
+}
+
+QVector<FrameTimer::Sample> FrameTimer::getSamples() const {
+  QVector<Sample> samples;
+  for (int i = 0; i < m_samples.size(); i += 1) {
+    samples.append(m_samples.at((m_nextSample + i) % m_samples.size()));
+  }
+  return samples;
+}
+
+const char *FrameTimer::getPhaseName(Phase phase) {
+  switch (phase) {
+    case UPLOAD:
+      return "upload";
+    case TILES:
+      return "tiles";
+    case TEXT:
+      return "text";
+    case PATH:
+      return "path";
+    case MICE:
+      return "mice";
+    case NUM_PHASES:
+      break;
+  }
+  ASSERT_NEVER_RUNS();
+}
+
+void FrameTimer::collect(Slot *slot) {
+  // The last query finishes last, so if it's available, they all are;
+  // otherwise the GPU is more than a few frames behind, and the times are
+  // dropped rather than waited for
+  slot->isPending = false;
+  if (slot->queries.at(slot->numQueries - 1)->isResultAvailable()) {
+    for (int i = 0; i < slot->phases.size(); i += 1) {
+      quint64 start = slot->queries.at(2 * i)->waitForResult();
+      quint64 end = slot->queries.at(2 * i + 1)->waitForResult();
+      slot->sample.gpuMilliseconds[slot->phases.at(i)] += (end - start) / 1e6;
+    }
+    slot->sample.hasGpu = true;
+  }
+  addSample(slot->sample);
+}
+
+void FrameTimer::addSample(const Sample &sample) {
+  if (m_samples.size() < MAX_SAMPLES) {
+    m_samples.append(sample);
+  } else {
+    m_samples[m_nextSample] = sample;
+    m_nextSample = (m_nextSample + 1) % MAX_SAMPLES;
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QOpenGLTimerQuery>
+#include <QVector>
+
+namespace mms {
+
+// The FrameTimer times the phases of rendering each frame, both on the CPU,
+// i.e., how long it took to issue the phase's calls, and on the GPU, via
+// timestamp queries, i.e., how long it took to execute them. GPU results
+// aren't read until a few frames later, once they're available, so timing
+// never stalls the pipeline; a frame whose results still aren't available
+// by then only has its CPU times. GPU times need timer queries (OpenGL 3.3,
+// or ARB_timer_query), which OpenGL ES doesn't have. The context must be
+// current whenever any of its methods are called.
+class FrameTimer {
+ public:
+  enum Phase {
+    UPLOAD,  // writing the buffer objects
+    TILES,
+    TEXT,
+    PATH,
+    MICE,
+    NUM_PHASES,
+  };
+
+  struct Sample {
+    double cpuMilliseconds[NUM_PHASES];
+    double cpuTotalMilliseconds;  // of the whole frame
+    bool hasGpu;
+    double gpuMilliseconds[NUM_PHASES];
+  };
+
+  FrameTimer();
+  ~FrameTimer();
+
+  // A phase may be timed any number of times per frame, e.g., once for each
+  // half of a split map, and its times are summed
+  void beginFrame();
+  void beginPhase(Phase phase);
+  void endPhase();
+  void endFrame();
+
+  // The most recent samples, oldest first, up to MAX_SAMPLES of them
+  static const int MAX_SAMPLES;
+  QVector<Sample> getSamples() const;
+
+  static const char *getPhaseName(Phase phase);
+
+ private:
+  // Results are read when a slot is reused, this many frames later
+  static const int NUM_SLOTS;
+
+  // The queries of one frame in flight; each phase has a query at its start
+  // and at its end
+  struct Slot {
+    bool isPending;
+    Sample sample;
+    QVector<QOpenGLTimerQuery *> queries;
+    QVector<Phase> phases;  // of each pair of queries
+    int numQueries;         // used this frame
+  };
+
+  bool m_isInitialized;
+  bool m_hasGpu;
+  QVector<Slot> m_slots;
+  int m_currentSlot;
+
+  QElapsedTimer m_frameClock;
+  QElapsedTimer m_phaseClock;
+  Phase m_phase;
+
+  QVector<Sample> m_samples;  // a ring
+  int m_nextSample;
+
+  void collect(Slot *slot);
+  void addSample(const Sample &sample);
+};
+
+}  // namespace mms
@@ -10,14 +10,20 @@ Coordinate GeometryUtilities::translateVertex(const Coordinate &vertex,
 Coordinate GeometryUtilities::rotateVertexAroundPoint(const Coordinate &vertex,
                                                       const Coordinate &point,
                                                       const Angle &angle) {
-  Coordinate relativeVertex = Coordinate::Cartesian(
-      vertex.getX() - point.getX(), vertex.getY() - point.getY());
-  Coordinate rotatedRelativeVertex = Coordinate::Polar(
-      relativeVertex.getRho(), relativeVertex.getTheta() + angle);
-  Coordinate rotatedVertex =
-      Coordinate::Cartesian(rotatedRelativeVertex.getX() + point.getX(),
-                            rotatedRelativeVertex.getY() + point.getY());
-  return rotatedVertex;
+  return rotateVertexAroundPoint(vertex, point, angle.getSin(),
+                                 angle.getCos());
+}
+
+Coordinate GeometryUtilities::rotateVertexAroundPoint(const Coordinate &vertex,
+                                                      const Coordinate &point,
+                                                      double sin, double cos) {
+  // Rotate relative to the point, directly rather than via polar coordinates,
+  // which would need a square root and an arctangent per vertex
+  double x = (vertex.getX() - point.getX()).getMeters();
+  double y = (vertex.getY() - point.getY()).getMeters();
+  return Coordinate::Cartesian(
+      point.getX() + Distance::Meters(x * cos - y * sin),
+      point.getY() + Distance::Meters(x * sin + y * cos));
 }
 
 }  // namespace mms
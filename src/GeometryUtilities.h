@@ -15,6 +15,12 @@ class GeometryUtilities {
   static Coordinate rotateVertexAroundPoint(const Coordinate &vertex,
                                             const Coordinate &point,
                                             const Angle &angle);
+
+  // The same, given the sine and cosine of the angle, so that they can be
+  // computed once when rotating many vertices by the same angle
+  static Coordinate rotateVertexAroundPoint(const Coordinate &vertex,
+                                            const Coordinate &point,
+                                            double sin, double cos);
 };
 
 }  // namespace mms
@@ -0,0 +1,261 @@
+#include "GpuMazeMetrics.h"
+
+#include <QSurfaceFormat>
+
+#include "Profiler.h"
+
+namespace mms {
+
+const int GpuMazeMetrics::WORKGROUP_SIZE = 256;
+const qint64 GpuMazeMetrics::MAX_DISPATCH_TILES = 16 * 1024 * 1024;
+const int GpuMazeMetrics::MAX_WORKGROUPS = 65535;
+
+GpuMazeMetrics::GpuMazeMetrics()
+    : m_surface(), m_context(), m_program(), m_buffers{0, 0, 0, 0} {}
+
+GpuMazeMetrics::~GpuMazeMetrics() {
+  // The buffers and the program belong to the context
+  if (m_buffers[WALLS] != 0 && m_context.makeCurrent(&m_surface)) {
+    glDeleteBuffers(4, m_buffers);
+    m_program.removeAllShaders();
+    m_context.doneCurrent();
+  }
+}
+
+bool GpuMazeMetrics::initialize(QString *error) {
+  QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+  if (format.renderableType() != QSurfaceFormat::OpenGLES) {
+    format.setVersion(4, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+  }
+  m_surface.setFormat(format);
+  m_surface.create();
+  m_context.setFormat(format);
+  if (!m_context.create() || !m_context.makeCurrent(&m_surface)) {
+    *error = "Could not create an OpenGL context.";
+    return false;
+  }
+  bool isES = m_context.isOpenGLES();
+  QPair<int, int> version = m_context.format().version();
+  if (version < (isES ? qMakePair(3, 1) : qMakePair(4, 3))) {
+    *error = "Compute shaders need OpenGL 4.3 or OpenGL ES 3.1.";
+    return false;
+  }
+  initializeOpenGLFunctions();
+
+  // Each level of the search is a pass over the maze's tiles by the whole
+  // workgroup; a tile at the current level opens the tiles past each of its
+  // missing walls. The passes of a level only ever write the next level, so
+  // racing writes all agree. Tiles are indexed by height * x + y, and the
+  // wall bits are 1 for north, 2 for east, 4 for south, and 8 for west.
+  QString shader = R"(
+            layout(local_size_x = WORKGROUP_SIZE) in;
+            layout(std430, binding = 0) readonly buffer Walls {
+                uint walls[];
+            };
+            layout(std430, binding = 1) coherent buffer Distances {
+                int distances[];
+            };
+            layout(std430, binding = 2) readonly buffer Mazes {
+                ivec4 mazes[];
+            };
+            layout(std430, binding = 3) writeonly buffer Results {
+                ivec4 results[];
+            };
+            shared int isGrowing;
+            shared int deadEnds;
+            shared int junctions;
+            shared int waysOnward;
+
+            int getWalls(int tile) {
+                return int((walls[tile >> 3] >> uint((tile & 7) * 4)) & 15u);
+            }
+
+            void reach(int tile, int distance) {
+                if (distances[tile] == -1) {
+                    distances[tile] = distance;
+                    isGrowing = 1;
+                }
+            }
+
+            void main(void) {
+                ivec4 maze = mazes[gl_WorkGroupID.x];
+                int offset = maze.x;
+                int width = maze.y;
+                int height = maze.z;
+                int numTiles = width * height;
+                int first = int(gl_LocalInvocationIndex);
+                for (int i = first; i < numTiles; i += WORKGROUP_SIZE) {
+                    int x = i / height;
+                    int y = i % height;
+                    bool isCenter = (width - 1) / 2 <= x && x <= width / 2 &&
+                                    (height - 1) / 2 <= y && y <= height / 2;
+                    distances[offset + i] = isCenter ? 0 : -1;
+                }
+                if (first == 0) {
+                    deadEnds = 0;
+                    junctions = 0;
+                    waysOnward = 0;
+                }
+                memoryBarrierBuffer();
+                barrier();
+
+                for (int level = 0; ; level += 1) {
+                    if (first == 0) {
+                        isGrowing = 0;
+                    }
+                    barrier();
+                    for (int i = first; i < numTiles; i += WORKGROUP_SIZE) {
+                        if (distances[offset + i] != level) {
+                            continue;
+                        }
+                        int x = i / height;
+                        int y = i % height;
+                        int tileWalls = getWalls(offset + i);
+                        if ((tileWalls & 1) == 0 && y + 1 < height) {
+                            reach(offset + i + 1, level + 1);
+                        }
+                        if ((tileWalls & 2) == 0 && x + 1 < width) {
+                            reach(offset + i + height, level + 1);
+                        }
+                        if ((tileWalls & 4) == 0 && 0 < y) {
+                            reach(offset + i - 1, level + 1);
+                        }
+                        if ((tileWalls & 8) == 0 && 0 < x) {
+                            reach(offset + i - height, level + 1);
+                        }
+                    }
+                    memoryBarrierBuffer();
+                    memoryBarrierShared();
+                    barrier();
+                    bool isDone = isGrowing == 0;
+                    barrier();
+                    if (isDone) {
+                        break;
+                    }
+                }
+
+                int myDeadEnds = 0;
+                int myJunctions = 0;
+                int myWaysOnward = 0;
+                for (int i = first; i < numTiles; i += WORKGROUP_SIZE) {
+                    int openSides = 4 - bitCount(getWalls(offset + i));
+                    if (openSides == 1) {
+                        myDeadEnds += 1;
+                    } else if (3 <= openSides) {
+                        myJunctions += 1;
+                        myWaysOnward += openSides - 1;
+                    }
+                }
+                atomicAdd(deadEnds, myDeadEnds);
+                atomicAdd(junctions, myJunctions);
+                atomicAdd(waysOnward, myWaysOnward);
+                barrier();
+                if (first == 0) {
+                    results[gl_WorkGroupID.x] = ivec4(
+                        distances[offset], deadEnds, junctions, waysOnward);
+                }
+            }
+        )";
+  shader.replace("WORKGROUP_SIZE", QString::number(WORKGROUP_SIZE));
+  QString preamble = isES ? "#version 310 es\n" : "#version 430 core\n";
+  if (!m_program.addShaderFromSourceCode(QOpenGLShader::Compute,
+                                         preamble + shader) ||
+      !m_program.link()) {
+    *error = "Could not build the metrics compute shader.";
+    return false;
+  }
+  glGenBuffers(4, m_buffers);
+  m_context.doneCurrent();
+  return true;
+}
+
+void GpuMazeMetrics::compute(const QVector<const Maze *> &mazes,
+                             QVector<MazeMetrics> *metrics) {
+  PROFILE_SCOPE("GpuMazeMetrics::compute");
+  m_context.makeCurrent(&m_surface);
+  metrics->fill({-1.0, -1, 0, 0.0}, mazes.size());
+
+  // Pack as many mazes as a dispatch takes; each maze starts on a word of
+  // its own, so that the offsets of tiles are the same in both buffers
+  int first = 0;
+  while (first < mazes.size()) {
+    QVector<quint32> walls;
+    QVector<qint32> descriptors;
+    QVector<int> indices;
+    int last = first;
+    for (; last < mazes.size() && indices.size() < MAX_WORKGROUPS;
+         last += 1) {
+      const Maze *maze = mazes.at(last);
+      if (maze == nullptr) {
+        continue;
+      }
+      int width = maze->getWidth();
+      int height = maze->getHeight();
+      qint64 numTiles = static_cast<qint64>(width) * height;
+      qint64 offset = walls.size() * 8;
+      if (!indices.isEmpty() && MAX_DISPATCH_TILES < offset + numTiles) {
+        break;
+      }
+      walls.resize(walls.size() + (numTiles + 7) / 8);
+      quint32 *words = walls.data();
+      for (int x = 0; x < width; x += 1) {
+        for (int y = 0; y < height; y += 1) {
+          qint64 tile = offset + height * x + y;
+          words[tile / 8] |= static_cast<quint32>(maze->getWalls(x, y))
+                             << (tile % 8 * 4);
+        }
+      }
+      descriptors.append({static_cast<qint32>(offset), width, height, 0});
+      indices.append(last);
+    }
+    if (!indices.isEmpty()) {
+      dispatch(walls, walls.size() * 8, descriptors, indices, metrics);
+    }
+    first = last;
+  }
+  m_context.doneCurrent();
+}
+
+void GpuMazeMetrics::dispatch(const QVector<quint32> &walls, qint64 numTiles,
+                              const QVector<qint32> &mazes,
+                              const QVector<int> &indices,
+                              QVector<MazeMetrics> *metrics) {
+  qint64 resultsSize = sizeof(qint32) * 4 * indices.size();
+  upload(WALLS, walls.constData(), sizeof(quint32) * walls.size(),
+         GL_STATIC_DRAW);
+  upload(DISTANCES, nullptr, sizeof(qint32) * numTiles, GL_DYNAMIC_COPY);
+  upload(MAZES, mazes.constData(), sizeof(qint32) * mazes.size(),
+         GL_STATIC_DRAW);
+  upload(RESULTS, nullptr, resultsSize, GL_DYNAMIC_READ);
+  m_program.bind();
+  glDispatchCompute(indices.size(), 1, 1);
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  m_program.release();
+
+  // Mapping the results waits for the dispatch
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[RESULTS]);
+  const qint32 *results = static_cast<const qint32 *>(glMapBufferRange(
+      GL_SHADER_STORAGE_BUFFER, 0, resultsSize, GL_MAP_READ_BIT));
+  for (int i = 0; results != nullptr && i < indices.size(); i += 1) {
+    const qint32 *result = results + 4 * i;
+    MazeMetrics &mazeMetrics = (*metrics)[indices.at(i)];
+    mazeMetrics.distance = result[0];
+    mazeMetrics.deadEnds = result[1];
+    mazeMetrics.branchingFactor =
+        result[2] == 0 ? 0.0 : static_cast<double>(result[3]) / result[2];
+  }
+  if (results != nullptr) {
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuMazeMetrics::upload(Buffer buffer, const void *data, qint64 size,
+                            GLenum usage) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[buffer]);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, buffer, m_buffers[buffer]);
+}
+
+}  // namespace mms
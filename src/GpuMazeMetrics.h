@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QString>
+#include <QVector>
+
+#include "Maze.h"
+#include "MazeMetrics.h"
+
+namespace mms {
+
+// Computes the grid metrics of many mazes at once with an OpenGL compute
+// shader, e.g., to re-index a large corpus on a GPU node: the distance to
+// the center, dead ends, and branching factor of MazeMetrics, but not the
+// optimal cost, whose search over headings and diagonals is left to
+// MazeSolver. The walls of a batch of mazes are packed into a single buffer,
+// four bits per tile, and uploaded once, and each maze is searched breadth
+// first from the center by a workgroup of its own, a level at a time.
+class GpuMazeMetrics : protected QOpenGLExtraFunctions {
+ public:
+  GpuMazeMetrics();
+  ~GpuMazeMetrics();
+
+  // Creates an offscreen context, which needs a QGuiApplication, and builds
+  // the shader; compute shaders need OpenGL 4.3 or OpenGL ES 3.1
+  bool initialize(QString *error);
+
+  // Sets every metric of each maze but the optimal cost, which is left as
+  // -1; null mazes get the metrics of an unreachable center
+  void compute(const QVector<const Maze *> &mazes,
+               QVector<MazeMetrics> *metrics);
+
+ private:
+  static const int WORKGROUP_SIZE;
+
+  // Bounds the distances buffer of a single dispatch to 64 MiB
+  static const qint64 MAX_DISPATCH_TILES;
+
+  // The minimum number of workgroups that every implementation supports
+  static const int MAX_WORKGROUPS;
+
+  // Bindings of the shader storage buffers
+  enum Buffer {
+    WALLS,
+    DISTANCES,
+    MAZES,
+    RESULTS,
+  };
+
+  QOffscreenSurface m_surface;
+  QOpenGLContext m_context;
+  QOpenGLShaderProgram m_program;
+  GLuint m_buffers[4];
+
+  // Runs the shader over the packed mazes, each of which is its offset into
+  // the walls, in tiles, its width, its height, and padding
+  void dispatch(const QVector<quint32> &walls, qint64 numTiles,
+                const QVector<qint32> &mazes, const QVector<int> &indices,
+                QVector<MazeMetrics> *metrics);
+  void upload(Buffer buffer, const void *data, qint64 size, GLenum usage);
+};
+
+}  // namespace mms
@@ -0,0 +1,101 @@
+#include "JobTuner.h"
+
+#include <QtGlobal>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+// Enough for an algo that spends nearly all of its time waiting on a
+// simulator that answers in microseconds, without thousands of processes
+const int JobTuner::MAX_JOBS_PER_CORE = 16;
+
+// A little headroom, since the utilization is of a window that's already
+// over, and a core that's fully busy makes every run in flight wait
+const double JobTuner::TARGET_UTILIZATION = 0.9;
+
+// Windows vary this much from noise alone, e.g., from mazes of different
+// sizes, so smaller changes in throughput are ignored
+const double JobTuner::THROUGHPUT_TOLERANCE = 0.1;
+
+// Per window, and at least as many runs as are in flight, so that each
+// window sees every run slot finish at least once
+const int JobTuner::MIN_WINDOW_RUNS = 8;
+
+JobTuner::JobTuner(int numCores, int maxJobs)
+    : m_numCores(qMax(1, numCores)),
+      m_maxJobs(maxJobs),
+      m_jobs(qMin(qMax(1, numCores), maxJobs)),
+      m_windowStart(0.0),
+      m_windowRuns(0),
+      m_windowRealSeconds(0.0),
+      m_windowBusySeconds(0.0),
+      m_windowServiceSeconds(0.0),
+      m_isWindowMeasured(true),
+      m_lastThroughput(0.0),
+      m_lastJobs(0) {
+  ASSERT_LT(0, m_maxJobs);
+}
+
+int JobTuner::getJobs() const {
+  return m_jobs;
+}
+
+void JobTuner::addRun(double nowSeconds, double realSeconds,
+                      double algoSeconds, double serviceSeconds) {
+  m_windowRuns += 1;
+  m_windowRealSeconds += realSeconds;
+  m_windowServiceSeconds += serviceSeconds;
+  if (algoSeconds < 0.0) {
+    m_isWindowMeasured = false;
+  } else {
+    m_windowBusySeconds += algoSeconds + serviceSeconds;
+  }
+  if (qMax(MIN_WINDOW_RUNS, m_jobs) <= m_windowRuns) {
+    adjust(nowSeconds);
+  }
+}
+
+void JobTuner::startWindow(double nowSeconds) {
+  m_windowStart = nowSeconds;
+  m_windowRuns = 0;
+  m_windowRealSeconds = 0.0;
+  m_windowBusySeconds = 0.0;
+  m_windowServiceSeconds = 0.0;
+  m_isWindowMeasured = true;
+}
+
+void JobTuner::adjust(double nowSeconds) {
+  double elapsed = nowSeconds - m_windowStart;
+  if (elapsed <= 0.0) {
+    startWindow(nowSeconds);
+    return;
+  }
+  double throughput = m_windowRuns / elapsed;
+  bool isIncrease = 0.0 < m_lastThroughput && m_lastJobs < m_jobs;
+  int jobs = m_jobs;
+  if (isIncrease &&
+      throughput < m_lastThroughput * (1.0 - THROUGHPUT_TOLERANCE)) {
+    m_maxJobs = m_jobs - 1;
+    jobs = m_lastJobs;
+  } else if (m_isWindowMeasured) {
+    double inFlight = m_windowRealSeconds / elapsed;
+    double utilization =
+        qMax(m_windowBusySeconds / (elapsed * m_numCores),
+             m_windowServiceSeconds / elapsed);
+    jobs = utilization <= 0.0
+               ? 2 * m_jobs
+               : qRound(inFlight * TARGET_UTILIZATION / utilization);
+    jobs = qBound(qMax(1, m_jobs / 2), jobs, 2 * m_jobs);
+  } else if (m_lastThroughput <= 0.0 ||
+             (isIncrease &&
+              m_lastThroughput * (1.0 + THROUGHPUT_TOLERANCE) < throughput)) {
+    jobs = 2 * m_jobs;
+  }
+  m_lastThroughput = throughput;
+  m_lastJobs = m_jobs;
+  m_jobs = qBound(1, jobs, m_maxJobs);
+  startWindow(nowSeconds);
+}
+
+}  // namespace mms
@@ -0,0 +1,64 @@
+#pragma once
+
+namespace mms {
+
+// Picks how many runs of a batch to keep in flight, fed each run as it
+// finishes, so that the batch gets through as many mazes a minute as the
+// machine allows, whether its algo is bound by its own CPU time or mostly
+// waits on the protocol. Runs are taken in windows; over each one, the
+// number of runs in flight is the sum of their real times over the window's
+// (Little's law), and of that real time, the algo's CPU time and the
+// simulator's service time are what use the machine, the rest being waits.
+// The service time is counted twice: against the cores, along with the
+// algo's, and against the simulator's single thread, which serves every
+// run. The next window gets as many runs as would bring the busier of the
+// two to TARGET_UTILIZATION, but at most twice or half as many as the last.
+//
+// Without measurements, e.g., of a plugin, or of an algo that can't be
+// sampled, the number of runs is doubled for as long as that speeds the
+// batch up. Either way, a window that's slower than the one before it, after
+// an increase, undoes the increase and caps the number of runs below it,
+// e.g., once the runs contend for memory bandwidth rather than cores.
+class JobTuner {
+ public:
+  // The most runs per core that --jobs auto allows, and that a batch of an
+  // algo that only ever waits would grow to
+  static const int MAX_JOBS_PER_CORE;
+
+  // Starts with a run per core, or the maximum, if that's fewer
+  JobTuner(int numCores, int maxJobs);
+
+  int getJobs() const;
+
+  // All of the times are in seconds: now, since the start of the batch, then
+  // the run's real time, the CPU time of its algo process, or negative if
+  // it's unknown, and the simulator's service time
+  void addRun(double nowSeconds, double realSeconds, double algoSeconds,
+              double serviceSeconds);
+
+ private:
+  static const double TARGET_UTILIZATION;
+  static const double THROUGHPUT_TOLERANCE;
+  static const int MIN_WINDOW_RUNS;
+
+  int m_numCores;
+  int m_maxJobs;  // lowered whenever an increase slows the batch down
+  int m_jobs;
+
+  // Of the current window, which starts as the number of jobs changes
+  double m_windowStart;
+  int m_windowRuns;
+  double m_windowRealSeconds;
+  double m_windowBusySeconds;     // of the algos and the simulator
+  double m_windowServiceSeconds;  // of the simulator alone
+  bool m_isWindowMeasured;        // if every run's algo time was known
+
+  // Of the window before, in runs per second, or zero if there wasn't one
+  double m_lastThroughput;
+  int m_lastJobs;
+
+  void startWindow(double nowSeconds);
+  void adjust(double nowSeconds);
+};
+
+}  // namespace mms
@@ -0,0 +1,78 @@
+#include "LatencyHistogram.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int LatencyHistogram::SUB_BUCKETS = 4;
+const int LatencyHistogram::NUM_BUCKETS = 64 * LatencyHistogram::SUB_BUCKETS;
+
+LatencyHistogram::LatencyHistogram()
+    : m_count(0),
+      m_totalNanoseconds(0),
+      m_maxNanoseconds(0),
+      m_buckets(QVector<qint64>(NUM_BUCKETS, 0)) {}
+
+void LatencyHistogram::add(qint64 nanoseconds) {
+  m_count += 1;
+  m_totalNanoseconds += nanoseconds;
+  m_maxNanoseconds = qMax(m_maxNanoseconds, nanoseconds);
+  m_buckets[getBucket(nanoseconds)] += 1;
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other) {
+  m_count += other.m_count;
+  m_totalNanoseconds += other.m_totalNanoseconds;
+  m_maxNanoseconds = qMax(m_maxNanoseconds, other.m_maxNanoseconds);
+  for (int i = 0; i < NUM_BUCKETS; i += 1) {
+    m_buckets[i] += other.m_buckets.at(i);
+  }
+}
+
+qint64 LatencyHistogram::getCount() const { return m_count; }
+
+qint64 LatencyHistogram::getMean() const {
+  return m_count == 0 ? 0 : m_totalNanoseconds / m_count;
+}
+
+qint64 LatencyHistogram::getMax() const { return m_maxNanoseconds; }
+
+qint64 LatencyHistogram::getPercentile(double fraction) const {
+  if (m_count == 0) {
+    return 0;
+  }
+  qint64 rank = static_cast<qint64>(fraction * (m_count - 1));
+  qint64 seen = 0;
+  for (int i = 0; i < NUM_BUCKETS; i += 1) {
+    seen += m_buckets.at(i);
+    if (rank < seen) {
+      return getBucketLowerBound(i);
+    }
+  }
+  ASSERT_NEVER_RUNS();
+}
+
+int LatencyHistogram::getBucket(qint64 nanoseconds) {
+  // Small durations have a bucket each, after which each power of two is
+  // split into SUB_BUCKETS by the bits just below the leading one
+  if (nanoseconds < SUB_BUCKETS) {
+    return qMax(nanoseconds, static_cast<qint64>(0));
+  }
+  int exponent = 63;
+  while ((nanoseconds >> exponent) == 0) {
+    exponent -= 1;
+  }
+  int sub = (nanoseconds >> (exponent - 2)) & (SUB_BUCKETS - 1);
+  return qMin(SUB_BUCKETS * (exponent - 1) + sub, NUM_BUCKETS - 1);
+}
+
+qint64 LatencyHistogram::getBucketLowerBound(int bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  int exponent = bucket / SUB_BUCKETS + 1;
+  qint64 sub = bucket % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub) << (exponent - 2);
+}
+
+}  // namespace mms
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+
+namespace mms {
+
+// A histogram of durations, in nanoseconds, that costs the same to update
+// however many it holds. Durations are bucketed by power of two, each split
+// into a few linear sub-buckets, so percentiles are accurate to within a
+// quarter.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void add(qint64 nanoseconds);
+
+  // Adds every duration of the other histogram, e.g., of many runs
+  void add(const LatencyHistogram &other);
+
+  qint64 getCount() const;
+  qint64 getMean() const;  // zero if empty
+  qint64 getMax() const;
+
+  // The lower bound of the bucket of the given fraction of the durations,
+  // e.g., 0.99 for the 99th percentile; zero if empty
+  qint64 getPercentile(double fraction) const;
+
+ private:
+  static const int SUB_BUCKETS;
+  static const int NUM_BUCKETS;
+
+  qint64 m_count;
+  qint64 m_totalNanoseconds;
+  qint64 m_maxNanoseconds;
+  QVector<qint64> m_buckets;
+
+  static int getBucket(qint64 nanoseconds);
+  static qint64 getBucketLowerBound(int bucket);
+};
+
+}  // namespace mms
@@ -0,0 +1,37 @@
+#include "LineBuffer.h"
+
+namespace mms {
+
+LineBuffer::LineBuffer() : m_bytes(QByteArray()), m_start(0) {}
+
+void LineBuffer::append(const QByteArray &bytes) {
+  // Drop the lines that were already handed out
+  if (0 < m_start) {
+    m_bytes.remove(0, m_start);
+    m_start = 0;
+  }
+  m_bytes.append(bytes);
+}
+
+bool LineBuffer::nextLine(QByteArrayView *line) {
+  int end = m_bytes.indexOf('\n', m_start);
+  if (end < 0) {
+    return false;
+  }
+  int length = end - m_start;
+  if (0 < length && m_bytes.at(end - 1) == '\r') {
+    length -= 1;  // Windows compatibility
+  }
+  *line = QByteArrayView(m_bytes.constData() + m_start, length);
+  m_start = end + 1;
+  return true;
+}
+
+bool LineBuffer::isEmpty() const { return m_bytes.size() <= m_start; }
+
+void LineBuffer::clear() {
+  m_bytes.clear();
+  m_start = 0;
+}
+
+}  // namespace mms
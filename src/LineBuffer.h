@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+namespace mms {
+
+// Splits a stream of bytes, e.g., an algo's stdout, into lines. Bytes are
+// appended as they arrive and complete lines are handed out as views into
+// the buffer, so nothing is copied or decoded per line; only the incomplete
+// tail is kept, and moved to the front, when more bytes arrive.
+class LineBuffer {
+ public:
+  LineBuffer();
+
+  void append(const QByteArray &bytes);
+
+  // Views the next complete line, excluding the newline (and the carriage
+  // return before it, if any). Returns false if there isn't one. The view is
+  // only valid until the next call to append or clear.
+  bool nextLine(QByteArrayView *line);
+
+  // Whether there are no bytes left to hand out, complete or not
+  bool isEmpty() const;
+
+  void clear();
+
+ private:
+  QByteArray m_bytes;
+  int m_start;  // the start of the first line that hasn't been handed out
+};
+
+}  // namespace mms
@@ -0,0 +1,155 @@
+#include "LiveFeed.h"
+
+#include <QHostAddress>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int LiveFeed::FRAME_INTERVAL_MILLISECONDS = 33;
+
+// About a second of a busy feed, or a keyframe of a big maze
+const qint64 LiveFeed::MAX_BACKLOG_BYTES = 256 * 1024;
+
+LiveFeed::LiveFeed(QObject *parent)
+    : QObject(parent),
+      m_server(new QTcpServer(this)),
+      m_viewers(QList<QTcpSocket *>()),
+      m_laggingViewers(QSet<QTcpSocket *>()),
+      m_timer(new QTimer(this)),
+      m_maze(QByteArray()),
+      m_numTiles(0),
+      m_height(0),
+      m_view(nullptr),
+      m_mouse(nullptr),
+      m_pose({0.0, 0.0, 0.0}) {
+  m_timer->setInterval(FRAME_INTERVAL_MILLISECONDS);
+  connect(m_timer, &QTimer::timeout, this, &LiveFeed::publish);
+  connect(m_server, &QTcpServer::newConnection, this,
+          &LiveFeed::acceptViewers);
+}
+
+bool LiveFeed::listen(quint16 port, QString *error) {
+  if (!m_server->listen(QHostAddress::Any, port)) {
+    *error = QString("Could not listen on port %1: %2")
+                 .arg(port)
+                 .arg(m_server->errorString());
+    return false;
+  }
+  return true;
+}
+
+void LiveFeed::follow(const Maze *maze, MazeGraphic *view,
+                      const Mouse *mouse) {
+  ASSERT_FA(isFollowing());
+  m_maze = maze->toBinary();
+  m_numTiles = maze->getWidth() * maze->getHeight();
+  m_height = maze->getHeight();
+  m_view = view;
+  m_mouse = mouse;
+  m_pose = getPose();
+
+  // Start tracking the changes, which the keyframe already has
+  m_view->takeChangedTiles();
+  QByteArray keyframe = getKeyframe();
+  for (QTcpSocket *viewer : m_viewers) {
+    viewer->write(keyframe);
+  }
+  m_laggingViewers.clear();
+  m_timer->start();
+}
+
+void LiveFeed::unfollow() {
+  // The last changes are sent, so that viewers see how the run ended
+  if (!isFollowing()) {
+    return;
+  }
+  publish();
+  m_timer->stop();
+  m_view = nullptr;
+  m_mouse = nullptr;
+}
+
+bool LiveFeed::isFollowing() const { return m_view != nullptr; }
+
+void LiveFeed::acceptViewers() {
+  while (m_server->hasPendingConnections()) {
+    QTcpSocket *viewer = m_server->nextPendingConnection();
+    viewer->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(viewer, &QTcpSocket::disconnected, this,
+            [=]() { removeViewer(viewer); });
+    m_viewers.append(viewer);
+    if (isFollowing()) {
+      viewer->write(getKeyframe());
+    }
+  }
+}
+
+void LiveFeed::publish() {
+  ASSERT_TR(isFollowing());
+  QVector<int> changed = m_view->takeChangedTiles();
+  LiveProtocol::Pose pose = getPose();
+  if (changed.isEmpty() && pose.x == m_pose.x && pose.y == m_pose.y &&
+      pose.degrees == m_pose.degrees) {
+    return;
+  }
+  m_pose = pose;
+  QVector<LiveProtocol::Tile> tiles;
+  tiles.reserve(changed.size());
+  for (int index : changed) {
+    tiles.append(getTile(index));
+  }
+  QByteArray delta = LiveProtocol::encodeDelta(pose, tiles);
+
+  // The keyframe for lagging viewers is only built if one of them drained
+  QByteArray keyframe;
+  for (QTcpSocket *viewer : m_viewers) {
+    if (m_laggingViewers.contains(viewer)) {
+      if (0 < viewer->bytesToWrite()) {
+        continue;
+      }
+      if (keyframe.isEmpty()) {
+        keyframe = getKeyframe();
+      }
+      viewer->write(keyframe);
+      m_laggingViewers.remove(viewer);
+    } else if (MAX_BACKLOG_BYTES < viewer->bytesToWrite()) {
+      m_laggingViewers.insert(viewer);
+    } else {
+      viewer->write(delta);
+    }
+  }
+}
+
+QByteArray LiveFeed::getKeyframe() const {
+  // Only the tiles that aren't as they started
+  QVector<LiveProtocol::Tile> tiles;
+  for (int i = 0; i < m_numTiles; i += 1) {
+    LiveProtocol::Tile tile = getTile(i);
+    if (tile.state.walls != 0 || tile.state.hasColor ||
+        !tile.state.text.isEmpty()) {
+      tiles.append(tile);
+    }
+  }
+  return LiveProtocol::encodeKeyframe(m_maze, m_pose, tiles);
+}
+
+LiveProtocol::Pose LiveFeed::getPose() const {
+  Coordinate translation = m_mouse->getCurrentTranslation();
+  return {static_cast<float>(translation.getX().getMeters()),
+          static_cast<float>(translation.getY().getMeters()),
+          static_cast<float>(
+              m_mouse->getCurrentRotation().getDegreesZeroTo360())};
+}
+
+LiveProtocol::Tile LiveFeed::getTile(int index) const {
+  return {index, m_view->getTileState(index / m_height, index % m_height)};
+}
+
+void LiveFeed::removeViewer(QTcpSocket *viewer) {
+  m_viewers.removeOne(viewer);
+  m_laggingViewers.remove(viewer);
+  viewer->deleteLater();
+}
+
+}  // namespace mms
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "LiveProtocol.h"
+#include "Maze.h"
+#include "MazeGraphic.h"
+#include "Mouse.h"
+
+namespace mms {
+
+// Publishes a run as it happens, e.g., one of a headless batch, to any number
+// of viewers (see LiveViewer) that connect to a port. A viewer is sent a
+// keyframe as it connects, and as each run is followed, and otherwise a delta
+// a frame at a time, of whatever tiles of the view changed since the last
+// frame (see MazeGraphic::takeChangedTiles) and the mouse's pose; nothing is
+// sent for a frame in which nothing changed. The deltas are encoded once for
+// every viewer. A viewer that can't keep up, whose socket has a backlog of
+// unsent bytes, is skipped until it drains, and then sent a keyframe instead,
+// so a slow viewer never holds up, or costs, the others.
+class LiveFeed : public QObject {
+  Q_OBJECT
+
+ public:
+  LiveFeed(QObject *parent = nullptr);
+
+  // Returns false if the port can't be listened on
+  bool listen(quint16 port, QString *error);
+
+  // Publishes the run of the given maze, view, and mouse, none of which are
+  // owned by the feed, until it's unfollowed, which must happen before any
+  // of them is deleted
+  void follow(const Maze *maze, MazeGraphic *view, const Mouse *mouse);
+  void unfollow();
+  bool isFollowing() const;
+
+ private:
+  static const int FRAME_INTERVAL_MILLISECONDS;
+  static const qint64 MAX_BACKLOG_BYTES;
+
+  QTcpServer *m_server;
+  QList<QTcpSocket *> m_viewers;
+  QSet<QTcpSocket *> m_laggingViewers;  // to be sent a keyframe once drained
+  QTimer *m_timer;
+
+  // The followed run, if any, and the pose that was last sent
+  QByteArray m_maze;
+  int m_numTiles;
+  int m_height;
+  MazeGraphic *m_view;
+  const Mouse *m_mouse;
+  LiveProtocol::Pose m_pose;
+
+  void acceptViewers();
+  void publish();
+  QByteArray getKeyframe() const;
+  LiveProtocol::Pose getPose() const;
+  LiveProtocol::Tile getTile(int index) const;
+  void removeViewer(QTcpSocket *viewer);
+};
+
+}  // namespace mms
@@ -0,0 +1,188 @@
+#include "LiveProtocol.h"
+
+#include <QString>
+#include <QtEndian>
+
+namespace mms {
+
+const int LiveProtocol::HEADER_SIZE = 5;
+
+// A keyframe of the biggest maze with text in every tile is well under this
+const int LiveProtocol::MAX_MESSAGE_SIZE = 64 * 1024 * 1024;
+
+const unsigned char LiveProtocol::NO_COLOR = 0xFF;
+
+QByteArray LiveProtocol::encodeKeyframe(const QByteArray &maze,
+                                        const Pose &pose,
+                                        const QVector<Tile> &tiles) {
+  QByteArray fields;
+  appendUInt32(&fields, maze.size());
+  fields.append(maze);
+  appendPose(&fields, pose);
+  appendTiles(&fields, tiles);
+  return frame(MessageType::KEYFRAME, fields);
+}
+
+QByteArray LiveProtocol::encodeDelta(const Pose &pose,
+                                     const QVector<Tile> &tiles) {
+  QByteArray fields;
+  appendPose(&fields, pose);
+  appendTiles(&fields, tiles);
+  return frame(MessageType::DELTA, fields);
+}
+
+LiveProtocol::Status LiveProtocol::take(QByteArray *buffer,
+                                        Message *message) {
+  if (buffer->size() < HEADER_SIZE) {
+    return Status::NONE;
+  }
+  quint32 size = qFromLittleEndian<quint32>(buffer->constData());
+  if (MAX_MESSAGE_SIZE < size) {
+    return Status::INVALID;
+  }
+  if (static_cast<quint32>(buffer->size() - HEADER_SIZE) < size) {
+    return Status::NONE;
+  }
+  message->type = static_cast<MessageType>(buffer->at(4));
+  QByteArray fields = buffer->mid(HEADER_SIZE, size);
+  buffer->remove(0, HEADER_SIZE + size);
+
+  int position = 0;
+  bool ok = true;
+  switch (message->type) {
+    case MessageType::KEYFRAME: {
+      quint32 mazeSize = 0;
+      ok = readUInt32(fields, &position, &mazeSize) &&
+           mazeSize <= static_cast<quint32>(fields.size() - position);
+      if (ok) {
+        message->maze = fields.mid(position, mazeSize);
+        position += mazeSize;
+      }
+      ok = ok && readPose(fields, &position, &message->pose) &&
+           readTiles(fields, &position, &message->tiles);
+      break;
+    }
+    case MessageType::DELTA:
+      message->maze.clear();
+      ok = readPose(fields, &position, &message->pose) &&
+           readTiles(fields, &position, &message->tiles);
+      break;
+    default:
+      ok = false;
+  }
+  return ok && position == fields.size() ? Status::MESSAGE : Status::INVALID;
+}
+
+QByteArray LiveProtocol::frame(MessageType type, const QByteArray &fields) {
+  QByteArray bytes;
+  appendUInt32(&bytes, fields.size());
+  bytes.append(static_cast<char>(type));
+  bytes.append(fields);
+  return bytes;
+}
+
+void LiveProtocol::appendUInt32(QByteArray *bytes, quint32 value) {
+  int start = bytes->size();
+  bytes->resize(start + 4);
+  qToLittleEndian<quint32>(value, bytes->data() + start);
+}
+
+void LiveProtocol::appendFloat(QByteArray *bytes, float value) {
+  int start = bytes->size();
+  bytes->resize(start + 4);
+  qToLittleEndian<float>(value, bytes->data() + start);
+}
+
+void LiveProtocol::appendPose(QByteArray *bytes, const Pose &pose) {
+  appendFloat(bytes, pose.x);
+  appendFloat(bytes, pose.y);
+  appendFloat(bytes, pose.degrees);
+}
+
+void LiveProtocol::appendTiles(QByteArray *bytes,
+                               const QVector<Tile> &tiles) {
+  // Each tile is its index, its walls, its color, and its text, which is
+  // printable ASCII (see Simulation::getPrintableText) and just a few
+  // characters long, so its length fits in a byte
+  appendUInt32(bytes, tiles.size());
+  for (const Tile &tile : tiles) {
+    QByteArray text = tile.state.text.toLatin1();
+    appendUInt32(bytes, tile.index);
+    bytes->append(static_cast<char>(tile.state.walls));
+    bytes->append(static_cast<char>(
+        tile.state.hasColor ? static_cast<unsigned char>(tile.state.color)
+                            : NO_COLOR));
+    bytes->append(static_cast<char>(text.size()));
+    bytes->append(text);
+  }
+}
+
+bool LiveProtocol::readUInt32(const QByteArray &bytes, int *position,
+                              quint32 *value) {
+  if (bytes.size() < *position + 4) {
+    return false;
+  }
+  *value = qFromLittleEndian<quint32>(bytes.constData() + *position);
+  *position += 4;
+  return true;
+}
+
+bool LiveProtocol::readFloat(const QByteArray &bytes, int *position,
+                             float *value) {
+  if (bytes.size() < *position + 4) {
+    return false;
+  }
+  *value = qFromLittleEndian<float>(bytes.constData() + *position);
+  *position += 4;
+  return true;
+}
+
+bool LiveProtocol::readPose(const QByteArray &bytes, int *position,
+                            Pose *pose) {
+  return readFloat(bytes, position, &pose->x) &&
+         readFloat(bytes, position, &pose->y) &&
+         readFloat(bytes, position, &pose->degrees);
+}
+
+bool LiveProtocol::readTiles(const QByteArray &bytes, int *position,
+                             QVector<Tile> *tiles) {
+  // Each tile takes at least seven bytes, so a count that can't fit is
+  // rejected before anything is allocated for it
+  quint32 count = 0;
+  if (!readUInt32(bytes, position, &count) ||
+      static_cast<quint32>(bytes.size() - *position) / 7 < count) {
+    return false;
+  }
+  tiles->clear();
+  tiles->reserve(count);
+  for (quint32 i = 0; i < count; i += 1) {
+    quint32 index = 0;
+    if (!readUInt32(bytes, position, &index) ||
+        bytes.size() < *position + 3) {
+      return false;
+    }
+    unsigned char walls = static_cast<unsigned char>(bytes.at(*position));
+    unsigned char color = static_cast<unsigned char>(bytes.at(*position + 1));
+    int length = static_cast<unsigned char>(bytes.at(*position + 2));
+    *position += 3;
+    if (0x0F < walls ||
+        (color != NO_COLOR &&
+         static_cast<unsigned char>(Color::DARK_YELLOW) < color) ||
+        bytes.size() < *position + length) {
+      return false;
+    }
+    Tile tile;
+    tile.index = index;
+    tile.state.walls = walls;
+    tile.state.hasColor = color != NO_COLOR;
+    tile.state.color =
+        color == NO_COLOR ? Color::BLACK : static_cast<Color>(color);
+    tile.state.text =
+        QString::fromLatin1(bytes.constData() + *position, length);
+    *position += length;
+    tiles->append(tile);
+  }
+  return true;
+}
+
+}  // namespace mms
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+#include "MazeGraphic.h"
+
+namespace mms {
+
+// The messages from a live feed (see LiveFeed) to its viewers (see
+// LiveViewer). Each message is a four-byte little-endian size, a one-byte
+// type, and then its fields, as in RemoteProtocol. A keyframe has the maze,
+// in the binary maze format (see Maze::toBinary), the mouse's pose, and every
+// tile that isn't as it started; a delta has the pose and just the tiles that
+// changed since the previous message, so it's as small as the changes are,
+// however big the maze is.
+class LiveProtocol {
+ public:
+  LiveProtocol() = delete;
+
+  enum class MessageType : unsigned char {
+    KEYFRAME = 0x01,
+    DELTA = 0x02,
+  };
+
+  // In meters and degrees, as in Mouse
+  struct Pose {
+    float x;
+    float y;
+    float degrees;
+  };
+
+  // The tile at x, y is at index x * height + y, as in MazeGraphic
+  struct Tile {
+    int index;
+    TileState state;
+  };
+
+  struct Message {
+    MessageType type;
+    QByteArray maze;  // for keyframes
+    Pose pose;
+    QVector<Tile> tiles;
+  };
+
+  enum class Status {
+    NONE,     // the buffer doesn't hold a complete message yet
+    MESSAGE,  // a message was taken from the front of the buffer
+    INVALID,  // the buffer can't be a message, so the feed is broken
+  };
+
+  static QByteArray encodeKeyframe(const QByteArray &maze, const Pose &pose,
+                                   const QVector<Tile> &tiles);
+  static QByteArray encodeDelta(const Pose &pose, const QVector<Tile> &tiles);
+
+  static Status take(QByteArray *buffer, Message *message);
+
+ private:
+  static const int HEADER_SIZE;
+  static const int MAX_MESSAGE_SIZE;
+
+  // The color of a tile without one
+  static const unsigned char NO_COLOR;
+
+  static QByteArray frame(MessageType type, const QByteArray &fields);
+
+  // Readers return false if the field would run past the end of the bytes
+  static void appendUInt32(QByteArray *bytes, quint32 value);
+  static void appendFloat(QByteArray *bytes, float value);
+  static void appendPose(QByteArray *bytes, const Pose &pose);
+  static void appendTiles(QByteArray *bytes, const QVector<Tile> &tiles);
+  static bool readUInt32(const QByteArray &bytes, int *position,
+                         quint32 *value);
+  static bool readFloat(const QByteArray &bytes, int *position,
+                        float *value);
+  static bool readPose(const QByteArray &bytes, int *position, Pose *pose);
+  static bool readTiles(const QByteArray &bytes, int *position,
+                        QVector<Tile> *tiles);
+};
+
+}  // namespace mms
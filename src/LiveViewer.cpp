@@ -0,0 +1,125 @@
+#include "LiveViewer.h"
+
+#include <QVBoxLayout>
+
+#include "SimUtilities.h"
+
+namespace mms {
+
+LiveViewer::LiveViewer(QWidget *parent)
+    : QWidget(parent),
+      m_address(QString()),
+      m_socket(new QTcpSocket(this)),
+      m_buffer(QByteArray()),
+      m_map(new Map()),
+      m_maze(nullptr),
+      m_view(nullptr),
+      m_mouse(),
+      m_mouseGraphic(nullptr) {
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->addWidget(m_map);
+  resize(640, 640);
+  connect(m_socket, &QTcpSocket::readyRead, this, &LiveViewer::readMessages);
+  connect(m_socket, &QTcpSocket::connected, this,
+          [=]() { setWindowTitle(m_address); });
+  connect(m_socket, &QTcpSocket::disconnected, this,
+          [=]() { setWindowTitle(m_address + " (disconnected)"); });
+  connect(m_socket, &QTcpSocket::errorOccurred, this, [=]() {
+    setWindowTitle(m_address + " (" + m_socket->errorString() + ")");
+  });
+}
+
+LiveViewer::~LiveViewer() { clear(); }
+
+void LiveViewer::connectToFeed(const QString &host, quint16 port) {
+  m_address = QString("%1:%2").arg(host).arg(port);
+  setWindowTitle(m_address + " (connecting)");
+  m_socket->connectToHost(host, port);
+}
+
+void LiveViewer::readMessages() {
+  m_buffer.append(m_socket->readAll());
+  LiveProtocol::Message message;
+  while (true) {
+    LiveProtocol::Status status = LiveProtocol::take(&m_buffer, &message);
+    if (status == LiveProtocol::Status::NONE) {
+      break;
+    }
+    bool ok = status == LiveProtocol::Status::MESSAGE;
+    if (ok && message.type == LiveProtocol::MessageType::KEYFRAME) {
+      ok = applyKeyframe(message);
+    } else if (ok) {
+      // Deltas before the first keyframe can't happen
+      ok = m_view != nullptr && applyTiles(message.tiles);
+      if (ok) {
+        applyPose(message.pose, false);
+      }
+    }
+    if (!ok) {
+      m_socket->abort();
+      setWindowTitle(m_address + " (invalid feed)");
+      return;
+    }
+  }
+  m_map->markFrameDirty();
+}
+
+bool LiveViewer::applyKeyframe(const LiveProtocol::Message &message) {
+  Maze *maze = Maze::fromBinary(message.maze);
+  if (maze == nullptr) {
+    return false;
+  }
+  clear();
+  m_maze = maze;
+  m_view = new MazeView(m_maze, false);
+  m_map->setMaze(m_maze);
+  m_map->setView(m_view);
+  if (!applyTiles(message.tiles)) {
+    return false;
+  }
+  applyPose(message.pose, true);
+  m_mouseGraphic = new MouseGraphic(&m_mouse);
+  m_map->setMouseGraphics({m_mouseGraphic});
+  return true;
+}
+
+bool LiveViewer::applyTiles(const QVector<LiveProtocol::Tile> &tiles) {
+  int height = m_maze->getHeight();
+  int numTiles = m_maze->getWidth() * height;
+  for (const LiveProtocol::Tile &tile : tiles) {
+    if (tile.index < 0 || numTiles <= tile.index) {
+      return false;
+    }
+    m_view->getMazeGraphic()->setTileState(tile.index / height,
+                                           tile.index % height, tile.state);
+  }
+  return true;
+}
+
+void LiveViewer::applyPose(const LiveProtocol::Pose &pose,
+                           bool isTeleported) {
+  Coordinate translation = Coordinate::Cartesian(Distance::Meters(pose.x),
+                                                 Distance::Meters(pose.y));
+  Angle rotation = Angle::Degrees(pose.degrees);
+  if (isTeleported) {
+    m_mouse.teleport(translation, rotation);
+  } else {
+    m_mouse.moveTo(translation, rotation,
+                   SimUtilities::getHighResTimestamp());
+  }
+}
+
+void LiveViewer::clear() {
+  // The map lets go of everything before any of it is deleted
+  m_map->setMouseGraphics({});
+  m_map->setMaze(nullptr);
+  delete m_mouseGraphic;
+  m_mouseGraphic = nullptr;
+  delete m_view;
+  m_view = nullptr;
+  delete m_maze;
+  m_maze = nullptr;
+}
+
+}  // namespace mms
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QTcpSocket>
+#include <QWidget>
+
+#include "LiveProtocol.h"
+#include "Map.h"
+#include "Maze.h"
+#include "MazeView.h"
+#include "Mouse.h"
+#include "MouseGraphic.h"
+
+namespace mms {
+
+// A window that shows the run that a live feed (see LiveFeed) on another
+// machine is publishing, e.g., of a headless batch, and nothing else. Each
+// keyframe replaces the maze and the view, and each delta just changes its
+// tiles and moves the mouse, which is drawn moving smoothly from one pose to
+// the next, as in the main window.
+class LiveViewer : public QWidget {
+  Q_OBJECT
+
+ public:
+  LiveViewer(QWidget *parent = nullptr);
+  ~LiveViewer();
+
+  void connectToFeed(const QString &host, quint16 port);
+
+ private:
+  QString m_address;
+  QTcpSocket *m_socket;
+  QByteArray m_buffer;  // of messages that haven't all arrived yet
+  Map *m_map;
+
+  // Null until the first keyframe
+  Maze *m_maze;
+  MazeView *m_view;
+  Mouse m_mouse;
+  MouseGraphic *m_mouseGraphic;
+
+  void readMessages();
+  bool applyKeyframe(const LiveProtocol::Message &message);
+  bool applyTiles(const QVector<LiveProtocol::Tile> &tiles);
+  void applyPose(const LiveProtocol::Pose &pose, bool isTeleported);
+  void clear();
+};
+
+}  // namespace mms
@@ -0,0 +1,208 @@
+#include "LockstepBatch.h"
+
+#include <QHash>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int LockstepBatch::DX[4] = {0, 1, 0, -1};
+const int LockstepBatch::DY[4] = {1, 0, -1, 0};
+
+LockstepBatch::LockstepBatch(const QVector<const Maze *> &mazes)
+    : m_walls(QVector<unsigned char>(1, 0x0F)),
+      m_offsets(QVector<int>(mazes.size(), 0)),
+      m_widths(QVector<int>(mazes.size(), 0)),
+      m_heights(QVector<int>(mazes.size(), 0)),
+      m_xs(QVector<int>(mazes.size(), 0)),
+      m_ys(QVector<int>(mazes.size(), 0)),
+      m_directions(QVector<int>(mazes.size(), 0)),
+      m_running(QVector<int>(mazes.size(), 0)),
+      m_sensed(QVector<int>(mazes.size(), 0)),
+      m_moved(QVector<int>(mazes.size(), 0)),
+      m_statuses(QVector<Status>(mazes.size(), Status::INVALID_MAZE)),
+      m_moves(QVector<int>(mazes.size(), 0)),
+      m_distances(QVector<int>(mazes.size(), 0)),
+      m_turns(QVector<int>(mazes.size(), 0)),
+      m_crashes(QVector<int>(mazes.size(), 0)),
+      m_solvedMoves(QVector<int>(mazes.size(), -1)),
+      m_numRunning(0),
+      m_batch() {
+  // Each mouse starts in the lower left tile, facing north, as in a
+  // Simulation, which is where the zeroed poses already put it
+  QHash<const Maze *, int> offsets;
+  for (int i = 0; i < mazes.size(); i += 1) {
+    const Maze *maze = mazes.at(i);
+    if (maze == nullptr) {
+      continue;
+    }
+    if (!offsets.contains(maze)) {
+      offsets.insert(maze, m_walls.size());
+      for (int x = 0; x < maze->getWidth(); x += 1) {
+        for (int y = 0; y < maze->getHeight(); y += 1) {
+          m_walls.append(maze->getWalls(x, y));
+        }
+      }
+    }
+    m_offsets[i] = offsets.value(maze);
+    m_widths[i] = maze->getWidth();
+    m_heights[i] = maze->getHeight();
+    m_running[i] = 1;
+    m_moved[i] = 1;
+    m_statuses[i] = Status::RUNNING;
+    m_numRunning += 1;
+  }
+  m_batch.count = mazes.size();
+  m_batch.running = m_running.constData();
+  m_batch.walls = m_sensed.constData();
+  m_batch.moved = m_moved.constData();
+}
+
+int LockstepBatch::getCount() const { return m_batch.count; }
+
+const QVector<int> &LockstepBatch::getWidths() const { return m_widths; }
+
+const QVector<int> &LockstepBatch::getHeights() const { return m_heights; }
+
+bool LockstepBatch::isRunning() const { return 0 < m_numRunning; }
+
+const mms_batch *LockstepBatch::sense() {
+  // Rotating a tile's mask by the heading puts the walls in the order of the
+  // walls command, i.e., front, right, back, left, since the directions are
+  // in clockwise order (see Maze::getWallBit). Stopped mice are sensed too,
+  // rather than branching around them; the mice of null mazes stand on the
+  // closed tile at offset zero.
+  const unsigned char *walls = m_walls.constData();
+  const int *offsets = m_offsets.constData();
+  const int *heights = m_heights.constData();
+  const int *xs = m_xs.constData();
+  const int *ys = m_ys.constData();
+  const int *directions = m_directions.constData();
+  int *sensed = m_sensed.data();
+  for (int i = 0; i < m_batch.count; i += 1) {
+    int mask = walls[offsets[i] + heights[i] * xs[i] + ys[i]];
+    int direction = directions[i];
+    sensed[i] = ((mask >> direction) | (mask << (4 - direction))) & 0x0F;
+  }
+  return &m_batch;
+}
+
+void LockstepBatch::advance(const mms_move *moves) {
+  for (int i = 0; i < m_batch.count; i += 1) {
+    if (m_running.at(i) == 0) {
+      continue;
+    }
+    switch (moves[i].movement) {
+      case MMS_MOVE_NONE:
+        stop(i, Status::COMPLETE);
+        continue;
+      case MMS_MOVE_FORWARD:
+        moveForward(i, moves[i].distance);
+        break;
+      case MMS_MOVE_TURN_RIGHT:
+        m_directions[i] = (m_directions.at(i) + 1) % 4;
+        m_turns[i] += 1;
+        m_moved[i] = 1;
+        break;
+      case MMS_MOVE_TURN_LEFT:
+        m_directions[i] = (m_directions.at(i) + 3) % 4;
+        m_turns[i] += 1;
+        m_moved[i] = 1;
+        break;
+      default:
+        // Half steps and diagonals are off the grid
+        stop(i, Status::INVALID_MOVE);
+        continue;
+    }
+    m_moves[i] += 1;
+    if (m_solvedMoves.at(i) < 0 && isInCenter(i)) {
+      m_solvedMoves[i] = m_moves.at(i);
+    }
+  }
+}
+
+void LockstepBatch::timeOut() {
+  for (int i = 0; i < m_batch.count; i += 1) {
+    if (m_running.at(i) != 0) {
+      stop(i, Status::TIMEOUT);
+    }
+  }
+}
+
+QStringList LockstepBatch::getCsvHeader() {
+  return {"status", "moves", "distance", "turns", "crashes", "solved-move"};
+}
+
+QStringList LockstepBatch::getCsvFields(int index) const {
+  if (m_statuses.at(index) == Status::INVALID_MAZE) {
+    // Nothing was run, as with BatchRunner's empty stats
+    return {getStatusName(Status::INVALID_MAZE), "", "", "", "", ""};
+  }
+  int solvedMove = m_solvedMoves.at(index);
+  return {
+      getStatusName(m_statuses.at(index)),
+      QString::number(m_moves.at(index)),
+      QString::number(m_distances.at(index)),
+      QString::number(m_turns.at(index)),
+      QString::number(m_crashes.at(index)),
+      solvedMove < 0 ? QString() : QString::number(solvedMove),
+  };
+}
+
+void LockstepBatch::moveForward(int index, int distance) {
+  // Non-positive distances are crashes, as in a Simulation
+  int direction = m_directions.at(index);
+  int bit = Maze::getWallBit(static_cast<Direction>(direction));
+  const unsigned char *walls = m_walls.constData() + m_offsets.at(index);
+  int height = m_heights.at(index);
+  int x = m_xs.at(index);
+  int y = m_ys.at(index);
+  int steps = 0;
+  while (steps < distance && (walls[height * x + y] & bit) == 0) {
+    x += DX[direction];
+    y += DY[direction];
+    steps += 1;
+  }
+  m_xs[index] = x;
+  m_ys[index] = y;
+  m_distances[index] += steps;
+  m_moved[index] = 0 < distance && steps == distance ? 1 : 0;
+  m_crashes[index] += 1 - m_moved.at(index);
+}
+
+void LockstepBatch::stop(int index, Status status) {
+  ASSERT_EQ(m_running.at(index), 1);
+  m_running[index] = 0;
+  m_statuses[index] = status;
+  m_numRunning -= 1;
+}
+
+QString LockstepBatch::getStatusName(Status status) {
+  switch (status) {
+    case Status::RUNNING:
+      return "running";
+    case Status::COMPLETE:
+      return "complete";
+    case Status::TIMEOUT:
+      return "timeout";
+    case Status::INVALID_MOVE:
+      return "error";
+    case Status::INVALID_MAZE:
+      return "invalid-maze";
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+bool LockstepBatch::isInCenter(int index) const {
+  // The center is the one, two, or four tiles in the middle (see
+  // Maze::getCenterPositions)
+  int width = m_widths.at(index);
+  int height = m_heights.at(index);
+  int x = m_xs.at(index);
+  int y = m_ys.at(index);
+  return (width - 1) / 2 <= x && x <= width / 2 && (height - 1) / 2 <= y &&
+         y <= height / 2;
+}
+
+}  // namespace mms
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "../util/mms-plugin.h"
+#include "Maze.h"
+
+namespace mms {
+
+// The mice of a batched plugin (see mms_plugin_batch_step), one per run,
+// moved in lockstep. There are no simulations, mice, or stats objects: a
+// mouse is an index into flat arrays of poses and counters, and the walls of
+// every maze are copied once into a single array of masks, so a mouse costs a
+// few dozen bytes beyond its maze, and each step is a couple of passes over
+// contiguous arrays. Sensing is branch-free, so the compiler can vectorize it.
+//
+// Only the grid is simulated: mice stand at the centers of tiles, facing one
+// of the four directions, and move by whole tiles or turn by 90 degrees. Just
+// as in a Simulation, a move stops short of the first wall in its way and
+// counts as a crash, and a mouse has solved its maze once a movement ends in
+// the center.
+class LockstepBatch {
+ public:
+  // Null mazes are runs that can't happen, e.g., of invalid maze files, and
+  // the same maze can be given for many runs. The mazes aren't needed once
+  // the batch is constructed.
+  explicit LockstepBatch(const QVector<const Maze *> &mazes);
+
+  int getCount() const;
+  const QVector<int> &getWidths() const;
+  const QVector<int> &getHeights() const;
+
+  // Whether any mouse is still running
+  bool isRunning() const;
+
+  // Senses the walls around every mouse, for the next step of the algo
+  const mms_batch *sense();
+
+  // Performs the movement of every running mouse
+  void advance(const mms_move *moves);
+
+  // Stops the mice that are still running, whose runs then time out
+  void timeOut();
+
+  // The status of a run is as in BatchRunner, followed by its counters
+  static QStringList getCsvHeader();
+  QStringList getCsvFields(int index) const;
+
+ private:
+  enum class Status {
+    RUNNING,
+    COMPLETE,
+    TIMEOUT,
+    INVALID_MOVE,
+    INVALID_MAZE,
+  };
+
+  // The tile that a step in each direction leads to, indexed by direction
+  static const int DX[4];
+  static const int DY[4];
+
+  // Every maze's wall masks, after a mask of a closed tile that the mice of
+  // null mazes stand on
+  QVector<unsigned char> m_walls;
+
+  // Indexed by mouse
+  QVector<int> m_offsets;  // of the mouse's maze, in the masks
+  QVector<int> m_widths;
+  QVector<int> m_heights;
+  QVector<int> m_xs;
+  QVector<int> m_ys;
+  QVector<int> m_directions;
+  QVector<int> m_running;
+  QVector<int> m_sensed;
+  QVector<int> m_moved;
+  QVector<Status> m_statuses;
+  QVector<int> m_moves;
+  QVector<int> m_distances;
+  QVector<int> m_turns;
+  QVector<int> m_crashes;
+  QVector<int> m_solvedMoves;  // -1 until the mouse reaches the center
+
+  int m_numRunning;
+  mms_batch m_batch;
+
+  void moveForward(int index, int distance);
+  void stop(int index, Status status);
+  static QString getStatusName(Status status);
+  bool isInCenter(int index) const;
+};
+
+}  // namespace mms
@@ -0,0 +1,56 @@
+#include "LockstepRunner.h"
+
+#include <QMap>
+#include <QVector>
+
+#include "AssertMacros.h"
+#include "BatchRunner.h"
+#include "LockstepBatch.h"
+#include "Maze.h"
+
+namespace mms {
+
+const int LockstepRunner::DEFAULT_BATCH_SIZE = 4096;
+
+int LockstepRunner::run(const QStringList &mazeFiles, int repeats,
+                        const PluginAlgo *plugin, double timeoutSeconds,
+                        int batchSize, QTextStream *output) {
+  ASSERT_LT(0, repeats);
+  ASSERT_LT(0, batchSize);
+  ASSERT_TR(plugin->isBatched());
+  QStringList header = {"maze"};
+  header.append(LockstepBatch::getCsvHeader());
+  *output << header.join(",") << Qt::endl;
+
+  int numRuns = mazeFiles.size() * repeats;
+  int failures = 0;
+  for (int first = 0; first < numRuns; first += batchSize) {
+    // A maze's repeats share its walls, see LockstepBatch
+    int count = qMin(batchSize, numRuns - first);
+    QMap<int, Maze *> loaded;
+    QVector<const Maze *> mazes;
+    for (int i = first; i < first + count; i += 1) {
+      int mazeIndex = i / repeats;
+      if (!loaded.contains(mazeIndex)) {
+        loaded.insert(mazeIndex, Maze::fromFile(mazeFiles.at(mazeIndex)));
+      }
+      mazes.append(loaded.value(mazeIndex));
+    }
+    LockstepBatch batch(mazes);
+    qDeleteAll(loaded);
+    plugin->runBatch(&batch, first, timeoutSeconds);
+
+    for (int i = 0; i < count; i += 1) {
+      QStringList fields = batch.getCsvFields(i);
+      if (fields.first() != "complete") {
+        failures += 1;
+      }
+      fields.prepend(
+          BatchRunner::toCsvField(mazeFiles.at((first + i) / repeats)));
+      *output << fields.join(",") << Qt::endl;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+}  // namespace mms
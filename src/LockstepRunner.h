@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include "PluginAlgo.h"
+
+namespace mms {
+
+// Runs a batched plugin (see LockstepBatch) against each of a list of mazes,
+// instead of a BatchRunner. The runs are stepped a batch at a time, so only
+// the mazes of one batch are ever loaded, and a CSV row is written for each
+// run, in order, with the counters of the lockstep simulation, not stats.
+class LockstepRunner {
+ public:
+  // The LockstepRunner class is not constructible
+  LockstepRunner() = delete;
+
+  // Big enough that each step is over long arrays, but small enough that
+  // the mazes of a batch take little memory
+  static const int DEFAULT_BATCH_SIZE;
+
+  // Each maze is run the given number of times, as in BatchRunner, at most
+  // the given number of runs per batch, and each batch is given the timeout
+  // as a whole. Returns a nonzero exit code if any of the runs did not
+  // complete successfully.
+  static int run(const QStringList &mazeFiles, int repeats,
+                 const PluginAlgo *plugin, double timeoutSeconds,
+                 int batchSize, QTextStream *output);
+};
+
+}  // namespace mms
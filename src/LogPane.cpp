@@ -0,0 +1,100 @@
+#include "LogPane.h"
+
+#include <QAction>
+#include <QFile>
+#include <QFileDialog>
+#include <QMenu>
+#include <QMessageBox>
+
+namespace mms {
+
+const int LogPane::MAX_LINES = 10000;
+const int LogPane::FLUSH_INTERVAL_MILLISECONDS = 16;
+
+LogPane::LogPane(QPlainTextEdit *edit, QObject *parent)
+    : QObject(parent),
+      m_edit(edit),
+      m_flushTimer(new QTimer(this)),
+      m_pendingLines(QStringList()),
+      m_numSkippedLines(0),
+      m_spillFile(new QTemporaryFile(this)) {
+  m_edit->setMaximumBlockCount(MAX_LINES);
+  m_flushTimer->setSingleShot(true);
+  m_flushTimer->setInterval(FLUSH_INTERVAL_MILLISECONDS);
+  connect(m_flushTimer, &QTimer::timeout, this, &LogPane::flush);
+  if (!m_spillFile->open()) {
+    delete m_spillFile;
+    m_spillFile = nullptr;
+  }
+
+  // Offer to save the full log, alongside the usual actions
+  m_edit->setContextMenuPolicy(Qt::CustomContextMenu);
+  connect(m_edit, &QWidget::customContextMenuRequested, this,
+          &LogPane::showContextMenu);
+}
+
+void LogPane::appendLine(const QString &line) {
+  if (m_spillFile != nullptr) {
+    m_spillFile->write(line.toUtf8());
+    m_spillFile->write("\n", 1);
+  }
+
+  // Lines beyond the limit would be removed as soon as they're shown
+  m_pendingLines.append(line);
+  if (MAX_LINES < m_pendingLines.size()) {
+    m_pendingLines.removeFirst();
+    m_numSkippedLines += 1;
+  }
+  if (!m_flushTimer->isActive()) {
+    m_flushTimer->start();
+  }
+}
+
+void LogPane::clear() {
+  m_flushTimer->stop();
+  m_pendingLines.clear();
+  m_numSkippedLines = 0;
+  m_edit->clear();
+  if (m_spillFile != nullptr) {
+    m_spillFile->resize(0);
+    m_spillFile->seek(0);
+  }
+}
+
+void LogPane::flush() {
+  if (0 < m_numSkippedLines) {
+    m_edit->appendPlainText(
+        QString("[%1 lines skipped, save the full log to see them]")
+            .arg(m_numSkippedLines));
+    m_numSkippedLines = 0;
+  }
+  if (!m_pendingLines.isEmpty()) {
+    m_edit->appendPlainText(m_pendingLines.join('\n'));
+    m_pendingLines.clear();
+  }
+}
+
+void LogPane::showContextMenu(const QPoint &position) {
+  QMenu *menu = m_edit->createStandardContextMenu();
+  menu->addSeparator();
+  QAction *action = menu->addAction("Save Full Log...");
+  action->setEnabled(m_spillFile != nullptr);
+  connect(action, &QAction::triggered, this, &LogPane::saveFullLog);
+  menu->exec(m_edit->mapToGlobal(position));
+  delete menu;
+}
+
+void LogPane::saveFullLog() {
+  QString path = QFileDialog::getSaveFileName(m_edit, tr("Save Full Log"));
+  if (path.isNull()) {
+    return;
+  }
+  m_spillFile->flush();
+  QFile::remove(path);
+  if (!QFile::copy(m_spillFile->fileName(), path)) {
+    QMessageBox::warning(m_edit, "Save Failed",
+                         QString("Could not write \"%1\".").arg(path));
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QObject>
+#include <QPlainTextEdit>
+#include <QPoint>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QTimer>
+
+namespace mms {
+
+// Shows the output of a process in a text edit without letting a chatty
+// process slow everything else down. Lines are coalesced and appended at
+// most once per frame, only the last MAX_LINES are kept, and lines that
+// would scroll away before they're drawn are skipped and summarized. Every
+// line is also spilled to a temporary file, so that the full log can still
+// be saved from the text edit's context menu.
+class LogPane : public QObject {
+  Q_OBJECT
+
+ public:
+  // The text edit isn't owned by the pane
+  LogPane(QPlainTextEdit *edit, QObject *parent = nullptr);
+
+  void appendLine(const QString &line);
+  void clear();
+
+ private:
+  static const int MAX_LINES;
+  static const int FLUSH_INTERVAL_MILLISECONDS;
+
+  QPlainTextEdit *m_edit;
+  QTimer *m_flushTimer;
+  QStringList m_pendingLines;
+  int m_numSkippedLines;
+  QTemporaryFile *m_spillFile;  // null if it couldn't be created
+
+  void flush();
+  void showContextMenu(const QPoint &position);
+  void saveFullLog();
+};
+
+}  // namespace mms
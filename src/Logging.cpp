@@ -1,26 +1,130 @@
 #include "Logging.h"
 
+#include <cstdio>
+
+#include <QLoggingCategory>
+#include <QStringList>
+
 #include "AssertMacros.h"
 
 namespace mms {
 
-QTextStream *Logging::STDOUT = nullptr;
+int Logging::MIN_LEVEL = 0;
+std::atomic<bool> Logging::IS_RUNNING(false);
+std::atomic<Logging::Node *> Logging::HEAD(nullptr);
+Logging::Node *Logging::TAIL = nullptr;
+std::atomic<int> Logging::NUM_PENDING(0);
+QSemaphore Logging::WAKEUP;
+std::thread *Logging::WRITER = nullptr;
 
 void Logging::init() {
-  ASSERT_TR(STDOUT == nullptr);
-  STDOUT = new QTextStream(stdout);
+  ASSERT_TR(WRITER == nullptr);
+
+  // Qt skips formatting the messages of disabled levels altogether
+  static const QStringList LEVELS = {"debug", "info", "warning", "critical"};
+  QString level = qEnvironmentVariable("MMS_LOG_LEVEL").toLower();
+  MIN_LEVEL = qMax(0, LEVELS.indexOf(level));
+  QStringList rules;
+  for (int i = 0; i < MIN_LEVEL; i += 1) {
+    rules.append(QString("*.%1=false").arg(LEVELS.at(i)));
+  }
+  QLoggingCategory::setFilterRules(rules.join('\n'));
+
+  // The queue starts with a node that has already been written
+  TAIL = new Node();
+  TAIL->next.store(nullptr);
+  HEAD.store(TAIL);
+  IS_RUNNING.store(true);
+  WRITER = new std::thread(runWriter);
   qInstallMessageHandler(handler);
 }
 
+void Logging::finish() {
+  if (WRITER == nullptr) {
+    return;
+  }
+  IS_RUNNING.store(false);
+  WAKEUP.release();
+  WRITER->join();
+  delete WRITER;
+  WRITER = nullptr;
+  // Messages that other threads were pushing just as logging stopped may
+  // miss this, but nothing is logged from other threads at exit
+  drain();
+}
+
 void Logging::handler(QtMsgType type, const QMessageLogContext &context,
                       const QString &msg) {
-  ASSERT_FA(STDOUT == nullptr);
+  if (getLevel(type) < MIN_LEVEL) {
+    return;
+  }
+  // A fatal message is followed by an abort, so it can't wait for the writer
+  if (type == QtFatalMsg || !IS_RUNNING.load()) {
+    write(format(context.file, context.line, msg));
+    return;
+  }
+  Node *node = new Node();
+  node->next.store(nullptr, std::memory_order_relaxed);
+  node->file = context.file;
+  node->line = context.line;
+  node->msg = msg;
+  Node *previous = HEAD.exchange(node, std::memory_order_acq_rel);
+  previous->next.store(node, std::memory_order_release);
+  if (NUM_PENDING.fetch_add(1) == 0) {
+    WAKEUP.release();
+  }
+}
 
-  QString formatted =
-      QString("[%1:%2] - %3")
-          .arg(context.file, QString::number(context.line), msg);
+int Logging::getLevel(QtMsgType type) {
+  switch (type) {
+    case QtDebugMsg:
+      return 0;
+    case QtInfoMsg:
+      return 1;
+    case QtWarningMsg:
+      return 2;
+    case QtCriticalMsg:
+      return 3;
+    case QtFatalMsg:
+      return 4;
+  }
+  return 4;
+}
+
+QByteArray Logging::format(const QByteArray &file, int line,
+                           const QString &msg) {
+  return QString("[%1:%2] - %3\n")
+      .arg(QString::fromUtf8(file), QString::number(line), msg)
+      .toLocal8Bit();
+}
+
+void Logging::write(const QByteArray &bytes) {
+  fwrite(bytes.constData(), 1, bytes.size(), stdout);
+  fflush(stdout);
+}
+
+void Logging::runWriter() {
+  while (IS_RUNNING.load()) {
+    WAKEUP.acquire();
+    NUM_PENDING.store(0);
+    drain();
+  }
+}
 
-  *STDOUT << formatted << Qt::endl;
+void Logging::drain() {
+  // A producer that has swapped itself in but not yet linked its node is
+  // picked up on the next wakeup, which it's about to cause
+  QByteArray bytes;
+  Node *next = TAIL->next.load(std::memory_order_acquire);
+  while (next != nullptr) {
+    bytes.append(format(next->file, next->line, next->msg));
+    delete TAIL;
+    TAIL = next;
+    next = TAIL->next.load(std::memory_order_acquire);
+  }
+  if (!bytes.isEmpty()) {
+    write(bytes);
+  }
 }
 
 }  // namespace mms
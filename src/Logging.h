@@ -1,20 +1,60 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
+
+#include <QByteArray>
 #include <QDebug>
+#include <QSemaphore>
 #include <QString>
-#include <QTextStream>
 
 namespace mms {
 
+// Qt's messages are written to stdout by a background thread, so that the
+// thread that logs never waits on stdout. Each message is pushed onto a
+// lock-free queue, and the writer drains the queue and writes what it found
+// in a single write, so heavy logging costs a write per batch rather than a
+// flush per line. Messages below the level in the MMS_LOG_LEVEL environment
+// variable (debug, info, warning, or critical) are dropped before they're
+// even formatted.
 class Logging {
  public:
   Logging() = delete;
   static void init();
 
+  // Writes whatever is still queued and stops the writer; any later messages
+  // are written directly
+  static void finish();
+
  private:
-  static QTextStream *STDOUT;
+  // A queue of one producer per logging thread and one consumer, the writer:
+  // producers swap themselves in at the head, and the writer follows the
+  // links from the tail, which is always a node that has been written
+  struct Node {
+    std::atomic<Node *> next;
+    QByteArray file;
+    int line;
+    QString msg;
+  };
+
+  static int MIN_LEVEL;
+  static std::atomic<bool> IS_RUNNING;
+  static std::atomic<Node *> HEAD;
+  static Node *TAIL;
+
+  // The writer is only woken when the queue may have gone from empty to not
+  static std::atomic<int> NUM_PENDING;
+  static QSemaphore WAKEUP;
+  static std::thread *WRITER;
+
   static void handler(QtMsgType type, const QMessageLogContext &context,
                       const QString &msg);
+  static int getLevel(QtMsgType type);
+  static QByteArray format(const QByteArray &file, int line,
+                           const QString &msg);
+  static void write(const QByteArray &bytes);
+  static void runWriter();
+  static void drain();
 };
 
 }  // namespace mms
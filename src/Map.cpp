@@ -1,53 +1,158 @@
 #include "Map.h"
 
-#include <QElapsedTimer>
-#include <QFile>
+#include <cmath>
 
+#include <QApplication>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFunctions>
+#include <QPainter>
+#include <QString>
+
+#include "AllocationCounter.h"
 #include "AssertMacros.h"
 #include "Dimensions.h"
-#include "FontImage.h"
-#include "Logging.h"
+#include "Profiler.h"
 #include "TransformationMatrix.h"
 
 namespace mms {
 
+const double Map::FRAME_BUDGET_MILLISECONDS = 1000.0 / 60.0;
+const double Map::MIN_RENDER_SCALE = 0.4;
+const double Map::RENDER_SCALE_STEP = 0.8;
+
+// Long enough for the GPU times of the frames at the new scale to be read
+// (see FrameTimer)
+const int Map::RENDER_SCALE_INTERVAL_FRAMES = 15;
+
 Map::Map(QWidget *parent)
     : QOpenGLWidget(parent),
-      m_maze(nullptr),
-      m_view(nullptr),
-      m_mouseGraphic(nullptr),
+      m_isFrameDirty(true),
+      m_isSuspended(false),
+      m_isFrameOverlayShown(false),
+      m_frameAllocations(0),
+      m_frameBytes(0),
+      m_canScaleRender(false),
+      m_isRenderScaleAdaptive(false),
+      m_renderScale(1.0),
+      m_framesSinceRescale(0),
+      m_scaledFramebuffer(nullptr),
       m_windowWidth(0),
       m_windowHeight(0),
-      m_textureAtlas(nullptr) {
+      m_maze(nullptr),
+      m_isEditing(false) {
   ASSERT_RUNS_JUST_ONCE();
+
+  // Anything that changed while the last frame was being drawn or presented
+  // still needs to be drawn
+  connect(this, &QOpenGLWidget::frameSwapped, this, [=]() {
+    if (!m_isSuspended && isFrameDirty()) {
+      update();
+    }
+  });
 }
 
 void Map::setMaze(const Maze *maze) {
-  ASSERT_TR(m_mouseGraphic == nullptr);
   m_maze = maze;
-  m_view = nullptr;
+  m_renderer.setMaze(maze);
+  markFrameDirty();
+}
+
+void Map::setView(MazeView *view) {
+  m_renderer.setView(view);
+  markFrameDirty();
+}
+
+void Map::setOtherViews(const QVector<MazeView *> &views) {
+  m_renderer.setOtherViews(views);
+  markFrameDirty();
 }
 
-void Map::setView(const MazeView *view) {
-  if (view != nullptr) {
-    ASSERT_FA(m_maze == nullptr);
+void Map::setMouseGraphics(
+    const QVector<const MouseGraphic *> &mouseGraphics) {
+  m_renderer.setMouseGraphics(mouseGraphics);
+  markFrameDirty();
+}
+
+void Map::refreshMouseGraphics() {
+  m_renderer.refreshMouseGraphics();
+  markFrameDirty();
+}
+
+void Map::setVisitCounts(VisitCounts *visitCounts) {
+  m_renderer.setVisitCounts(visitCounts);
+  markFrameDirty();
+}
+
+void Map::setHeatmapShown(bool shown) {
+  m_renderer.setHeatmapShown(shown);
+  markFrameDirty();
+}
+
+bool Map::isHeatmapShown() const { return m_renderer.isHeatmapShown(); }
+
+void Map::markFrameDirty() {
+  // Updates are throttled to the display's refresh rate by Qt
+  m_isFrameDirty = true;
+  if (!m_isSuspended) {
+    update();
   }
-  m_view = view;
 }
 
-void Map::setMouseGraphic(const MouseGraphic *mouseGraphic) {
-  if (mouseGraphic != nullptr) {
-    ASSERT_FA(m_maze == nullptr);
-    ASSERT_FA(m_view == nullptr);
+void Map::setSuspended(bool suspended) {
+  // Whatever changed while suspended is drawn in a single frame on resuming
+  m_isSuspended = suspended;
+  if (!m_isSuspended && isFrameDirty()) {
+    update();
   }
-  m_mouseGraphic = mouseGraphic;
 }
 
+bool Map::isFrameDirty() const {
+  // Moving mice are drawn a little behind the simulation, so they're drawn
+  // again until they catch up, even if nothing else changes
+  return m_isFrameDirty || m_renderer.isViewDirty() ||
+         m_renderer.areMiceCatchingUp();
+}
+
+void Map::setFrameOverlayShown(bool shown) {
+  m_isFrameOverlayShown = shown;
+  refreshTimingEnabled();
+  markFrameDirty();
+}
+
+bool Map::isFrameOverlayShown() const { return m_isFrameOverlayShown; }
+
+void Map::setRenderScaleAdaptive(bool adaptive) {
+  // Back at full resolution, the offscreen framebuffer is freed by the next
+  // frame, while the context is current
+  m_isRenderScaleAdaptive = adaptive;
+  m_renderScale = 1.0;
+  m_framesSinceRescale = 0;
+  refreshTimingEnabled();
+  markFrameDirty();
+}
+
+bool Map::isRenderScaleAdaptive() const { return m_isRenderScaleAdaptive; }
+
+void Map::setFollowingMouse(bool following) {
+  m_renderer.getCamera()->setFollowing(following);
+  markFrameDirty();
+}
+
+bool Map::isFollowingMouse() const {
+  return m_renderer.getCamera()->isFollowing();
+}
+
+void Map::setEditing(bool editing) { m_isEditing = editing; }
+
+bool Map::isEditing() const { return m_isEditing; }
+
 QStringList Map::getOpenGLVersionInfo() {
   static QStringList info;
   if (info.empty()) {
     QString glType = context()->isOpenGLES() ? "OpenGL ES" : "OpenGL";
-    QString glVersion = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    QString glVersion = reinterpret_cast<const char *>(
+        context()->functions()->glGetString(GL_VERSION));
     QString glProfile;
     switch (format().profile()) {
       case QSurfaceFormat::NoProfile:
@@ -69,12 +174,23 @@ QStringList Map::getOpenGLVersionInfo() {
 
 void Map::shutdown() {
   makeCurrent();
+  delete m_scaledFramebuffer;
+  m_scaledFramebuffer = nullptr;
   m_openGLLogger.stopLogging();
 }
 
 void Map::initOpenGLLogger() {
   if (m_openGLLogger.initialize()) {
-    m_openGLLogger.startLogging(QOpenGLDebugLogger::SynchronousLogging);
+    // Synchronous logging stalls the pipeline on every call, but gives the
+    // call that caused each message, so it's only used if requested
+    connect(&m_openGLLogger, &QOpenGLDebugLogger::messageLogged, this,
+            [](const QOpenGLDebugMessage &message) {
+              qWarning().noquote() << message.message();
+            });
+    m_openGLLogger.startLogging(
+        qEnvironmentVariable("MMS_GL_DEBUG") == "sync"
+            ? QOpenGLDebugLogger::SynchronousLogging
+            : QOpenGLDebugLogger::AsynchronousLogging);
     m_openGLLogger.enableMessages();
     m_openGLLogger.disableMessages(QOpenGLDebugMessage::AnySource,
                                    QOpenGLDebugMessage::AnyType,
@@ -84,62 +200,179 @@ void Map::initOpenGLLogger() {
 
 void Map::initializeGL() {
   // Contains all initialization that requires an OpenGL context
-
-  // First, initialize the logger
   initOpenGLLogger();
+  m_renderer.initialize();
+  m_canScaleRender = QOpenGLFramebufferObject::hasOpenGLFramebufferBlit();
+}
 
-  // Make it possible to call gl functions directly
-  initializeOpenGLFunctions();
-
-  // Set some gl values
-  glClearColor(0.0, 0.0, 0.0, 1.0);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glEnable(GL_BLEND);
+void Map::paintGL() {
+  // One sample per frame
+  PROFILE_SCOPE("Map::paintGL");
+  AllocationCounter counter;
+  m_isFrameDirty = false;
+  int pixelWidth = qRound(m_windowWidth * devicePixelRatioF());
+  int pixelHeight = qRound(m_windowHeight * devicePixelRatioF());
+  if (m_renderScale < 1.0 && 0 < pixelWidth && 0 < pixelHeight) {
+    renderScaled(pixelWidth, pixelHeight);
+  } else {
+    delete m_scaledFramebuffer;
+    m_scaledFramebuffer = nullptr;
+    m_renderer.render(m_windowWidth, m_windowHeight, devicePixelRatioF());
+  }
+  updateRenderScale();
+  m_frameAllocations = counter.getAllocations();
+  m_frameBytes = counter.getBytes();
+  if (m_isFrameOverlayShown) {
+    drawFrameOverlay();
+  }
+}
 
-  // Initialize the polygon and texture programs
-  initPolygonProgram();
-  initTextureProgram();
+void Map::renderScaled(int pixelWidth, int pixelHeight) {
+  // The renderer lays out its viewports in device pixels, so rendering at a
+  // smaller device pixel ratio fills exactly the smaller framebuffer
+  QSize size(qMax(1, qRound(pixelWidth * m_renderScale)),
+             qMax(1, qRound(pixelHeight * m_renderScale)));
+  if (m_scaledFramebuffer == nullptr || m_scaledFramebuffer->size() != size) {
+    delete m_scaledFramebuffer;
+    m_scaledFramebuffer = new QOpenGLFramebufferObject(size);
+  }
+  m_scaledFramebuffer->bind();
+  m_renderer.render(m_windowWidth, m_windowHeight,
+                    devicePixelRatioF() * size.width() / pixelWidth);
+
+  // Upscale onto the widget's own framebuffer, which is left bound, e.g.,
+  // for the overlay
+  QOpenGLExtraFunctions *functions = context()->extraFunctions();
+  functions->glBindFramebuffer(GL_READ_FRAMEBUFFER,
+                               m_scaledFramebuffer->handle());
+  functions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER,
+                               defaultFramebufferObject());
+  functions->glBlitFramebuffer(0, 0, size.width(), size.height(), 0, 0,
+                               pixelWidth, pixelHeight, GL_COLOR_BUFFER_BIT,
+                               GL_LINEAR);
+  functions->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
 }
 
-void Map::paintGL() {
-  // TODO: upforgrabs
-  // Optimize this code
-  //
-  // QElapsedTimer timer;
-  // timer.start();
-
-  // If the view hasn't been set yet, just draw black
-  if (m_view == nullptr) {
-    glClear(GL_COLOR_BUFFER_BIT);
+void Map::updateRenderScale() {
+  if (!m_isRenderScaleAdaptive || !m_canScaleRender) {
     return;
   }
-
-  QVector<TriangleGraphic> mouseBuffer;
-  if (m_mouseGraphic != nullptr) {
-    mouseBuffer = m_mouseGraphic->draw();
+  m_framesSinceRescale += 1;
+  const FrameTimer *timer = m_renderer.getFrameTimer();
+  if (m_framesSinceRescale < RENDER_SCALE_INTERVAL_FRAMES || timer == nullptr) {
+    return;
+  }
+  QVector<FrameTimer::Sample> samples = timer->getSamples();
+  if (samples.isEmpty()) {
+    return;
   }
 
-  // Re-populate both vertex buffer objects
-  repopulateVertexBufferObjects(mouseBuffer);
+  // The GPU's time is what the scale changes, if it's known
+  const FrameTimer::Sample &sample = samples.last();
+  double milliseconds = sample.cpuTotalMilliseconds;
+  if (sample.hasGpu) {
+    milliseconds = 0.0;
+    for (int i = 0; i < FrameTimer::NUM_PHASES; i += 1) {
+      milliseconds += sample.gpuMilliseconds[i];
+    }
+  }
+  double scale = m_renderScale;
+  if (FRAME_BUDGET_MILLISECONDS < milliseconds) {
+    scale = qMax(MIN_RENDER_SCALE, scale * RENDER_SCALE_STEP);
+  } else if (milliseconds < 0.5 * FRAME_BUDGET_MILLISECONDS) {
+    scale = qMin(1.0, scale / RENDER_SCALE_STEP);
+  }
+  if (scale != m_renderScale) {
+    m_renderScale = scale;
+    m_framesSinceRescale = 0;
+    markFrameDirty();
+  }
+}
 
-  // Draw the tiles
-  drawMap(&m_polygonProgram, &m_polygonVAO, 0,
-          3 * m_view->getGraphicCpuBuffer()->size());
+void Map::refreshTimingEnabled() {
+  // The adaptive scale is driven by the frame times
+  m_renderer.setTimingEnabled(m_isFrameOverlayShown ||
+                              m_isRenderScaleAdaptive);
+}
 
-  // Overlay the tile text
-  if (m_textureAtlas != nullptr) {
-    drawMap(&m_textureProgram, &m_textureVAO, 0,
-            3 * m_view->getTextureCpuBuffer()->size());
+void Map::drawFrameOverlay() {
+  const FrameTimer *timer = m_renderer.getFrameTimer();
+  if (timer == nullptr) {
+    return;
+  }
+  QVector<FrameTimer::Sample> samples = timer->getSamples();
+  if (samples.isEmpty()) {
+    return;
   }
 
-  // Draw the mouse
-  drawMap(&m_polygonProgram, &m_polygonVAO,
-          3 * m_view->getGraphicCpuBuffer()->size(), 3 * mouseBuffer.size());
-
-  // TODO: upforgrabs
-  // Optimize this code
-  //
-  // qDebug() << timer.nsecsElapsed();
+  // Each frame is a pair of bars, CPU then GPU, scaled so that the budget is
+  // half of the height of the graph
+  const int barWidth = 2;
+  const int graphHeight = 80;
+  const int margin = 6;
+  double pixelsPerMillisecond = 0.5 * graphHeight / FRAME_BUDGET_MILLISECONDS;
+  int graphWidth = FrameTimer::MAX_SAMPLES * 2 * barWidth;
+  QPainter painter(this);
+  int lineHeight = painter.fontMetrics().height();
+  painter.fillRect(margin, margin, graphWidth + 2 * margin,
+                   graphHeight + 4 * margin + 4 * lineHeight,
+                   QColor(0, 0, 0, 192));
+  int bottom = 2 * margin + graphHeight;
+  for (int i = 0; i < samples.size(); i += 1) {
+    const FrameTimer::Sample &sample = samples.at(i);
+    double gpu = 0.0;
+    for (int phase = 0; phase < FrameTimer::NUM_PHASES; phase += 1) {
+      gpu += sample.gpuMilliseconds[phase];
+    }
+    int x = 2 * margin + 2 * barWidth * i;
+    int cpuHeight = qMin(graphHeight, qRound(sample.cpuTotalMilliseconds *
+                                             pixelsPerMillisecond));
+    painter.fillRect(x, bottom - cpuHeight, barWidth, cpuHeight,
+                     QColor(80, 200, 80));
+    if (sample.hasGpu) {
+      int gpuHeight = qMin(graphHeight, qRound(gpu * pixelsPerMillisecond));
+      painter.fillRect(x + barWidth, bottom - gpuHeight, barWidth, gpuHeight,
+                       QColor(240, 160, 40));
+    }
+  }
+  int budget =
+      bottom - qRound(FRAME_BUDGET_MILLISECONDS * pixelsPerMillisecond);
+  painter.setPen(QColor(220, 60, 60));
+  painter.drawLine(2 * margin, budget, 2 * margin + graphWidth, budget);
+
+  // The times of each phase of the latest frame
+  const FrameTimer::Sample &last = samples.last();
+  QStringList cpu;
+  QStringList gpu;
+  for (int i = 0; i < FrameTimer::NUM_PHASES; i += 1) {
+    FrameTimer::Phase phase = static_cast<FrameTimer::Phase>(i);
+    cpu.append(QString("%1 %2")
+                   .arg(FrameTimer::getPhaseName(phase))
+                   .arg(last.cpuMilliseconds[i], 0, 'f', 2));
+    gpu.append(QString("%1 %2")
+                   .arg(FrameTimer::getPhaseName(phase))
+                   .arg(last.gpuMilliseconds[i], 0, 'f', 2));
+  }
+  int y = bottom + margin + painter.fontMetrics().ascent();
+  painter.setPen(Qt::white);
+  painter.drawText(2 * margin, y,
+                   QString("CPU %1 ms: %2")
+                       .arg(last.cpuTotalMilliseconds, 0, 'f', 2)
+                       .arg(cpu.join(", ")));
+  painter.drawText(2 * margin, y + lineHeight,
+                   last.hasGpu ? QString("GPU ms: %1").arg(gpu.join(", "))
+                               : QString("GPU: no timer queries"));
+  painter.drawText(2 * margin, y + 2 * lineHeight,
+                   QString("budget %1 ms (red), CPU (green), GPU (orange), "
+                           "scale %2%")
+                       .arg(FRAME_BUDGET_MILLISECONDS, 0, 'f', 1)
+                       .arg(qRound(100 * m_renderScale)));
+  painter.drawText(2 * margin, y + 3 * lineHeight,
+                   AllocationCounter::isEnabled()
+                       ? QString("frame: %1 allocations, %2 bytes")
+                             .arg(m_frameAllocations)
+                             .arg(m_frameBytes)
+                       : QString("allocations: not counted in this build"));
 }
 
 void Map::resizeGL(int width, int height) {
@@ -147,175 +380,96 @@ void Map::resizeGL(int width, int height) {
   m_windowHeight = height;
 }
 
-void Map::initPolygonProgram() {
-  m_polygonProgram.addShaderFromSourceCode(QOpenGLShader::Vertex,
-                                           R"(
-            uniform mat4 transformationMatrix;
-            attribute vec2 coordinate;
-            attribute vec4 inColor;
-            varying vec4 outColor;
-            void main(void) {
-                gl_Position = transformationMatrix * vec4(coordinate, 0.0, 1.0);
-                outColor = inColor;
-            }
-        )");
-  m_polygonProgram.addShaderFromSourceCode(QOpenGLShader::Fragment,
-                                           R"(
-            varying vec4 outColor;
-            void main(void) {
-               gl_FragColor = outColor;
-            }
-        )");
-  m_polygonProgram.link();
-  m_polygonProgram.bind();
-
-  m_polygonVAO.create();
-  m_polygonVAO.bind();
-
-  m_polygonVBO.create();
-  m_polygonVBO.bind();
-  m_polygonVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
-
-  m_polygonProgram.enableAttributeArray("coordinate");
-  m_polygonProgram.setAttributeBuffer(
-      "coordinate",  // name
-      GL_FLOAT,      // type
-      0,             // offset (bytes)
-      2,             // tupleSize (number of elements in the attribute array)
-      2 * sizeof(float) +
-          4 * sizeof(unsigned char)  // stride (bytes between vertices)
-  );
-
-  m_polygonProgram.enableAttributeArray("inColor");
-  m_polygonProgram.setAttributeBuffer(
-      "inColor",          // name
-      GL_UNSIGNED_BYTE,   // type
-      2 * sizeof(float),  // offset (bytes)
-      4,  // tupleSize (number of elements in the attribute array)
-      2 * sizeof(float) +
-          4 * sizeof(unsigned char)  // stride (bytes between vertices)
-  );
-
-  m_polygonVBO.release();
-  m_polygonVAO.release();
-  m_polygonProgram.release();
-}
-
-void Map::initTextureProgram() {
-  m_textureProgram.addShaderFromSourceCode(QOpenGLShader::Vertex,
-                                           R"(
-            uniform mat4 transformationMatrix;
-            attribute vec2 coordinate;
-            attribute vec2 inTextureCoordinate;
-            varying vec2 outTextureCoordinate;
-            void main() {
-                gl_Position = transformationMatrix * vec4(coordinate, 0.0, 1.0);
-                outTextureCoordinate = inTextureCoordinate;
-            }
-        )");
-  m_textureProgram.addShaderFromSourceCode(QOpenGLShader::Fragment,
-                                           R"(
-            uniform sampler2D texture;
-            varying vec2 outTextureCoordinate;
-            void main() {
-                gl_FragColor = texture2D(texture, outTextureCoordinate);
-            }
-        )");
-  m_textureProgram.link();
-  m_textureProgram.bind();
-
-  m_textureVAO.create();
-  m_textureVAO.bind();
-
-  m_textureVBO.create();
-  m_textureVBO.bind();
-  m_textureVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
-
-  m_textureProgram.enableAttributeArray("coordinate");
-  m_textureProgram.setAttributeBuffer(
-      "coordinate",  // name
-      GL_FLOAT,      // type
-      0,             // offset (bytes)
-      2,             // tupleSize (number of elements in the attribute array)
-      4 * sizeof(float)  // stride (bytes between vertices)
-  );
-
-  m_textureProgram.enableAttributeArray("inTextureCoordinate");
-  m_textureProgram.setAttributeBuffer(
-      "inTextureCoordinate",  // name
-      GL_FLOAT,               // type
-      2 * sizeof(float),      // offset (bytes)
-      2,  // tupleSize (number of elements in the attribute array)
-      4 * sizeof(float)  // stride (bytes between vertices)
-  );
-
-  // Load the bitmap texture into the texture atlas
-  if (QFile::exists(FontImage::path())) {
-    m_textureAtlas = new QOpenGLTexture(QImage(FontImage::path()).mirrored());
-  } else {
-    qWarning() << "Font image file does not exist:" << FontImage::path();
-  }
+void Map::mousePressEvent(QMouseEvent *event) {
+  m_dragPosition = event->position();
+  m_pressPosition = event->position();
+}
 
-  m_polygonVBO.release();
-  m_polygonVAO.release();
-  m_polygonProgram.release();
-}
-
-void Map::repopulateVertexBufferObjects(
-    const QVector<TriangleGraphic> &mouseBuffer) {
-  // Overwrite the polygon vertex buffer object data
-  m_polygonVBO.bind();
-  m_polygonVBO.allocate(
-      sizeof(TriangleGraphic) *
-      (m_view->getGraphicCpuBuffer()->size() + mouseBuffer.size()));
-  // Write the maze
-  m_polygonVBO.write(
-      0, &(m_view->getGraphicCpuBuffer()->front()),
-      sizeof(TriangleGraphic) * m_view->getGraphicCpuBuffer()->size());
-  // Write the mouse
-  if (!mouseBuffer.isEmpty()) {
-    m_polygonVBO.write(
-        sizeof(TriangleGraphic) * m_view->getGraphicCpuBuffer()->size(),
-        &(mouseBuffer.front()), sizeof(TriangleGraphic) * mouseBuffer.size());
+void Map::mouseMoveEvent(QMouseEvent *event) {
+  if (!(event->buttons() & Qt::LeftButton)) {
+    return;
   }
-  m_polygonVBO.release();
-
-  // Overwrite the texture vertex buffer object data
-  m_textureVBO.bind();
-  m_textureVBO.allocate(
-      &(m_view->getTextureCpuBuffer()->front()),
-      sizeof(TriangleTexture) * m_view->getTextureCpuBuffer()->size());
-  m_textureVBO.release();
-}
-
-void Map::drawMap(QOpenGLShaderProgram *program, QOpenGLVertexArrayObject *vao,
-                  int vboStartingIndex, int count) {
-  // Start using the program and vertex array object
-  program->bind();
-  vao->bind();
-
-  // If it's the texture program, bind the texture and set the uniform
-  if (program == &m_textureProgram) {
-    glActiveTexture(GL_TEXTURE0);
-    m_textureAtlas->bind();
-    program->setUniformValue("texture", 0);
+  // Dragging takes the camera away from the mouse, if it was following it
+  QPointF size = getViewSize();
+  QPointF offset = event->position() - m_dragPosition;
+  m_dragPosition = event->position();
+  Camera *camera = m_renderer.getCamera();
+  camera->setFollowing(false);
+  camera->pan(QPointF(offset.x() / size.x(), -offset.y() / size.y()));
+  markFrameDirty();
+}
+
+void Map::mouseReleaseEvent(QMouseEvent *event) {
+  if (!m_isEditing || m_maze == nullptr ||
+      event->button() != Qt::LeftButton ||
+      QApplication::startDragDistance() <=
+          (event->position() - m_pressPosition).manhattanLength()) {
+    return;
   }
 
-  // TODO: upforgrabs
-  // This should be QTransform
-  QMatrix4x4 transformationMatrix = TransformationMatrix::get(
-      m_maze->getWidth(), m_maze->getHeight(), m_windowWidth, m_windowHeight);
+  // Every cell of the map shows the same maze
+  QPointF size = getViewSize();
+  QPointF fitted = m_renderer.getCamera()->toFitted(
+      getCameraPoint(event->position()));
+  QPointF meters = TransformationMatrix::getMeters(
+      m_maze->getWidth(), m_maze->getHeight(), static_cast<int>(size.x()),
+      static_cast<int>(size.y()), fitted);
+  double tiles = Dimensions::tileLength().getMeters();
+  double tileX = meters.x() / tiles;
+  double tileY = meters.y() / tiles;
+  int x = static_cast<int>(std::floor(tileX));
+  int y = static_cast<int>(std::floor(tileY));
+  if (x < 0 || y < 0 || m_maze->getWidth() <= x ||
+      m_maze->getHeight() <= y) {
+    return;
+  }
 
-  program->setUniformValue("transformationMatrix", transformationMatrix);
-  glDrawArrays(GL_TRIANGLES, vboStartingIndex, count);
+  // The wall whose edge of the tile is nearest the cursor
+  double fractionX = tileX - x;
+  double fractionY = tileY - y;
+  Direction direction = Direction::NORTH;
+  double nearest = 1.0 - fractionY;
+  if (1.0 - fractionX < nearest) {
+    direction = Direction::EAST;
+    nearest = 1.0 - fractionX;
+  }
+  if (fractionY < nearest) {
+    direction = Direction::SOUTH;
+    nearest = fractionY;
+  }
+  if (fractionX < nearest) {
+    direction = Direction::WEST;
+  }
+  emit wallClicked(x, y, direction);
+}
 
-  // If it's the texture program, we should additionally unbind the texture
-  if (program == &m_textureProgram) {
-    m_textureAtlas->release();
+void Map::mouseDoubleClickEvent(QMouseEvent *event) {
+  Q_UNUSED(event);
+  if (m_isEditing) {
+    return;
   }
+  m_renderer.getCamera()->reset();
+  markFrameDirty();
+}
+
+void Map::wheelEvent(QWheelEvent *event) {
+  // A notch of the wheel is 120 units, and zooms by a quarter
+  double factor = std::pow(1.25, event->angleDelta().y() / 120.0);
+  m_renderer.getCamera()->zoomAt(getCameraPoint(event->position()), factor);
+  markFrameDirty();
+}
+
+QPointF Map::getViewSize() const {
+  // The same as the cells of the map in MapRenderer::render
+  QPair<int, int> grid = MapRenderer::getGridSize(m_renderer.getNumViews());
+  return QPointF(qMax(1, m_windowWidth / grid.first),
+                 qMax(1, m_windowHeight / grid.second));
+}
 
-  // Stop using the program and vertex array object
-  vao->release();
+QPointF Map::getCameraPoint(QPointF position) const {
+  QPointF size = getViewSize();
+  return QPointF(std::fmod(position.x(), size.x()) / size.x(),
+                 1.0 - std::fmod(position.y(), size.y()) / size.y());
 }
 
 }  // namespace mms
@@ -1,82 +1,151 @@
 #pragma once
 
-#include <QOpenGLBuffer>
+#include <QMouseEvent>
 #include <QOpenGLDebugLogger>
-#include <QOpenGLFunctions>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLTexture>
-#include <QOpenGLVertexArrayObject>
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLWidget>
+#include <QPointF>
+#include <QStringList>
 #include <QVector>
+#include <QWheelEvent>
 
+#include "Direction.h"
+#include "MapRenderer.h"
 #include "Maze.h"
 #include "MazeView.h"
 #include "MouseGraphic.h"
-#include "TriangleGraphic.h"
+#include "VisitCounts.h"
 
 namespace mms {
 
-class Map : public QOpenGLWidget, protected QOpenGLFunctions {
-  // NOTE: Inheriting from QOpenGLFunctions allows
-  // us to call the OpenGL functions directly
-
+// The Map is the widget that shows the maze; all of the drawing is done by
+// its MapRenderer, into the widget's framebuffer
+class Map : public QOpenGLWidget {
   Q_OBJECT
 
  public:
   Map(QWidget *parent = 0);
 
+  // See MapRenderer
   void setMaze(const Maze *maze);
-  void setView(const MazeView *view);
-  void setMouseGraphic(const MouseGraphic *mouseGraphic);
+  void setView(MazeView *view);
+  void setOtherViews(const QVector<MazeView *> &views);
+  void setMouseGraphics(const QVector<const MouseGraphic *> &mouseGraphics);
+  void refreshMouseGraphics();
+  void setVisitCounts(VisitCounts *visitCounts);
+  void setHeatmapShown(bool shown);
+  bool isHeatmapShown() const;
+
+  // Frames are only drawn if the view or the mouse changed since the last
+  // frame. Changes must be reported via markFrameDirty(), which schedules a
+  // frame for the next vertical refresh; many changes within a single refresh
+  // result in just one frame.
+  void markFrameDirty();
+  bool isFrameDirty() const;
+
+  // While suspended, e.g., while the window is minimized, changes are only
+  // noted, and no frames are drawn until the map is resumed
+  void setSuspended(bool suspended);
+
+  // If shown, the CPU and GPU times of recent frames are graphed over the
+  // map, against the budget of a 60 Hz display, along with the times of each
+  // phase of the last frame (see FrameTimer)
+  void setFrameOverlayShown(bool shown);
+  bool isFrameOverlayShown() const;
+
+  // If adaptive, the map is rendered offscreen at a fraction of the widget's
+  // device pixels, and upscaled onto it, and the fraction is lowered while
+  // frames take longer than the budget and raised again once they're cheap,
+  // e.g., for an integrated GPU driving a HiDPI display, where filling the
+  // blended walls is most of the frame. Off by default, in which case the
+  // map is always rendered at full resolution, as it also is if the context
+  // can't blit framebuffers (OpenGL 3.0, or OpenGL ES 3.0).
+  void setRenderScaleAdaptive(bool adaptive);
+  bool isRenderScaleAdaptive() const;
+
+  // The map can be zoomed with the scroll wheel, around the cursor, and
+  // panned by dragging it; double-clicking shows the whole maze again. If
+  // following, it's instead kept centered on the first mouse (see Camera).
+  void setFollowingMouse(bool following);
+  bool isFollowingMouse() const;
+
+  // While editing, clicking the map (rather than dragging it) emits the wall
+  // nearest the cursor, e.g., for the window to toggle it, and a double click
+  // is just two clicks rather than a reset of the camera
+  void setEditing(bool editing);
+  bool isEditing() const;
 
   // Retrieves OpenGL version info
   QStringList getOpenGLVersionInfo();
 
   void shutdown();
 
+ signals:
+  void wallClicked(int x, int y, Direction direction);
+
  protected:
   void initializeGL();
   void paintGL();
   void resizeGL(int width, int height);
+  void mousePressEvent(QMouseEvent *event);
+  void mouseMoveEvent(QMouseEvent *event);
+  void mouseReleaseEvent(QMouseEvent *event);
+  void mouseDoubleClickEvent(QMouseEvent *event);
+  void wheelEvent(QWheelEvent *event);
 
  private:
   // Logger of OpenGL warnings and errors
   QOpenGLDebugLogger m_openGLLogger;
   void initOpenGLLogger();
 
-  // TODO: upforgrabs
-  // m_maze shouldn't be necessary,
-  // MazeView should actually be MazeGraphic
-
-  // No ownership here - only pointers
-  const Maze *m_maze;
-  const MazeView *m_view;
-  const MouseGraphic *m_mouseGraphic;
+  MapRenderer m_renderer;
+
+  // Whether something other than the view changed since the last frame
+  bool m_isFrameDirty;
+  bool m_isSuspended;
+
+  static const double FRAME_BUDGET_MILLISECONDS;
+  bool m_isFrameOverlayShown;
+  void drawFrameOverlay();
+
+  // Of the latest frame, not including the overlay, if they're counted (see
+  // AllocationCounter)
+  qint64 m_frameAllocations;
+  qint64 m_frameBytes;
+
+  // The scale is only changed every so often, by a step at a time, once the
+  // frames being timed were drawn at the current scale; it's raised only
+  // once a frame takes well under half of the budget, which is the cost of a
+  // step up, so that it doesn't go back and forth
+  static const double MIN_RENDER_SCALE;
+  static const double RENDER_SCALE_STEP;
+  static const int RENDER_SCALE_INTERVAL_FRAMES;
+  bool m_canScaleRender;
+  bool m_isRenderScaleAdaptive;
+  double m_renderScale;
+  int m_framesSinceRescale;
+  QOpenGLFramebufferObject *m_scaledFramebuffer;  // null unless scaled
+  void renderScaled(int pixelWidth, int pixelHeight);
+  void updateRenderScale();
+  void refreshTimingEnabled();
 
   // The map's window size, in pixels
   int m_windowWidth;
   int m_windowHeight;
 
-  // Polygon program variables
-  QOpenGLShaderProgram m_polygonProgram;
-  QOpenGLVertexArrayObject m_polygonVAO;
-  QOpenGLBuffer m_polygonVBO;
-
-  // Texture program variables
-  QOpenGLTexture *m_textureAtlas;
-  QOpenGLShaderProgram m_textureProgram;
-  QOpenGLVertexArrayObject m_textureVAO;
-  QOpenGLBuffer m_textureVBO;
-
-  // Initialize the graphics
-  void initPolygonProgram();
-  void initTextureProgram();
-
-  // Drawing helper methods
-  void repopulateVertexBufferObjects(
-      const QVector<TriangleGraphic> &mouseBuffer);
-  void drawMap(QOpenGLShaderProgram *program, QOpenGLVertexArrayObject *vao,
-               int vboStartingIndex, int count);
+  // Where the cursor was when the drag last moved the map, in pixels
+  QPointF m_dragPosition;
+
+  // The maze that clicks are on, and where the cursor was pressed, so that
+  // clicks can be told from drags
+  const Maze *m_maze;
+  bool m_isEditing;
+  QPointF m_pressPosition;
+
+  // The size of each half of the map, and the corresponding point of the
+  // camera, for a position in the widget, whose origin is at its upper left
+  QPointF getViewSize() const;
+  QPointF getCameraPoint(QPointF position) const;
 };
 
 }  // namespace mms
@@ -0,0 +1,1462 @@
+#include "MapRenderer.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include <QDebug>
+#include <QFile>
+#include <QImage>
+#include <QOpenGLContext>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector2D>
+
+#include "AssertMacros.h"
+#include "Dimensions.h"
+#include "FontImage.h"
+#include "Profiler.h"
+#include "SimUtilities.h"
+#include "TilePalette.h"
+#include "TransformationMatrix.h"
+
+namespace mms {
+
+const int MapRenderer::MAX_VIEWS = 9;
+const int MapRenderer::CHUNK_COLUMNS = 32;
+const int MapRenderer::MAX_RESIDENT_CHUNKS = 16;
+const double MapRenderer::MIN_PIXELS_PER_TILE_FOR_CORNERS = 8.0;
+const double MapRenderer::MIN_PIXELS_PER_TILE_FOR_TEXT = 16.0;
+const GLuint MapRenderer::TRANSFORM_BINDING = 0;
+const GLuint MapRenderer::PALETTE_BINDING = 1;
+const int MapRenderer::COORDINATE_LOCATION = 0;
+const int MapRenderer::COLOR_LOCATION = 1;
+const int MapRenderer::STATE_COORDINATE_LOCATION = 1;
+const int MapRenderer::TEXTURE_U_LOCATION = 1;
+const int MapRenderer::TEXTURE_V_LOCATION = 2;
+
+MapRenderer::MapRenderer()
+    : m_maze(nullptr),
+      m_mouseGraphics(QVector<const MouseGraphic *>()),
+      m_viewBuffers(QVector<ViewBuffers *>()),
+      m_mainBuffers(nullptr),
+      m_numViews(1),
+      m_chunks(QVector<Chunk *>()),
+      m_numResidentChunks(0),
+      m_frameNumber(0),
+      m_isGeometryUploaded(false),
+      m_isMouseUploaded(false),
+      m_frameTimestamp(0.0),
+      m_isCoreProfile(false),
+      m_transformUBO(0),
+      m_paletteUBO(0),
+      m_palette(QVector<QVector4D>()),
+      m_resources(nullptr),
+      m_polygonProgram(nullptr),
+      m_polygonUniforms({-1, -1, -1, -1, -1}),
+      m_useTileStateTexture(false),
+      m_tileStateProgram(nullptr),
+      m_tileStateUniforms({-1, -1, -1, -1, -1}),
+      m_textureAtlas(nullptr),
+      m_textureProgram(nullptr),
+      m_textureUniforms({-1, -1, -1, -1, -1}),
+      m_visitCounts(nullptr),
+      m_isHeatmapShown(false),
+      m_isHeatmapUploaded(false),
+      m_heatmapProgram(nullptr),
+      m_heatmapUniforms({-1, -1, -1, -1, -1}),
+      m_heatmapTexture(nullptr),
+      m_isTimingEnabled(false),
+      m_frameTimer(nullptr) {
+  for (int i = 0; i < MAX_VIEWS; i += 1) {
+    ViewBuffers *buffers = new ViewBuffers();
+    buffers->view = nullptr;
+    buffers->isUploaded = false;
+    buffers->tileStateTexture = nullptr;
+    buffers->textureVBOSize = 0;
+    m_viewBuffers.append(buffers);
+  }
+  m_mainBuffers = m_viewBuffers.first();
+}
+
+MapRenderer::~MapRenderer() {
+  // The uniform buffers aren't wrapped, so they're deleted here, if the
+  // context is still current
+  if (m_transformUBO != 0 && QOpenGLContext::currentContext() != nullptr) {
+    glDeleteBuffers(1, &m_transformUBO);
+    glDeleteBuffers(1, &m_paletteUBO);
+  }
+  if (m_resources != nullptr) {
+    MapResources::release(m_resources);
+  }
+  delete m_frameTimer;
+  for (ViewBuffers *buffers : m_viewBuffers) {
+    qDeleteAll(buffers->chunks);
+  }
+  qDeleteAll(m_viewBuffers);
+  qDeleteAll(m_chunks);
+}
+
+void MapRenderer::setMaze(const Maze *maze) {
+  ASSERT_TR(m_mouseGraphics.isEmpty());
+  m_maze = maze;
+  for (ViewBuffers *buffers : m_viewBuffers) {
+    buffers->view = nullptr;
+  }
+  m_numViews = 1;
+}
+
+void MapRenderer::setView(MazeView *view) {
+  if (view != nullptr) {
+    ASSERT_FA(m_maze == nullptr);
+  }
+  for (int i = 1; i < m_numViews; i += 1) {
+    MazeView *other = m_viewBuffers.at(i)->view;
+    ASSERT_FA(view == nullptr);
+    ASSERT_FA(view == other);
+    ASSERT_TR(view->getGeometry() == other->getGeometry());
+  }
+  m_mainBuffers->view = view;
+  m_mainBuffers->isUploaded = false;
+  m_isGeometryUploaded = false;
+}
+
+void MapRenderer::setOtherViews(const QVector<MazeView *> &views) {
+  // Each view's snapshots have a single reader, which uploads what changed
+  // since the snapshot it read before, so the same view can't be uploaded
+  // twice
+  ASSERT_LT(views.size(), MAX_VIEWS);
+  for (int i = 0; i < views.size(); i += 1) {
+    MazeView *view = views.at(i);
+    ASSERT_FA(m_mainBuffers->view == nullptr);
+    ASSERT_FA(view == nullptr);
+    ASSERT_FA(view == m_mainBuffers->view);
+    ASSERT_TR(view->getGeometry() == m_mainBuffers->view->getGeometry());
+    for (int j = 0; j < i; j += 1) {
+      ASSERT_FA(view == views.at(j));
+    }
+  }
+  for (int i = 1; i < MAX_VIEWS; i += 1) {
+    ViewBuffers *buffers = m_viewBuffers.at(i);
+    MazeView *view = i <= views.size() ? views.at(i - 1) : nullptr;
+    if (buffers->view != view) {
+      buffers->view = view;
+      buffers->isUploaded = false;
+    }
+  }
+  m_numViews = 1 + views.size();
+}
+
+int MapRenderer::getNumViews() const { return m_numViews; }
+
+QPair<int, int> MapRenderer::getGridSize(int numViews) {
+  int columns = 1;
+  while (columns * columns < numViews) {
+    columns += 1;
+  }
+  int rows = (numViews + columns - 1) / columns;
+  return {columns, rows};
+}
+
+qint64 MapRenderer::getGpuMemoryBytes(const MazeView *view,
+                                      bool isMainView) {
+  // Text is a byte of v coordinate and three floats per vertex, while the
+  // tile state texture is RGBA8
+  qint64 polygonSize = view->getGraphicCpuBuffer()->size();
+  QPair<int, int> stateSize = view->getTileGraphicStateTextureSize();
+  qint64 bytes =
+      sizeof(VertexColor) * polygonSize +
+      4 * static_cast<qint64>(stateSize.first) * stateSize.second +
+      3 * (sizeof(unsigned char) + 3 * sizeof(float)) *
+          static_cast<qint64>(view->getTextureCpuBuffer()->size()) +
+      sizeof(VertexGraphic) *
+          static_cast<qint64>(view->getPathCpuBuffer()->size());
+  if (isMainView) {
+    bytes += sizeof(unsigned int) * view->getGraphicIndexBuffer()->size() +
+             2 * sizeof(float) * polygonSize +
+             sizeof(float) * view->getGraphicStateCoordinateBuffer()->size();
+  }
+  return bytes;
+}
+
+void MapRenderer::setMouseGraphics(
+    const QVector<const MouseGraphic *> &mouseGraphics) {
+  if (!mouseGraphics.isEmpty()) {
+    ASSERT_FA(m_maze == nullptr);
+    ASSERT_FA(m_mainBuffers->view == nullptr);
+  }
+  m_mouseGraphics = mouseGraphics;
+  m_isMouseUploaded = false;
+}
+
+void MapRenderer::refreshMouseGraphics() { m_isMouseUploaded = false; }
+
+void MapRenderer::setVisitCounts(VisitCounts *visitCounts) {
+  if (visitCounts != nullptr) {
+    ASSERT_FA(m_maze == nullptr);
+    ASSERT_EQ(visitCounts->getWidth(), m_maze->getWidth());
+    ASSERT_EQ(visitCounts->getHeight(), m_maze->getHeight());
+  }
+  m_visitCounts = visitCounts;
+  m_isHeatmapUploaded = false;
+}
+
+void MapRenderer::setHeatmapShown(bool shown) { m_isHeatmapShown = shown; }
+
+bool MapRenderer::isHeatmapShown() const { return m_isHeatmapShown; }
+
+bool MapRenderer::isViewDirty() const {
+  for (const ViewBuffers *buffers : m_viewBuffers) {
+    if (buffers->view != nullptr && buffers->view->isDirty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MapRenderer::areMiceCatchingUp() const {
+  for (const MouseGraphic *mouseGraphic : m_mouseGraphics) {
+    if (mouseGraphic->isCatchingUp(m_frameTimestamp)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Camera *MapRenderer::getCamera() { return &m_camera; }
+
+const Camera *MapRenderer::getCamera() const { return &m_camera; }
+
+void MapRenderer::initialize() {
+  PROFILE_SCOPE("MapRenderer::initialize");
+
+  // Make it possible to call gl functions directly
+  initializeOpenGLFunctions();
+
+  // Uniform buffers, and the core dialect of GLSL, need OpenGL 3.3 or
+  // OpenGL ES 3.0; a compatibility profile of 3.3 or later supports both
+  QOpenGLContext *context = QOpenGLContext::currentContext();
+  QPair<int, int> version = context->format().version();
+  m_isCoreProfile = context->isOpenGLES() ? version >= qMakePair(3, 0)
+                                          : version >= qMakePair(3, 3);
+  if (m_isCoreProfile) {
+    glGenBuffers(1, &m_transformUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_transformUBO);
+    glBufferData(GL_UNIFORM_BUFFER, 16 * sizeof(float), nullptr,
+                 GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, TRANSFORM_BINDING, m_transformUBO);
+    glGenBuffers(1, &m_paletteUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_paletteUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(QVector4D) * TilePalette::size(),
+                 nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, PALETTE_BINDING, m_paletteUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  // Set some gl values
+  glClearColor(0.0, 0.0, 0.0, 1.0);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEnable(GL_BLEND);
+
+  // Initialize the polygon and texture programs, and the VAOs of each view,
+  // apart from those of the chunks, which are made as they're uploaded;
+  // the shaders are cacheable, so after the first launch their linked
+  // binaries are loaded from Qt's shader cache rather than compiled, and
+  // they're only linked by the first renderer of the share group
+  ASSERT_TR(m_resources == nullptr);
+  m_resources = MapResources::acquire();
+  m_polygonProgram = &m_resources->polygonProgram;
+  m_tileStateProgram = &m_resources->tileStateProgram;
+  m_textureProgram = &m_resources->textureProgram;
+  m_heatmapProgram = &m_resources->heatmapProgram;
+  initPolygonProgram();
+  initTextureProgram();
+  initHeatmapProgram();
+  for (ViewBuffers *buffers : m_viewBuffers) {
+    initTextureVAO(buffers);
+    initPathVAO(buffers);
+  }
+  initMouseVAO();
+
+  // Tile colors are sampled from the tile state texture, unless the vertex
+  // shader can't read textures, in which case each vertex has its own color
+  GLint maxVertexTextureImageUnits = 0;
+  glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &maxVertexTextureImageUnits);
+  m_useTileStateTexture =
+      0 < maxVertexTextureImageUnits && initTileStateProgram();
+  m_resources->isInitialized = true;
+}
+
+void MapRenderer::render(int width, int height, qreal devicePixelRatio) {
+  // If the view hasn't been set yet, just draw black
+  glClear(GL_COLOR_BUFFER_BIT);
+  if (m_mainBuffers->view == nullptr) {
+    return;
+  }
+  m_frameTimestamp = SimUtilities::getHighResTimestamp();
+
+  // The theme is looked up once per frame, so it's never stale
+  m_palette = TilePalette::getColors();
+  if (m_isCoreProfile) {
+    writeUniformBuffer(m_paletteUBO, m_palette.constData(),
+                       sizeof(QVector4D) * m_palette.size());
+  }
+
+  // The mice aren't indexed, so just flatten their triangles into vertices
+  if (!m_isMouseUploaded) {
+    m_mouseBuffer.clear();
+    m_mouseBufferStarts.clear();
+    for (const MouseGraphic *mouseGraphic : m_mouseGraphics) {
+      m_mouseBufferStarts.append(m_mouseBuffer.size());
+      for (const TriangleGraphic &triangle : mouseGraphic->draw()) {
+        m_mouseBuffer.append(triangle.p1);
+        m_mouseBuffer.append(triangle.p2);
+        m_mouseBuffer.append(triangle.p3);
+      }
+    }
+    m_mouseBufferStarts.append(m_mouseBuffer.size());
+  }
+
+  // The buffer objects are repopulated once the visible columns are known
+  if (m_isTimingEnabled) {
+    if (m_frameTimer == nullptr) {
+      m_frameTimer = new FrameTimer();
+    }
+    m_frameTimer->beginFrame();
+  }
+
+  // Each view gets a cell of the map, and is drawn with the same shared
+  // geometry, just with a different viewport and transformation matrix; the
+  // cells don't overlap, so it's a draw per view rather than one instanced
+  // draw, which would need every view's tile states in a single texture.
+  // Every cell shows the same columns, so only their chunks are uploaded.
+  QPair<int, int> grid = getGridSize(m_numViews);
+  int viewWidth = width / grid.first;
+  int viewHeight = height / grid.second;
+  int mazeWidth = m_maze->getWidth();
+  int mazeHeight = m_maze->getHeight();
+  if (m_camera.isFollowing() && !m_mouseGraphics.isEmpty()) {
+    Coordinate translation =
+        m_mouseGraphics.first()->getDrawnTranslation(m_frameTimestamp);
+    m_camera.centerOn(TransformationMatrix::getMapPoint(
+        mazeWidth, mazeHeight, viewWidth, viewHeight,
+        QPointF(translation.getX().getMeters(),
+                translation.getY().getMeters())));
+  }
+  QPair<int, int> columns = getVisibleColumns(viewWidth, viewHeight);
+  beginPhase(FrameTimer::UPLOAD);
+  repopulateVertexBufferObjects(getChunks(columns));
+  if (m_isHeatmapShown && m_visitCounts != nullptr) {
+    writeVisitCounts();
+  }
+  endPhase();
+
+  // The cells are laid out in device pixels, so that they meet exactly and
+  // fill the framebuffer at any device pixel ratio, e.g., 1.5, or with an
+  // odd width, rather than leave a seam where the sizes were truncated; the
+  // first row is at the top, while the viewport's origin is at the bottom
+  int pixelWidth = qRound(width * devicePixelRatio);
+  int pixelHeight = qRound(height * devicePixelRatio);
+  for (int i = 0; i < m_numViews; i += 1) {
+    int column = i % grid.first;
+    int row = grid.second - 1 - i / grid.first;
+    int left = pixelWidth * column / grid.first;
+    int right = pixelWidth * (column + 1) / grid.first;
+    int bottom = pixelHeight * row / grid.second;
+    int top = pixelHeight * (row + 1) / grid.second;
+    glViewport(left, bottom, right - left, top - bottom);
+    m_transformationMatrix =
+        m_camera.getMatrix() * TransformationMatrix::get(mazeWidth, mazeHeight,
+                                                         viewWidth, viewHeight);
+    if (m_isCoreProfile) {
+      writeUniformBuffer(m_transformUBO, m_transformationMatrix.constData(),
+                         16 * sizeof(float));
+    }
+
+    // When tiles are only a few pixels across, the corners and the text are
+    // smaller than a pixel, so skip them rather than rasterize noise
+    double pixelsPerTile =
+        m_camera.getZoom() * TransformationMatrix::getPixelsPerTile(
+                                 mazeWidth, mazeHeight, viewWidth, viewHeight);
+    drawView(m_viewBuffers.at(i), columns,
+             MIN_PIXELS_PER_TILE_FOR_CORNERS <= pixelsPerTile,
+             MIN_PIXELS_PER_TILE_FOR_TEXT <= pixelsPerTile);
+  }
+  if (m_isTimingEnabled) {
+    m_frameTimer->endFrame();
+  }
+}
+
+void MapRenderer::setTimingEnabled(bool enabled) {
+  m_isTimingEnabled = enabled;
+}
+
+const FrameTimer *MapRenderer::getFrameTimer() const { return m_frameTimer; }
+
+void MapRenderer::beginPhase(FrameTimer::Phase phase) {
+  if (m_isTimingEnabled) {
+    m_frameTimer->beginPhase(phase);
+  }
+}
+
+void MapRenderer::endPhase() {
+  if (m_isTimingEnabled) {
+    m_frameTimer->endPhase();
+  }
+}
+
+QPair<int, int> MapRenderer::getVisibleColumns(int viewWidth,
+                                               int viewHeight) const {
+  // The left and right edges of the view, in meters
+  int mazeWidth = m_maze->getWidth();
+  int mazeHeight = m_maze->getHeight();
+  double left = TransformationMatrix::getMeters(
+                    mazeWidth, mazeHeight, viewWidth, viewHeight,
+                    m_camera.toFitted(QPointF(0.0, 0.0)))
+                    .x();
+  double right = TransformationMatrix::getMeters(
+                     mazeWidth, mazeHeight, viewWidth, viewHeight,
+                     m_camera.toFitted(QPointF(1.0, 1.0)))
+                     .x();
+
+  // The walls and corners of a column stick out by half of a wall on either
+  // side, so take one more column on each side rather than clip them
+  double tileLength = Dimensions::tileLength().getMeters();
+  int first = static_cast<int>(std::floor(left / tileLength)) - 1;
+  int last = static_cast<int>(std::floor(right / tileLength)) + 2;
+  return {qBound(0, first, mazeWidth), qBound(0, last, mazeWidth)};
+}
+
+QPair<int, int> MapRenderer::getChunks(QPair<int, int> columns) const {
+  if (columns.second <= columns.first) {
+    return {0, 0};
+  }
+  return {columns.first / CHUNK_COLUMNS,
+          (columns.second + CHUNK_COLUMNS - 1) / CHUNK_COLUMNS};
+}
+
+void MapRenderer::drawView(ViewBuffers *buffers, QPair<int, int> columns,
+                           bool isCornersDrawn, bool isTextDrawn) {
+  // Draw the tiles of the visible columns, which are a range of the bases, a
+  // range of the walls, and a range of the corners of each of their chunks
+  // (see MazeGeometry). Walls and corners are drawn over the bases of the
+  // tiles on either side of them, which may be in the next chunk, so each
+  // kind of polygon is drawn for every chunk before the next kind is.
+  beginPhase(FrameTimer::TILES);
+  QSharedPointer<MazeGeometry> geometry = buffers->view->getGeometry();
+  QVector<const QVector<int> *> sections = {&geometry->baseColumnStarts,
+                                            &geometry->wallColumnStarts};
+  if (isCornersDrawn) {
+    sections.append(&geometry->cornerColumnStarts);
+  }
+  QPair<int, int> chunks = getChunks(columns);
+  for (int i = 0; i < sections.size(); i += 1) {
+    const QVector<int> *starts = sections.at(i);
+    for (int j = chunks.first; j < chunks.second; j += 1) {
+      Chunk *chunk = m_chunks.at(j);
+      int first = qMax(columns.first, chunk->firstColumn);
+      int last = qMin(columns.second, chunk->lastColumn);
+      int count = starts->at(last) - starts->at(first);
+      if (count == 0) {
+        continue;
+      }
+      int sectionStart =
+          i == 0 ? 0 : (i == 1 ? chunk->wallStart : chunk->cornerStart);
+      int start =
+          sectionStart + starts->at(first) - starts->at(chunk->firstColumn);
+      if (m_useTileStateTexture) {
+        drawMap(m_tileStateProgram, &chunk->vao, buffers->tileStateTexture,
+                GL_TRIANGLES, start, count, true, QMatrix4x4());
+      } else {
+        drawMap(m_polygonProgram, &buffers->chunks.at(j)->polygonVAO,
+                nullptr, GL_TRIANGLES, start, count, true, QMatrix4x4());
+      }
+    }
+  }
+
+  // Overlay the heatmap on the tiles, beneath their text, in a single draw
+  // call over the whole maze, since the camera clips the rest anyway
+  if (m_isHeatmapShown && m_visitCounts != nullptr) {
+    drawMap(m_heatmapProgram, &m_heatmapVAO, m_heatmapTexture,
+            GL_TRIANGLE_STRIP, 0, 4, false, QMatrix4x4());
+  }
+  endPhase();
+
+  // Overlay the text of the visible columns, which only has triangles for
+  // the tiles that have had text, in the same order as the polygons
+  const MazeViewSnapshot &snapshot = buffers->view->getSnapshot();
+  int textStart = snapshot.textureColumnStarts.at(columns.first);
+  int textEnd = snapshot.textureColumnStarts.at(columns.second);
+  if (m_textureAtlas != nullptr && isTextDrawn && textStart < textEnd) {
+    beginPhase(FrameTimer::TEXT);
+    drawMap(m_textureProgram, &buffers->textureVAO, m_textureAtlas,
+            GL_TRIANGLES, 3 * textStart, 3 * (textEnd - textStart), false,
+            QMatrix4x4());
+    endPhase();
+  }
+
+  // Overlay the path, in a single draw call
+  int pathSize = snapshot.pathCpuBuffer.size();
+  if (1 < pathSize) {
+    beginPhase(FrameTimer::PATH);
+    drawMap(m_polygonProgram, &buffers->pathVAO, nullptr, GL_LINE_STRIP, 0,
+            pathSize, false, QMatrix4x4());
+    endPhase();
+  }
+
+  // Draw the mice, each moved from its initial position to its current one
+  beginPhase(FrameTimer::MICE);
+  for (int i = 0; i < m_mouseGraphics.size(); i += 1) {
+    int start = m_mouseBufferStarts.at(i);
+    drawMap(m_polygonProgram, &m_mouseVAO, nullptr, GL_TRIANGLES, start,
+            m_mouseBufferStarts.at(i + 1) - start, false,
+            m_mouseGraphics.at(i)->getModelMatrix(m_frameTimestamp));
+  }
+  endPhase();
+}
+
+void MapRenderer::initPolygonProgram() {
+  // The colors of the vertices are a palette index and an alpha
+  linkProgram(m_polygonProgram, R"(
+            TRANSFORM_UNIFORMS
+            PALETTE_UNIFORMS
+            uniform mat4 modelMatrix;
+            ATTRIBUTE vec2 coordinate;
+            ATTRIBUTE vec2 inColor;
+            VARYING vec4 outColor;
+            void main(void) {
+                gl_Position = transformationMatrix * modelMatrix *
+                              vec4(coordinate, 0.0, 1.0);
+                vec4 color = palette[int(inColor.x * 255.0 + 0.5)];
+                outColor = vec4(color.rgb, color.a * inColor.y);
+            }
+        )",
+              R"(
+            VARYING vec4 outColor;
+            void main(void) {
+               FRAG_COLOR = outColor;
+            }
+        )",
+              {{"coordinate", COORDINATE_LOCATION},
+               {"inColor", COLOR_LOCATION}},
+              nullptr, &m_polygonUniforms);
+}
+
+bool MapRenderer::initTileStateProgram() {
+  // The tile states are indices into the palette, which holds the theme
+  QString vertexShader = R"(
+            TRANSFORM_UNIFORMS
+            PALETTE_UNIFORMS
+            uniform sampler2D tileStates;
+            ATTRIBUTE vec2 coordinate;
+            ATTRIBUTE vec2 inStateCoordinate;
+            VARYING vec4 outColor;
+            void main(void) {
+                gl_Position = transformationMatrix * vec4(coordinate, 0.0, 1.0);
+                vec4 state =
+                    TEXTURE_2D_LOD(tileStates, inStateCoordinate, 0.0);
+                vec4 color = palette[int(state.r * 255.0 + 0.5)];
+                outColor = vec4(color.rgb, color.a * state.a);
+            }
+        )";
+  QString fragmentShader = R"(
+            VARYING vec4 outColor;
+            void main(void) {
+               FRAG_COLOR = outColor;
+            }
+        )";
+  // Each chunk's VAO binds its attributes (see makeResident)
+  return linkProgram(m_tileStateProgram, vertexShader, fragmentShader,
+                     {{"coordinate", COORDINATE_LOCATION},
+                      {"inStateCoordinate", STATE_COORDINATE_LOCATION}},
+                     "tileStates", &m_tileStateUniforms);
+}
+
+void MapRenderer::initTextureProgram() {
+  linkProgram(m_textureProgram, R"(
+            TRANSFORM_UNIFORMS
+            ATTRIBUTE vec2 coordinate;
+            ATTRIBUTE float inTextureU;
+            ATTRIBUTE float inTextureV;
+            VARYING vec2 outTextureCoordinate;
+            void main() {
+                gl_Position = transformationMatrix * vec4(coordinate, 0.0, 1.0);
+                outTextureCoordinate = vec2(inTextureU, inTextureV);
+            }
+        )",
+              R"(
+            uniform sampler2D atlas;
+            VARYING vec2 outTextureCoordinate;
+            void main() {
+                // The alpha is a distance field (see FontImage), in which one
+                // texel is about a sixth; blend across roughly a texel
+                vec4 color = TEXTURE_2D(atlas, outTextureCoordinate);
+                float alpha = smoothstep(0.42, 0.58, color.a);
+                FRAG_COLOR = vec4(color.rgb, alpha);
+            }
+        )",
+              {{"coordinate", COORDINATE_LOCATION},
+               {"inTextureU", TEXTURE_U_LOCATION},
+               {"inTextureV", TEXTURE_V_LOCATION}},
+              "atlas", &m_textureUniforms);
+  if (m_resources->isInitialized) {
+    m_textureAtlas = m_resources->textureAtlas;
+    return;
+  }
+
+  // Load the font distance field into the texture atlas, with mipmaps so text
+  // stays smooth when tiles are small. Glyphs are side by side, so only the
+  // levels in which every glyph is still a whole number of texels are used;
+  // beyond that, neighboring glyphs would bleed into each other.
+  if (QFile::exists(FontImage::path())) {
+    QImage image = FontImage::loadDistanceField();
+    int glyphWidth = image.width() / FontImage::characters().size();
+    int glyphHeight = image.height();
+    int maxLevel = 0;
+    while (0 < glyphWidth && glyphWidth % 2 == 0 && glyphHeight % 2 == 0) {
+      glyphWidth /= 2;
+      glyphHeight /= 2;
+      maxLevel += 1;
+    }
+    m_textureAtlas =
+        new QOpenGLTexture(image, QOpenGLTexture::GenerateMipMaps);
+    m_textureAtlas->setMipMaxLevel(maxLevel);
+    m_textureAtlas->setMinMagFilters(QOpenGLTexture::LinearMipMapLinear,
+                                     QOpenGLTexture::Linear);
+    m_textureAtlas->setWrapMode(QOpenGLTexture::ClampToEdge);
+    m_resources->textureAtlas = m_textureAtlas;
+  } else {
+    qWarning() << "Font image file does not exist:" << FontImage::path();
+  }
+}
+
+void MapRenderer::initHeatmapProgram() {
+  // The texture holds a column of tiles in each row, like the tile state
+  // texture, so it's sampled with the coordinates swapped; the texels are
+  // sampled exactly, so each tile is a single flat color
+  linkProgram(m_heatmapProgram, R"(
+            TRANSFORM_UNIFORMS
+            uniform vec2 mazeSize;
+            ATTRIBUTE vec2 coordinate;
+            VARYING vec2 outVisitsCoordinate;
+            void main() {
+                gl_Position = transformationMatrix * vec4(coordinate, 0.0, 1.0);
+                outVisitsCoordinate = coordinate.yx / mazeSize.yx;
+            }
+        )",
+              R"(
+            uniform sampler2D visits;
+            uniform float maxVisits;
+            VARYING vec2 outVisitsCoordinate;
+            void main() {
+                // Each count is split into a low and a high byte, and tiles
+                // that were never visited are left alone
+                vec4 texel = TEXTURE_2D(visits, outVisitsCoordinate);
+                float count = 255.0 * texel.r + 65280.0 * texel.g;
+                if (count < 0.5) {
+                    discard;
+                }
+                float heat = count / maxVisits;
+                vec3 cold = vec3(0.2, 0.4, 1.0);
+                vec3 hot = vec3(1.0, 0.2, 0.1);
+                FRAG_COLOR = vec4(mix(cold, hot, heat), 0.25 + 0.35 * heat);
+            }
+        )",
+              {{"coordinate", COORDINATE_LOCATION}}, "visits",
+              &m_heatmapUniforms);
+  m_heatmapProgram->bind();
+
+  m_heatmapVAO.create();
+  m_heatmapVAO.bind();
+  m_heatmapVBO.create();
+  m_heatmapVBO.bind();
+  m_heatmapVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+  m_heatmapProgram->enableAttributeArray(COORDINATE_LOCATION);
+  m_heatmapProgram->setAttributeBuffer(
+      COORDINATE_LOCATION,  // location
+      GL_FLOAT,             // type
+      0,                    // offset (bytes)
+      2,  // tupleSize (number of elements in the attribute array)
+      2 * sizeof(float)  // stride (bytes between vertices)
+  );
+
+  m_heatmapVBO.release();
+  m_heatmapVAO.release();
+  m_heatmapProgram->release();
+}
+
+void MapRenderer::initTextureVAO(ViewBuffers *buffers) {
+  m_textureProgram->bind();
+  buffers->textureVAO.create();
+  buffers->textureVAO.bind();
+
+  // Texture v-coordinates never change, but the positions and u-coordinates
+  // do change whenever tile text is updated
+  buffers->textureStaticVBO.create();
+  buffers->textureStaticVBO.bind();
+  buffers->textureStaticVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+  // Each v-coordinate is either 0 or 1, so a normalized byte is exact
+  m_textureProgram->enableAttributeArray(TEXTURE_V_LOCATION);
+  m_textureProgram->setAttributeBuffer(
+      TEXTURE_V_LOCATION,  // location
+      GL_UNSIGNED_BYTE,    // type
+      0,                   // offset (bytes)
+      1,  // tupleSize (number of elements in the attribute array)
+      1 * sizeof(unsigned char)  // stride (bytes between vertices)
+  );
+
+  buffers->textureDynamicVBO.create();
+  buffers->textureDynamicVBO.bind();
+  buffers->textureDynamicVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+
+  m_textureProgram->enableAttributeArray(COORDINATE_LOCATION);
+  m_textureProgram->setAttributeBuffer(
+      COORDINATE_LOCATION,  // location
+      GL_FLOAT,             // type
+      0,                    // offset (bytes)
+      2,  // tupleSize (number of elements in the attribute array)
+      3 * sizeof(float)  // stride (bytes between vertices)
+  );
+
+  m_textureProgram->enableAttributeArray(TEXTURE_U_LOCATION);
+  m_textureProgram->setAttributeBuffer(
+      TEXTURE_U_LOCATION,  // location
+      GL_FLOAT,            // type
+      2 * sizeof(float),   // offset (bytes)
+      1,  // tupleSize (number of elements in the attribute array)
+      3 * sizeof(float)  // stride (bytes between vertices)
+  );
+
+  buffers->textureDynamicVBO.release();
+  buffers->textureVAO.release();
+  m_textureProgram->release();
+}
+
+void MapRenderer::initPathVAO(ViewBuffers *buffers) {
+  m_polygonProgram->bind();
+  buffers->pathVAO.create();
+  buffers->pathVAO.bind();
+
+  // The path is rewritten whole whenever it changes, and is small enough that
+  // its vertices are uploaded as they are, positions and colors interleaved
+  buffers->pathVBO.create();
+  buffers->pathVBO.bind();
+  buffers->pathVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+
+  m_polygonProgram->enableAttributeArray(COORDINATE_LOCATION);
+  m_polygonProgram->setAttributeBuffer(
+      COORDINATE_LOCATION,         // location
+      GL_FLOAT,                    // type
+      offsetof(VertexGraphic, x),  // offset (bytes)
+      2,                           // tupleSize
+      sizeof(VertexGraphic)        // stride (bytes between vertices)
+  );
+  m_polygonProgram->enableAttributeArray(COLOR_LOCATION);
+  m_polygonProgram->setAttributeBuffer(
+      COLOR_LOCATION,                         // location
+      GL_UNSIGNED_BYTE,                       // type
+      offsetof(VertexGraphic, paletteIndex),  // offset (bytes)
+      2,                      // tupleSize (palette index and alpha)
+      sizeof(VertexGraphic)   // stride (bytes between vertices)
+  );
+
+  buffers->pathVBO.release();
+  buffers->pathVAO.release();
+  m_polygonProgram->release();
+}
+
+void MapRenderer::initMouseVAO() {
+  m_polygonProgram->bind();
+  m_mouseVAO.create();
+  m_mouseVAO.bind();
+
+  // Like the path, the mice are uploaded as they are, since they're only
+  // written when they change, and are drawn moved by their model matrices
+  m_mouseVBO.create();
+  m_mouseVBO.bind();
+  m_mouseVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+  m_polygonProgram->enableAttributeArray(COORDINATE_LOCATION);
+  m_polygonProgram->setAttributeBuffer(
+      COORDINATE_LOCATION,         // location
+      GL_FLOAT,                    // type
+      offsetof(VertexGraphic, x),  // offset (bytes)
+      2,                           // tupleSize
+      sizeof(VertexGraphic)        // stride (bytes between vertices)
+  );
+  m_polygonProgram->enableAttributeArray(COLOR_LOCATION);
+  m_polygonProgram->setAttributeBuffer(
+      COLOR_LOCATION,                         // location
+      GL_UNSIGNED_BYTE,                       // type
+      offsetof(VertexGraphic, paletteIndex),  // offset (bytes)
+      2,                      // tupleSize (palette index and alpha)
+      sizeof(VertexGraphic)   // stride (bytes between vertices)
+  );
+
+  m_mouseVBO.release();
+  m_mouseVAO.release();
+  m_polygonProgram->release();
+}
+
+bool MapRenderer::linkProgram(
+    QOpenGLShaderProgram *program, QString vertexShader,
+    QString fragmentShader,
+    const QVector<QPair<const char *, int>> &attributes, const char *sampler,
+    Uniforms *uniforms) {
+  if (m_resources->isInitialized) {
+    getUniformLocations(program, uniforms);
+    return program->isLinked();
+  }
+
+  // The shared uniforms are blocks of their own in the core dialect, laid out
+  // as std140, which matches QMatrix4x4 and QVector4D arrays exactly
+  QString transformUniforms = "uniform mat4 transformationMatrix;";
+  QString paletteUniforms = "uniform vec4 palette[PALETTE_SIZE];";
+  if (m_isCoreProfile) {
+    transformUniforms = "layout(std140) uniform Transform {\n" +
+                        transformUniforms + "\n};";
+    paletteUniforms =
+        "layout(std140) uniform Palette {\n" + paletteUniforms + "\n};";
+  }
+  for (QString *shader : {&vertexShader, &fragmentShader}) {
+    shader->replace("TRANSFORM_UNIFORMS", transformUniforms);
+    shader->replace("PALETTE_UNIFORMS", paletteUniforms);
+    shader->replace("PALETTE_SIZE", QString::number(TilePalette::size()));
+  }
+  program->addCacheableShaderFromSourceCode(
+      QOpenGLShader::Vertex,
+      getShaderPreamble(QOpenGLShader::Vertex) + vertexShader);
+  program->addCacheableShaderFromSourceCode(
+      QOpenGLShader::Fragment,
+      getShaderPreamble(QOpenGLShader::Fragment) + fragmentShader);
+  for (const QPair<const char *, int> &attribute : attributes) {
+    program->bindAttributeLocation(attribute.first, attribute.second);
+  }
+  if (!program->link()) {
+    return false;
+  }
+
+  // Blocks that a program doesn't use aren't active, and aren't bound
+  if (m_isCoreProfile) {
+    GLuint id = program->programId();
+    GLuint transformIndex = glGetUniformBlockIndex(id, "Transform");
+    if (transformIndex != GL_INVALID_INDEX) {
+      glUniformBlockBinding(id, transformIndex, TRANSFORM_BINDING);
+    }
+    GLuint paletteIndex = glGetUniformBlockIndex(id, "Palette");
+    if (paletteIndex != GL_INVALID_INDEX) {
+      glUniformBlockBinding(id, paletteIndex, PALETTE_BINDING);
+    }
+  }
+  getUniformLocations(program, uniforms);
+  if (sampler != nullptr) {
+    program->bind();
+    program->setUniformValue(sampler, 0);
+    program->release();
+  }
+  return true;
+}
+
+void MapRenderer::getUniformLocations(const QOpenGLShaderProgram *program,
+                                      Uniforms *uniforms) {
+  uniforms->transformationMatrix =
+      program->uniformLocation("transformationMatrix");
+  uniforms->modelMatrix = program->uniformLocation("modelMatrix");
+  uniforms->palette = program->uniformLocation("palette");
+  uniforms->mazeSize = program->uniformLocation("mazeSize");
+  uniforms->maxVisits = program->uniformLocation("maxVisits");
+}
+
+QString MapRenderer::getShaderPreamble(QOpenGLShader::ShaderType type) const {
+  // Fragment shaders need a default precision on OpenGL ES; Qt inserts its
+  // own definitions after the version, if any
+  bool isES = QOpenGLContext::currentContext()->isOpenGLES();
+  QString preamble;
+  if (m_isCoreProfile) {
+    preamble = isES ? "#version 300 es\n" : "#version 330 core\n";
+    if (type == QOpenGLShader::Vertex) {
+      preamble += "#define ATTRIBUTE in\n"
+                  "#define VARYING out\n"
+                  "#define TEXTURE_2D_LOD textureLod\n";
+    } else {
+      preamble += isES ? "precision highp float;\n" : "";
+      preamble += "#define VARYING in\n"
+                  "#define TEXTURE_2D texture\n"
+                  "out vec4 fragColor;\n"
+                  "#define FRAG_COLOR fragColor\n";
+    }
+  } else {
+    if (type == QOpenGLShader::Vertex) {
+      preamble = "#define ATTRIBUTE attribute\n"
+                 "#define VARYING varying\n"
+                 "#define TEXTURE_2D_LOD texture2DLod\n";
+    } else {
+      preamble = isES ? "precision mediump float;\n" : "";
+      preamble += "#define VARYING varying\n"
+                  "#define TEXTURE_2D texture2D\n"
+                  "#define FRAG_COLOR gl_FragColor\n";
+    }
+  }
+  return preamble;
+}
+
+void MapRenderer::writeUniformBuffer(GLuint buffer, const void *data,
+                                     int size) {
+  // The buffers stay bound to their binding points, so only the binding for
+  // the write is changed
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+const MapRenderer::Uniforms &MapRenderer::getUniforms(
+    const QOpenGLShaderProgram *program) const {
+  return program == m_polygonProgram     ? m_polygonUniforms
+         : program == m_tileStateProgram ? m_tileStateUniforms
+         : program == m_textureProgram   ? m_textureUniforms
+                                         : m_heatmapUniforms;
+}
+
+void MapRenderer::repopulateVertexBufferObjects(QPair<int, int> chunks) {
+  PROFILE_SCOPE("MapRenderer::repopulateVertexBufferObjects");
+
+  // Whatever changed since the last frame is written to the cpu buffers once,
+  // however many times it changed, and published, since the views are
+  // modified on this thread; the chunks are laid out again whenever the main
+  // view changes, since the geometry may have
+  for (int i = 0; i < m_numViews; i += 1) {
+    m_viewBuffers.at(i)->view->publish();
+  }
+  if (!m_isGeometryUploaded) {
+    buildChunks();
+    m_isGeometryUploaded = true;
+  }
+
+  // The chunks that are drawn are used, along with those on either side of
+  // the first mouse, so that a camera that follows it seldom has to wait
+  // for a chunk to be uploaded; their geometry is uploaded first, since
+  // every view's colors of a chunk are drawn with it
+  m_frameNumber += 1;
+  QVector<int> usedChunks;
+  for (int i = chunks.first; i < chunks.second; i += 1) {
+    usedChunks.append(i);
+  }
+  if (!m_mouseGraphics.isEmpty()) {
+    double x = m_mouseGraphics.first()
+                   ->getDrawnTranslation(m_frameTimestamp)
+                   .getX()
+                   .getMeters();
+    int chunk = static_cast<int>(
+        x / Dimensions::tileLength().getMeters() / CHUNK_COLUMNS);
+    for (int i = chunk - 1; i <= chunk + 1; i += 1) {
+      if (0 <= i && i < m_chunks.size() && !usedChunks.contains(i)) {
+        usedChunks.append(i);
+      }
+    }
+  }
+  for (int i : usedChunks) {
+    Chunk *chunk = m_chunks.at(i);
+    if (!chunk->isResident) {
+      makeResident(chunk);
+    }
+    chunk->lastUsedFrame = m_frameNumber;
+  }
+  for (int i = 0; i < m_numViews; i += 1) {
+    repopulateViewBuffers(m_viewBuffers.at(i), usedChunks);
+  }
+  freeLeastRecentlyUsedChunks();
+
+  // The mice are written at their initial positions, and are moved by their
+  // model matrices instead of being rewritten every frame
+  if (!m_isMouseUploaded) {
+    m_mouseVBO.bind();
+    m_mouseVBO.allocate(m_mouseBuffer.constData(),
+                        sizeof(VertexGraphic) * m_mouseBuffer.size());
+    m_mouseVBO.release();
+  }
+  m_isMouseUploaded = true;
+}
+
+void MapRenderer::repopulateViewBuffers(ViewBuffers *buffers,
+                                        const QVector<int> &usedChunks) {
+  // Everything is drawn from the view's latest snapshot, which stays as it is
+  // until the next frame, however the view changes meanwhile
+  bool isNewSnapshot = buffers->view->acquireSnapshot();
+  const MazeViewSnapshot &snapshot = buffers->view->getSnapshot();
+  const QVector<VertexColor> *graphicCpuBuffer = &snapshot.graphicCpuBuffer;
+  const QVector<TriangleTexture> *textureCpuBuffer =
+      &snapshot.textureCpuBuffer;
+
+  // The buffers are only reallocated when the view changes; otherwise, just
+  // the dynamic attributes that changed are written, to the chunks that are
+  // resident. The colors of the maze are only needed if there's no tile
+  // state texture.
+  if (!buffers->isUploaded) {
+    for (ViewChunk *viewChunk : buffers->chunks) {
+      viewChunk->isUploaded = false;
+    }
+    if (m_useTileStateTexture) {
+      reallocateTileStateTexture(buffers);
+    }
+  } else if (!isNewSnapshot) {
+    // Nothing changed since the last frame
+  } else if (m_useTileStateTexture) {
+    writeTileStates(buffers);
+  } else {
+    for (const QPair<int, int> &range :
+         snapshot.graphicDirtyRanges.getRanges()) {
+      for (int i = 0; i < m_chunks.size(); i += 1) {
+        const Chunk *chunk = m_chunks.at(i);
+        ViewChunk *viewChunk = buffers->chunks.at(i);
+        int start = qMax(range.first, chunk->firstVertex);
+        int end = qMin(range.first + range.second,
+                       chunk->firstVertex + chunk->numVertices);
+        if (!viewChunk->isUploaded || end <= start) {
+          continue;
+        }
+        viewChunk->colorVBO.bind();
+        viewChunk->colorVBO.write(
+            sizeof(VertexColor) * (start - chunk->firstVertex),
+            graphicCpuBuffer->constData() + start,
+            sizeof(VertexColor) * (end - start));
+        viewChunk->colorVBO.release();
+      }
+    }
+  }
+  if (!m_useTileStateTexture) {
+    for (int i : usedChunks) {
+      if (!buffers->chunks.at(i)->isUploaded) {
+        uploadViewChunk(buffers, i);
+      }
+    }
+  }
+
+  // The texture buffer changes size if the tile text dimensions change, or
+  // when a tile is given text for the first time
+  int textureSize = textureCpuBuffer->size();
+  if (!buffers->isUploaded || buffers->textureVBOSize != textureSize) {
+    QVector<unsigned char> vCoordinates =
+        getTextureVCoordinates(textureCpuBuffer->constData(), textureSize);
+    buffers->textureStaticVBO.bind();
+    buffers->textureStaticVBO.allocate(
+        vCoordinates.constData(),
+        sizeof(unsigned char) * vCoordinates.size());
+    buffers->textureStaticVBO.release();
+
+    QVector<float> xyuCoordinates =
+        getTextureXYUCoordinates(textureCpuBuffer->constData(), textureSize);
+    buffers->textureDynamicVBO.bind();
+    buffers->textureDynamicVBO.allocate(
+        xyuCoordinates.constData(), sizeof(float) * xyuCoordinates.size());
+    buffers->textureDynamicVBO.release();
+
+    buffers->textureVBOSize = textureSize;
+  } else if (isNewSnapshot) {
+    buffers->textureDynamicVBO.bind();
+    for (const QPair<int, int> &range :
+         snapshot.textureDirtyRanges.getRanges()) {
+      QVector<float> xyuCoordinates = getTextureXYUCoordinates(
+          textureCpuBuffer->constData() + range.first, range.second);
+      buffers->textureDynamicVBO.write(3 * sizeof(float) * 3 * range.first,
+                                       xyuCoordinates.constData(),
+                                       sizeof(float) * xyuCoordinates.size());
+    }
+    buffers->textureDynamicVBO.release();
+  }
+
+  if (!buffers->isUploaded || (isNewSnapshot && snapshot.isPathDirty)) {
+    buffers->pathVBO.bind();
+    buffers->pathVBO.allocate(
+        snapshot.pathCpuBuffer.constData(),
+        sizeof(VertexGraphic) * snapshot.pathCpuBuffer.size());
+    buffers->pathVBO.release();
+  }
+
+  buffers->isUploaded = true;
+}
+
+void MapRenderer::buildChunks() {
+  for (int i = 0; i < m_chunks.size(); i += 1) {
+    if (m_chunks.at(i)->isResident) {
+      freeChunk(i);
+    }
+  }
+  for (ViewBuffers *buffers : m_viewBuffers) {
+    qDeleteAll(buffers->chunks);
+    buffers->chunks.clear();
+  }
+  qDeleteAll(m_chunks);
+  m_chunks.clear();
+
+  // Every column has the same number of polygons, including empty ones, so
+  // the vertices of a range of columns start with its first polygon
+  QSharedPointer<MazeGeometry> geometry = m_mainBuffers->view->getGeometry();
+  int width = geometry->mazeSize.first;
+  const QVector<int> &starts = geometry->polygonStartingVertices;
+  ASSERT_EQ((starts.size() - 1) % width, 0);
+  int polygonsPerColumn = (starts.size() - 1) / width;
+  for (int first = 0; first < width; first += CHUNK_COLUMNS) {
+    int last = qMin(width, first + CHUNK_COLUMNS);
+    Chunk *chunk = new Chunk();
+    chunk->firstColumn = first;
+    chunk->lastColumn = last;
+    chunk->firstVertex = starts.at(polygonsPerColumn * first);
+    chunk->numVertices =
+        starts.at(polygonsPerColumn * last) - chunk->firstVertex;
+    chunk->wallStart = geometry->baseColumnStarts.at(last) -
+                       geometry->baseColumnStarts.at(first);
+    chunk->cornerStart = chunk->wallStart +
+                         geometry->wallColumnStarts.at(last) -
+                         geometry->wallColumnStarts.at(first);
+    chunk->numIndices = chunk->cornerStart +
+                        geometry->cornerColumnStarts.at(last) -
+                        geometry->cornerColumnStarts.at(first);
+    chunk->isResident = false;
+    chunk->lastUsedFrame = 0;
+    chunk->ibo = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    m_chunks.append(chunk);
+    for (ViewBuffers *buffers : m_viewBuffers) {
+      ViewChunk *viewChunk = new ViewChunk();
+      viewChunk->isUploaded = false;
+      buffers->chunks.append(viewChunk);
+    }
+  }
+}
+
+void MapRenderer::makeResident(Chunk *chunk) {
+  // The indices are made relative to the chunk's first vertex, and the
+  // sections are put one after another
+  QSharedPointer<MazeGeometry> geometry = m_mainBuffers->view->getGeometry();
+  QVector<unsigned int> indices;
+  indices.reserve(chunk->numIndices);
+  for (const QVector<int> *starts :
+       {&geometry->baseColumnStarts, &geometry->wallColumnStarts,
+        &geometry->cornerColumnStarts}) {
+    for (int i = starts->at(chunk->firstColumn);
+         i < starts->at(chunk->lastColumn); i += 1) {
+      indices.append(geometry->indices.at(i) - chunk->firstVertex);
+    }
+  }
+  ASSERT_EQ(indices.size(), chunk->numIndices);
+
+  // The index buffer is part of the state of the VAO that it's bound by, so
+  // it's written while the chunk's VAO is bound, and stays bound to it
+  chunk->vao.create();
+  chunk->vao.bind();
+  chunk->ibo.create();
+  chunk->ibo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+  chunk->ibo.bind();
+  chunk->ibo.allocate(indices.constData(),
+                      sizeof(unsigned int) * indices.size());
+
+  // The positions are already laid out as the VBO expects, since they're
+  // shared with every other view of the maze rather than interleaved
+  chunk->positionVBO.create();
+  chunk->positionVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+  chunk->positionVBO.bind();
+  chunk->positionVBO.allocate(
+      geometry->positions.constData() + 2 * chunk->firstVertex,
+      2 * sizeof(float) * chunk->numVertices);
+  if (m_useTileStateTexture) {
+    m_tileStateProgram->bind();
+    m_tileStateProgram->enableAttributeArray(COORDINATE_LOCATION);
+    m_tileStateProgram->setAttributeBuffer(
+        COORDINATE_LOCATION,  // location
+        GL_FLOAT,             // type
+        0,                    // offset (bytes)
+        2,  // tupleSize (number of elements in the attribute array)
+        2 * sizeof(float)  // stride (bytes between vertices)
+    );
+
+    // The coordinates of each vertex's color in the tile state texture
+    chunk->stateCoordinateVBO.create();
+    chunk->stateCoordinateVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    chunk->stateCoordinateVBO.bind();
+    chunk->stateCoordinateVBO.allocate(
+        geometry->stateCoordinates.constData() + 2 * chunk->firstVertex,
+        2 * sizeof(float) * chunk->numVertices);
+    m_tileStateProgram->enableAttributeArray(STATE_COORDINATE_LOCATION);
+    m_tileStateProgram->setAttributeBuffer(
+        STATE_COORDINATE_LOCATION,  // location
+        GL_FLOAT,                   // type
+        0,                          // offset (bytes)
+        2,  // tupleSize (number of elements in the attribute array)
+        2 * sizeof(float)  // stride (bytes between vertices)
+    );
+    chunk->stateCoordinateVBO.release();
+    m_tileStateProgram->release();
+  } else {
+    chunk->positionVBO.release();
+  }
+  chunk->vao.release();
+  chunk->isResident = true;
+  m_numResidentChunks += 1;
+}
+
+void MapRenderer::uploadViewChunk(ViewBuffers *buffers, int chunkIndex) {
+  // The VAO is made the first time the view's colors of the chunk are
+  // uploaded; it draws from the chunk's index buffer and positions, which
+  // never change, and the view's vertex colors, which change all the time
+  Chunk *chunk = m_chunks.at(chunkIndex);
+  ViewChunk *viewChunk = buffers->chunks.at(chunkIndex);
+  ASSERT_TR(chunk->isResident);
+  if (!viewChunk->polygonVAO.isCreated()) {
+    m_polygonProgram->bind();
+    viewChunk->polygonVAO.create();
+    viewChunk->polygonVAO.bind();
+    chunk->ibo.bind();
+    chunk->positionVBO.bind();
+    m_polygonProgram->enableAttributeArray(COORDINATE_LOCATION);
+    m_polygonProgram->setAttributeBuffer(
+        COORDINATE_LOCATION,  // location
+        GL_FLOAT,             // type
+        0,                    // offset (bytes)
+        2,  // tupleSize (number of elements in the attribute array)
+        2 * sizeof(float)  // stride (bytes between vertices)
+    );
+
+    viewChunk->colorVBO.create();
+    viewChunk->colorVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    viewChunk->colorVBO.bind();
+    m_polygonProgram->enableAttributeArray(COLOR_LOCATION);
+    m_polygonProgram->setAttributeBuffer(
+        COLOR_LOCATION,    // location
+        GL_UNSIGNED_BYTE,  // type
+        0,                 // offset (bytes)
+        2,  // tupleSize (palette index and alpha)
+        2 * sizeof(unsigned char)  // stride (bytes between vertices)
+    );
+    viewChunk->colorVBO.release();
+    viewChunk->polygonVAO.release();
+    m_polygonProgram->release();
+  }
+  viewChunk->colorVBO.bind();
+  viewChunk->colorVBO.allocate(
+      buffers->view->getSnapshot().graphicCpuBuffer.constData() +
+          chunk->firstVertex,
+      sizeof(VertexColor) * chunk->numVertices);
+  viewChunk->colorVBO.release();
+  viewChunk->isUploaded = true;
+}
+
+void MapRenderer::freeChunk(int chunkIndex) {
+  Chunk *chunk = m_chunks.at(chunkIndex);
+  ASSERT_TR(chunk->isResident);
+  for (ViewBuffers *buffers : m_viewBuffers) {
+    ViewChunk *viewChunk = buffers->chunks.at(chunkIndex);
+    viewChunk->polygonVAO.destroy();
+    viewChunk->colorVBO.destroy();
+    viewChunk->isUploaded = false;
+  }
+  chunk->vao.destroy();
+  chunk->ibo.destroy();
+  chunk->positionVBO.destroy();
+  chunk->stateCoordinateVBO.destroy();
+  chunk->isResident = false;
+  m_numResidentChunks -= 1;
+}
+
+void MapRenderer::freeLeastRecentlyUsedChunks() {
+  // The chunks of this frame are never freed, however many there are, since
+  // they're about to be drawn
+  while (MAX_RESIDENT_CHUNKS < m_numResidentChunks) {
+    int oldest = -1;
+    for (int i = 0; i < m_chunks.size(); i += 1) {
+      const Chunk *chunk = m_chunks.at(i);
+      if (chunk->isResident && chunk->lastUsedFrame < m_frameNumber &&
+          (oldest == -1 ||
+           chunk->lastUsedFrame < m_chunks.at(oldest)->lastUsedFrame)) {
+        oldest = i;
+      }
+    }
+    if (oldest == -1) {
+      return;
+    }
+    freeChunk(oldest);
+  }
+}
+
+void MapRenderer::reallocateTileStateTexture(ViewBuffers *buffers) {
+  // One texel per color, sampled exactly, so there's no filtering
+  QPair<int, int> size = buffers->view->getTileGraphicStateTextureSize();
+  const QVector<TileGraphicState> *states =
+      &buffers->view->getSnapshot().tileGraphicStateBuffer;
+  delete buffers->tileStateTexture;
+  QOpenGLTexture *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+  texture->setSize(size.first, size.second);
+  texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+  texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+  texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+  texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+  texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+                   states->constData());
+  buffers->tileStateTexture = texture;
+}
+
+void MapRenderer::writeTileStates(ViewBuffers *buffers) {
+  // Each row of the texture holds a whole column of tiles, so a range of
+  // tiles may span multiple rows, each of which is written separately
+  const MazeViewSnapshot &snapshot = buffers->view->getSnapshot();
+  const QVector<TileGraphicState> *states = &snapshot.tileGraphicStateBuffer;
+  int tilesPerRow = buffers->view->getTileGraphicStateTextureSize().first / 6;
+  for (const QPair<int, int> &range :
+       snapshot.tileGraphicStateDirtyRanges.getRanges()) {
+    int tile = range.first;
+    int end = range.first + range.second;
+    while (tile < end) {
+      int row = tile / tilesPerRow;
+      int column = tile % tilesPerRow;
+      int count = qMin(end - tile, tilesPerRow - column);
+      buffers->tileStateTexture->setData(
+          6 * column, row, 0, 6 * count, 1, 1, QOpenGLTexture::RGBA,
+          QOpenGLTexture::UInt8, states->constData() + tile);
+      tile += count;
+    }
+  }
+}
+
+void MapRenderer::writeVisitCounts() {
+  // The texture and the corners of the maze are only reallocated when the
+  // counts change, otherwise just the tiles whose counts changed are written
+  int width = m_visitCounts->getWidth();
+  int height = m_visitCounts->getHeight();
+  if (!m_isHeatmapUploaded) {
+    delete m_heatmapTexture;
+    m_heatmapTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    m_heatmapTexture->setSize(height, width);
+    m_heatmapTexture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    m_heatmapTexture->setMinMagFilters(QOpenGLTexture::Nearest,
+                                       QOpenGLTexture::Nearest);
+    m_heatmapTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    m_heatmapTexture->allocateStorage(QOpenGLTexture::RGBA,
+                                      QOpenGLTexture::UInt8);
+    m_visitCounts->markAllDirty();
+
+    float right = width * Dimensions::tileLength().getMeters();
+    float top = height * Dimensions::tileLength().getMeters();
+    QVector<float> corners = {0.0, 0.0, right, 0.0, 0.0, top, right, top};
+    m_heatmapVBO.bind();
+    m_heatmapVBO.allocate(corners.constData(),
+                          sizeof(float) * corners.size());
+    m_heatmapVBO.release();
+    m_isHeatmapUploaded = true;
+  }
+
+  // As with the tile states, a range of tiles may span multiple rows; counts
+  // beyond what two bytes can hold are clamped
+  QVector<unsigned char> texels;
+  for (const QPair<int, int> &range :
+       m_visitCounts->getDirtyRanges().getRanges()) {
+    int tile = range.first;
+    int end = range.first + range.second;
+    while (tile < end) {
+      int row = tile / height;
+      int column = tile % height;
+      int count = qMin(end - tile, height - column);
+      texels.clear();
+      for (int y = column; y < column + count; y += 1) {
+        int visits = qMin(m_visitCounts->getTileVisits(row, y), 0xffff);
+        texels.append(static_cast<unsigned char>(visits & 0xff));
+        texels.append(static_cast<unsigned char>(visits >> 8));
+        texels.append(0);
+        texels.append(255);
+      }
+      m_heatmapTexture->setData(column, row, 0, count, 1, 1,
+                                QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+                                texels.constData());
+      tile += count;
+    }
+  }
+  m_visitCounts->clearDirtyRanges();
+}
+
+QVector<unsigned char> MapRenderer::getTextureVCoordinates(
+    const TriangleTexture *triangles, int count) {
+  QVector<unsigned char> vCoordinates;
+  vCoordinates.reserve(3 * count);
+  for (int i = 0; i < count; i += 1) {
+    for (const VertexTexture *vertex :
+         {&triangles[i].p1, &triangles[i].p2, &triangles[i].p3}) {
+      vCoordinates.append(vertex->v == 0.0 ? 0 : 255);
+    }
+  }
+  return vCoordinates;
+}
+
+QVector<float> MapRenderer::getTextureXYUCoordinates(
+    const TriangleTexture *triangles, int count) {
+  QVector<float> xyuCoordinates;
+  xyuCoordinates.reserve(3 * 3 * count);
+  for (int i = 0; i < count; i += 1) {
+    for (const VertexTexture *vertex :
+         {&triangles[i].p1, &triangles[i].p2, &triangles[i].p3}) {
+      xyuCoordinates.append(vertex->x);
+      xyuCoordinates.append(vertex->y);
+      xyuCoordinates.append(vertex->u);
+    }
+  }
+  return xyuCoordinates;
+}
+
+void MapRenderer::drawMap(QOpenGLShaderProgram *program,
+                          QOpenGLVertexArrayObject *vao,
+                          QOpenGLTexture *texture, GLenum mode,
+                          int startingIndex, int count, bool isIndexed,
+                          const QMatrix4x4 &modelMatrix) {
+  // Start using the program and vertex array object
+  program->bind();
+  vao->bind();
+
+  // If the program samples from a texture, bind it; every sampler is set to
+  // the first texture unit once the program is linked
+  if (texture != nullptr) {
+    glActiveTexture(GL_TEXTURE0);
+    texture->bind();
+  }
+
+  // The heatmap is scaled to the most visited tile, so it's never saturated
+  const Uniforms &uniforms = getUniforms(program);
+  if (program == m_heatmapProgram) {
+    double tileLength = Dimensions::tileLength().getMeters();
+    program->setUniformValue(
+        uniforms.mazeSize, QVector2D(m_visitCounts->getWidth() * tileLength,
+                                     m_visitCounts->getHeight() * tileLength));
+    program->setUniformValue(
+        uniforms.maxVisits,
+        static_cast<GLfloat>(qMax(1, m_visitCounts->getMaxTileVisits())));
+  }
+
+  // The transformation matrix is computed once for each half of the map, and
+  // the palette once per frame; they're already in the uniform buffers, if
+  // there are any
+  if (!m_isCoreProfile) {
+    program->setUniformValue(uniforms.transformationMatrix,
+                             m_transformationMatrix);
+    if (uniforms.palette != -1) {
+      program->setUniformValueArray(uniforms.palette, m_palette.constData(),
+                                    m_palette.size());
+    }
+  }
+  if (uniforms.modelMatrix != -1) {
+    program->setUniformValue(uniforms.modelMatrix, modelMatrix);
+  }
+  if (isIndexed) {
+    glDrawElements(
+        mode, count, GL_UNSIGNED_INT,
+        reinterpret_cast<void *>(sizeof(unsigned int) * startingIndex));
+  } else {
+    glDrawArrays(mode, startingIndex, count);
+  }
+
+  // Unbind the texture, if any
+  if (texture != nullptr) {
+    texture->release();
+  }
+
+  // Stop using the program and vertex array object
+  vao->release();
+}
+
+}  // namespace mms
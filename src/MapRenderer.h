@@ -0,0 +1,353 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLVertexArrayObject>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QVector4D>
+
+#include "Camera.h"
+#include "DirtyRanges.h"
+#include "FrameTimer.h"
+#include "MapResources.h"
+#include "Maze.h"
+#include "MazeView.h"
+#include "MouseGraphic.h"
+#include "TileGraphicState.h"
+#include "TriangleGraphic.h"
+#include "TriangleTexture.h"
+#include "VertexColor.h"
+#include "VertexGraphic.h"
+#include "VisitCounts.h"
+
+namespace mms {
+
+// The MapRenderer draws a maze, its views, and its mice into whatever
+// framebuffer is bound in the current OpenGL context, e.g., that of the Map
+// widget, or an offscreen one (see FrameExporter). The context must be
+// current whenever any of its methods are called, apart from the setters.
+class MapRenderer : protected QOpenGLExtraFunctions {
+ public:
+  MapRenderer();
+  ~MapRenderer();
+
+  void setMaze(const Maze *maze);
+  void setView(MazeView *view);
+
+  // If set, the map is divided into a grid of cells, with the view in the
+  // first and the other views after it, row by row, e.g., to compare what the
+  // mouse knows to the truth, or to what the rivals know, all at once. The
+  // views must share their geometry (see MazeView), which is uploaded just
+  // once for all of them, so each only costs its colors, text, and path, and
+  // the mice are drawn on each of them. At most MAX_VIEWS in all.
+  void setOtherViews(const QVector<MazeView *> &views);
+  int getNumViews() const;
+  static const int MAX_VIEWS;
+
+  // The columns and rows of the grid of cells of the given number of views,
+  // as close to square as they can be, e.g., two views are side by side
+  static QPair<int, int> getGridSize(int numViews);
+
+  // The video memory that the buffers of a view take once all of it is
+  // uploaded (see repopulateVertexBufferObjects), including those of its
+  // geometry if it's the main view, which no other view uploads, but not the
+  // mice, the font, or the heatmap, which stay small whatever the maze. The
+  // tile state coordinates and texture are counted as if they're used. The
+  // polygons are uploaded in chunks, so a large maze that's only partly
+  // shown takes just the chunks that are resident (see MAX_RESIDENT_CHUNKS).
+  static qint64 getGpuMemoryBytes(const MazeView *view, bool isMainView);
+
+  // Every mouse is drawn in the same pass, in order, so later mice are drawn
+  // on top of earlier ones
+  void setMouseGraphics(const QVector<const MouseGraphic *> &mouseGraphics);
+
+  // Redraws the triangles of the mouse graphics, e.g., if their colors changed
+  void refreshMouseGraphics();
+
+  // If shown, the visit counts (see VisitCounts), which must be of the maze,
+  // are drawn over the tiles of each half of the map as a heatmap. The counts
+  // aren't owned by the renderer, which clears their dirty ranges once
+  // they're uploaded. Off by default.
+  void setVisitCounts(VisitCounts *visitCounts);
+  void setHeatmapShown(bool shown);
+  bool isHeatmapShown() const;
+
+  // Whether any of the views changed since they were last rendered
+  bool isViewDirty() const;
+
+  // Whether any of the mice was drawn short of where it is, in which case
+  // it must be drawn again as it catches up (see Mouse::getDrawnPose)
+  bool areMiceCatchingUp() const;
+
+  // The camera of each cell of the map; every cell is shown through the same
+  // camera, so they always show the same part of the maze
+  Camera *getCamera();
+  const Camera *getCamera() const;
+
+  // Must be called once, before the first render
+  void initialize();
+
+  // Renders a frame of the given size, in device independent pixels
+  void render(int width, int height, qreal devicePixelRatio);
+
+  // If enabled, the phases of each frame are timed (see FrameTimer); off by
+  // default, since timer queries aren't free
+  void setTimingEnabled(bool enabled);
+  const FrameTimer *getFrameTimer() const;  // null if never enabled
+
+ private:
+  // No ownership here - only pointers
+  const Maze *m_maze;
+  QVector<const MouseGraphic *> m_mouseGraphics;
+
+  // The polygons of the maze are uploaded in chunks of CHUNK_COLUMNS columns
+  // of tiles, each with buffers of its own, since tiles are laid out column
+  // by column (see MazeGeometry), so the triangles of a chunk are a range of
+  // the bases, the walls, and the corners, and its vertices are a single
+  // range. A chunk is only uploaded once it's drawn, or is near the first
+  // mouse, and once more than MAX_RESIDENT_CHUNKS are, those that were used
+  // the longest ago are freed, so that the video memory and upload cost of a
+  // giant maze follow what's shown, not the size of the maze. A chunk that
+  // isn't resident is never written, since it's uploaded whole when it next
+  // is; one that is gets just the colors that changed.
+  static const int CHUNK_COLUMNS;
+  static const int MAX_RESIDENT_CHUNKS;
+
+  // The geometry of a chunk, shared by every view; the indices are of the
+  // chunk's own vertices, with the bases, then the walls, then the corners.
+  // The VAO draws the chunk from the tile state texture, if that's used, and
+  // otherwise only holds the index buffer, which each view's VAO also binds.
+  struct Chunk {
+    int firstColumn;
+    int lastColumn;  // exclusive
+    int firstVertex;
+    int numVertices;
+    int wallStart;
+    int cornerStart;
+    int numIndices;
+    bool isResident;
+    int lastUsedFrame;
+    QOpenGLVertexArrayObject vao;
+    QOpenGLBuffer ibo;
+    QOpenGLBuffer positionVBO;
+    QOpenGLBuffer stateCoordinateVBO;
+  };
+
+  // The colors of a chunk, for one view, if they aren't sampled from the tile
+  // state texture; created along with the chunk's geometry, and freed with it
+  struct ViewChunk {
+    bool isUploaded;
+    QOpenGLVertexArrayObject polygonVAO;
+    QOpenGLBuffer colorVBO;
+  };
+
+  // The GPU side of everything that differs between the views of a maze; the
+  // positions, triangles, and tile state coordinates are the same for each
+  // (see MazeGeometry), so they're uploaded once and shared by every view
+  struct ViewBuffers {
+    MazeView *view;
+
+    // Whether the buffers hold the current view, in which case only what
+    // changed since the last frame needs to be written
+    bool isUploaded;
+
+    // Indexed like the chunks of the geometry
+    QVector<ViewChunk *> chunks;
+    QOpenGLTexture *tileStateTexture;
+
+    QOpenGLVertexArrayObject textureVAO;
+    QOpenGLBuffer textureStaticVBO;   // texture v-coordinates
+    QOpenGLBuffer textureDynamicVBO;  // vertex positions, texture u-coords
+    int textureVBOSize;               // in triangles
+
+    QOpenGLVertexArrayObject pathVAO;
+    QOpenGLBuffer pathVBO;
+  };
+
+  // The view, and then the other views, if any, of which there are
+  // m_numViews in all. The buffers hold GL objects, which can't be copied,
+  // so they're owned here rather than held by value, as are the chunks.
+  QVector<ViewBuffers *> m_viewBuffers;
+  ViewBuffers *m_mainBuffers;
+  int m_numViews;
+
+  // The chunks of the shared geometry, the number that are resident, and the
+  // number of the frame, by which the least recently used chunk is found
+  QVector<Chunk *> m_chunks;
+  int m_numResidentChunks;
+  int m_frameNumber;
+
+  // Whether the chunks of the shared geometry are laid out, and the
+  // transformation matrix of the cell of the map that's being drawn,
+  // computed once per frame and cell
+  bool m_isGeometryUploaded;
+  QMatrix4x4 m_transformationMatrix;
+  Camera m_camera;
+
+  // The triangles of the mice at their initial positions, which only need to
+  // be uploaded once rather than every frame; each mouse is then drawn with a
+  // model matrix of its own, by the polygon program, from a buffer of its
+  // own. The vertices of mouse i start at index i of the starts, which end
+  // with the size of the buffer.
+  QVector<VertexGraphic> m_mouseBuffer;
+  QVector<int> m_mouseBufferStarts;
+  bool m_isMouseUploaded;
+  QOpenGLVertexArrayObject m_mouseVAO;
+  QOpenGLBuffer m_mouseVBO;
+
+  // The time that the mice of the last frame were drawn as of, from
+  // SimUtilities::getHighResTimestamp
+  double m_frameTimestamp;
+
+  // Below these lengths of a tile, in pixels, corners and text aren't drawn
+  static const double MIN_PIXELS_PER_TILE_FOR_CORNERS;
+  static const double MIN_PIXELS_PER_TILE_FOR_TEXT;
+
+  // If the context supports GLSL 3.30 (or GLSL ES 3.00), the programs are
+  // compiled in that dialect, and the transformation matrix and the palette
+  // are in uniform buffers that every program shares, written once per cell
+  // of the map and once per frame, respectively. Otherwise, the programs are
+  // compiled as GLSL 1.x, and those uniforms are set on every draw. Either
+  // way, the palette is only looked up once per frame.
+  bool m_isCoreProfile;
+  GLuint m_transformUBO;
+  GLuint m_paletteUBO;
+  QVector<QVector4D> m_palette;
+  static const GLuint TRANSFORM_BINDING;
+  static const GLuint PALETTE_BINDING;
+
+  // The attribute locations, which are bound before the programs are linked
+  // rather than looked up by name
+  static const int COORDINATE_LOCATION;
+  static const int COLOR_LOCATION;
+  static const int STATE_COORDINATE_LOCATION;
+  static const int TEXTURE_U_LOCATION;
+  static const int TEXTURE_V_LOCATION;
+
+  // The locations of the uniforms that are set on each draw, looked up once
+  // the program is linked; those that a program doesn't have are -1. The
+  // samplers always use the first texture unit, so they're set just once.
+  struct Uniforms {
+    int transformationMatrix;
+    int modelMatrix;
+    int palette;
+    int mazeSize;
+    int maxVisits;
+  };
+
+  // The programs and the font atlas are those of the context's share group,
+  // acquired when the renderer is initialized (see MapResources)
+  MapResources *m_resources;
+
+  // Polygon program variables; the index buffer and vertex positions of each
+  // chunk are shared by every view's VAO of that chunk
+  QOpenGLShaderProgram *m_polygonProgram;
+  Uniforms m_polygonUniforms;
+
+  // Tile state program variables; the tile state program draws the same
+  // triangles as the polygon program, but samples their colors from a texture
+  // of per-tile state, so that changing a tile's color is a single texel
+  // write. Its attributes are all shared, so each view only needs a texture.
+  bool m_useTileStateTexture;
+  QOpenGLShaderProgram *m_tileStateProgram;
+  Uniforms m_tileStateUniforms;
+
+  // Texture program variables
+  QOpenGLTexture *m_textureAtlas;
+  QOpenGLShaderProgram *m_textureProgram;
+  Uniforms m_textureUniforms;
+
+  // Heatmap program variables; the heatmap is a single quad over the maze,
+  // colored by a texture with a texel per tile, so a visit is a single texel
+  // write, and the tiles' own colors are never touched
+  VisitCounts *m_visitCounts;
+  bool m_isHeatmapShown;
+  bool m_isHeatmapUploaded;
+  QOpenGLShaderProgram *m_heatmapProgram;
+  Uniforms m_heatmapUniforms;
+  QOpenGLVertexArrayObject m_heatmapVAO;
+  QOpenGLBuffer m_heatmapVBO;  // the corners of the maze
+  QOpenGLTexture *m_heatmapTexture;
+
+  // Kept once created, even if timing is disabled, so that its queries are
+  // only ever deleted along with the renderer
+  bool m_isTimingEnabled;
+  FrameTimer *m_frameTimer;
+  void beginPhase(FrameTimer::Phase phase);
+  void endPhase();
+
+  // Initialize the graphics; the path is drawn by the polygon program, as a
+  // single line strip, straight from the view's vertices
+  void initPolygonProgram();
+  bool initTileStateProgram();
+  void initTextureProgram();
+  void initHeatmapProgram();
+  void initTextureVAO(ViewBuffers *buffers);
+  void initPathVAO(ViewBuffers *buffers);
+  void initMouseVAO();
+
+  // Shaders are written once for both dialects: they declare the shared
+  // uniforms as TRANSFORM_UNIFORMS and PALETTE_UNIFORMS, and use the macros
+  // of getShaderPreamble in place of the keywords that differ. The attributes
+  // are given with their locations, and the sampler, if any, is set to the
+  // first texture unit. Returns whether the program linked. Only the first
+  // renderer of a share group links the programs; the rest just look up
+  // their uniforms.
+  bool linkProgram(QOpenGLShaderProgram *program, QString vertexShader,
+                   QString fragmentShader,
+                   const QVector<QPair<const char *, int>> &attributes,
+                   const char *sampler, Uniforms *uniforms);
+  static void getUniformLocations(const QOpenGLShaderProgram *program,
+                                  Uniforms *uniforms);
+  QString getShaderPreamble(QOpenGLShader::ShaderType type) const;
+  void writeUniformBuffer(GLuint buffer, const void *data, int size);
+  const Uniforms &getUniforms(const QOpenGLShaderProgram *program) const;
+
+  // Drawing helper methods; the chunks are those of the visible columns,
+  // from the first up to (but not including) the last
+  void repopulateVertexBufferObjects(QPair<int, int> chunks);
+  void repopulateViewBuffers(ViewBuffers *buffers,
+                             const QVector<int> &usedChunks);
+  void reallocateTileStateTexture(ViewBuffers *buffers);
+  void writeTileStates(ViewBuffers *buffers);
+  void writeVisitCounts();
+  void drawView(ViewBuffers *buffers, QPair<int, int> columns,
+                bool isCornersDrawn, bool isTextDrawn);
+
+  // The range of columns of tiles, from the first up to (but not including)
+  // the last, with any part in a cell of the map of the given size, and the
+  // range of the chunks that hold them
+  QPair<int, int> getVisibleColumns(int viewWidth, int viewHeight) const;
+  QPair<int, int> getChunks(QPair<int, int> columns) const;
+
+  // Lays out the chunks of the main view's geometry, none of them resident;
+  // uploads a chunk's geometry, or a view's colors of it; and frees a chunk,
+  // along with every view's colors of it
+  void buildChunks();
+  void makeResident(Chunk *chunk);
+  void uploadViewChunk(ViewBuffers *buffers, int chunkIndex);
+  void freeChunk(int chunkIndex);
+  void freeLeastRecentlyUsedChunks();
+
+  // Extract the attributes of each vertex of the given triangles, in the
+  // layouts of the vertex buffer objects
+  static QVector<unsigned char> getTextureVCoordinates(
+      const TriangleTexture *triangles, int count);
+  static QVector<float> getTextureXYUCoordinates(
+      const TriangleTexture *triangles, int count);
+
+  // If indexed, the starting index and count are into the VAO's index buffer,
+  // otherwise they're into its vertex buffers. The texture, if any, is what
+  // the program samples from. The model matrix is only used by the polygon
+  // program. The mode is the kind of primitive, e.g., GL_TRIANGLES.
+  void drawMap(QOpenGLShaderProgram *program, QOpenGLVertexArrayObject *vao,
+               QOpenGLTexture *texture, GLenum mode, int startingIndex,
+               int count, bool isIndexed, const QMatrix4x4 &modelMatrix);
+};
+
+}  // namespace mms
@@ -0,0 +1,47 @@
+#include "MapResources.h"
+
+#include <QOpenGLContext>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+QHash<QOpenGLContextGroup *, MapResources *> MapResources::RESOURCES;
+
+MapResources *MapResources::acquire() {
+  QOpenGLContextGroup *group = QOpenGLContextGroup::currentContextGroup();
+  ASSERT_FA(group == nullptr);
+  MapResources *resources = RESOURCES.value(group, nullptr);
+  if (resources == nullptr) {
+    resources = new MapResources(group);
+    RESOURCES.insert(group, resources);
+  }
+  resources->m_references += 1;
+  return resources;
+}
+
+void MapResources::release(MapResources *resources) {
+  ASSERT_LT(0, resources->m_references);
+  resources->m_references -= 1;
+  if (resources->m_references == 0) {
+    RESOURCES.remove(resources->m_group);
+    delete resources;
+  }
+}
+
+MapResources::MapResources(QOpenGLContextGroup *group)
+    : isInitialized(false),
+      textureAtlas(nullptr),
+      m_group(group),
+      m_references(0) {}
+
+MapResources::~MapResources() {
+  // The programs free themselves through any context of the group, but the
+  // atlas needs one to be current, as it is while a renderer is destroyed
+  // with its widget; otherwise it's left for the driver to free
+  if (QOpenGLContext::currentContext() != nullptr) {
+    delete textureAtlas;
+  }
+}
+
+}  // namespace mms
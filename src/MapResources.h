@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QHash>
+#include <QOpenGLContextGroup>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+
+namespace mms {
+
+// The GL objects of the map that don't depend on what's drawn, i.e., the
+// programs and the font atlas, which are the same for every renderer (see
+// MapRenderer). Contexts that share (see Qt::AA_ShareOpenGLContexts) are in
+// the same share group, so each group only compiles the programs and uploads
+// the atlas once, with the first renderer that's initialized in it, however
+// many widgets and windows draw maps. Everything that differs between
+// renderers, e.g., VAOs, which are never shared, and the buffers of the maze
+// and its views, is still each renderer's own.
+class MapResources {
+ public:
+  // The resources of the current context's share group, created if this is
+  // the first renderer of the group; each acquire must be released, and
+  // the resources are deleted once the last renderer releases them. Only used
+  // on the GUI thread, like the contexts themselves.
+  static MapResources *acquire();
+  static void release(MapResources *resources);
+
+  // Whether the first renderer has set these up, after which the others only
+  // use them; the tile state program stays unlinked if the context can't
+  // read textures in vertex shaders, and the atlas is null without a font
+  bool isInitialized;
+  QOpenGLShaderProgram polygonProgram;
+  QOpenGLShaderProgram tileStateProgram;
+  QOpenGLShaderProgram textureProgram;
+  QOpenGLShaderProgram heatmapProgram;
+  QOpenGLTexture *textureAtlas;
+
+ private:
+  static QHash<QOpenGLContextGroup *, MapResources *> RESOURCES;
+
+  MapResources(QOpenGLContextGroup *group);
+  ~MapResources();
+
+  QOpenGLContextGroup *m_group;
+  int m_references;
+};
+
+}  // namespace mms
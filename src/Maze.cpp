@@ -1,69 +1,293 @@
 #include "Maze.h"
 
+#include <QCryptographicHash>
 #include <QFile>
-#include <QQueue>
-#include <QTextStream>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+#include <utility>
 
 #include "AssertMacros.h"
+#include "MazeBitboard.h"
+#include "MazeCorpus.h"
+#include "Profiler.h"
 
 namespace mms {
 
+// Binary format (all integers are little-endian):
+//   [0, 4)    magic ("MMSM")
+//   [4, 6)    version
+//   [6, 8)    width
+//   [8, 10)   height
+//   [10, 12)  reserved, zero
+//   [12, ...) wall masks of tiles in order height * x + y, two per byte, with
+//             the even tile in the low nibble
+const quint32 Maze::BINARY_MAGIC = 0x4d534d4d;  // "MMSM"
+const quint16 Maze::BINARY_VERSION = 1;
+const int Maze::BINARY_HEADER_SIZE = 12;
+
+// Far beyond any real maze, e.g., 1024x1024 stress mazes, yet only 16 MiB of
+// walls at most
+const int Maze::MAX_SIZE = 4096;
+
 Maze *Maze::fromFile(const QString &path) {
   // Open the file
   if (path.isEmpty()) {
     return nullptr;
   }
   QFile file(path);
+  if (!file.exists()) {
+    QString corpusPath;
+    int index = 0;
+    if (!MazeCorpus::parseEntryPath(path, &corpusPath, &index)) {
+      return nullptr;
+    }
+    return MazeCorpus::getMaze(corpusPath, index);
+  }
   if (!file.open(QFile::ReadOnly)) {
     return nullptr;
   }
 
-  // Read the lines into a vector
-  QString line;
-  QVector<QString> lines;
-  QTextStream stream(&file);
-  while (stream.readLineInto(&line)) {
-    lines.append(line);
+  // Map the file rather than reading it, so that nothing is copied; fall
+  // back to reading it if it can't be mapped, e.g., compressed resources
+  qint64 size = file.size();
+  uchar *data = 0 < size ? file.map(0, size) : nullptr;
+  if (data == nullptr) {
+    return fromBytes(file.readAll());
   }
+  Maze *maze = fromBytes(QByteArray::fromRawData(
+      reinterpret_cast<const char *>(data), static_cast<int>(size)));
+  file.unmap(data);
+  return maze;
+}
 
-  // Try map format first, then num
-  Maze *maze = fromMapFile(lines);
-  if (maze != nullptr) {
-    return maze;
+Maze *Maze::fromBinary(const QByteArray &bytes) {
+  if (bytes.size() < BINARY_HEADER_SIZE) {
+    return nullptr;
+  }
+  const char *data = bytes.constData();
+  if (qFromLittleEndian<quint32>(data) != BINARY_MAGIC ||
+      qFromLittleEndian<quint16>(data + 4) != BINARY_VERSION) {
+    return nullptr;
+  }
+  int width = qFromLittleEndian<quint16>(data + 6);
+  int height = qFromLittleEndian<quint16>(data + 8);
+  if (width < 1 || height < 1 || MAX_SIZE < width || MAX_SIZE < height) {
+    return nullptr;
+  }
+  qint64 numTiles = static_cast<qint64>(width) * height;
+  if (bytes.size() < BINARY_HEADER_SIZE + (numTiles + 1) / 2) {
+    return nullptr;
   }
-  return fromNumFile(lines);
+  QVector<unsigned char> walls(numTiles);
+  const char *nibbles = data + BINARY_HEADER_SIZE;
+  for (int i = 0; i < numTiles; i += 1) {
+    unsigned char byte = nibbles[i / 2];
+    walls[i] = i % 2 == 0 ? byte & 0x0f : byte >> 4;
+  }
+  return fromWalls(width, height, std::move(walls));
 }
 
-int Maze::getWidth() const { return m_tiles.size(); }
+QByteArray Maze::toBinary() const {
+  return toBinary(m_width, m_height, m_walls);
+}
 
-int Maze::getHeight() const { return m_tiles.at(0).size(); }
+QByteArray Maze::toBinary(int width, int height,
+                          const QVector<unsigned char> &walls) {
+  int numTiles = width * height;
+  ASSERT_EQ(walls.size(), numTiles);
+  QByteArray bytes(BINARY_HEADER_SIZE + (numTiles + 1) / 2, 0);
+  char *data = bytes.data();
+  qToLittleEndian<quint32>(BINARY_MAGIC, data);
+  qToLittleEndian<quint16>(BINARY_VERSION, data + 4);
+  qToLittleEndian<quint16>(width, data + 6);
+  qToLittleEndian<quint16>(height, data + 8);
+  char *nibbles = data + BINARY_HEADER_SIZE;
+  for (int i = 0; i < numTiles; i += 1) {
+    nibbles[i / 2] |= i % 2 == 0 ? walls.at(i) : walls.at(i) << 4;
+  }
+  return bytes;
+}
 
-const Tile *Maze::getTile(int x, int y) const {
-  ASSERT_LE(0, x);
-  ASSERT_LE(0, y);
-  ASSERT_LT(x, getWidth());
-  ASSERT_LT(y, getHeight());
-  return &m_tiles.at(x).at(y);
+QByteArray Maze::toMapFile() const {
+  // The rows are written from top to bottom, each as the line of its north
+  // walls and then the line of its west and east walls (see fromMapFile)
+  QByteArray bytes;
+  for (int y = m_height - 1; 0 <= y; y -= 1) {
+    bytes.append('+');
+    for (int x = 0; x < m_width; x += 1) {
+      bytes.append(isWall(x, y, Direction::NORTH) ? "---+" : "   +");
+    }
+    bytes.append('\n');
+    bytes.append(isWall(0, y, Direction::WEST) ? '|' : ' ');
+    for (int x = 0; x < m_width; x += 1) {
+      bytes.append(isWall(x, y, Direction::EAST) ? "   |" : "    ");
+    }
+    bytes.append('\n');
+  }
+  bytes.append('+');
+  for (int x = 0; x < m_width; x += 1) {
+    bytes.append(isWall(x, 0, Direction::SOUTH) ? "---+" : "   +");
+  }
+  bytes.append('\n');
+  return bytes;
+}
+
+QByteArray Maze::toNumFile() const {
+  QByteArray bytes;
+  for (int x = 0; x < m_width; x += 1) {
+    for (int y = 0; y < m_height; y += 1) {
+      bytes.append(QByteArray::number(x));
+      bytes.append(' ');
+      bytes.append(QByteArray::number(y));
+      for (Direction direction : CARDINAL_DIRECTIONS()) {
+        bytes.append(isWall(x, y, direction) ? " 1" : " 0");
+      }
+      bytes.append('\n');
+    }
+  }
+  return bytes;
+}
+
+QByteArray Maze::getCanonicalHash() const {
+  // The first four symmetries are the rotations, and the rest are the
+  // rotations mirrored; the identity always puts the start in the corner
+  QByteArray smallest;
+  for (int symmetry = 0; symmetry < 8; symmetry += 1) {
+    int width = m_width;
+    int height = m_height;
+    QVector<unsigned char> walls = m_walls;
+    for (int i = 0; i < symmetry % 4; i += 1) {
+      walls = rotate(width, height, walls);
+      std::swap(width, height);
+    }
+    if (4 <= symmetry) {
+      walls = reflect(width, height, walls);
+    }
+    if (walls.at(0) != m_walls.at(0)) {
+      continue;
+    }
+    QByteArray bytes = toBinary(width, height, walls);
+    if (smallest.isNull() || bytes < smallest) {
+      smallest = bytes;
+    }
+  }
+  return QCryptographicHash::hash(smallest, QCryptographicHash::Sha1);
+}
+
+int Maze::getWidth() const { return m_width; }
+
+int Maze::getHeight() const { return m_height; }
+
+qint64 Maze::getMemoryBytes() const {
+  return sizeof(unsigned char) * m_walls.capacity() +
+         sizeof(int) * m_distances.capacity();
+}
+
+bool Maze::isWall(int x, int y, Direction direction) const {
+  return (getWalls(x, y) & getWallBit(direction)) != 0;
+}
+
+unsigned char Maze::getWalls(int x, int y) const {
+  return m_walls.at(getIndex(x, y));
+}
+
+int Maze::getDistance(int x, int y) const {
+  return m_distances.at(getIndex(x, y));
 }
 
 bool Maze::isInCenter(QPair<int, int> location) const {
   return getCenterPositions(getWidth(), getHeight()).contains(location);
 }
 
-Maze::Maze(BasicMaze basicMaze) {
-  QVector<QVector<int>> distances = getDistances(basicMaze);
-  for (int x = 0; x < basicMaze.size(); x += 1) {
-    QVector<Tile> column;
-    for (int y = 0; y < basicMaze.at(x).size(); y += 1) {
-      Tile tile(x, y, distances.at(x).at(y), basicMaze.at(x).at(y));
-      tile.initPolygons(basicMaze.size(), basicMaze.at(x).size());
-      column.append(tile);
+QVector<QPair<int, int>> Maze::setWall(int x, int y, Direction direction,
+                                       bool isWall) {
+  int neighborX = x;
+  int neighborY = y;
+  if (direction == Direction::NORTH) {
+    neighborY += 1;
+  }
+  if (direction == Direction::EAST) {
+    neighborX += 1;
+  }
+  if (direction == Direction::SOUTH) {
+    neighborY -= 1;
+  }
+  if (direction == Direction::WEST) {
+    neighborX -= 1;
+  }
+  bool isBorder = neighborX < 0 || neighborY < 0 || m_width <= neighborX ||
+                  m_height <= neighborY;
+  ASSERT_TR(isWall || !isBorder);
+  if (this->isWall(x, y, direction) == isWall) {
+    return {};
+  }
+
+  // Update the wall on both sides
+  int index = getIndex(x, y);
+  int neighbor = getIndex(neighborX, neighborY);
+  int opposite = (CARDINAL_DIRECTIONS().indexOf(direction) + 2) % 4;
+  unsigned char bit = getWallBit(direction);
+  unsigned char oppositeBit = getWallBit(CARDINAL_DIRECTIONS().at(opposite));
+  QVector<int> changed;
+  if (isWall) {
+    m_walls[index] |= bit;
+    m_walls[neighbor] |= oppositeBit;
+
+    // Only the farther tile (and tiles beyond it) could have used the wall
+    int distance = m_distances.at(index);
+    int neighborDistance = m_distances.at(neighbor);
+    if (distance != neighborDistance) {
+      changed = increaseDistances(distance < neighborDistance ? neighbor
+                                                              : index);
     }
-    m_tiles.append(column);
+  } else {
+    m_walls[index] &= ~bit;
+    m_walls[neighbor] &= ~oppositeBit;
+    changed = decreaseDistances(index, neighbor);
+    changed += decreaseDistances(neighbor, index);
+  }
+
+  QVector<QPair<int, int>> tiles;
+  for (int i : changed) {
+    tiles.append({i / m_height, i % m_height});
   }
+  return tiles;
+}
+
+unsigned char Maze::getWallBit(Direction direction) {
+  return 1 << static_cast<int>(direction);
 }
 
-Maze *Maze::fromMapFile(QVector<QString> lines) {
+Maze::Maze(int width, int height, QVector<unsigned char> walls)
+    : m_width(width),
+      m_height(height),
+      m_walls(std::move(walls)),
+      m_distances(getDistances(width, height, m_walls)) {}
+
+int Maze::getIndex(int x, int y) const {
+  ASSERT_LE(0, x);
+  ASSERT_LE(0, y);
+  ASSERT_LT(x, getWidth());
+  ASSERT_LT(y, getHeight());
+  return m_height * x + y;
+}
+
+Maze *Maze::fromBytes(const QByteArray &bytes) {
+  PROFILE_SCOPE("Maze::fromBytes");
+  if (4 <= bytes.size() &&
+      qFromLittleEndian<quint32>(bytes.constData()) == BINARY_MAGIC) {
+    return fromBinary(bytes);
+  }
+
+  // Map files always start with the upper left corner of the top wall
+  if (bytes.startsWith('+')) {
+    return fromMapFile(bytes);
+  }
+  return fromNumFile(bytes);
+}
+
+Maze *Maze::fromMapFile(const QByteArray &bytes) {
   // Format:
   //
   //     +---+---+---+
@@ -71,69 +295,76 @@ Maze *Maze::fromMapFile(QVector<QString> lines) {
   //     +   +   +   +
   //     |   |       |
   //     +---+---+---+
+  //
+  // Even lines hold horizontal walls: the south walls of the row of tiles
+  // above and the north walls of the row below. Odd lines hold the vertical
+  // walls of a single row. The rows are read from top to bottom, and then
+  // flipped once the height is known.
+
+  unsigned char north = getWallBit(Direction::NORTH);
+  unsigned char east = getWallBit(Direction::EAST);
+  unsigned char south = getWallBit(Direction::SOUTH);
+  unsigned char west = getWallBit(Direction::WEST);
+
+  int width = -1;
+  int numLines = 0;
+  QVector<unsigned char> rows;
+  int start = 0;
+  const char *line = nullptr;
+  int length = 0;
+  while (getNextLine(bytes, &start, &line, &length)) {
+    // The width is determined by the first line, check bounds for the rest
+    if (width == -1) {
+      width = length / 4;
+
+      // Every other line starts a row, and every line is about as long
+      rows.reserve(width * (bytes.size() / (2 * (length + 1)) + 1));
+    }
+    if (length < 4 * width + 1) {
+      return nullptr;
+    }
 
-  // Flip the lines to process them from bottom to top
-  for (int i = 0; i < lines.size() / 2; i += 1) {
-    int j = lines.size() - 1 - i;
-    QString one = lines.at(i);
-    QString two = lines.at(j);
-    lines[i] = two;
-    lines[j] = one;
-  }
-
-  BasicMaze basicMaze;
-  for (int y = 0; y < lines.size() / 2; y += 1) {
-    for (int x = 0; x < lines.at(y).size() / 4; x += 1) {
-      // Fill out the maze as necessary
-      while (basicMaze.size() <= x) {
-        QVector<QMap<Direction, bool>> column;
-        basicMaze.append(column);
-      }
-      while (basicMaze.at(x).size() <= y) {
-        QMap<Direction, bool> walls;
-        basicMaze[x].append(walls);
-      }
-
-      // Calculate the edges of the cell:
-      //
-      //    west v
-      //         +---+ < north
-      //         |   |
-      // south > +---+
-      //             ^ east
-      //
-      int north = 2 * (y + 1);
-      int south = 2 * (y + 0);
-      int east = 4 * (x + 1);
-      int west = 4 * (x + 0);
-
-      // Check bounds
-      if (lines.size() <= north) {
-        return nullptr;
+    if (numLines % 2 == 0) {
+      // Close off the previous row, and start a new one
+      int previous = rows.size() - width;
+      for (int x = 0; x < width; x += 1) {
+        bool isWall = line[4 * x + 2] != ' ';
+        if (0 < numLines && isWall) {
+          rows[previous + x] |= south;
+        }
+        rows.append(isWall ? north : 0);
       }
-      if (lines.at(south + 1).size() <= east) {
-        return nullptr;
+    } else {
+      int current = rows.size() - width;
+      for (int x = 0; x < width; x += 1) {
+        if (line[4 * x] != ' ') {
+          rows[current + x] |= west;
+        }
+        if (line[4 * x + 4] != ' ') {
+          rows[current + x] |= east;
+        }
       }
-
-      // Add values for the current cell
-      QMap<Direction, bool> walls;
-      walls[Direction::NORTH] = lines.at(north).at(west + 2) != ' ';
-      walls[Direction::EAST] = lines.at(south + 1).at(east) != ' ';
-      walls[Direction::SOUTH] = lines.at(south).at(west + 2) != ' ';
-      walls[Direction::WEST] = lines.at(south + 1).at(west) != ' ';
-      basicMaze[x][y] = walls;
     }
+    numLines += 1;
   }
 
-  // Check if the maze is valid
-  if (!isValid(basicMaze)) {
+  // The last line must be horizontal walls, and the row that was started
+  // beneath them doesn't exist
+  if (numLines % 2 == 0) {
     return nullptr;
   }
-
-  return new Maze(basicMaze);
+  int height = numLines / 2;
+  QVector<unsigned char> walls(width * height);
+  for (int row = 0; row < height; row += 1) {
+    int y = height - 1 - row;
+    for (int x = 0; x < width; x += 1) {
+      walls[height * x + y] = rows.at(width * row + x);
+    }
+  }
+  return fromWalls(width, height, std::move(walls));
 }
 
-Maze *Maze::fromNumFile(QVector<QString> lines) {
+Maze *Maze::fromNumFile(const QByteArray &bytes) {
   // Format:
   //
   //     X Y N E S W
@@ -154,171 +385,393 @@ Maze *Maze::fromNumFile(QVector<QString> lines) {
   //     +   +   +   +
   //     |   |       |
   //     +---+---+---+
-
-  BasicMaze basicMaze;
-  for (QString line : lines) {
-    // Tokenize the line
-    QStringList tokens = line.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 6) {
+  //
+  // Lines may be in any order, so the walls of each line are collected as
+  // (x, y, walls) triples until the dimensions are known.
+
+  // No line is shorter than "0 0 0 0 0 0", so this is enough for every one
+  QVector<int> cells;
+  cells.reserve(3 * (bytes.size() / 11 + 1));
+  QVector<int> columnHeights;
+  int start = 0;
+  const char *line = nullptr;
+  int length = 0;
+  while (getNextLine(bytes, &start, &line, &length)) {
+    int values[6];
+    if (!getNumFileValues(line, length, values)) {
+      return nullptr;
+    }
+    int x = values[0];
+    int y = values[1];
+    if (MAX_SIZE <= x || MAX_SIZE <= y) {
       return nullptr;
     }
+    unsigned char walls = 0;
+    for (int i = 0; i < CARDINAL_DIRECTIONS().size(); i += 1) {
+      if (values[2 + i] == 1) {
+        walls |= getWallBit(CARDINAL_DIRECTIONS().at(i));
+      }
+    }
+    cells.append(x);
+    cells.append(y);
+    cells.append(walls);
+    while (columnHeights.size() <= x) {
+      columnHeights.append(0);
+    }
+    columnHeights[x] = qMax(columnHeights.at(x), y + 1);
+  }
 
-    // Extract numeric values
-    bool ok = true;
-    int x = tokens.at(0).toInt(&ok);
-    int y = tokens.at(1).toInt(&ok);
-    bool n = tokens.at(2).toInt(&ok) == 1;
-    bool e = tokens.at(3).toInt(&ok) == 1;
-    bool s = tokens.at(4).toInt(&ok) == 1;
-    bool w = tokens.at(5).toInt(&ok) == 1;
-    if (!ok) {
+  // Check that the maze is rectangular
+  int width = columnHeights.size();
+  int height = columnHeights.isEmpty() ? 0 : columnHeights.at(0);
+  for (int columnHeight : columnHeights) {
+    if (columnHeight != height) {
       return nullptr;
     }
+  }
 
-    // Fill out the maze as necessary
-    while (basicMaze.size() <= x) {
-      QVector<QMap<Direction, bool>> column;
-      basicMaze.append(column);
+  // Later lines take precedence, and missing tiles have no walls
+  QVector<unsigned char> walls(static_cast<qint64>(width) * height, 0);
+  for (int i = 0; i < cells.size(); i += 3) {
+    walls[height * cells.at(i) + cells.at(i + 1)] = cells.at(i + 2);
+  }
+  return fromWalls(width, height, std::move(walls));
+}
+
+Maze *Maze::fromWalls(int width, int height, QVector<unsigned char> walls) {
+  // The other formats are bounded as they're parsed, but a map file only by
+  // its own size
+  if (MAX_SIZE < width || MAX_SIZE < height ||
+      !isValid(width, height, walls)) {
+    return nullptr;
+  }
+  return new Maze(width, height, std::move(walls));
+}
+
+bool Maze::getNextLine(const QByteArray &bytes, int *start, const char **line,
+                       int *length) {
+  if (bytes.size() <= *start) {
+    return false;
+  }
+  int end = bytes.indexOf('\n', *start);
+  if (end == -1) {
+    end = bytes.size();
+  }
+  *line = bytes.constData() + *start;
+  *length = end - *start;
+  if (0 < *length && (*line)[*length - 1] == '\r') {
+    *length -= 1;
+  }
+  *start = end + 1;
+  return true;
+}
+
+bool Maze::getNumFileValues(const char *line, int length, int *values) {
+  // Exactly six non-negative integers, separated by whitespace
+  int numValues = 0;
+  int i = 0;
+  while (i < length) {
+    if (line[i] == ' ' || line[i] == '\t') {
+      i += 1;
+      continue;
     }
-    while (basicMaze.at(x).size() <= y) {
-      QMap<Direction, bool> walls;
-      basicMaze[x].append(walls);
+    if (numValues == 6 || line[i] < '0' || '9' < line[i]) {
+      return false;
     }
+    int value = 0;
+    while (i < length && '0' <= line[i] && line[i] <= '9') {
+      if (std::numeric_limits<int>::max() / 10 < value) {
+        return false;
+      }
+      value = 10 * value + (line[i] - '0');
+      i += 1;
+    }
+    values[numValues] = value;
+    numValues += 1;
+  }
+  return numValues == 6;
+}
 
-    // Add values for the current cell
-    QMap<Direction, bool> walls;
-    walls[Direction::NORTH] = n;
-    walls[Direction::EAST] = e;
-    walls[Direction::SOUTH] = s;
-    walls[Direction::WEST] = w;
-    basicMaze[x][y] = walls;
+bool Maze::isValid(int width, int height,
+                   const QVector<unsigned char> &walls) {
+  return (isNonempty(width, height) && isEnclosed(width, height, walls) &&
+          isConsistent(width, height, walls));
+}
+
+QVector<unsigned char> Maze::rotate(int width, int height,
+                                   const QVector<unsigned char> &walls) {
+  // The tile at (x, y) goes to (y, width - 1 - x) of a maze that's height
+  // tiles wide, and each wall goes to the next direction clockwise
+  QVector<unsigned char> rotated(walls.size(), 0);
+  for (int x = 0; x < width; x += 1) {
+    for (int y = 0; y < height; y += 1) {
+      unsigned char mask = walls.at(height * x + y);
+      rotated[width * y + (width - 1 - x)] =
+          ((mask << 1) | (mask >> 3)) & 0x0F;
+    }
   }
+  return rotated;
+}
 
-  // Check if the maze is valid
-  if (!isValid(basicMaze)) {
-    return nullptr;
+QVector<unsigned char> Maze::reflect(int width, int height,
+                                    const QVector<unsigned char> &walls) {
+  unsigned char east = getWallBit(Direction::EAST);
+  unsigned char west = getWallBit(Direction::WEST);
+  QVector<unsigned char> reflected(walls.size(), 0);
+  for (int x = 0; x < width; x += 1) {
+    for (int y = 0; y < height; y += 1) {
+      unsigned char mask = walls.at(height * x + y);
+      unsigned char swapped = mask & ~(east | west);
+      swapped |= (mask & east) != 0 ? west : 0;
+      swapped |= (mask & west) != 0 ? east : 0;
+      reflected[height * (width - 1 - x) + y] = swapped;
+    }
   }
+  return reflected;
+}
 
-  return new Maze(basicMaze);
+bool Maze::isNonempty(int width, int height) {
+  return 0 < width && 0 < height;
 }
 
-bool Maze::isValid(const BasicMaze &basicMaze) {
-  return (isNonempty(basicMaze) && isRectangular(basicMaze) &&
-          isEnclosed(basicMaze) && isConsistent(basicMaze));
+bool Maze::isEnclosed(int width, int height,
+                      const QVector<unsigned char> &walls) {
+  for (int x = 0; x < width; x += 1) {
+    if (!(walls.at(height * x) & getWallBit(Direction::SOUTH)) ||
+        !(walls.at(height * x + height - 1) & getWallBit(Direction::NORTH))) {
+      return false;
+    }
+  }
+  for (int y = 0; y < height; y += 1) {
+    if (!(walls.at(y) & getWallBit(Direction::WEST)) ||
+        !(walls.at(height * (width - 1) + y) & getWallBit(Direction::EAST))) {
+      return false;
+    }
+  }
+  return true;
 }
 
-bool Maze::isNonempty(const BasicMaze &basicMaze) {
-  return 0 < basicMaze.size() && 0 < basicMaze.at(0).size();
+bool Maze::isConsistent(int width, int height,
+                        const QVector<unsigned char> &walls) {
+  // Each interior wall is stored twice, once for each of its tiles. Since
+  // tiles are stored column by column, every east wall pairs with the west
+  // wall of the tile "height" bytes later, and every north wall pairs with
+  // the south wall of the next byte. The latter also pairs the top of each
+  // column with the bottom of the next, but both of those walls are set in
+  // an enclosed maze, so this must only be called after isEnclosed.
+  const unsigned char *data = walls.constData();
+  int size = width * height;
+  return (areWallsPaired(data, size - height, height, Direction::EAST,
+                         Direction::WEST) &&
+          areWallsPaired(data, size - 1, 1, Direction::NORTH,
+                         Direction::SOUTH));
 }
 
-bool Maze::isRectangular(const BasicMaze &basicMaze) {
-  for (int x = 0; x < basicMaze.size() - 1; x += 1) {
-    if (basicMaze.at(x).size() != basicMaze.at(x + 1).size()) {
+bool Maze::areWallsPaired(const unsigned char *walls, int count, int offset,
+                          Direction first, Direction second) {
+  // Compare eight tiles at a time; after shifting, the walls of interest are
+  // in the lowest bit of each byte, and any bits shifted in from neighboring
+  // bytes are masked off
+  const quint64 lowestBits = 0x0101010101010101ULL;
+  int firstShift = static_cast<int>(first);
+  int secondShift = static_cast<int>(second);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    quint64 firstWalls;
+    quint64 secondWalls;
+    std::memcpy(&firstWalls, walls + i, 8);
+    std::memcpy(&secondWalls, walls + i + offset, 8);
+    if (((firstWalls >> firstShift) ^ (secondWalls >> secondShift)) &
+        lowestBits) {
+      return false;
+    }
+  }
+  for (; i < count; i += 1) {
+    if (((walls[i] >> firstShift) ^ (walls[i + offset] >> secondShift)) & 1) {
       return false;
     }
   }
   return true;
 }
 
-bool Maze::isEnclosed(const BasicMaze &basicMaze) {
-  int width = basicMaze.size();
-  int height = basicMaze.at(0).size();
-  for (int x = 0; x < width; x += 1) {
-    for (int y = 0; y < height; y += 1) {
-      QMap<Direction, bool> walls = basicMaze.at(x).at(y);
-      if (x == 0 && !walls.value(Direction::WEST)) {
-        return false;
+QVector<int> Maze::getDistances(int width, int height,
+                                const QVector<unsigned char> &walls) {
+  // The common competition sizes have bitboard kernels, which are faster
+  // unless the maze is mostly corridors, i.e., has fewer than one loop for
+  // every 25 tiles (see MazeBitboard::getNumPassages)
+  int minPassages = width * height + width * height / 25;
+  if (width == 16 && height == 16) {
+    MazeBitboard<16, 16> board(walls);
+    if (minPassages <= board.getNumPassages()) {
+      return board.getDistances(getCenterPositions(width, height));
+    }
+  }
+  if (width == 32 && height == 32) {
+    MazeBitboard<32, 32> board(walls);
+    if (minPassages <= board.getNumPassages()) {
+      return board.getDistances(getCenterPositions(width, height));
+    }
+  }
+
+  // Initialize all positions with default value
+  QVector<int> distances(width * height, -1);
+
+  // Set the distances of the center positions to 0 and enqueue them; the
+  // queue never holds more than one entry per tile, so use a plain vector
+  QVector<int> discovered;
+  discovered.reserve(width * height);
+  for (QPair<int, int> position : getCenterPositions(width, height)) {
+    int index = height * position.first + position.second;
+    distances[index] = 0;
+    discovered.append(index);
+  }
+
+  // Perform a breadth first search; the maze is enclosed, so neighbors of
+  // open walls are always within the maze
+  QVector<QPair<Direction, int>> offsets = getNeighborOffsets(height);
+  for (int i = 0; i < discovered.size(); i += 1) {
+    int index = discovered.at(i);
+    for (const QPair<Direction, int> &offset : offsets) {
+      if (walls.at(index) & getWallBit(offset.first)) {
+        continue;
       }
-      if (y == 0 && !walls.value(Direction::SOUTH)) {
-        return false;
+      int neighbor = index + offset.second;
+      if (distances.at(neighbor) == -1) {
+        distances[neighbor] = distances.at(index) + 1;
+        discovered.append(neighbor);
       }
-      if (x == width - 1 && !walls.value(Direction::EAST)) {
-        return false;
+    }
+  }
+  return distances;
+}
+
+QVector<QPair<Direction, int>> Maze::getNeighborOffsets(int height) {
+  return {
+      {Direction::NORTH, 1},
+      {Direction::EAST, height},
+      {Direction::SOUTH, -1},
+      {Direction::WEST, -height},
+  };
+}
+
+QVector<int> Maze::decreaseDistances(int from, int to) {
+  QVector<int> changed;
+  int distance = m_distances.at(from);
+  if (distance == -1 ||
+      (m_distances.at(to) != -1 && m_distances.at(to) <= distance + 1)) {
+    return changed;
+  }
+
+  // Propagate the shorter distance outward; tiles are discovered in order of
+  // distance, so each tile is only updated once
+  m_distances[to] = distance + 1;
+  changed.append(to);
+  QVector<QPair<Direction, int>> offsets = getNeighborOffsets(m_height);
+  for (int i = 0; i < changed.size(); i += 1) {
+    int index = changed.at(i);
+    for (const QPair<Direction, int> &offset : offsets) {
+      if (m_walls.at(index) & getWallBit(offset.first)) {
+        continue;
       }
-      if (y == height - 1 && !walls.value(Direction::NORTH)) {
-        return false;
+      int neighbor = index + offset.second;
+      int neighborDistance = m_distances.at(neighbor);
+      if (neighborDistance == -1 ||
+          m_distances.at(index) + 1 < neighborDistance) {
+        m_distances[neighbor] = m_distances.at(index) + 1;
+        changed.append(neighbor);
       }
     }
   }
-  return true;
+  return changed;
 }
 
-bool Maze::isConsistent(const BasicMaze &basicMaze) {
-  int width = basicMaze.size();
-  int height = basicMaze.at(0).size();
-  for (int x = 0; x < basicMaze.size(); x += 1) {
-    for (int y = 0; y < basicMaze.at(x).size(); y += 1) {
-      QMap<Direction, bool> walls = basicMaze.at(x).at(y);
-      if (0 < x && walls.value(Direction::WEST) &&
-          !basicMaze.at(x - 1).at(y).value(Direction::EAST)) {
-        return false;
+QVector<int> Maze::increaseDistances(int start) {
+  QVector<int> changed;
+  QSet<int> orphans;
+  if (m_distances.at(start) == -1 || hasShortestPath(start, orphans)) {
+    return changed;
+  }
+
+  // First, find the tiles that lost all of their shortest paths, i.e., those
+  // whose every neighbor one step closer to the center is also an orphan.
+  // Tiles are rechecked whenever one of their neighbors becomes an orphan.
+  QVector<QPair<Direction, int>> offsets = getNeighborOffsets(m_height);
+  QVector<int> queue = {start};
+  orphans.insert(start);
+  for (int i = 0; i < queue.size(); i += 1) {
+    int index = queue.at(i);
+    for (const QPair<Direction, int> &offset : offsets) {
+      if (m_walls.at(index) & getWallBit(offset.first)) {
+        continue;
       }
-      if (0 < y && walls.value(Direction::SOUTH) &&
-          !basicMaze.at(x).at(y - 1).value(Direction::NORTH)) {
-        return false;
+      int neighbor = index + offset.second;
+      if (m_distances.at(neighbor) == m_distances.at(index) + 1 &&
+          !orphans.contains(neighbor) && !hasShortestPath(neighbor, orphans)) {
+        queue.append(neighbor);
+        orphans.insert(neighbor);
       }
-      if (x < width - 1 && walls.value(Direction::EAST) &&
-          !basicMaze.at(x + 1).at(y).value(Direction::WEST)) {
-        return false;
+    }
+  }
+
+  // Then, reattach the orphans to the rest of the maze, closest first
+  QVector<int> oldDistances;
+  for (int index : queue) {
+    oldDistances.append(m_distances.at(index));
+    m_distances[index] = -1;
+  }
+  QMap<int, QVector<int>> frontier;
+  for (int index : queue) {
+    int best = -1;
+    for (const QPair<Direction, int> &offset : offsets) {
+      int neighbor = index + offset.second;
+      if (!(m_walls.at(index) & getWallBit(offset.first)) &&
+          m_distances.at(neighbor) != -1 &&
+          (best == -1 || m_distances.at(neighbor) + 1 < best)) {
+        best = m_distances.at(neighbor) + 1;
       }
-      if (y < height - 1 && walls.value(Direction::NORTH) &&
-          !basicMaze.at(x).at(y + 1).value(Direction::SOUTH)) {
-        return false;
+    }
+    if (best != -1) {
+      frontier[best].append(index);
+    }
+  }
+  while (!frontier.isEmpty()) {
+    int distance = frontier.firstKey();
+    QVector<int> tiles = frontier.take(distance);
+    for (int index : tiles) {
+      if (m_distances.at(index) != -1) {
+        continue;
+      }
+      m_distances[index] = distance;
+      for (const QPair<Direction, int> &offset : offsets) {
+        int neighbor = index + offset.second;
+        if (!(m_walls.at(index) & getWallBit(offset.first)) &&
+            orphans.contains(neighbor) && m_distances.at(neighbor) == -1) {
+          frontier[distance + 1].append(neighbor);
+        }
       }
     }
   }
-  return true;
-}
 
-QVector<QVector<int>> Maze::getDistances(BasicMaze basicMaze) {
-  // Initialize all positions with default value
-  QVector<QVector<int>> distances;
-  for (int x = 0; x < basicMaze.size(); x += 1) {
-    QVector<int> column;
-    for (int y = 0; y < basicMaze.at(x).size(); y += 1) {
-      column.append(-1);
+  for (int i = 0; i < queue.size(); i += 1) {
+    if (m_distances.at(queue.at(i)) != oldDistances.at(i)) {
+      changed.append(queue.at(i));
     }
-    distances.append(column);
   }
+  return changed;
+}
 
-  // Set the distances of the center positions to 0 and enqueue them
-  QQueue<QPair<int, int>> discovered;
-  int width = basicMaze.size();
-  int height = basicMaze.at(0).size();
-  for (QPair<int, int> position : getCenterPositions(width, height)) {
-    distances[position.first][position.second] = 0;
-    discovered.enqueue(position);
-  }
-
-  // Perform a breadth first search
-  while (!discovered.empty()) {
-    QPair<int, int> position = discovered.dequeue();
-    int x = position.first;
-    int y = position.second;
-    for (Direction direction : CARDINAL_DIRECTIONS()) {
-      if (!basicMaze.at(x).at(y).value(direction)) {
-        int nx = x;
-        int ny = y;
-        if (direction == Direction::NORTH) {
-          ny += 1;
-        }
-        if (direction == Direction::EAST) {
-          nx += 1;
-        }
-        if (direction == Direction::SOUTH) {
-          ny -= 1;
-        }
-        if (direction == Direction::WEST) {
-          nx -= 1;
-        }
-        if (distances.at(nx).at(ny) == -1) {
-          distances[nx][ny] = distances.at(x).at(y) + 1;
-          discovered.enqueue({nx, ny});
-        }
-      }
+bool Maze::hasShortestPath(int index, const QSet<int> &excluded) const {
+  // Whether some open neighbor, other than the excluded ones, is one step
+  // closer to the center
+  for (const QPair<Direction, int> &offset : getNeighborOffsets(m_height)) {
+    int neighbor = index + offset.second;
+    if (!(m_walls.at(index) & getWallBit(offset.first)) &&
+        m_distances.at(neighbor) == m_distances.at(index) - 1 &&
+        !excluded.contains(neighbor)) {
+      return true;
     }
   }
-  return distances;
+  return false;
 }
 
 QVector<QPair<int, int>> Maze::getCenterPositions(int width, int height) {
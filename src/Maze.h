@@ -1,41 +1,133 @@
 #pragma once
 
+#include <QByteArray>
+#include <QPair>
+#include <QSet>
 #include <QString>
 #include <QVector>
 
-#include "Tile.h"
+#include "Direction.h"
 
 namespace mms {
 
-typedef QVector<QVector<QMap<Direction, bool>>> BasicMaze;
-
+// The walls of each tile are stored as a 4-bit mask, one bit per direction,
+// in a flat array indexed by height * x + y. Wall queries are single bit
+// tests, and a 256x256 maze takes only 64 KiB of walls.
 class Maze {
  public:
+  // The most tiles along either side of a maze that any format loads, so
+  // that a corrupt or hostile file can't make a huge allocation
+  static const int MAX_SIZE;
+
+  // Loads a map, num, or binary maze file, or an entry of a corpus given as
+  // "path#index" (see MazeCorpus)
   static Maze *fromFile(const QString &path);
 
+  // Parses the contents of a map, num, or binary maze file, sniffing the
+  // format from the first bytes, e.g., of an entry of an archive
+  static Maze *fromBytes(const QByteArray &bytes);
+
+  // The versioned binary format: a small header followed by the wall masks,
+  // packed two per byte, which can be used straight from a mapped file
+  static Maze *fromBinary(const QByteArray &bytes);
+  QByteArray toBinary() const;
+
+  // Packs wall masks in the binary format without making a maze of them, so
+  // they aren't validated, e.g., for mazes that are valid by construction
+  static QByteArray toBinary(int width, int height,
+                             const QVector<unsigned char> &walls);
+
+  // The text formats, as read by fromFile, e.g., to save an edited maze
+  QByteArray toMapFile() const;
+  QByteArray toNumFile() const;
+
+  // A hash that's the same for every rotation and reflection of the maze
+  // that puts a tile like its start (i.e., with the same walls) in the start
+  // corner, e.g., to find copies of a maze that were stored the other way
+  // around. Its smallest binary form under those symmetries is hashed.
+  QByteArray getCanonicalHash() const;
+
   int getWidth() const;
   int getHeight() const;
-  const Tile *getTile(int x, int y) const;
+
+  // The heap memory that the maze holds, e.g., for the memory report (see
+  // MemoryReport)
+  qint64 getMemoryBytes() const;
+
+  bool isWall(int x, int y, Direction direction) const;
+  unsigned char getWalls(int x, int y) const;
+  int getDistance(int x, int y) const;
   bool isInCenter(QPair<int, int> location) const;
 
+  // Sets or clears a wall, on both of the tiles that share it, and repairs
+  // only the distances that are affected. Walls on the border of the maze
+  // can't be cleared. Returns the tiles whose distances changed.
+  QVector<QPair<int, int>> setWall(int x, int y, Direction direction,
+                                   bool isWall);
+
+  // The bit of a wall mask that corresponds to the given direction
+  static unsigned char getWallBit(Direction direction);
+
+  // The one, two, or four tiles in the center of a maze of the given size
+  static QVector<QPair<int, int>> getCenterPositions(int width, int height);
+
  private:
-  QVector<QVector<Tile>> m_tiles;
-  explicit Maze(BasicMaze basicMaze);
+  static const quint32 BINARY_MAGIC;
+  static const quint16 BINARY_VERSION;
+  static const int BINARY_HEADER_SIZE;
+
+  int m_width;
+  int m_height;
+  QVector<unsigned char> m_walls;
+  QVector<int> m_distances;
+  Maze(int width, int height, QVector<unsigned char> walls);
+  int getIndex(int x, int y) const;
+
+  // Each text format is parsed in a single pass straight into wall masks
+  static Maze *fromMapFile(const QByteArray &bytes);
+  static Maze *fromNumFile(const QByteArray &bytes);
+  static Maze *fromWalls(int width, int height, QVector<unsigned char> walls);
 
-  // Maze file formats
-  static Maze *fromMapFile(QVector<QString> lines);
-  static Maze *fromNumFile(QVector<QString> lines);
+  // Parsing helpers; lines exclude the terminating newline (and carriage
+  // return, if any)
+  static bool getNextLine(const QByteArray &bytes, int *start,
+                          const char **line, int *length);
+  static bool getNumFileValues(const char *line, int length, int *values);
 
   // Validate the maze
-  static bool isValid(const BasicMaze &basicMaze);
-  static bool isNonempty(const BasicMaze &basicMaze);
-  static bool isRectangular(const BasicMaze &basicMaze);
-  static bool isEnclosed(const BasicMaze &basicMaze);
-  static bool isConsistent(const BasicMaze &basicMaze);
+  static bool isValid(int width, int height,
+                      const QVector<unsigned char> &walls);
+
+  // The walls of the maze turned a quarter turn clockwise, which swaps its
+  // width and height, or mirrored east to west
+  static QVector<unsigned char> rotate(int width, int height,
+                                       const QVector<unsigned char> &walls);
+  static QVector<unsigned char> reflect(int width, int height,
+                                        const QVector<unsigned char> &walls);
+  static bool isNonempty(int width, int height);
+  static bool isEnclosed(int width, int height,
+                         const QVector<unsigned char> &walls);
+  static bool isConsistent(int width, int height,
+                           const QVector<unsigned char> &walls);
+
+  // Whether, for each of the first count tiles, the wall in the first
+  // direction matches the wall in the second direction of the tile offset
+  // tiles later
+  static bool areWallsPaired(const unsigned char *walls, int count,
+                             int offset, Direction first, Direction second);
 
   // Populate distances
-  static QVector<QVector<int>> getDistances(BasicMaze basicMaze);
-  static QVector<QPair<int, int>> getCenterPositions(int width, int height);
+  static QVector<int> getDistances(int width, int height,
+                                   const QVector<unsigned char> &walls);
+  static QVector<QPair<Direction, int>> getNeighborOffsets(int height);
+
+  // Repair distances after a wall is removed, i.e., when the distance of
+  // "to" may drop to one more than that of "from", or after a wall is added,
+  // i.e., when "start" may have lost its shortest path to the center. Both
+  // return the indices of the tiles whose distances changed.
+  QVector<int> decreaseDistances(int from, int to);
+  QVector<int> increaseDistances(int start);
+  bool hasShortestPath(int index, const QSet<int> &excluded) const;
 };
 
 }  // namespace mms
@@ -0,0 +1,251 @@
+#include "MazeArchive.h"
+
+#include <QFile>
+#include <QFuture>
+#include <QList>
+#include <QProcess>
+#include <QSet>
+#include <QtConcurrent>
+
+#include "Maze.h"
+#include "Profiler.h"
+
+namespace mms {
+
+const int MazeArchive::BLOCK_SIZE = 512;
+const int MazeArchive::BATCH_SIZE = 1024;
+const qint64 MazeArchive::MAX_ENTRY_SIZE = 64 * 1024 * 1024;
+
+bool MazeArchive::read(const QString &path, Contents *contents,
+                       QString *error) {
+  PROFILE_SCOPE("MazeArchive::read");
+  QFile file;
+  QProcess process;
+  QIODevice *device = &file;
+  QStringList decompressor = getDecompressor(path);
+  if (path == "-") {
+    file.open(stdin, QFile::ReadOnly);
+  } else if (!QFile::exists(path)) {
+    *error = QString("Could not open \"%1\".").arg(path);
+    return false;
+  } else if (decompressor.isEmpty()) {
+    file.setFileName(path);
+    if (!file.open(QFile::ReadOnly)) {
+      *error = QString("Could not open \"%1\".").arg(path);
+      return false;
+    }
+  } else {
+    // The tool's own errors, e.g., of a corrupt archive, go to stderr
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.setProgram(decompressor.takeFirst());
+    process.setArguments(decompressor);
+    process.start(QIODevice::ReadOnly);
+    if (!process.waitForStarted(-1)) {
+      *error = QString("Could not run \"%1\".").arg(process.program());
+      return false;
+    }
+    device = &process;
+  }
+
+  // A batch is hashed while the next one is read, and the results are taken
+  // in order, so the corpus doesn't depend on the timing of the threads
+  contents->mazes.clear();
+  contents->numInvalid = 0;
+  contents->numDuplicates = 0;
+  QSet<QByteArray> hashes;
+  auto collect = [&](const QList<Parsed> &results) {
+    for (const Parsed &parsed : results) {
+      if (parsed.hash.isNull()) {
+        contents->numInvalid += 1;
+      } else if (hashes.contains(parsed.hash)) {
+        contents->numDuplicates += 1;
+      } else {
+        hashes.insert(parsed.hash);
+        contents->mazes.append(parsed.binary);
+      }
+    }
+  };
+  QVector<QByteArray> batch;
+  QFuture<Parsed> pending;
+  bool isPending = false;
+  bool isEnd = false;
+  QString reason;
+  while (!isEnd) {
+    QByteArray bytes;
+    if (!readEntry(device, &bytes, &isEnd, &reason)) {
+      *error = QString("Could not read \"%1\", %2.").arg(path, reason);
+      return false;
+    }
+    if (!isEnd) {
+      batch.append(bytes);
+    }
+    if (batch.size() == BATCH_SIZE || (isEnd && !batch.isEmpty())) {
+      if (isPending) {
+        collect(pending.results());
+      }
+      pending = QtConcurrent::mapped(batch, &MazeArchive::parse);
+      isPending = true;
+      batch.clear();
+    }
+  }
+  if (isPending) {
+    collect(pending.results());
+  }
+
+  if (device == &process) {
+    process.waitForFinished(-1);
+    if (process.exitStatus() != QProcess::NormalExit ||
+        process.exitCode() != 0) {
+      *error = QString("Could not decompress \"%1\".").arg(path);
+      return false;
+    }
+  }
+  return true;
+}
+
+QStringList MazeArchive::getDecompressor(const QString &path) {
+  QString name = path.toLower();
+  if (name.endsWith(".tar.gz") || name.endsWith(".tgz")) {
+    return {"gzip", "-dc", "--", path};
+  }
+  if (name.endsWith(".tar.xz") || name.endsWith(".txz")) {
+    return {"xz", "-dc", "--", path};
+  }
+  if (name.endsWith(".tar.bz2") || name.endsWith(".tbz2")) {
+    return {"bzip2", "-dc", "--", path};
+  }
+  if (name.endsWith(".tar.zst") || name.endsWith(".tzst")) {
+    return {"zstd", "-dc", "--", path};
+  }
+  if (name.endsWith(".zip")) {
+    return {"bsdtar", "-cf", "-", "@" + path};
+  }
+  return {};
+}
+
+bool MazeArchive::readEntry(QIODevice *device, QByteArray *bytes,
+                            bool *isEnd, QString *error) {
+  // Directories, links, and the extended headers of long names are skipped,
+  // since the format of a maze file is sniffed rather than named
+  QByteArray header(BLOCK_SIZE, '\0');
+  while (true) {
+    qint64 count = readFully(device, header.data(), BLOCK_SIZE);
+    if (count == 0 || header.count('\0') == BLOCK_SIZE) {
+      // Some writers leave out the zeroed blocks at the end
+      *isEnd = true;
+      return true;
+    }
+    if (count < BLOCK_SIZE) {
+      *error = "it's truncated";
+      return false;
+    }
+    qint64 size = getSize(header.constData());
+    if (!isChecksumValid(header.constData()) || size < 0) {
+      *error = "it isn't a tar archive";
+      return false;
+    }
+    qint64 padding = (BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE;
+    char type = header.at(156);
+    bool isFile = type == '0' || type == '\0' || type == '7';
+    if (!isFile || MAX_ENTRY_SIZE < size) {
+      if (!skip(device, size + padding)) {
+        *error = "it's truncated";
+        return false;
+      }
+      if (isFile) {
+        bytes->clear();
+        return true;
+      }
+      continue;
+    }
+    bytes->resize(size);
+    if (readFully(device, bytes->data(), size) < size ||
+        !skip(device, padding)) {
+      *error = "it's truncated";
+      return false;
+    }
+    return true;
+  }
+}
+
+qint64 MazeArchive::readFully(QIODevice *device, char *data, qint64 size) {
+  qint64 done = 0;
+  while (done < size) {
+    qint64 count = device->read(data + done, size - done);
+    if (count < 0 || (count == 0 && !device->waitForReadyRead(-1))) {
+      break;
+    }
+    done += count;
+  }
+  return done;
+}
+
+bool MazeArchive::skip(QIODevice *device, qint64 size) {
+  QByteArray buffer(qMin<qint64>(size, 64 * 1024), '\0');
+  while (0 < size) {
+    qint64 count = qMin<qint64>(size, buffer.size());
+    if (readFully(device, buffer.data(), count) < count) {
+      return false;
+    }
+    size -= count;
+  }
+  return true;
+}
+
+qint64 MazeArchive::parseOctal(const char *field, int size) {
+  // Padded with spaces or nulls on either side, depending on the writer
+  int i = 0;
+  while (i < size && field[i] == ' ') {
+    i += 1;
+  }
+  qint64 value = 0;
+  int numDigits = 0;
+  for (; i < size && '0' <= field[i] && field[i] <= '7'; i += 1) {
+    value = value * 8 + (field[i] - '0');
+    numDigits += 1;
+  }
+  if (numDigits == 0 || (i < size && field[i] != ' ' && field[i] != '\0')) {
+    return -1;
+  }
+  return value;
+}
+
+qint64 MazeArchive::getSize(const char *header) {
+  // Sizes too big for the octal field are stored in base 256, flagged by the
+  // high bit of the first byte
+  const char *field = header + 124;
+  if ((field[0] & 0x80) == 0) {
+    return parseOctal(field, 12);
+  }
+  qint64 size = 0;
+  for (int i = 1; i < 12; i += 1) {
+    if ((size >> 55) != 0) {
+      return -1;
+    }
+    size = (size << 8) | static_cast<unsigned char>(field[i]);
+  }
+  return size;
+}
+
+bool MazeArchive::isChecksumValid(const char *header) {
+  // The sum of the header's bytes, with the checksum field taken as spaces
+  qint64 sum = 0;
+  for (int i = 0; i < BLOCK_SIZE; i += 1) {
+    bool isChecksum = 148 <= i && i < 156;
+    sum += isChecksum ? ' ' : static_cast<unsigned char>(header[i]);
+  }
+  return parseOctal(header + 148, 8) == sum;
+}
+
+MazeArchive::Parsed MazeArchive::parse(const QByteArray &bytes) {
+  Parsed parsed;
+  Maze *maze = Maze::fromBytes(bytes);
+  if (maze != nullptr) {
+    parsed.hash = maze->getCanonicalHash();
+    parsed.binary = maze->toBinary();
+    delete maze;
+  }
+  return parsed;
+}
+
+}  // namespace mms
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace mms {
+
+// Streams the mazes out of an archive of maze files, e.g., a dump of a maze
+// collection, without extracting anything to disk. A tar archive is read
+// straight from its file, or from stdin as "-", and a compressed archive is
+// read from the output of the tool that decompresses it, so decompression
+// runs alongside everything else. Entries are parsed, validated, and hashed
+// on the global thread pool a batch at a time, while the next batch is read,
+// and copies of a maze are dropped, as when packing maze files.
+class MazeArchive {
+ public:
+  // The MazeArchive class is not constructible
+  MazeArchive() = delete;
+
+  struct Contents {
+    // In binary, in the order of the archive
+    QVector<QByteArray> mazes;
+    int numInvalid;
+    int numDuplicates;
+  };
+
+  // The format is picked by the file name: .tar.gz, .tgz, .tar.xz, .tar.bz2,
+  // and .tar.zst are decompressed by gzip, xz, bzip2, and zstd, a .zip is
+  // converted to a tar by bsdtar, and anything else is read as a plain tar.
+  // Entries that aren't maze files are counted as invalid.
+  static bool read(const QString &path, Contents *contents, QString *error);
+
+ private:
+  static const int BLOCK_SIZE;
+
+  // Enough that the hashing of a batch outlasts the reading of the next
+  static const int BATCH_SIZE;
+
+  // Bigger entries can't be maze files of any supported size, and are
+  // skipped without being buffered
+  static const qint64 MAX_ENTRY_SIZE;
+
+  // A null hash for an invalid maze
+  struct Parsed {
+    QByteArray hash;
+    QByteArray binary;
+  };
+
+  // The program and arguments that write the archive as a tar to stdout, or
+  // none for a plain tar
+  static QStringList getDecompressor(const QString &path);
+
+  // Reads the next regular file, skipping any other entries; the bytes of a
+  // file that's too big are left empty
+  static bool readEntry(QIODevice *device, QByteArray *bytes, bool *isEnd,
+                        QString *error);
+
+  // Blocks until the bytes are read, even from a pipe, returning fewer only
+  // at the end of the stream
+  static qint64 readFully(QIODevice *device, char *data, qint64 size);
+  static bool skip(QIODevice *device, qint64 size);
+
+  // Tar header fields; -1 for an invalid one
+  static qint64 parseOctal(const char *field, int size);
+  static qint64 getSize(const char *header);
+  static bool isChecksumValid(const char *header);
+
+  static Parsed parse(const QByteArray &bytes);
+};
+
+}  // namespace mms
@@ -0,0 +1,134 @@
+#include "MazeBitboard.h"
+
+#include <utility>
+
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include "AssertMacros.h"
+#include "Direction.h"
+
+namespace mms {
+
+template <int WIDTH, int HEIGHT>
+MazeBitboard<WIDTH, HEIGHT>::MazeBitboard(
+    const QVector<unsigned char> &walls) {
+  ASSERT_EQ(walls.size(), WIDTH * HEIGHT);
+
+  // Eight tiles at a time: the bit of each direction is its value (see
+  // Maze::getWallBit), so after shifting, the wall of interest is the lowest
+  // bit of each byte, and the multiplication gathers those eight bits into
+  // the top byte, in order
+  const quint64 lowestBits = 0x0101010101010101ULL;
+  const quint64 gather = 0x0102040810204080ULL;
+  const unsigned char *data = walls.constData();
+  for (int w = 0; w < NUM_WORDS; w += 1) {
+    quint64 closed[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 8; i += 1) {
+      quint64 masks = qFromLittleEndian<quint64>(data + 64 * w + 8 * i);
+      for (int d = 0; d < 4; d += 1) {
+        quint64 gathered = (((masks >> d) & lowestBits) * gather) >> 56;
+        closed[d] |= gathered << (8 * i);
+      }
+    }
+    for (int d = 0; d < 4; d += 1) {
+      m_open[d][w] = ~closed[d];
+    }
+  }
+}
+
+template <int WIDTH, int HEIGHT>
+int MazeBitboard<WIDTH, HEIGHT>::getNumPassages() const {
+  // The maze is enclosed, so each passage is open to the north or east of
+  // exactly one tile
+  int count = 0;
+  for (int w = 0; w < NUM_WORDS; w += 1) {
+    count += qPopulationCount(m_open[static_cast<int>(Direction::NORTH)][w]);
+    count += qPopulationCount(m_open[static_cast<int>(Direction::EAST)][w]);
+  }
+  return count;
+}
+
+template <int WIDTH, int HEIGHT>
+QVector<int> MazeBitboard<WIDTH, HEIGHT>::getDistances(
+    const QVector<QPair<int, int>> &sources) const {
+  QVector<int> distances(WIDTH * HEIGHT, -1);
+  int *data = distances.data();
+
+  // The frontier and the tiles that will be reached from it take turns in
+  // the same two boards, and only the words that might be nonzero are ever
+  // touched: a step moves a bit by less than a word, so the next frontier is
+  // within one word of the current one on either side. That keeps each pass
+  // cheap when the frontier is small, e.g., along a corridor.
+  Board boards[2];
+  boards[0].fill(0);
+  boards[1].fill(0);
+  Board *frontier = &boards[0];
+  Board *next = &boards[1];
+  int first = NUM_WORDS;
+  int last = -1;
+  for (const QPair<int, int> &source : sources) {
+    int index = HEIGHT * source.first + source.second;
+    (*frontier)[index / 64] |= 1ULL << (index % 64);
+    first = qMin(first, index / 64);
+    last = qMax(last, index / 64);
+  }
+  Board visited = *frontier;
+  for (int w = first; w <= last; w += 1) {
+    for (quint64 word = (*frontier)[w]; word != 0; word &= word - 1) {
+      data[64 * w + qCountTrailingZeroBits(word)] = 0;
+    }
+  }
+
+  const Board &north = m_open[static_cast<int>(Direction::NORTH)];
+  const Board &east = m_open[static_cast<int>(Direction::EAST)];
+  const Board &south = m_open[static_cast<int>(Direction::SOUTH)];
+  const Board &west = m_open[static_cast<int>(Direction::WEST)];
+  for (int distance = 1; first <= last; distance += 1) {
+    int nextFirst = NUM_WORDS;
+    int nextLast = -1;
+    for (int w = qMax(0, first - 1); w <= qMin(NUM_WORDS - 1, last + 1);
+         w += 1) {
+      quint64 word = (*frontier)[w];
+      quint64 reached = ((word & north[w]) << 1) | ((word & south[w]) >> 1) |
+                        ((word & east[w]) << HEIGHT) |
+                        ((word & west[w]) >> HEIGHT);
+      if (0 < w) {
+        quint64 below = (*frontier)[w - 1];
+        reached |= ((below & north[w - 1]) >> 63) |
+                   ((below & east[w - 1]) >> (64 - HEIGHT));
+      }
+      if (w < NUM_WORDS - 1) {
+        quint64 above = (*frontier)[w + 1];
+        reached |= ((above & south[w + 1]) << 63) |
+                   ((above & west[w + 1]) << (64 - HEIGHT));
+      }
+      reached &= ~visited[w];
+      (*next)[w] = reached;
+      if (reached == 0) {
+        continue;
+      }
+      visited[w] |= reached;
+      nextFirst = qMin(nextFirst, w);
+      nextLast = w;
+      for (; reached != 0; reached &= reached - 1) {
+        data[64 * w + qCountTrailingZeroBits(reached)] = distance;
+      }
+    }
+    // Every other word of the old frontier is already clear, so this leaves
+    // the whole board clear for the pass after
+    for (int w = first; w <= last; w += 1) {
+      (*frontier)[w] = 0;
+    }
+    std::swap(frontier, next);
+    first = nextFirst;
+    last = nextLast;
+  }
+  return distances;
+}
+
+// The only sizes that are used, see Maze::getDistances
+template class MazeBitboard<16, 16>;
+template class MazeBitboard<32, 32>;
+
+}  // namespace mms
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+
+#include <QPair>
+#include <QVector>
+#include <QtGlobal>
+
+namespace mms {
+
+// The walls of a maze of a fixed size, as bitboards: for each direction, one
+// bit per tile, indexed by height * x + y (as in Maze), which is set if the
+// tile is open that way. A breadth first search can then expand its whole
+// frontier at once, with a few shifts and masks per 64-bit word, rather than
+// visiting the neighbors of each tile in turn. Only the common competition
+// sizes are instantiated, 16x16 (four words per board) and 32x32 (sixteen),
+// so that the number of words is a constant and the loops over them unroll;
+// mazes of any other size use the generic path in Maze.
+template <int WIDTH, int HEIGHT>
+class MazeBitboard {
+ public:
+  // The walls are masks of Maze::getWallBit, and the maze must be enclosed,
+  // so that no open bit ever leads out of it
+  explicit MazeBitboard(const QVector<unsigned char> &walls);
+
+  // The number of pairs of neighboring tiles with no wall between them.
+  // Each pass of the search costs about as much as visiting a few tiles, so
+  // it only pays off if the frontier is wide, which it isn't in a maze with
+  // few loops, i.e., with not many more passages than the tiles less one.
+  int getNumPassages() const;
+
+  // The same as Maze::getDistances, from the given tiles
+  QVector<int> getDistances(const QVector<QPair<int, int>> &sources) const;
+
+ private:
+  static_assert(WIDTH * HEIGHT % 64 == 0, "boards must fill whole words");
+  static_assert(HEIGHT < 64, "a step east or west must move by one word");
+  static constexpr int NUM_WORDS = WIDTH * HEIGHT / 64;
+  typedef std::array<quint64, NUM_WORDS> Board;
+
+  // Indexed by direction
+  Board m_open[4];
+};
+
+}  // namespace mms
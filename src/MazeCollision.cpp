@@ -0,0 +1,162 @@
+#include "MazeCollision.h"
+
+#include <QtMath>
+
+#include "Dimensions.h"
+#include "Triangle.h"
+
+namespace mms {
+
+bool MazeCollision::isColliding(const Maze *maze, const Polygon &polygon) {
+  return isColliding(maze, polygon, Coordinate());
+}
+
+bool MazeCollision::isColliding(const Maze *maze, const Polygon &polygon,
+                                const Coordinate &translation) {
+  // The walls near the whole swept shape are gathered once and shared by all
+  // of its triangles
+  QPointF offset = toPoint(translation);
+  QVector<QPointF> vertices;
+  for (const Coordinate &vertex : polygon.getVertices()) {
+    vertices.append(toPoint(vertex));
+    vertices.append(toPoint(vertex) + offset);
+  }
+  QVector<QRectF> rectangles =
+      getNearbyRectangles(maze, getBounds(vertices));
+  if (rectangles.isEmpty()) {
+    return false;
+  }
+
+  // The shape swept by a triangle is the convex hull of where it starts and
+  // ends, whose edges are either the triangle's or parallel to the move
+  for (const Triangle &triangle : polygon.getTriangles()) {
+    QVector<QPointF> corners = {toPoint(triangle.p1), toPoint(triangle.p2),
+                                toPoint(triangle.p3)};
+    QVector<QPointF> normals;
+    for (int i = 0; i < 3; i += 1) {
+      QPointF edge = corners.at((i + 1) % 3) - corners.at(i);
+      normals.append({-edge.y(), edge.x()});
+    }
+    if (!offset.isNull()) {
+      normals.append({-offset.y(), offset.x()});
+      for (int i = 0; i < 3; i += 1) {
+        corners.append(corners.at(i) + offset);
+      }
+    }
+    QRectF bounds = getBounds(corners);
+    for (const QRectF &rectangle : rectangles) {
+      if (bounds.intersects(rectangle) &&
+          isOverlapping(corners, normals, rectangle)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+QVector<QRectF> MazeCollision::getNearbyRectangles(const Maze *maze,
+                                                   const QRectF &bounds) {
+  // Grid line i is at i tile lengths, and everything on it, whether posts or
+  // walls, is within half a wall's width of it (see Tile::initPolygons)
+  double tileLength = Dimensions::tileLength().getMeters();
+  double halfWallWidth = Dimensions::halfWallWidth().getMeters();
+  int width = maze->getWidth();
+  int height = maze->getHeight();
+  int minLineX = qMax(0, qCeil((bounds.left() - halfWallWidth) / tileLength));
+  int maxLineX =
+      qMin(width, qFloor((bounds.right() + halfWallWidth) / tileLength));
+  int minLineY = qMax(0, qCeil((bounds.top() - halfWallWidth) / tileLength));
+  int maxLineY =
+      qMin(height, qFloor((bounds.bottom() + halfWallWidth) / tileLength));
+  int minX = qMax(0, qFloor(bounds.left() / tileLength));
+  int maxX = qMin(width - 1, qFloor(bounds.right() / tileLength));
+  int minY = qMax(0, qFloor(bounds.top() / tileLength));
+  int maxY = qMin(height - 1, qFloor(bounds.bottom() / tileLength));
+
+  // The rectangles' top is their lowest coordinate, as with the bounds
+  QVector<QRectF> rectangles;
+  double wallLength = tileLength - 2.0 * halfWallWidth;
+  for (int i = minLineX; i <= maxLineX; i += 1) {
+    for (int j = minLineY; j <= maxLineY; j += 1) {
+      rectangles.append({i * tileLength - halfWallWidth,
+                         j * tileLength - halfWallWidth, 2.0 * halfWallWidth,
+                         2.0 * halfWallWidth});
+    }
+  }
+  for (int i = minLineX; i <= maxLineX; i += 1) {
+    for (int y = minY; y <= maxY; y += 1) {
+      bool isWall = i < width ? maze->isWall(i, y, Direction::WEST)
+                              : maze->isWall(i - 1, y, Direction::EAST);
+      if (isWall) {
+        rectangles.append({i * tileLength - halfWallWidth,
+                           y * tileLength + halfWallWidth,
+                           2.0 * halfWallWidth, wallLength});
+      }
+    }
+  }
+  for (int j = minLineY; j <= maxLineY; j += 1) {
+    for (int x = minX; x <= maxX; x += 1) {
+      bool isWall = j < height ? maze->isWall(x, j, Direction::SOUTH)
+                               : maze->isWall(x, j - 1, Direction::NORTH);
+      if (isWall) {
+        rectangles.append({x * tileLength + halfWallWidth,
+                           j * tileLength - halfWallWidth, wallLength,
+                           2.0 * halfWallWidth});
+      }
+    }
+  }
+  return rectangles;
+}
+
+bool MazeCollision::isOverlapping(const QVector<QPointF> &points,
+                                  const QVector<QPointF> &normals,
+                                  const QRectF &rectangle) {
+  // The rectangle's own axes were already checked against the bounds, so
+  // only the hull's remain; the shapes overlap unless one separates them
+  QVector<QPointF> corners = {rectangle.topLeft(), rectangle.topRight(),
+                              rectangle.bottomRight(), rectangle.bottomLeft()};
+  for (const QPointF &normal : normals) {
+    if (normal.isNull()) {
+      continue;  // a degenerate edge separates nothing
+    }
+    double minPoint = QPointF::dotProduct(points.first(), normal);
+    double maxPoint = minPoint;
+    for (const QPointF &point : points) {
+      double projection = QPointF::dotProduct(point, normal);
+      minPoint = qMin(minPoint, projection);
+      maxPoint = qMax(maxPoint, projection);
+    }
+    double minCorner = QPointF::dotProduct(corners.first(), normal);
+    double maxCorner = minCorner;
+    for (const QPointF &corner : corners) {
+      double projection = QPointF::dotProduct(corner, normal);
+      minCorner = qMin(minCorner, projection);
+      maxCorner = qMax(maxCorner, projection);
+    }
+    if (maxPoint <= minCorner || maxCorner <= minPoint) {
+      return false;
+    }
+  }
+  return true;
+}
+
+QRectF MazeCollision::getBounds(const QVector<QPointF> &points) {
+  double minX = points.first().x();
+  double maxX = minX;
+  double minY = points.first().y();
+  double maxY = minY;
+  for (const QPointF &point : points) {
+    minX = qMin(minX, point.x());
+    maxX = qMax(maxX, point.x());
+    minY = qMin(minY, point.y());
+    maxY = qMax(maxY, point.y());
+  }
+  return QRectF(minX, minY, maxX - minX, maxY - minY);
+}
+
+QPointF MazeCollision::toPoint(const Coordinate &coordinate) {
+  return QPointF(coordinate.getX().getMeters(),
+                 coordinate.getY().getMeters());
+}
+
+}  // namespace mms
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+#include "Maze.h"
+#include "Polygon.h"
+#include "units/Coordinate.h"
+
+namespace mms {
+
+// Collision detection between a shape, e.g., the body of the mouse (see
+// Mouse::getCurrentBodyPolygon), and the walls and posts of a maze, as they
+// are drawn (see Tile). The tiles are already a uniform grid, so the only
+// rectangles that are tested are those of the grid lines that the shape's
+// bounding box touches, which is a handful, no matter how large the maze
+// is. Each triangle of the shape is tested against each nearby rectangle by
+// separating axes, since both are convex.
+class MazeCollision {
+ public:
+  MazeCollision() = delete;
+
+  // Whether the polygon overlaps any wall or post; every post is solid,
+  // whether or not any walls meet at it. Touching doesn't count.
+  static bool isColliding(const Maze *maze, const Polygon &polygon);
+
+  // Whether the polygon overlaps any wall or post at any point along a
+  // straight move by the translation, not only where it starts and ends,
+  // i.e., whether the swept shape does; a rotation can be checked as a
+  // sequence of short moves between the poses along it
+  static bool isColliding(const Maze *maze, const Polygon &polygon,
+                          const Coordinate &translation);
+
+ private:
+  // The walls and posts within or on the border of the bounds
+  static QVector<QRectF> getNearbyRectangles(const Maze *maze,
+                                             const QRectF &bounds);
+
+  // Whether the convex hull of the points overlaps the rectangle, given the
+  // normals of the hull's edges
+  static bool isOverlapping(const QVector<QPointF> &points,
+                            const QVector<QPointF> &normals,
+                            const QRectF &rectangle);
+
+  static QRectF getBounds(const QVector<QPointF> &points);
+  static QPointF toPoint(const Coordinate &coordinate);
+};
+
+}  // namespace mms
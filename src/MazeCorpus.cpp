@@ -0,0 +1,212 @@
+#include "MazeCorpus.h"
+
+#include <QFile>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include "MazeSolver.h"
+
+namespace mms {
+
+// Layout (all integers are little-endian):
+//   [0, 4)             magic ("MMSC")
+//   [4, 6)             version
+//   [6, 8)             reserved, zero
+//   [8, 12)            number of mazes, N
+//   [12, 12 + 24N)     index: for each maze, its offset and size (quint32),
+//                      then its metrics: optimal cost (float), distance and
+//                      dead ends (qint32), and branching factor (float)
+//   [12 + 24N, ...)    the mazes, in the binary maze format
+// Version 1 corpora, whose index entries are only the offset and size, can
+// still be read, but have no metrics.
+const quint32 MazeCorpus::MAGIC = 0x43534d4d;  // "MMSC"
+const quint16 MazeCorpus::VERSION = 2;
+const quint16 MazeCorpus::MIN_VERSION = 1;
+const int MazeCorpus::HEADER_SIZE = 12;
+const int MazeCorpus::INDEX_ENTRY_SIZE = 24;
+const int MazeCorpus::VERSION_1_INDEX_ENTRY_SIZE = 8;
+const int MazeCorpus::GPU_BATCH_SIZE = 16384;
+
+int MazeCorpus::getSize(const QString &path) {
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly)) {
+    return -1;
+  }
+  QByteArray header = file.read(HEADER_SIZE);
+  if (header.size() < HEADER_SIZE) {
+    return -1;
+  }
+  return getSize(reinterpret_cast<const uchar *>(header.constData()),
+                 file.size());
+}
+
+QString MazeCorpus::getEntryPath(const QString &path, int index) {
+  return path + "#" + QString::number(index);
+}
+
+bool MazeCorpus::parseEntryPath(const QString &entryPath, QString *path,
+                                int *index) {
+  int separator = entryPath.lastIndexOf('#');
+  if (separator == -1) {
+    return false;
+  }
+  bool ok = true;
+  *index = entryPath.mid(separator + 1).toInt(&ok);
+  *path = entryPath.left(separator);
+  return ok;
+}
+
+Maze *MazeCorpus::getMaze(const QString &path, int index) {
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly)) {
+    return nullptr;
+  }
+
+  // Only the pages of the index entry and the maze itself are ever read
+  qint64 size = file.size();
+  uchar *data = 0 < size ? file.map(0, size) : nullptr;
+  if (data == nullptr) {
+    return nullptr;
+  }
+  Maze *maze = nullptr;
+  if (0 <= index && index < getSize(data, size)) {
+    const uchar *entry = data + HEADER_SIZE + getIndexEntrySize(data) * index;
+    qint64 offset = qFromLittleEndian<quint32>(entry);
+    qint64 length = qFromLittleEndian<quint32>(entry + 4);
+    if (offset + length <= size) {
+      maze = Maze::fromBinary(QByteArray::fromRawData(
+          reinterpret_cast<const char *>(data + offset),
+          static_cast<int>(length)));
+    }
+  }
+  file.unmap(data);
+  return maze;
+}
+
+bool MazeCorpus::getMetrics(const QString &path, int index,
+                            MazeMetrics *metrics) {
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly)) {
+    return false;
+  }
+  QByteArray header = file.read(HEADER_SIZE);
+  if (header.size() < HEADER_SIZE) {
+    return false;
+  }
+  const uchar *headerData = reinterpret_cast<const uchar *>(header.constData());
+  if (index < 0 || getSize(headerData, file.size()) <= index ||
+      qFromLittleEndian<quint16>(headerData + 4) < VERSION) {
+    return false;
+  }
+  int entrySize = getIndexEntrySize(headerData);
+  if (!file.seek(HEADER_SIZE + static_cast<qint64>(entrySize) * index)) {
+    return false;
+  }
+  QByteArray entry = file.read(entrySize);
+  if (entry.size() < entrySize) {
+    return false;
+  }
+  const uchar *entryData = reinterpret_cast<const uchar *>(entry.constData());
+  metrics->optimalCost = qFromLittleEndian<float>(entryData + 8);
+  metrics->distance = qFromLittleEndian<qint32>(entryData + 12);
+  metrics->deadEnds = qFromLittleEndian<qint32>(entryData + 16);
+  metrics->branchingFactor = qFromLittleEndian<float>(entryData + 20);
+  return true;
+}
+
+bool MazeCorpus::write(const QString &path, const QVector<QByteArray> &mazes,
+                       GpuMazeMetrics *gpuMetrics) {
+  // Mazes that can't be parsed are still written, with metrics as if the
+  // center were unreachable, so that the indices match the input
+  QVector<MazeMetrics> metrics;
+  if (gpuMetrics != nullptr) {
+    metrics = getGpuMetrics(mazes, gpuMetrics);
+  } else {
+    metrics = QtConcurrent::blockingMapped(mazes, [](const QByteArray &bytes) {
+      MazeMetrics metrics = {-1.0, -1, 0, 0.0};
+      Maze *maze = Maze::fromBinary(bytes);
+      if (maze != nullptr) {
+        metrics = MazeMetrics::fromMaze(maze);
+        delete maze;
+      }
+      return metrics;
+    });
+  }
+
+  QByteArray header(HEADER_SIZE + INDEX_ENTRY_SIZE * mazes.size(), 0);
+  uchar *data = reinterpret_cast<uchar *>(header.data());
+  qToLittleEndian<quint32>(MAGIC, data);
+  qToLittleEndian<quint16>(VERSION, data + 4);
+  qToLittleEndian<quint32>(mazes.size(), data + 8);
+  qint64 offset = header.size();
+  for (int i = 0; i < mazes.size(); i += 1) {
+    uchar *entry = data + HEADER_SIZE + INDEX_ENTRY_SIZE * i;
+    qToLittleEndian<quint32>(offset, entry);
+    qToLittleEndian<quint32>(mazes.at(i).size(), entry + 4);
+    qToLittleEndian<float>(metrics.at(i).optimalCost, entry + 8);
+    qToLittleEndian<qint32>(metrics.at(i).distance, entry + 12);
+    qToLittleEndian<qint32>(metrics.at(i).deadEnds, entry + 16);
+    qToLittleEndian<float>(metrics.at(i).branchingFactor, entry + 20);
+    offset += mazes.at(i).size();
+  }
+
+  QFile file(path);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate) ||
+      file.write(header) != header.size()) {
+    return false;
+  }
+  for (const QByteArray &maze : mazes) {
+    if (file.write(maze) != maze.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+QVector<MazeMetrics> MazeCorpus::getGpuMetrics(
+    const QVector<QByteArray> &mazes, GpuMazeMetrics *gpuMetrics) {
+  // The optimal costs of a batch are searched for on the pool while the GPU
+  // computes the rest
+  QVector<MazeMetrics> metrics;
+  metrics.reserve(mazes.size());
+  for (int first = 0; first < mazes.size(); first += GPU_BATCH_SIZE) {
+    QVector<const Maze *> batch = QtConcurrent::blockingMapped(
+        mazes.mid(first, GPU_BATCH_SIZE), [](const QByteArray &bytes) {
+          return static_cast<const Maze *>(Maze::fromBinary(bytes));
+        });
+    QFuture<double> costs =
+        QtConcurrent::mapped(batch, [](const Maze *maze) {
+          return maze == nullptr ? -1.0 : MazeSolver::getOptimalCost(maze);
+        });
+    QVector<MazeMetrics> batchMetrics;
+    gpuMetrics->compute(batch, &batchMetrics);
+    QList<double> batchCosts = costs.results();
+    for (int i = 0; i < batch.size(); i += 1) {
+      batchMetrics[i].optimalCost = batchCosts.at(i);
+    }
+    qDeleteAll(batch);
+    metrics.append(batchMetrics);
+  }
+  return metrics;
+}
+
+int MazeCorpus::getSize(const uchar *header, qint64 fileSize) {
+  quint16 version = qFromLittleEndian<quint16>(header + 4);
+  if (fileSize < HEADER_SIZE || qFromLittleEndian<quint32>(header) != MAGIC ||
+      version < MIN_VERSION || VERSION < version) {
+    return -1;
+  }
+  qint64 count = qFromLittleEndian<quint32>(header + 8);
+  if (fileSize < HEADER_SIZE + getIndexEntrySize(header) * count) {
+    return -1;
+  }
+  return static_cast<int>(count);
+}
+
+int MazeCorpus::getIndexEntrySize(const uchar *header) {
+  return qFromLittleEndian<quint16>(header + 4) < VERSION
+             ? VERSION_1_INDEX_ENTRY_SIZE
+             : INDEX_ENTRY_SIZE;
+}
+
+}  // namespace mms
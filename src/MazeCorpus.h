@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "GpuMazeMetrics.h"
+#include "Maze.h"
+#include "MazeMetrics.h"
+
+namespace mms {
+
+// A corpus bundles many binary mazes (see Maze::toBinary) into a single file,
+// with an index of offsets so that any one of them can be loaded without
+// reading the rest, and the metrics of each maze, so that they needn't be
+// recomputed for every run. Entries of a corpus are referred to as
+// "path#index".
+class MazeCorpus {
+ public:
+  MazeCorpus() = delete;
+
+  // Returns the number of mazes in the corpus, or -1 if it isn't one
+  static int getSize(const QString &path);
+  static QString getEntryPath(const QString &path, int index);
+
+  // Splits "path#index"; returns false if the entry path isn't of that form
+  static bool parseEntryPath(const QString &entryPath, QString *path,
+                             int *index);
+
+  static Maze *getMaze(const QString &path, int index);
+
+  // Returns false if the metrics couldn't be read, e.g., the corpus predates
+  // them
+  static bool getMetrics(const QString &path, int index,
+                         MazeMetrics *metrics);
+
+  // Computes the metrics of every maze, in parallel, and writes them along
+  // with the mazes; returns false if the corpus couldn't be written. Given
+  // GPU metrics, all but the optimal costs are computed on the GPU, while
+  // the costs are computed on the CPU.
+  static bool write(const QString &path, const QVector<QByteArray> &mazes,
+                    GpuMazeMetrics *gpuMetrics);
+
+ private:
+  static const quint32 MAGIC;
+  static const quint16 VERSION;
+  static const quint16 MIN_VERSION;
+  static const int HEADER_SIZE;
+  static const int INDEX_ENTRY_SIZE;
+  static const int VERSION_1_INDEX_ENTRY_SIZE;
+
+  // The mazes whose metrics are computed on the GPU at once, which are all
+  // loaded at the same time
+  static const int GPU_BATCH_SIZE;
+
+  static QVector<MazeMetrics> getGpuMetrics(const QVector<QByteArray> &mazes,
+                                            GpuMazeMetrics *gpuMetrics);
+
+  // Returns the number of mazes, or -1 if the header is invalid; the header
+  // must be complete, but the rest of the file needn't be present
+  static int getSize(const uchar *header, qint64 fileSize);
+  static int getIndexEntrySize(const uchar *header);
+};
+
+}  // namespace mms
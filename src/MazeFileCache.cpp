@@ -0,0 +1,76 @@
+#include "MazeFileCache.h"
+
+#include <QFileInfo>
+
+#include "MazeThumbnail.h"
+
+namespace mms {
+
+const int MazeFileCache::THUMBNAIL_SIZE = 32;
+
+MazeFileCache::MazeFileCache(QObject *parent) : QObject(parent) {}
+
+MazeFileCache::~MazeFileCache() {
+  // The workers refer to the cache, so they must finish first; any results
+  // that they post afterwards are discarded along with the cache
+  m_pool.clear();
+  m_pool.waitForDone();
+}
+
+void MazeFileCache::validate(const QString &path) {
+  if (m_pending.contains(path)) {
+    return;
+  }
+  m_pending.insert(path);
+  bool isCached = m_entries.contains(path);
+  Entry cached = m_entries.value(path);
+  m_pool.start([=]() {
+    Entry entry = load(path, isCached, cached);
+    QMetaObject::invokeMethod(
+        this, [=]() { onValidated(path, entry); }, Qt::QueuedConnection);
+  });
+}
+
+bool MazeFileCache::get(const QString &path, Info *info) const {
+  if (!m_entries.contains(path)) {
+    return false;
+  }
+  *info = m_entries.value(path).info;
+  return true;
+}
+
+void MazeFileCache::onValidated(const QString &path, const Entry &entry) {
+  m_pending.remove(path);
+  m_entries.insert(path, entry);
+  emit validated(path, entry.info);
+}
+
+MazeFileCache::Entry MazeFileCache::load(const QString &path, bool isCached,
+                                         const Entry &cached) {
+  // An entry of a corpus (see Maze::fromFile) is modified along with the
+  // corpus file itself
+  QFileInfo file(path);
+  int separator = path.lastIndexOf('#');
+  if (!file.exists() && separator != -1) {
+    file = QFileInfo(path.left(separator));
+  }
+  Entry entry = {file.lastModified(), {file.exists(), false, 0, 0, QImage()}};
+  if (!entry.info.exists) {
+    return entry;
+  }
+  if (isCached && cached.info.exists &&
+      cached.lastModified == entry.lastModified) {
+    return cached;
+  }
+  Maze *maze = Maze::fromFile(path);
+  if (maze != nullptr) {
+    entry.info.isValid = true;
+    entry.info.width = maze->getWidth();
+    entry.info.height = maze->getHeight();
+    entry.info.thumbnail = MazeThumbnail::get(maze, THUMBNAIL_SIZE);
+    delete maze;
+  }
+  return entry;
+}
+
+}  // namespace mms
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+#include "Maze.h"
+
+namespace mms {
+
+// Validates maze files on a pool of worker threads, so that long lists of
+// maze files can be shown without the GUI thread ever touching the disk.
+// Results are cached by path and are only recomputed if the file has been
+// modified since it was last validated.
+class MazeFileCache : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Info {
+    bool exists;
+    bool isValid;
+    int width;  // zero unless valid, like the height
+    int height;
+    QImage thumbnail;  // null unless valid
+  };
+
+  MazeFileCache(QObject *parent = nullptr);
+  ~MazeFileCache();
+
+  // Validates the file in the background; validated() is emitted once it's
+  // done, on the thread that the cache lives on. Files that are already being
+  // validated aren't validated again.
+  void validate(const QString &path);
+
+  // Returns whether the file has been validated, and if so, the last result
+  bool get(const QString &path, Info *info) const;
+
+ signals:
+  void validated(const QString &path, const MazeFileCache::Info &info);
+
+ private:
+  static const int THUMBNAIL_SIZE;
+
+  struct Entry {
+    QDateTime lastModified;
+    Info info;
+  };
+
+  QThreadPool m_pool;
+  QHash<QString, Entry> m_entries;
+  QSet<QString> m_pending;
+
+  void onValidated(const QString &path, const Entry &entry);
+
+  // These run on the worker threads; the cached entry, if the path has one,
+  // is reused if the file hasn't been modified since
+  static Entry load(const QString &path, bool isCached, const Entry &cached);
+};
+
+}  // namespace mms
@@ -0,0 +1,309 @@
+#include "MazeGenerator.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "AssertMacros.h"
+#include "Maze.h"
+
+namespace mms {
+
+const QMap<QString, MazeAlgorithm> &STRING_TO_MAZE_ALGORITHM() {
+  static const QMap<QString, MazeAlgorithm> map = {
+      {"dfs", MazeAlgorithm::DFS},
+      {"prim", MazeAlgorithm::PRIM},
+      {"kruskal", MazeAlgorithm::KRUSKAL},
+      {"competition", MazeAlgorithm::COMPETITION},
+  };
+  return map;
+}
+
+const double MazeGenerator::COMPETITION_LOOP_FRACTION = 0.05;
+
+QByteArray MazeGenerator::generate(MazeAlgorithm algorithm, int width,
+                                   int height, quint32 seed) {
+  ASSERT_LT(0, width);
+  ASSERT_LT(0, height);
+
+  // Start with every wall, and knock them down
+  unsigned char allWalls = 0;
+  for (Direction direction : CARDINAL_DIRECTIONS()) {
+    allWalls |= Maze::getWallBit(direction);
+  }
+  Grid grid = {width, height, QVector<unsigned char>(width * height, allWalls)};
+  QRandomGenerator random(seed);
+  switch (algorithm) {
+    case MazeAlgorithm::DFS: {
+      QVector<bool> visited(width * height, false);
+      carveDfs(&grid, &visited, 0, &random);
+      break;
+    }
+    case MazeAlgorithm::PRIM:
+      carvePrim(&grid, &random);
+      break;
+    case MazeAlgorithm::KRUSKAL:
+      carveKruskal(&grid, &random);
+      break;
+    case MazeAlgorithm::COMPETITION:
+      carveCompetition(&grid, &random);
+      break;
+  }
+  return Maze::toBinary(width, height, grid.walls);
+}
+
+QVector<QByteArray> MazeGenerator::generate(MazeAlgorithm algorithm,
+                                            int width, int height, int count,
+                                            quint32 seed) {
+  // Each maze has its own generator, so they're completely independent
+  QVector<quint32> seeds;
+  seeds.reserve(count);
+  for (int i = 0; i < count; i += 1) {
+    seeds.append(seed + i);
+  }
+  return QtConcurrent::blockingMapped<QVector<QByteArray>>(
+      seeds, [=](quint32 mazeSeed) {
+        return generate(algorithm, width, height, mazeSeed);
+      });
+}
+
+int MazeGenerator::getNeighbor(const Grid &grid, int index,
+                               Direction direction) {
+  int x = index / grid.height;
+  int y = index % grid.height;
+  switch (direction) {
+    case Direction::NORTH:
+      return y + 1 < grid.height ? index + 1 : -1;
+    case Direction::EAST:
+      return x + 1 < grid.width ? index + grid.height : -1;
+    case Direction::SOUTH:
+      return 0 < y ? index - 1 : -1;
+    case Direction::WEST:
+      return 0 < x ? index - grid.height : -1;
+  }
+  ASSERT_NEVER_RUNS();
+  return -1;
+}
+
+void MazeGenerator::clearWall(Grid *grid, int index, Direction direction) {
+  int neighbor = getNeighbor(*grid, index, direction);
+  ASSERT_LE(0, neighbor);
+  Direction opposite = static_cast<Direction>(
+      (static_cast<int>(direction) + 2) % CARDINAL_DIRECTIONS().size());
+  grid->walls[index] &= ~Maze::getWallBit(direction);
+  grid->walls[neighbor] &= ~Maze::getWallBit(opposite);
+}
+
+void MazeGenerator::carveDfs(Grid *grid, QVector<bool> *visited, int start,
+                             QRandomGenerator *random) {
+  // An explicit stack, since the path can be as long as the maze is big
+  QVector<int> stack = {start};
+  (*visited)[start] = true;
+  while (!stack.isEmpty()) {
+    int index = stack.last();
+    Direction options[4];
+    int numOptions = 0;
+    for (Direction direction : CARDINAL_DIRECTIONS()) {
+      int neighbor = getNeighbor(*grid, index, direction);
+      if (neighbor != -1 && !visited->at(neighbor)) {
+        options[numOptions] = direction;
+        numOptions += 1;
+      }
+    }
+    if (numOptions == 0) {
+      stack.removeLast();
+      continue;
+    }
+    Direction direction = options[random->bounded(numOptions)];
+    int neighbor = getNeighbor(*grid, index, direction);
+    clearWall(grid, index, direction);
+    (*visited)[neighbor] = true;
+    stack.append(neighbor);
+  }
+}
+
+void MazeGenerator::carvePrim(Grid *grid, QRandomGenerator *random) {
+  // Grow the maze from a random tile, joining a random tile on its frontier
+  // to a random tile already in the maze at each step
+  int numTiles = grid->width * grid->height;
+  QVector<bool> visited(numTiles, false);
+  QVector<bool> isFrontier(numTiles, false);
+  QVector<int> frontier;
+  int index = random->bounded(numTiles);
+  while (true) {
+    visited[index] = true;
+    for (Direction direction : CARDINAL_DIRECTIONS()) {
+      int neighbor = getNeighbor(*grid, index, direction);
+      if (neighbor != -1 && !visited.at(neighbor) &&
+          !isFrontier.at(neighbor)) {
+        isFrontier[neighbor] = true;
+        frontier.append(neighbor);
+      }
+    }
+    if (frontier.isEmpty()) {
+      break;
+    }
+
+    // Removing from the middle by swapping with the last is O(1)
+    int i = random->bounded(frontier.size());
+    index = frontier.at(i);
+    frontier[i] = frontier.last();
+    frontier.removeLast();
+    Direction options[4];
+    int numOptions = 0;
+    for (Direction direction : CARDINAL_DIRECTIONS()) {
+      int neighbor = getNeighbor(*grid, index, direction);
+      if (neighbor != -1 && visited.at(neighbor)) {
+        options[numOptions] = direction;
+        numOptions += 1;
+      }
+    }
+    ASSERT_LT(0, numOptions);
+    clearWall(grid, index, options[random->bounded(numOptions)]);
+  }
+}
+
+void MazeGenerator::carveKruskal(Grid *grid, QRandomGenerator *random) {
+  // Each interior wall is the north or east wall of some tile, encoded as
+  // 2 * index plus 0 or 1, respectively
+  int numTiles = grid->width * grid->height;
+  QVector<int> walls;
+  for (int index = 0; index < numTiles; index += 1) {
+    if (getNeighbor(*grid, index, Direction::NORTH) != -1) {
+      walls.append(2 * index);
+    }
+    if (getNeighbor(*grid, index, Direction::EAST) != -1) {
+      walls.append(2 * index + 1);
+    }
+  }
+  std::shuffle(walls.begin(), walls.end(), *random);
+
+  // Knock down each wall that joins two separate sets of tiles, tracked by a
+  // union-find with path halving
+  QVector<int> parents(numTiles);
+  for (int i = 0; i < numTiles; i += 1) {
+    parents[i] = i;
+  }
+  auto find = [&](int i) {
+    while (parents.at(i) != i) {
+      parents[i] = parents.at(parents.at(i));
+      i = parents.at(i);
+    }
+    return i;
+  };
+  for (int wall : walls) {
+    int index = wall / 2;
+    Direction direction = wall % 2 == 0 ? Direction::NORTH : Direction::EAST;
+    int a = find(index);
+    int b = find(getNeighbor(*grid, index, direction));
+    if (a != b) {
+      parents[a] = b;
+      clearWall(grid, index, direction);
+    }
+  }
+}
+
+void MazeGenerator::carveCompetition(Grid *grid, QRandomGenerator *random) {
+  int numTiles = grid->width * grid->height;
+  QVector<bool> visited(numTiles, false);
+  if (grid->width < 3 || grid->height < 3) {
+    carveDfs(grid, &visited, 0, random);
+    return;
+  }
+
+  // The center is open inside, and is left out of the spanning tree
+  QVector<bool> isCenter(numTiles, false);
+  QVector<int> center;
+  for (const QPair<int, int> &position :
+       Maze::getCenterPositions(grid->width, grid->height)) {
+    int index = grid->height * position.first + position.second;
+    isCenter[index] = true;
+    visited[index] = true;
+    center.append(index);
+  }
+  for (int index : center) {
+    for (Direction direction : {Direction::NORTH, Direction::EAST}) {
+      int neighbor = getNeighbor(*grid, index, direction);
+      if (neighbor != -1 && isCenter.at(neighbor)) {
+        clearWall(grid, index, direction);
+      }
+    }
+  }
+
+  // The start is only open to the north, which is never the center since the
+  // maze is at least 3x3; removing the center and the start from the grid
+  // leaves every other tile connected, so the tree still spans them
+  visited[0] = true;
+  clearWall(grid, 0, Direction::NORTH);
+  carveDfs(grid, &visited, 1, random);
+
+  // The center has a single entrance
+  QVector<QPair<int, Direction>> entrances;
+  for (int index : center) {
+    for (Direction direction : CARDINAL_DIRECTIONS()) {
+      int neighbor = getNeighbor(*grid, index, direction);
+      if (neighbor != -1 && !isCenter.at(neighbor)) {
+        entrances.append({index, direction});
+      }
+    }
+  }
+  QPair<int, Direction> entrance =
+      entrances.at(random->bounded(entrances.size()));
+  clearWall(grid, entrance.first, entrance.second);
+
+  // Knock down a few walls away from the start and the center to make loops,
+  // so that there's more than one path, but never leave a post without walls
+  QVector<int> candidates;
+  for (int index = 1; index < numTiles; index += 1) {
+    for (int i = 0; i < 2; i += 1) {
+      Direction direction = i == 0 ? Direction::NORTH : Direction::EAST;
+      int neighbor = getNeighbor(*grid, index, direction);
+      if (neighbor != -1 && !isCenter.at(index) && !isCenter.at(neighbor) &&
+          (grid->walls.at(index) & Maze::getWallBit(direction))) {
+        candidates.append(2 * index + i);
+      }
+    }
+  }
+  std::shuffle(candidates.begin(), candidates.end(), *random);
+  int numLoops = candidates.size() * COMPETITION_LOOP_FRACTION;
+  for (int i = 0; i < candidates.size() && 0 < numLoops; i += 1) {
+    int index = candidates.at(i) / 2;
+    int x = index / grid->height;
+    int y = index % grid->height;
+    bool isNorth = candidates.at(i) % 2 == 0;
+    Direction direction = isNorth ? Direction::NORTH : Direction::EAST;
+    int neighbor = getNeighbor(*grid, index, direction);
+    unsigned char tileWalls = grid->walls.at(index);
+    unsigned char neighborWalls = grid->walls.at(neighbor);
+    clearWall(grid, index, direction);
+    // The posts at either end of the wall
+    bool hasWalls = isNorth ? hasWallAtPost(*grid, x, y + 1) &&
+                                  hasWallAtPost(*grid, x + 1, y + 1)
+                            : hasWallAtPost(*grid, x + 1, y) &&
+                                  hasWallAtPost(*grid, x + 1, y + 1);
+    if (hasWalls) {
+      numLoops -= 1;
+    } else {
+      grid->walls[index] = tileWalls;
+      grid->walls[neighbor] = neighborWalls;
+    }
+  }
+}
+
+bool MazeGenerator::hasWallAtPost(const Grid &grid, int x, int y) {
+  // Posts on the border always have the border
+  if (x == 0 || y == 0 || x == grid.width || y == grid.height) {
+    return true;
+  }
+  // The walls that meet at the post belong to the tiles below it
+  int lowerLeft = grid.height * (x - 1) + (y - 1);
+  int lowerRight = grid.height * x + (y - 1);
+  int upperLeft = grid.height * (x - 1) + y;
+  unsigned char north = Maze::getWallBit(Direction::NORTH);
+  unsigned char east = Maze::getWallBit(Direction::EAST);
+  return (grid.walls.at(lowerLeft) & north) ||
+         (grid.walls.at(lowerLeft) & east) ||
+         (grid.walls.at(lowerRight) & north) ||
+         (grid.walls.at(upperLeft) & east);
+}
+
+}  // namespace mms
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QString>
+#include <QVector>
+
+#include "Direction.h"
+
+namespace mms {
+
+enum class MazeAlgorithm {
+  DFS,          // long, winding corridors with few branches
+  PRIM,         // many short dead ends
+  KRUSKAL,      // somewhere in between
+  COMPETITION,  // a walled-off center with a single entrance, a start tile
+                // that's only open to the north, and a few loops
+};
+
+// Maps the names accepted by --generate to algorithms
+const QMap<QString, MazeAlgorithm> &STRING_TO_MAZE_ALGORITHM();
+
+// Generates random mazes, each of which is valid by construction: every tile
+// can be reached from every other tile, so the center is always reachable.
+// Mazes are made straight in the binary format (see Maze::toBinary), without
+// being parsed or validated, so that large corpora are cheap to make.
+class MazeGenerator {
+ public:
+  MazeGenerator() = delete;
+
+  // The same seed always generates the same maze. Competition mazes smaller
+  // than 3x3 have no room for a walled-off center, so they're made with DFS.
+  static QByteArray generate(MazeAlgorithm algorithm, int width, int height,
+                             quint32 seed);
+
+  // Generates mazes with consecutive seeds, starting at the given one, in
+  // parallel across all cores
+  static QVector<QByteArray> generate(MazeAlgorithm algorithm, int width,
+                                      int height, int count, quint32 seed);
+
+ private:
+  // The fraction of the interior walls that are left after carving a
+  // competition maze that are then knocked down to make loops
+  static const double COMPETITION_LOOP_FRACTION;
+
+  // Wall masks indexed by height * x + y, as in Maze
+  struct Grid {
+    int width;
+    int height;
+    QVector<unsigned char> walls;
+  };
+
+  // Returns the index of the neighboring tile, or -1 if there isn't one
+  static int getNeighbor(const Grid &grid, int index, Direction direction);
+
+  // Clears the wall on both of the tiles that share it
+  static void clearWall(Grid *grid, int index, Direction direction);
+
+  // Carve a spanning tree of the tiles, i.e., a maze without loops. DFS only
+  // visits the tiles that aren't visited yet, starting from the given one.
+  static void carveDfs(Grid *grid, QVector<bool> *visited, int start,
+                       QRandomGenerator *random);
+  static void carvePrim(Grid *grid, QRandomGenerator *random);
+  static void carveKruskal(Grid *grid, QRandomGenerator *random);
+  static void carveCompetition(Grid *grid, QRandomGenerator *random);
+
+  // Whether the post at the given corner of the tiles (from (0, 0) at the
+  // bottom left to (width, height) at the top right) has any wall attached
+  static bool hasWallAtPost(const Grid &grid, int x, int y);
+};
+
+}  // namespace mms
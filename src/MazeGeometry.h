@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QPair>
+#include <QVector>
+
+namespace mms {
+
+// The parts of a view's polygon buffers that only depend on the dimensions of
+// the maze, not on what's drawn: where the vertices are, how they make up
+// triangles, and where each samples its color from the tile state. It's built
+// by the first view of a maze and never changes afterwards, so any number of
+// views of the maze can share it, each holding only its own colors.
+struct MazeGeometry {
+  QPair<int, int> mazeSize;
+
+  // The x and y of each distinct vertex of each polygon, in meters
+  QVector<float> positions;
+
+  // Three indices into the vertices for each triangle; the triangles of the
+  // corners come last, after numIndicesWithoutCorners
+  QVector<unsigned int> indices;
+  int numIndicesWithoutCorners;
+
+  // For the bases, the walls, and the corners, where the triangles of each
+  // column of tiles start in the indices, plus where that kind of polygon
+  // ends. Tiles are inserted column by column, so the triangles of any range
+  // of columns are three ranges of the indices, e.g., the columns that the
+  // camera can see (see MapRenderer).
+  QVector<int> baseColumnStarts;
+  QVector<int> wallColumnStarts;
+  QVector<int> cornerColumnStarts;
+
+  // The coordinates of each vertex's color in the tile state texture
+  QVector<float> stateCoordinates;
+
+  // The index of the first vertex of each polygon, plus the total number of
+  // vertices, so that polygon i spans from element i up to element i + 1
+  QVector<int> polygonStartingVertices;
+};
+
+}  // namespace mms
@@ -1,66 +1,226 @@
 #include "MazeGraphic.h"
 
 #include "AssertMacros.h"
+#include "Dimensions.h"
 
 namespace mms {
 
+const unsigned char MazeGraphic::COLOR_CHANGED = 1 << 4;
+const unsigned char MazeGraphic::TEXT_CHANGED = 1 << 5;
+
+bool operator==(const TileState &lhs, const TileState &rhs) {
+  return lhs.walls == rhs.walls && lhs.hasColor == rhs.hasColor &&
+         (!lhs.hasColor || lhs.color == rhs.color) && lhs.text == rhs.text;
+}
+
+bool operator!=(const TileState &lhs, const TileState &rhs) {
+  return !(lhs == rhs);
+}
+
 MazeGraphic::MazeGraphic(const Maze *maze, BufferInterface *bufferInterface,
-                         bool isTruthView) {
+                         bool isTruthView)
+    : m_bufferInterface(bufferInterface),
+      m_height(maze->getHeight()),
+      m_tileGraphics(QVector<TileGraphic>()),
+      m_pendingChanges(maze->getWidth() * maze->getHeight(), 0),
+      m_pendingTiles(QVector<int>()),
+      m_isChanged(QVector<bool>()),
+      m_changedTiles(QVector<int>()),
+      m_path(QVector<SemiPosition>()),
+      m_pathColor(Color::BLACK) {
+  m_tileGraphics.reserve(maze->getWidth() * maze->getHeight());
   for (int x = 0; x < maze->getWidth(); x += 1) {
-    QVector<TileGraphic> column;
     for (int y = 0; y < maze->getHeight(); y += 1) {
-      column.append(
-          TileGraphic(maze->getTile(x, y), bufferInterface, isTruthView));
+      m_tileGraphics.append(
+          TileGraphic(maze, x, y, bufferInterface, isTruthView));
     }
-    m_tileGraphics.append(column);
   }
 }
 
 void MazeGraphic::setWall(int x, int y, Direction direction) {
-  m_tileGraphics[x][y].setWall(direction);
+  if (m_tileGraphics[getTileIndex(x, y)].setWall(direction)) {
+    addPendingChanges(x, y, Maze::getWallBit(direction));
+  }
 }
 
 void MazeGraphic::clearWall(int x, int y, Direction direction) {
-  m_tileGraphics[x][y].clearWall(direction);
+  if (m_tileGraphics[getTileIndex(x, y)].clearWall(direction)) {
+    addPendingChanges(x, y, Maze::getWallBit(direction));
+  }
 }
 
 void MazeGraphic::setColor(int x, int y, Color color) {
-  m_tileGraphics[x][y].setColor(color);
+  if (m_tileGraphics[getTileIndex(x, y)].setColor(color)) {
+    addPendingChanges(x, y, COLOR_CHANGED);
+  }
 }
 
 void MazeGraphic::clearColor(int x, int y) {
-  m_tileGraphics[x][y].clearColor();
+  if (m_tileGraphics[getTileIndex(x, y)].clearColor()) {
+    addPendingChanges(x, y, COLOR_CHANGED);
+  }
 }
 
 void MazeGraphic::setText(int x, int y, const QString &text) {
-  m_tileGraphics[x][y].setText(text);
+  if (m_tileGraphics[getTileIndex(x, y)].setText(text)) {
+    addPendingChanges(x, y, TEXT_CHANGED);
+  }
 }
 
-void MazeGraphic::clearText(int x, int y) { m_tileGraphics[x][y].clearText(); }
+void MazeGraphic::clearText(int x, int y) { setText(x, y, QString()); }
+
+void MazeGraphic::setColorGrid(const QVector<QPair<bool, Color>> &colors) {
+  ASSERT_EQ(colors.size(), m_tileGraphics.size());
+  for (int i = 0; i < colors.size(); i += 1) {
+    const QPair<bool, Color> &color = colors.at(i);
+    if (color.first) {
+      setColor(i / m_height, i % m_height, color.second);
+    } else {
+      clearColor(i / m_height, i % m_height);
+    }
+  }
+}
+
+void MazeGraphic::setTextGrid(const QVector<QString> &texts) {
+  ASSERT_EQ(texts.size(), m_tileGraphics.size());
+  for (int i = 0; i < texts.size(); i += 1) {
+    setText(i / m_height, i % m_height, texts.at(i));
+  }
+}
+
+void MazeGraphic::setPath(const QVector<SemiPosition> &path, Color color) {
+  QVector<Coordinate> points;
+  points.reserve(path.size());
+  for (const SemiPosition &semiPos : path) {
+    points.append(Coordinate::Cartesian(
+        Dimensions::halfTileLength() * static_cast<double>(semiPos.x),
+        Dimensions::halfTileLength() * static_cast<double>(semiPos.y)));
+  }
+  m_bufferInterface->updatePath(points, color);
+  m_path = path;
+  m_pathColor = color;
+}
+
+void MazeGraphic::clearPath() {
+  if (!m_path.isEmpty()) {
+    setPath({}, m_pathColor);
+  }
+}
+
+QVector<SemiPosition> MazeGraphic::getPath() const { return m_path; }
+
+Color MazeGraphic::getPathColor() const { return m_pathColor; }
+
+TileState MazeGraphic::getTileState(int x, int y) const {
+  const TileGraphic &tile = m_tileGraphics.at(getTileIndex(x, y));
+  return {tile.getWalls(), tile.hasColor(), tile.getColor(), tile.getText()};
+}
+
+void MazeGraphic::setTileState(int x, int y, const TileState &state) {
+  // Setting an unchanged part of the tile is a no-op
+  for (Direction direction : CARDINAL_DIRECTIONS()) {
+    if (state.walls & Maze::getWallBit(direction)) {
+      setWall(x, y, direction);
+    } else {
+      clearWall(x, y, direction);
+    }
+  }
+  if (state.hasColor) {
+    setColor(x, y, state.color);
+  } else {
+    clearColor(x, y);
+  }
+  setText(x, y, state.text);
+}
+
+void MazeGraphic::reset() {
+  // The colors are refreshed too, since the maze may have been edited since
+  // the tiles were drawn, which changes the alpha of undeclared walls
+  TileState initial = {0, false, Color::BLACK, QString()};
+  for (int i = 0; i < m_tileGraphics.size(); i += 1) {
+    setTileState(i / m_height, i % m_height, initial);
+  }
+  refreshColors();
+  clearPath();
+}
+
+void MazeGraphic::flush() {
+  for (int index : m_pendingTiles) {
+    TileGraphic &tile = m_tileGraphics[index];
+    unsigned char changes = m_pendingChanges.at(index);
+    for (Direction direction : CARDINAL_DIRECTIONS()) {
+      if (changes & Maze::getWallBit(direction)) {
+        tile.updateWall(direction);
+      }
+    }
+    if (changes & COLOR_CHANGED) {
+      tile.updateColor();
+    }
+    if (changes & TEXT_CHANGED) {
+      tile.updateText();
+    }
+    m_pendingChanges[index] = 0;
+  }
+  m_pendingTiles.clear();
+}
+
+bool MazeGraphic::hasPendingChanges() const {
+  return !m_pendingTiles.isEmpty();
+}
+
+QVector<int> MazeGraphic::takeChangedTiles() {
+  if (m_isChanged.isEmpty()) {
+    m_isChanged.fill(false, m_tileGraphics.size());
+  }
+  for (int index : m_changedTiles) {
+    m_isChanged[index] = false;
+  }
+  QVector<int> changed;
+  changed.swap(m_changedTiles);
+  return changed;
+}
+
+qint64 MazeGraphic::getMemoryBytes() const {
+  // Tile graphics hold their text inline, so they're all that a tile costs
+  return sizeof(TileGraphic) * m_tileGraphics.capacity() +
+         sizeof(unsigned char) * m_pendingChanges.capacity() +
+         sizeof(int) * m_pendingTiles.capacity() +
+         sizeof(bool) * m_isChanged.capacity() +
+         sizeof(int) * m_changedTiles.capacity() +
+         sizeof(SemiPosition) * m_path.capacity();
+}
 
 void MazeGraphic::drawPolygons() const {
   // Fill the GRAPHIC_CPU_BUFFER
-  for (int x = 0; x < m_tileGraphics.size(); x += 1) {
-    for (int y = 0; y < m_tileGraphics.at(x).size(); y += 1) {
-      m_tileGraphics.at(x).at(y).drawPolygons();
-    }
+  for (const TileGraphic &tile : m_tileGraphics) {
+    tile.drawPolygons();
   }
 }
 
-void MazeGraphic::drawTextures() const {
+void MazeGraphic::drawTextures() {
   // Fill the TEXTURE_CPU_BUFFER
-  for (int x = 0; x < m_tileGraphics.size(); x += 1) {
-    for (int y = 0; y < m_tileGraphics.at(x).size(); y += 1) {
-      m_tileGraphics[x][y].drawTextures();
-    }
+  for (TileGraphic &tile : m_tileGraphics) {
+    tile.drawTextures();
   }
 }
 
 void MazeGraphic::refreshColors() {
-  for (int x = 0; x < m_tileGraphics.size(); x += 1) {
-    for (int y = 0; y < m_tileGraphics.at(x).size(); y += 1) {
-      m_tileGraphics[x][y].refreshColors();
-    }
+  for (TileGraphic &tile : m_tileGraphics) {
+    tile.refreshColors();
+  }
+}
+
+int MazeGraphic::getTileIndex(int x, int y) const { return m_height * x + y; }
+
+void MazeGraphic::addPendingChanges(int x, int y, unsigned char changes) {
+  int index = getTileIndex(x, y);
+  if (m_pendingChanges.at(index) == 0) {
+    m_pendingTiles.append(index);
+  }
+  m_pendingChanges[index] |= changes;
+  if (!m_isChanged.isEmpty() && !m_isChanged.at(index)) {
+    m_isChanged[index] = true;
+    m_changedTiles.append(index);
   }
 }
 
@@ -1,14 +1,31 @@
 #pragma once
 
+#include <QPair>
 #include <QVector>
 
 #include "BufferInterface.h"
 #include "Color.h"
 #include "Maze.h"
+#include "Mouse.h"
 #include "TileGraphic.h"
 
 namespace mms {
 
+// The parts of a tile graphic that an algo can change
+struct TileState {
+  unsigned char walls;  // see Maze::getWallBit
+  bool hasColor;
+  Color color;  // only meaningful if hasColor
+  QString text;
+};
+
+bool operator==(const TileState &lhs, const TileState &rhs);
+bool operator!=(const TileState &lhs, const TileState &rhs);
+
+// Changes to the tiles are recorded as they're made, and written to the
+// buffers once per tile, by flush, just before they're uploaded; a tile that
+// changes several times between two frames, e.g., as an algo recolors it
+// while exploring, only has its last state written.
 class MazeGraphic {
  public:
   MazeGraphic(const Maze *maze, BufferInterface *bufferInterface,
@@ -23,13 +40,72 @@ class MazeGraphic {
   void setText(int x, int y, const QString &text);
   void clearText(int x, int y);
 
+  // Set every tile at once, given column by column, i.e., the tile at x, y is
+  // at index x * height + y. That's the order of the tiles in the buffers, so
+  // each is a single linear sweep over them. A tile without a color (the
+  // first of the pair is false) is cleared, as is one with empty text.
+  void setColorGrid(const QVector<QPair<bool, Color>> &colors);
+  void setTextGrid(const QVector<QString> &texts);
+
+  // A polyline through semi-positions, drawn over the tiles, e.g., an algo's
+  // planned route; setting a path replaces the previous one
+  void setPath(const QVector<SemiPosition> &path, Color color);
+  void clearPath();
+  QVector<SemiPosition> getPath() const;
+  Color getPathColor() const;
+
+  // For saving and restoring the view; only the parts of the tile that
+  // differ from the given state are updated
+  TileState getTileState(int x, int y) const;
+  void setTileState(int x, int y, const TileState &state);
+
+  // Clears everything that an algo could have changed, as if new
+  void reset();
+
+  // Writes the tiles that changed since the last flush to the buffers
+  void flush();
+  bool hasPendingChanges() const;
+
+  // The tiles that changed since the previous call, each just once, in the
+  // order they were first changed, e.g., for a LiveFeed, which reads them at
+  // its own pace rather than at every flush. Nothing is kept until the first
+  // call, which returns nothing.
+  QVector<int> takeChangedTiles();
+
+  // The heap memory of the tile graphics and the pending changes
+  qint64 getMemoryBytes() const;
+
   void drawPolygons() const;
-  void drawTextures() const;
+  void drawTextures();
 
   void refreshColors();
 
  private:
-  QVector<QVector<TileGraphic>> m_tileGraphics;
+  // What changed about a pending tile: the walls, by their bits (see
+  // Maze::getWallBit), and its color and text
+  static const unsigned char COLOR_CHANGED;
+  static const unsigned char TEXT_CHANGED;
+
+  BufferInterface *m_bufferInterface;
+
+  // By tile index (x * height + y), in a single allocation; each tile graphic
+  // is just its state, so building and freeing them is cheap (see Tile)
+  int m_height;
+  QVector<TileGraphic> m_tileGraphics;
+  int getTileIndex(int x, int y) const;
+
+  // Also by tile index, and the tiles with any changes, in the order they
+  // were first changed
+  QVector<unsigned char> m_pendingChanges;
+  QVector<int> m_pendingTiles;
+  void addPendingChanges(int x, int y, unsigned char changes);
+
+  // Likewise, for takeChangedTiles; empty until it's first called
+  QVector<bool> m_isChanged;
+  QVector<int> m_changedTiles;
+
+  QVector<SemiPosition> m_path;
+  Color m_pathColor;
 };
 
 }  // namespace mms
@@ -0,0 +1,47 @@
+#include "MazeMetrics.h"
+
+#include "MazeSolver.h"
+
+namespace mms {
+
+MazeMetrics MazeMetrics::fromMaze(const Maze *maze) {
+  MazeMetrics metrics;
+  metrics.optimalCost = MazeSolver::getOptimalCost(maze);
+  metrics.distance = maze->getDistance(0, 0);
+
+  // A junction is a tile with at least three open sides; arriving through
+  // one of them leaves the others as the ways onward
+  metrics.deadEnds = 0;
+  int junctions = 0;
+  int waysOnward = 0;
+  for (int x = 0; x < maze->getWidth(); x += 1) {
+    for (int y = 0; y < maze->getHeight(); y += 1) {
+      int openSides = 0;
+      for (Direction direction : CARDINAL_DIRECTIONS()) {
+        if (!maze->isWall(x, y, direction)) {
+          openSides += 1;
+        }
+      }
+      if (openSides == 1) {
+        metrics.deadEnds += 1;
+      } else if (3 <= openSides) {
+        junctions += 1;
+        waysOnward += openSides - 1;
+      }
+    }
+  }
+  metrics.branchingFactor =
+      junctions == 0 ? 0.0 : static_cast<double>(waysOnward) / junctions;
+  return metrics;
+}
+
+QStringList MazeMetrics::getCsvHeader() {
+  return {"optimal-cost", "distance", "dead-ends", "branching-factor"};
+}
+
+QStringList MazeMetrics::getCsvFields() const {
+  return {QString::number(optimalCost), QString::number(distance),
+          QString::number(deadEnds), QString::number(branchingFactor)};
+}
+
+}  // namespace mms
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QStringList>
+
+#include "Maze.h"
+
+namespace mms {
+
+// Measures of a maze that don't depend on any algo, e.g., to compare a run
+// against the best possible one or to sort a corpus by difficulty. Corpora
+// store them alongside each maze (see MazeCorpus), since the optimal cost
+// takes a search of the whole maze.
+struct MazeMetrics {
+  double optimalCost;      // see MazeSolver::getOptimalCost
+  int distance;            // from the start to the center, in tiles (or -1)
+  int deadEnds;            // the number of tiles with three walls
+  double branchingFactor;  // the mean number of ways onward from a junction
+
+  static MazeMetrics fromMaze(const Maze *maze);
+
+  // Fields for a CSV row, in the same order as the header
+  static QStringList getCsvHeader();
+  QStringList getCsvFields() const;
+};
+
+}  // namespace mms
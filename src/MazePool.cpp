@@ -0,0 +1,102 @@
+#include "MazePool.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QMutexLocker>
+
+namespace mms {
+
+QMutex MazePool::MUTEX;
+QHash<QByteArray, QWeakPointer<const Maze>> MazePool::MAZES;
+
+QSharedPointer<const Maze> MazePool::fromFile(const QString &path) {
+  // Entries of a corpus are already binary, so they're keyed by their
+  // contents once loaded, which is cheap, rather than by the whole corpus
+  QFile file(path);
+  if (!file.exists()) {
+    Maze *maze = Maze::fromFile(path);
+    if (maze == nullptr) {
+      return QSharedPointer<const Maze>();
+    }
+    return share(getKey(maze->toBinary()), maze);
+  }
+  if (!file.open(QFile::ReadOnly)) {
+    return QSharedPointer<const Maze>();
+  }
+
+  // Hashed from a mapping of the file, as with Maze::fromFile, so that
+  // sharing a maze costs a read of the file but no copy of it
+  qint64 size = file.size();
+  uchar *data = 0 < size ? file.map(0, size) : nullptr;
+  QByteArray key =
+      getKey(data == nullptr
+                 ? file.readAll()
+                 : QByteArray::fromRawData(reinterpret_cast<char *>(data),
+                                           static_cast<int>(size)));
+  if (data != nullptr) {
+    file.unmap(data);
+  }
+  QSharedPointer<const Maze> maze = find(key);
+  if (!maze.isNull()) {
+    return maze;
+  }
+  Maze *loaded = Maze::fromFile(path);
+  if (loaded == nullptr) {
+    return QSharedPointer<const Maze>();
+  }
+
+  // Keyed by the file too, so that the file needn't be parsed again while
+  // the maze is in use
+  maze = share(getKey(loaded->toBinary()), loaded);
+  alias(key, maze);
+  return maze;
+}
+
+QSharedPointer<const Maze> MazePool::fromBinary(const QByteArray &bytes) {
+  QByteArray key = getKey(bytes);
+  QSharedPointer<const Maze> maze = find(key);
+  if (!maze.isNull()) {
+    return maze;
+  }
+  Maze *loaded = Maze::fromBinary(bytes);
+  if (loaded == nullptr) {
+    return QSharedPointer<const Maze>();
+  }
+  return share(key, loaded);
+}
+
+QSharedPointer<const Maze> MazePool::find(const QByteArray &key) {
+  QMutexLocker locker(&MUTEX);
+  return MAZES.value(key).toStrongRef();
+}
+
+QSharedPointer<const Maze> MazePool::share(const QByteArray &key,
+                                           Maze *maze) {
+  QMutexLocker locker(&MUTEX);
+  QSharedPointer<const Maze> shared = MAZES.value(key).toStrongRef();
+  if (!shared.isNull()) {
+    delete maze;
+    return shared;
+  }
+
+  // Entries of mazes that were freed are dropped as new ones are shared, so
+  // the table only grows with the number of mazes in use
+  for (auto it = MAZES.begin(); it != MAZES.end();) {
+    it = it.value().isNull() ? MAZES.erase(it) : it + 1;
+  }
+  shared = QSharedPointer<const Maze>(maze);
+  MAZES.insert(key, shared);
+  return shared;
+}
+
+void MazePool::alias(const QByteArray &key,
+                     const QSharedPointer<const Maze> &maze) {
+  QMutexLocker locker(&MUTEX);
+  MAZES.insert(key, maze);
+}
+
+QByteArray MazePool::getKey(const QByteArray &bytes) {
+  return QCryptographicHash::hash(bytes, QCryptographicHash::Sha1);
+}
+
+}  // namespace mms
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QWeakPointer>
+
+#include "Maze.h"
+
+namespace mms {
+
+// Mazes that are in use, shared read-only by every simulation that runs on
+// them, e.g., by every algo and repeat of a batch, rather than loaded again
+// for each run. Mazes are keyed by a hash of their walls (in the binary
+// format), so the same maze under different paths, or in different formats,
+// is also shared, and each one is freed once the last run that holds it is
+// done with it. Mazes may be taken on any thread.
+class MazePool {
+ public:
+  // The MazePool class is not constructible
+  MazePool() = delete;
+
+  // As in Maze, null if the maze is invalid; a file is only parsed if no
+  // maze with the same contents is in use
+  static QSharedPointer<const Maze> fromFile(const QString &path);
+  static QSharedPointer<const Maze> fromBinary(const QByteArray &bytes);
+
+ private:
+  static QMutex MUTEX;
+  static QHash<QByteArray, QWeakPointer<const Maze>> MAZES;
+
+  // Returns the maze in use with the key, if there is one
+  static QSharedPointer<const Maze> find(const QByteArray &key);
+
+  // Shares the maze, which is deleted if one with the same key was shared in
+  // the meantime, e.g., by another thread, in which case that one's returned
+  static QSharedPointer<const Maze> share(const QByteArray &key, Maze *maze);
+
+  // Also finds the shared maze by another key, e.g., that of a file of it
+  static void alias(const QByteArray &key,
+                    const QSharedPointer<const Maze> &maze);
+
+  static QByteArray getKey(const QByteArray &bytes);
+};
+
+}  // namespace mms
@@ -0,0 +1,135 @@
+#include "MazeSampler.h"
+
+#include <algorithm>
+
+#include <QMap>
+#include <QRandomGenerator>
+#include <QtConcurrent>
+
+#include "AssertMacros.h"
+#include "Maze.h"
+#include "MazeCorpus.h"
+#include "MazeMetrics.h"
+
+namespace mms {
+
+const int MazeSampler::NUM_BINS = 3;
+
+QStringList MazeSampler::sample(const QStringList &mazeFiles, int count,
+                                quint32 seed) {
+  ASSERT_LT(0, count);
+
+  // The metrics of corpus entries are read rather than computed, but the
+  // maze itself is still needed for its size
+  struct Features {
+    bool isValid;
+    double size;
+    double deadEndDensity;
+    double distance;
+  };
+  QVector<Features> features = QtConcurrent::blockingMapped<QVector<Features>>(
+      mazeFiles, [](const QString &mazeFile) {
+        Maze *maze = Maze::fromFile(mazeFile);
+        if (maze == nullptr) {
+          return Features{false, 0.0, 0.0, 0.0};
+        }
+        MazeMetrics metrics;
+        QString path;
+        int index = 0;
+        if (!MazeCorpus::parseEntryPath(mazeFile, &path, &index) ||
+            !MazeCorpus::getMetrics(path, index, &metrics)) {
+          metrics = MazeMetrics::fromMaze(maze);
+        }
+        double size = maze->getWidth() * maze->getHeight();
+        delete maze;
+        return Features{true, size, metrics.deadEnds / size,
+                        static_cast<double>(metrics.distance)};
+      });
+
+  QVector<int> valid;
+  QVector<double> sizes;
+  QVector<double> densities;
+  QVector<double> distances;
+  for (int i = 0; i < features.size(); i += 1) {
+    if (features.at(i).isValid) {
+      valid.append(i);
+      sizes.append(features.at(i).size);
+      densities.append(features.at(i).deadEndDensity);
+      distances.append(features.at(i).distance);
+    }
+  }
+  if (valid.size() <= count) {
+    QStringList sampled;
+    for (int i : valid) {
+      sampled.append(mazeFiles.at(i));
+    }
+    return sampled;
+  }
+
+  // Each stratum is a combination of bins, in the order of the mazes
+  QVector<int> sizeBins = getBins(sizes);
+  QVector<int> densityBins = getBins(densities);
+  QVector<int> distanceBins = getBins(distances);
+  QMap<int, QVector<int>> strata;
+  for (int i = 0; i < valid.size(); i += 1) {
+    int stratum = (sizeBins.at(i) * NUM_BINS + densityBins.at(i)) * NUM_BINS +
+                  distanceBins.at(i);
+    strata[stratum].append(valid.at(i));
+  }
+
+  // Each stratum gets the whole part of its share, and the strata with the
+  // largest fractional parts get the rest (Hamilton's method), so the sample
+  // is exactly the requested size
+  QList<int> keys = strata.keys();
+  QVector<int> quotas;
+  QVector<double> remainders;
+  int numAllotted = 0;
+  for (int key : keys) {
+    double share =
+        static_cast<double>(count) * strata.value(key).size() / valid.size();
+    quotas.append(static_cast<int>(share));
+    remainders.append(share - quotas.last());
+    numAllotted += quotas.last();
+  }
+  QVector<int> order;
+  for (int i = 0; i < keys.size(); i += 1) {
+    order.append(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return remainders.at(a) > remainders.at(b);
+  });
+  for (int i = 0; numAllotted < count; i += 1) {
+    quotas[order.at(i)] += 1;
+    numAllotted += 1;
+  }
+
+  QRandomGenerator generator(seed);
+  QVector<int> picked;
+  for (int i = 0; i < keys.size(); i += 1) {
+    QVector<int> members = strata.value(keys.at(i));
+    std::shuffle(members.begin(), members.end(), generator);
+    picked.append(members.mid(0, quotas.at(i)));
+  }
+  std::sort(picked.begin(), picked.end());
+  QStringList sampled;
+  for (int i : picked) {
+    sampled.append(mazeFiles.at(i));
+  }
+  return sampled;
+}
+
+QVector<int> MazeSampler::getBins(const QVector<double> &values) {
+  // A value's bin is by the number of values below it, so that a corpus of
+  // mazes that are all the same size has a single bin of sizes
+  QVector<double> sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+  QVector<int> bins;
+  for (double value : values) {
+    int below = std::lower_bound(sorted.begin(), sorted.end(), value) -
+                sorted.begin();
+    bins.append(below * NUM_BINS / sorted.size());
+  }
+  return bins;
+}
+
+}  // namespace mms
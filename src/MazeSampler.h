@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace mms {
+
+// Picks a subset of a list of mazes that's representative of the whole, e.g.,
+// for a quick check of an algo before a full batch. The mazes are split into
+// strata by thirds of their size, dead end density, and distance from the
+// start to the center (see MazeMetrics, which corpora already store), and the
+// sample takes from every stratum in proportion to its share of the mazes, so
+// that rare kinds of mazes aren't left out by chance.
+class MazeSampler {
+ public:
+  // The MazeSampler class is not constructible
+  MazeSampler() = delete;
+
+  // Returns the sampled mazes in the order that they were given; the same
+  // seed always picks the same ones. Invalid mazes are never picked.
+  static QStringList sample(const QStringList &mazeFiles, int count,
+                            quint32 seed);
+
+ private:
+  static const int NUM_BINS;
+
+  // Of each maze, by the rank of its value among the others, with equal
+  // values in the same bin
+  static QVector<int> getBins(const QVector<double> &values);
+};
+
+}  // namespace mms
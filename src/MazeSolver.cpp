@@ -0,0 +1,326 @@
+#include "MazeSolver.h"
+
+#include <algorithm>
+
+#include <QStringList>
+#include <QtMath>
+
+#include "AssertMacros.h"
+#include "Dimensions.h"
+#include "Direction.h"
+#include "MotionProfile.h"
+
+namespace mms {
+
+const int MazeSolver::UNITS_PER_PROGRESS = 6;
+
+MazeSolver::Solution MazeSolver::solve(const Maze *maze) {
+  // The maze already knows the distance of every tile to the center, so if
+  // the center can't be reached, there's no need to search every state of
+  // the mouse to find that out
+  if (maze->getDistance(0, 0) == -1) {
+    return {false, -1.0, {}, {}};
+  }
+  QVector<int> parents;
+  int goal = search(maze, &parents);
+  if (goal == -1) {
+    return {false, -1.0, {}, {}};
+  }
+  return getSolution(maze, parents, goal);
+}
+
+double MazeSolver::getOptimalCost(const Maze *maze) {
+  return solve(maze).cost;
+}
+
+double MazeSolver::getSeconds(const QVector<Move> &moves) {
+  // Each straightaway starts and ends at rest, or at the speed of the turns
+  // on either side of it
+  double seconds = 0.0;
+  double meters = 0.0;
+  double entrySpeed = 0.0;
+  for (const Move &move : moves) {
+    switch (move.movement) {
+      case Movement::MOVE_STRAIGHT:
+        meters += Dimensions::halfTileLength().getMeters() * move.halfSteps;
+        break;
+      case Movement::MOVE_DIAGONAL:
+        meters += Dimensions::halfTileLength().getMeters() * qSqrt(2.0) *
+                  move.halfSteps;
+        break;
+      default: {
+        bool isHalfTurn = move.movement == Movement::TURN_LEFT_45 ||
+                          move.movement == Movement::TURN_RIGHT_45;
+        seconds += MotionProfile::getStraightSeconds(
+            Distance::Meters(meters), entrySpeed, MotionProfile::TURN_SPEED);
+        seconds += MotionProfile::getTurnSeconds(
+            Angle::Degrees(isHalfTurn ? 45 : 90));
+        meters = 0.0;
+        entrySpeed = MotionProfile::TURN_SPEED;
+      }
+    }
+  }
+  return seconds + MotionProfile::getStraightSeconds(Distance::Meters(meters),
+                                                     entrySpeed, 0.0);
+}
+
+QStringList MazeSolver::toCommands(const QVector<Move> &moves) {
+  QStringList commands;
+  for (const Move &move : moves) {
+    switch (move.movement) {
+      case Movement::MOVE_STRAIGHT:
+      case Movement::MOVE_DIAGONAL:
+        if (move.halfSteps % 2 == 0) {
+          commands.append(QString("moveForward %1").arg(move.halfSteps / 2));
+        } else {
+          commands.append(QString("moveForwardHalf %1").arg(move.halfSteps));
+        }
+        break;
+      case Movement::TURN_RIGHT_45:
+        commands.append("turnRight45");
+        break;
+      case Movement::TURN_RIGHT_90:
+        commands.append("turnRight");
+        break;
+      case Movement::TURN_LEFT_45:
+        commands.append("turnLeft45");
+        break;
+      case Movement::TURN_LEFT_90:
+        commands.append("turnLeft");
+        break;
+      default:
+        ASSERT_NEVER_RUNS();
+    }
+  }
+  return commands;
+}
+
+int MazeSolver::search(const Maze *maze, QVector<int> *parents) {
+  int semiWidth = 2 * maze->getWidth() + 1;
+  int semiHeight = 2 * maze->getHeight() + 1;
+  int numPositions = semiWidth * semiHeight;
+
+  // The costs of each movement, and the rotations and half-steps of each
+  // semi-direction, by value, so that the search needs no lookups
+  int straightCost = qRound(Simulation::PROGRESS_PER_STRAIGHT_HALF_STEP *
+                            UNITS_PER_PROGRESS);
+  int diagonalCost = qRound(Simulation::PROGRESS_PER_DIAGONAL_HALF_STEP *
+                            UNITS_PER_PROGRESS);
+  int turn45Cost =
+      qRound(Simulation::PROGRESS_PER_45_DEGREE_TURN * UNITS_PER_PROGRESS);
+  int turn90Cost =
+      qRound(Simulation::PROGRESS_PER_90_DEGREE_TURN * UNITS_PER_PROGRESS);
+  int maxCost =
+      std::max({straightCost, diagonalCost, turn45Cost, turn90Cost});
+  int turns[8][4];
+  int stepCosts[8];
+  int offsets[8];
+  for (int i = 0; i < 8; i += 1) {
+    SemiDirection semiDir = static_cast<SemiDirection>(i);
+    turns[i][0] = static_cast<int>(DIRECTION_ROTATE_45_LEFT().value(semiDir));
+    turns[i][1] = static_cast<int>(DIRECTION_ROTATE_45_RIGHT().value(semiDir));
+    turns[i][2] = static_cast<int>(DIRECTION_ROTATE_90_LEFT().value(semiDir));
+    turns[i][3] = static_cast<int>(DIRECTION_ROTATE_90_RIGHT().value(semiDir));
+    stepCosts[i] =
+        ORDINAL_DIRECTIONS().contains(semiDir) ? diagonalCost : straightCost;
+    QPair<int, int> step = Simulation::getSemiStep(semiDir);
+    offsets[i] = semiHeight * step.first + step.second;
+  }
+  int turnCosts[4] = {turn45Cost, turn45Cost, turn90Cost, turn90Cost};
+
+  // A run finishes at any semi-position within a center tile, and the center
+  // tiles are always a contiguous block
+  QVector<QPair<int, int>> centers =
+      Maze::getCenterPositions(maze->getWidth(), maze->getHeight());
+  int goalMinX = 2 * centers.first().first;
+  int goalMaxX = 2 * centers.first().first + 1;
+  int goalMinY = 2 * centers.first().second;
+  int goalMaxY = 2 * centers.first().second + 1;
+  for (const QPair<int, int> &center : centers) {
+    goalMinX = std::min(goalMinX, 2 * center.first);
+    goalMaxX = std::max(goalMaxX, 2 * center.first + 1);
+    goalMinY = std::min(goalMinY, 2 * center.second);
+    goalMaxY = std::max(goalMaxY, 2 * center.second + 1);
+  }
+
+  // A*, with the larger of two bounds as the heuristic: the cost of the
+  // shortest octile path to the center (as if there were no walls and turns
+  // were free), and the cost of the tiles that are still to be crossed, from
+  // the maze's distances (the bitboard search, for the common sizes). Moving
+  // from one edge of a tile to another takes either a diagonal half-step or
+  // two straight ones, and each time, the distance drops by at most one. A
+  // tile center is a straight half-step from its edges. Both bounds never
+  // overestimate and change by at most the cost of each half-step, so the
+  // first goal state that's expanded is optimal, and the priority of a state
+  // is always within two of the largest costs of the one it's reached from.
+  int edgeCost = std::min(2 * straightCost, diagonalCost);
+  auto getTileDistance = [&](int x, int y) {
+    if (x < 0 || maze->getWidth() <= x || y < 0 || maze->getHeight() <= y) {
+      return -1;
+    }
+    return maze->getDistance(x, y);
+  };
+  auto getHeuristic = [&](int position) {
+    int x = position / semiHeight;
+    int y = position % semiHeight;
+    int dx = std::max({0, goalMinX - x, x - goalMaxX});
+    int dy = std::max({0, goalMinY - y, y - goalMaxY});
+    int diagonals = std::min(dx, dy);
+    int octile = diagonalCost * diagonals +
+                 straightCost * (std::max(dx, dy) - diagonals);
+    int tiles = 0;
+    if (x % 2 == 1 && y % 2 == 1) {
+      int distance = getTileDistance(x / 2, y / 2);
+      if (0 < distance) {
+        tiles = straightCost + edgeCost * (distance - 1);
+      }
+    } else {
+      // An edge, between the tiles on either side of it, of which only those
+      // within the maze and connected to the center have a distance
+      int first = x % 2 == 0 ? getTileDistance(x / 2 - 1, y / 2)
+                             : getTileDistance(x / 2, y / 2 - 1);
+      int second = getTileDistance(x / 2, y / 2);
+      int distance = first == -1 || (second != -1 && second < first)
+                         ? second
+                         : first;
+      if (0 < distance) {
+        tiles = edgeCost * distance;
+      }
+    }
+    return std::max(octile, tiles);
+  };
+
+  // For each semi-position, a bitmask of the semi-directions that are
+  // blocked, as in Simulation; they're only computed for the semi-positions
+  // that are expanded, which A* keeps to a fraction of the maze
+  QVector<short> blocked(numPositions, -1);
+  auto getBlocked = [&](int position) {
+    if (blocked.at(position) == -1) {
+      SemiPosition semiPos = {position / semiHeight, position % semiHeight};
+      short mask = 0;
+      for (int i = 0; i < 8; i += 1) {
+        if (Simulation::isWallInMaze(maze, semiPos,
+                                     static_cast<SemiDirection>(i))) {
+          mask |= 1 << i;
+        }
+      }
+      blocked[position] = mask;
+    }
+    return blocked.at(position);
+  };
+
+  // The open set is a circular bucket queue (as in Dial's algorithm), since
+  // priorities are small integers that never decrease; a state is stale if
+  // it was reached more cheaply after it was queued
+  QVector<qint64> costs(8 * numPositions, -1);
+  parents->fill(-1, 8 * numPositions);
+  QVector<QVector<int>> buckets(2 * maxCost + 1);
+  int numQueued = 0;
+  auto reach = [&](int from, int to, qint64 cost) {
+    if (costs.at(to) == -1 || cost < costs.at(to)) {
+      costs[to] = cost;
+      (*parents)[to] = from;
+      qint64 priority = cost + getHeuristic(to / 8);
+      buckets[priority % buckets.size()].append(to);
+      numQueued += 1;
+    }
+  };
+  SemiPosition start = {1, 1};
+  int startState = 8 * (semiHeight * start.x + start.y) +
+                   static_cast<int>(SemiDirection::NORTH);
+  reach(-1, startState, 0);
+  for (qint64 priority = 0; 0 < numQueued; priority += 1) {
+    // Nothing is added to the current bucket, since every cost is positive
+    // and the heuristic is consistent
+    QVector<int> &bucket = buckets[priority % buckets.size()];
+    for (int state : bucket) {
+      numQueued -= 1;
+      int position = state / 8;
+      qint64 cost = costs.at(state);
+      if (cost + getHeuristic(position) != priority) {
+        continue;
+      }
+      int x = position / semiHeight;
+      int y = position % semiHeight;
+      if (goalMinX <= x && x <= goalMaxX && goalMinY <= y && y <= goalMaxY) {
+        return state;
+      }
+      int direction = state % 8;
+      for (int i = 0; i < 4; i += 1) {
+        reach(state, 8 * position + turns[direction][i], cost + turnCosts[i]);
+      }
+      if (!(getBlocked(position) & (1 << direction))) {
+        reach(state, state + 8 * offsets[direction],
+              cost + stepCosts[direction]);
+      }
+    }
+    bucket.clear();
+  }
+  return -1;
+}
+
+MazeSolver::Solution MazeSolver::getSolution(const Maze *maze,
+                                             const QVector<int> &parents,
+                                             int goal) {
+  QVector<int> states;
+  for (int state = goal; state != -1; state = parents.at(state)) {
+    states.append(state);
+  }
+  std::reverse(states.begin(), states.end());
+
+  // Consecutive half-steps are merged into a single move
+  int semiHeight = 2 * maze->getHeight() + 1;
+  Solution solution = {true, 0.0, {}, {}};
+  solution.path.append({states.first() / 8 / semiHeight,
+                        states.first() / 8 % semiHeight});
+  for (int i = 1; i < states.size(); i += 1) {
+    int position = states.at(i) / 8;
+    SemiDirection from = static_cast<SemiDirection>(states.at(i - 1) % 8);
+    SemiDirection to = static_cast<SemiDirection>(states.at(i) % 8);
+    if (position != states.at(i - 1) / 8) {
+      ASSERT_TR(from == to);
+      solution.path.append({position / semiHeight, position % semiHeight});
+      Movement movement = ORDINAL_DIRECTIONS().contains(to)
+                              ? Movement::MOVE_DIAGONAL
+                              : Movement::MOVE_STRAIGHT;
+      if (!solution.moves.isEmpty() &&
+          solution.moves.last().movement == movement) {
+        solution.moves.last().halfSteps += 1;
+      } else {
+        solution.moves.append({movement, 1});
+      }
+    } else if (DIRECTION_ROTATE_45_LEFT().value(from) == to) {
+      solution.moves.append({Movement::TURN_LEFT_45, 0});
+    } else if (DIRECTION_ROTATE_45_RIGHT().value(from) == to) {
+      solution.moves.append({Movement::TURN_RIGHT_45, 0});
+    } else if (DIRECTION_ROTATE_90_LEFT().value(from) == to) {
+      solution.moves.append({Movement::TURN_LEFT_90, 0});
+    } else {
+      ASSERT_TR(DIRECTION_ROTATE_90_RIGHT().value(from) == to);
+      solution.moves.append({Movement::TURN_RIGHT_90, 0});
+    }
+  }
+  for (const Move &move : solution.moves) {
+    solution.cost += getProgressRequired(move);
+  }
+  return solution;
+}
+
+double MazeSolver::getProgressRequired(const Move &move) {
+  switch (move.movement) {
+    case Movement::MOVE_STRAIGHT:
+      return Simulation::PROGRESS_PER_STRAIGHT_HALF_STEP * move.halfSteps;
+    case Movement::MOVE_DIAGONAL:
+      return Simulation::PROGRESS_PER_DIAGONAL_HALF_STEP * move.halfSteps;
+    case Movement::TURN_RIGHT_45:
+    case Movement::TURN_LEFT_45:
+      return Simulation::PROGRESS_PER_45_DEGREE_TURN;
+    case Movement::TURN_RIGHT_90:
+    case Movement::TURN_LEFT_90:
+      return Simulation::PROGRESS_PER_90_DEGREE_TURN;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QStringList>
+#include <QVector>
+
+#include "Maze.h"
+#include "Mouse.h"
+#include "Simulation.h"
+
+namespace mms {
+
+// The MazeSolver finds the fastest run from the start of a maze to its
+// center under the simulator's own movement model: the mouse moves between
+// semi-positions (see SemiPosition), straight or diagonally, and turns in
+// place by 45 or 90 degrees, and each movement takes as long as the
+// simulation says it does (see Simulation::progressRequired).
+class MazeSolver {
+ public:
+  MazeSolver() = delete;
+
+  // A single command of a run: a turn, or a move of some number of
+  // half-steps, straight or diagonally depending on the mouse's direction
+  struct Move {
+    Movement movement;
+    int halfSteps;  // zero for turns
+  };
+
+  struct Solution {
+    bool isSolved;  // false if the center can't be reached
+    double cost;    // the total progress required by the moves
+    QVector<Move> moves;
+
+    // Every semi-position that the mouse passes through, starting with the
+    // start, e.g., to draw the path
+    QVector<SemiPosition> path;
+  };
+
+  static Solution solve(const Maze *maze);
+
+  // Returns the progress required by the fastest run, or -1 if the center
+  // can't be reached
+  static double getOptimalCost(const Maze *maze);
+
+  // The progress required by the move, as in the simulation
+  static double getProgressRequired(const Move &move);
+
+  // The time that a real mouse would take to drive the moves, without
+  // stopping between them, see MotionProfile
+  static double getSeconds(const QVector<Move> &moves);
+
+  // The moves as commands of the text API, e.g., "moveForwardHalf 3"
+  static QStringList toCommands(const QVector<Move> &moves);
+
+ private:
+  // Costs are searched as integers, in these units of progress, so that a
+  // bucket queue can be used; that's exact apart from a rounding of the
+  // diagonal cost by less than 0.1%, and the cost of the path that's found
+  // is then computed exactly
+  static const int UNITS_PER_PROGRESS;
+
+  // Searches the states of the mouse, i.e., a semi-position and one of eight
+  // semi-directions, indexed by 8 * (semiHeight * x + y) + direction. Returns
+  // the first state in the center that's reached, or -1 if none is, with the
+  // state that each state was reached from.
+  static int search(const Maze *maze, QVector<int> *parents);
+
+  static Solution getSolution(const Maze *maze, const QVector<int> &parents,
+                              int goal);
+};
+
+}  // namespace mms
@@ -0,0 +1,107 @@
+#include "MazeThumbnail.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+namespace mms {
+
+QImage MazeThumbnail::get(const Maze *maze, int size) {
+  QString path = getCachePath(maze, size);
+  if (!path.isEmpty()) {
+    QImage cached(path);
+    if (cached.width() == size && cached.height() == size) {
+      return cached;
+    }
+  }
+  QImage image = render(maze, size);
+  if (!path.isEmpty() && QDir().mkpath(QFileInfo(path).path())) {
+    // Written under a temporary name and then renamed, so that other workers
+    // (or processes) never read a partial thumbnail
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG")) {
+      file.commit();
+    }
+  }
+  return image;
+}
+
+QImage MazeThumbnail::render(const Maze *maze, int size) {
+  QImage image(size, size, QImage::Format_RGB32);
+  image.fill(Qt::black);
+  int width = maze->getWidth();
+  int height = maze->getHeight();
+  double scale = (size - 1.0) / qMax(width, height);
+  int left = qRound(0.5 * (size - 1.0 - scale * width));
+  int top = qRound(0.5 * (size - 1.0 - scale * height));
+
+  // The image's y-axis points down, but the maze's points up
+  QVector<int> columns(width + 1);
+  for (int x = 0; x <= width; x += 1) {
+    columns[x] = qMin(left + qRound(scale * x), size - 1);
+  }
+  QVector<int> rows(height + 1);
+  for (int y = 0; y <= height; y += 1) {
+    rows[y] = qMin(top + qRound(scale * (height - y)), size - 1);
+  }
+
+  QRgb *pixels = reinterpret_cast<QRgb *>(image.bits());
+  int stride = image.bytesPerLine() / sizeof(QRgb);
+  QRgb white = qRgb(255, 255, 255);
+  auto drawRow = [&](int row, int fromColumn, int toColumn) {
+    QRgb *pixel = pixels + row * stride;
+    for (int column = fromColumn; column <= toColumn; column += 1) {
+      pixel[column] = white;
+    }
+  };
+  auto drawColumn = [&](int column, int fromRow, int toRow) {
+    for (int row = fromRow; row <= toRow; row += 1) {
+      pixels[row * stride + column] = white;
+    }
+  };
+
+  // Each wall is a line along the edge of its tile; shared walls are only
+  // drawn by one of their tiles, i.e., the north and east walls, and the
+  // south and west walls along the border
+  unsigned char north = Maze::getWallBit(Direction::NORTH);
+  unsigned char east = Maze::getWallBit(Direction::EAST);
+  unsigned char south = Maze::getWallBit(Direction::SOUTH);
+  unsigned char west = Maze::getWallBit(Direction::WEST);
+  for (int x = 0; x < width; x += 1) {
+    for (int y = 0; y < height; y += 1) {
+      unsigned char walls = maze->getWalls(x, y);
+      if (walls & north) {
+        drawRow(rows[y + 1], columns[x], columns[x + 1]);
+      }
+      if (walls & east) {
+        drawColumn(columns[x + 1], rows[y + 1], rows[y]);
+      }
+      if (y == 0 && (walls & south)) {
+        drawRow(rows[y], columns[x], columns[x + 1]);
+      }
+      if (x == 0 && (walls & west)) {
+        drawColumn(columns[x], rows[y + 1], rows[y]);
+      }
+    }
+  }
+  return image;
+}
+
+QString MazeThumbnail::getCachePath(const Maze *maze, int size) {
+  QString directory =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (directory.isEmpty()) {
+    return QString();
+  }
+  QByteArray hash = QCryptographicHash::hash(maze->toBinary(),
+                                             QCryptographicHash::Sha1);
+  return QDir(directory).filePath(
+      QString("thumbnails/%1-%2.png")
+          .arg(QString::fromLatin1(hash.toHex()))
+          .arg(size));
+}
+
+}  // namespace mms
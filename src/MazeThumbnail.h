@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+
+#include "Maze.h"
+
+namespace mms {
+
+// Small previews of mazes, e.g., for lists of maze files. Walls are written
+// straight from the wall masks into the pixels of the image, so a thumbnail
+// costs a pass over the tiles rather than a view of the maze, and thumbnails
+// are also cached on disk, keyed by a hash of the maze's binary form (see
+// Maze::toBinary), so that each maze is only ever rendered once, whatever
+// file or corpus it's loaded from. Safe to use off the GUI thread.
+class MazeThumbnail {
+ public:
+  MazeThumbnail() = delete;
+
+  // Returns the cached thumbnail of the maze if there is one, and otherwise
+  // renders it and caches it, if the cache directory can be written
+  static QImage get(const Maze *maze, int size);
+
+  // A square image, with the maze scaled to fit and centered
+  static QImage render(const Maze *maze, int size);
+
+ private:
+  // Empty if there's nowhere to cache thumbnails
+  static QString getCachePath(const Maze *maze, int size);
+};
+
+}  // namespace mms
@@ -1,47 +1,260 @@
 #include "MazeView.h"
 
+#include <algorithm>
+
+#include "AssertMacros.h"
 #include "BufferInterface.h"
 #include "Dimensions.h"
 #include "MazeGraphic.h"
+#include "Profiler.h"
 
 namespace mms {
 
-MazeView::MazeView(const Maze *maze, bool isTruthView)
-    : m_bufferInterface({maze->getWidth(), maze->getHeight()},
-                        &m_graphicCpuBuffer, &m_textureCpuBuffer),
-      m_mazeGraphic(maze, &m_bufferInterface, isTruthView) {
+// A bit beside the index of the published snapshot, which is at most 2
+const int MazeView::UNREAD = 4;
+
+MazeView::MazeView(const Maze *maze, bool isTruthView,
+                   QSharedPointer<MazeGeometry> geometry)
+    : m_geometry(geometry.isNull() ? QSharedPointer<MazeGeometry>::create()
+                                   : geometry),
+      m_bufferInterface({maze->getWidth(), maze->getHeight()},
+                        m_geometry.data(), &m_graphicCpuBuffer,
+                        &m_tileGraphicStateBuffer, &m_textureCpuBuffer,
+                        &m_pathCpuBuffer),
+      m_mazeGraphic(maze, &m_bufferInterface, isTruthView),
+      m_writeIndex(0),
+      m_readIndex(1),
+      m_publishedIndex(2) {
+  PROFILE_SCOPE("MazeView::MazeView");
+  for (int i = 0; i < 3; i += 1) {
+    m_snapshots[i].isPathDirty = false;
+    m_staleness[i].isPathStale = true;
+  }
+
   // Establish the coordinates for the tile text characters
   initText(2, 5);
 
   // Populate the data vectors with wall polygons and tile distance text.
   m_mazeGraphic.drawPolygons();
-  m_mazeGraphic.drawTextures();
+  m_bufferInterface.finishGraphicIndexBuffer();
 }
 
 MazeGraphic *MazeView::getMazeGraphic() { return &m_mazeGraphic; }
 
+QSharedPointer<MazeGeometry> MazeView::getGeometry() const {
+  return m_geometry;
+}
+
+void MazeView::reset() {
+  m_bufferInterface.clearTileGraphicText();
+  m_mazeGraphic.reset();
+}
+
 void MazeView::initTileGraphicText(int numRows, int numCols) {
   initText(numRows, numCols);
 }
 
-const QVector<TriangleGraphic> *MazeView::getGraphicCpuBuffer() const {
+const QVector<VertexColor> *MazeView::getGraphicCpuBuffer() const {
   return &m_graphicCpuBuffer;
 }
 
+const QVector<float> *MazeView::getGraphicPositionBuffer() const {
+  return &m_geometry->positions;
+}
+
+const QVector<unsigned int> *MazeView::getGraphicIndexBuffer() const {
+  return &m_geometry->indices;
+}
+
+int MazeView::getNumGraphicIndicesWithoutCorners() const {
+  return m_bufferInterface.getNumGraphicIndicesWithoutCorners();
+}
+
+const QVector<float> *MazeView::getGraphicStateCoordinateBuffer() const {
+  return &m_geometry->stateCoordinates;
+}
+
+const QVector<TileGraphicState> *MazeView::getTileGraphicStateBuffer() const {
+  return &m_tileGraphicStateBuffer;
+}
+
+QPair<int, int> MazeView::getTileGraphicStateTextureSize() const {
+  return m_bufferInterface.getTileGraphicStateTextureSize();
+}
+
 const QVector<TriangleTexture> *MazeView::getTextureCpuBuffer() const {
   return &m_textureCpuBuffer;
 }
 
+int MazeView::getTextureColumnStart(int column) const {
+  return m_bufferInterface.getTileGraphicTextColumnStart(column);
+}
+
+const QVector<VertexGraphic> *MazeView::getPathCpuBuffer() const {
+  return &m_pathCpuBuffer;
+}
+
+void MazeView::flush() { m_mazeGraphic.flush(); }
+
+void MazeView::publish() {
+  PROFILE_SCOPE("MazeView::publish");
+  m_mazeGraphic.flush();
+
+  // Every snapshot falls behind by what changed since the last publish,
+  // including the reader's and the one in between, which catch up whenever
+  // they're next written
+  const DirtyRanges &graphicRanges = m_bufferInterface.getGraphicDirtyRanges();
+  const DirtyRanges &textureRanges = m_bufferInterface.getTextureDirtyRanges();
+  const DirtyRanges &tileGraphicStateRanges =
+      m_bufferInterface.getTileGraphicStateDirtyRanges();
+  bool isPathDirty = m_bufferInterface.isPathDirty();
+  for (int i = 0; i < 3; i += 1) {
+    m_staleness[i].graphicRanges.insert(graphicRanges);
+    m_staleness[i].textureRanges.insert(textureRanges);
+    m_staleness[i].tileGraphicStateRanges.insert(tileGraphicStateRanges);
+    m_staleness[i].isPathStale = m_staleness[i].isPathStale || isPathDirty;
+  }
+
+  MazeViewSnapshot *snapshot = &m_snapshots[m_writeIndex];
+  Staleness *staleness = &m_staleness[m_writeIndex];
+  copyRanges(m_graphicCpuBuffer, staleness->graphicRanges,
+             &snapshot->graphicCpuBuffer);
+  copyRanges(m_tileGraphicStateBuffer, staleness->tileGraphicStateRanges,
+             &snapshot->tileGraphicStateBuffer);
+  copyRanges(m_textureCpuBuffer, staleness->textureRanges,
+             &snapshot->textureCpuBuffer);
+  // The path is replaced whole whenever it changes, so its data is shared
+  // rather than copied
+  if (staleness->isPathStale) {
+    snapshot->pathCpuBuffer = m_pathCpuBuffer;
+  }
+  int numColumns = m_geometry->mazeSize.first + 1;
+  snapshot->textureColumnStarts.resize(numColumns);
+  for (int i = 0; i < numColumns; i += 1) {
+    snapshot->textureColumnStarts[i] =
+        m_bufferInterface.getTileGraphicTextColumnStart(i);
+  }
+  staleness->graphicRanges.clear();
+  staleness->textureRanges.clear();
+  staleness->tileGraphicStateRanges.clear();
+  staleness->isPathStale = false;
+
+  // The reader uploads what changed since the snapshot it has, which, if it
+  // hasn't taken the one in between, includes what changed before that one.
+  // The reader may take it meanwhile, in which case a little more is
+  // uploaded than needs to be; either way, both threads only read it.
+  snapshot->graphicDirtyRanges = graphicRanges;
+  snapshot->textureDirtyRanges = textureRanges;
+  snapshot->tileGraphicStateDirtyRanges = tileGraphicStateRanges;
+  snapshot->isPathDirty = isPathDirty;
+  int published = m_publishedIndex.load(std::memory_order_acquire);
+  if (published & UNREAD) {
+    const MazeViewSnapshot &unread = m_snapshots[published & ~UNREAD];
+    snapshot->graphicDirtyRanges.insert(unread.graphicDirtyRanges);
+    snapshot->textureDirtyRanges.insert(unread.textureDirtyRanges);
+    snapshot->tileGraphicStateDirtyRanges.insert(
+        unread.tileGraphicStateDirtyRanges);
+    snapshot->isPathDirty = snapshot->isPathDirty || unread.isPathDirty;
+  }
+  m_bufferInterface.clearDirtyRanges();
+
+  m_writeIndex = m_publishedIndex.exchange(m_writeIndex | UNREAD,
+                                           std::memory_order_acq_rel) &
+                 ~UNREAD;
+}
+
+bool MazeView::acquireSnapshot() {
+  // Only the writer marks a snapshot as unread, so once it's seen, the
+  // exchange is sure to take an unread one, if not the same one
+  if (!(m_publishedIndex.load(std::memory_order_relaxed) & UNREAD)) {
+    return false;
+  }
+  m_readIndex =
+      m_publishedIndex.exchange(m_readIndex, std::memory_order_acq_rel) &
+      ~UNREAD;
+  return true;
+}
+
+const MazeViewSnapshot &MazeView::getSnapshot() const {
+  return m_snapshots[m_readIndex];
+}
+
+qint64 MazeView::getCpuBufferMemoryBytes() const {
+  qint64 bytes =
+      sizeof(VertexColor) * m_graphicCpuBuffer.capacity() +
+      sizeof(TileGraphicState) * m_tileGraphicStateBuffer.capacity() +
+      sizeof(TriangleTexture) * m_textureCpuBuffer.capacity() +
+      sizeof(VertexGraphic) * m_pathCpuBuffer.capacity();
+  for (const MazeViewSnapshot &snapshot : m_snapshots) {
+    bytes += sizeof(VertexColor) * snapshot.graphicCpuBuffer.capacity() +
+             sizeof(TileGraphicState) *
+                 snapshot.tileGraphicStateBuffer.capacity() +
+             sizeof(TriangleTexture) * snapshot.textureCpuBuffer.capacity() +
+             sizeof(VertexGraphic) * snapshot.pathCpuBuffer.capacity() +
+             sizeof(int) * snapshot.textureColumnStarts.capacity();
+  }
+  return bytes;
+}
+
+qint64 MazeView::getGeometryMemoryBytes() const {
+  return sizeof(float) * (m_geometry->positions.capacity() +
+                          m_geometry->stateCoordinates.capacity()) +
+         sizeof(unsigned int) * m_geometry->indices.capacity() +
+         sizeof(int) * (m_geometry->baseColumnStarts.capacity() +
+                        m_geometry->wallColumnStarts.capacity() +
+                        m_geometry->cornerColumnStarts.capacity() +
+                        m_geometry->polygonStartingVertices.capacity());
+}
+
+qint64 MazeView::getTileGraphicMemoryBytes() const {
+  return m_mazeGraphic.getMemoryBytes() + m_bufferInterface.getMemoryBytes();
+}
+
+qint64 MazeView::getTextCacheMemoryBytes() const {
+  return m_bufferInterface.getTextCacheMemoryBytes();
+}
+
+bool MazeView::isDirty() const {
+  // The tile graphic state only changes along with the graphic cpu buffer
+  return m_mazeGraphic.hasPendingChanges() ||
+         !m_bufferInterface.getGraphicDirtyRanges().isEmpty() ||
+         !m_bufferInterface.getTextureDirtyRanges().isEmpty() ||
+         m_bufferInterface.isPathDirty() ||
+         (m_publishedIndex.load(std::memory_order_relaxed) & UNREAD) != 0;
+}
+
 void MazeView::initText(int numRows, int numCols) {
-  // Initialze the tile text in the buffer class,
-  // do caching for speed improvement
-  m_bufferInterface.initTileGraphicText(
-      Dimensions::wallLength(), Dimensions::wallWidth(), {numRows, numCols});
-
-  // TODO: upforgrabs
-  // The naming ("draw") is kind of confusing
-  m_textureCpuBuffer.clear();
+  ASSERT_LE(numRows * numCols, TileGraphic::MAX_TEXT_LENGTH);
+  QPair<int, int> size = {numRows, numCols};
+  if (m_bufferInterface.getTileGraphicTextMaxSize() == size) {
+    return;
+  }
+
+  // Initialze the tile text in the buffer class, do caching for speed
+  // improvement, and empty the text buffer; then lay out the text of just
+  // the tiles that have any
+  m_bufferInterface.initTileGraphicText(Dimensions::wallLength(),
+                                        Dimensions::wallWidth(), size);
   m_mazeGraphic.drawTextures();
 }
 
+template <typename T>
+void MazeView::copyRanges(const QVector<T> &from, const DirtyRanges &ranges,
+                          QVector<T> *to) {
+  // The copies are made element by element, rather than by assigning the
+  // vector, which would share its data and make the next write to the view
+  // copy all of it
+  if (to->size() != from.size()) {
+    to->resize(from.size());
+    std::copy(from.constBegin(), from.constEnd(), to->begin());
+    return;
+  }
+  T *data = to->data();
+  for (const QPair<int, int> &range : ranges.getRanges()) {
+    std::copy(from.constBegin() + range.first,
+              from.constBegin() + range.first + range.second,
+              data + range.first);
+  }
+}
+
 }  // namespace mms
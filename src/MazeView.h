@@ -1,38 +1,153 @@
 #pragma once
 
+#include <atomic>
+
+#include <QPair>
+#include <QSharedPointer>
 #include <QVector>
 
 #include "BufferInterface.h"
+#include "DirtyRanges.h"
 #include "Maze.h"
+#include "MazeGeometry.h"
 #include "MazeGraphic.h"
-#include "TriangleGraphic.h"
+#include "MazeViewSnapshot.h"
+#include "TileGraphicState.h"
 #include "TriangleTexture.h"
+#include "VertexColor.h"
+#include "VertexGraphic.h"
 
 namespace mms {
 
+// The MazeView holds the CPU side of everything that's drawn for a maze. It's
+// modified (via the MazeGraphic) by one thread, the writer, and drawn (by the
+// Map) from snapshots of its buffers, which one thread, the reader, reads
+// without any locks, so that a frame never sees a partial update. There are
+// three snapshots: the writer's, which it's bringing up to date, the
+// reader's, and the one that was published last, which each of them swaps
+// its own for with a single atomic exchange. Only what changed since a
+// snapshot was last written is copied into it. For now, the simulation runs
+// on the GUI thread, so the renderer publishes for it just before reading.
 class MazeView {
  public:
-  MazeView(const Maze *maze, bool isTruthView);
+  // Views of mazes of the same size may share a geometry, e.g., the truth
+  // view and the algo's view, in which case only the first view builds it; if
+  // none is given, the view builds its own
+  MazeView(const Maze *maze, bool isTruthView,
+           QSharedPointer<MazeGeometry> geometry =
+               QSharedPointer<MazeGeometry>());
   MazeGraphic *getMazeGraphic();
+  QSharedPointer<MazeGeometry> getGeometry() const;
+
+  // Returns the view to the state it was constructed in, in place; much
+  // cheaper than constructing a new view, which triangulates every tile. The
+  // text buffer is emptied, since every tile's text is cleared.
+  void reset();
+
+  // At most TileGraphic::MAX_TEXT_LENGTH glyphs per tile
   void initTileGraphicText(int numRows, int numCols);
-  const QVector<TriangleGraphic> *getGraphicCpuBuffer() const;
+  const QVector<VertexColor> *getGraphicCpuBuffer() const;
+  const QVector<float> *getGraphicPositionBuffer() const;
+  const QVector<unsigned int> *getGraphicIndexBuffer() const;
+
+  // The corners are indexed last, so this prefix of the index buffer draws
+  // everything else
+  int getNumGraphicIndicesWithoutCorners() const;
+
+  const QVector<float> *getGraphicStateCoordinateBuffer() const;
+  const QVector<TileGraphicState> *getTileGraphicStateBuffer() const;
+  QPair<int, int> getTileGraphicStateTextureSize() const;
   const QVector<TriangleTexture> *getTextureCpuBuffer() const;
 
+  // The texture cpu buffer only holds the text of the tiles that have had any
+  // (see BufferInterface::clearTileGraphicText), so a column's triangles
+  // start wherever the previous column's end
+  int getTextureColumnStart(int column) const;
+
+  // The vertices of the path, in order, drawn as a single line strip
+  const QVector<VertexGraphic> *getPathCpuBuffer() const;
+
+  // Writes the changes to the tiles that are still pending in the MazeGraphic;
+  // must be called before the buffers are read
+  void flush();
+
+  // Of the writer: flushes, and publishes a snapshot of the buffers, in place
+  // of the last one if the reader hasn't taken that one yet
+  void publish();
+
+  // Of the reader: takes the snapshot that was published last, if it hasn't
+  // already, and returns whether it did; otherwise, the reader's snapshot is
+  // the same as before, and nothing in it needs to be uploaded again
+  bool acquireSnapshot();
+  const MazeViewSnapshot &getSnapshot() const;
+
+  // Whether anything changed that the reader hasn't taken yet, including
+  // changes that haven't been flushed or published; the changes are the
+  // writer's, so this is only meaningful on the writer's thread
+  bool isDirty() const;
+
+  // The heap memory of the view, e.g., for the memory report (see
+  // MemoryReport): its own cpu buffers and their snapshots, the geometry,
+  // which may be shared with other views, the tile graphics along with their
+  // bookkeeping, and the tile text cache
+  qint64 getCpuBufferMemoryBytes() const;
+  qint64 getGeometryMemoryBytes() const;
+  qint64 getTileGraphicMemoryBytes() const;
+  qint64 getTextCacheMemoryBytes() const;
+
  private:
-  // These vectors contain the triangles that will actually be drawn
-  QVector<TriangleGraphic> m_graphicCpuBuffer;
+  // The positions and triangles of the polygons, which never change and may
+  // be shared with other views, and the colors of their vertices, which are
+  // this view's own
+  QSharedPointer<MazeGeometry> m_geometry;
+  QVector<VertexColor> m_graphicCpuBuffer;
+
+  // The polygon colors can instead be sampled from per-tile state, in which
+  // case each vertex only needs the coordinates of its color in that state,
+  // which are also part of the geometry
+  QVector<TileGraphicState> m_tileGraphicStateBuffer;
+
   QVector<TriangleTexture> m_textureCpuBuffer;
 
+  // The vertices of a polyline that an algo drew, e.g., its planned route
+  QVector<VertexGraphic> m_pathCpuBuffer;
+
   // The buffer interface provides abstractions which the MazeGraphic
-  // uses to populate the vector of TriangleGraphic objects
+  // uses to populate the vectors of vertices and triangles
   BufferInterface m_bufferInterface;
 
   // The MazeGraphic is essentially a "handle" into the above vectors;
   // it provides a high-level API for modifying their contents
   MazeGraphic m_mazeGraphic;
 
+  // The snapshots, by the indices below: the writer's and the reader's,
+  // which only they touch, and the one in between, which the writer marks
+  // with UNREAD when it publishes, until the reader takes it
+  static const int UNREAD;
+  MazeViewSnapshot m_snapshots[3];
+  int m_writeIndex;
+  int m_readIndex;
+  std::atomic<int> m_publishedIndex;
+
+  // What changed in the cpu buffers since each snapshot was last written,
+  // which only the writer touches; the buffers of a snapshot are copied
+  // whole, rather than by range, if their size changed
+  struct Staleness {
+    DirtyRanges graphicRanges;
+    DirtyRanges textureRanges;
+    DirtyRanges tileGraphicStateRanges;
+    bool isPathStale;
+  };
+  Staleness m_staleness[3];
+
   // Helper method for initializing TileGraphic text
   void initText(int numRows, int numCols);
+
+  // Copies the ranges of one buffer to another of the same size, or the
+  // whole buffer if the sizes differ
+  template <typename T>
+  static void copyRanges(const QVector<T> &from, const DirtyRanges &ranges,
+                         QVector<T> *to);
 };
 
 }  // namespace mms
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QVector>
+
+#include "DirtyRanges.h"
+#include "TileGraphicState.h"
+#include "TriangleTexture.h"
+#include "VertexColor.h"
+#include "VertexGraphic.h"
+
+namespace mms {
+
+// A copy of the cpu buffers of a view, as they were when it was published
+// (see MazeView::publish), which the renderer reads while the view goes on
+// changing. Along with the buffers are the parts of them that changed since
+// the snapshot that the renderer read before this one, i.e., what it needs to
+// upload if it already uploaded that one.
+struct MazeViewSnapshot {
+  QVector<VertexColor> graphicCpuBuffer;
+  QVector<TileGraphicState> tileGraphicStateBuffer;
+  QVector<TriangleTexture> textureCpuBuffer;
+  QVector<VertexGraphic> pathCpuBuffer;
+
+  // By column, plus the column after the last, as in
+  // MazeView::getTextureColumnStart
+  QVector<int> textureColumnStarts;
+
+  DirtyRanges graphicDirtyRanges;
+  DirtyRanges textureDirtyRanges;
+  DirtyRanges tileGraphicStateDirtyRanges;
+  bool isPathDirty;
+};
+
+}  // namespace mms
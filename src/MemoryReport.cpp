@@ -0,0 +1,89 @@
+#include "MemoryReport.h"
+
+#include <QCoreApplication>
+#include <QScopedPointer>
+
+#include "BatchRunner.h"
+#include "MapRenderer.h"
+#include "MazeGenerator.h"
+#include "MazeView.h"
+#include "ProcessUtilities.h"
+#include "Simulation.h"
+#include "Stats.h"
+
+namespace mms {
+
+int MemoryReport::run(const QStringList &mazeFiles, QPair<int, int> size,
+                      int jobs, QTextStream *output) {
+  QTextStream err(stderr);
+  *output << "maze,subsystem,bytes" << Qt::endl;
+  if (mazeFiles.isEmpty()) {
+    QScopedPointer<Maze> maze(Maze::fromBinary(MazeGenerator::generate(
+        MazeAlgorithm::DFS, size.first, size.second, 0)));
+    report(QString("%1x%2").arg(size.first).arg(size.second), maze.data(),
+           jobs, output);
+  }
+  for (const QString &file : mazeFiles) {
+    QScopedPointer<Maze> maze(Maze::fromFile(file));
+    if (maze.isNull()) {
+      err << QString("Invalid maze \"%1\".").arg(file) << Qt::endl;
+      return 1;
+    }
+    report(file, maze.data(), jobs, output);
+  }
+
+  // As a check on the rest, e.g., for what the containers don't account for
+  ProcessUtilities::Usage usage;
+  if (ProcessUtilities::getUsage(QCoreApplication::applicationPid(),
+                                 &usage)) {
+    *output << ",process/peak-resident," << usage.peakResidentBytes
+            << Qt::endl;
+  }
+  return 0;
+}
+
+void MemoryReport::report(const QString &name, const Maze *maze, int jobs,
+                          QTextStream *output) {
+  // As in the GUI, the mouse's view is the main one and the truth view is
+  // the other one of the split view
+  MazeView truth(maze, true);
+  MazeView view(maze, false, truth.getGeometry());
+  Stats stats;
+  stats.resetAll();
+  Simulation simulation(maze, view.getMazeGraphic(), &stats, nullptr);
+  view.flush();
+  truth.flush();
+
+  QString field = BatchRunner::toCsvField(name);
+  qint64 gui = 0;
+  auto add = [&](const QString &subsystem, qint64 bytes) {
+    *output << field << "," << subsystem << "," << bytes << Qt::endl;
+  };
+  auto addToGui = [&](const QString &subsystem, qint64 bytes) {
+    add(subsystem, bytes);
+    gui += bytes;
+  };
+  addToGui("maze", maze->getMemoryBytes());
+  addToGui("geometry", view.getGeometryMemoryBytes());
+  addToGui("mouse-view/cpu-buffers", view.getCpuBufferMemoryBytes());
+  addToGui("mouse-view/tile-graphics", view.getTileGraphicMemoryBytes());
+  addToGui("mouse-view/text-cache", view.getTextCacheMemoryBytes());
+  addToGui("truth-view/cpu-buffers", truth.getCpuBufferMemoryBytes());
+  addToGui("truth-view/tile-graphics", truth.getTileGraphicMemoryBytes());
+  addToGui("truth-view/text-cache", truth.getTextCacheMemoryBytes());
+  addToGui("simulation", sizeof(Simulation) + sizeof(Stats));
+  addToGui("simulation/command-queue",
+           simulation.getCommandQueueMemoryBytes());
+  add("gui/total", gui);
+  add("gpu/mouse-view", MapRenderer::getGpuMemoryBytes(&view, true));
+  add("gpu/truth-view", MapRenderer::getGpuMemoryBytes(&truth, false));
+
+  // Batch runs have no views (see BatchRunner), just the maze and the
+  // simulation
+  qint64 run = maze->getMemoryBytes() + sizeof(Simulation) + sizeof(Stats) +
+               simulation.getCommandQueueMemoryBytes();
+  add("batch/run", run);
+  add(QString("batch/%1-runs").arg(jobs), jobs * run);
+}
+
+}  // namespace mms
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include "Maze.h"
+
+namespace mms {
+
+// Breaks down the memory that the simulator holds for a maze by subsystem,
+// so that it can be told ahead of time whether a run fits, e.g., a 256x256
+// maze in the GUI, or a batch of many simulations on a worker. For each
+// maze, the GUI's truth and mouse views are built, sharing their geometry,
+// along with a simulation, and a CSV row is written for each subsystem.
+// Bytes are what the containers have allocated, not counting the
+// allocator's overhead; video memory is predicted from the views' buffers
+// (see MapRenderer::getGpuMemoryBytes), since nothing is uploaded here.
+class MemoryReport {
+ public:
+  // The MemoryReport class is not constructible
+  MemoryReport() = delete;
+
+  // If no maze files are given, a maze of the given size is generated. A
+  // batch runs the given number of simulations at once (see BatchRunner).
+  // Returns a nonzero exit code if a maze couldn't be loaded.
+  static int run(const QStringList &mazeFiles, QPair<int, int> size,
+                 int jobs, QTextStream *output);
+
+ private:
+  static void report(const QString &name, const Maze *maze, int jobs,
+                     QTextStream *output);
+};
+
+}  // namespace mms
@@ -0,0 +1,94 @@
+#include "MetricsPlot.h"
+
+#include <QPainter>
+#include <QString>
+#include <QVector>
+#include <QtNumeric>
+
+namespace mms {
+
+const int MetricsPlot::REFRESH_INTERVAL_MILLISECONDS = 100;
+const int MetricsPlot::ROW_HEIGHT = 64;
+const int MetricsPlot::MARGIN = 4;
+
+MetricsPlot::MetricsPlot(QWidget *parent)
+    : QWidget(parent), m_metrics(nullptr), m_refreshTimer(new QTimer(this)) {
+  m_refreshTimer->setInterval(REFRESH_INTERVAL_MILLISECONDS);
+  connect(m_refreshTimer, &QTimer::timeout, this, &MetricsPlot::refresh);
+  m_refreshTimer->start();
+}
+
+void MetricsPlot::setMetrics(const AlgoMetrics *metrics) {
+  m_metrics = metrics;
+  update();
+}
+
+void MetricsPlot::paintEvent(QPaintEvent *event) {
+  Q_UNUSED(event);
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().base());
+  if (m_metrics == nullptr || m_metrics->getCount() == 0) {
+    painter.setPen(palette().text().color());
+    painter.drawText(rect(), Qt::AlignCenter,
+                     "No metrics (see the metric command)");
+    return;
+  }
+
+  // Each row is the name and the latest value, over the envelope, which is
+  // scaled to the range of the buffered samples
+  int count = m_metrics->getCount();
+  int rowHeight = qMax(ROW_HEIGHT, height() / count);
+  int width = qMax(1, this->width() - 2 * MARGIN);
+  int textHeight = painter.fontMetrics().height();
+  QVector<double> mins;
+  QVector<double> maxes;
+  for (int metric = 0; metric < count; metric += 1) {
+    int top = metric * rowHeight;
+    if (height() <= top) {
+      break;
+    }
+    painter.setPen(palette().text().color());
+    painter.drawText(
+        MARGIN, top + MARGIN, width, textHeight, Qt::AlignLeft,
+        QString("%1: %2 (min %3, max %4)")
+            .arg(m_metrics->getName(metric))
+            .arg(m_metrics->getLast(metric))
+            .arg(m_metrics->getMin(metric))
+            .arg(m_metrics->getMax(metric)));
+
+    m_metrics->getEnvelope(metric, width, &mins, &maxes);
+    double low = qInf();
+    double high = -qInf();
+    for (int i = 0; i < width; i += 1) {
+      if (!qIsNaN(mins.at(i))) {
+        low = qMin(low, mins.at(i));
+        high = qMax(high, maxes.at(i));
+      }
+    }
+    int plotTop = top + 2 * MARGIN + textHeight;
+    int plotHeight = qMax(1, top + rowHeight - MARGIN - plotTop);
+    double range = low < high ? high - low : 1.0;
+    painter.setPen(palette().highlight().color());
+    for (int i = 0; i < width; i += 1) {
+      if (qIsNaN(mins.at(i))) {
+        continue;
+      }
+      int y1 = plotTop + plotHeight -
+               static_cast<int>((maxes.at(i) - low) / range * plotHeight);
+      int y2 = plotTop + plotHeight -
+               static_cast<int>((mins.at(i) - low) / range * plotHeight);
+      painter.drawLine(MARGIN + i, y1, MARGIN + i, y2);
+    }
+    painter.setPen(palette().mid().color());
+    painter.drawLine(0, top + rowHeight - 1, this->width(),
+                     top + rowHeight - 1);
+  }
+}
+
+void MetricsPlot::refresh() {
+  if (isVisible() && m_metrics != nullptr) {
+    update();
+  }
+}
+
+}  // namespace mms
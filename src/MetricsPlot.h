@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QPaintEvent>
+#include <QTimer>
+#include <QWidget>
+
+#include "AlgoMetrics.h"
+
+namespace mms {
+
+// Plots the metrics that the algo reports with the metric command, a row for
+// each, as the envelope of its buffered samples (see AlgoMetrics): each column
+// of pixels spans the minimum and maximum of the samples that fall in it, so
+// a plot costs the same however many samples arrive. The plot is redrawn on
+// a timer of its own, and only while it's visible, rather than whenever a
+// sample arrives.
+class MetricsPlot : public QWidget {
+  Q_OBJECT
+
+ public:
+  MetricsPlot(QWidget *parent = nullptr);
+
+  // Not owned by the plot, and null when there's no simulation
+  void setMetrics(const AlgoMetrics *metrics);
+
+ protected:
+  void paintEvent(QPaintEvent *event) override;
+
+ private:
+  static const int REFRESH_INTERVAL_MILLISECONDS;
+  static const int ROW_HEIGHT;
+  static const int MARGIN;
+
+  const AlgoMetrics *m_metrics;
+  QTimer *m_refreshTimer;
+
+  void refresh();
+};
+
+}  // namespace mms
@@ -0,0 +1,57 @@
+#include "MotionProfile.h"
+
+#include <cmath>
+
+#include <QtGlobal>
+
+#include "AssertMacros.h"
+#include "Dimensions.h"
+
+namespace mms {
+
+const double MotionProfile::MAX_SPEED = 2.0;
+const double MotionProfile::ACCELERATION = 4.0;
+const double MotionProfile::TURN_SPEED = 0.6;
+
+double MotionProfile::getStraightSeconds(Distance distance, double entrySpeed,
+                                         double exitSpeed) {
+  double meters = distance.getMeters();
+  ASSERT_LE(0.0, meters);
+  ASSERT_LE(0.0, entrySpeed);
+  ASSERT_LE(0.0, exitSpeed);
+  if (meters == 0.0) {
+    return 0.0;
+  }
+
+  // If the distance is too short to reach the exit speed, the mouse arrives
+  // at whatever speed it does reach, and if it's too short to brake to the
+  // exit speed, it brakes the whole way and arrives a little too fast
+  double reach = 2.0 * ACCELERATION * meters;
+  exitSpeed = qMin(exitSpeed, std::sqrt(entrySpeed * entrySpeed + reach));
+  if (exitSpeed * exitSpeed + reach < entrySpeed * entrySpeed) {
+    exitSpeed = std::sqrt(entrySpeed * entrySpeed - reach);
+    return 2.0 * meters / (entrySpeed + exitSpeed);
+  }
+
+  // Accelerating and then braking, as hard as possible, meets at the peak
+  // speed (a triangular profile), unless that's faster than the top speed,
+  // in which case the mouse cruises at the top speed in between (a
+  // trapezoidal one)
+  double peakSpeed = std::sqrt(
+      (reach + entrySpeed * entrySpeed + exitSpeed * exitSpeed) / 2.0);
+  if (peakSpeed <= MAX_SPEED) {
+    return (2.0 * peakSpeed - entrySpeed - exitSpeed) / ACCELERATION;
+  }
+  double rampMeters = (2.0 * MAX_SPEED * MAX_SPEED - entrySpeed * entrySpeed -
+                       exitSpeed * exitSpeed) /
+                      (2.0 * ACCELERATION);
+  return (2.0 * MAX_SPEED - entrySpeed - exitSpeed) / ACCELERATION +
+         (meters - rampMeters) / MAX_SPEED;
+}
+
+double MotionProfile::getTurnSeconds(Angle angle) {
+  return Dimensions::halfTileLength().getMeters() *
+         std::abs(angle.getRadiansUnbounded()) / TURN_SPEED;
+}
+
+}  // namespace mms
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "units/Angle.h"
+#include "units/Distance.h"
+
+namespace mms {
+
+// A model of how long a real mouse takes to drive a run, in closed form
+// rather than by stepping the animation: straightaways are trapezoidal
+// velocity profiles, accelerating as hard as possible up to a top speed and
+// braking in time to arrive at the speed of whatever comes next, and turns
+// are smooth curves, driven at a constant speed along an arc of half a tile.
+// A straightaway that ends in a turn brakes to the turn's speed, and one
+// that ends the run brakes to a stop, which is how the time of any sequence
+// of moves follows directly from their lengths and angles.
+class MotionProfile {
+ public:
+  MotionProfile() = delete;
+
+  // In meters per second, and meters per second squared
+  static const double MAX_SPEED;
+  static const double ACCELERATION;
+  static const double TURN_SPEED;
+
+  // The time to drive straight for the distance, starting and ending at the
+  // given speeds, or as close to them as the acceleration allows
+  static double getStraightSeconds(Distance distance, double entrySpeed,
+                                   double exitSpeed);
+
+  // The time to curve through a turn of the given angle, in either direction
+  static double getTurnSeconds(Angle angle);
+};
+
+}  // namespace mms
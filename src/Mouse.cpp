@@ -12,6 +12,9 @@
 
 namespace mms {
 
+const double Mouse::DRAW_DELAY_SECONDS = 0.025;
+const int Mouse::MAX_POSES = 16;
+
 QPair<int, int> SemiPosition::toMazeLocation() { return {x / 2, y / 2}; }
 
 Mouse::Mouse() {
@@ -25,41 +28,43 @@ Mouse::Mouse() {
   // The initial rotation of the mouse is determined by the starting tile walls
   m_initialRotation = DIRECTION_TO_ANGLE().value(SemiDirection::NORTH);
   m_currentRotation = m_initialRotation;
+}
 
-  // Initialize the body, wheels, and sensors, such that they have the
-  // correct initial translation and rotation
-  QVector<Coordinate> bodyVertices = {
+const Polygon &Mouse::INITIAL_BODY_POLYGON() {
+  static const Polygon polygon = getInitialPolygon({
       Coordinate::Cartesian(Distance::Meters(0.00), Distance::Meters(0.00)),
       Coordinate::Cartesian(Distance::Meters(0.00), Distance::Meters(0.06)),
       Coordinate::Cartesian(Distance::Meters(0.03), Distance::Meters(0.09)),
       Coordinate::Cartesian(Distance::Meters(0.06), Distance::Meters(0.06)),
       Coordinate::Cartesian(Distance::Meters(0.06), Distance::Meters(0.00)),
-  };
-  Coordinate centerOfMass =
-      Coordinate::Cartesian(Distance::Meters(0.06), Distance::Meters(0.06));
-  for (int i = 0; i < bodyVertices.size(); i += 1) {
-    bodyVertices[i] =
-        GeometryUtilities::translateVertex(bodyVertices.at(i), centerOfMass);
-  }
-  m_initialBodyPolygon = Polygon(bodyVertices);
+  });
+  return polygon;
+}
 
-  // Initialize the wheel polygon
-  QVector<Coordinate> wheelVertices = {
+const Polygon &Mouse::INITIAL_WHEEL_POLYGON() {
+  static const Polygon polygon = getInitialPolygon({
       Coordinate::Cartesian(Distance::Meters(-0.005), Distance::Meters(0.01)),
       Coordinate::Cartesian(Distance::Meters(-0.005), Distance::Meters(0.05)),
       Coordinate::Cartesian(Distance::Meters(0.065), Distance::Meters(0.05)),
       Coordinate::Cartesian(Distance::Meters(0.065), Distance::Meters(0.01)),
-  };
-  for (int i = 0; i < wheelVertices.size(); i += 1) {
-    wheelVertices[i] =
-        GeometryUtilities::translateVertex(wheelVertices.at(i), centerOfMass);
+  });
+  return polygon;
+}
+
+Polygon Mouse::getInitialPolygon(QVector<Coordinate> vertices) {
+  // Place the polygon such that it has the correct initial translation
+  Coordinate centerOfMass =
+      Coordinate::Cartesian(Distance::Meters(0.06), Distance::Meters(0.06));
+  for (int i = 0; i < vertices.size(); i += 1) {
+    vertices[i] =
+        GeometryUtilities::translateVertex(vertices.at(i), centerOfMass);
   }
-  m_initialWheelPolygon = Polygon(wheelVertices);
 
-  // Force triangulation of the drawable polygons, thus ensuring
-  // that we only triangulate once, at the beginning of execution
-  m_initialBodyPolygon.getTriangles();
-  m_initialWheelPolygon.getTriangles();
+  // Force triangulation of the drawable polygon, thus ensuring that we only
+  // triangulate once, at the beginning of execution
+  Polygon polygon(vertices);
+  polygon.getTriangles();
+  return polygon;
 }
 
 // TODO: upforgrabs
@@ -73,6 +78,53 @@ void Mouse::reset() {
 void Mouse::teleport(const Coordinate &translation, const Angle &rotation) {
   m_currentTranslation = translation;
   m_currentRotation = rotation;
+  m_poses.clear();
+}
+
+void Mouse::moveTo(const Coordinate &translation, const Angle &rotation,
+                   double timestamp) {
+  m_currentTranslation = translation;
+  m_currentRotation = rotation;
+  if (MAX_POSES <= m_poses.size()) {
+    m_poses.removeFirst();
+  }
+  m_poses.append({timestamp, translation, rotation});
+}
+
+void Mouse::getDrawnPose(double timestamp, Coordinate *translation,
+                         Angle *rotation) const {
+  double drawn = timestamp - DRAW_DELAY_SECONDS;
+  if (m_poses.isEmpty() || m_poses.last().timestamp <= drawn) {
+    *translation = m_currentTranslation;
+    *rotation = m_currentRotation;
+    return;
+  }
+  if (drawn <= m_poses.first().timestamp) {
+    *translation = m_poses.first().translation;
+    *rotation = m_poses.first().rotation;
+    return;
+  }
+  int next = 1;
+  while (m_poses.at(next).timestamp <= drawn) {
+    next += 1;
+  }
+  const Pose &from = m_poses.at(next - 1);
+  const Pose &to = m_poses.at(next);
+  double fraction = (drawn - from.timestamp) / (to.timestamp - from.timestamp);
+  *translation =
+      from.translation * (1.0 - fraction) + to.translation * fraction;
+
+  // The shorter way around, in case one of the angles was normalized
+  double radians = (to.rotation - from.rotation).getRadiansZeroTo2pi();
+  if (M_PI < radians) {
+    radians -= 2 * M_PI;
+  }
+  *rotation = from.rotation + Angle::Radians(radians * fraction);
+}
+
+bool Mouse::isCatchingUp(double timestamp) const {
+  return !m_poses.isEmpty() &&
+         timestamp - DRAW_DELAY_SECONDS < m_poses.last().timestamp;
 }
 
 SemiPosition Mouse::getCurrentDiscretizedTranslation() const {
@@ -112,13 +164,27 @@ SemiDirection Mouse::getCurrentDiscretizedRotation() const {
 }
 
 Polygon Mouse::getCurrentBodyPolygon() const {
-  return getCurrentPolygon(m_initialBodyPolygon);
+  return getCurrentPolygon(INITIAL_BODY_POLYGON());
 }
 
 Polygon Mouse::getCurrentWheelPolygon() const {
-  return getCurrentPolygon(m_initialWheelPolygon);
+  return getCurrentPolygon(INITIAL_WHEEL_POLYGON());
 }
 
+Polygon Mouse::getInitialBodyPolygon() const { return INITIAL_BODY_POLYGON(); }
+
+Polygon Mouse::getInitialWheelPolygon() const {
+  return INITIAL_WHEEL_POLYGON();
+}
+
+Coordinate Mouse::getInitialTranslation() const { return m_initialTranslation; }
+
+Angle Mouse::getInitialRotation() const { return m_initialRotation; }
+
+Coordinate Mouse::getCurrentTranslation() const { return m_currentTranslation; }
+
+Angle Mouse::getCurrentRotation() const { return m_currentRotation; }
+
 Polygon Mouse::getCurrentPolygon(const Polygon &initialPolygon) const {
   return initialPolygon.translate(m_currentTranslation - m_initialTranslation)
       .rotateAroundPoint(m_currentRotation - m_initialRotation,
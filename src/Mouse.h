@@ -1,7 +1,6 @@
 #pragma once
 
 #include <QMap>
-#include <QMutex>
 #include <QPair>
 #include <QString>
 #include <QVector>
@@ -45,9 +44,33 @@ class Mouse {
   // Resets the mouse to the beginning of the maze
   void reset();
 
-  // Sets the current translation and rotation of the mouse
+  // Sets the current translation and rotation of the mouse, where it's drawn
+  // right away, since any poses that were published are discarded
   void teleport(const Coordinate &translation, const Angle &rotation);
 
+  // Likewise, but the new pose is published as of the timestamp (see
+  // SimUtilities::getHighResTimestamp) at which the mouse got there in
+  // simulated time, so that it's drawn moving smoothly from one published
+  // pose to the next, however far apart they are and however often it's drawn
+  void moveTo(const Coordinate &translation, const Angle &rotation,
+              double timestamp);
+
+  // Poses are drawn this long after they're published, so that there's
+  // usually a later one to interpolate towards; the simulation must publish
+  // them at least this often while the mouse moves
+  static const double DRAW_DELAY_SECONDS;
+
+  // Where to draw the mouse at the timestamp, i.e., interpolated between the
+  // published poses around DRAW_DELAY_SECONDS earlier. Before the first of
+  // them, it's drawn at the first; after the last, or if there are none, at
+  // its current pose, which is the last one published.
+  void getDrawnPose(double timestamp, Coordinate *translation,
+                    Angle *rotation) const;
+
+  // Whether the mouse is drawn short of its current pose at the timestamp,
+  // i.e., whether it should be drawn again as it catches up
+  bool isCatchingUp(double timestamp) const;
+
   // Gets the current discretized translation and rotation of the mouse
   SemiPosition getCurrentDiscretizedTranslation() const;
   SemiDirection getCurrentDiscretizedRotation() const;
@@ -56,6 +79,15 @@ class Mouse {
   Polygon getCurrentBodyPolygon() const;
   Polygon getCurrentWheelPolygon() const;
 
+  // The polygons of the mouse at its initial translation and rotation, which
+  // can instead be transformed to the current translation and rotation
+  Polygon getInitialBodyPolygon() const;
+  Polygon getInitialWheelPolygon() const;
+  Coordinate getInitialTranslation() const;
+  Angle getInitialRotation() const;
+  Coordinate getCurrentTranslation() const;
+  Angle getCurrentRotation() const;
+
  private:
   // The translation and rotation of the mouse
   Coordinate m_initialTranslation;
@@ -63,9 +95,22 @@ class Mouse {
   Angle m_initialRotation;
   Angle m_currentRotation;
 
-  // The parts of the mouse at the starting location
-  Polygon m_initialBodyPolygon;
-  Polygon m_initialWheelPolygon;
+  // The poses that were published since the mouse was last teleported, oldest
+  // first, up to MAX_POSES of them
+  struct Pose {
+    double timestamp;
+    Coordinate translation;
+    Angle rotation;
+  };
+  static const int MAX_POSES;
+  QVector<Pose> m_poses;
+
+  // The parts of the mouse at the starting location; these are the same for
+  // every mouse, so they're built (and triangulated) just once and shared,
+  // which keeps mice cheap to create
+  static const Polygon &INITIAL_BODY_POLYGON();
+  static const Polygon &INITIAL_WHEEL_POLYGON();
+  static Polygon getInitialPolygon(QVector<Coordinate> vertices);
   Polygon getCurrentPolygon(const Polygon &initialPolygon) const;
 };
 
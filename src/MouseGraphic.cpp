@@ -1,21 +1,89 @@
 #include "MouseGraphic.h"
 
+#include <QtMath>
+
 #include "ColorManager.h"
 #include "SimUtilities.h"
 
 namespace mms {
 
-MouseGraphic::MouseGraphic(const Mouse *mouse) : m_mouse(mouse) {}
+// Fine enough that the interpolated sine and cosine are within 1.2e-6 of the
+// exact ones, i.e., well under a micron across the mouse
+const int MouseGraphic::ROTATION_STEPS = 2048;
+
+MouseGraphic::MouseGraphic(const Mouse *mouse)
+    : m_mouse(mouse), m_hasBodyColor(false), m_bodyColor(Color::BLACK) {}
+
+MouseGraphic::MouseGraphic(const Mouse *mouse, Color bodyColor)
+    : m_mouse(mouse), m_hasBodyColor(true), m_bodyColor(bodyColor) {}
 
 QVector<TriangleGraphic> MouseGraphic::draw() const {
   QVector<TriangleGraphic> buffer;
-  buffer.append(SimUtilities::polygonToTriangleGraphics(
-      m_mouse->getCurrentWheelPolygon(),
-      ColorManager::get()->getMouseWheelColor(), 255));
-  buffer.append(SimUtilities::polygonToTriangleGraphics(
-      m_mouse->getCurrentBodyPolygon(),
-      ColorManager::get()->getMouseBodyColor(), 255));
+  SimUtilities::appendTriangleGraphics(
+      m_mouse->getInitialWheelPolygon(),
+      ColorManager::get()->getMouseWheelColor(), 255, &buffer);
+  SimUtilities::appendTriangleGraphics(
+      m_mouse->getInitialBodyPolygon(),
+      m_hasBodyColor ? m_bodyColor : ColorManager::get()->getMouseBodyColor(),
+      255, &buffer);
   return buffer;
 }
 
+Coordinate MouseGraphic::getDrawnTranslation(double timestamp) const {
+  Coordinate translation;
+  Angle rotation;
+  m_mouse->getDrawnPose(timestamp, &translation, &rotation);
+  return translation;
+}
+
+bool MouseGraphic::isCatchingUp(double timestamp) const {
+  return m_mouse->isCatchingUp(timestamp);
+}
+
+QMatrix4x4 MouseGraphic::getModelMatrix(double timestamp) const {
+  // Equivalent to Mouse::getCurrentPolygon, i.e., translate and then rotate
+  // around the current translation, which is a rotation around the initial
+  // translation followed by a translation to the current one. It's written
+  // out directly, with one sine and cosine from the table, rather than
+  // composed of general rotations and translations, since it's needed for
+  // every mouse on every frame.
+  Coordinate initialTranslation = m_mouse->getInitialTranslation();
+  Coordinate currentTranslation;
+  Angle currentRotation;
+  m_mouse->getDrawnPose(timestamp, &currentTranslation, &currentRotation);
+  Angle rotation = currentRotation - m_mouse->getInitialRotation();
+  double sin;
+  double cos;
+  getSinCos(rotation, &sin, &cos);
+  double ix = initialTranslation.getX().getMeters();
+  double iy = initialTranslation.getY().getMeters();
+  double tx = currentTranslation.getX().getMeters() - (cos * ix - sin * iy);
+  double ty = currentTranslation.getY().getMeters() - (sin * ix + cos * iy);
+  return QMatrix4x4(cos, -sin, 0.0, tx,
+                    sin, cos, 0.0, ty,
+                    0.0, 0.0, 1.0, 0.0,
+                    0.0, 0.0, 0.0, 1.0);
+}
+
+void MouseGraphic::getSinCos(Angle rotation, double *sin, double *cos) {
+  // One entry past a full revolution, so that there's always a next entry to
+  // interpolate toward
+  static const QVector<QPair<double, double>> table = [] {
+    QVector<QPair<double, double>> entries;
+    entries.reserve(ROTATION_STEPS + 1);
+    for (int i = 0; i <= ROTATION_STEPS; i += 1) {
+      double radians = 2 * M_PI * i / ROTATION_STEPS;
+      entries.append({qSin(radians), qCos(radians)});
+    }
+    return entries;
+  }();
+  double step = rotation.getRadiansZeroTo2pi() * ROTATION_STEPS / (2 * M_PI);
+  int index = qMin(static_cast<int>(step), ROTATION_STEPS - 1);
+  double fraction = step - index;
+  const QPair<double, double> &from = table.at(index);
+  const QPair<double, double> &to = table.at(index + 1);
+  *sin = from.first + (to.first - from.first) * fraction;
+  *cos = from.second + (to.second - from.second) * fraction;
+}
+
 }  // namespace mms
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <QMatrix4x4>
 #include <QVector>
 
+#include "Color.h"
 #include "Mouse.h"
 #include "TriangleGraphic.h"
 
@@ -10,10 +12,39 @@ namespace mms {
 class MouseGraphic {
  public:
   MouseGraphic(const Mouse *mouse);
+
+  // The body is drawn in the given color rather than the configured one,
+  // e.g., to tell several mice in the same maze apart
+  MouseGraphic(const Mouse *mouse, Color bodyColor);
+
+  // The triangles of the mouse at its initial translation and rotation. These
+  // don't change as the mouse moves, so they only need to be drawn once (or
+  // again, if the mouse colors change).
   QVector<TriangleGraphic> draw() const;
 
+  // Transforms the triangles from the initial translation and rotation of the
+  // mouse to where it's drawn at the timestamp (see Mouse::getDrawnPose)
+  QMatrix4x4 getModelMatrix(double timestamp) const;
+
+  // Where the mouse is drawn at the timestamp, e.g., for the camera to follow
+  Coordinate getDrawnTranslation(double timestamp) const;
+
+  // See Mouse::isCatchingUp
+  bool isCatchingUp(double timestamp) const;
+
  private:
+  // Every turn is an in-place rotation from a multiple of 45 degrees, so the
+  // rotations of every drawn turn are ranges of one table of sines and
+  // cosines, with this many steps per revolution
+  static const int ROTATION_STEPS;
+
+  // The sine and cosine of the rotation, interpolated linearly between the
+  // entries of the table, which is built on first use
+  static void getSinCos(Angle rotation, double *sin, double *cos);
+
   const Mouse *m_mouse;
+  bool m_hasBodyColor;
+  Color m_bodyColor;
 };
 
 }  // namespace mms
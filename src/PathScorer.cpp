@@ -0,0 +1,143 @@
+#include "PathScorer.h"
+
+#include <QtConcurrent>
+
+#include "AssertMacros.h"
+#include "Command.h"
+#include "Direction.h"
+#include "Simulation.h"
+#include "TextProtocol.h"
+
+namespace mms {
+
+PathScorer::PathScorer(const Maze *maze)
+    : m_semiHeight(2 * maze->getHeight() + 1),
+      m_centers(
+          Maze::getCenterPositions(maze->getWidth(), maze->getHeight())),
+      m_clearHalfSteps(QVector<unsigned short>()) {
+  // Only the clear half-steps are kept, since every move starts from the
+  // center or the edge of a tile, and any wall ahead shows up in them
+  QVector<unsigned char> blockedSemiDirections;
+  Simulation::getWallTables(maze, &blockedSemiDirections, &m_clearHalfSteps);
+}
+
+bool PathScorer::parse(const QString &sequence,
+                       QVector<MazeSolver::Move> *steps) {
+  // The command's own parser is used, so that exactly the sequences that an
+  // algo could send are valid; moves are straight until they're scored,
+  // since only the direction of the mouse says whether they're diagonal
+  Command command;
+  if (!TextProtocol::parse(("moveSequence " + sequence).toLatin1(),
+                           &command)) {
+    return false;
+  }
+  steps->clear();
+  for (int i = 0; i + 1 < command.values.size(); i += 2) {
+    int n = command.values.at(i + 1);
+    switch (static_cast<CommandType>(command.values.at(i))) {
+      case CommandType::MOVE_FORWARD:
+        steps->append({Movement::MOVE_STRAIGHT, 2 * n});
+        break;
+      case CommandType::MOVE_FORWARD_HALF:
+        steps->append({Movement::MOVE_STRAIGHT, n});
+        break;
+      case CommandType::TURN_RIGHT_45:
+        steps->append({Movement::TURN_RIGHT_45, 0});
+        break;
+      case CommandType::TURN_LEFT_45:
+        steps->append({Movement::TURN_LEFT_45, 0});
+        break;
+      case CommandType::TURN_RIGHT_90:
+        steps->append({Movement::TURN_RIGHT_90, 0});
+        break;
+      case CommandType::TURN_LEFT_90:
+        steps->append({Movement::TURN_LEFT_90, 0});
+        break;
+      default:
+        ASSERT_NEVER_RUNS();
+    }
+  }
+  return true;
+}
+
+PathScorer::Score PathScorer::score(
+    const QVector<MazeSolver::Move> &steps) const {
+  // As in Simulation::moveForward, a move that's blocked straight away
+  // doesn't start, and one that's blocked later goes as far as it can and
+  // then crashes; either way, nothing after it is performed
+  SemiPosition position = Simulation::INITIAL_STARTING_POSITION;
+  SemiDirection direction = Simulation::INITIAL_STARTING_DIRECTION;
+  QVector<MazeSolver::Move> moves;
+  int crashStep = -1;
+  for (int i = 0; i < steps.size() && crashStep == -1; i += 1) {
+    MazeSolver::Move move = steps.at(i);
+    switch (move.movement) {
+      case Movement::MOVE_STRAIGHT:
+      case Movement::MOVE_DIAGONAL: {
+        int clear = m_clearHalfSteps.at(
+            8 * (m_semiHeight * position.x + position.y) +
+            static_cast<int>(direction));
+        if (move.halfSteps < 1 || clear == 0) {
+          crashStep = i;
+          break;
+        }
+        if (clear < move.halfSteps) {
+          move.halfSteps = clear;
+          crashStep = i;
+        }
+        move.movement = ORDINAL_DIRECTIONS().contains(direction)
+                            ? Movement::MOVE_DIAGONAL
+                            : Movement::MOVE_STRAIGHT;
+        QPair<int, int> step = Simulation::getSemiStep(direction);
+        position.x += step.first * move.halfSteps;
+        position.y += step.second * move.halfSteps;
+        moves.append(move);
+        break;
+      }
+      case Movement::TURN_RIGHT_45:
+        direction = DIRECTION_ROTATE_45_RIGHT().value(direction);
+        moves.append(move);
+        break;
+      case Movement::TURN_LEFT_45:
+        direction = DIRECTION_ROTATE_45_LEFT().value(direction);
+        moves.append(move);
+        break;
+      case Movement::TURN_RIGHT_90:
+        direction = DIRECTION_ROTATE_90_RIGHT().value(direction);
+        moves.append(move);
+        break;
+      case Movement::TURN_LEFT_90:
+        direction = DIRECTION_ROTATE_90_LEFT().value(direction);
+        moves.append(move);
+        break;
+      default:
+        ASSERT_NEVER_RUNS();
+    }
+  }
+
+  // A run ends in the center at any semi-position within a center tile, as
+  // in MazeSolver, including the edges on its west and south sides
+  bool isFinished = false;
+  for (const QPair<int, int> &center : m_centers) {
+    isFinished = isFinished || (2 * center.first <= position.x &&
+                                position.x <= 2 * center.first + 1 &&
+                                2 * center.second <= position.y &&
+                                position.y <= 2 * center.second + 1);
+  }
+  double progress = 0.0;
+  for (const MazeSolver::Move &move : moves) {
+    progress += MazeSolver::getProgressRequired(move);
+  }
+  return {crashStep, crashStep == -1 && isFinished, progress,
+          MazeSolver::getSeconds(moves)};
+}
+
+QVector<PathScorer::Score> PathScorer::scoreAll(
+    const QVector<QVector<MazeSolver::Move>> &sequences) const {
+  return QtConcurrent::blockingMapped<QVector<Score>>(
+      sequences, [this](const QVector<MazeSolver::Move> &steps) {
+        return score(steps);
+      });
+}
+
+}  // namespace mms
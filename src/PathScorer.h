@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include "Maze.h"
+#include "MazeSolver.h"
+
+namespace mms {
+
+// Scores candidate runs, e.g., the speed runs of a planner, exactly as the
+// simulator would: each is the steps of a moveSequence, which are checked
+// against the same wall tables that a simulation of the maze keeps (see
+// Simulation::getWallTables), and costed in progress, as the simulation
+// times movements, and in seconds, as a real mouse would drive them (see
+// MazeSolver::getSeconds). Nothing is animated and no algo is run, and a
+// scorer is never changed once it's made, so any number of threads can
+// share one, as scoreAll does.
+class PathScorer {
+ public:
+  struct Score {
+    int crashStep;    // the index of the step that crashed, or -1
+    bool isFinished;  // whether the run ends in the center, without crashing
+    double progress;  // of the steps that were taken, up to any crash
+    double seconds;   // likewise
+  };
+
+  explicit PathScorer(const Maze *maze);
+
+  // The steps of the sequence, as in the moveSequence command, e.g.,
+  // "F6 R45 H3 L45 F2"; returns false if it isn't valid
+  static bool parse(const QString &sequence, QVector<MazeSolver::Move> *steps);
+
+  // The steps are those of parse, or any others, from the start of the maze
+  Score score(const QVector<MazeSolver::Move> &steps) const;
+
+  // The scores of every sequence, in order, on every core
+  QVector<Score> scoreAll(
+      const QVector<QVector<MazeSolver::Move>> &sequences) const;
+
+ private:
+  int m_semiHeight;
+  QVector<QPair<int, int>> m_centers;
+  QVector<unsigned short> m_clearHalfSteps;
+};
+
+}  // namespace mms
@@ -0,0 +1,455 @@
+#include "PluginAlgo.h"
+
+#include "AssertMacros.h"
+#include "ReferenceAlgo.h"
+
+namespace mms {
+
+PluginAlgo *PluginAlgo::load(const QString &path, QString *error) {
+  ASSERT_FA(error == nullptr);
+  QLibrary *library = new QLibrary(path);
+  if (!library->load()) {
+    *error = library->errorString();
+    delete library;
+    return nullptr;
+  }
+  mms_plugin_run_function function = reinterpret_cast<mms_plugin_run_function>(
+      library->resolve("mms_plugin_run"));
+  mms_plugin_start_function start = reinterpret_cast<mms_plugin_start_function>(
+      library->resolve("mms_plugin_start"));
+  mms_plugin_resume_function resume =
+      reinterpret_cast<mms_plugin_resume_function>(
+          library->resolve("mms_plugin_resume"));
+  mms_plugin_destroy_function destroy =
+      reinterpret_cast<mms_plugin_destroy_function>(
+          library->resolve("mms_plugin_destroy"));
+  mms_plugin_batch_start_function batchStart =
+      reinterpret_cast<mms_plugin_batch_start_function>(
+          library->resolve("mms_plugin_batch_start"));
+  mms_plugin_batch_step_function batchStep =
+      reinterpret_cast<mms_plugin_batch_step_function>(
+          library->resolve("mms_plugin_batch_step"));
+  mms_plugin_batch_destroy_function batchDestroy =
+      reinterpret_cast<mms_plugin_batch_destroy_function>(
+          library->resolve("mms_plugin_batch_destroy"));
+  bool isResumable =
+      start != nullptr && resume != nullptr && destroy != nullptr;
+  bool isBatched =
+      batchStart != nullptr && batchStep != nullptr && batchDestroy != nullptr;
+  if (function == nullptr && !isResumable && !isBatched) {
+    *error = QString("%1 exports neither mms_plugin_run, nor mms_plugin_start "
+                     "and friends, nor mms_plugin_batch_start and friends")
+                 .arg(path);
+    library->unload();
+    delete library;
+    return nullptr;
+  }
+  if (isResumable) {
+    // Either way of running it works, and this one supports both
+    function = nullptr;
+  } else {
+    start = nullptr;
+    resume = nullptr;
+    destroy = nullptr;
+  }
+  PluginAlgo *plugin =
+      new PluginAlgo(library, function, start, resume, destroy);
+  if (isBatched) {
+    plugin->m_batchStart = batchStart;
+    plugin->m_batchStep = batchStep;
+    plugin->m_batchDestroy = batchDestroy;
+  }
+  return plugin;
+}
+
+PluginAlgo *PluginAlgo::getReference(const QString &name, QString *error) {
+  ASSERT_FA(error == nullptr);
+  mms_plugin_run_function function = ReferenceAlgo::get(name);
+  if (function == nullptr) {
+    *error = QString("Unknown reference algo \"%1\", expected one of: %2")
+                 .arg(name, ReferenceAlgo::getNames().join(", "));
+    return nullptr;
+  }
+  return new PluginAlgo(nullptr, function, nullptr, nullptr, nullptr);
+}
+
+PluginAlgo::PluginAlgo(QLibrary *library, mms_plugin_run_function function,
+                       mms_plugin_start_function start,
+                       mms_plugin_resume_function resume,
+                       mms_plugin_destroy_function destroy)
+    : m_library(library),
+      m_function(function),
+      m_start(start),
+      m_resume(resume),
+      m_destroy(destroy),
+      m_batchStart(nullptr),
+      m_batchStep(nullptr),
+      m_batchDestroy(nullptr) {}
+
+PluginAlgo::~PluginAlgo() {
+  if (m_library != nullptr) {
+    m_library->unload();
+    delete m_library;
+  }
+}
+
+bool PluginAlgo::run(Simulation *simulation, double timeoutSeconds) {
+  ASSERT_FA(simulation == nullptr);
+  if (isResumable()) {
+    // With nothing else to interleave it with, it's just resumed until done
+    Instance *instance = start(simulation, timeoutSeconds);
+    while (instance->resume()) {
+    }
+    bool timedOut = instance->isTimedOut();
+    delete instance;
+    return !timedOut;
+  }
+  Context context;
+  context.simulation = simulation;
+  context.timeoutMilliseconds = static_cast<qint64>(timeoutSeconds * 1000);
+  context.timedOut = false;
+  context.timer.start();
+
+  mms_api api;
+  initApi(&context, &api);
+  m_function(&api);
+  return !context.timedOut;
+}
+
+bool PluginAlgo::isResumable() const { return m_start != nullptr; }
+
+bool PluginAlgo::isBatched() const { return m_batchStart != nullptr; }
+
+bool PluginAlgo::runBatch(LockstepBatch *batch, int first,
+                          double timeoutSeconds) const {
+  ASSERT_TR(isBatched());
+  ASSERT_FA(batch == nullptr);
+  qint64 timeoutMilliseconds = static_cast<qint64>(timeoutSeconds * 1000);
+  QElapsedTimer timer;
+  timer.start();
+
+  // The algo is only asked for the movements of the mice that are running,
+  // so the others are left as they are
+  QVector<mms_move> moves(batch->getCount(), {MMS_MOVE_NONE, 0});
+  void *state =
+      m_batchStart(batch->getCount(), first, batch->getWidths().constData(),
+                   batch->getHeights().constData());
+  bool timedOut = false;
+  while (batch->isRunning()) {
+    if (0 < timeoutMilliseconds && timeoutMilliseconds <= timer.elapsed()) {
+      batch->timeOut();
+      timedOut = true;
+      break;
+    }
+    m_batchStep(state, batch->sense(), moves.data());
+    batch->advance(moves.constData());
+  }
+  m_batchDestroy(state);
+  return !timedOut;
+}
+
+PluginAlgo::Instance *PluginAlgo::start(Simulation *simulation,
+                                        double timeoutSeconds) const {
+  ASSERT_TR(isResumable());
+  ASSERT_FA(simulation == nullptr);
+  return new Instance(this, simulation, timeoutSeconds);
+}
+
+PluginAlgo::Instance::Instance(const PluginAlgo *plugin,
+                               Simulation *simulation, double timeoutSeconds)
+    : m_resume(plugin->m_resume),
+      m_destroy(plugin->m_destroy),
+      m_context(new Context()),
+      m_api(),
+      m_instance(nullptr),
+      m_move({MMS_MOVE_NONE, 0}),
+      m_isFinished(false) {
+  m_context->simulation = simulation;
+  m_context->timeoutMilliseconds = static_cast<qint64>(timeoutSeconds * 1000);
+  m_context->timedOut = false;
+  m_context->timer.start();
+  initApi(m_context, &m_api);
+  m_instance = plugin->m_start(&m_api);
+}
+
+PluginAlgo::Instance::~Instance() {
+  m_destroy(m_instance);
+  delete m_context;
+}
+
+bool PluginAlgo::Instance::resume() {
+  if (m_isFinished || PluginAlgo::isTimedOut(m_context)) {
+    m_isFinished = true;
+    return false;
+  }
+  int moved = 0;
+  switch (m_move.movement) {
+    case MMS_MOVE_NONE:
+      break;
+    case MMS_MOVE_FORWARD:
+      moved = move(m_context, CommandType::MOVE_FORWARD, m_move.distance);
+      break;
+    case MMS_MOVE_FORWARD_HALF:
+      moved = move(m_context, CommandType::MOVE_FORWARD_HALF, m_move.distance);
+      break;
+    case MMS_MOVE_TURN_RIGHT:
+      moved = move(m_context, CommandType::TURN_RIGHT_90, 0);
+      break;
+    case MMS_MOVE_TURN_LEFT:
+      moved = move(m_context, CommandType::TURN_LEFT_90, 0);
+      break;
+    case MMS_MOVE_TURN_RIGHT_45:
+      moved = move(m_context, CommandType::TURN_RIGHT_45, 0);
+      break;
+    case MMS_MOVE_TURN_LEFT_45:
+      moved = move(m_context, CommandType::TURN_LEFT_45, 0);
+      break;
+    default:
+      // An unknown movement is treated as a crash, like an invalid command
+      break;
+  }
+  m_move = m_resume(m_instance, moved);
+  m_isFinished = m_move.movement == MMS_MOVE_NONE;
+  return !m_isFinished;
+}
+
+bool PluginAlgo::Instance::isTimedOut() const { return m_context->timedOut; }
+
+void PluginAlgo::initApi(Context *context, mms_api *api) {
+  api->version = MMS_PLUGIN_VERSION;
+  api->context = context;
+  api->stopped = &PluginAlgo::stopped;
+  api->maze_width = &PluginAlgo::mazeWidth;
+  api->maze_height = &PluginAlgo::mazeHeight;
+  api->wall_front = &PluginAlgo::wallFront;
+  api->wall_right = &PluginAlgo::wallRight;
+  api->wall_left = &PluginAlgo::wallLeft;
+  api->wall_back = &PluginAlgo::wallBack;
+  api->wall_front_right = &PluginAlgo::wallFrontRight;
+  api->wall_front_left = &PluginAlgo::wallFrontLeft;
+  api->wall_back_right = &PluginAlgo::wallBackRight;
+  api->wall_back_left = &PluginAlgo::wallBackLeft;
+  api->walls = &PluginAlgo::walls;
+  api->move_forward = &PluginAlgo::moveForward;
+  api->move_forward_half = &PluginAlgo::moveForwardHalf;
+  api->turn_right = &PluginAlgo::turnRight;
+  api->turn_left = &PluginAlgo::turnLeft;
+  api->turn_right_45 = &PluginAlgo::turnRight45;
+  api->turn_left_45 = &PluginAlgo::turnLeft45;
+  api->set_wall = &PluginAlgo::setWall;
+  api->clear_wall = &PluginAlgo::clearWall;
+  api->set_color = &PluginAlgo::setColor;
+  api->clear_color = &PluginAlgo::clearColor;
+  api->clear_all_color = &PluginAlgo::clearAllColor;
+  api->set_text = &PluginAlgo::setText;
+  api->clear_text = &PluginAlgo::clearText;
+  api->clear_all_text = &PluginAlgo::clearAllText;
+  api->draw_path = &PluginAlgo::drawPath;
+  api->clear_path = &PluginAlgo::clearPath;
+  api->set_color_grid = &PluginAlgo::setColorGrid;
+  api->set_text_grid = &PluginAlgo::setTextGrid;
+  api->was_reset = &PluginAlgo::wasReset;
+  api->ack_reset = &PluginAlgo::ackReset;
+  api->get_stat = &PluginAlgo::getStat;
+  api->metric = &PluginAlgo::metric;
+}
+
+bool PluginAlgo::isTimedOut(void *context) {
+  Context *run = static_cast<Context *>(context);
+  if (!run->timedOut && 0 < run->timeoutMilliseconds &&
+      run->timeoutMilliseconds <= run->timer.elapsed()) {
+    run->timedOut = true;
+  }
+  return run->timedOut;
+}
+
+Response PluginAlgo::execute(void *context, const Command &command) {
+  return static_cast<Context *>(context)->simulation->execute(command);
+}
+
+int PluginAlgo::query(void *context, CommandType type, int n) {
+  Command command = {type};
+  command.n = n;
+  return static_cast<int>(execute(context, command).value);
+}
+
+int PluginAlgo::move(void *context, CommandType type, int n) {
+  // The algo can't be killed, so refuse to move once it has run out of time,
+  // in the hope that it notices and returns
+  if (isTimedOut(context)) {
+    return 0;
+  }
+  Command command = {type};
+  command.n = n;
+  return execute(context, command).type == ResponseType::ACK ? 1 : 0;
+}
+
+void PluginAlgo::annotate(void *context, CommandType type, int x, int y,
+                          char c) {
+  Command command = {type};
+  command.x = x;
+  command.y = y;
+  command.c = QChar::fromLatin1(c);
+  execute(context, command);
+}
+
+int PluginAlgo::stopped(void *context) { return isTimedOut(context) ? 1 : 0; }
+
+int PluginAlgo::mazeWidth(void *context) {
+  return query(context, CommandType::MAZE_WIDTH, 0);
+}
+
+int PluginAlgo::mazeHeight(void *context) {
+  return query(context, CommandType::MAZE_HEIGHT, 0);
+}
+
+int PluginAlgo::wallFront(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_FRONT, halfSteps);
+}
+
+int PluginAlgo::wallRight(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_RIGHT, halfSteps);
+}
+
+int PluginAlgo::wallLeft(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_LEFT, halfSteps);
+}
+
+int PluginAlgo::wallBack(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_BACK, halfSteps);
+}
+
+int PluginAlgo::wallFrontRight(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_FRONT_RIGHT, halfSteps);
+}
+
+int PluginAlgo::wallFrontLeft(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_FRONT_LEFT, halfSteps);
+}
+
+int PluginAlgo::wallBackRight(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_BACK_RIGHT, halfSteps);
+}
+
+int PluginAlgo::wallBackLeft(void *context, int halfSteps) {
+  return query(context, CommandType::WALL_BACK_LEFT, halfSteps);
+}
+
+int PluginAlgo::walls(void *context, int halfSteps) {
+  return query(context, CommandType::WALLS, halfSteps);
+}
+
+int PluginAlgo::moveForward(void *context, int distance) {
+  return move(context, CommandType::MOVE_FORWARD, distance);
+}
+
+int PluginAlgo::moveForwardHalf(void *context, int distance) {
+  return move(context, CommandType::MOVE_FORWARD_HALF, distance);
+}
+
+void PluginAlgo::turnRight(void *context) {
+  move(context, CommandType::TURN_RIGHT_90, 0);
+}
+
+void PluginAlgo::turnLeft(void *context) {
+  move(context, CommandType::TURN_LEFT_90, 0);
+}
+
+void PluginAlgo::turnRight45(void *context) {
+  move(context, CommandType::TURN_RIGHT_45, 0);
+}
+
+void PluginAlgo::turnLeft45(void *context) {
+  move(context, CommandType::TURN_LEFT_45, 0);
+}
+
+void PluginAlgo::setWall(void *context, int x, int y, char direction) {
+  annotate(context, CommandType::SET_WALL, x, y, direction);
+}
+
+void PluginAlgo::clearWall(void *context, int x, int y, char direction) {
+  annotate(context, CommandType::CLEAR_WALL, x, y, direction);
+}
+
+void PluginAlgo::setColor(void *context, int x, int y, char color) {
+  annotate(context, CommandType::SET_COLOR, x, y, color);
+}
+
+void PluginAlgo::clearColor(void *context, int x, int y) {
+  annotate(context, CommandType::CLEAR_COLOR, x, y, ' ');
+}
+
+void PluginAlgo::clearAllColor(void *context) {
+  annotate(context, CommandType::CLEAR_ALL_COLOR, 0, 0, ' ');
+}
+
+void PluginAlgo::setText(void *context, int x, int y, const char *text) {
+  Command command = {CommandType::SET_TEXT};
+  command.x = x;
+  command.y = y;
+  command.text = QString::fromUtf8(text);
+  execute(context, command);
+}
+
+void PluginAlgo::clearText(void *context, int x, int y) {
+  annotate(context, CommandType::CLEAR_TEXT, x, y, ' ');
+}
+
+void PluginAlgo::clearAllText(void *context) {
+  annotate(context, CommandType::CLEAR_ALL_TEXT, 0, 0, ' ');
+}
+
+void PluginAlgo::drawPath(void *context, char color, const int *points,
+                          int count) {
+  Command command = {CommandType::DRAW_PATH};
+  command.c = color;
+  for (int i = 0; i < count; i += 1) {
+    command.cells.append({points[2 * i], points[2 * i + 1], ' ', ""});
+  }
+  execute(context, command);
+}
+
+void PluginAlgo::clearPath(void *context) {
+  annotate(context, CommandType::CLEAR_PATH, 0, 0, ' ');
+}
+
+void PluginAlgo::setColorGrid(void *context, const char *colors) {
+  Command command = {CommandType::SET_COLOR_GRID};
+  command.text = QString::fromLatin1(colors);
+  execute(context, command);
+}
+
+void PluginAlgo::setTextGrid(void *context, int fieldWidth,
+                             const char *texts) {
+  Command command = {CommandType::SET_TEXT_GRID};
+  command.n = fieldWidth;
+  command.text = QString::fromLatin1(texts);
+  execute(context, command);
+}
+
+int PluginAlgo::wasReset(void *context) {
+  return query(context, CommandType::WAS_RESET, 0);
+}
+
+void PluginAlgo::ackReset(void *context) {
+  query(context, CommandType::ACK_RESET, 0);
+}
+
+double PluginAlgo::getStat(void *context, const char *name) {
+  QString stat = QString::fromUtf8(name);
+  if (!STRING_TO_STAT().contains(stat)) {
+    return -1.0;
+  }
+  Command command = {CommandType::GET_STAT};
+  command.stat = STRING_TO_STAT().value(stat);
+  return execute(context, command).value;
+}
+
+void PluginAlgo::metric(void *context, const char *name, double value) {
+  Command command = {CommandType::METRIC};
+  command.text = QString::fromUtf8(name);
+  command.value = value;
+  execute(context, command);
+}
+
+}  // namespace mms
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QLibrary>
+#include <QString>
+
+#include "../util/mms-plugin.h"
+#include "Command.h"
+#include "LockstepBatch.h"
+#include "Simulation.h"
+
+namespace mms {
+
+// An optional alternative to algo processes for C and C++ algos. The algo is
+// loaded as a shared library and called directly, with each API function
+// answered synchronously by the simulation, so there's no process startup and
+// no protocol to encode or parse. See util/mms-plugin.h for the interface.
+class PluginAlgo {
+ private:
+  struct Context;
+
+ public:
+  // A run of a resumable algo (see util/mms-coro.h), which suspends at each
+  // movement rather than blocking in it, so that the caller decides when it
+  // continues, and many runs can be interleaved on a few threads (see
+  // PluginScheduler)
+  class Instance {
+   public:
+    // Destroys the algo's instance, even if it's suspended
+    ~Instance();
+
+    // Completes the movement that the algo is suspended at, if any, and then
+    // runs the algo until its next one. Returns false, doing nothing, once
+    // the algo has returned or the run has timed out.
+    bool resume();
+
+    bool isTimedOut() const;
+
+   private:
+    friend class PluginAlgo;
+    Instance(const PluginAlgo *plugin, Simulation *simulation,
+             double timeoutSeconds);
+
+    mms_plugin_resume_function m_resume;
+    mms_plugin_destroy_function m_destroy;
+    Context *m_context;
+    mms_api m_api;
+    void *m_instance;
+    mms_move m_move;  // the movement that the algo is suspended at
+    bool m_isFinished;
+  };
+
+  // Returns nullptr if the library can't be loaded or doesn't export any of
+  // the ways to run an algo, in which case the error is set
+  static PluginAlgo *load(const QString &path, QString *error);
+
+  // Returns one of the algos that are built in (see ReferenceAlgo), which is
+  // run just like a plugin, or nullptr if there's none with that name
+  static PluginAlgo *getReference(const QString &name, QString *error);
+  ~PluginAlgo();
+
+  // Runs the algo against the simulation, which must be instant, until the
+  // algo returns. A non-positive timeout means that the run is never cut
+  // short. Returns false if the run timed out.
+  bool run(Simulation *simulation, double timeoutSeconds);
+
+  // Whether the algo exports mms_plugin_start and friends instead of
+  // mms_plugin_run, in which case its runs can also be started as instances
+  bool isResumable() const;
+  Instance *start(Simulation *simulation, double timeoutSeconds) const;
+
+  // Whether the algo exports mms_plugin_batch_start and friends, in which
+  // case it steps all of the mice of a batch at once, rather than being run
+  bool isBatched() const;
+
+  // Steps the mice, the first of which is of the given run, until they've
+  // all stopped, or until the timeout, after which the rest time out.
+  // Returns false if the batch timed out.
+  bool runBatch(LockstepBatch *batch, int first, double timeoutSeconds) const;
+
+ private:
+  PluginAlgo(QLibrary *library, mms_plugin_run_function function,
+             mms_plugin_start_function start,
+             mms_plugin_resume_function resume,
+             mms_plugin_destroy_function destroy);
+
+  QLibrary *m_library;  // null for reference algos
+  mms_plugin_run_function m_function;  // null if resumable
+
+  // Null unless resumable
+  mms_plugin_start_function m_start;
+  mms_plugin_resume_function m_resume;
+  mms_plugin_destroy_function m_destroy;
+
+  // Null unless batched
+  mms_plugin_batch_start_function m_batchStart;
+  mms_plugin_batch_step_function m_batchStep;
+  mms_plugin_batch_destroy_function m_batchDestroy;
+
+  // The state of a single run, passed to the algo as its context
+  struct Context {
+    Simulation *simulation;
+    QElapsedTimer timer;
+    qint64 timeoutMilliseconds;
+    bool timedOut;
+  };
+
+  static void initApi(Context *context, mms_api *api);
+  static bool isTimedOut(void *context);
+  static Response execute(void *context, const Command &command);
+  static int query(void *context, CommandType type, int n);
+  static int move(void *context, CommandType type, int n);
+  static void annotate(void *context, CommandType type, int x, int y,
+                       char c);
+
+  // ----- API -----
+
+  static int stopped(void *context);
+
+  static int mazeWidth(void *context);
+  static int mazeHeight(void *context);
+
+  static int wallFront(void *context, int halfSteps);
+  static int wallRight(void *context, int halfSteps);
+  static int wallLeft(void *context, int halfSteps);
+  static int wallBack(void *context, int halfSteps);
+  static int wallFrontRight(void *context, int halfSteps);
+  static int wallFrontLeft(void *context, int halfSteps);
+  static int wallBackRight(void *context, int halfSteps);
+  static int wallBackLeft(void *context, int halfSteps);
+  static int walls(void *context, int halfSteps);
+
+  static int moveForward(void *context, int distance);
+  static int moveForwardHalf(void *context, int distance);
+  static void turnRight(void *context);
+  static void turnLeft(void *context);
+  static void turnRight45(void *context);
+  static void turnLeft45(void *context);
+
+  static void setWall(void *context, int x, int y, char direction);
+  static void clearWall(void *context, int x, int y, char direction);
+  static void setColor(void *context, int x, int y, char color);
+  static void clearColor(void *context, int x, int y);
+  static void clearAllColor(void *context);
+  static void setText(void *context, int x, int y, const char *text);
+  static void clearText(void *context, int x, int y);
+  static void clearAllText(void *context);
+  static void drawPath(void *context, char color, const int *points,
+                       int count);
+  static void clearPath(void *context);
+  static void setColorGrid(void *context, const char *colors);
+  static void setTextGrid(void *context, int fieldWidth, const char *texts);
+
+  static int wasReset(void *context);
+  static void ackReset(void *context);
+
+  static double getStat(void *context, const char *name);
+
+  static void metric(void *context, const char *name, double value);
+};
+
+}  // namespace mms
@@ -0,0 +1,106 @@
+#include "PluginScheduler.h"
+
+#include <QMutexLocker>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int PluginScheduler::MOVES_PER_TURN = 16;
+
+PluginScheduler::PluginScheduler(int numThreads, QObject *parent)
+    : QObject(parent),
+      m_nextQueue(0),
+      m_numQueued(0),
+      m_isStopping(false) {
+  ASSERT_LT(0, numThreads);
+  for (int i = 0; i < numThreads; i += 1) {
+    m_queues.append(new Queue());
+  }
+  for (int i = 0; i < numThreads; i += 1) {
+    QThread *thread = QThread::create([=]() { work(i); });
+    m_threads.append(thread);
+    thread->start();
+  }
+}
+
+PluginScheduler::~PluginScheduler() {
+  {
+    QMutexLocker locker(&m_mutex);
+    m_isStopping = true;
+    m_condition.wakeAll();
+  }
+  for (QThread *thread : m_threads) {
+    thread->wait();
+    delete thread;
+  }
+  for (Queue *queue : m_queues) {
+    delete queue;
+  }
+}
+
+void PluginScheduler::add(PluginAlgo::Instance *instance, int id) {
+  push(m_nextQueue, {instance, id});
+  m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+}
+
+void PluginScheduler::work(int index) {
+  while (true) {
+    Task task;
+    if (!take(index, &task)) {
+      QMutexLocker locker(&m_mutex);
+      while (m_numQueued == 0 && !m_isStopping) {
+        m_condition.wait(&m_mutex);
+      }
+      if (m_isStopping) {
+        return;
+      }
+      continue;
+    }
+    bool isRunning = true;
+    for (int i = 0; isRunning && i < MOVES_PER_TURN; i += 1) {
+      isRunning = task.instance->resume();
+    }
+    if (isRunning) {
+      push(index, task);
+    } else {
+      emit finished(task.id);
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_isStopping) {
+      return;
+    }
+  }
+}
+
+bool PluginScheduler::take(int index, Task *task) {
+  // The front of a queue is the instance that has waited the longest, while
+  // the back is the one that was resumed most recently, so thieves take the
+  // back and leave the owner's order alone
+  bool found = false;
+  for (int i = 0; !found && i < m_queues.size(); i += 1) {
+    Queue *queue = m_queues.at((index + i) % m_queues.size());
+    QMutexLocker locker(&queue->mutex);
+    if (!queue->tasks.isEmpty()) {
+      *task = i == 0 ? queue->tasks.takeFirst() : queue->tasks.takeLast();
+      found = true;
+    }
+  }
+  if (found) {
+    QMutexLocker locker(&m_mutex);
+    m_numQueued -= 1;
+  }
+  return found;
+}
+
+void PluginScheduler::push(int index, const Task &task) {
+  {
+    QMutexLocker locker(&m_queues.at(index)->mutex);
+    m_queues.at(index)->tasks.append(task);
+  }
+  QMutexLocker locker(&m_mutex);
+  m_numQueued += 1;
+  m_condition.wakeOne();
+}
+
+}  // namespace mms
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "PluginAlgo.h"
+
+namespace mms {
+
+// Resumes the instances of a resumable plugin (see PluginAlgo::Instance) on a
+// small pool of threads, so that far more runs than there are cores can be in
+// flight at once, each of them costing only its simulation and coroutine.
+// Scheduling is cooperative: an instance is resumed a few movements at a
+// time, and then goes to the back of its thread's queue. Each thread takes
+// from the front of its own queue, and, once that's empty, steals from the
+// back of another's, so a thread whose runs finish early never sits idle
+// while the others have work.
+//
+// An instance is only ever resumed by one thread at a time, but it's not
+// always the same thread, so the simulation of a run must not rely on its
+// event loop; an instant simulation without a view, output, hang timeout, or
+// time budget never does.
+class PluginScheduler : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit PluginScheduler(int numThreads, QObject *parent = nullptr);
+
+  // Stops the threads once their current turns are over; instances that
+  // haven't finished are left as they are
+  ~PluginScheduler();
+
+  // Resumes the instance, which isn't owned by the scheduler, until it
+  // finishes; the id is passed back to identify it
+  void add(PluginAlgo::Instance *instance, int id);
+
+ signals:
+  // Emitted from one of the threads once the instance has finished, after
+  // which the scheduler never touches it again
+  void finished(int id);
+
+ private:
+  static const int MOVES_PER_TURN;
+
+  struct Task {
+    PluginAlgo::Instance *instance;
+    int id;
+  };
+
+  // Each thread's queue has a lock of its own, so that threads only contend
+  // when one of them steals
+  struct Queue {
+    QMutex mutex;
+    QList<Task> tasks;
+  };
+
+  QVector<QThread *> m_threads;
+  QVector<Queue *> m_queues;  // by thread
+  int m_nextQueue;  // that an added instance goes to, in turn
+
+  // Idle threads wait until something is queued
+  QMutex m_mutex;
+  QWaitCondition m_condition;
+  int m_numQueued;
+  bool m_isStopping;
+
+  void work(int index);
+  bool take(int index, Task *task);
+  void push(int index, const Task &task);
+};
+
+}  // namespace mms
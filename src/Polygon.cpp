@@ -5,10 +5,11 @@
 #include "AssertMacros.h"
 #include "GeometryUtilities.h"
 #include "SimUtilities.h"
-#include "polypartition/polypartition.h"
 
 namespace mms {
 
+const int Polygon::MAX_TRIANGULATED_VERTICES = 256;
+
 Polygon::Polygon() {}
 
 Polygon::Polygon(const Polygon &polygon) : m_vertices(polygon.getVertices()) {
@@ -35,8 +36,16 @@ Polygon::Polygon(QVector<Coordinate> vertices)
       // Postpone triangulation until we absolutely have to do it.
       m_triangles({}) {
   ASSERT_LE(3, m_vertices.size());
-  // If the number of vertices is three, the triangulation is trivial
-  if (m_vertices.size() == 3) {
+  // If the polygon is convex, e.g., every polygon of a tile, the
+  // triangulation is trivial, so do it now; copies share the triangles, so
+  // each polygon is only ever triangulated once
+  double orientation =
+      getConvexOrientation(m_vertices.constData(), m_vertices.size());
+  if (orientation != 0.0) {
+    m_triangles.resize(m_vertices.size() - 2);
+    fan(m_vertices.constData(), m_vertices.size(), orientation,
+        m_triangles.data());
+  } else if (m_vertices.size() == 3) {
     m_triangles = {{
         m_vertices.at(0),
         m_vertices.at(1),
@@ -50,18 +59,22 @@ QVector<Coordinate> Polygon::getVertices() const { return m_vertices; }
 QVector<Triangle> Polygon::getTriangles() const {
   // Lazy initialization here
   if (m_triangles.size() == 0) {
-    m_triangles = triangulate(m_vertices);
+    m_triangles.resize(m_vertices.size() - 2);
+    triangulate(m_vertices.constData(), m_vertices.size(),
+                m_triangles.data());
   }
   return m_triangles;
 }
 
 Polygon Polygon::translate(const Coordinate &translation) const {
   QVector<Coordinate> vertices;
+  vertices.reserve(m_vertices.size());
   for (const Coordinate &vertex : m_vertices) {
     vertices.append(GeometryUtilities::translateVertex(vertex, translation));
   }
 
   QVector<Triangle> triangles;
+  triangles.reserve(m_triangles.size());
   for (const Triangle &triangle : m_triangles) {
     triangles.append({
         GeometryUtilities::translateVertex(triangle.p1, translation),
@@ -75,18 +88,27 @@ Polygon Polygon::translate(const Coordinate &translation) const {
 
 Polygon Polygon::rotateAroundPoint(const Angle &angle,
                                    const Coordinate &point) const {
+  // The sine and cosine are the same for every vertex
+  double sin = angle.getSin();
+  double cos = angle.getCos();
+
   QVector<Coordinate> vertices;
+  vertices.reserve(m_vertices.size());
   for (const Coordinate &vertex : m_vertices) {
     vertices.append(
-        GeometryUtilities::rotateVertexAroundPoint(vertex, point, angle));
+        GeometryUtilities::rotateVertexAroundPoint(vertex, point, sin, cos));
   }
 
   QVector<Triangle> triangles;
+  triangles.reserve(m_triangles.size());
   for (const Triangle &triangle : m_triangles) {
     triangles.append({
-        GeometryUtilities::rotateVertexAroundPoint(triangle.p1, point, angle),
-        GeometryUtilities::rotateVertexAroundPoint(triangle.p2, point, angle),
-        GeometryUtilities::rotateVertexAroundPoint(triangle.p3, point, angle),
+        GeometryUtilities::rotateVertexAroundPoint(triangle.p1, point, sin,
+                                                   cos),
+        GeometryUtilities::rotateVertexAroundPoint(triangle.p2, point, sin,
+                                                   cos),
+        GeometryUtilities::rotateVertexAroundPoint(triangle.p3, point, sin,
+                                                   cos),
     });
   }
 
@@ -100,35 +122,125 @@ bool Polygon::alreadyPerformedTriangulation() const {
   return 0 < m_triangles.size();
 }
 
-QVector<Triangle> Polygon::triangulate(QVector<Coordinate> vertices) {
-  // Populate the TPPLPoly
-  TPPLPoly tpplPoly;
-  tpplPoly.Init(vertices.size());
-  for (int i = 0; i < vertices.size(); i += 1) {
-    tpplPoly[i].x = vertices.at(i).getX().getMeters();
-    tpplPoly[i].y = vertices.at(i).getY().getMeters();
+int Polygon::triangulate(const Coordinate *vertices, int count,
+                         Triangle *triangles) {
+  ASSERT_LE(3, count);
+  ASSERT_LE(count, MAX_TRIANGULATED_VERTICES);
+
+  // Convex polygons are much cheaper to fan than to ear clip
+  double orientation = getConvexOrientation(vertices, count);
+  if (orientation != 0.0) {
+    fan(vertices, count, orientation, triangles);
+    return count - 2;
   }
-  tpplPoly.SetOrientation(TPPL_CCW);
 
-  // Perform the triangulation
-  TPPLPartition triangulator;
-  std::list<TPPLPoly> result;
-  triangulator.Triangulate_EC(&tpplPoly, &result);
+  // The remaining vertices are kept counterclockwise, whatever the winding
+  // of the polygon, by the sign of its area
+  double xs[MAX_TRIANGULATED_VERTICES];
+  double ys[MAX_TRIANGULATED_VERTICES];
+  int remaining[MAX_TRIANGULATED_VERTICES];
+  double area = 0.0;
+  for (int i = 0; i < count; i += 1) {
+    xs[i] = vertices[i].getX().getMeters();
+    ys[i] = vertices[i].getY().getMeters();
+  }
+  for (int i = 0; i < count; i += 1) {
+    int j = (i + 1) % count;
+    area += xs[i] * ys[j] - xs[j] * ys[i];
+  }
+  for (int i = 0; i < count; i += 1) {
+    remaining[i] = 0.0 <= area ? i : count - 1 - i;
+  }
 
-  // Populate the output vector
-  QVector<Triangle> triangles;
-  for (auto it = result.begin(); it != result.end(); it++) {
-    triangles.append({
-        Coordinate::Cartesian(Distance::Meters((*it)[0].x),
-                              Distance::Meters((*it)[0].y)),
-        Coordinate::Cartesian(Distance::Meters((*it)[1].x),
-                              Distance::Meters((*it)[1].y)),
-        Coordinate::Cartesian(Distance::Meters((*it)[2].x),
-                              Distance::Meters((*it)[2].y)),
-    });
+  // Clip an ear at a time, trying each vertex in turn. Polygons with
+  // collinear or repeated vertices can run out of ears, in which case the
+  // next vertex is clipped anyway, so that there are always count - 2
+  // triangles covering every vertex.
+  int numTriangles = 0;
+  int size = count;
+  int index = 0;
+  int numTried = 0;
+  while (3 < size) {
+    if (!isEar(xs, ys, remaining, size, index) && numTried < size) {
+      index = (index + 1) % size;
+      numTried += 1;
+      continue;
+    }
+    triangles[numTriangles] = {
+        vertices[remaining[(index + size - 1) % size]],
+        vertices[remaining[index]],
+        vertices[remaining[(index + 1) % size]],
+    };
+    numTriangles += 1;
+    for (int i = index; i + 1 < size; i += 1) {
+      remaining[i] = remaining[i + 1];
+    }
+    size -= 1;
+    index %= size;
+    numTried = 0;
   }
+  triangles[numTriangles] = {
+      vertices[remaining[0]],
+      vertices[remaining[1]],
+      vertices[remaining[2]],
+  };
+  return numTriangles + 1;
+}
 
-  return triangles;
+void Polygon::fan(const Coordinate *vertices, int count, double orientation,
+                  Triangle *triangles) {
+  // Like ear clipping, the triangles are counterclockwise
+  for (int i = 1; i + 1 < count; i += 1) {
+    if (0.0 < orientation) {
+      triangles[i - 1] = {vertices[0], vertices[i], vertices[i + 1]};
+    } else {
+      triangles[i - 1] = {vertices[0], vertices[i + 1], vertices[i]};
+    }
+  }
+}
+
+double Polygon::getConvexOrientation(const Coordinate *vertices, int count) {
+  // The z components of the cross products of consecutive edges must all
+  // have the same sign; collinear edges are left to the ear clipping
+  double orientation = 0.0;
+  for (int i = 0; i < count; i += 1) {
+    const Coordinate &a = vertices[i];
+    const Coordinate &b = vertices[(i + 1) % count];
+    const Coordinate &c = vertices[(i + 2) % count];
+    double cross = (b.getX() - a.getX()).getMeters() *
+                       (c.getY() - b.getY()).getMeters() -
+                   (b.getY() - a.getY()).getMeters() *
+                       (c.getX() - b.getX()).getMeters();
+    if (cross == 0.0 || cross * orientation < 0.0) {
+      return 0.0;
+    }
+    orientation = cross;
+  }
+  return orientation;
+}
+
+bool Polygon::isEar(const double *xs, const double *ys, const int *remaining,
+                    int size, int index) {
+  // Positive if the point is to the left of the line from u to v
+  auto cross = [&](int u, int v, double x, double y) {
+    return (xs[v] - xs[u]) * (y - ys[u]) - (ys[v] - ys[u]) * (x - xs[u]);
+  };
+  int a = remaining[(index + size - 1) % size];
+  int b = remaining[index];
+  int c = remaining[(index + 1) % size];
+  if (cross(a, b, xs[c], ys[c]) <= 0.0) {
+    return false;
+  }
+  // A vertex on the edge of the triangle blocks it too, since clipping the
+  // ear would leave a zero-width gap at that vertex
+  for (int i = 0; i < size; i += 1) {
+    int p = remaining[i];
+    if (p != a && p != b && p != c && 0.0 <= cross(a, b, xs[p], ys[p]) &&
+        0.0 <= cross(b, c, xs[p], ys[p]) && 0.0 <= cross(c, a, xs[p], ys[p])) {
+      return false;
+    }
+  }
+  return true;
 }
 
 }  // namespace mms
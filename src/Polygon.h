@@ -20,12 +20,23 @@ class Polygon {
   Polygon translate(const Coordinate &translation) const;
   Polygon rotateAroundPoint(const Angle &angle, const Coordinate &point) const;
 
+  // The most vertices that triangulate takes, so that its working memory can
+  // be kept on the stack
+  static const int MAX_TRIANGULATED_VERTICES;
+
+  // Triangulates a simple polygon into the first count - 2 triangles of the
+  // buffer, all counterclockwise, without allocating anything, e.g., to
+  // re-triangulate dynamic geometry every frame. Convex polygons are fanned,
+  // and any others are ear clipped. Returns the number of triangles.
+  static int triangulate(const Coordinate *vertices, int count,
+                         Triangle *triangles);
+
  private:
   QVector<Coordinate> m_vertices;
 
-  // We're lazy about triangulation, since it's expensive and not always
-  // necessary. The "mutable" keyword allows us to assign m_triangles in the
-  // const function getTriangles().
+  // We're lazy about triangulating concave polygons, since it's expensive
+  // and not always necessary. The "mutable" keyword allows us to assign
+  // m_triangles in the const function getTriangles().
   mutable QVector<Triangle> m_triangles;
 
   // This special constructor makes it so that rotate and translate don't
@@ -39,8 +50,19 @@ class Polygon {
   // throwing away information.
   bool alreadyPerformedTriangulation() const;
 
-  // Actually peforms the triangulation of the polygon.
-  static QVector<Triangle> triangulate(QVector<Coordinate> vertices);
+  // Triangulates a convex polygon from its first vertex
+  static void fan(const Coordinate *vertices, int count, double orientation,
+                  Triangle *triangles);
+
+  // Positive if the polygon is convex and counterclockwise, negative if it's
+  // convex and clockwise, and zero otherwise
+  static double getConvexOrientation(const Coordinate *vertices, int count);
+
+  // Whether the remaining vertex at the index is the tip of an ear, i.e., it's
+  // convex, and no other remaining vertex is in the triangle it makes with its
+  // neighbors; the remaining vertices are indices, counterclockwise
+  static bool isEar(const double *xs, const double *ys, const int *remaining,
+                    int size, int index);
 };
 
 }  // namespace mms
@@ -1,9 +1,26 @@
 #include "ProcessUtilities.h"
 
+#include <QFile>
 #include <QStringList>
+#include <QtGlobal>
+
+#if defined(Q_OS_LINUX)
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <libproc.h>
+#include <mach/mach_time.h>
+#include <sys/resource.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
 
 namespace mms {
 
+const int ProcessUtilities::RAISED_NICE_VALUE = -10;
+
 bool ProcessUtilities::start(const QString &command, const QString &directory,
                              QProcess *process) {
   QStringList args = command.split(' ', Qt::SkipEmptyParts);
@@ -17,4 +34,168 @@ bool ProcessUtilities::start(const QString &command, const QString &directory,
   return process->waitForStarted();
 }
 
+bool ProcessUtilities::getUsage(qint64 pid, Usage *usage) {
+  if (pid <= 0) {
+    return false;
+  }
+#if defined(Q_OS_LINUX)
+  // The times are the 14th and 15th fields of stat, in clock ticks, counted
+  // from after the command name, which may itself contain spaces
+  QFile stat(QString("/proc/%1/stat").arg(pid));
+  QFile status(QString("/proc/%1/status").arg(pid));
+  if (!stat.open(QFile::ReadOnly) || !status.open(QFile::ReadOnly)) {
+    return false;
+  }
+  QByteArray line = stat.readAll();
+  QList<QByteArray> fields =
+      line.mid(line.lastIndexOf(')') + 1).simplified().split(' ');
+  if (fields.size() < 13) {
+    return false;
+  }
+  double ticksPerSecond = sysconf(_SC_CLK_TCK);
+  usage->userSeconds = fields.at(11).toLongLong() / ticksPerSecond;
+  usage->systemSeconds = fields.at(12).toLongLong() / ticksPerSecond;
+  usage->peakResidentBytes = 0;
+  usage->residentBytes = 0;
+  for (const QByteArray &entry : status.readAll().split('\n')) {
+    if (entry.startsWith("VmHWM:")) {
+      QList<QByteArray> parts = entry.simplified().split(' ');
+      usage->peakResidentBytes = parts.value(1).toLongLong() * 1024;
+    } else if (entry.startsWith("VmRSS:")) {
+      QList<QByteArray> parts = entry.simplified().split(' ');
+      usage->residentBytes = parts.value(1).toLongLong() * 1024;
+    }
+  }
+  return true;
+#elif defined(Q_OS_MACOS)
+  // The times are in Mach absolute time units
+  rusage_info_v4 info;
+  if (proc_pid_rusage(static_cast<int>(pid), RUSAGE_INFO_V4,
+                      reinterpret_cast<rusage_info_t *>(&info)) != 0) {
+    return false;
+  }
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  double secondsPerUnit =
+      static_cast<double>(timebase.numer) / timebase.denom / 1e9;
+  usage->userSeconds = info.ri_user_time * secondsPerUnit;
+  usage->systemSeconds = info.ri_system_time * secondsPerUnit;
+  usage->peakResidentBytes = info.ri_lifetime_max_phys_footprint;
+  usage->residentBytes = info.ri_phys_footprint;
+  return true;
+#elif defined(Q_OS_WIN)
+  // The times are in units of 100 nanoseconds
+  HANDLE handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE,
+                              static_cast<DWORD>(pid));
+  if (handle == nullptr) {
+    return false;
+  }
+  FILETIME creation, exitTime, kernel, user;
+  PROCESS_MEMORY_COUNTERS memory;
+  bool ok = GetProcessTimes(handle, &creation, &exitTime, &kernel, &user) &&
+            GetProcessMemoryInfo(handle, &memory, sizeof(memory));
+  CloseHandle(handle);
+  if (!ok) {
+    return false;
+  }
+  auto toSeconds = [](const FILETIME &time) {
+    return ((static_cast<quint64>(time.dwHighDateTime) << 32) |
+            time.dwLowDateTime) /
+           1e7;
+  };
+  usage->userSeconds = toSeconds(user);
+  usage->systemSeconds = toSeconds(kernel);
+  usage->peakResidentBytes = memory.PeakWorkingSetSize;
+  usage->residentBytes = memory.WorkingSetSize;
+  return true;
+#else
+  Q_UNUSED(usage);
+  return false;
+#endif
+}
+
+bool ProcessUtilities::parseCores(const QString &spec, QVector<int> *cores) {
+  cores->clear();
+  for (const QString &part : spec.split(',')) {
+    QStringList bounds = part.trimmed().split('-');
+    bool isFirstValid = false;
+    bool isLastValid = false;
+    int first = bounds.first().toInt(&isFirstValid);
+    int last = bounds.last().toInt(&isLastValid);
+    if (2 < bounds.size() || !isFirstValid || !isLastValid || first < 0 ||
+        last < first) {
+      return false;
+    }
+    for (int core = first; core <= last; core += 1) {
+      cores->append(core);
+    }
+  }
+  return !cores->isEmpty();
+}
+
+bool ProcessUtilities::setAffinity(qint64 pid, const QVector<int> &cores) {
+  if (pid < 0 || cores.isEmpty()) {
+    return false;
+  }
+#if defined(Q_OS_LINUX)
+  // A pid of zero is the calling thread, not the whole process
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int core : cores) {
+    if (CPU_SETSIZE <= core) {
+      return false;
+    }
+    CPU_SET(core, &set);
+  }
+  return sched_setaffinity(static_cast<pid_t>(pid), sizeof(set), &set) == 0;
+#elif defined(Q_OS_WIN)
+  DWORD_PTR mask = 0;
+  for (int core : cores) {
+    if (64 <= core) {
+      return false;
+    }
+    mask |= static_cast<DWORD_PTR>(1) << core;
+  }
+  if (pid == 0) {
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+  }
+  HANDLE handle = OpenProcess(PROCESS_SET_INFORMATION, FALSE,
+                              static_cast<DWORD>(pid));
+  if (handle == nullptr) {
+    return false;
+  }
+  bool ok = SetProcessAffinityMask(handle, mask);
+  CloseHandle(handle);
+  return ok;
+#else
+  return false;
+#endif
+}
+
+bool ProcessUtilities::raisePriority(qint64 pid) {
+  if (pid < 0) {
+    return false;
+  }
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+  // On Linux, a pid of zero is the calling thread, since each thread has a
+  // nice value of its own, while on macOS it's the whole process
+  return setpriority(PRIO_PROCESS, static_cast<id_t>(pid),
+                     RAISED_NICE_VALUE) == 0;
+#elif defined(Q_OS_WIN)
+  if (pid == 0) {
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+  }
+  HANDLE handle = OpenProcess(PROCESS_SET_INFORMATION, FALSE,
+                              static_cast<DWORD>(pid));
+  if (handle == nullptr) {
+    return false;
+  }
+  bool ok = SetPriorityClass(handle, HIGH_PRIORITY_CLASS);
+  CloseHandle(handle);
+  return ok;
+#else
+  return false;
+#endif
+}
+
 }  // namespace mms
@@ -2,6 +2,7 @@
 
 #include <QProcess>
 #include <QString>
+#include <QVector>
 
 namespace mms {
 
@@ -11,6 +12,41 @@ class ProcessUtilities {
 
   static bool start(const QString &command, const QString &directory,
                     QProcess *process);
+
+  // The resources that a process has used since it started
+  struct Usage {
+    double userSeconds;
+    double systemSeconds;
+    qint64 peakResidentBytes;  // the high-water mark of its resident memory
+    qint64 residentBytes;      // its resident memory now
+  };
+
+  // Measures a running process, e.g., an algo, from /proc on Linux, from
+  // proc_pid_rusage on macOS, and from its handle on Windows. Returns false
+  // if it can't be measured, e.g., once it has exited and been reaped, which
+  // QProcess does as soon as it exits, so a process that exits on its own is
+  // only known as of the last time it was measured.
+  static bool getUsage(qint64 pid, Usage *usage);
+
+  // Parses a comma-separated list of cores and ranges of cores, e.g.,
+  // "0-3,8", as numbered by the OS, say, the cores of one socket. Returns
+  // false if the list is empty or malformed.
+  static bool parseCores(const QString &spec, QVector<int> *cores);
+
+  // Pins a process, or the calling thread if the pid is zero, to the given
+  // cores, e.g., so that it doesn't migrate while its latency is measured.
+  // Returns false if it couldn't be pinned, including on macOS, which only
+  // has affinity hints, and for cores beyond the first 64 on Windows.
+  static bool setAffinity(qint64 pid, const QVector<int> &cores);
+
+  // Raises the priority of a process, or of the calling thread if the pid is
+  // zero, above that of ordinary work. Returns false if it couldn't be
+  // raised, e.g., without the privileges that Unix requires for it.
+  static bool raisePriority(qint64 pid);
+
+ private:
+  // The nice value of a raised priority on Unix
+  static const int RAISED_NICE_VALUE;
 };
 
 }  // namespace mms
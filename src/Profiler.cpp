@@ -0,0 +1,172 @@
+#include "Profiler.h"
+
+#include <algorithm>
+
+#include <QAbstractEventDispatcher>
+#include <QFile>
+#include <QList>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QtGlobal>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const int Profiler::MAX_EVENTS = 1000000;
+
+bool Profiler::ENABLED = false;
+QString Profiler::PATH;
+QElapsedTimer Profiler::CLOCK;
+QMutex Profiler::MUTEX;
+QVector<Profiler::Event> Profiler::EVENTS;
+QHash<const char *, LatencyHistogram> Profiler::HISTOGRAMS;
+QHash<const char *, Profiler::Allocations> Profiler::ALLOCATIONS;
+#if defined(MMS_ITT)
+__itt_domain *Profiler::ITT_DOMAIN = nullptr;
+#endif
+
+void Profiler::init() {
+  ASSERT_RUNS_JUST_ONCE();
+  PATH = qEnvironmentVariable("MMS_PROFILE");
+  ENABLED = !PATH.isEmpty();
+  CLOCK.start();
+#if defined(MMS_ITT)
+  ITT_DOMAIN = __itt_domain_create("mms");
+#endif
+}
+
+bool Profiler::isEnabled() { return ENABLED; }
+
+void Profiler::markEventLoopTurns() {
+  // A turn ends whenever the loop is about to wait for more events
+#if defined(MMS_TRACY) || defined(MMS_ITT)
+  QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+  if (dispatcher == nullptr) {
+    return;
+  }
+#endif
+#if defined(MMS_TRACY)
+  QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock,
+                   []() { FrameMarkNamed("event loop"); });
+#elif defined(MMS_ITT)
+  QObject::connect(dispatcher, &QAbstractEventDispatcher::awake,
+                   []() { __itt_frame_begin_v3(ITT_DOMAIN, nullptr); });
+  QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock,
+                   []() { __itt_frame_end_v3(ITT_DOMAIN, nullptr); });
+#endif
+}
+
+void Profiler::finish() {
+  if (!ENABLED) {
+    return;
+  }
+  ENABLED = false;
+  if (!writeTrace()) {
+    QTextStream(stderr) << QString("Could not write \"%1\".").arg(PATH)
+                        << Qt::endl;
+  }
+  writeSummary();
+}
+
+Profiler::Scope::Scope(const char *name)
+    : m_name(name),
+      m_start(ENABLED ? CLOCK.nsecsElapsed() : -1),
+      m_counter() {}
+
+Profiler::Scope::~Scope() {
+  if (0 <= m_start && ENABLED) {
+    record(m_name, m_start, CLOCK.nsecsElapsed(), m_counter);
+  }
+}
+
+#if defined(MMS_ITT)
+Profiler::IttTask::IttTask(__itt_string_handle *handle) {
+  __itt_task_begin(ITT_DOMAIN, __itt_null, __itt_null, handle);
+}
+
+Profiler::IttTask::~IttTask() { __itt_task_end(ITT_DOMAIN); }
+#endif
+
+void Profiler::record(const char *name, qint64 start, qint64 end,
+                      const AllocationCounter &counter) {
+  // Read before recording, which itself allocates now and then
+  Allocations allocations = {counter.getAllocations(), counter.getBytes()};
+  qint64 duration = end - start;
+  QMutexLocker locker(&MUTEX);
+  if (EVENTS.size() < MAX_EVENTS) {
+    EVENTS.append({name, start, duration});
+  }
+  HISTOGRAMS[name].add(duration);
+  Allocations &totals = ALLOCATIONS[name];
+  totals.count += allocations.count;
+  totals.bytes += allocations.bytes;
+}
+
+bool Profiler::writeTrace() {
+  QFile file(PATH);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    return false;
+  }
+
+  // Complete events ("X"), with timestamps in microseconds; nesting is
+  // inferred from the times, since everything runs on the main thread
+  QTextStream stream(&file);
+  stream << "{\"traceEvents\":[";
+  for (int i = 0; i < EVENTS.size(); i += 1) {
+    const Event &event = EVENTS.at(i);
+    if (0 < i) {
+      stream << ",";
+    }
+    stream << "\n{\"name\":\"" << event.name
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+           << QString::number(event.start / 1000.0, 'f', 3)
+           << ",\"dur\":" << QString::number(event.duration / 1000.0, 'f', 3)
+           << "}";
+  }
+  stream << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  stream.flush();
+  return file.error() == QFile::NoError;
+}
+
+void Profiler::writeSummary() {
+  // Sorted by name, so that summaries can be diffed
+  QList<const char *> names = HISTOGRAMS.keys();
+  std::sort(names.begin(), names.end(), [](const char *a, const char *b) {
+    return qstrcmp(a, b) < 0;
+  });
+  QTextStream err(stderr);
+  QString header = QString("%1 %2 %3 %4 %5 %6")
+                       .arg("section", -30)
+                       .arg("count", 10)
+                       .arg("mean", 10)
+                       .arg("p50", 10)
+                       .arg("p99", 10)
+                       .arg("max", 10);
+  if (AllocationCounter::isEnabled()) {
+    header += QString(" %1 %2").arg("allocs", 10).arg("bytes", 10);
+  }
+  err << header << Qt::endl;
+  for (const char *name : names) {
+    const LatencyHistogram &histogram = HISTOGRAMS[name];
+    QString row = QString("%1 %2 %3 %4 %5 %6")
+                      .arg(name, -30)
+                      .arg(histogram.getCount(), 10)
+                      .arg(histogram.getMean(), 10)
+                      .arg(histogram.getPercentile(0.50), 10)
+                      .arg(histogram.getPercentile(0.99), 10)
+                      .arg(histogram.getMax(), 10);
+    if (AllocationCounter::isEnabled()) {
+      // Means per call, like the durations
+      const Allocations &totals = ALLOCATIONS[name];
+      double count = qMax<qint64>(1, histogram.getCount());
+      row += QString(" %1 %2")
+                 .arg(totals.count / count, 10, 'f', 1)
+                 .arg(totals.bytes / count, 10, 'f', 1);
+    }
+    err << row << Qt::endl;
+  }
+  err << "(all durations in nanoseconds)" << Qt::endl;
+}
+
+}  // namespace mms
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "AllocationCounter.h"
+#include "LatencyHistogram.h"
+
+#if defined(MMS_TRACY)
+#include <tracy/Tracy.hpp>
+#elif defined(MMS_ITT)
+#include <ittnotify.h>
+#endif
+
+// Times the enclosing block (see Profiler::Scope), and marks it as a zone of
+// an external profiler, in builds configured with CONFIG+=tracy or
+// CONFIG+=itt (see mms.pro), so that Tracy or VTune can show every section
+// on a timeline, by thread; in other builds zones compile to nothing. The
+// name must be a string literal, and there can be one per block.
+#if defined(MMS_TRACY)
+#define PROFILE_ZONE(name) ZoneScopedN(name)
+#elif defined(MMS_ITT)
+#define PROFILE_ZONE(name)                                  \
+  static __itt_string_handle *const profileZoneHandle =     \
+      __itt_string_handle_create(name);                     \
+  mms::Profiler::IttTask profileZoneTask(profileZoneHandle)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#define PROFILE_SCOPE(name)                \
+  mms::Profiler::Scope profileScope(name); \
+  PROFILE_ZONE(name)
+
+namespace mms {
+
+// The Profiler times named sections of the simulator's hot paths, e.g., each
+// command and each frame. It's enabled by setting the MMS_PROFILE environment
+// variable to a file path; otherwise each section costs a single branch. When
+// the simulator exits, the sections are written to that file as a Chrome
+// trace (see chrome://tracing) and a summary of each is written to stderr.
+// In builds that count allocations (see AllocationCounter), the summary also
+// has the mean allocations and bytes of each section, including those of any
+// sections nested in it.
+class Profiler {
+ public:
+  // The Profiler class is not constructible
+  Profiler() = delete;
+
+  static void init();
+  static bool isEnabled();
+
+  // Marks each turn of the application's event loop as a frame of the
+  // external profiler, if there is one; called once the application exists
+  static void markEventLoopTurns();
+
+  // Writes the trace and the summary; no-op if disabled
+  static void finish();
+
+  // Times the enclosing block; the name must be a string literal
+  class Scope {
+   public:
+    explicit Scope(const char *name);
+    ~Scope();
+
+   private:
+    const char *m_name;
+    qint64 m_start;  // -1 if disabled
+    AllocationCounter m_counter;
+  };
+
+#if defined(MMS_ITT)
+  // An ITT task, for PROFILE_ZONE
+  class IttTask {
+   public:
+    explicit IttTask(__itt_string_handle *handle);
+    ~IttTask();
+  };
+#endif
+
+ private:
+  struct Event {
+    const char *name;
+    qint64 start;
+    qint64 duration;
+  };
+
+  struct Allocations {
+    qint64 count;
+    qint64 bytes;
+  };
+
+  static const int MAX_EVENTS;
+
+  static bool ENABLED;
+  static QString PATH;
+#if defined(MMS_ITT)
+  static __itt_domain *ITT_DOMAIN;
+#endif
+  static QElapsedTimer CLOCK;
+
+  // Events stop being recorded once there are too many to write, but the
+  // histograms are always updated; sections may be timed on any thread (see
+  // PluginScheduler), so both are updated under the lock
+  static QMutex MUTEX;
+  static QVector<Event> EVENTS;
+  static QHash<const char *, LatencyHistogram> HISTOGRAMS;
+  static QHash<const char *, Allocations> ALLOCATIONS;  // totals
+
+  static void record(const char *name, qint64 start, qint64 end,
+                     const AllocationCounter &counter);
+  static bool writeTrace();
+  static void writeSummary();
+};
+
+}  // namespace mms
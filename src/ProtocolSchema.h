@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+
+#include "../util/mms-protocol.h"
+#include "Command.h"
+
+namespace mms {
+
+// The layout of a command's arguments, in both protocols, and what it's
+// answered with, as documented in util/mms-protocol.h
+enum class Args {
+  NONE,
+  COUNT,
+  POSITION,
+  POSITION_AND_CHAR,
+  POSITION_AND_TEXT,
+  POSITION_AND_INTEGER,
+  STAT,
+  INTEGERS,
+  CELLS_AND_CHARS,
+  CELLS_AND_TEXTS,
+  CHAR_AND_CELLS,
+  GRID_OF_CHARS,
+  GRID_OF_TEXTS,
+  MOVES,
+  NAME_AND_NUMBER,
+};
+
+enum class Reply {
+  NONE,
+  ACK,
+  BOOL,
+  INTEGER,
+  FLOAT,
+  INTEGERS,
+  MOVE,
+};
+
+struct CommandSchema {
+  CommandType type;
+  const char *name;  // in the text protocol
+  Args args;
+  Reply reply;
+};
+
+struct CommandAlias {
+  const char *name;
+  CommandType type;
+};
+
+// Every command, in the order of the schema, and the other names of some
+#define MMS_COMMAND_SCHEMA(name, opcode, text, args, reply) \
+  {CommandType::name, text, Args::args, Reply::reply},
+inline constexpr CommandSchema COMMAND_SCHEMAS[] = {
+    MMS_PROTOCOL_COMMANDS(MMS_COMMAND_SCHEMA)};
+#undef MMS_COMMAND_SCHEMA
+
+#define MMS_COMMAND_ALIAS(text, name) {text, CommandType::name},
+inline constexpr CommandAlias COMMAND_ALIASES[] = {
+    MMS_PROTOCOL_ALIASES(MMS_COMMAND_ALIAS)};
+#undef MMS_COMMAND_ALIAS
+
+// The index in COMMAND_SCHEMAS of every opcode, or -1 if it isn't a command,
+// built at compile time, so that a binary command is looked up with a single
+// load, and so that a schema that reuses an opcode doesn't compile
+inline constexpr std::array<int, 256> COMMAND_INDICES = []() {
+  std::array<int, 256> indices = {};
+  for (int i = 0; i < 256; i += 1) {
+    indices[i] = -1;
+  }
+  int size = sizeof(COMMAND_SCHEMAS) / sizeof(COMMAND_SCHEMAS[0]);
+  for (int i = 0; i < size; i += 1) {
+    int opcode = static_cast<int>(COMMAND_SCHEMAS[i].type);
+    indices[opcode] = indices[opcode] == -1 ? i : -2;
+  }
+  return indices;
+}();
+
+inline constexpr bool hasUniqueOpcodes() {
+  for (int index : COMMAND_INDICES) {
+    if (index == -2) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(hasUniqueOpcodes(), "two commands share an opcode");
+
+// Returns null if the byte isn't the opcode of a command
+constexpr const CommandSchema *getCommandSchema(unsigned char opcode) {
+  int index = COMMAND_INDICES[opcode];
+  return index < 0 ? nullptr : &COMMAND_SCHEMAS[index];
+}
+
+constexpr const CommandSchema &getCommandSchema(CommandType type) {
+  return COMMAND_SCHEMAS[COMMAND_INDICES[static_cast<unsigned char>(type)]];
+}
+
+}  // namespace mms
@@ -0,0 +1,109 @@
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const double QuantileSketch::COMPRESSION = 100.0;
+const int QuantileSketch::BUFFER_SIZE = 500;
+
+QuantileSketch::QuantileSketch() : m_count(0), m_min(0.0), m_max(0.0) {}
+
+void QuantileSketch::add(double value) {
+  if (m_count == 0) {
+    m_min = value;
+    m_max = value;
+  } else {
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+  m_count += 1;
+  m_buffer.append(value);
+  if (BUFFER_SIZE <= m_buffer.size()) {
+    merge();
+  }
+}
+
+int QuantileSketch::getCount() const { return m_count; }
+
+double QuantileSketch::getQuantile(double fraction) const {
+  ASSERT_LE(0.0, fraction);
+  ASSERT_LE(fraction, 1.0);
+  if (m_count == 0) {
+    return 0.0;
+  }
+  merge();
+
+  // Each centroid is centered on its share of the cumulative weight; the
+  // extremes are exact, and everything else is interpolated between centers
+  double target = fraction * m_count;
+  double previousCenter = 0.0;
+  double previousMean = m_min;
+  double cumulative = 0.0;
+  for (const Centroid &centroid : m_centroids) {
+    double center = cumulative + centroid.weight / 2.0;
+    if (target < center) {
+      double t = (target - previousCenter) / (center - previousCenter);
+      return previousMean + t * (centroid.mean - previousMean);
+    }
+    cumulative += centroid.weight;
+    previousCenter = center;
+    previousMean = centroid.mean;
+  }
+  double t = (target - previousCenter) / (cumulative - previousCenter);
+  return previousMean + t * (m_max - previousMean);
+}
+
+void QuantileSketch::merge() const {
+  if (m_buffer.isEmpty()) {
+    return;
+  }
+  QVector<Centroid> all = m_centroids;
+  for (double value : m_buffer) {
+    all.append({value, 1.0});
+  }
+  m_buffer.clear();
+  std::sort(all.begin(), all.end(), [](const Centroid &a, const Centroid &b) {
+    return a.mean < b.mean;
+  });
+
+  // Greedily combine neighbors while the combined weight stays within the
+  // limit for the quantile that the centroid starts at
+  m_centroids.clear();
+  double total = m_count;
+  double weightSoFar = 0.0;
+  double limit = fromScale(toScale(0.0) + 1.0) * total;
+  Centroid current = all.at(0);
+  for (int i = 1; i < all.size(); i += 1) {
+    const Centroid &next = all.at(i);
+    if (weightSoFar + current.weight + next.weight <= limit) {
+      double weight = current.weight + next.weight;
+      current.mean += (next.mean - current.mean) * next.weight / weight;
+      current.weight = weight;
+    } else {
+      weightSoFar += current.weight;
+      m_centroids.append(current);
+      limit = fromScale(toScale(weightSoFar / total) + 1.0) * total;
+      current = next;
+    }
+  }
+  m_centroids.append(current);
+}
+
+double QuantileSketch::toScale(double fraction) {
+  return COMPRESSION / (2.0 * M_PI) * std::asin(2.0 * fraction - 1.0);
+}
+
+double QuantileSketch::fromScale(double scale) {
+  // Past the end of the scale, the limit is simply everything
+  double angle = scale * 2.0 * M_PI / COMPRESSION;
+  if (M_PI / 2.0 <= angle) {
+    return 1.0;
+  }
+  return (std::sin(angle) + 1.0) / 2.0;
+}
+
+}  // namespace mms
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QVector>
+
+namespace mms {
+
+// A merging t-digest, which estimates quantiles of a stream of values in
+// constant memory. Values are buffered and periodically merged into a sorted
+// list of weighted centroids, which are kept small near the extremes, so that
+// tail quantiles (e.g., the 99th percentile) stay accurate.
+class QuantileSketch {
+ public:
+  QuantileSketch();
+
+  void add(double value);
+  int getCount() const;
+
+  // The fraction must be in [0, 1]; returns 0 if no values were added
+  double getQuantile(double fraction) const;
+
+ private:
+  static const double COMPRESSION;
+  static const int BUFFER_SIZE;
+
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  int m_count;
+  double m_min;
+  double m_max;
+
+  // Merged lazily, so that quantiles can be queried at any time
+  mutable QVector<Centroid> m_centroids;
+  mutable QVector<double> m_buffer;
+  void merge() const;
+
+  // The scale function, which bounds the weight of each centroid by its
+  // quantile, and its inverse
+  static double toScale(double fraction);
+  static double fromScale(double scale);
+};
+
+}  // namespace mms
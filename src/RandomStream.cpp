@@ -0,0 +1,53 @@
+#include "RandomStream.h"
+
+#include <QCryptographicHash>
+#include <QtEndian>
+
+namespace mms {
+
+RandomStream::RandomStream(quint64 key, quint32 substream)
+    : m_key(key), m_substream(substream), m_position(0) {}
+
+double RandomStream::generateDouble() {
+  double sample = getDouble(m_key, m_substream, m_position);
+  m_position += 1;
+  return sample;
+}
+
+quint64 RandomStream::getPosition() const { return m_position; }
+
+double RandomStream::getDouble(quint64 key, quint32 substream,
+                               quint64 position) {
+  // Half of each block is used, which is plenty for a double
+  quint32 counter[4] = {static_cast<quint32>(position),
+                        static_cast<quint32>(position >> 32), substream, 0};
+  philox(counter, static_cast<quint32>(key), static_cast<quint32>(key >> 32));
+  quint64 bits = (static_cast<quint64>(counter[0]) << 32) | counter[1];
+  return static_cast<double>(bits >> 11) / static_cast<double>(1ULL << 53);
+}
+
+quint64 RandomStream::getKey(const QByteArray &identity) {
+  QByteArray hash =
+      QCryptographicHash::hash(identity, QCryptographicHash::Sha1);
+  return qFromLittleEndian<quint64>(hash.constData());
+}
+
+void RandomStream::philox(quint32 counter[4], quint32 key0, quint32 key1) {
+  for (int i = 0; i < 10; i += 1) {
+    quint64 product0 = static_cast<quint64>(0xD2511F53) * counter[0];
+    quint64 product1 = static_cast<quint64>(0xCD9E8D57) * counter[2];
+    quint32 next[4] = {
+        static_cast<quint32>(product1 >> 32) ^ counter[1] ^ key0,
+        static_cast<quint32>(product1),
+        static_cast<quint32>(product0 >> 32) ^ counter[3] ^ key1,
+        static_cast<quint32>(product0),
+    };
+    for (int j = 0; j < 4; j += 1) {
+      counter[j] = next[j];
+    }
+    key0 += 0x9E3779B9;
+    key1 += 0xBB67AE85;
+  }
+}
+
+}  // namespace mms
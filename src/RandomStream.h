@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QByteArray>
+
+namespace mms {
+
+// A counter-based random number generator (Philox4x32-10, of Salmon et al.),
+// whose every draw is a pure function of its key, its substream, and its
+// position in the substream. Nothing is shared between streams, so each run
+// of a batch can be given its own key, derived from whatever identifies the
+// run (see getKey), and read the same numbers however many runs are in
+// flight, on however many threads, and in whatever order they're scheduled.
+class RandomStream {
+ public:
+  // Each part of a simulation that draws numbers has a substream of its own,
+  // so that adding draws to one doesn't shift any of the others
+  explicit RandomStream(quint64 key = 0, quint32 substream = 0);
+
+  // A uniform sample in [0, 1), the one at the current position, which then
+  // advances
+  double generateDouble();
+
+  // The number of samples drawn so far
+  quint64 getPosition() const;
+
+  // The sample at the position of the substream, without a stream
+  static double getDouble(quint64 key, quint32 substream, quint64 position);
+
+  // A key from the bytes that identify a run, e.g., of its seed, algo,
+  // maze, and repeat
+  static quint64 getKey(const QByteArray &identity);
+
+ private:
+  quint64 m_key;
+  quint32 m_substream;
+  quint64 m_position;
+
+  // Ten rounds of Philox on the counter, in place
+  static void philox(quint32 counter[4], quint32 key0, quint32 key1);
+};
+
+}  // namespace mms
@@ -0,0 +1,313 @@
+#include "ReferenceAlgo.h"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "AssertMacros.h"
+#include "Maze.h"
+
+namespace mms {
+
+QStringList ReferenceAlgo::getNames() {
+  return {"wall-follow", "flood-fill", "dijkstra"};
+}
+
+mms_plugin_run_function ReferenceAlgo::get(const QString &name) {
+  if (name == "wall-follow") {
+    return &ReferenceAlgo::runWallFollow;
+  }
+  if (name == "flood-fill") {
+    return &ReferenceAlgo::runFloodFill;
+  }
+  if (name == "dijkstra") {
+    return &ReferenceAlgo::runDijkstra;
+  }
+  return nullptr;
+}
+
+ReferenceAlgo::ReferenceAlgo(const mms_api *api, Strategy strategy)
+    : m_api(api),
+      m_strategy(strategy),
+      m_width(api->maze_width(api->context)),
+      m_height(api->maze_height(api->context)),
+      m_walls(m_width * m_height, 0),
+      m_isVisited(m_width * m_height, false),
+      m_x(0),
+      m_y(0),
+      m_direction(Direction::NORTH),
+      // Every tile could be entered from each side, which is plenty for any
+      // algo that's making progress
+      m_movesLeft(4 * m_width * m_height) {
+  for (int x = 0; x < m_width; x += 1) {
+    setWall(getIndex(x, 0), Direction::SOUTH);
+    setWall(getIndex(x, m_height - 1), Direction::NORTH);
+  }
+  for (int y = 0; y < m_height; y += 1) {
+    setWall(getIndex(0, y), Direction::WEST);
+    setWall(getIndex(m_width - 1, y), Direction::EAST);
+  }
+}
+
+void ReferenceAlgo::runWallFollow(const mms_api *api) {
+  ReferenceAlgo(api, Strategy::WALL_FOLLOW).run();
+}
+
+void ReferenceAlgo::runFloodFill(const mms_api *api) {
+  ReferenceAlgo(api, Strategy::FLOOD_FILL).run();
+}
+
+void ReferenceAlgo::runDijkstra(const mms_api *api) {
+  ReferenceAlgo(api, Strategy::DIJKSTRA).run();
+}
+
+void ReferenceAlgo::run() {
+  if (m_strategy == Strategy::WALL_FOLLOW) {
+    followWall();
+    return;
+  }
+  QVector<int> center;
+  for (QPair<int, int> position :
+       Maze::getCenterPositions(m_width, m_height)) {
+    center.append(getIndex(position.first, position.second));
+  }
+  if (travel(center) && travel({getIndex(0, 0)})) {
+    travel(center);
+  }
+}
+
+void ReferenceAlgo::followWall() {
+  QVector<QPair<int, int>> center =
+      Maze::getCenterPositions(m_width, m_height);
+  while (!center.contains({m_x, m_y}) && 0 < m_movesLeft &&
+         !m_api->stopped(m_api->context)) {
+    // Keep a hand on the left wall: turn left if it's open, and otherwise
+    // turn right until the way ahead is
+    senseWalls();
+    int index = getIndex(m_x, m_y);
+    Direction direction = rotate(m_direction, 3);
+    while (isWall(index, direction)) {
+      direction = rotate(direction, 1);
+    }
+    turnTo(direction);
+    if (!moveForward(1)) {
+      return;
+    }
+  }
+}
+
+bool ReferenceAlgo::travel(const QVector<int> &goals) {
+  while (!goals.contains(getIndex(m_x, m_y))) {
+    if (m_movesLeft <= 0 || m_api->stopped(m_api->context)) {
+      return false;
+    }
+    senseWalls();
+    bool moved = m_strategy == Strategy::FLOOD_FILL ? stepFloodFill(goals)
+                                                     : stepDijkstra(goals);
+    if (!moved) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReferenceAlgo::stepFloodFill(const QVector<int> &goals) {
+  // Breadth first from the goals, assuming that walls that haven't been
+  // found aren't there
+  QVector<int> distances(m_width * m_height, -1);
+  QVector<int> discovered;
+  discovered.reserve(m_width * m_height);
+  for (int goal : goals) {
+    distances[goal] = 0;
+    discovered.append(goal);
+  }
+  for (int i = 0; i < discovered.size(); i += 1) {
+    int index = discovered.at(i);
+    for (Direction direction : CARDINAL_DIRECTIONS()) {
+      if (isWall(index, direction)) {
+        continue;
+      }
+      int neighbor = getNeighbor(index, direction);
+      if (distances.at(neighbor) == -1) {
+        distances[neighbor] = distances.at(index) + 1;
+        discovered.append(neighbor);
+      }
+    }
+  }
+
+  // Downhill, preferring to go straight
+  int index = getIndex(m_x, m_y);
+  if (distances.at(index) == -1) {
+    return false;
+  }
+  for (int turns : {0, 1, 3, 2}) {
+    Direction direction = rotate(m_direction, turns);
+    if (!isWall(index, direction) &&
+        distances.at(getNeighbor(index, direction)) ==
+            distances.at(index) - 1) {
+      turnTo(direction);
+      return moveForward(1);
+    }
+  }
+  ASSERT_NEVER_RUNS();
+  return false;
+}
+
+bool ReferenceAlgo::stepDijkstra(const QVector<int> &goals) {
+  // The states are a tile and a heading, indexed by 4 * tile + heading. A
+  // move to the next tile costs less than a turn, so that straightaways are
+  // preferred, just as they're faster to drive.
+  const int moveCost = 2;
+  const int turnCost = 3;
+  int numStates = 4 * m_width * m_height;
+  QVector<int> costs(numStates, -1);
+  QVector<int> parents(numStates, -1);
+  typedef QPair<int, int> Entry;  // cost, state
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+  int start = 4 * getIndex(m_x, m_y) + static_cast<int>(m_direction);
+  costs[start] = 0;
+  heap.push({0, start});
+  int goal = -1;
+  while (!heap.empty()) {
+    Entry entry = heap.top();
+    heap.pop();
+    int state = entry.second;
+    if (entry.first != costs.at(state)) {
+      continue;  // a stale entry, since the state was reached more cheaply
+    }
+    if (goals.contains(state / 4)) {
+      goal = state;
+      break;
+    }
+    Direction heading = static_cast<Direction>(state % 4);
+    QVector<QPair<int, int>> steps;  // next state, cost
+    if (!isWall(state / 4, heading)) {
+      steps.append({4 * getNeighbor(state / 4, heading) + state % 4,
+                    moveCost});
+    }
+    steps.append({4 * (state / 4) + static_cast<int>(rotate(heading, 1)),
+                  turnCost});
+    steps.append({4 * (state / 4) + static_cast<int>(rotate(heading, 3)),
+                  turnCost});
+    for (const QPair<int, int> &step : steps) {
+      int cost = entry.first + step.second;
+      if (costs.at(step.first) == -1 || cost < costs.at(step.first)) {
+        costs[step.first] = cost;
+        parents[step.first] = state;
+        heap.push({cost, step.first});
+      }
+    }
+  }
+  if (goal == -1) {
+    return false;
+  }
+
+  // Follow the path from the start: make its turns, then drive its first
+  // straightaway for as long as the walls of each tile along it are known,
+  // plus one tile into the unknown
+  QVector<int> path;
+  for (int state = goal; state != -1; state = parents.at(state)) {
+    path.prepend(state);
+  }
+  int i = 1;
+  while (i < path.size() && path.at(i) / 4 == path.at(i - 1) / 4) {
+    i += 1;
+  }
+  ASSERT_LT(i, path.size());
+  turnTo(static_cast<Direction>(path.at(i) % 4));
+  int distance = 1;
+  while (i + distance < path.size() &&
+         path.at(i + distance) % 4 == path.at(i) % 4 &&
+         m_isVisited.at(path.at(i + distance - 1) / 4)) {
+    distance += 1;
+  }
+  return moveForward(distance);
+}
+
+void ReferenceAlgo::senseWalls() {
+  int index = getIndex(m_x, m_y);
+  if (m_isVisited.at(index)) {
+    return;
+  }
+  // The bits are front, right, back, and left, which are a quarter turn
+  // apart, just like the directions
+  int mask = m_api->walls(m_api->context, 1);
+  for (int turns = 0; turns < 4; turns += 1) {
+    if (mask & (1 << turns)) {
+      setWall(index, rotate(m_direction, turns));
+    }
+  }
+  m_isVisited[index] = true;
+}
+
+void ReferenceAlgo::setWall(int index, Direction direction) {
+  m_walls[index] |= Maze::getWallBit(direction);
+  int neighbor = getNeighbor(index, direction);
+  if (neighbor != -1) {
+    m_walls[neighbor] |= Maze::getWallBit(rotate(direction, 2));
+  }
+}
+
+bool ReferenceAlgo::isWall(int index, Direction direction) const {
+  return (m_walls.at(index) & Maze::getWallBit(direction)) != 0;
+}
+
+void ReferenceAlgo::turnTo(Direction direction) {
+  int turns = (static_cast<int>(direction) - static_cast<int>(m_direction) +
+               4) %
+              4;
+  if (turns == 3) {
+    m_api->turn_left(m_api->context);
+  } else {
+    for (int i = 0; i < turns; i += 1) {
+      m_api->turn_right(m_api->context);
+    }
+  }
+  m_direction = direction;
+}
+
+bool ReferenceAlgo::moveForward(int distance) {
+  if (!m_api->move_forward(m_api->context, distance)) {
+    return false;
+  }
+  for (int i = 0; i < distance; i += 1) {
+    int index = getNeighbor(getIndex(m_x, m_y), m_direction);
+    ASSERT_LE(0, index);
+    m_x = index / m_height;
+    m_y = index % m_height;
+  }
+  m_movesLeft -= 1;
+  return true;
+}
+
+int ReferenceAlgo::getIndex(int x, int y) const { return m_height * x + y; }
+
+int ReferenceAlgo::getNeighbor(int index, Direction direction) const {
+  int x = index / m_height;
+  int y = index % m_height;
+  switch (direction) {
+    case Direction::NORTH:
+      y += 1;
+      break;
+    case Direction::EAST:
+      x += 1;
+      break;
+    case Direction::SOUTH:
+      y -= 1;
+      break;
+    case Direction::WEST:
+      x -= 1;
+      break;
+  }
+  if (x < 0 || m_width <= x || y < 0 || m_height <= y) {
+    return -1;
+  }
+  return getIndex(x, y);
+}
+
+Direction ReferenceAlgo::rotate(Direction direction, int quarterTurns) {
+  return CARDINAL_DIRECTIONS().at(
+      (CARDINAL_DIRECTIONS().indexOf(direction) + quarterTurns) % 4);
+}
+
+}  // namespace mms
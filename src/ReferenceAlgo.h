@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "../util/mms-plugin.h"
+#include "Direction.h"
+
+namespace mms {
+
+// Mouse algos that are built into the simulator and run in-process, through
+// the same table of functions as plugins (see PluginAlgo), so they show how
+// fast the simulator itself can go, with no process or protocol at all, and
+// give the runs of other algos something to be compared to:
+//
+//   wall-follow  follows the left wall until it happens upon the center
+//   flood-fill   moves one tile at a time, downhill on the distances to its
+//                goal, which are recomputed from the walls found so far
+//   dijkstra     as in the old mackAlgoTwo: a heap-based search for the
+//                path with the fewest turns and moves, driven as straightaways
+//                through tiles whose walls are already known
+//
+// Apart from wall-follow, each goes from the start to the center, back to the
+// start, and then to the center again on what it learned, so the best run is
+// a speed run.
+class ReferenceAlgo {
+ public:
+  static QStringList getNames();
+
+  // Returns nullptr if there's no reference algo with that name
+  static mms_plugin_run_function get(const QString &name);
+
+ private:
+  enum class Strategy {
+    WALL_FOLLOW,
+    FLOOD_FILL,
+    DIJKSTRA,
+  };
+
+  ReferenceAlgo(const mms_api *api, Strategy strategy);
+
+  static void runWallFollow(const mms_api *api);
+  static void runFloodFill(const mms_api *api);
+  static void runDijkstra(const mms_api *api);
+
+  const mms_api *m_api;
+  Strategy m_strategy;
+  int m_width;
+  int m_height;
+
+  // The walls found so far of each tile, by index (see getIndex), as bits
+  // of Maze::getWallBit, and whether each tile has been visited, i.e.,
+  // whether all of its walls are known
+  QVector<unsigned char> m_walls;
+  QVector<bool> m_isVisited;
+
+  // Where the mouse is, and the number of moves left before giving up, in
+  // case the algo can't find its goal
+  int m_x;
+  int m_y;
+  Direction m_direction;
+  int m_movesLeft;
+
+  void run();
+  void followWall();
+
+  // Goes to any of the tiles, returning false if it couldn't, e.g., if the
+  // run timed out or the tiles can't be reached
+  bool travel(const QVector<int> &goals);
+  bool stepFloodFill(const QVector<int> &goals);
+  bool stepDijkstra(const QVector<int> &goals);
+
+  void senseWalls();
+  void setWall(int index, Direction direction);
+  bool isWall(int index, Direction direction) const;
+  void turnTo(Direction direction);
+  bool moveForward(int distance);
+
+  int getIndex(int x, int y) const;
+  int getNeighbor(int index, Direction direction) const;
+  static Direction rotate(Direction direction, int quarterTurns);
+};
+
+}  // namespace mms
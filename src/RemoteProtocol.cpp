@@ -0,0 +1,222 @@
+#include "RemoteProtocol.h"
+
+#include <QtEndian>
+
+namespace mms {
+
+const int RemoteProtocol::HEADER_SIZE = 5;
+
+// Replays are by far the largest messages, and even long runs are a few MiB
+const int RemoteProtocol::MAX_MESSAGE_SIZE = 256 * 1024 * 1024;
+
+QByteArray RemoteProtocol::encodeHello(int maxJobs) {
+  QByteArray fields;
+  appendUInt32(&fields, maxJobs);
+  return frame(MessageType::HELLO, fields);
+}
+
+QByteArray RemoteProtocol::encode(const Job &job) {
+  QByteArray fields;
+  appendUInt32(&fields, job.index);
+  appendBytes(&fields, job.directory.toUtf8());
+  appendBytes(&fields, job.runCommand.toUtf8());
+  appendFloat(&fields, job.timeoutSeconds);
+  appendFloat(&fields, job.hangTimeoutSeconds);
+  fields.append(job.isRecorded ? 1 : 0);
+  fields.append(job.isCpuTimed ? 1 : 0);
+  fields.append(job.isLatencyTracked ? 1 : 0);
+  fields.append(job.isUsageTracked ? 1 : 0);
+  fields.append(job.isHeatmapped ? 1 : 0);
+  fields.append(job.isTraced ? 1 : 0);
+  appendBytes(&fields, job.resetInjection.toUtf8());
+  appendUInt32(&fields, static_cast<quint32>(job.randomKey));
+  appendUInt32(&fields, static_cast<quint32>(job.randomKey >> 32));
+  appendBytes(&fields, job.maze);
+  return frame(MessageType::JOB, fields);
+}
+
+QByteArray RemoteProtocol::encode(const Result &result) {
+  QByteArray fields;
+  appendUInt32(&fields, result.index);
+  appendBytes(&fields, result.status.toUtf8());
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    appendFloat(&fields, result.stats.values[i]);
+  }
+  fields.append(result.stats.startedRun ? 1 : 0);
+  fields.append(result.stats.solved ? 1 : 0);
+  fields.append(result.stats.bestRunRecorded ? 1 : 0);
+  appendFloat(&fields, result.stats.penalty);
+  appendFloat(&fields, result.stats.straightMeters);
+  appendFloat(&fields, result.stats.straightEntrySpeed);
+  appendFloat(&fields, result.stats.straightSeconds);
+  appendBytes(&fields, result.replay);
+  appendBytes(&fields, result.latency.toUtf8());
+  appendBytes(&fields, result.usage.toUtf8());
+  appendBytes(&fields, result.resets.toUtf8());
+  appendBytes(&fields, result.heatmap);
+  appendBytes(&fields, result.trace);
+  appendBytes(&fields, result.algoMetrics.toUtf8());
+  return frame(MessageType::RESULT, fields);
+}
+
+QByteArray RemoteProtocol::encodeDone() {
+  return frame(MessageType::DONE, QByteArray());
+}
+
+RemoteProtocol::Status RemoteProtocol::take(QByteArray *buffer,
+                                            Message *message) {
+  if (buffer->size() < HEADER_SIZE) {
+    return Status::NONE;
+  }
+  quint32 size = qFromLittleEndian<quint32>(buffer->constData());
+  if (MAX_MESSAGE_SIZE < size) {
+    return Status::INVALID;
+  }
+  if (static_cast<quint32>(buffer->size() - HEADER_SIZE) < size) {
+    return Status::NONE;
+  }
+  message->type = static_cast<MessageType>(buffer->at(4));
+  QByteArray fields = buffer->mid(HEADER_SIZE, size);
+  buffer->remove(0, HEADER_SIZE + size);
+
+  int position = 0;
+  quint32 value = 0;
+  QByteArray bytes;
+  bool ok = true;
+  switch (message->type) {
+    case MessageType::HELLO:
+      ok = readUInt32(fields, &position, &value);
+      message->maxJobs = value;
+      break;
+    case MessageType::JOB: {
+      Job *job = &message->job;
+      float timeout = 0.0;
+      float hangTimeout = 0.0;
+      ok = readUInt32(fields, &position, &value);
+      job->index = value;
+      ok = ok && readBytes(fields, &position, &bytes);
+      job->directory = QString::fromUtf8(bytes);
+      ok = ok && readBytes(fields, &position, &bytes);
+      job->runCommand = QString::fromUtf8(bytes);
+      ok = ok && readFloat(fields, &position, &timeout) &&
+           readFloat(fields, &position, &hangTimeout) &&
+           position + 6 <= fields.size();
+      job->timeoutSeconds = timeout;
+      job->hangTimeoutSeconds = hangTimeout;
+      job->isRecorded = ok && fields.at(position) != 0;
+      job->isCpuTimed = ok && fields.at(position + 1) != 0;
+      job->isLatencyTracked = ok && fields.at(position + 2) != 0;
+      job->isUsageTracked = ok && fields.at(position + 3) != 0;
+      job->isHeatmapped = ok && fields.at(position + 4) != 0;
+      job->isTraced = ok && fields.at(position + 5) != 0;
+      position += 6;
+      ok = ok && readBytes(fields, &position, &bytes);
+      job->resetInjection = QString::fromUtf8(bytes);
+      ok = ok && readUInt32(fields, &position, &value);
+      job->randomKey = value;
+      ok = ok && readUInt32(fields, &position, &value);
+      job->randomKey |= static_cast<quint64>(value) << 32;
+      ok = ok && readBytes(fields, &position, &job->maze);
+      break;
+    }
+    case MessageType::RESULT: {
+      Result *result = &message->result;
+      ok = readUInt32(fields, &position, &value);
+      result->index = value;
+      ok = ok && readBytes(fields, &position, &bytes);
+      result->status = QString::fromUtf8(bytes);
+      for (int i = 0; i < NUM_STATS; i += 1) {
+        ok = ok && readFloat(fields, &position, &result->stats.values[i]);
+      }
+      ok = ok && position + 3 <= fields.size();
+      if (ok) {
+        result->stats.startedRun = fields.at(position) != 0;
+        result->stats.solved = fields.at(position + 1) != 0;
+        result->stats.bestRunRecorded = fields.at(position + 2) != 0;
+        position += 3;
+      }
+      ok = ok && readFloat(fields, &position, &result->stats.penalty);
+      ok = ok && readFloat(fields, &position, &result->stats.straightMeters);
+      ok = ok &&
+           readFloat(fields, &position, &result->stats.straightEntrySpeed);
+      ok = ok && readFloat(fields, &position, &result->stats.straightSeconds);
+      ok = ok && readBytes(fields, &position, &result->replay);
+      ok = ok && readBytes(fields, &position, &bytes);
+      result->latency = QString::fromUtf8(bytes);
+      ok = ok && readBytes(fields, &position, &bytes);
+      result->usage = QString::fromUtf8(bytes);
+      ok = ok && readBytes(fields, &position, &bytes);
+      result->resets = QString::fromUtf8(bytes);
+      ok = ok && readBytes(fields, &position, &result->heatmap);
+      ok = ok && readBytes(fields, &position, &result->trace);
+      ok = ok && readBytes(fields, &position, &bytes);
+      result->algoMetrics = QString::fromUtf8(bytes);
+      break;
+    }
+    case MessageType::DONE:
+      break;
+    default:
+      ok = false;
+  }
+  return ok && position == fields.size() ? Status::MESSAGE : Status::INVALID;
+}
+
+QByteArray RemoteProtocol::frame(MessageType type, const QByteArray &fields) {
+  QByteArray bytes;
+  appendUInt32(&bytes, fields.size());
+  bytes.append(static_cast<char>(type));
+  bytes.append(fields);
+  return bytes;
+}
+
+void RemoteProtocol::appendUInt32(QByteArray *bytes, quint32 value) {
+  int start = bytes->size();
+  bytes->resize(start + 4);
+  qToLittleEndian<quint32>(value, bytes->data() + start);
+}
+
+void RemoteProtocol::appendFloat(QByteArray *bytes, float value) {
+  int start = bytes->size();
+  bytes->resize(start + 4);
+  qToLittleEndian<float>(value, bytes->data() + start);
+}
+
+void RemoteProtocol::appendBytes(QByteArray *bytes, const QByteArray &value) {
+  appendUInt32(bytes, value.size());
+  bytes->append(value);
+}
+
+bool RemoteProtocol::readUInt32(const QByteArray &bytes, int *position,
+                                quint32 *value) {
+  if (bytes.size() < *position + 4) {
+    return false;
+  }
+  *value = qFromLittleEndian<quint32>(bytes.constData() + *position);
+  *position += 4;
+  return true;
+}
+
+bool RemoteProtocol::readFloat(const QByteArray &bytes, int *position,
+                               float *value) {
+  if (bytes.size() < *position + 4) {
+    return false;
+  }
+  *value = qFromLittleEndian<float>(bytes.constData() + *position);
+  *position += 4;
+  return true;
+}
+
+bool RemoteProtocol::readBytes(const QByteArray &bytes, int *position,
+                               QByteArray *value) {
+  int start = *position;
+  quint32 size = 0;
+  if (!readUInt32(bytes, &start, &size) ||
+      static_cast<quint32>(bytes.size() - start) < size) {
+    return false;
+  }
+  *value = bytes.mid(start, size);
+  *position = start + size;
+  return true;
+}
+
+}  // namespace mms
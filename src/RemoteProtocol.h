@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "Stats.h"
+
+namespace mms {
+
+// The messages between a coordinator, which hands out the runs of a batch,
+// and its workers, which run them (see BatchRunner::serve and work). Each
+// message is a four-byte little-endian size, a one-byte type, and then its
+// fields; mazes are in the binary maze format (see Maze::toBinary), and
+// replays in the replay log format (see ReplayLog), so a run can be
+// reproduced on any machine from what was sent.
+class RemoteProtocol {
+ public:
+  RemoteProtocol() = delete;
+
+  enum class MessageType : unsigned char {
+    HELLO = 0x01,   // worker to coordinator, once connected
+    JOB = 0x02,     // coordinator to worker
+    RESULT = 0x03,  // worker to coordinator, once a job is done
+    DONE = 0x04,    // coordinator to worker, once the batch is finished
+  };
+
+  // The algo is given by its directory and run command, which must be the
+  // same on every worker, e.g., on a shared file system
+  struct Job {
+    int index;  // of the run, in the coordinator's batch
+    QString directory;
+    QString runCommand;
+    double timeoutSeconds;
+    bool isCpuTimed;  // see BatchRunner::setCpuTimeout
+    double hangTimeoutSeconds;
+    bool isRecorded;
+    bool isLatencyTracked;
+    bool isUsageTracked;
+    bool isHeatmapped;
+    bool isTraced;
+    QString resetInjection;  // the schedule (see ResetInjection), or empty
+    quint64 randomKey;       // see Simulation::setRandomKey
+    QByteArray maze;
+  };
+
+  struct Result {
+    int index;
+    QString status;  // as in a row, see BatchRunner
+    Stats::State stats;
+    QByteArray replay;  // empty unless the job was recorded
+    QString latency;    // CSV fields, empty unless latency was tracked
+    QString usage;      // CSV fields, empty unless usage was measured
+    QString resets;     // CSV fields, empty unless resets were injected
+    QByteArray heatmap;  // CSV (see VisitCounts), empty unless requested
+    QByteArray trace;    // CSV (see RunTrace), empty unless requested
+    QString algoMetrics;  // see AlgoMetrics::getSummary
+  };
+
+  struct Message {
+    MessageType type;
+    int maxJobs;  // for hellos
+    Job job;
+    Result result;
+  };
+
+  enum class Status {
+    NONE,     // the buffer doesn't hold a complete message yet
+    MESSAGE,  // a message was taken from the front of the buffer
+    INVALID,  // the buffer can't be a message, so the peer is broken
+  };
+
+  static QByteArray encodeHello(int maxJobs);
+  static QByteArray encode(const Job &job);
+  static QByteArray encode(const Result &result);
+  static QByteArray encodeDone();
+
+  static Status take(QByteArray *buffer, Message *message);
+
+ private:
+  static const int HEADER_SIZE;
+  static const int MAX_MESSAGE_SIZE;
+
+  static QByteArray frame(MessageType type, const QByteArray &fields);
+
+  // Readers return false, and leave the position alone, if the field would
+  // run past the end of the bytes
+  static void appendUInt32(QByteArray *bytes, quint32 value);
+  static void appendFloat(QByteArray *bytes, float value);
+  static void appendBytes(QByteArray *bytes, const QByteArray &value);
+  static bool readUInt32(const QByteArray &bytes, int *position,
+                         quint32 *value);
+  static bool readFloat(const QByteArray &bytes, int *position,
+                        float *value);
+  static bool readBytes(const QByteArray &bytes, int *position,
+                        QByteArray *value);
+};
+
+}  // namespace mms
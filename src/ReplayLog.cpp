@@ -0,0 +1,220 @@
+#include "ReplayLog.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+// Layout (all integers are little-endian):
+//   [0, 4)          magic ("MMSR")
+//   [4, 6)          version
+//   [6, 8)          reserved, zero
+//   [8, 12)         size of the maze, M
+//   [12, 12 + M)    the maze, in the binary maze format
+//   [12 + M, I)     the chunks, each of which is a run of whole records,
+//                   compressed with qCompress
+//   [I, T)          the index, sixteen bytes per chunk: four of its offset,
+//                   four of its compressed size, and eight of the time of
+//                   the record before it (microseconds)
+//   [T, T + 8)      the trailer, four bytes of the number of chunks, and four
+//                   of the offset of the index, I
+// Each record is one byte of type, four bytes of time since the previous
+// record (microseconds), two bytes of size, and then that many bytes. In
+// version 1, the records follow the maze uncompressed.
+const quint32 ReplayLog::MAGIC = 0x52534d4d;  // "MMSR"
+const quint16 ReplayLog::VERSION = 2;
+const quint16 ReplayLog::UNCOMPRESSED_VERSION = 1;
+const int ReplayLog::HEADER_SIZE = 12;
+const int ReplayLog::RECORD_HEADER_SIZE = 7;
+const int ReplayLog::CHUNK_SIZE = 64 * 1024;
+const int ReplayLog::INDEX_ENTRY_SIZE = 16;
+const int ReplayLog::TRAILER_SIZE = 8;
+
+ReplayLog::ReplayLog(const Maze *maze)
+    : ReplayLog(maze->toBinary(), QByteArray(), 0) {}
+
+ReplayLog::ReplayLog(const QByteArray &maze, const QByteArray &records,
+                     qint64 duration)
+    : m_maze(maze), m_records(records), m_duration(duration) {}
+
+ReplayLog *ReplayLog::fromFile(const QString &path) {
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly)) {
+    return nullptr;
+  }
+  return fromBytes(file.readAll());
+}
+
+ReplayLog *ReplayLog::fromBytes(const QByteArray &bytes) {
+  const char *data = bytes.constData();
+  if (bytes.size() < HEADER_SIZE ||
+      qFromLittleEndian<quint32>(data) != MAGIC ||
+      (qFromLittleEndian<quint16>(data + 4) != VERSION &&
+       qFromLittleEndian<quint16>(data + 4) != UNCOMPRESSED_VERSION)) {
+    return nullptr;
+  }
+  qint64 mazeSize = qFromLittleEndian<quint32>(data + 8);
+  if (bytes.size() < HEADER_SIZE + mazeSize) {
+    return nullptr;
+  }
+  QByteArray maze = bytes.mid(HEADER_SIZE, mazeSize);
+  Maze *parsed = Maze::fromBinary(maze);
+  if (parsed == nullptr) {
+    return nullptr;
+  }
+  delete parsed;
+  QByteArray records;
+  if (qFromLittleEndian<quint16>(data + 4) == UNCOMPRESSED_VERSION) {
+    records = bytes.mid(HEADER_SIZE + mazeSize);
+  } else if (!readChunks(bytes, HEADER_SIZE + mazeSize, &records)) {
+    return nullptr;
+  }
+
+  // Validate every record up front, so that reads never fail part way
+  ReplayLog *log = new ReplayLog(maze, records, 0);
+  const char *records = log->m_records.constData();
+  int position = 0;
+  while (position < log->m_records.size()) {
+    if (log->m_records.size() < position + RECORD_HEADER_SIZE) {
+      delete log;
+      return nullptr;
+    }
+    RecordType type = static_cast<RecordType>(records[position]);
+    int size = qFromLittleEndian<quint16>(records + position + 5);
+    if ((type != RecordType::COMMAND && type != RecordType::RESPONSE &&
+         type != RecordType::RESET) ||
+        log->m_records.size() < position + RECORD_HEADER_SIZE + size) {
+      delete log;
+      return nullptr;
+    }
+    log->m_duration += qFromLittleEndian<quint32>(records + position + 1);
+    position += RECORD_HEADER_SIZE + size;
+  }
+  return log;
+}
+
+bool ReplayLog::readChunks(const QByteArray &bytes, int start,
+                           QByteArray *records) {
+  // The chunks must follow one another, from the maze up to the index
+  if (bytes.size() < start + TRAILER_SIZE) {
+    return false;
+  }
+  const char *data = bytes.constData();
+  const char *trailer = data + bytes.size() - TRAILER_SIZE;
+  qint64 numChunks = qFromLittleEndian<quint32>(trailer);
+  qint64 indexOffset = qFromLittleEndian<quint32>(trailer + 4);
+  if (indexOffset < start ||
+      indexOffset + numChunks * INDEX_ENTRY_SIZE !=
+          bytes.size() - TRAILER_SIZE) {
+    return false;
+  }
+  qint64 offset = start;
+  for (qint64 i = 0; i < numChunks; i += 1) {
+    const char *entry = data + indexOffset + i * INDEX_ENTRY_SIZE;
+    qint64 chunkSize = qFromLittleEndian<quint32>(entry + 4);
+    if (qFromLittleEndian<quint32>(entry) != offset ||
+        indexOffset < offset + chunkSize) {
+      return false;
+    }
+    QByteArray chunk = qUncompress(
+        reinterpret_cast<const uchar *>(data + offset), chunkSize);
+    if (chunk.isEmpty()) {
+      return false;
+    }
+    records->append(chunk);
+    offset += chunkSize;
+  }
+  return offset == indexOffset;
+}
+
+bool ReplayLog::toFile(const QString &path) const {
+  QByteArray header = getHeader();
+  QByteArray chunks = getChunks();
+  QFile file(path);
+  return file.open(QFile::WriteOnly | QFile::Truncate) &&
+         file.write(header) == header.size() &&
+         file.write(m_maze) == m_maze.size() &&
+         file.write(chunks) == chunks.size();
+}
+
+QByteArray ReplayLog::toBytes() const {
+  return getHeader() + m_maze + getChunks();
+}
+
+QByteArray ReplayLog::getHeader() const {
+  QByteArray header(HEADER_SIZE, 0);
+  char *data = header.data();
+  qToLittleEndian<quint32>(MAGIC, data);
+  qToLittleEndian<quint16>(VERSION, data + 4);
+  qToLittleEndian<quint32>(m_maze.size(), data + 8);
+  return header;
+}
+
+QByteArray ReplayLog::getChunks() const {
+  // A chunk ends at the first record that takes it past the chunk size, so
+  // that any chunk can be decompressed and read on its own
+  QByteArray chunks;
+  QByteArray index;
+  qint64 start = HEADER_SIZE + m_maze.size();
+  const char *records = m_records.constData();
+  int first = 0;
+  int position = 0;
+  qint64 firstMicroseconds = 0;
+  qint64 microseconds = 0;
+  while (first < m_records.size()) {
+    while (position < m_records.size() && position - first < CHUNK_SIZE) {
+      microseconds += qFromLittleEndian<quint32>(records + position + 1);
+      position += RECORD_HEADER_SIZE +
+                  qFromLittleEndian<quint16>(records + position + 5);
+    }
+    QByteArray chunk = qCompress(
+        reinterpret_cast<const uchar *>(records + first), position - first);
+    char entry[INDEX_ENTRY_SIZE];
+    qToLittleEndian<quint32>(start + chunks.size(), entry);
+    qToLittleEndian<quint32>(chunk.size(), entry + 4);
+    qToLittleEndian<quint64>(firstMicroseconds, entry + 8);
+    index.append(entry, INDEX_ENTRY_SIZE);
+    chunks.append(chunk);
+    first = position;
+    firstMicroseconds = microseconds;
+  }
+  char trailer[TRAILER_SIZE];
+  qToLittleEndian<quint32>(index.size() / INDEX_ENTRY_SIZE, trailer);
+  qToLittleEndian<quint32>(start + chunks.size(), trailer + 4);
+  return chunks + index + QByteArray(trailer, TRAILER_SIZE);
+}
+
+const QByteArray &ReplayLog::getMaze() const { return m_maze; }
+
+qint64 ReplayLog::getDuration() const { return m_duration; }
+
+void ReplayLog::append(RecordType type, qint64 microseconds,
+                       const QByteArray &bytes) {
+  ASSERT_LE(m_duration, microseconds);
+  ASSERT_LE(bytes.size(), 0xffff);
+  char header[RECORD_HEADER_SIZE];
+  header[0] = static_cast<char>(type);
+  qToLittleEndian<quint32>(microseconds - m_duration, header + 1);
+  qToLittleEndian<quint16>(bytes.size(), header + 5);
+  m_records.append(header, RECORD_HEADER_SIZE);
+  m_records.append(bytes);
+  m_duration = microseconds;
+}
+
+int ReplayLog::read(int position, qint64 previousMicroseconds,
+                    Record *record) const {
+  if (position < 0 || m_records.size() <= position) {
+    return -1;
+  }
+  const char *data = m_records.constData() + position;
+  int size = qFromLittleEndian<quint16>(data + 5);
+  record->type = static_cast<RecordType>(data[0]);
+  record->microseconds =
+      previousMicroseconds + qFromLittleEndian<quint32>(data + 1);
+  record->bytes = m_records.mid(position + RECORD_HEADER_SIZE, size);
+  return position + RECORD_HEADER_SIZE + size;
+}
+
+}  // namespace mms
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "Maze.h"
+
+namespace mms {
+
+// A compact record of a single run: the maze, every command that the algo
+// sent, every response that it received, and every reset, each stamped with
+// the virtual time of the simulation (see Simulation::getVirtualSeconds).
+// Commands and responses are kept in the binary protocol, no matter which
+// protocol the algo used, so that the run can be replayed without the algo.
+//
+// Appending only copies the record onto the end of a buffer. The records
+// are compressed as the log is written, in chunks that each start at a
+// record, and each chunk's offset and starting time are indexed at the end
+// of the file, so that a reader can seek to a time without decompressing
+// everything before it.
+class ReplayLog {
+ public:
+  enum class RecordType : unsigned char {
+    COMMAND = 0x01,
+    RESPONSE = 0x02,
+    RESET = 0x03,
+  };
+
+  struct Record {
+    RecordType type;
+    qint64 microseconds;  // virtual time
+    QByteArray bytes;     // empty for resets
+  };
+
+  ReplayLog(const Maze *maze);
+
+  // Returns nullptr if the file isn't a valid replay log
+  static ReplayLog *fromFile(const QString &path);
+
+  // Returns false if the log couldn't be written
+  bool toFile(const QString &path) const;
+
+  // The same as the file, e.g., to send the log elsewhere
+  static ReplayLog *fromBytes(const QByteArray &bytes);
+  QByteArray toBytes() const;
+
+  // The maze in the binary maze format, see Maze::fromBinary
+  const QByteArray &getMaze() const;
+
+  // The virtual time of the last record
+  qint64 getDuration() const;
+
+  // Records must be appended in order of virtual time
+  void append(RecordType type, qint64 microseconds, const QByteArray &bytes);
+
+  // Reads the record at the position (zero for the first) into the record
+  // and returns the position of the next one, or returns -1 if there are no
+  // more records. The time before the record is needed to decode its own.
+  int read(int position, qint64 previousMicroseconds, Record *record) const;
+
+ private:
+  static const quint32 MAGIC;
+  static const quint16 VERSION;
+  static const quint16 UNCOMPRESSED_VERSION;  // still read, never written
+  static const int HEADER_SIZE;
+  static const int RECORD_HEADER_SIZE;
+  static const int CHUNK_SIZE;
+  static const int INDEX_ENTRY_SIZE;
+  static const int TRAILER_SIZE;
+
+  ReplayLog(const QByteArray &maze, const QByteArray &records,
+            qint64 duration);
+  QByteArray getHeader() const;
+
+  // The compressed chunks of records, then their index, then its trailer
+  QByteArray getChunks() const;
+
+  // Returns false if the chunks (everything after the maze) are invalid
+  static bool readChunks(const QByteArray &bytes, int start,
+                         QByteArray *records);
+
+  QByteArray m_maze;
+  QByteArray m_records;
+  qint64 m_duration;
+};
+
+}  // namespace mms
@@ -0,0 +1,113 @@
+#include "ReplayPlayer.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+ReplayPlayer::ReplayPlayer(const ReplayLog *log, QObject *parent)
+    : QObject(parent),
+      m_log(log),
+      m_simulation(nullptr),
+      m_nextPosition(0),
+      m_microseconds(0),
+      m_responseOffset(0),
+      m_mismatches(0),
+      m_seekTarget(-1) {
+  ASSERT_FA(m_log == nullptr);
+  m_output.open(QIODevice::WriteOnly);
+
+  // Responses to movements arrive asynchronously
+  connect(&m_output, &QIODevice::bytesWritten, this, &ReplayPlayer::advance);
+}
+
+QIODevice *ReplayPlayer::getOutput() { return &m_output; }
+
+void ReplayPlayer::start(Simulation *simulation) {
+  ASSERT_TR(m_simulation == nullptr);
+  ASSERT_FA(simulation == nullptr);
+  m_simulation = simulation;
+
+  // Responses were recorded in the binary protocol
+  m_simulation->useBinaryProtocol();
+  advance();
+}
+
+void ReplayPlayer::stop() { m_simulation = nullptr; }
+
+void ReplayPlayer::seek(qint64 microseconds) {
+  ASSERT_LE(m_microseconds, microseconds);
+  ASSERT_FA(m_simulation == nullptr);
+  m_seekTarget = microseconds;
+  m_simulation->setInstant(true);
+  advance();
+}
+
+qint64 ReplayPlayer::getPosition() const { return m_microseconds; }
+
+bool ReplayPlayer::getCheckpoint(Checkpoint *checkpoint) const {
+  ASSERT_FA(checkpoint == nullptr);
+  if (m_nextPosition < 0 || m_responseOffset < m_output.buffer().size()) {
+    return false;
+  }
+  *checkpoint = {m_nextPosition, m_microseconds, m_mismatches};
+  return true;
+}
+
+void ReplayPlayer::restoreCheckpoint(const Checkpoint &checkpoint) {
+  m_output.buffer().clear();
+  m_output.seek(0);
+  m_responseOffset = 0;
+  m_nextPosition = checkpoint.nextPosition;
+  m_microseconds = checkpoint.microseconds;
+  m_mismatches = checkpoint.mismatches;
+  m_seekTarget = -1;
+}
+
+void ReplayPlayer::advance() {
+  if (m_simulation == nullptr || m_nextPosition < 0) {
+    return;
+  }
+  ReplayLog::Record record;
+  while (true) {
+    if (0 <= m_seekTarget && m_seekTarget <= m_microseconds) {
+      m_seekTarget = -1;
+      emit seekFinished();
+    }
+    int next = m_log->read(m_nextPosition, m_microseconds, &record);
+    if (next < 0) {
+      m_nextPosition = -1;
+      if (0 <= m_seekTarget) {
+        m_seekTarget = -1;
+        emit seekFinished();
+      }
+      emit finished(m_mismatches);
+      return;
+    }
+    if (record.type == ReplayLog::RecordType::RESPONSE) {
+      // Wait for the simulation to catch up, e.g., to finish a movement
+      const QByteArray &output = m_output.buffer();
+      if (output.size() - m_responseOffset < record.bytes.size()) {
+        return;
+      }
+      if (output.mid(m_responseOffset, record.bytes.size()) != record.bytes) {
+        m_mismatches += 1;
+      }
+      m_responseOffset += record.bytes.size();
+      if (m_responseOffset == output.size()) {
+        // Everything has been read, so the buffer can be reused
+        m_output.buffer().clear();
+        m_output.seek(0);
+        m_responseOffset = 0;
+      }
+    } else if (record.type == ReplayLog::RecordType::COMMAND) {
+      m_simulation->processOutput(record.bytes);
+    } else {
+      m_simulation->requestReset();
+    }
+    m_nextPosition = next;
+    m_microseconds = record.microseconds;
+    emit played(m_microseconds);
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QBuffer>
+#include <QObject>
+
+#include "ReplayLog.h"
+#include "Simulation.h"
+
+namespace mms {
+
+// The ReplayPlayer feeds the commands of a replay log to a simulation as if
+// they came from the algo, so that a run can be watched again without the
+// algo. Each command is only sent once the simulation has produced all of
+// the responses that preceded it in the log, so the simulation sees exactly
+// the same sequence of commands and resets as it did during the recording.
+class ReplayPlayer : public QObject {
+  Q_OBJECT
+
+ public:
+  // The log isn't owned by the player
+  ReplayPlayer(const ReplayLog *log, QObject *parent = nullptr);
+
+  // The simulation must have been created for the maze of the log, with the
+  // output of the player as its output device. It isn't owned by the player.
+  QIODevice *getOutput();
+  void start(Simulation *simulation);
+
+  // Stops feeding the simulation, e.g., before it's deleted
+  void stop();
+
+  // Plays instantly up to the given virtual time, which must not be before
+  // the current position, then emits seekFinished
+  void seek(qint64 microseconds);
+
+  // The virtual time of the most recently played record
+  qint64 getPosition() const;
+
+  // The state of the player between records, see ReplayTimeline
+  struct Checkpoint {
+    int nextPosition;
+    qint64 microseconds;
+    int mismatches;
+  };
+
+  // Returns false if some responses haven't been checked yet, in which case
+  // the checkpoint isn't set
+  bool getCheckpoint(Checkpoint *checkpoint) const;
+
+  // Resumes from the checkpoint, once the simulation has been restored to the
+  // same point; any seek is abandoned
+  void restoreCheckpoint(const Checkpoint &checkpoint);
+
+ signals:
+  void seekFinished();
+
+  // Emitted after each record is played
+  void played(qint64 microseconds);
+
+  // Emitted once every record has been played; mismatches are responses
+  // that differed from the recording, which means that the run can't be
+  // reproduced, e.g., because the maze was edited while it was recorded
+  void finished(int mismatches);
+
+ private:
+  const ReplayLog *m_log;
+  Simulation *m_simulation;
+  QBuffer m_output;
+
+  int m_nextPosition;     // of the next record in the log
+  qint64 m_microseconds;  // of the most recent record
+  int m_responseOffset;   // of the first unread response in the output
+  int m_mismatches;
+  qint64 m_seekTarget;  // negative if not seeking
+
+  void advance();
+};
+
+}  // namespace mms
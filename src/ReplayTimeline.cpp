@@ -0,0 +1,108 @@
+#include "ReplayTimeline.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const qint64 ReplayTimeline::SNAPSHOT_INTERVAL_MICROSECONDS = 1000000;
+const int ReplayTimeline::KEYFRAME_INTERVAL = 16;
+
+ReplayTimeline::ReplayTimeline(const Maze *maze, MazeGraphic *view,
+                               Simulation *simulation, ReplayPlayer *player)
+    : m_maze(maze),
+      m_view(view),
+      m_simulation(simulation),
+      m_player(player),
+      m_snapshots(QVector<Snapshot>()),
+      m_tiles(QVector<TileState>()) {
+  ASSERT_FA(m_maze == nullptr);
+  ASSERT_FA(m_view == nullptr);
+  ASSERT_FA(m_simulation == nullptr);
+  ASSERT_FA(m_player == nullptr);
+}
+
+void ReplayTimeline::update() {
+  // Snapshots are only ever appended, so replaying a part of the run that
+  // already has snapshots doesn't take any more
+  ReplayPlayer::Checkpoint checkpoint;
+  if (!m_player->getCheckpoint(&checkpoint) || !m_simulation->isIdle()) {
+    return;
+  }
+  if (!m_snapshots.isEmpty() &&
+      checkpoint.microseconds < m_snapshots.last().player.microseconds +
+                                    SNAPSHOT_INTERVAL_MICROSECONDS) {
+    return;
+  }
+
+  Snapshot snapshot;
+  snapshot.player = checkpoint;
+  snapshot.simulation = m_simulation->getSnapshot();
+  snapshot.path = m_view->getPath();
+  snapshot.pathColor = m_view->getPathColor();
+  int numTiles = m_maze->getWidth() * m_maze->getHeight();
+  bool isKeyframe = m_snapshots.size() % KEYFRAME_INTERVAL == 0;
+  m_tiles.resize(numTiles);
+  for (int i = 0; i < numTiles; i += 1) {
+    TileState state = getTileState(i);
+    if (isKeyframe || state != m_tiles.at(i)) {
+      snapshot.tiles.append({i, state});
+      m_tiles[i] = state;
+    }
+  }
+  m_snapshots.append(snapshot);
+}
+
+void ReplayTimeline::seek(qint64 microseconds) {
+  // Find the last snapshot at or before the time
+  int low = 0;
+  int high = m_snapshots.size();
+  while (low < high) {
+    int middle = (low + high) / 2;
+    if (m_snapshots.at(middle).player.microseconds <= microseconds) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  int index = low - 1;
+
+  // Going back requires a snapshot, going forward only benefits from one
+  qint64 position = m_player->getPosition();
+  if (0 <= index && (microseconds < position ||
+                     position < m_snapshots.at(index).player.microseconds)) {
+    restore(index);
+  }
+  ASSERT_LE(m_player->getPosition(), microseconds);
+  m_player->seek(microseconds);
+}
+
+TileState ReplayTimeline::getTileState(int index) const {
+  int height = m_maze->getHeight();
+  return m_view->getTileState(index / height, index % height);
+}
+
+void ReplayTimeline::restore(int snapshotIndex) {
+  // Rebuild the view from the keyframe and the deltas that follow it
+  int keyframe = snapshotIndex - snapshotIndex % KEYFRAME_INTERVAL;
+  QVector<TileState> tiles(m_maze->getWidth() * m_maze->getHeight());
+  for (int i = keyframe; i <= snapshotIndex; i += 1) {
+    for (const QPair<int, TileState> &tile : m_snapshots.at(i).tiles) {
+      tiles[tile.first] = tile.second;
+    }
+  }
+  int height = m_maze->getHeight();
+  for (int i = 0; i < tiles.size(); i += 1) {
+    m_view->setTileState(i / height, i % height, tiles.at(i));
+  }
+
+  const Snapshot &snapshot = m_snapshots.at(snapshotIndex);
+  if (snapshot.path.isEmpty()) {
+    m_view->clearPath();
+  } else {
+    m_view->setPath(snapshot.path, snapshot.pathColor);
+  }
+  m_simulation->restoreSnapshot(snapshot.simulation);
+  m_player->restoreCheckpoint(snapshot.player);
+}
+
+}  // namespace mms
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QPair>
+#include <QVector>
+
+#include "Maze.h"
+#include "MazeGraphic.h"
+#include "ReplayPlayer.h"
+#include "Simulation.h"
+
+namespace mms {
+
+// The ReplayTimeline keeps periodic snapshots of a replay (the view, the
+// simulation, and the player) as it's played, so that seeking to any point
+// only means restoring the nearest snapshot before it and replaying from
+// there. To keep memory low on long runs, the view is delta-compressed: each
+// snapshot only holds the tiles that changed since the previous one, with a
+// complete keyframe every so often to bound the cost of a restore.
+class ReplayTimeline {
+ public:
+  // None of the arguments are owned by the timeline
+  ReplayTimeline(const Maze *maze, MazeGraphic *view, Simulation *simulation,
+                 ReplayPlayer *player);
+
+  // Takes a snapshot if enough virtual time has passed since the last one,
+  // and if the replay is between commands; should be called after each
+  // record is played
+  void update();
+
+  // Restores the nearest snapshot, if that's quicker than playing on from
+  // the current position, then plays instantly up to the virtual time
+  void seek(qint64 microseconds);
+
+ private:
+  static const qint64 SNAPSHOT_INTERVAL_MICROSECONDS;
+  static const int KEYFRAME_INTERVAL;
+
+  struct Snapshot {
+    ReplayPlayer::Checkpoint player;
+    Simulation::Snapshot simulation;
+    QVector<QPair<int, TileState>> tiles;  // by index, see getIndex
+    QVector<SemiPosition> path;            // shared with the view, not copied
+    Color pathColor;
+  };
+
+  const Maze *m_maze;
+  MazeGraphic *m_view;
+  Simulation *m_simulation;
+  ReplayPlayer *m_player;
+
+  QVector<Snapshot> m_snapshots;
+  QVector<TileState> m_tiles;  // as of the most recent snapshot
+
+  TileState getTileState(int index) const;
+  void restore(int snapshotIndex);
+};
+
+}  // namespace mms
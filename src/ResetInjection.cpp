@@ -0,0 +1,65 @@
+#include "ResetInjection.h"
+
+#include <QStringList>
+
+namespace mms {
+
+const quint32 ResetInjection::RESET_SUBSTREAM = 1;
+
+ResetInjection::ResetInjection()
+    : m_probability(0.0), m_randomKey(0), m_numMovements(0) {}
+
+bool ResetInjection::fromSpec(const QString &spec, ResetInjection *injection,
+                              QString *error) {
+  ResetInjection parsed;
+  parsed.m_spec = spec;
+  for (const QString &trigger : spec.split(',', Qt::SkipEmptyParts)) {
+    QStringList parts = trigger.split(':');
+    bool ok = false;
+    if (parts.first() == "moves" && parts.size() == 2) {
+      int moves = parts.at(1).toInt(&ok);
+      ok = ok && 0 < moves;
+      parsed.m_moves.insert(moves);
+    } else if (parts.first() == "tile" && parts.size() == 3) {
+      bool yOk = false;
+      int x = parts.at(1).toInt(&ok);
+      int y = parts.at(2).toInt(&yOk);
+      ok = ok && yOk && 0 <= x && 0 <= y;
+      parsed.m_tiles.insert({x, y});
+    } else if (parts.first() == "random" && parts.size() == 2) {
+      double probability = parts.at(1).toDouble(&ok);
+      ok = ok && 0.0 <= probability && probability <= 1.0;
+      parsed.m_probability = probability;
+    }
+    if (!ok) {
+      *error = QString("Invalid reset trigger: \"%1\"").arg(trigger);
+      return false;
+    }
+  }
+  *injection = parsed;
+  return true;
+}
+
+QString ResetInjection::getSpec() const { return m_spec; }
+
+bool ResetInjection::isEmpty() const {
+  return m_moves.isEmpty() && m_tiles.isEmpty() && m_probability == 0.0;
+}
+
+void ResetInjection::setRandomKey(quint64 key) { m_randomKey = key; }
+
+bool ResetInjection::onMovementCompleted(int x, int y) {
+  m_numMovements += 1;
+  bool isDue = m_moves.contains(m_numMovements);
+  if (m_tiles.remove({x, y})) {
+    isDue = true;
+  }
+  if (0.0 < m_probability &&
+      RandomStream::getDouble(m_randomKey, RESET_SUBSTREAM, m_numMovements) <
+          m_probability) {
+    isDue = true;
+  }
+  return isDue;
+}
+
+}  // namespace mms
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QPair>
+#include <QSet>
+#include <QString>
+
+#include "RandomStream.h"
+
+namespace mms {
+
+// A schedule of resets to inject into a run, as if the reset button had been
+// pressed at those points, so that how algos recover from resets can be
+// measured over whole batches. A schedule is a comma-separated list of
+// triggers, which are checked as each movement of the mouse ends:
+//
+//   moves:N   once the Nth movement ends
+//   tile:X:Y  the first time that a movement ends on the tile
+//   random:P  after every movement, with probability P
+//
+// The random draws are from a stream of the run's key (see RandomStream), so
+// a run is always reset at the same points, however many run at once.
+class ResetInjection {
+ public:
+  // Never injects a reset
+  ResetInjection();
+
+  // Returns false if the schedule can't be parsed
+  static bool fromSpec(const QString &spec, ResetInjection *injection,
+                       QString *error);
+  QString getSpec() const;
+  bool isEmpty() const;
+
+  void setRandomKey(quint64 key);
+
+  // Counts a movement that ended on the tile, and returns whether a reset is
+  // due; each trigger other than random ones fires at most once
+  bool onMovementCompleted(int x, int y);
+
+ private:
+  QString m_spec;
+  QSet<int> m_moves;
+  QSet<QPair<int, int>> m_tiles;  // that haven't been reached yet
+  double m_probability;
+  quint64 m_randomKey;
+  int m_numMovements;
+
+  // Each movement's draw is at its number in the substream, so that no
+  // stream needs to be kept per run
+  static const quint32 RESET_SUBSTREAM;
+};
+
+}  // namespace mms
@@ -0,0 +1,101 @@
+#include "ResultCache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+
+namespace mms {
+
+const int ResultCache::VERSION = 10;
+
+QByteArray ResultCache::getAlgoHash(const QString &directory,
+                                    const QString &runCommand) {
+  QDir root(directory);
+  if (!root.exists()) {
+    return QByteArray();
+  }
+  // Sorted, since the order of iteration depends on the file system
+  QStringList paths;
+  QDirIterator iterator(directory, QDir::Files | QDir::Hidden,
+                        QDirIterator::Subdirectories);
+  while (iterator.hasNext()) {
+    paths.append(root.relativeFilePath(iterator.next()));
+  }
+  paths.sort();
+
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(runCommand.toUtf8());
+  for (const QString &path : paths) {
+    QFile file(root.filePath(path));
+    if (!file.open(QFile::ReadOnly)) {
+      return QByteArray();
+    }
+    // The null separates the path from the contents of the next file
+    hash.addData(path.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(&file);
+  }
+  return hash.result();
+}
+
+QByteArray ResultCache::getKey(const QByteArray &algoHash, const Maze *maze,
+                               int repeat, double timeoutSeconds,
+                               bool isCpuTimed, quint32 seed,
+                               const QString &resetInjection) {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(QString("%1,%2,%3,%4,%5,")
+                   .arg(VERSION)
+                   .arg(repeat)
+                   .arg(timeoutSeconds)
+                   .arg(isCpuTimed ? "cpu" : "real")
+                   .arg(seed)
+                   .toUtf8());
+  hash.addData(algoHash);
+
+  // The exact walls rather than the canonical hash (see
+  // Maze::getCanonicalHash), since the runs of an algo on a rotated or
+  // mirrored copy of a maze aren't the same runs
+  hash.addData(maze->toBinary());
+  hash.addData(resetInjection.toUtf8());
+  return hash.result();
+}
+
+bool ResultCache::load(const QString &directory, const QByteArray &key,
+                       RemoteProtocol::Result *result) {
+  QFile file(getPath(directory, key));
+  if (!file.open(QFile::ReadOnly)) {
+    return false;
+  }
+  QByteArray bytes = file.readAll();
+  RemoteProtocol::Message message;
+  if (RemoteProtocol::take(&bytes, &message) !=
+          RemoteProtocol::Status::MESSAGE ||
+      message.type != RemoteProtocol::MessageType::RESULT) {
+    return false;
+  }
+  *result = message.result;
+  return true;
+}
+
+void ResultCache::store(const QString &directory, const QByteArray &key,
+                        const RemoteProtocol::Result &result) {
+  if (!QDir().mkpath(directory)) {
+    return;
+  }
+  // Written under a temporary name and then renamed, so that concurrent
+  // batches never read a partial entry
+  QSaveFile file(getPath(directory, key));
+  if (file.open(QIODevice::WriteOnly)) {
+    file.write(RemoteProtocol::encode(result));
+    file.commit();
+  }
+}
+
+QString ResultCache::getPath(const QString &directory, const QByteArray &key) {
+  return QDir(directory).filePath(QString(key.toHex()) + ".mmsc");
+}
+
+}  // namespace mms
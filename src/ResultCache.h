@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "Maze.h"
+#include "RemoteProtocol.h"
+
+namespace mms {
+
+// Results of finished runs, on disk, keyed by everything that a run depends
+// on: the contents of the algo's directory (its sources and build output),
+// its run command, the maze, the repeat, and the settings of the run. Since
+// a run's virtual time doesn't depend on the machine, a deterministic algo
+// gets the same stats every time, so a cached result can stand in for the
+// run. Entries are in the same format as the results that workers send (see
+// RemoteProtocol), one file per key.
+class ResultCache {
+ public:
+  ResultCache() = delete;
+
+  // A hash of the path and contents of every file under the directory, and
+  // of the run command; empty if the directory can't be read
+  static QByteArray getAlgoHash(const QString &directory,
+                                const QString &runCommand);
+
+  // The timeout is of CPU time if so (see BatchRunner::setCpuTimeout), the
+  // seed is that of the batch's random streams (see BatchRunner::setSeed),
+  // and the schedule of injected resets (see ResetInjection) is empty if none
+  static QByteArray getKey(const QByteArray &algoHash, const Maze *maze,
+                           int repeat, double timeoutSeconds, bool isCpuTimed,
+                           quint32 seed, const QString &resetInjection);
+
+  // Returns false if there's no (readable) entry for the key
+  static bool load(const QString &directory, const QByteArray &key,
+                   RemoteProtocol::Result *result);
+
+  // Does nothing if the entry can't be written, since it's only a cache
+  static void store(const QString &directory, const QByteArray &key,
+                    const RemoteProtocol::Result &result);
+
+ private:
+  // Incremented whenever runs of the same algo could give different results,
+  // e.g., when the stats change, so that old entries are never used
+  static const int VERSION;
+
+  static QString getPath(const QString &directory, const QByteArray &key);
+};
+
+}  // namespace mms
@@ -0,0 +1,226 @@
+#include "ResultsDatabase.h"
+
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+// Enough that the syncs are few, but few enough that little is lost if the
+// batch is killed, which a checkpoint (see BatchRunner) wouldn't rerun
+const int ResultsDatabase::COMMIT_INTERVAL = 100;
+
+const QStringList &ResultsDatabase::SCHEMA() {
+  // The runs are looked up by algo and maze, or by when they finished, and
+  // their stats by run, which the primary key of stats covers
+  static const QStringList schema = {
+      "CREATE TABLE IF NOT EXISTS batches ("
+      "id INTEGER PRIMARY KEY, started TEXT NOT NULL)",
+      "CREATE TABLE IF NOT EXISTS algos ("
+      "id INTEGER PRIMARY KEY, name TEXT NOT NULL, directory TEXT NOT NULL, "
+      "run_command TEXT NOT NULL, UNIQUE (name, directory, run_command))",
+      "CREATE TABLE IF NOT EXISTS mazes ("
+      "id INTEGER PRIMARY KEY, file TEXT NOT NULL, hash BLOB NOT NULL, "
+      "UNIQUE (file, hash))",
+      "CREATE TABLE IF NOT EXISTS runs ("
+      "id INTEGER PRIMARY KEY, "
+      "batch_id INTEGER NOT NULL REFERENCES batches (id), "
+      "algo_id INTEGER NOT NULL REFERENCES algos (id), "
+      "maze_id INTEGER NOT NULL REFERENCES mazes (id), "
+      "repeat INTEGER NOT NULL, status TEXT NOT NULL, finished TEXT NOT NULL, "
+      "algo_user_s REAL, algo_system_s REAL, algo_peak_rss_kib INTEGER)",
+      "CREATE INDEX IF NOT EXISTS runs_by_algo_and_maze "
+      "ON runs (algo_id, maze_id)",
+      "CREATE INDEX IF NOT EXISTS runs_by_finished ON runs (finished)",
+      "CREATE TABLE IF NOT EXISTS stats ("
+      "run_id INTEGER NOT NULL REFERENCES runs (id), name TEXT NOT NULL, "
+      "value REAL, PRIMARY KEY (run_id, name)) WITHOUT ROWID",
+      "CREATE VIEW IF NOT EXISTS results AS SELECT "
+      "algos.name AS algo, algos.directory AS directory, mazes.file AS maze, "
+      "COUNT(*) AS runs, SUM(runs.status = 'complete') AS complete, "
+      "MIN(best.value) AS best_run_time, AVG(best.value) AS mean_run_time, "
+      "AVG(score.value) AS mean_score, "
+      "AVG(runs.algo_user_s + runs.algo_system_s) AS mean_algo_cpu_s, "
+      "MAX(runs.finished) AS last_finished "
+      "FROM runs "
+      "JOIN algos ON algos.id = runs.algo_id "
+      "JOIN mazes ON mazes.id = runs.maze_id "
+      "LEFT JOIN stats AS best "
+      "ON best.run_id = runs.id AND best.name = 'best-run-time' "
+      "LEFT JOIN stats AS score "
+      "ON score.run_id = runs.id AND score.name = 'score' "
+      "GROUP BY runs.algo_id, runs.maze_id",
+  };
+  return schema;
+}
+
+ResultsDatabase *ResultsDatabase::open(const QString &path, QString *error,
+                                       QObject *parent) {
+  ResultsDatabase *database = new ResultsDatabase(parent);
+  if (!database->initialize(path, error)) {
+    delete database;
+    return nullptr;
+  }
+  return database;
+}
+
+ResultsDatabase::ResultsDatabase(QObject *parent)
+    : QObject(parent),
+      m_connection(QString("mms-results-%1")
+                       .arg(reinterpret_cast<quintptr>(this))),
+      m_batchId(-1),
+      m_numPending(0),
+      m_algoIds(QHash<QString, qint64>()),
+      m_mazeIds(QHash<QString, qint64>()) {}
+
+ResultsDatabase::~ResultsDatabase() {
+  // The connection can only be removed once nothing refers to it
+  {
+    QSqlDatabase database = QSqlDatabase::database(m_connection, false);
+    if (database.isOpen()) {
+      commit();
+      database.close();
+    }
+  }
+  QSqlDatabase::removeDatabase(m_connection);
+}
+
+bool ResultsDatabase::initialize(const QString &path, QString *error) {
+  QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", m_connection);
+  database.setDatabaseName(path);
+  if (!database.open()) {
+    *error = QString("Could not open \"%1\": %2")
+                 .arg(path, database.lastError().text());
+    return false;
+  }
+  QSqlQuery query(database);
+  for (const QString &statement : SCHEMA()) {
+    if (!query.exec(statement)) {
+      *error = QString("\"%1\" is not a results database: %2")
+                   .arg(path, query.lastError().text());
+      return false;
+    }
+  }
+  query.prepare("INSERT INTO batches (started) VALUES (?)");
+  query.addBindValue(
+      QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+  if (!query.exec()) {
+    *error = QString("Could not write to \"%1\": %2")
+                 .arg(path, query.lastError().text());
+    return false;
+  }
+  m_batchId = query.lastInsertId().toLongLong();
+  return true;
+}
+
+bool ResultsDatabase::addRun(const Run &run) {
+  QSqlDatabase database = QSqlDatabase::database(m_connection);
+  if (m_numPending == 0 && !database.transaction()) {
+    return false;
+  }
+  m_numPending += 1;
+  qint64 algoId = -1;
+  qint64 mazeId = -1;
+  if (!getId("algos", {"name", "directory", "run_command"},
+             {run.algoName, run.algoDirectory, run.algoRunCommand},
+             &m_algoIds, &algoId) ||
+      !getId("mazes", {"file", "hash"}, {run.mazeFile, run.mazeHash},
+             &m_mazeIds, &mazeId)) {
+    return false;
+  }
+
+  // The usage is empty unless it was measured, in which case it's the user
+  // and system seconds, then the peak (see BatchRunner::getUsageFields)
+  QStringList usage = run.usage.split(',');
+  auto toValue = [](const QString &field) {
+    return field.isEmpty() ? QVariant() : QVariant(field.toDouble());
+  };
+  QSqlQuery query(database);
+  query.prepare(
+      "INSERT INTO runs (batch_id, algo_id, maze_id, repeat, status, "
+      "finished, algo_user_s, algo_system_s, algo_peak_rss_kib) "
+      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+  query.addBindValue(m_batchId);
+  query.addBindValue(algoId);
+  query.addBindValue(mazeId);
+  query.addBindValue(run.repeat);
+  query.addBindValue(run.status);
+  query.addBindValue(
+      QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+  query.addBindValue(toValue(usage.value(0)));
+  query.addBindValue(toValue(usage.value(1)));
+  query.addBindValue(toValue(usage.value(2)));
+  if (!query.exec()) {
+    return false;
+  }
+  qint64 runId = query.lastInsertId().toLongLong();
+  query.prepare("INSERT INTO stats (run_id, name, value) VALUES (?, ?, ?)");
+  for (auto it = run.stats.constBegin(); it != run.stats.constEnd(); ++it) {
+    query.addBindValue(runId);
+    query.addBindValue(it.key());
+    query.addBindValue(toValue(it.value()));
+    if (!query.exec()) {
+      return false;
+    }
+  }
+  if (COMMIT_INTERVAL <= m_numPending) {
+    return commit();
+  }
+  return true;
+}
+
+bool ResultsDatabase::commit() {
+  if (m_numPending == 0) {
+    return true;
+  }
+  m_numPending = 0;
+  return QSqlDatabase::database(m_connection).commit();
+}
+
+bool ResultsDatabase::getId(const QString &table, const QStringList &columns,
+                            const QVariantList &values,
+                            QHash<QString, qint64> *ids, qint64 *id) {
+  ASSERT_EQ(columns.size(), values.size());
+  QStringList keys;
+  for (const QVariant &value : values) {
+    keys.append(value.typeId() == QMetaType::QByteArray
+                    ? QString(value.toByteArray().toHex())
+                    : value.toString());
+  }
+  QString key = keys.join('\n');
+  if (ids->contains(key)) {
+    *id = ids->value(key);
+    return true;
+  }
+  QStringList placeholders;
+  QStringList conditions;
+  for (const QString &column : columns) {
+    placeholders.append("?");
+    conditions.append(column + " = ?");
+  }
+  QSqlQuery query(QSqlDatabase::database(m_connection));
+  query.prepare(QString("INSERT OR IGNORE INTO %1 (%2) VALUES (%3)")
+                    .arg(table, columns.join(", "), placeholders.join(", ")));
+  for (const QVariant &value : values) {
+    query.addBindValue(value);
+  }
+  if (!query.exec()) {
+    return false;
+  }
+  query.prepare(QString("SELECT id FROM %1 WHERE %2")
+                    .arg(table, conditions.join(" AND ")));
+  for (const QVariant &value : values) {
+    query.addBindValue(value);
+  }
+  if (!query.exec() || !query.next()) {
+    return false;
+  }
+  *id = query.value(0).toLongLong();
+  ids->insert(key, *id);
+  return true;
+}
+
+}  // namespace mms
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantList>
+
+namespace mms {
+
+// An SQLite database of the runs of every batch that was given it, e.g., to
+// compare an algo's runs over weeks. Each run is a row of runs, referring to
+// rows of batches, algos, and mazes, with its stats as rows of stats, and
+// the results view summarizes the runs of each algo on each maze, which is
+// what the GUI shows (see ResultsView). Runs are inserted in transactions of
+// many runs apiece, since a transaction per run would be bound by syncing the
+// disk, and anything pending is committed when the database is deleted.
+class ResultsDatabase : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Run {
+    QString algoName;  // empty unless the batch is a tournament
+    QString algoDirectory;
+    QString algoRunCommand;
+    QString mazeFile;
+    QByteArray mazeHash;  // of the maze's binary format, empty if invalid
+    int repeat;
+    QString status;  // as in a row, see BatchRunner
+    QMap<QString, QString> stats;  // by name, see STRING_TO_STAT
+    QString usage;  // CSV fields, see BatchRunner::setUsageColumns
+  };
+
+  // Opens the database, creating it if need be, and starts a new batch in
+  // it; returns nullptr if it couldn't be opened or isn't a results database
+  static ResultsDatabase *open(const QString &path, QString *error,
+                               QObject *parent = nullptr);
+
+  ~ResultsDatabase();
+
+  // Returns false if the run couldn't be inserted
+  bool addRun(const Run &run);
+
+  // Commits the runs that were added since the last commit
+  bool commit();
+
+ private:
+  static const int COMMIT_INTERVAL;
+  static const QStringList &SCHEMA();
+
+  ResultsDatabase(QObject *parent);
+  bool initialize(const QString &path, QString *error);
+
+  // Finds the row of the table with the values, inserting it if need be
+  bool getId(const QString &table, const QStringList &columns,
+             const QVariantList &values, QHash<QString, qint64> *ids,
+             qint64 *id);
+
+  QString m_connection;
+  qint64 m_batchId;
+  int m_numPending;  // the runs in the open transaction
+
+  // The rows of the algos and mazes that were already looked up, by their
+  // values, so that each is only looked up once per batch
+  QHash<QString, qint64> m_algoIds;
+  QHash<QString, qint64> m_mazeIds;
+};
+
+}  // namespace mms
@@ -0,0 +1,107 @@
+#include "ResultsView.h"
+
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVBoxLayout>
+
+namespace mms {
+
+const QString ResultsView::CONNECTION = "mms-results-view";
+
+ResultsView::ResultsView(QWidget *parent)
+    : QWidget(parent),
+      m_openButton(new QPushButton("Open")),
+      m_refreshButton(new QPushButton("Refresh")),
+      m_filter(new QLineEdit()),
+      m_status(new QLabel()),
+      m_table(new QTableView()),
+      m_model(new QSqlQueryModel(this)) {
+  QHBoxLayout *controlsLayout = new QHBoxLayout();
+  controlsLayout->addWidget(m_openButton);
+  controlsLayout->addWidget(m_refreshButton);
+  controlsLayout->addWidget(m_filter);
+  QVBoxLayout *layout = new QVBoxLayout();
+  layout->addLayout(controlsLayout);
+  layout->addWidget(m_status);
+  layout->addWidget(m_table);
+  setLayout(layout);
+
+  // Nothing can be refreshed or filtered until a database is open
+  m_refreshButton->setEnabled(false);
+  m_filter->setEnabled(false);
+  m_filter->setPlaceholderText("Filter by algo or maze");
+  m_table->setModel(m_model);
+  m_table->horizontalHeader()->setSectionResizeMode(
+      QHeaderView::ResizeToContents);
+  connect(m_openButton, &QPushButton::clicked, this, &ResultsView::open);
+  connect(m_refreshButton, &QPushButton::clicked, this,
+          &ResultsView::refresh);
+  connect(m_filter, &QLineEdit::textChanged, this, &ResultsView::refresh);
+}
+
+ResultsView::~ResultsView() {
+  // The connection can only be removed once the model's query is gone
+  m_model->clear();
+  if (QSqlDatabase::contains(CONNECTION)) {
+    QSqlDatabase::database(CONNECTION, false).close();
+    QSqlDatabase::removeDatabase(CONNECTION);
+  }
+}
+
+void ResultsView::open() {
+  QString path = QFileDialog::getOpenFileName(
+      this, tr("Open Results"), QString(),
+      tr("Results databases (*.sqlite *.db);;All files (*)"));
+  if (path.isNull()) {
+    return;
+  }
+  m_model->clear();
+  if (QSqlDatabase::contains(CONNECTION)) {
+    QSqlDatabase::database(CONNECTION, false).close();
+    QSqlDatabase::removeDatabase(CONNECTION);
+  }
+  // Opened read-only, so that a batch can keep writing to it
+  QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+  database.setDatabaseName(path);
+  database.setConnectOptions("QSQLITE_OPEN_READONLY");
+  if (!database.open()) {
+    m_status->setText(QString("Could not open \"%1\": %2")
+                          .arg(path, database.lastError().text()));
+    m_refreshButton->setEnabled(false);
+    m_filter->setEnabled(false);
+    return;
+  }
+  m_refreshButton->setEnabled(true);
+  m_filter->setEnabled(true);
+  refresh();
+}
+
+void ResultsView::refresh() {
+  QSqlDatabase database = QSqlDatabase::database(CONNECTION, false);
+  if (!database.isOpen()) {
+    return;
+  }
+  QSqlQuery query(database);
+  query.prepare(
+      "SELECT * FROM results WHERE instr(algo, ?) > 0 OR "
+      "instr(directory, ?) > 0 OR instr(maze, ?) > 0 "
+      "ORDER BY algo, directory, maze");
+  for (int i = 0; i < 3; i += 1) {
+    query.addBindValue(m_filter->text());
+  }
+  if (!query.exec()) {
+    m_model->clear();
+    m_status->setText(QString("\"%1\" is not a results database: %2")
+                          .arg(database.databaseName(),
+                               query.lastError().text()));
+    return;
+  }
+  m_model->setQuery(std::move(query));
+  m_status->setText(QString("%1").arg(database.databaseName()));
+}
+
+}  // namespace mms
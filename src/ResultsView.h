@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSqlQueryModel>
+#include <QString>
+#include <QTableView>
+#include <QWidget>
+
+namespace mms {
+
+// Shows the results view of a results database (see ResultsDatabase): the
+// runs of each algo on each maze, summarized, optionally filtered to the
+// algos or mazes whose names contain some text. The database is queried
+// whenever the filter changes or the view is refreshed, rather than read
+// into memory, so that it can be as large as it likes.
+class ResultsView : public QWidget {
+  Q_OBJECT
+
+ public:
+  ResultsView(QWidget *parent = nullptr);
+  ~ResultsView();
+
+ private:
+  static const QString CONNECTION;
+
+  QPushButton *m_openButton;
+  QPushButton *m_refreshButton;
+  QLineEdit *m_filter;
+  QLabel *m_status;
+  QTableView *m_table;
+  QSqlQueryModel *m_model;
+
+  void open();
+  void refresh();
+};
+
+}  // namespace mms
@@ -0,0 +1,146 @@
+#include "RunTrace.h"
+
+#include <QStringList>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+RunTrace::RunTrace()
+    : m_microseconds(QVector<qint64>()),
+      m_kinds(QVector<Kind>()),
+      m_codes(QVector<int>()),
+      m_values(QVector<double>()),
+      m_xs(QVector<int>()),
+      m_ys(QVector<int>()),
+      m_directions(QVector<SemiDirection>()),
+      m_distances(QVector<float>()),
+      m_turns(QVector<float>()),
+      m_metricIds(QHash<QString, int>()),
+      m_metricNames(QStringList()) {}
+
+int RunTrace::getSize() const { return m_kinds.size(); }
+
+void RunTrace::append(Kind kind, qint64 microseconds, int code, double value,
+                      SemiPosition position, SemiDirection direction,
+                      float distance, float turns) {
+  m_microseconds.append(microseconds);
+  m_kinds.append(kind);
+  m_codes.append(code);
+  m_values.append(value);
+  m_xs.append(position.x);
+  m_ys.append(position.y);
+  m_directions.append(direction);
+  m_distances.append(distance);
+  m_turns.append(turns);
+}
+
+int RunTrace::getMetricId(const QString &name) {
+  auto it = m_metricIds.constFind(name);
+  if (it != m_metricIds.constEnd()) {
+    return it.value();
+  }
+  int id = m_metricNames.size();
+  m_metricIds.insert(name, id);
+  m_metricNames.append(name);
+  return id;
+}
+
+QString RunTrace::toCsv() const {
+  QStringList rows = {
+      "time-us,kind,opcode,argument,response,x,y,direction,distance,turns,"
+      "metric"};
+  rows.reserve(1 + getSize());
+  float distance = 0.0;
+  float turns = 0.0;
+  for (int i = 0; i < getSize(); i += 1) {
+    Kind kind = m_kinds.at(i);
+    QString opcode;
+    QString argument;
+    QString response;
+    QString metric;
+    if (kind == Kind::COMMAND) {
+      opcode = QString::number(m_codes.at(i));
+      argument = QString::number(m_values.at(i));
+    } else if (kind == Kind::METRIC) {
+      opcode = QString::number(static_cast<int>(CommandType::METRIC));
+      argument = QString::number(m_values.at(i));
+      metric = m_metricNames.at(m_codes.at(i));
+    } else if (kind == Kind::RESPONSE) {
+      response = getResponseText(static_cast<ResponseType>(m_codes.at(i)),
+                                 m_values.at(i));
+    }
+    rows.append(QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11")
+                    .arg(m_microseconds.at(i))
+                    .arg(getKindName(kind), opcode, argument, response)
+                    .arg(m_xs.at(i))
+                    .arg(m_ys.at(i))
+                    .arg(getDirectionName(m_directions.at(i)))
+                    .arg(m_distances.at(i) - distance)
+                    .arg(m_turns.at(i) - turns)
+                    .arg(metric));
+    distance = m_distances.at(i);
+    turns = m_turns.at(i);
+  }
+  return rows.join("\n") + "\n";
+}
+
+QString RunTrace::getKindName(Kind kind) {
+  switch (kind) {
+    case Kind::COMMAND:
+      return "command";
+    case Kind::RESPONSE:
+      return "response";
+    case Kind::RESET:
+      return "reset";
+    case Kind::METRIC:
+      return "metric";
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+QString RunTrace::getDirectionName(SemiDirection direction) {
+  switch (direction) {
+    case SemiDirection::NORTH:
+      return "n";
+    case SemiDirection::SOUTH:
+      return "s";
+    case SemiDirection::EAST:
+      return "e";
+    case SemiDirection::WEST:
+      return "w";
+    case SemiDirection::NORTHEAST:
+      return "ne";
+    case SemiDirection::SOUTHEAST:
+      return "se";
+    case SemiDirection::NORTHWEST:
+      return "nw";
+    case SemiDirection::SOUTHWEST:
+      return "sw";
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+QString RunTrace::getResponseText(ResponseType type, double value) {
+  // As in the text protocol, see TextProtocol::encode
+  switch (type) {
+    case ResponseType::NONE:
+    case ResponseType::INTEGERS:
+      return "";
+    case ResponseType::ACK:
+      return "ack";
+    case ResponseType::CRASH:
+      return "crash";
+    case ResponseType::BOOL:
+      return value != 0.0 ? "true" : "false";
+    case ResponseType::INTEGER:
+    case ResponseType::FLOAT:
+      return QString::number(value);
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "Command.h"
+#include "Direction.h"
+#include "Mouse.h"
+
+namespace mms {
+
+// A trace of a run for offline analysis, e.g., with pandas or DuckDB: a row
+// for every command, response, and reset, stamped with the virtual time (see
+// Simulation::getVirtualSeconds), with the pose of the mouse and the change
+// in its distance and turns since the previous row. Rows are kept a column
+// at a time, in flat arrays, so that appending one is cheap enough to do for
+// every command, and nothing is formatted until the trace is written.
+class RunTrace {
+ public:
+  enum class Kind : unsigned char {
+    COMMAND,
+    RESPONSE,
+    RESET,
+    METRIC,
+  };
+
+  RunTrace();
+
+  int getSize() const;
+
+  // The code is the command's opcode (see CommandType) or the response's
+  // type, or the metric's ID (see getMetricId), and the value is the
+  // command's count, the response's value, or the metric's sample. The
+  // distance and turns are the totals of the run so far.
+  void append(Kind kind, qint64 microseconds, int code, double value,
+              SemiPosition position, SemiDirection direction, float distance,
+              float turns);
+
+  // A small ID for the name of a metric, so that its rows needn't keep a
+  // copy of the name
+  int getMetricId(const QString &name);
+
+  // A row for each record, in order, after the header row:
+  // "time-us,kind,opcode,argument,response,x,y,direction,distance,turns,
+  // metric", where the opcode and argument are only set for commands and
+  // metrics (whose argument is the sample), the response only for responses
+  // (and is empty for lists of integers), x and y are the semi-position of
+  // the mouse (see SemiPosition), the distance and turns are the changes
+  // since the previous row, and the metric is only set for metrics, to the
+  // metric's name
+  QString toCsv() const;
+
+ private:
+  QVector<qint64> m_microseconds;
+  QVector<Kind> m_kinds;
+  QVector<int> m_codes;
+  QVector<double> m_values;
+  QVector<int> m_xs;
+  QVector<int> m_ys;
+  QVector<SemiDirection> m_directions;
+  QVector<float> m_distances;
+  QVector<float> m_turns;
+  QHash<QString, int> m_metricIds;
+  QStringList m_metricNames;  // indexed by ID
+
+  static QString getKindName(Kind kind);
+  static QString getDirectionName(SemiDirection direction);
+  static QString getResponseText(ResponseType type, double value);
+};
+
+}  // namespace mms
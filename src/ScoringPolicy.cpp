@@ -0,0 +1,33 @@
+#include "ScoringPolicy.h"
+
+namespace mms {
+
+float ClassicScoring::score(const Stats::State &state) {
+  if (!state.solved) {
+    return 2000;
+  }
+  const float *values = state.values;
+  return values[static_cast<int>(StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE)] +
+         values[static_cast<int>(StatsEnum::BEST_RUN_TURNS)] +
+         0.1 * (values[static_cast<int>(StatsEnum::TOTAL_EFFECTIVE_DISTANCE)] +
+                values[static_cast<int>(StatsEnum::TOTAL_TURNS)]);
+}
+
+float TimeScoring::score(const Stats::State &state) {
+  if (!state.solved) {
+    return 600;
+  }
+  const float *values = state.values;
+  return values[static_cast<int>(StatsEnum::BEST_RUN_TIME)] +
+         values[static_cast<int>(StatsEnum::TOTAL_TIME)] / 30.0;
+}
+
+const QMap<QString, Stats::Scoring> &STRING_TO_SCORING() {
+  static const QMap<QString, Stats::Scoring> map = {
+      {"classic", &ClassicScoring::score},
+      {"time", &TimeScoring::score},
+  };
+  return map;
+}
+
+}  // namespace mms
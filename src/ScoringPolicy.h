@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QMap>
+#include <QString>
+
+#include "Stats.h"
+
+namespace mms {
+
+// Scoring policies, for the rules of different competitions. Each is a class
+// with a static function that derives the score from the rest of a run's
+// stats; it's only called when the score is needed, e.g., when it's shown or
+// written to a row, so any number of policies can score a run after the fact
+// without simulating it again. Policies must not read the score itself.
+class ClassicScoring {
+ public:
+  // The ClassicScoring class is not constructible
+  ClassicScoring() = delete;
+
+  // The effective distance and turns of the best run, plus a tenth of those
+  // of the whole search, or 2000 until the maze is solved
+  static float score(const Stats::State &state);
+};
+
+class TimeScoring {
+ public:
+  // The TimeScoring class is not constructible
+  TimeScoring() = delete;
+
+  // The time of the best run, plus a thirtieth of the time of the whole
+  // search, in seconds, as a real mouse would drive them (see MotionProfile),
+  // or 600, i.e., a ten minute limit, until the maze is solved
+  static float score(const Stats::State &state);
+};
+
+// Maps the names of the policies to their score functions, e.g., to choose
+// them on the command line
+const QMap<QString, Stats::Scoring> &STRING_TO_SCORING();
+
+}  // namespace mms
@@ -0,0 +1,346 @@
+#include "ScriptAlgo.h"
+
+#include <QFile>
+#include <QJSValue>
+#include <QMetaMethod>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include "BinaryProtocol.h"
+#include "Stats.h"
+
+namespace mms {
+
+const int ScriptAlgo::MAX_BATCH_SIZE = 64;
+const int ScriptAlgo::SIZE_OF_INTEGER = sizeof(quint16);
+const int ScriptAlgo::SIZE_OF_FLOAT = sizeof(float);
+
+ScriptAlgo::ScriptAlgo(const QString &path, QObject *parent)
+    : QObject(parent),
+      m_path(path),
+      m_batch(QVector<Command>()),
+      m_numHandedOver(0),
+      m_engine(nullptr),
+      m_isInterrupted(false),
+      m_isHandshakeResolved(false),
+      m_isHandshakeAccepted(false),
+      m_numAllowed(0),
+      m_responses(QByteArray()) {}
+
+bool ScriptAlgo::isScript(const QString &command) {
+  return command.trimmed().endsWith(".js", Qt::CaseInsensitive);
+}
+
+void ScriptAlgo::run() {
+  QFile file(m_path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    log(QString("Couldn't open %1: %2").arg(m_path, file.errorString()));
+    emit finished(1);
+    return;
+  }
+  QString program = QString::fromUtf8(file.readAll());
+
+  QJSEngine engine;
+  {
+    QMutexLocker locker(&m_mutex);
+    m_engine = &engine;
+    engine.setInterrupted(m_isInterrupted);
+  }
+
+  // Each function of the API is also a global, so that scripts read just like
+  // algos that print their commands; the engine must not delete the algo
+  QJSEngine::setObjectOwnership(this, QJSEngine::CppOwnership);
+  QJSValue api = engine.newQObject(this);
+  const QMetaObject *metaObject = this->metaObject();
+  for (int i = metaObject->methodOffset(); i < metaObject->methodCount();
+       i += 1) {
+    QMetaMethod method = metaObject->method(i);
+    if (method.methodType() == QMetaMethod::Method) {
+      QString name = QString::fromLatin1(method.name());
+      engine.globalObject().setProperty(name, api.property(name));
+    }
+  }
+
+  int exitCode = 1;
+  if (handshake()) {
+    QJSValue result = engine.evaluate(program, m_path);
+    exitCode = result.isError() ? 1 : 0;
+    if (result.isError() && !engine.isInterrupted()) {
+      log(QString("%1:%2: %3")
+              .arg(m_path)
+              .arg(result.property("lineNumber").toInt())
+              .arg(result.toString()));
+    }
+    // Whatever the script did last still takes effect
+    flush();
+  }
+
+  bool isInterrupted = false;
+  {
+    QMutexLocker locker(&m_mutex);
+    m_engine = nullptr;
+    isInterrupted = m_isInterrupted;
+  }
+  if (!isInterrupted) {
+    emit finished(exitCode);
+  }
+}
+
+void ScriptAlgo::interrupt() {
+  QMutexLocker locker(&m_mutex);
+  m_isInterrupted = true;
+  if (m_engine != nullptr) {
+    m_engine->setInterrupted(true);
+  }
+  m_condition.wakeAll();
+}
+
+void ScriptAlgo::resolveHandshake(bool accepted) {
+  QMutexLocker locker(&m_mutex);
+  m_isHandshakeResolved = true;
+  m_isHandshakeAccepted = accepted;
+  m_condition.wakeAll();
+}
+
+void ScriptAlgo::allowCommands(qint64 numAllowed) {
+  QMutexLocker locker(&m_mutex);
+  if (m_numAllowed < numAllowed) {
+    m_numAllowed = numAllowed;
+    m_condition.wakeAll();
+  }
+}
+
+void ScriptAlgo::addResponses(const QByteArray &bytes) {
+  QMutexLocker locker(&m_mutex);
+  m_responses.append(bytes);
+  m_condition.wakeAll();
+}
+
+int ScriptAlgo::mazeWidth() {
+  return queryInteger(CommandType::MAZE_WIDTH, 0);
+}
+
+int ScriptAlgo::mazeHeight() {
+  return queryInteger(CommandType::MAZE_HEIGHT, 0);
+}
+
+bool ScriptAlgo::wallFront(int halfStepsAway) {
+  return query(CommandType::WALL_FRONT, halfStepsAway);
+}
+
+bool ScriptAlgo::wallRight(int halfStepsAway) {
+  return query(CommandType::WALL_RIGHT, halfStepsAway);
+}
+
+bool ScriptAlgo::wallLeft(int halfStepsAway) {
+  return query(CommandType::WALL_LEFT, halfStepsAway);
+}
+
+bool ScriptAlgo::wallBack(int halfStepsAway) {
+  return query(CommandType::WALL_BACK, halfStepsAway);
+}
+
+bool ScriptAlgo::wallFrontRight(int halfStepsAway) {
+  return query(CommandType::WALL_FRONT_RIGHT, halfStepsAway);
+}
+
+bool ScriptAlgo::wallFrontLeft(int halfStepsAway) {
+  return query(CommandType::WALL_FRONT_LEFT, halfStepsAway);
+}
+
+bool ScriptAlgo::wallBackRight(int halfStepsAway) {
+  return query(CommandType::WALL_BACK_RIGHT, halfStepsAway);
+}
+
+bool ScriptAlgo::wallBackLeft(int halfStepsAway) {
+  return query(CommandType::WALL_BACK_LEFT, halfStepsAway);
+}
+
+int ScriptAlgo::walls(int halfStepsAway) {
+  return queryInteger(CommandType::WALLS, halfStepsAway);
+}
+
+bool ScriptAlgo::moveForward(int distance) {
+  return move(CommandType::MOVE_FORWARD, distance);
+}
+
+bool ScriptAlgo::moveForwardHalf(int numHalfSteps) {
+  return move(CommandType::MOVE_FORWARD_HALF, numHalfSteps);
+}
+
+bool ScriptAlgo::turnRight() { return move(CommandType::TURN_RIGHT_90, 0); }
+
+bool ScriptAlgo::turnLeft() { return move(CommandType::TURN_LEFT_90, 0); }
+
+bool ScriptAlgo::turnRight45() { return move(CommandType::TURN_RIGHT_45, 0); }
+
+bool ScriptAlgo::turnLeft45() { return move(CommandType::TURN_LEFT_45, 0); }
+
+void ScriptAlgo::setWall(int x, int y, const QString &direction) {
+  annotate(CommandType::SET_WALL, x, y, direction);
+}
+
+void ScriptAlgo::clearWall(int x, int y, const QString &direction) {
+  annotate(CommandType::CLEAR_WALL, x, y, direction);
+}
+
+void ScriptAlgo::setColor(int x, int y, const QString &color) {
+  annotate(CommandType::SET_COLOR, x, y, color);
+}
+
+void ScriptAlgo::clearColor(int x, int y) {
+  annotate(CommandType::CLEAR_COLOR, x, y, " ");
+}
+
+void ScriptAlgo::clearAllColor() {
+  annotate(CommandType::CLEAR_ALL_COLOR, 0, 0, " ");
+}
+
+void ScriptAlgo::setText(int x, int y, const QString &text) {
+  Command command = {CommandType::SET_TEXT};
+  command.x = x;
+  command.y = y;
+  command.text = text;
+  submit(command, 0);
+}
+
+void ScriptAlgo::clearText(int x, int y) {
+  annotate(CommandType::CLEAR_TEXT, x, y, " ");
+}
+
+void ScriptAlgo::clearAllText() {
+  annotate(CommandType::CLEAR_ALL_TEXT, 0, 0, " ");
+}
+
+bool ScriptAlgo::wasReset() { return query(CommandType::WAS_RESET, 0); }
+
+void ScriptAlgo::ackReset() { move(CommandType::ACK_RESET, 0); }
+
+double ScriptAlgo::getStat(const QString &name) {
+  if (!STRING_TO_STAT().contains(name)) {
+    return -1.0;
+  }
+  Command command = {CommandType::GET_STAT};
+  command.stat = STRING_TO_STAT().value(name);
+  QByteArray response = submit(command, SIZE_OF_FLOAT);
+  if (response.size() != SIZE_OF_FLOAT) {
+    return -1.0;
+  }
+  return qFromLittleEndian<float>(response.constData());
+}
+
+void ScriptAlgo::metric(const QString &name, double value) {
+  Command command = {CommandType::METRIC};
+  command.text = name;
+  command.value = value;
+  submit(command, 0);
+}
+
+void ScriptAlgo::log(const QString &text) {
+  emit standardErrorRead(text.toUtf8() + '\n');
+}
+
+bool ScriptAlgo::handshake() {
+  // As with a process, nothing is handed over until something is allowed
+  QMutexLocker locker(&m_mutex);
+  while (!m_isInterrupted && m_numAllowed <= m_numHandedOver) {
+    m_condition.wait(&m_mutex);
+  }
+  if (m_isInterrupted) {
+    return false;
+  }
+  locker.unlock();
+  emit commandsParsed({}, CommandParser::Status::HANDSHAKE);
+  locker.relock();
+  while (!m_isInterrupted && !m_isHandshakeResolved) {
+    m_condition.wait(&m_mutex);
+  }
+  if (m_isInterrupted) {
+    return false;
+  }
+  // The acknowledgment is the only response that was in the text protocol
+  m_responses.clear();
+  if (!m_isHandshakeAccepted) {
+    locker.unlock();
+    log("The simulation didn't accept the binary protocol");
+    return false;
+  }
+  return true;
+}
+
+QByteArray ScriptAlgo::submit(const Command &command, int responseSize) {
+  m_batch.append(command);
+  if (responseSize == 0 && m_batch.size() < MAX_BATCH_SIZE) {
+    return QByteArray();
+  }
+  if (!flush() || responseSize == 0) {
+    return QByteArray();
+  }
+  QMutexLocker locker(&m_mutex);
+  while (!m_isInterrupted && m_responses.size() < responseSize) {
+    m_condition.wait(&m_mutex);
+  }
+  if (m_isInterrupted) {
+    return QByteArray();
+  }
+  QByteArray response = m_responses.left(responseSize);
+  m_responses.remove(0, responseSize);
+  return response;
+}
+
+bool ScriptAlgo::flush() {
+  int start = 0;
+  while (start < m_batch.size()) {
+    qint64 room = 0;
+    {
+      QMutexLocker locker(&m_mutex);
+      while (!m_isInterrupted && m_numAllowed <= m_numHandedOver) {
+        m_condition.wait(&m_mutex);
+      }
+      if (m_isInterrupted) {
+        m_batch.clear();
+        return false;
+      }
+      room = m_numAllowed - m_numHandedOver;
+    }
+    int count = static_cast<int>(qMin<qint64>(room, m_batch.size() - start));
+    m_numHandedOver += count;
+    emit commandsParsed(m_batch.mid(start, count),
+                        CommandParser::Status::NONE);
+    start += count;
+  }
+  m_batch.clear();
+  return true;
+}
+
+bool ScriptAlgo::query(CommandType type, int n) {
+  Command command = {type};
+  command.n = n;
+  return submit(command, 1) == QByteArray(1, BinaryProtocol::RESPONSE_TRUE);
+}
+
+int ScriptAlgo::queryInteger(CommandType type, int n) {
+  Command command = {type};
+  command.n = n;
+  QByteArray response = submit(command, SIZE_OF_INTEGER);
+  if (response.size() != SIZE_OF_INTEGER) {
+    return 0;
+  }
+  return qFromLittleEndian<quint16>(response.constData());
+}
+
+bool ScriptAlgo::move(CommandType type, int n) {
+  Command command = {type};
+  command.n = n;
+  return submit(command, 1) == QByteArray(1, BinaryProtocol::RESPONSE_ACK);
+}
+
+void ScriptAlgo::annotate(CommandType type, int x, int y, const QString &c) {
+  Command command = {type};
+  command.x = x;
+  command.y = y;
+  command.c = c.isEmpty() ? QChar() : c.at(0);
+  submit(command, 0);
+}
+
+}  // namespace mms
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJSEngine>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "Command.h"
+#include "CommandParser.h"
+
+namespace mms {
+
+// An algo written in JavaScript, run in-process by a QJSEngine instead of as
+// a process of its own, so that nothing is printed, piped, or parsed. The API
+// is that of the text protocol, as global functions that return the response
+// directly, e.g., "if (!wallFront()) { moveForward(); }", plus log, which
+// writes a line to the run's output.
+//
+// The script runs on an AlgoChannel's thread, and hands over its commands
+// just as the channel does for a process, with the same handshake and flow
+// control, so the simulation can't tell the two apart; responses come back
+// in the binary protocol, which needs no parsing. The script blocks its
+// thread while it waits for each response, so everything that the channel
+// would otherwise queue onto that thread is handed over under a lock.
+class ScriptAlgo : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit ScriptAlgo(const QString &path, QObject *parent = nullptr);
+
+  // Whether a run command is just the path of a script, relative to the
+  // algo's directory
+  static bool isScript(const QString &command);
+
+  // Runs the script to completion on the calling thread, then emits finished
+  // with 0, or with 1 if it threw, unless it was interrupted
+  void run();
+
+  // These may be called from any thread (see AlgoChannel)
+  void interrupt();
+  void resolveHandshake(bool accepted);
+  void allowCommands(qint64 numAllowed);
+  void addResponses(const QByteArray &bytes);
+
+  // The API, which is only ever called by the script
+  Q_INVOKABLE int mazeWidth();
+  Q_INVOKABLE int mazeHeight();
+  Q_INVOKABLE bool wallFront(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallRight(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallLeft(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallBack(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallFrontRight(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallFrontLeft(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallBackRight(int halfStepsAway = 1);
+  Q_INVOKABLE bool wallBackLeft(int halfStepsAway = 1);
+  Q_INVOKABLE int walls(int halfStepsAway = 1);
+  Q_INVOKABLE bool moveForward(int distance = 1);
+  Q_INVOKABLE bool moveForwardHalf(int numHalfSteps = 1);
+  Q_INVOKABLE bool turnRight();
+  Q_INVOKABLE bool turnLeft();
+  Q_INVOKABLE bool turnRight45();
+  Q_INVOKABLE bool turnLeft45();
+  Q_INVOKABLE void setWall(int x, int y, const QString &direction);
+  Q_INVOKABLE void clearWall(int x, int y, const QString &direction);
+  Q_INVOKABLE void setColor(int x, int y, const QString &color);
+  Q_INVOKABLE void clearColor(int x, int y);
+  Q_INVOKABLE void clearAllColor();
+  Q_INVOKABLE void setText(int x, int y, const QString &text);
+  Q_INVOKABLE void clearText(int x, int y);
+  Q_INVOKABLE void clearAllText();
+  Q_INVOKABLE bool wasReset();
+  Q_INVOKABLE void ackReset();
+  Q_INVOKABLE double getStat(const QString &name);
+  Q_INVOKABLE void metric(const QString &name, double value);
+  Q_INVOKABLE void log(const QString &text);
+
+ signals:
+  void commandsParsed(const QVector<Command> &commands,
+                      CommandParser::Status status);
+  void standardErrorRead(const QByteArray &bytes);
+  void finished(int exitCode);
+
+ private:
+  // Commands without a response are handed over together, up to this many
+  static const int MAX_BATCH_SIZE;
+
+  // The widths of the responses that aren't a single byte
+  static const int SIZE_OF_INTEGER;
+  static const int SIZE_OF_FLOAT;
+
+  QString m_path;
+
+  // Only touched by the script
+  QVector<Command> m_batch;
+  qint64 m_numHandedOver;
+
+  // Shared with the channel, under the lock
+  QMutex m_mutex;
+  QWaitCondition m_condition;
+  QJSEngine *m_engine;  // only while the script runs
+  bool m_isInterrupted;
+  bool m_isHandshakeResolved;
+  bool m_isHandshakeAccepted;
+  qint64 m_numAllowed;
+  QByteArray m_responses;
+
+  bool handshake();
+
+  // Hands over the command, or adds it to the batch if it has no response, and
+  // returns the response, which is empty if there is none or if interrupted
+  QByteArray submit(const Command &command, int responseSize);
+
+  // Hands over the batch, as the room allows; returns false if interrupted
+  bool flush();
+
+  bool query(CommandType type, int n);
+  int queryInteger(CommandType type, int n);
+  bool move(CommandType type, int n);
+  void annotate(CommandType type, int x, int y, const QString &c);
+};
+
+}  // namespace mms
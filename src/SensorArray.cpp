@@ -0,0 +1,146 @@
+#include "SensorArray.h"
+
+#include <limits>
+
+#include <QtMath>
+
+#include "Dimensions.h"
+
+namespace mms {
+
+const int SensorArray::MAX_SENSORS = 16;
+const quint32 SensorArray::NOISE_SUBSTREAM = 0;
+
+SensorArray::SensorArray()
+    : m_sensors(getDefaultSensors()),
+      m_random(RandomStream(0, NOISE_SUBSTREAM)) {}
+
+QVector<Sensor> SensorArray::getDefaultSensors() {
+  auto sensor = [](double forward, double left, double degrees) -> Sensor {
+    return {Distance::Meters(forward), Distance::Meters(left),
+            Angle::Degrees(degrees), Distance::Meters(0.25),
+            Distance::Meters(0.0)};
+  };
+  return {
+      sensor(0.04, 0.02, 0.0),    sensor(0.04, -0.02, 0.0),
+      sensor(0.03, 0.025, 45.0),  sensor(0.03, -0.025, -45.0),
+      sensor(0.0, 0.025, 90.0),   sensor(0.0, -0.025, -90.0),
+  };
+}
+
+void SensorArray::setRandomKey(quint64 key) {
+  m_random = RandomStream(key, NOISE_SUBSTREAM);
+}
+
+bool SensorArray::setSensors(const QVector<Sensor> &sensors) {
+  if (MAX_SENSORS < sensors.size()) {
+    return false;
+  }
+  for (const Sensor &sensor : sensors) {
+    if (sensor.range.getMeters() <= 0.0 || sensor.noise.getMeters() < 0.0) {
+      return false;
+    }
+  }
+  m_sensors = sensors;
+  return true;
+}
+
+const QVector<Sensor> &SensorArray::getSensors() const { return m_sensors; }
+
+QVector<int> SensorArray::read(const Maze *maze, const Coordinate &translation,
+                               const Angle &rotation) {
+  Angle left = rotation + Angle::Degrees(90);
+  QVector<int> readings;
+  readings.reserve(m_sensors.size());
+  for (const Sensor &sensor : m_sensors) {
+    Coordinate mount = translation +
+                       Coordinate::Polar(sensor.forward, rotation) +
+                       Coordinate::Polar(sensor.left, left);
+    double range = sensor.range.getMeters();
+    double meters =
+        castRay(maze, mount, rotation + sensor.rotation, sensor.range)
+            .getMeters();
+    if (meters < range && 0.0 < sensor.noise.getMeters()) {
+      meters += sensor.noise.getMeters() * getGaussian();
+    }
+    readings.append(qRound(1000.0 * qBound(0.0, meters, range)));
+  }
+  return readings;
+}
+
+Distance SensorArray::castRay(const Maze *maze, const Coordinate &origin,
+                              const Angle &direction, const Distance &range) {
+  // The ray is marched in units of tiles, so that grid line i is at i
+  double tileLength = Dimensions::tileLength().getMeters();
+  double x0 = origin.getX().getMeters() / tileLength;
+  double y0 = origin.getY().getMeters() / tileLength;
+  int x = qFloor(x0);
+  int y = qFloor(y0);
+  if (x < 0 || maze->getWidth() <= x || y < 0 || maze->getHeight() <= y) {
+    return Distance::Meters(0.0);
+  }
+
+  // The ray is at x0 + t * dx, y0 + t * dy, and crosses the next vertical
+  // and horizontal grid lines at tNextX and tNextY, which step by tDeltaX
+  // and tDeltaY from one line to the next
+  double infinity = std::numeric_limits<double>::infinity();
+  double dx = direction.getCos();
+  double dy = direction.getSin();
+  double tDeltaX = dx != 0.0 ? 1.0 / qAbs(dx) : infinity;
+  double tDeltaY = dy != 0.0 ? 1.0 / qAbs(dy) : infinity;
+  double tNextX = 0.0 < dx   ? (x + 1 - x0) * tDeltaX
+                  : dx < 0.0 ? (x0 - x) * tDeltaX
+                             : infinity;
+  double tNextY = 0.0 < dy   ? (y + 1 - y0) * tDeltaY
+                  : dy < 0.0 ? (y0 - y) * tDeltaY
+                             : infinity;
+  Direction directionX = 0.0 < dx ? Direction::EAST : Direction::WEST;
+  Direction directionY = 0.0 < dy ? Direction::NORTH : Direction::SOUTH;
+
+  // Everything on a grid line (see Tile::initPolygons) is within half a
+  // wall's width of it, so a line is blocked where it's crossed if there's a
+  // wall there, or if the crossing is that close to a post, and the face
+  // that's hit is that much closer than the line, though never closer than
+  // where the ray entered the tile
+  double halfWallWidth = Dimensions::halfWallWidth().getMeters() / tileLength;
+  double maxT = range.getMeters() / tileLength;
+  double tEntry = 0.0;
+  while (true) {
+    bool isCrossingX = tNextX < tNextY;
+    double t = isCrossingX ? tNextX : tNextY;
+    double tDelta = isCrossingX ? tDeltaX : tDeltaY;
+    double tFace = qMax(tEntry, t - halfWallWidth * tDelta);
+    if (maxT < tFace) {
+      break;
+    }
+    double crossing = isCrossingX ? y0 + t * dy : x0 + t * dx;
+    bool isBlocked =
+        qAbs(crossing - qRound(crossing)) < halfWallWidth ||
+        maze->isWall(x, y, isCrossingX ? directionX : directionY);
+    if (isBlocked) {
+      return Distance::Meters(tFace * tileLength);
+    }
+    tEntry = t;
+    if (isCrossingX) {
+      x += 0.0 < dx ? 1 : -1;
+      tNextX += tDeltaX;
+    } else {
+      y += 0.0 < dy ? 1 : -1;
+      tNextY += tDeltaY;
+    }
+    if (x < 0 || maze->getWidth() <= x || y < 0 || maze->getHeight() <= y) {
+      break;  // only possible if the maze isn't enclosed
+    }
+  }
+  return range;
+}
+
+double SensorArray::getGaussian() {
+  // The Box-Muller transform, of a uniform sample in (0, 1] so that its
+  // logarithm is finite
+  double u1 = 1.0 - m_random.generateDouble();
+  double u2 = m_random.generateDouble();
+  return qSqrt(-2.0 * qLn(u1)) * qCos(2.0 * M_PI * u2);
+}
+
+}  // namespace mms
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QVector>
+
+#include "Maze.h"
+#include "RandomStream.h"
+#include "units/Angle.h"
+#include "units/Coordinate.h"
+#include "units/Distance.h"
+
+namespace mms {
+
+// An IR distance sensor, as mounted on the mouse. The mounting is relative to
+// the mouse's center and heading, so it's the same no matter where the mouse
+// is or which way it faces.
+struct Sensor {
+  Distance forward;  // ahead of the center, or behind if negative
+  Distance left;     // to the left of the center, or right if negative
+  Angle rotation;    // counterclockwise from the heading
+  Distance range;    // beyond which nothing is seen
+  Distance noise;    // the standard deviation of the readings
+};
+
+// The distance sensors of a mouse. Each reading is the distance along the
+// sensor's ray to the nearest wall or post, found by marching the ray across
+// the tiles that it passes through (a DDA) and stopping at the first grid
+// line that's blocked where it's crossed, so a reading costs a handful of
+// wall lookups, no matter how large the maze is or how far the sensor sees.
+class SensorArray {
+ public:
+  // The sensors of a typical mouse, see getDefaultSensors
+  SensorArray();
+
+  // A pair of sensors facing forward, a pair facing diagonally forward, and
+  // a pair facing the sides, in that order, left before right
+  static QVector<Sensor> getDefaultSensors();
+
+  // Returns false, and leaves the sensors unchanged, if there are more than
+  // MAX_SENSORS of them or any has a nonpositive range or a negative noise
+  static const int MAX_SENSORS;
+  bool setSensors(const QVector<Sensor> &sensors);
+  const QVector<Sensor> &getSensors() const;
+
+  // The reading of each sensor, in millimeters, for the mouse at the given
+  // pose; a sensor that sees nothing reads its range. Noise is drawn from a
+  // stream of the key (see RandomStream), zero unless it's set, so runs with
+  // the same key read identically.
+  void setRandomKey(quint64 key);
+  QVector<int> read(const Maze *maze, const Coordinate &translation,
+                    const Angle &rotation);
+
+  // The distance from the origin along the direction to the nearest wall or
+  // post, or the range if there's none within it; zero if the origin is
+  // outside of the maze
+  static Distance castRay(const Maze *maze, const Coordinate &origin,
+                          const Angle &direction, const Distance &range);
+
+ private:
+  static const quint32 NOISE_SUBSTREAM;
+
+  QVector<Sensor> m_sensors;
+  RandomStream m_random;
+
+  // A sample of the standard normal distribution
+  double getGaussian();
+};
+
+}  // namespace mms
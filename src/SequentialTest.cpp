@@ -0,0 +1,91 @@
+#include "SequentialTest.h"
+
+#include <QtMath>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+// Small enough to be worth detecting, big enough to be detected in a fraction
+// of a corpus of thousands of mazes
+const double SequentialTest::WIN_RATE = 0.6;
+
+SequentialTest::SequentialTest(double confidence)
+    : m_upperBound(0.0),
+      m_lowerBound(0.0),
+      m_wins(0),
+      m_losses(0),
+      m_ties(0),
+      m_decision(Decision::UNDECIDED) {
+  ASSERT_LT(0.5, confidence);
+  ASSERT_LT(confidence, 1.0);
+
+  // Wald's bounds, with the false positives split between the two sides
+  double alpha = (1.0 - confidence) / 2.0;
+  double beta = 1.0 - confidence;
+  m_upperBound = qLn((1.0 - beta) / alpha);
+  m_lowerBound = qLn(beta / (1.0 - alpha));
+}
+
+void SequentialTest::add(double difference) {
+  if (isDecided()) {
+    return;
+  }
+  if (difference < 0.0) {
+    m_wins += 1;
+  } else if (0.0 < difference) {
+    m_losses += 1;
+  } else {
+    m_ties += 1;
+    return;
+  }
+  double first = getLogLikelihoodRatio(m_wins, m_losses);
+  double second = getLogLikelihoodRatio(m_losses, m_wins);
+  if (m_upperBound <= first) {
+    m_decision = Decision::FIRST_BETTER;
+  } else if (m_upperBound <= second) {
+    m_decision = Decision::SECOND_BETTER;
+  } else if (first <= m_lowerBound && second <= m_lowerBound) {
+    m_decision = Decision::NO_DIFFERENCE;
+  }
+}
+
+SequentialTest::Decision SequentialTest::getDecision() const {
+  return m_decision;
+}
+
+bool SequentialTest::isDecided() const {
+  return m_decision != Decision::UNDECIDED;
+}
+
+QString SequentialTest::getDescription() const {
+  QString decision;
+  switch (m_decision) {
+    case Decision::UNDECIDED:
+      decision = "undecided";
+      break;
+    case Decision::FIRST_BETTER:
+      decision = "first better";
+      break;
+    case Decision::SECOND_BETTER:
+      decision = "second better";
+      break;
+    case Decision::NO_DIFFERENCE:
+      decision = "no difference";
+      break;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+  return QString("%1 after %2 mazes (%3 wins, %4 losses, %5 ties)")
+      .arg(decision)
+      .arg(m_wins + m_losses + m_ties)
+      .arg(m_wins)
+      .arg(m_losses)
+      .arg(m_ties);
+}
+
+double SequentialTest::getLogLikelihoodRatio(int wins, int losses) {
+  return wins * qLn(2.0 * WIN_RATE) + losses * qLn(2.0 * (1.0 - WIN_RATE));
+}
+
+}  // namespace mms
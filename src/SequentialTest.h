@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QString>
+
+namespace mms {
+
+// A sequential probability ratio test of whether the first of two algos is
+// better than the second, fed one maze at a time, so that an A/B comparison
+// can stop as soon as the mazes so far are conclusive rather than running the
+// whole corpus. Each maze is a win for whichever algo scored lower on it, or a
+// tie, which is left out; the test decides between the algos winning equally
+// often and either of them winning at least WIN_RATE of the mazes, and is
+// wrong about as often as the confidence allows. Being a sign test, it
+// doesn't care how large a difference is, so a few mazes that an algo can't
+// solve at all can't swamp the rest.
+class SequentialTest {
+ public:
+  enum class Decision {
+    UNDECIDED,
+    FIRST_BETTER,
+    SECOND_BETTER,
+    NO_DIFFERENCE,
+  };
+
+  // The confidence must be in (0.5, 1)
+  explicit SequentialTest(double confidence);
+
+  // The difference is the first algo's score minus the second's, i.e.,
+  // negative if the first did better; once decided, further mazes are ignored
+  void add(double difference);
+
+  Decision getDecision() const;
+  bool isDecided() const;
+
+  // E.g., "first better after 120 mazes (70 wins, 40 losses, 10 ties)"
+  QString getDescription() const;
+
+ private:
+  static const double WIN_RATE;
+
+  double m_upperBound;
+  double m_lowerBound;
+  int m_wins;
+  int m_losses;
+  int m_ties;
+  Decision m_decision;
+
+  // Of either algo being better, vs. the algos winning equally often
+  static double getLogLikelihoodRatio(int wins, int losses);
+};
+
+}  // namespace mms
@@ -8,6 +8,7 @@
 namespace mms {
 
 Settings *Settings::INSTANCE = nullptr;
+const int Settings::FLUSH_DELAY_MILLISECONDS = 500;
 
 void Settings::init() {
   ASSERT_TR(INSTANCE == nullptr);
@@ -20,24 +21,29 @@ Settings *Settings::get() {
 }
 
 QString Settings::value(QString group, QString key) {
-  QSettings settings;
-  settings.beginGroup(group);
-  return settings.value(key).toString();
+  return getValues(group)->value(key);
 }
 
 void Settings::update(QString group, QString key, QString value) {
-  QSettings settings;
-  settings.beginGroup(group);
-  settings.setValue(key, value);
+  QMap<QString, QString> *values = getValues(group);
+  if (values->contains(key) && values->value(key) == value) {
+    return;
+  }
+  values->insert(key, value);
+  markValuesDirty(group);
 }
 
 QStringList Settings::values(QString group, QString key) {
-  QStringList values;
-  for (const auto &entry : getGroup(group)) {
-    values << entry.value(key);
+  QHash<QString, QStringList> &sortedValues = m_sortedValues[group];
+  if (!sortedValues.contains(key)) {
+    QStringList values;
+    for (const auto &entry : *getGroup(group)) {
+      values << entry.value(key);
+    }
+    values.sort(Qt::CaseInsensitive);
+    sortedValues.insert(key, values);
   }
-  values.sort(Qt::CaseInsensitive);
-  return values;
+  return sortedValues.value(key);
 }
 
 void Settings::add(QString group, QMap<QString, QString> entry) {
@@ -45,19 +51,8 @@ void Settings::add(QString group, QMap<QString, QString> entry) {
   ASSERT_FA(group.isEmpty());
   ASSERT_FA(entry.isEmpty());
 
-  // Get the current size
-  QSettings settings;
-  int size = settings.beginReadArray(group);
-  settings.endArray();
-
-  // Append the element at the current size
-  settings.beginWriteArray(group);
-  settings.setArrayIndex(size);
-  QMap<QString, QString>::const_iterator it;
-  for (it = entry.constBegin(); it != entry.constEnd(); it += 1) {
-    settings.setValue(it.key(), it.value());
-  }
-  settings.endArray();
+  getGroup(group)->append(entry);
+  markGroupDirty(group);
 }
 
 void Settings::remove(QString group, QString key, QString value) {
@@ -65,27 +60,18 @@ void Settings::remove(QString group, QString key, QString value) {
   ASSERT_FA(group.isEmpty());
   ASSERT_FA(key.isEmpty());
 
-  // Get all existing entries
-  QVector<QMap<QString, QString>> entries = getGroup(group);
-
-  // Remove all existing entries
-  QSettings settings;
-  settings.remove(group);
-
-  // Write back entries that don't have value given
-  settings.beginWriteArray(group);
-  int index = 0;
-  for (const auto &entry : entries) {
+  // Keep the entries that don't have the given value
+  QVector<QMap<QString, QString>> *entries = getGroup(group);
+  QVector<QMap<QString, QString>> remaining;
+  for (const auto &entry : *entries) {
     if (entry.value(key) != value) {
-      settings.setArrayIndex(index);
-      QMap<QString, QString>::const_iterator it;
-      for (it = entry.constBegin(); it != entry.constEnd(); it += 1) {
-        settings.setValue(it.key(), it.value());
-      }
-      index += 1;
+      remaining.append(entry);
     }
   }
-  settings.endArray();
+  if (remaining.size() != entries->size()) {
+    *entries = remaining;
+    markGroupDirty(group);
+  }
 }
 
 QVector<QMap<QString, QString>> Settings::find(QString group, QString key,
@@ -96,7 +82,7 @@ QVector<QMap<QString, QString>> Settings::find(QString group, QString key,
 
   // Find entries that match the criteria
   QVector<QMap<QString, QString>> entries;
-  for (const auto &entry : getGroup(group)) {
+  for (const auto &entry : *getGroup(group)) {
     if (entry.value(key) == value) {
       entries.append(entry);
     }
@@ -104,52 +90,141 @@ QVector<QMap<QString, QString>> Settings::find(QString group, QString key,
   return entries;
 }
 
+const QMap<QString, QString> *Settings::findFirst(QString group, QString key,
+                                                QString value) {
+  // Group and key must be nonempty
+  ASSERT_FA(group.isEmpty());
+  ASSERT_FA(key.isEmpty());
+
+  const QVector<QMap<QString, QString>> *entries = getGroup(group);
+  QHash<QString, QHash<QString, int>> &firstIndices = m_firstIndices[group];
+  if (!firstIndices.contains(key)) {
+    // Iterate backwards, so that earlier entries take precedence
+    QHash<QString, int> indices;
+    for (int i = entries->size() - 1; 0 <= i; i -= 1) {
+      indices.insert(entries->at(i).value(key), i);
+    }
+    firstIndices.insert(key, indices);
+  }
+  int index = firstIndices.value(key).value(value, -1);
+  return index == -1 ? nullptr : &entries->at(index);
+}
+
 void Settings::update(QString group, QString key, QString value,
                       QMap<QString, QString> changes) {
   // Group and key must be nonempty
   ASSERT_FA(group.isEmpty());
   ASSERT_FA(key.isEmpty());
 
-  // Find the entries to update
-  QVector<QMap<QString, QString>> entries = find(group, key, value);
+  // Update the matching entries in place
+  for (auto &entry : *getGroup(group)) {
+    if (entry.value(key) == value) {
+      QMap<QString, QString>::const_iterator it;
+      for (it = changes.constBegin(); it != changes.constEnd(); it += 1) {
+        entry[it.key()] = it.value();
+      }
+      markGroupDirty(group);
+    }
+  }
+}
 
-  // Remove those entries
-  remove(group, key, value);
+void Settings::flush() {
+  m_flushTimer.stop();
+  if (m_dirtyValues.isEmpty() && m_dirtyGroups.isEmpty()) {
+    return;
+  }
 
-  // Re-add the entries, but with updates
-  for (QMap<QString, QString> entry : entries) {
+  // Every change is written with a single QSettings, and sync() replaces the
+  // backing file as a whole, so a crash never leaves it half written
+  QSettings settings;
+  for (const QString &group : m_dirtyValues) {
+    settings.beginGroup(group);
+    const QMap<QString, QString> &values = m_values.value(group);
     QMap<QString, QString>::const_iterator it;
-    for (it = changes.constBegin(); it != changes.constEnd(); it += 1) {
-      entry[it.key()] = it.value();
+    for (it = values.constBegin(); it != values.constEnd(); it += 1) {
+      settings.setValue(it.key(), it.value());
+    }
+    settings.endGroup();
+  }
+  for (const QString &group : m_dirtyGroups) {
+    const QVector<QMap<QString, QString>> &entries = m_groups.value(group);
+    settings.remove(group);
+    settings.beginWriteArray(group, entries.size());
+    for (int i = 0; i < entries.size(); i += 1) {
+      settings.setArrayIndex(i);
+      QMap<QString, QString>::const_iterator it;
+      for (it = entries.at(i).constBegin(); it != entries.at(i).constEnd();
+           it += 1) {
+        settings.setValue(it.key(), it.value());
+      }
     }
-    add(group, entry);
+    settings.endArray();
   }
+  settings.sync();
+  m_dirtyValues.clear();
+  m_dirtyGroups.clear();
 }
 
 Settings::Settings() {
   QCoreApplication::setOrganizationName("mackorone");
   QCoreApplication::setOrganizationDomain("www.github.com/mackorone");
   QCoreApplication::setApplicationName("mms");
+
+  // Changes are batched, and whatever is still pending at exit is written
+  m_flushTimer.setSingleShot(true);
+  m_flushTimer.setInterval(FLUSH_DELAY_MILLISECONDS);
+  QObject::connect(&m_flushTimer, &QTimer::timeout, [=]() { flush(); });
+  QObject::connect(QCoreApplication::instance(),
+                   &QCoreApplication::aboutToQuit, [=]() { flush(); });
 }
 
-QVector<QMap<QString, QString>> Settings::getGroup(QString group) {
+QMap<QString, QString> *Settings::getValues(QString group) {
+  if (!m_values.contains(group)) {
+    QMap<QString, QString> values;
+    QSettings settings;
+    settings.beginGroup(group);
+    for (QString key : settings.childKeys()) {
+      values[key] = settings.value(key).toString();
+    }
+    settings.endGroup();
+    m_values.insert(group, values);
+  }
+  return &m_values[group];
+}
+
+QVector<QMap<QString, QString>> *Settings::getGroup(QString group) {
   // Group must be nonempty
   ASSERT_FA(group.isEmpty());
 
   // Get all entries for a given group
-  QVector<QMap<QString, QString>> entries;
-  QSettings settings;
-  int size = settings.beginReadArray(group);
-  for (int i = 0; i < size; i += 1) {
-    settings.setArrayIndex(i);
-    QMap<QString, QString> map;
-    for (QString key : settings.allKeys()) {
-      map[key] = settings.value(key).toString();
+  if (!m_groups.contains(group)) {
+    QVector<QMap<QString, QString>> entries;
+    QSettings settings;
+    int size = settings.beginReadArray(group);
+    for (int i = 0; i < size; i += 1) {
+      settings.setArrayIndex(i);
+      QMap<QString, QString> map;
+      for (QString key : settings.allKeys()) {
+        map[key] = settings.value(key).toString();
+      }
+      entries.append(map);
     }
-    entries.append(map);
+    settings.endArray();
+    m_groups.insert(group, entries);
   }
-  settings.endArray();
-  return entries;
+  return &m_groups[group];
+}
+
+void Settings::markValuesDirty(QString group) {
+  m_dirtyValues.insert(group);
+  m_flushTimer.start();
+}
+
+void Settings::markGroupDirty(QString group) {
+  m_sortedValues.remove(group);
+  m_firstIndices.remove(group);
+  m_dirtyGroups.insert(group);
+  m_flushTimer.start();
 }
 
 }  // namespace mms
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <QHash>
 #include <QMap>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 #include <QVector>
 
 namespace mms {
 
+// Each group is read from the backing store the first time that it's used,
+// and is then held in memory, so reads never touch the disk. Changes are
+// applied in memory immediately and written behind: all of the changes made
+// within a short window are written together, and any that are still pending
+// are written when the application quits.
 class Settings {
  public:
   static void init();
@@ -32,16 +40,47 @@ class Settings {
   QVector<QMap<QString, QString>> find(QString group, QString key,
                                        QString value);
 
+  // Returns the first entry in group with value for key, or nullptr if there
+  // isn't one. This is a hash lookup, and the entry isn't copied, but it's
+  // only valid until the group is next changed.
+  const QMap<QString, QString> *findFirst(QString group, QString key,
+                                          QString value);
+
   // Updates all entries in group with value for key
   void update(QString group, QString key, QString value,
               QMap<QString, QString> changes);
 
+  // Writes any pending changes to the backing store now
+  void flush();
+
  private:
   Settings();
   static Settings *INSTANCE;
 
+  // How long to wait after a change for more changes, before writing
+  static const int FLUSH_DELAY_MILLISECONDS;
+
+  // The groups that have been read, and those of them that have changed
+  // since they were last written
+  QMap<QString, QMap<QString, QString>> m_values;
+  QMap<QString, QVector<QMap<QString, QString>>> m_groups;
+  QSet<QString> m_dirtyValues;
+  QSet<QString> m_dirtyGroups;
+  QTimer m_flushTimer;
+
+  // Built as needed and discarded whenever their group changes: by group and
+  // key, the sorted values, and the index of the first entry with each value
+  QHash<QString, QHash<QString, QStringList>> m_sortedValues;
+  QHash<QString, QHash<QString, QHash<QString, int>>> m_firstIndices;
+
+  // Returns all values of a given non-array group
+  QMap<QString, QString> *getValues(QString group);
+
   // Returns all entries for a given group
-  QVector<QMap<QString, QString>> getGroup(QString group);
+  QVector<QMap<QString, QString>> *getGroup(QString group);
+
+  void markValuesDirty(QString group);
+  void markGroupDirty(QString group);
 };
 
 }  // namespace mms
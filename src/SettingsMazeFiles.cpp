@@ -12,7 +12,7 @@ QStringList SettingsMazeFiles::getAllPaths() {
 }
 
 void SettingsMazeFiles::addPath(QString path) {
-  if (Settings::get()->find(GROUP, KEY_PATH, path).isEmpty()) {
+  if (Settings::get()->findFirst(GROUP, KEY_PATH, path) == nullptr) {
     Settings::get()->add(GROUP, {{KEY_PATH, path}});
   }
 }
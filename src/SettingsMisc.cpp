@@ -9,6 +9,8 @@ const QString SettingsMisc::KEY_RECENT_MAZE_ALGO = "recent-maze-file";
 const QString SettingsMisc::KEY_RECENT_MOUSE_ALGO = "recent-mouse-algo";
 const QString SettingsMisc::KEY_RECENT_WINDOW_WIDTH = "recent-window-width";
 const QString SettingsMisc::KEY_RECENT_WINDOW_HEIGHT = "recent-window-height";
+const QString SettingsMisc::KEY_COMMAND_TIME_BUDGET_MICROSECONDS =
+    "command-time-budget-us";
 
 QString SettingsMisc::getRecentMazeFile() {
   return getValue(KEY_RECENT_MAZE_ALGO);
@@ -42,6 +44,11 @@ void SettingsMisc::setRecentWindowHeight(int height) {
   setValue(KEY_RECENT_WINDOW_HEIGHT, QString::number(height));
 }
 
+int SettingsMisc::getCommandTimeBudgetMicroseconds() {
+  // A quarter of a frame at 60 FPS, leaving the rest for drawing
+  return qMax(0, getNumber(KEY_COMMAND_TIME_BUDGET_MICROSECONDS, 4000));
+}
+
 int SettingsMisc::getNumber(QString key, int defaultValue) {
   bool ok = true;
   int number = getValue(key).toInt(&ok);
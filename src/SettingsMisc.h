@@ -20,12 +20,17 @@ class SettingsMisc {
   static int getRecentWindowHeight();
   static void setRecentWindowHeight(int height);
 
+  // How long the GUI's simulations may spend processing commands per turn of
+  // the event loop (see Simulation::setTimeBudget), or 0 for no limit
+  static int getCommandTimeBudgetMicroseconds();
+
  private:
   static const QString GROUP;
   static const QString KEY_RECENT_MAZE_ALGO;
   static const QString KEY_RECENT_MOUSE_ALGO;
   static const QString KEY_RECENT_WINDOW_WIDTH;
   static const QString KEY_RECENT_WINDOW_HEIGHT;
+  static const QString KEY_COMMAND_TIME_BUDGET_MICROSECONDS;
 
   static int getNumber(QString key, int defaultValue);
   static QString getValue(const QString &key);
@@ -57,8 +57,8 @@ void SettingsMouseAlgos::remove(const QString &name) {
 }
 
 QString SettingsMouseAlgos::getValue(const QString &name, const QString &key) {
-  const auto &vector = Settings::get()->find(GROUP, KEY_NAME, name);
-  return (vector.size() == 0 ? "" : vector.at(0).value(key));
+  const auto *entry = Settings::get()->findFirst(GROUP, KEY_NAME, name);
+  return (entry == nullptr ? "" : entry->value(key));
 }
 
 }  // namespace mms
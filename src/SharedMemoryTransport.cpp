@@ -0,0 +1,158 @@
+#include "SharedMemoryTransport.h"
+
+#include <QDir>
+#include <cstring>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const char *SharedMemoryTransport::ENVIRONMENT_VARIABLE = "MMS_SHM_PATH";
+
+// Layout (all integers are little-endian quint32):
+//   [0, 64)             magic, capacity
+//   [64, 192 + C)       command ring: head at +0, tail at +64, data at +128
+//   [192 + C, 320 + 2C) response ring: same as above
+// Each head is written only by the producer and each tail only by the
+// consumer; both are free-running, so used = head - tail.
+const quint32 SharedMemoryTransport::MAGIC = 0x31534d4d;  // "MMS1"
+const int SharedMemoryTransport::CAPACITY = 1 << 16;
+const int SharedMemoryTransport::HEADER_SIZE = 64;
+const int SharedMemoryTransport::RING_HEADER_SIZE = 128;
+const int SharedMemoryTransport::MAX_BUSY_POLLS = 1000;
+
+SharedMemoryTransport::SharedMemoryTransport(QObject *parent)
+    : QIODevice(parent),
+      m_file(QDir::temp().filePath("mms-shm-XXXXXX")),
+      m_memory(nullptr),
+      m_pendingWrites(QByteArray()),
+      m_pollTimer(new QTimer(this)),
+      m_idlePolls(0) {
+  connect(m_pollTimer, &QTimer::timeout, this, &SharedMemoryTransport::poll);
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+  if (m_memory != nullptr) {
+    m_file.unmap(m_memory);
+  }
+}
+
+bool SharedMemoryTransport::create() {
+  ASSERT_TR(m_memory == nullptr);
+  int size = HEADER_SIZE + 2 * (RING_HEADER_SIZE + CAPACITY);
+  if (!m_file.open() || !m_file.resize(size)) {
+    return false;
+  }
+  m_memory = m_file.map(0, size);
+  if (m_memory == nullptr) {
+    return false;
+  }
+  std::memset(m_memory, 0, size);
+  atomicAt(m_memory, 4)->store(CAPACITY, std::memory_order_relaxed);
+  // Written last, so that the client can wait for the header to be ready
+  atomicAt(m_memory, 0)->store(MAGIC, std::memory_order_release);
+  open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+  m_pollTimer->start(0);
+  return true;
+}
+
+QString SharedMemoryTransport::path() const { return m_file.fileName(); }
+
+bool SharedMemoryTransport::isSequential() const { return true; }
+
+qint64 SharedMemoryTransport::bytesAvailable() const {
+  if (m_memory == nullptr) {
+    return 0;
+  }
+  return usedBytes(HEADER_SIZE) + QIODevice::bytesAvailable();
+}
+
+qint64 SharedMemoryTransport::readData(char *data, qint64 maxSize) {
+  if (m_memory == nullptr) {
+    return -1;
+  }
+  return readRing(HEADER_SIZE, data, static_cast<int>(maxSize));
+}
+
+qint64 SharedMemoryTransport::writeData(const char *data, qint64 maxSize) {
+  if (m_memory == nullptr) {
+    return -1;
+  }
+  // Preserve ordering with responses that are already waiting
+  m_pendingWrites.append(data, maxSize);
+  flushPendingWrites();
+  return maxSize;
+}
+
+void SharedMemoryTransport::poll() {
+  flushPendingWrites();
+  if (0 < usedBytes(HEADER_SIZE)) {
+    if (m_idlePolls >= MAX_BUSY_POLLS) {
+      m_pollTimer->setInterval(0);
+    }
+    m_idlePolls = 0;
+    emit readyRead();
+  } else if (m_idlePolls < MAX_BUSY_POLLS) {
+    m_idlePolls += 1;
+    if (m_idlePolls == MAX_BUSY_POLLS) {
+      m_pollTimer->setInterval(1);
+    }
+  }
+}
+
+void SharedMemoryTransport::flushPendingWrites() {
+  if (m_pendingWrites.isEmpty()) {
+    return;
+  }
+  int offset = HEADER_SIZE + RING_HEADER_SIZE + CAPACITY;
+  int written =
+      writeRing(offset, m_pendingWrites.constData(), m_pendingWrites.size());
+  m_pendingWrites.remove(0, written);
+}
+
+int SharedMemoryTransport::readRing(int offset, char *data, int maxSize) {
+  std::atomic<quint32> *head = atomicAt(m_memory, offset);
+  std::atomic<quint32> *tail = atomicAt(m_memory, offset + 64);
+  uchar *buffer = m_memory + offset + RING_HEADER_SIZE;
+  quint32 end = head->load(std::memory_order_acquire);
+  quint32 start = tail->load(std::memory_order_relaxed);
+  int size = qMin(static_cast<int>(end - start), maxSize);
+  for (int i = 0; i < size; i += 1) {
+    data[i] = buffer[(start + i) % CAPACITY];
+  }
+  tail->store(start + size, std::memory_order_release);
+  return size;
+}
+
+int SharedMemoryTransport::writeRing(int offset, const char *data, int size) {
+  std::atomic<quint32> *head = atomicAt(m_memory, offset);
+  std::atomic<quint32> *tail = atomicAt(m_memory, offset + 64);
+  uchar *buffer = m_memory + offset + RING_HEADER_SIZE;
+  quint32 start = head->load(std::memory_order_relaxed);
+  quint32 end = tail->load(std::memory_order_acquire);
+  int space = CAPACITY - static_cast<int>(start - end);
+  int written = qMin(space, size);
+  for (int i = 0; i < written; i += 1) {
+    buffer[(start + i) % CAPACITY] = data[i];
+  }
+  head->store(start + written, std::memory_order_release);
+  return written;
+}
+
+std::atomic<quint32> *SharedMemoryTransport::atomicAt(uchar *memory,
+                                                      int offset) {
+  // The algo's client uses C11 atomics on the same memory, which requires the
+  // atomics to be lock-free (and thus address-free)
+  static_assert(ATOMIC_INT_LOCK_FREE == 2,
+                "shared memory requires lock-free atomics");
+  return reinterpret_cast<std::atomic<quint32> *>(memory + offset);
+}
+
+int SharedMemoryTransport::usedBytes(int offset) const {
+  std::atomic<quint32> *head = atomicAt(m_memory, offset);
+  std::atomic<quint32> *tail = atomicAt(m_memory, offset + 64);
+  return static_cast<int>(head->load(std::memory_order_acquire) -
+                          tail->load(std::memory_order_relaxed));
+}
+
+}  // namespace mms
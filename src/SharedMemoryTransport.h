@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QTemporaryFile>
+#include <QTimer>
+#include <atomic>
+
+namespace mms {
+
+// An optional alternative to stdin/stdout for co-located algos. Commands and
+// responses (in the binary protocol) pass through a pair of single-producer,
+// single-consumer ring buffers in a memory-mapped file, whose path is given
+// to the algo in an environment variable. See util/mms-shm.h for the client.
+class SharedMemoryTransport : public QIODevice {
+  Q_OBJECT
+
+ public:
+  static const char *ENVIRONMENT_VARIABLE;
+
+  SharedMemoryTransport(QObject *parent = nullptr);
+  ~SharedMemoryTransport();
+
+  // Creates and maps the backing file, returns false on failure
+  bool create();
+  QString path() const;
+
+  bool isSequential() const override;
+  qint64 bytesAvailable() const override;
+
+ protected:
+  qint64 readData(char *data, qint64 maxSize) override;
+  qint64 writeData(const char *data, qint64 maxSize) override;
+
+ private:
+  // The layout is shared with the client, so it must never change
+  static const quint32 MAGIC;
+  static const int CAPACITY;
+  static const int HEADER_SIZE;
+  static const int RING_HEADER_SIZE;
+  static const int MAX_BUSY_POLLS;
+
+  QTemporaryFile m_file;
+  uchar *m_memory;
+
+  // Responses that didn't fit in the ring, written once there's space
+  QByteArray m_pendingWrites;
+
+  // Cross-process wakeups aren't portable, so poll for commands: eagerly
+  // while the algo is active, then backing off once it goes quiet
+  QTimer *m_pollTimer;
+  int m_idlePolls;
+
+  void poll();
+  void flushPendingWrites();
+
+  // Returns the number of bytes copied
+  int readRing(int offset, char *data, int maxSize);
+  int writeRing(int offset, const char *data, int size);
+  int usedBytes(int offset) const;
+  static std::atomic<quint32> *atomicAt(uchar *memory, int offset);
+};
+
+}  // namespace mms
@@ -1,43 +1,46 @@
 #include "SimUtilities.h"
 
-#include <QDateTime>
+#include <QElapsedTimer>
 
 #include "AssertMacros.h"
+#include "TilePalette.h"
 
 namespace mms {
 
 double SimUtilities::getHighResTimestamp() {
-  return QDateTime::currentDateTime().toMSecsSinceEpoch() / 1000.0;
+  // Monotonic and nanosecond resolution, unlike the wall clock
+  static QElapsedTimer timer;
+  if (!timer.isValid()) {
+    timer.start();
+  }
+  return timer.nsecsElapsed() / 1e9;
 }
 
-QVector<TriangleGraphic> SimUtilities::polygonToTriangleGraphics(
-    const Polygon &polygon, Color color, unsigned char alpha) {
-  QVector<Triangle> triangles = polygon.getTriangles();
-  QVector<TriangleGraphic> triangleGraphics;
-  RGB colorValues = COLOR_TO_RGB().value(color);
-  for (Triangle triangle : triangles) {
-    TriangleGraphic graphic;
-    graphic.p1 = {
-        static_cast<float>(triangle.p1.getX().getMeters()),
-        static_cast<float>(triangle.p1.getY().getMeters()),
-        colorValues,
-        alpha,
-    };
-    graphic.p2 = {
-        static_cast<float>(triangle.p2.getX().getMeters()),
-        static_cast<float>(triangle.p2.getY().getMeters()),
-        colorValues,
-        alpha,
-    };
-    graphic.p3 = {
-        static_cast<float>(triangle.p3.getX().getMeters()),
-        static_cast<float>(triangle.p3.getY().getMeters()),
-        colorValues,
-        alpha,
-    };
-    triangleGraphics.append(graphic);
+void SimUtilities::appendTriangleGraphics(const Polygon &polygon, Color color,
+                                          unsigned char alpha,
+                                          QVector<TriangleGraphic> *buffer) {
+  const QVector<Triangle> triangles = polygon.getTriangles();
+  int paletteIndex = TilePalette::getIndex(color, ThemeColor::NONE);
+  for (const Triangle &triangle : triangles) {
+    buffer->append({
+        toVertexGraphic(triangle.p1, paletteIndex, alpha),
+        toVertexGraphic(triangle.p2, paletteIndex, alpha),
+        toVertexGraphic(triangle.p3, paletteIndex, alpha),
+    });
   }
-  return triangleGraphics;
+}
+
+VertexGraphic SimUtilities::toVertexGraphic(const Coordinate &point,
+                                            int paletteIndex,
+                                            unsigned char alpha) {
+  ASSERT_LE(0, paletteIndex);
+  ASSERT_LT(paletteIndex, TilePalette::size());
+  return {
+      static_cast<float>(point.getX().getMeters()),
+      static_cast<float>(point.getY().getMeters()),
+      static_cast<unsigned char>(paletteIndex),
+      alpha,
+  };
 }
 
 }  // namespace mms
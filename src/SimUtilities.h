@@ -1,12 +1,13 @@
 #pragma once
 
 #include <QChar>
-#include <QString>
 #include <QVector>
 
 #include "Color.h"
 #include "Polygon.h"
 #include "TriangleGraphic.h"
+#include "VertexGraphic.h"
+#include "units/Coordinate.h"
 
 namespace mms {
 
@@ -15,12 +16,18 @@ class SimUtilities {
   // The SimUtilities class is not constructible
   SimUtilities() = delete;
 
-  // Like time() in <ctime> but higher resolution (returns seconds since epoch)
+  // Seconds since the first call, from a monotonic, high resolution clock
   static double getHighResTimestamp();
 
-  // Converts a polygon to a vector of triangle graphics
-  static QVector<TriangleGraphic> polygonToTriangleGraphics(
-      const Polygon &polygon, Color color, unsigned char alpha);
+  // Appends the triangles of a polygon to the buffer, as triangle graphics
+  static void appendTriangleGraphics(const Polygon &polygon, Color color,
+                                     unsigned char alpha,
+                                     QVector<TriangleGraphic> *buffer);
+
+  // A single vertex of a triangle graphic, in meters, colored by an entry of
+  // the palette
+  static VertexGraphic toVertexGraphic(const Coordinate &point,
+                                       int paletteIndex, unsigned char alpha);
 };
 
 }  // namespace mms
@@ -0,0 +1,1911 @@
+#include "Simulation.h"
+
+#include <QRegularExpression>
+#include <QtMath>
+
+#include "AssertMacros.h"
+#include "BinaryProtocol.h"
+#include "Color.h"
+#include "Dimensions.h"
+#include "FontImage.h"
+#include "Profiler.h"
+#include "ProtocolSchema.h"
+#include "SimUtilities.h"
+#include "TextProtocol.h"
+
+namespace mms {
+
+const double Simulation::MIN_PROGRESS_PER_SECOND = 10.0;
+const double Simulation::MAX_PROGRESS_PER_SECOND = 5000.0;
+const double Simulation::MAX_SLEEP_SECONDS = 0.016;
+const int Simulation::MAX_QUEUED_COMMANDS = 256;
+const qint64 Simulation::CLOCK_STEP_NANOSECONDS = 100000;
+const qint64 Simulation::MAX_CATCH_UP_NANOSECONDS = 100000000;
+
+const double Simulation::PROGRESS_PER_STRAIGHT_HALF_STEP = 50.0;
+const double Simulation::PROGRESS_PER_DIAGONAL_HALF_STEP = 70.71;
+const double Simulation::PROGRESS_PER_45_DEGREE_TURN = 16.66;
+const double Simulation::PROGRESS_PER_90_DEGREE_TURN = 33.33;
+
+const QChar Simulation::GRID_NO_COLOR = '.';
+
+const SemiPosition Simulation::INITIAL_STARTING_POSITION = {1, 1};
+const SemiDirection Simulation::INITIAL_STARTING_DIRECTION =
+    SemiDirection::NORTH;
+
+Simulation::Simulation(const Maze *maze, MazeGraphic *view, Stats *stats,
+                       QIODevice *output, QObject *parent)
+    : QObject(parent),
+      m_maze(maze),
+      m_view(view),
+      m_stats(stats),
+      m_output(output),
+
+      // Pause/reset
+      m_isPaused(false),
+      m_wasReset(false),
+      m_wasResumed(false),
+      m_isAwaitingNextMaze(false),
+      m_resetInjection(ResetInjection()),
+      m_watchpoints(Watchpoints()),
+      m_numCommands(0),
+      m_randomKey(0),
+      m_numMovements(0),
+      m_numInjectedResets(0),
+      m_numAcknowledgedResets(0),
+      m_firstAcknowledgedMovement(-1),
+      m_recoveryMovements(-1),
+
+      // Communication
+      m_isBinary(false),
+      m_parser(CommandParser()),
+      m_isParsing(false),
+      m_commandQueue(CommandQueue(MAX_QUEUED_COMMANDS)),
+      m_commandQueueTimer(new QTimer(this)),
+      m_responseBuffer(QByteArray()),
+      m_replayLog(nullptr),
+      m_trace(nullptr),
+      m_isTrackingLatency(false),
+      m_commandArrivals(QQueue<qint64>()),
+      m_lastResponseNanoseconds(-1),
+      m_serviceTimes(LatencyHistogram()),
+      m_thinkTimes(LatencyHistogram()),
+      m_algoMetrics(AlgoMetrics()),
+      m_hangTimer(nullptr),
+      m_timeBudgetNanoseconds(0),
+      m_sliceStartNanoseconds(-1),
+      m_isDeferred(false),
+      m_isHandshakePending(false),
+
+      // Movement
+      m_sensors(SensorArray()),
+      m_visitCounts(VisitCounts(maze->getWidth(), maze->getHeight())),
+      m_startingPosition(INITIAL_STARTING_POSITION),
+      m_startingDirection(INITIAL_STARTING_DIRECTION),
+      m_movement(Movement::NONE),
+      m_doomedToCrash(false),
+      m_halfStepsToMoveForward(0),
+      m_sequenceStep(0),
+      m_isAsync(false),
+      m_isMovementAnswered(false),
+      m_hasWallAcks(false),
+      m_movementProgress(0.0),
+      m_progressPerSecond(MAX_PROGRESS_PER_SECOND),
+      m_isInstant(false),
+      m_isFramePaced(false),
+      m_isFrameShown(true),
+      m_isAwaitingFrame(false),
+
+      // Clock
+      m_clock(QElapsedTimer()),
+      m_isClockRunning(false),
+      m_isLockstep(false),
+      m_lastTickNanoseconds(0),
+      m_bankedNanoseconds(0),
+      m_scheduledClockSteps(0),
+      m_elapsedClockSteps(0),
+
+      // Helpers
+      m_tilesWithColor(TileSet()),
+      m_tilesWithText(TileSet()),
+      m_wallAccuracy(WallAccuracy(maze)),
+      m_semiHeight(0),
+      m_blockedSemiDirections(QVector<unsigned char>()),
+      m_clearHalfSteps(QVector<unsigned short>()) {
+  ASSERT_FA(m_maze == nullptr);
+  ASSERT_FA(m_stats == nullptr);
+  refreshWalls();
+  m_tilesWithColor.resize(m_maze->getWidth() * m_maze->getHeight());
+  m_tilesWithText.resize(m_maze->getWidth() * m_maze->getHeight());
+  QPair<int, int> start = m_startingPosition.toMazeLocation();
+  m_visitCounts.addVisit(start.first, start.second);
+
+  // Configure command queue timer, which drives the clock
+  m_clock.start();
+  m_commandQueueTimer->setSingleShot(true);
+  m_commandQueueTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_commandQueueTimer, &QTimer::timeout, this,
+          &Simulation::onClockTick);
+}
+
+const Mouse *Simulation::getMouse() const { return &m_mouse; }
+
+VisitCounts *Simulation::getVisitCounts() { return &m_visitCounts; }
+
+const VisitCounts *Simulation::getVisitCounts() const {
+  return &m_visitCounts;
+}
+
+void Simulation::processOutput(const QByteArray &bytes) {
+  PROFILE_SCOPE("Simulation::processOutput");
+  m_parser.append(bytes);
+  parseOutput();
+}
+
+bool Simulation::processCommands(const QVector<Command> &commands,
+                                 CommandParser::Status status) {
+  for (const Command &command : commands) {
+    dispatchCommand(command);
+  }
+  bool accepted = false;
+  if (status == CommandParser::Status::HANDSHAKE) {
+    // Only switch protocols once all prior commands have been answered
+    if (m_commandQueue.isEmpty()) {
+      writeResponse({ResponseType::ACK, 0.0});
+      m_isBinary = true;
+      accepted = true;
+    } else {
+      m_isHandshakePending = true;
+    }
+  } else if (status == CommandParser::Status::INVALID) {
+    if (m_output != nullptr) {
+      m_responseBuffer.append(BinaryProtocol::RESPONSE_INVALID);
+    }
+  }
+  flushResponses();
+  return accepted;
+}
+
+int Simulation::getCommandQueueRoom() const {
+  if (m_isDeferred || m_isHandshakePending) {
+    return 0;
+  }
+  return m_commandQueue.getCapacity() - m_commandQueue.size();
+}
+
+int Simulation::getMaxQueuedCommands() const {
+  return m_commandQueue.getMaxSize();
+}
+
+qint64 Simulation::getCommandQueueMemoryBytes() const {
+  return m_commandQueue.getMemoryBytes();
+}
+
+void Simulation::useBinaryProtocol() {
+  m_isBinary = true;
+  m_parser.useBinaryProtocol();
+}
+
+bool Simulation::isBinaryProtocol() const { return m_isBinary; }
+
+void Simulation::stop() {
+  // Stop consuming queued commands
+  m_commandQueueTimer->stop();
+  m_isClockRunning = false;
+  m_commandQueue.clear();
+  m_commandArrivals.clear();
+  m_isAwaitingNextMaze = false;
+  m_parser.clear();
+  m_isDeferred = false;
+  m_isHandshakePending = false;
+  m_isAwaitingFrame = false;
+  m_sequenceStep = 0;
+  m_isMovementAnswered = false;
+  if (m_hangTimer != nullptr) {
+    m_hangTimer->stop();
+  }
+
+  // Stop producing responses
+  m_responseBuffer.clear();
+  m_output = nullptr;
+}
+
+void Simulation::setPaused(bool paused) {
+  m_isPaused = paused;
+  if (!m_isPaused) {
+    processQueuedCommands();
+    flushResponses();
+  }
+}
+
+bool Simulation::isPaused() const { return m_isPaused; }
+
+void Simulation::requestReset() {
+  m_wasReset = true;
+  recordReset();
+}
+
+void Simulation::setResetInjection(const ResetInjection &injection) {
+  m_resetInjection = injection;
+  m_resetInjection.setRandomKey(m_randomKey);
+}
+
+void Simulation::setWatchpoints(const Watchpoints &watchpoints) {
+  m_watchpoints = watchpoints;
+}
+
+void Simulation::setRandomKey(quint64 key) {
+  m_randomKey = key;
+  m_sensors.setRandomKey(key);
+  m_resetInjection.setRandomKey(key);
+}
+
+int Simulation::getNumInjectedResets() const { return m_numInjectedResets; }
+
+int Simulation::getNumAcknowledgedResets() const {
+  return m_numAcknowledgedResets;
+}
+
+int Simulation::getRecoveryMovements() const { return m_recoveryMovements; }
+
+void Simulation::setResumed() { m_wasResumed = true; }
+
+void Simulation::answerNextMaze(bool isNextMaze) {
+  ASSERT_TR(m_isAwaitingNextMaze);
+  ASSERT_TR(m_commandQueue.head().type == CommandType::NEXT_MAZE);
+  m_isAwaitingNextMaze = false;
+
+  // Not recorded, since a replay covers a single maze, and not timed, since
+  // it waited on the owner rather than the simulator; answered before it's
+  // dequeued, which may accept a pending handshake
+  writeResponse(boolResponse(isNextMaze));
+  dequeueCommand();
+  if (!m_commandArrivals.isEmpty()) {
+    m_commandArrivals.dequeue();
+  }
+  processQueuedCommands();
+  flushResponses();
+}
+
+void Simulation::setProgressPerSecond(double progressPerSecond) {
+  ASSERT_LT(0.0, progressPerSecond);
+  m_progressPerSecond = progressPerSecond;
+}
+
+void Simulation::setInstant(bool instant) { m_isInstant = instant; }
+
+void Simulation::setLockstep(bool lockstep) { m_isLockstep = lockstep; }
+
+void Simulation::setFramePaced(bool framePaced) {
+  m_isFramePaced = framePaced;
+}
+
+void Simulation::onFrameShown() {
+  m_isFrameShown = true;
+  if (m_isAwaitingFrame) {
+    m_isAwaitingFrame = false;
+    processQueuedCommands();
+    flushResponses();
+  }
+}
+
+void Simulation::setTimeBudget(double seconds) {
+  ASSERT_LE(0.0, seconds);
+  m_timeBudgetNanoseconds = seconds * 1e9;
+}
+
+double Simulation::getVirtualSeconds() const {
+  return m_elapsedClockSteps * (CLOCK_STEP_NANOSECONDS / 1e9);
+}
+
+void Simulation::setReplayLog(ReplayLog *log) { m_replayLog = log; }
+
+void Simulation::setTrace(RunTrace *trace) { m_trace = trace; }
+
+void Simulation::setLatencyTracking(bool tracking) {
+  ASSERT_TR(m_commandQueue.isEmpty());
+  m_isTrackingLatency = tracking;
+}
+
+const LatencyHistogram &Simulation::getServiceTimes() const {
+  return m_serviceTimes;
+}
+
+const LatencyHistogram &Simulation::getThinkTimes() const {
+  return m_thinkTimes;
+}
+
+const AlgoMetrics *Simulation::getAlgoMetrics() const {
+  return &m_algoMetrics;
+}
+
+void Simulation::setHangTimeout(double seconds) {
+  if (seconds <= 0.0) {
+    delete m_hangTimer;
+    m_hangTimer = nullptr;
+    return;
+  }
+  if (m_hangTimer == nullptr) {
+    m_hangTimer = new QTimer(this);
+    m_hangTimer->setSingleShot(true);
+    connect(m_hangTimer, &QTimer::timeout, this, &Simulation::hung);
+  }
+  m_hangTimer->setInterval(qCeil(seconds * 1000));
+  m_hangTimer->start();
+}
+
+bool Simulation::isIdle() const {
+  return m_commandQueue.isEmpty() && m_parser.isEmpty() &&
+         m_movement == Movement::NONE;
+}
+
+Simulation::Snapshot Simulation::getSnapshot() const {
+  ASSERT_TR(isIdle());
+  return {m_startingPosition, m_startingDirection, m_wasReset,
+          m_elapsedClockSteps, m_stats->getState(), m_visitCounts,
+          m_wallAccuracy};
+}
+
+void Simulation::restoreSnapshot(const Snapshot &snapshot) {
+  // Drop whatever was in progress
+  m_commandQueueTimer->stop();
+  m_commandQueue.clear();
+  m_commandArrivals.clear();
+  m_lastResponseNanoseconds = -1;
+  m_isAwaitingNextMaze = false;
+  m_parser.clear();
+  m_responseBuffer.clear();
+  m_movement = Movement::NONE;
+  m_movementProgress = 0.0;
+  m_doomedToCrash = false;
+  m_halfStepsToMoveForward = 0;
+  m_sequenceStep = 0;
+  m_isMovementAnswered = false;
+  m_isClockRunning = false;
+  m_bankedNanoseconds = 0;
+
+  m_startingPosition = snapshot.position;
+  m_startingDirection = snapshot.direction;
+  m_wasReset = snapshot.wasReset;
+  m_elapsedClockSteps = snapshot.elapsedClockSteps;
+  m_stats->setState(snapshot.stats);
+  m_visitCounts = snapshot.visits;
+  m_visitCounts.markAllDirty();
+  m_wallAccuracy = snapshot.walls;
+  updateWallStats();
+  m_mouse.teleport(getCoordinate(m_startingPosition),
+                   DIRECTION_TO_ANGLE().value(m_startingDirection));
+
+  // The tiles that need clearing are whatever the view says they are
+  m_tilesWithColor.clear();
+  m_tilesWithText.clear();
+  if (m_view != nullptr) {
+    for (int x = 0; x < m_maze->getWidth(); x += 1) {
+      for (int y = 0; y < m_maze->getHeight(); y += 1) {
+        TileState state = m_view->getTileState(x, y);
+        if (state.hasColor) {
+          m_tilesWithColor.insert(getTileIndex(x, y));
+        }
+        if (!state.text.isEmpty()) {
+          m_tilesWithText.insert(getTileIndex(x, y));
+        }
+      }
+    }
+  }
+  emit mouseMoved();
+  emit viewChanged();
+}
+
+Response Simulation::execute(const Command &command) {
+  ASSERT_TR(m_isInstant);
+  ASSERT_TR(m_commandQueue.isEmpty());
+  recordCommand(command);
+  if (performInlineCommand(command)) {
+    return {ResponseType::ACK, 0.0};
+  }
+  Response response = executeCommand(command);
+  while (response.type == ResponseType::NONE) {
+    // Complete the movement in a single step, as processQueuedCommands would
+    ASSERT_TR(isMoving());
+    completeMovement();
+    response = finishMovement(command);
+  }
+  m_sequenceStep = 0;
+  recordResponse(response);
+  return response;
+}
+
+void Simulation::parseOutput() {
+  if (m_isParsing) {
+    return;
+  }
+  m_isParsing = true;
+  QVector<Command> commands;
+  CommandParser::Status status = CommandParser::Status::NONE;
+  do {
+    // Parse no more than fits, counting inline commands too, since there's no
+    // telling which are which until they're parsed; the rest waits for room
+    int room = getCommandQueueRoom();
+    if (room == 0) {
+      break;
+    }
+    if (isOverBudget()) {
+      deferProcessing();
+      break;
+    }
+    commands.clear();
+    status = m_parser.parse(&commands, room);
+    if (processCommands(commands, status)) {
+      m_parser.useBinaryProtocol();
+    }
+  } while (status != CommandParser::Status::NONE);
+  m_isParsing = false;
+}
+
+void Simulation::dispatchCommand(const Command &command) {
+  PROFILE_SCOPE("Simulation::dispatchCommand");
+
+  // For performance reasons, handle no-response commands inline (don't queue
+  // them with the commands that elicit a response, just perform the action)
+  if (command.type != CommandType::NEXT_MAZE) {
+    recordCommand(command);
+  }
+  bool isInline = performInlineCommand(command);
+  onCommandArrived(!isInline);
+  m_numCommands += 1;
+  if (!m_watchpoints.isEmpty()) {
+    // Hit before a queued command is processed, so it's the next to run
+    pauseAt(m_watchpoints.onCommandArrived(m_numCommands));
+    pauseAt(m_watchpoints.onStatsChanged(m_stats));
+  }
+  if (isInline) {
+    return;
+  }
+
+  // Enqueue the serial command, process it if future processing is not
+  // already scheduled, or if it might be answered during a movement
+  m_commandQueue.enqueue(command);
+  if (!m_commandQueueTimer->isActive() || m_isAsync) {
+    processQueuedCommands();
+  }
+}
+
+void Simulation::dequeueCommand() {
+  bool wasFull = m_commandQueue.isFull();
+  m_commandQueue.dequeue();
+  if (m_isHandshakePending && m_commandQueue.isEmpty()) {
+    acceptHandshake();
+    return;
+  }
+  if (!wasFull) {
+    return;
+  }
+  // Parse what was held back from the event loop, rather than while the queue
+  // is being processed, since the commands that it holds would be processed
+  // from within the loop that's answering them
+  if (!m_isParsing && !m_parser.isEmpty()) {
+    QTimer::singleShot(0, this, &Simulation::parseOutput);
+  }
+  emit readyForCommands();
+}
+
+void Simulation::acceptHandshake() {
+  // The ack follows the response to the last command before the handshake,
+  // and anything the algo wrote after it was text that it mustn't have sent
+  m_isHandshakePending = false;
+  writeResponse({ResponseType::ACK, 0.0});
+  m_isBinary = true;
+  m_parser.useBinaryProtocol();
+  emit handshakeAccepted();
+  if (!m_isParsing && !m_parser.isEmpty()) {
+    QTimer::singleShot(0, this, &Simulation::parseOutput);
+  }
+  emit readyForCommands();
+}
+
+bool Simulation::performInlineCommand(const Command &command) {
+  // Exactly the commands without a reply are inline (see ProtocolSchema.h)
+  if (getCommandSchema(command.type).reply != Reply::NONE) {
+    return false;
+  }
+
+  // Metrics are plotted on a timer of their own, rather than with the view,
+  // and ones with invalid names are dropped, as the command has no response
+  if (command.type == CommandType::METRIC) {
+    if (AlgoMetrics::isValidName(command.text)) {
+      m_algoMetrics.add(command.text, getVirtualMicroseconds(),
+                        command.value);
+    }
+    return true;
+  }
+  switch (command.type) {
+    case CommandType::SET_WALL:
+      setWall(command.x, command.y, command.c);
+      break;
+    case CommandType::CLEAR_WALL:
+      clearWall(command.x, command.y, command.c);
+      break;
+    case CommandType::SET_COLOR:
+      setColor(command.x, command.y, command.c);
+      break;
+    case CommandType::CLEAR_COLOR:
+      clearColor(command.x, command.y);
+      break;
+    case CommandType::CLEAR_ALL_COLOR:
+      clearAllColor();
+      break;
+    case CommandType::SET_TEXT:
+      setText(command.x, command.y, command.text);
+      break;
+    case CommandType::CLEAR_TEXT:
+      clearText(command.x, command.y);
+      break;
+    case CommandType::CLEAR_ALL_TEXT:
+      clearAllText();
+      break;
+    case CommandType::SET_WALLS:
+      for (const Cell &cell : command.cells) {
+        setWall(cell.x, cell.y, cell.c);
+      }
+      break;
+    case CommandType::SET_COLORS:
+      for (const Cell &cell : command.cells) {
+        setColor(cell.x, cell.y, cell.c);
+      }
+      break;
+    case CommandType::SET_TEXTS:
+      for (const Cell &cell : command.cells) {
+        setText(cell.x, cell.y, cell.text);
+      }
+      break;
+    case CommandType::SET_COLOR_GRID:
+      setColorGrid(command.text);
+      break;
+    case CommandType::SET_TEXT_GRID:
+      setTextGrid(command.n, command.text);
+      break;
+    case CommandType::SET_WALL_MASK:
+      setWallMask(command.x, command.y, command.n);
+      break;
+    case CommandType::SET_WALL_GRID:
+      setWallGrid(command.text);
+      break;
+    case CommandType::DRAW_PATH:
+      drawPath(command.c, command.cells);
+      break;
+    case CommandType::CLEAR_PATH:
+      clearPath();
+      break;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+
+  // All of the inline commands are visualization commands
+  emit viewChanged();
+  return true;
+}
+
+Response Simulation::executeCommand(const Command &command) {
+  PROFILE_SCOPE("Simulation::executeCommand");
+
+  // The "wallFront" and such methods take "halfStepsAway", which represents
+  // the number of moves "head" of the current move to simulator before
+  // checking if a wall is a half-step away. To check if a wall is directly
+  // in front of the mouse, we provide halfStepsAhead=0. The potential wall
+  // would be 1 half-step away, which is a bit more intuitive from the
+  // perspective of the API, hence the -1 here.
+  int halfStepsAhead = command.n - 1;
+  switch (command.type) {
+    case CommandType::MAZE_WIDTH:
+      return {ResponseType::INTEGER, static_cast<double>(mazeWidth())};
+    case CommandType::MAZE_HEIGHT:
+      return {ResponseType::INTEGER, static_cast<double>(mazeHeight())};
+    case CommandType::WALL_FRONT:
+      return boolResponse(wallFront(halfStepsAhead));
+    case CommandType::WALL_BACK:
+      return boolResponse(wallBack(halfStepsAhead));
+    case CommandType::WALL_LEFT:
+      return boolResponse(wallLeft(halfStepsAhead));
+    case CommandType::WALL_RIGHT:
+      return boolResponse(wallRight(halfStepsAhead));
+    case CommandType::WALL_FRONT_RIGHT:
+      return boolResponse(wallFrontRight(halfStepsAhead));
+    case CommandType::WALL_FRONT_LEFT:
+      return boolResponse(wallFrontLeft(halfStepsAhead));
+    case CommandType::WALL_BACK_RIGHT:
+      return boolResponse(wallBackRight(halfStepsAhead));
+    case CommandType::WALL_BACK_LEFT:
+      return boolResponse(wallBackLeft(halfStepsAhead));
+    case CommandType::WALLS:
+      return {ResponseType::INTEGER,
+              static_cast<double>(walls(halfStepsAhead))};
+    case CommandType::SENSOR_SCAN:
+      return {ResponseType::INTEGERS, 0.0, sensorScan()};
+    case CommandType::READ_SENSORS:
+      return {ResponseType::INTEGERS, 0.0, readSensors()};
+    case CommandType::SET_SENSORS:
+      return boolResponse(setSensors(command.values));
+    case CommandType::MOVE_FORWARD: {
+      bool success = moveForward(command.n * 2);
+      return {success ? ResponseType::NONE : ResponseType::CRASH, 0.0};
+    }
+    case CommandType::MOVE_FORWARD_HALF: {
+      bool success = moveForward(command.n);
+      return {success ? ResponseType::NONE : ResponseType::CRASH, 0.0};
+    }
+    case CommandType::TURN_RIGHT_90:
+      turn(Movement::TURN_RIGHT_90);
+      return {ResponseType::NONE, 0.0};
+    case CommandType::TURN_LEFT_90:
+      turn(Movement::TURN_LEFT_90);
+      return {ResponseType::NONE, 0.0};
+    case CommandType::TURN_RIGHT_45:
+      turn(Movement::TURN_RIGHT_45);
+      return {ResponseType::NONE, 0.0};
+    case CommandType::TURN_LEFT_45:
+      turn(Movement::TURN_LEFT_45);
+      return {ResponseType::NONE, 0.0};
+    case CommandType::MOVE_SEQUENCE:
+      return startSequenceStep(command);
+    case CommandType::SET_ASYNC_MOVES:
+      m_isAsync = command.n != 0;
+      return {ResponseType::ACK, 0.0};
+    case CommandType::SET_WALL_ACKS:
+      m_hasWallAcks = command.n != 0;
+      return {ResponseType::ACK, 0.0};
+    case CommandType::WAIT_FOR_MOVES:
+      // The mouse has stopped by now, see isAnsweredWhileMoving
+      return {ResponseType::ACK, 0.0};
+    case CommandType::WAS_RESET:
+      return boolResponse(wasReset());
+    case CommandType::WAS_RESUMED:
+      return boolResponse(m_wasResumed);
+    case CommandType::ACK_RESET:
+      ackReset();
+      return {ResponseType::ACK, 0.0};
+    case CommandType::GET_STAT: {
+      QString statValue = m_stats->getStat(command.stat);
+      // Cannot return an empty value. Return -1 to indicate empty field.
+      double value = statValue.isEmpty() ? -1.0 : statValue.toDouble();
+      return {ResponseType::FLOAT, value};
+    }
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+void Simulation::processQueuedCommands() {
+  PROFILE_SCOPE("Simulation::processQueuedCommands");
+  // An async movement is driven even once there's nothing left to answer
+  while ((!m_commandQueue.isEmpty() || isMoving()) && !m_isPaused) {
+    // Movements in progress are still advanced, since they're already timed
+    // by the clock
+    if (!isMoving() && (m_isDeferred || isOverBudget())) {
+      deferProcessing();
+      break;
+    }
+    Response response = {ResponseType::NONE, 0.0};
+    if (isMoving() && m_isAsync && !m_commandQueue.isEmpty() &&
+        isAnsweredWhileMoving(m_commandQueue.head().type)) {
+      response = executeCommand(m_commandQueue.head());
+    } else if (isMoving()) {
+      if (m_isInstant) {
+        completeMovement();
+      } else if (m_isFramePaced) {
+        // The previous movement must be drawn first; completing this one
+        // emits mouseMoved, so a frame is surely on its way
+        if (!m_isFrameShown) {
+          m_isAwaitingFrame = true;
+          return;
+        }
+        m_isFrameShown = false;
+        completeMovement();
+      } else if (m_commandQueueTimer->isActive()) {
+        // Answering an async query, between clock ticks
+        return;
+      } else {
+        spendClockSteps();
+      }
+      if (isMoving()) {
+        // Wait for more time to be banked
+        scheduleMouseProgressUpdate();
+        return;
+      }
+      if (m_isMovementAnswered) {
+        m_isMovementAnswered = false;
+        continue;
+      }
+      response = finishMovement(m_commandQueue.head());
+    } else if (m_commandQueue.head().type == CommandType::NEXT_MAZE) {
+      // Only the owner knows whether there's another maze
+      if (!m_isAwaitingNextMaze) {
+        m_isAwaitingNextMaze = true;
+        emit nextMazeRequested();
+      }
+      break;
+    } else {
+      const Command &command = m_commandQueue.head();
+      response = executeCommand(command);
+      if (m_isAsync && response.type == ResponseType::NONE &&
+          command.type != CommandType::MOVE_SEQUENCE) {
+        // Whether the move crashes is known before it starts
+        response = m_doomedToCrash ? getCrash(command) : getAck();
+        m_isMovementAnswered = true;
+      }
+    }
+    if (response.type != ResponseType::NONE) {
+      m_sequenceStep = 0;
+      recordResponse(response);
+      writeResponse(response);
+      dequeueCommand();
+      onCommandAnswered();
+    }
+  }
+
+  // The mouse is idle, so time shouldn't be banked until it moves again
+  m_isClockRunning = false;
+  m_bankedNanoseconds = 0;
+}
+
+bool Simulation::isOverBudget() {
+  if (m_timeBudgetNanoseconds <= 0) {
+    return false;
+  }
+  qint64 now = m_clock.nsecsElapsed();
+  if (m_sliceStartNanoseconds < 0) {
+    // The slice lasts until the event loop gets a turn
+    m_sliceStartNanoseconds = now;
+    QTimer::singleShot(0, this, [=]() { m_sliceStartNanoseconds = -1; });
+    return false;
+  }
+  return m_timeBudgetNanoseconds < now - m_sliceStartNanoseconds;
+}
+
+void Simulation::deferProcessing() {
+  if (m_isDeferred) {
+    return;
+  }
+  // The slice is over by the time this runs, since its timer was first
+  m_isDeferred = true;
+  QTimer::singleShot(0, this, &Simulation::resumeProcessing);
+}
+
+void Simulation::resumeProcessing() {
+  if (!m_isDeferred) {
+    return;  // stopped in the meantime
+  }
+  m_isDeferred = false;
+  processQueuedCommands();
+  flushResponses();
+  parseOutput();
+  emit readyForCommands();
+}
+
+void Simulation::writeResponse(const Response &response) {
+  if (m_output == nullptr) {
+    return;
+  }
+  if (m_isBinary) {
+    BinaryProtocol::append(response, &m_responseBuffer);
+  } else {
+    TextProtocol::append(response, &m_responseBuffer);
+  }
+}
+
+void Simulation::flushResponses() {
+  if (m_output == nullptr || m_responseBuffer.isEmpty()) {
+    return;
+  }
+  m_output->write(m_responseBuffer);
+  m_responseBuffer.clear();
+
+  // With nothing left in the queue, the simulator is waiting on the algo
+  if (m_commandQueue.isEmpty()) {
+    if (m_isTrackingLatency) {
+      m_lastResponseNanoseconds = m_clock.nsecsElapsed();
+    }
+    if (m_hangTimer != nullptr) {
+      m_hangTimer->start();
+    }
+  }
+}
+
+void Simulation::onCommandArrived(bool isQueued) {
+  if (m_hangTimer != nullptr) {
+    m_hangTimer->stop();
+  }
+  if (!m_isTrackingLatency) {
+    return;
+  }
+  qint64 now = m_clock.nsecsElapsed();
+  if (0 <= m_lastResponseNanoseconds) {
+    m_thinkTimes.add(now - m_lastResponseNanoseconds);
+    m_lastResponseNanoseconds = -1;
+  }
+  if (isQueued) {
+    m_commandArrivals.enqueue(now);
+  }
+}
+
+void Simulation::onCommandAnswered() {
+  if (!m_commandArrivals.isEmpty()) {
+    m_serviceTimes.add(m_clock.nsecsElapsed() -
+                       m_commandArrivals.dequeue());
+  }
+}
+
+void Simulation::recordCommand(const Command &command) {
+  // Only encode if necessary, since this is on the path of every command
+  if (m_replayLog != nullptr) {
+    m_replayLog->append(ReplayLog::RecordType::COMMAND,
+                        getVirtualMicroseconds(),
+                        BinaryProtocol::encode(command));
+  }
+  if (m_trace != nullptr && command.type == CommandType::METRIC) {
+    if (AlgoMetrics::isValidName(command.text)) {
+      traceRecord(RunTrace::Kind::METRIC, m_trace->getMetricId(command.text),
+                  command.value);
+    }
+  } else if (m_trace != nullptr) {
+    traceRecord(RunTrace::Kind::COMMAND, static_cast<int>(command.type),
+                command.n);
+  }
+}
+
+void Simulation::recordResponse(const Response &response) {
+  if (m_replayLog != nullptr) {
+    m_replayLog->append(ReplayLog::RecordType::RESPONSE,
+                        getVirtualMicroseconds(),
+                        BinaryProtocol::encode(response));
+  }
+  if (m_trace != nullptr) {
+    traceRecord(RunTrace::Kind::RESPONSE, static_cast<int>(response.type),
+                response.value);
+  }
+}
+
+void Simulation::recordReset() {
+  if (m_replayLog != nullptr) {
+    m_replayLog->append(ReplayLog::RecordType::RESET,
+                        getVirtualMicroseconds(), QByteArray());
+  }
+  if (m_trace != nullptr) {
+    traceRecord(RunTrace::Kind::RESET, 0, 0.0);
+  }
+}
+
+void Simulation::traceRecord(RunTrace::Kind kind, int code, double value) {
+  Stats::State stats = m_stats->getState();
+  m_trace->append(kind, getVirtualMicroseconds(), code, value,
+                  m_mouse.getCurrentDiscretizedTranslation(),
+                  m_mouse.getCurrentDiscretizedRotation(),
+                  stats.values[static_cast<int>(StatsEnum::TOTAL_DISTANCE)],
+                  stats.values[static_cast<int>(StatsEnum::TOTAL_TURNS)]);
+}
+
+double Simulation::progressRequired(Movement movement) {
+  switch (movement) {
+    case Movement::MOVE_STRAIGHT:
+      return PROGRESS_PER_STRAIGHT_HALF_STEP * m_halfStepsToMoveForward;
+    case Movement::MOVE_DIAGONAL:
+      return PROGRESS_PER_DIAGONAL_HALF_STEP * m_halfStepsToMoveForward;
+    case Movement::TURN_RIGHT_45:
+    case Movement::TURN_LEFT_45:
+      return PROGRESS_PER_45_DEGREE_TURN;
+    case Movement::TURN_RIGHT_90:
+    case Movement::TURN_LEFT_90:
+      return PROGRESS_PER_90_DEGREE_TURN;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+void Simulation::updateMouseProgress(double progress) {
+  PROFILE_SCOPE("Simulation::updateMouseProgress");
+
+  // Determine the destination of the mouse.
+  SemiPosition destinationLocation = getPlannedTranslation();
+  Angle destinationRotation = DIRECTION_TO_ANGLE().value(m_startingDirection);
+  // Explicity add or subtract depending on direction so that the mouse is
+  // guaranteed to only rotate that much (using DIRECTION_ROTATE can cause
+  // the mouse to rotate 270 degrees in the opposite direction in some cases)
+  if (m_movement == Movement::MOVE_STRAIGHT ||
+      m_movement == Movement::MOVE_DIAGONAL) {
+    // The rotation stays as it is
+  } else if (m_movement == Movement::TURN_RIGHT_45) {
+    destinationRotation -= Angle::Degrees(45);
+  } else if (m_movement == Movement::TURN_LEFT_45) {
+    destinationRotation += Angle::Degrees(45);
+  } else if (m_movement == Movement::TURN_RIGHT_90) {
+    destinationRotation -= Angle::Degrees(90);
+  } else if (m_movement == Movement::TURN_LEFT_90) {
+    destinationRotation += Angle::Degrees(90);
+  } else {
+    ASSERT_NEVER_RUNS();
+  }
+
+  // Increment the movement progress, calculate fraction complete
+  m_movementProgress += progress;
+  double required = progressRequired(m_movement);
+  double remaining = required - m_movementProgress;
+  if (remaining < 0) {
+    remaining = 0;
+  }
+  double fraction = 1.0 - (remaining / required);
+
+  // Calculate the current translation and rotation
+  Coordinate startingTranslation = getCoordinate(m_startingPosition);
+  Coordinate destinationTranslation = getCoordinate(destinationLocation);
+
+  Angle startingRotation = DIRECTION_TO_ANGLE().value(m_startingDirection);
+  Coordinate currentTranslation = startingTranslation * (1.0 - fraction) +
+                                  destinationTranslation * fraction;
+  Angle currentRotation =
+      startingRotation * (1.0 - fraction) + destinationRotation * fraction;
+
+  // Move the mouse, reset movement state if done; the drawn mouse is
+  // interpolated between poses, so it moves smoothly however seldom they come
+  if (m_isInstant) {
+    m_mouse.teleport(currentTranslation, currentRotation);
+  } else {
+    m_mouse.moveTo(currentTranslation, currentRotation, getPoseTimestamp());
+  }
+  emit mouseMoved();
+  if (remaining == 0.0) {
+    // Every half-step of a move is counted, not just where it ends
+    SemiPosition from = m_startingPosition;
+    int stepX = qBound(-1, destinationLocation.x - from.x, 1);
+    int stepY = qBound(-1, destinationLocation.y - from.y, 1);
+    for (int i = 0; i < m_halfStepsToMoveForward; i += 1) {
+      SemiPosition to = {from.x + stepX, from.y + stepY};
+      m_visitCounts.addHalfStep(from, to);
+      from = to;
+    }
+    m_startingPosition = m_mouse.getCurrentDiscretizedTranslation();
+    m_startingDirection = m_mouse.getCurrentDiscretizedRotation();
+    m_movementProgress = 0.0;
+    m_movement = Movement::NONE;
+    m_halfStepsToMoveForward = 0;
+    // TODO: upforgrabs
+    // This if-else can probably be moved outside of the enclosing if-block
+    // determine if the goal was reached
+    if (m_maze->isInCenter(m_startingPosition.toMazeLocation())) {
+      m_stats->finishRun();  // record a completed start-to-finish run
+    } else if (m_startingPosition.toMazeLocation().first == 0 &&
+               m_startingPosition.toMazeLocation().second == 0) {
+      m_stats->endUnfinishedRun();
+    }
+    injectResets();
+  }
+}
+
+void Simulation::injectResets() {
+  m_numMovements += 1;
+  QPair<int, int> location = m_startingPosition.toMazeLocation();
+  if (0 <= m_firstAcknowledgedMovement && m_recoveryMovements < 0 &&
+      m_maze->isInCenter(location)) {
+    m_recoveryMovements = m_numMovements - m_firstAcknowledgedMovement;
+  }
+  if (m_resetInjection.onMovementCompleted(location.first, location.second) &&
+      !m_wasReset) {
+    m_numInjectedResets += 1;
+    requestReset();
+  }
+  if (!m_watchpoints.isEmpty()) {
+    pauseAt(m_watchpoints.onMovementCompleted(m_numMovements, location.first,
+                                              location.second));
+    pauseAt(m_watchpoints.onStatsChanged(m_stats));
+  }
+}
+
+void Simulation::pauseAt(const QString &watchpoint) {
+  // Commands already queued wait, as they do while paused by the owner
+  if (!watchpoint.isNull()) {
+    m_isPaused = true;
+    emit watchpointHit(watchpoint);
+  }
+}
+
+void Simulation::completeMovement() {
+  // Progress beyond what's required is clamped, so the full amount
+  // guarantees that the movement completes
+  m_elapsedClockSteps += getRequiredClockSteps();
+  updateMouseProgress(progressRequired(m_movement));
+  ASSERT_FA(isMoving());
+}
+
+Response Simulation::startSequenceStep(const Command &command) {
+  // The values are pairs of each step's type and distance
+  ASSERT_LT(2 * m_sequenceStep + 1, command.values.size());
+  Command step = {
+      static_cast<CommandType>(command.values.at(2 * m_sequenceStep))};
+  step.n = command.values.at(2 * m_sequenceStep + 1);
+  m_sequenceStep += 1;
+  Response response = executeCommand(step);
+  if (response.type == ResponseType::CRASH) {
+    return getCrash(command);
+  }
+  return response;
+}
+
+Response Simulation::finishMovement(const Command &command) {
+  if (m_doomedToCrash) {
+    return getCrash(command);
+  }
+  if (command.type == CommandType::MOVE_SEQUENCE &&
+      2 * m_sequenceStep < command.values.size()) {
+    return startSequenceStep(command);
+  }
+  return getAck();
+}
+
+Response Simulation::getAck() {
+  // The walls are as the walls command would see them, i.e., around where
+  // the mouse stops, even if it's still on its way there
+  if (m_hasWallAcks) {
+    return {ResponseType::ACK, 0.0, {walls(0)}};
+  }
+  return {ResponseType::ACK, 0.0};
+}
+
+Response Simulation::getCrash(const Command &command) const {
+  if (command.type == CommandType::MOVE_SEQUENCE) {
+    return {ResponseType::CRASH, 0.0, {m_sequenceStep - 1}};
+  }
+  return {ResponseType::CRASH, 0.0};
+}
+
+void Simulation::scheduleMouseProgressUpdate() {
+  // Wait for the rest of the movement, but wake up often enough that the
+  // mouse moves smoothly
+  qint64 maxSleepSteps = MAX_SLEEP_SECONDS * 1e9 / CLOCK_STEP_NANOSECONDS;
+  m_scheduledClockSteps = qMin(getRequiredClockSteps(), maxSleepSteps);
+  ASSERT_LT(0, m_scheduledClockSteps);
+  if (!m_isClockRunning) {
+    m_isClockRunning = true;
+    m_lastTickNanoseconds = m_clock.nsecsElapsed();
+
+    // The movement starts now, not when the last one ended, so the drawn
+    // mouse mustn't drift from there in the meantime
+    m_mouse.moveTo(m_mouse.getCurrentTranslation(),
+                   m_mouse.getCurrentRotation(), getPoseTimestamp());
+  }
+
+  // Any time that's already banked is spent first
+  qint64 nanoseconds =
+      m_scheduledClockSteps * CLOCK_STEP_NANOSECONDS - m_bankedNanoseconds;
+  m_commandQueueTimer->start(qMax(1, qCeil(nanoseconds / 1e6)));
+}
+
+double Simulation::getPoseTimestamp() const {
+  // Banked time hasn't been spent on the movement yet, so the mouse is where
+  // it should have been that long ago
+  return SimUtilities::getHighResTimestamp() - m_bankedNanoseconds / 1e9;
+}
+
+void Simulation::onClockTick() {
+  qint64 now = m_clock.nsecsElapsed();
+  if (m_isLockstep) {
+    m_bankedNanoseconds += m_scheduledClockSteps * CLOCK_STEP_NANOSECONDS;
+  } else {
+    // Don't race to catch up after a stall, e.g., while the window is moved
+    m_bankedNanoseconds +=
+        qMin(now - m_lastTickNanoseconds, MAX_CATCH_UP_NANOSECONDS);
+  }
+  m_lastTickNanoseconds = now;
+  processQueuedCommands();
+  flushResponses();
+}
+
+void Simulation::spendClockSteps() {
+  qint64 required = getRequiredClockSteps();
+  qint64 steps = qMin(m_bankedNanoseconds / CLOCK_STEP_NANOSECONDS, required);
+  if (steps == 0) {
+    return;
+  }
+  m_bankedNanoseconds -= steps * CLOCK_STEP_NANOSECONDS;
+  m_elapsedClockSteps += steps;
+
+  // Avoid rounding error on the last step, so the movement surely completes
+  updateMouseProgress(steps == required ? progressRequired(m_movement)
+                                        : steps * getProgressPerClockStep());
+}
+
+qint64 Simulation::getVirtualMicroseconds() const {
+  return m_elapsedClockSteps * CLOCK_STEP_NANOSECONDS / 1000;
+}
+
+qint64 Simulation::getRequiredClockSteps() {
+  double remaining = progressRequired(m_movement) - m_movementProgress;
+  return qMax<qint64>(1, qCeil(remaining / getProgressPerClockStep()));
+}
+
+double Simulation::getProgressPerClockStep() const {
+  return m_progressPerSecond * (CLOCK_STEP_NANOSECONDS / 1e9);
+}
+
+bool Simulation::isMoving() { return m_movement != Movement::NONE; }
+
+bool Simulation::isAnsweredWhileMoving(CommandType type) {
+  // Only queries of the maze around the mouse's planned pose, which a
+  // movement that's underway can't change
+  switch (type) {
+    case CommandType::MAZE_WIDTH:
+    case CommandType::MAZE_HEIGHT:
+    case CommandType::WALL_FRONT:
+    case CommandType::WALL_RIGHT:
+    case CommandType::WALL_LEFT:
+    case CommandType::WALL_BACK:
+    case CommandType::WALL_FRONT_RIGHT:
+    case CommandType::WALL_FRONT_LEFT:
+    case CommandType::WALL_BACK_RIGHT:
+    case CommandType::WALL_BACK_LEFT:
+    case CommandType::WALLS:
+    case CommandType::SENSOR_SCAN:
+      return true;
+    default:
+      return false;
+  }
+}
+
+SemiPosition Simulation::getPlannedTranslation() const {
+  // Where the current movement ends, or else where the mouse is
+  if (m_movement == Movement::NONE) {
+    return m_mouse.getCurrentDiscretizedTranslation();
+  }
+  SemiPosition location = m_startingPosition;
+  if (m_movement == Movement::MOVE_STRAIGHT) {
+    if (m_startingDirection == SemiDirection::NORTH) {
+      location.y += m_halfStepsToMoveForward;
+    } else if (m_startingDirection == SemiDirection::EAST) {
+      location.x += m_halfStepsToMoveForward;
+    } else if (m_startingDirection == SemiDirection::SOUTH) {
+      location.y -= m_halfStepsToMoveForward;
+    } else if (m_startingDirection == SemiDirection::WEST) {
+      location.x -= m_halfStepsToMoveForward;
+    } else {
+      ASSERT_NEVER_RUNS();
+    }
+  } else if (m_movement == Movement::MOVE_DIAGONAL) {
+    if (m_startingDirection == SemiDirection::NORTHEAST) {
+      location.x += m_halfStepsToMoveForward;
+      location.y += m_halfStepsToMoveForward;
+    } else if (m_startingDirection == SemiDirection::NORTHWEST) {
+      location.x -= m_halfStepsToMoveForward;
+      location.y += m_halfStepsToMoveForward;
+    } else if (m_startingDirection == SemiDirection::SOUTHEAST) {
+      location.x += m_halfStepsToMoveForward;
+      location.y -= m_halfStepsToMoveForward;
+    } else if (m_startingDirection == SemiDirection::SOUTHWEST) {
+      location.x -= m_halfStepsToMoveForward;
+      location.y -= m_halfStepsToMoveForward;
+    } else {
+      ASSERT_NEVER_RUNS();
+    }
+  }
+  return location;
+}
+
+SemiDirection Simulation::getPlannedRotation() const {
+  switch (m_movement) {
+    case Movement::NONE:
+      return m_mouse.getCurrentDiscretizedRotation();
+    case Movement::TURN_RIGHT_45:
+      return DIRECTION_ROTATE_45_RIGHT().value(m_startingDirection);
+    case Movement::TURN_LEFT_45:
+      return DIRECTION_ROTATE_45_LEFT().value(m_startingDirection);
+    case Movement::TURN_RIGHT_90:
+      return DIRECTION_ROTATE_90_RIGHT().value(m_startingDirection);
+    case Movement::TURN_LEFT_90:
+      return DIRECTION_ROTATE_90_LEFT().value(m_startingDirection);
+    default:
+      return m_startingDirection;
+  }
+}
+
+int Simulation::mazeWidth() { return m_maze->getWidth(); }
+
+int Simulation::mazeHeight() { return m_maze->getHeight(); }
+
+bool Simulation::wallFront(int halfStepsAhead) {
+  return isWall(getPlannedTranslation(),
+                getPlannedRotation(), halfStepsAhead);
+}
+
+bool Simulation::wallRight(int halfStepsAhead) {
+  return isWall(getPlannedTranslation(),
+                DIRECTION_ROTATE_90_RIGHT().value(
+                    getPlannedRotation()),
+                halfStepsAhead);
+}
+
+bool Simulation::wallLeft(int halfStepsAhead) {
+  return isWall(getPlannedTranslation(),
+                DIRECTION_ROTATE_90_LEFT().value(
+                    getPlannedRotation()),
+                halfStepsAhead);
+}
+
+bool Simulation::wallBack(int halfStepsAhead) {
+  return isWall(
+      getPlannedTranslation(),
+      DIRECTION_ROTATE_180().value(getPlannedRotation()),
+      halfStepsAhead);
+}
+
+bool Simulation::wallFrontRight(int halfStepsAhead) {
+  return isWall(getPlannedTranslation(),
+                DIRECTION_ROTATE_45_RIGHT().value(
+                    getPlannedRotation()),
+                halfStepsAhead);
+}
+
+bool Simulation::wallFrontLeft(int halfStepsAhead) {
+  return isWall(getPlannedTranslation(),
+                DIRECTION_ROTATE_45_LEFT().value(
+                    getPlannedRotation()),
+                halfStepsAhead);
+}
+
+bool Simulation::wallBackRight(int halfStepsAhead) {
+  return isWall(
+      getPlannedTranslation(),
+      DIRECTION_ROTATE_90_RIGHT().value(DIRECTION_ROTATE_45_RIGHT().value(
+          getPlannedRotation())),
+      halfStepsAhead);
+}
+
+bool Simulation::wallBackLeft(int halfStepsAhead) {
+  return isWall(
+      getPlannedTranslation(),
+      DIRECTION_ROTATE_90_LEFT().value(DIRECTION_ROTATE_45_LEFT().value(
+          getPlannedRotation())),
+      halfStepsAhead);
+}
+
+int Simulation::walls(int halfStepsAhead) {
+  // The bit order is part of the API, so it must never change
+  int mask = 0;
+  mask |= wallFront(halfStepsAhead) << 0;
+  mask |= wallRight(halfStepsAhead) << 1;
+  mask |= wallBack(halfStepsAhead) << 2;
+  mask |= wallLeft(halfStepsAhead) << 3;
+  mask |= wallFrontRight(halfStepsAhead) << 4;
+  mask |= wallFrontLeft(halfStepsAhead) << 5;
+  mask |= wallBackRight(halfStepsAhead) << 6;
+  mask |= wallBackLeft(halfStepsAhead) << 7;
+  return mask;
+}
+
+QVector<int> Simulation::sensorScan() {
+  // The clear runs of all eight semi-directions are stored next to each
+  // other, so this reads a single 16-byte block, reordered to be relative to
+  // the mouse in the same order as the bits of walls()
+  SemiPosition semiPos = getPlannedTranslation();
+  SemiDirection front = getPlannedRotation();
+  SemiDirection frontRight = DIRECTION_ROTATE_45_RIGHT().value(front);
+  SemiDirection frontLeft = DIRECTION_ROTATE_45_LEFT().value(front);
+  QVector<SemiDirection> semiDirs = {
+      front,
+      DIRECTION_ROTATE_90_RIGHT().value(front),
+      DIRECTION_ROTATE_180().value(front),
+      DIRECTION_ROTATE_90_LEFT().value(front),
+      frontRight,
+      frontLeft,
+      DIRECTION_ROTATE_90_RIGHT().value(frontRight),
+      DIRECTION_ROTATE_90_LEFT().value(frontLeft),
+  };
+  QVector<int> distances;
+  distances.reserve(semiDirs.size());
+  for (SemiDirection semiDir : semiDirs) {
+    distances.append(getClearHalfSteps(semiPos, semiDir));
+  }
+  return distances;
+}
+
+QVector<int> Simulation::readSensors() {
+  return m_sensors.read(m_maze, m_mouse.getCurrentTranslation(),
+                        m_mouse.getCurrentRotation());
+}
+
+bool Simulation::setSensors(const QVector<int> &values) {
+  if (values.size() % 5 != 0) {
+    return false;
+  }
+  QVector<Sensor> sensors;
+  sensors.reserve(values.size() / 5);
+  for (int i = 0; i < values.size(); i += 5) {
+    sensors.append({Distance::Meters(values.at(i) / 1000.0),
+                    Distance::Meters(values.at(i + 1) / 1000.0),
+                    Angle::Degrees(values.at(i + 2)),
+                    Distance::Meters(values.at(i + 3) / 1000.0),
+                    Distance::Meters(values.at(i + 4) / 1000.0)});
+  }
+  return m_sensors.setSensors(sensors);
+}
+
+bool Simulation::moveForward(int numHalfSteps) {
+  // Non-positive distances aren't allowed
+  if (numHalfSteps < 1) {
+    return false;
+  }
+  // Special case for a wall directly in front of the mouse, else
+  // the wall won't be detected until after the mouse starts moving
+  if (wallFront(0)) {
+    return false;
+  }
+
+  // Compute the number of allowable moves
+  int allowableHalfSteps =
+      qMin(numHalfSteps,
+           getClearHalfSteps(m_mouse.getCurrentDiscretizedTranslation(),
+                             m_mouse.getCurrentDiscretizedRotation()));
+  m_doomedToCrash = (allowableHalfSteps != numHalfSteps);
+  m_halfStepsToMoveForward = allowableHalfSteps;
+
+  // Update m_movement based on current direction and requested steps
+  SemiDirection semiDir = m_mouse.getCurrentDiscretizedRotation();
+  if (!ORDINAL_DIRECTIONS().contains(semiDir)) {
+    m_movement = Movement::MOVE_STRAIGHT;
+  } else {
+    m_movement = Movement::MOVE_DIAGONAL;
+  }
+
+  // TODO: upforgrabs
+  // Starting position shouldn't be hardcoded here since it can depend on maze
+  if (m_startingPosition.toMazeLocation().first == 0 &&
+      m_startingPosition.toMazeLocation().second == 0) {
+    m_stats->startRun();
+  }
+  // TODO: upforgrabs
+  // Half steps shouldn't count as a full move
+  // increase the stats by the distance that will be travelled
+  Distance length = Dimensions::halfTileLength() * numHalfSteps;
+  if (m_movement == Movement::MOVE_DIAGONAL) {
+    length = length * qSqrt(2.0);
+  }
+  m_stats->addDistance(numHalfSteps, length);
+
+  // Return true so that the allowable movement can be executed
+  return true;
+}
+
+void Simulation::turn(Movement movement) {
+  ASSERT_TR(movement == Movement::TURN_LEFT_45 ||
+            movement == Movement::TURN_LEFT_90 ||
+            movement == Movement::TURN_RIGHT_45 ||
+            movement == Movement::TURN_RIGHT_90);
+
+  m_movement = movement;
+  // TODO: upforgrabs
+  // Setting these member variables should be unnecessary here
+  m_doomedToCrash = false;
+  m_halfStepsToMoveForward = 0;
+  // TODO: upforgrabs
+  // Half turns shouldn't count as full turn
+  bool isHalfTurn = movement == Movement::TURN_LEFT_45 ||
+                    movement == Movement::TURN_RIGHT_45;
+  m_stats->addTurn(Angle::Degrees(isHalfTurn ? 45 : 90));
+}
+
+void Simulation::setWall(int x, int y, QChar direction) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  if (!CHAR_TO_DIRECTION().contains(direction)) {
+    return;
+  }
+  declareWall({x, y, CHAR_TO_DIRECTION().value(direction)}, true);
+  updateWallStats();
+}
+
+void Simulation::clearWall(int x, int y, QChar direction) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  if (!CHAR_TO_DIRECTION().contains(direction)) {
+    return;
+  }
+  declareWall({x, y, CHAR_TO_DIRECTION().value(direction)}, false);
+  updateWallStats();
+}
+
+void Simulation::setWallMask(int x, int y, int mask) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  for (Direction d : CARDINAL_DIRECTIONS()) {
+    declareWall({x, y, d}, (mask & Maze::getWallBit(d)) != 0);
+  }
+  updateWallStats();
+}
+
+void Simulation::setWallGrid(const QString &masks) {
+  int width = m_maze->getWidth();
+  int height = m_maze->getHeight();
+  if (masks.size() != width * height) {
+    return;
+  }
+  QVector<int> grid;
+  grid.reserve(masks.size());
+  for (QChar c : masks) {
+    int mask = c.toLower().unicode();
+    if ('0' <= mask && mask <= '9') {
+      grid.append(mask - '0');
+    } else if ('a' <= mask && mask <= 'f') {
+      grid.append(mask - 'a' + 10);
+    } else {
+      return;
+    }
+  }
+  for (int x = 0; x < width; x += 1) {
+    for (int y = 0; y < height; y += 1) {
+      int mask = grid.at(getTileIndex(x, y));
+      for (Direction d : CARDINAL_DIRECTIONS()) {
+        if ((d == Direction::SOUTH && 0 < y) ||
+            (d == Direction::WEST && 0 < x)) {
+          continue;
+        }
+        declareWall({x, y, d}, (mask & Maze::getWallBit(d)) != 0);
+      }
+    }
+  }
+  updateWallStats();
+}
+
+void Simulation::declareWall(Wall wall, bool isWall) {
+  int numWrong = m_wallAccuracy.getNumWrong();
+  m_wallAccuracy.declare(wall.x, wall.y, wall.d, isWall);
+  if (!m_watchpoints.isEmpty()) {
+    pauseAt(m_watchpoints.onWallDeclared(numWrong <
+                                         m_wallAccuracy.getNumWrong()));
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  Wall opposingWall = getOpposingWall(wall);
+  bool hasOpposingWall = isWithinMaze(opposingWall.x, opposingWall.y);
+  if (isWall) {
+    m_view->setWall(wall.x, wall.y, wall.d);
+    if (hasOpposingWall) {
+      m_view->setWall(opposingWall.x, opposingWall.y, opposingWall.d);
+    }
+  } else {
+    m_view->clearWall(wall.x, wall.y, wall.d);
+    if (hasOpposingWall) {
+      m_view->clearWall(opposingWall.x, opposingWall.y, opposingWall.d);
+    }
+  }
+}
+
+void Simulation::updateWallStats() {
+  m_stats->setWallCounts(m_wallAccuracy.getNumCorrect(),
+                         m_wallAccuracy.getNumWrong(),
+                         m_wallAccuracy.getNumUndiscovered());
+}
+
+void Simulation::setColor(int x, int y, QChar color) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  if (!CHAR_TO_COLOR().contains(color)) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  m_view->setColor(x, y, CHAR_TO_COLOR().value(color));
+  m_tilesWithColor.insert(getTileIndex(x, y));
+}
+
+void Simulation::clearColor(int x, int y) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  m_view->clearColor(x, y);
+  m_tilesWithColor.remove(getTileIndex(x, y));
+}
+
+void Simulation::clearAllColor() {
+  int height = m_maze->getHeight();
+  for (int index : m_tilesWithColor.getTouched()) {
+    if (m_tilesWithColor.contains(index)) {
+      m_view->clearColor(index / height, index % height);
+    }
+  }
+  m_tilesWithColor.clear();
+}
+
+void Simulation::setText(int x, int y, QString text) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  m_view->setText(x, y, getPrintableText(text));
+  m_tilesWithText.insert(getTileIndex(x, y));
+}
+
+void Simulation::clearText(int x, int y) {
+  if (!isWithinMaze(x, y)) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  m_view->clearText(x, y);
+  m_tilesWithText.remove(getTileIndex(x, y));
+}
+
+void Simulation::clearAllText() {
+  int height = m_maze->getHeight();
+  for (int index : m_tilesWithText.getTouched()) {
+    if (m_tilesWithText.contains(index)) {
+      m_view->clearText(index / height, index % height);
+    }
+  }
+  m_tilesWithText.clear();
+}
+
+void Simulation::setColorGrid(const QString &colors) {
+  int height = m_maze->getHeight();
+  if (colors.size() != m_maze->getWidth() * height) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  QVector<QPair<bool, Color>> grid;
+  grid.reserve(colors.size());
+  for (QChar c : colors) {
+    if (c == GRID_NO_COLOR) {
+      grid.append({false, Color::BLACK});
+    } else if (CHAR_TO_COLOR().contains(c)) {
+      grid.append({true, CHAR_TO_COLOR().value(c)});
+    } else {
+      return;
+    }
+  }
+  m_view->setColorGrid(grid);
+  for (int i = 0; i < grid.size(); i += 1) {
+    if (grid.at(i).first) {
+      m_tilesWithColor.insert(i);
+    } else {
+      m_tilesWithColor.remove(i);
+    }
+  }
+}
+
+void Simulation::setTextGrid(int fieldWidth, const QString &texts) {
+  int height = m_maze->getHeight();
+  int numTiles = m_maze->getWidth() * height;
+  if (fieldWidth < 1 || texts.size() != fieldWidth * numTiles) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  QString printable = getPrintableText(texts);
+  QVector<QString> grid;
+  grid.reserve(numTiles);
+  for (int i = 0; i < numTiles; i += 1) {
+    int length = fieldWidth;
+    while (0 < length && printable.at(i * fieldWidth + length - 1) == ' ') {
+      length -= 1;
+    }
+    grid.append(printable.mid(i * fieldWidth, length));
+    if (0 < length) {
+      m_tilesWithText.insert(i);
+    } else {
+      m_tilesWithText.remove(i);
+    }
+  }
+  m_view->setTextGrid(grid);
+}
+
+void Simulation::drawPath(QChar color, const QVector<Cell> &points) {
+  if (!CHAR_TO_COLOR().contains(color)) {
+    return;
+  }
+  if (m_view == nullptr) {
+    return;
+  }
+  QVector<SemiPosition> path;
+  path.reserve(points.size());
+  for (const Cell &point : points) {
+    if (point.x < 0 || 2 * m_maze->getWidth() < point.x || point.y < 0 ||
+        2 * m_maze->getHeight() < point.y) {
+      return;
+    }
+    path.append({point.x, point.y});
+  }
+  m_view->setPath(path, CHAR_TO_COLOR().value(color));
+}
+
+void Simulation::clearPath() {
+  if (m_view == nullptr) {
+    return;
+  }
+  m_view->clearPath();
+}
+
+bool Simulation::wasReset() { return m_wasReset; }
+
+void Simulation::ackReset() {
+  m_mouse.reset();
+  emit mouseMoved();
+  m_startingPosition = INITIAL_STARTING_POSITION;
+  m_startingDirection = INITIAL_STARTING_DIRECTION;
+  QPair<int, int> start = m_startingPosition.toMazeLocation();
+  m_visitCounts.addVisit(start.first, start.second);
+  m_movement = Movement::NONE;
+  m_movementProgress = 0.0;
+  m_wasReset = false;
+  m_numAcknowledgedResets += 1;
+  if (m_firstAcknowledgedMovement < 0) {
+    m_firstAcknowledgedMovement = m_numMovements;
+  }
+  m_stats->penalizeForReset();
+  m_stats->endUnfinishedRun();
+  emit resetAcknowledged();
+}
+
+QString Simulation::getPrintableText(QString text) {
+  // Characters that aren't in the font image are shown as question marks
+  static QRegularExpression regex = QRegularExpression(
+      QString("[^") + FontImage::characters() + QString("]"));
+  return text.replace(regex, "?");
+}
+
+Response Simulation::boolResponse(bool value) const {
+  return {ResponseType::BOOL, value ? 1.0 : 0.0};
+}
+
+bool Simulation::isWall(SemiPosition semiPos, SemiDirection semiDir) const {
+  return m_blockedSemiDirections.at(getSemiIndex(semiPos)) &
+         (1 << static_cast<int>(semiDir));
+}
+
+bool Simulation::isWall(SemiPosition semiPos, SemiDirection semiDir,
+                        int halfStepsAhead) const {
+  // There's a wall obstructing the path if the mouse would be blocked at or
+  // before the given number of half-steps ahead
+  return getClearHalfSteps(semiPos, semiDir) <= qMax(halfStepsAhead, 0);
+}
+
+int Simulation::getClearHalfSteps(SemiPosition semiPos,
+                                  SemiDirection semiDir) const {
+  return m_clearHalfSteps.at(8 * getSemiIndex(semiPos) +
+                             static_cast<int>(semiDir));
+}
+
+int Simulation::getSemiIndex(SemiPosition semiPos) const {
+  ASSERT_LE(0, semiPos.x);
+  ASSERT_LE(semiPos.x, m_maze->getWidth() * 2);
+  ASSERT_LE(0, semiPos.y);
+  ASSERT_LE(semiPos.y, m_maze->getHeight() * 2);
+  return m_semiHeight * semiPos.x + semiPos.y;
+}
+
+int Simulation::getTileIndex(int x, int y) const {
+  ASSERT_TR(isWithinMaze(x, y));
+  return m_maze->getHeight() * x + y;
+}
+
+void Simulation::refreshWalls() {
+  // The declarations stay the same, but whether they're correct may not
+  m_wallAccuracy.recount();
+  updateWallStats();
+
+  m_semiHeight = m_maze->getHeight() * 2 + 1;
+  getWallTables(m_maze, &m_blockedSemiDirections, &m_clearHalfSteps);
+}
+
+void Simulation::getWallTables(const Maze *maze,
+                               QVector<unsigned char> *blockedSemiDirections,
+                               QVector<unsigned short> *clearHalfSteps) {
+  int semiWidth = maze->getWidth() * 2 + 1;
+  int semiHeight = maze->getHeight() * 2 + 1;
+
+  // First, determine which of the eight semi-directions are blocked at each
+  // semi-position; the mouse is never inside a corner, so those are skipped
+  blockedSemiDirections->fill(0xff, semiWidth * semiHeight);
+  for (int x = 0; x < semiWidth; x += 1) {
+    for (int y = 0; y < semiHeight; y += 1) {
+      if (x % 2 == 0 && y % 2 == 0) {
+        continue;
+      }
+      unsigned char blocked = 0;
+      for (int i = 0; i < 8; i += 1) {
+        if (isWallInMaze(maze, {x, y}, static_cast<SemiDirection>(i))) {
+          blocked |= 1 << i;
+        }
+      }
+      (*blockedSemiDirections)[semiHeight * x + y] = blocked;
+    }
+  }
+
+  // Then, accumulate the clear runs in each direction, starting from the far
+  // end so that the run of the next semi-position is always known
+  clearHalfSteps->fill(0, 8 * semiWidth * semiHeight);
+  for (int i = 0; i < 8; i += 1) {
+    SemiDirection semiDir = static_cast<SemiDirection>(i);
+    QPair<int, int> step = getSemiStep(semiDir);
+    for (int j = 0; j < semiWidth; j += 1) {
+      int x = 0 < step.first ? semiWidth - 1 - j : j;
+      for (int k = 0; k < semiHeight; k += 1) {
+        int y = 0 < step.second ? semiHeight - 1 - k : k;
+        if (blockedSemiDirections->at(semiHeight * x + y) & (1 << i)) {
+          continue;
+        }
+        int nextX = x + step.first;
+        int nextY = y + step.second;
+        int next = 0;
+        if (0 <= nextX && nextX < semiWidth && 0 <= nextY &&
+            nextY < semiHeight) {
+          next = clearHalfSteps->at(8 * (semiHeight * nextX + nextY) + i);
+        }
+        (*clearHalfSteps)[8 * (semiHeight * x + y) + i] = next + 1;
+      }
+    }
+  }
+}
+
+bool Simulation::isWallInMaze(const Maze *maze, SemiPosition semiPos,
+                              SemiDirection semiDir) {
+  ASSERT_LE(0, semiPos.x);
+  ASSERT_LE(semiPos.x, maze->getWidth() * 2);
+  ASSERT_LE(0, semiPos.y);
+  ASSERT_LE(semiPos.y, maze->getHeight() * 2);
+
+  // Maze locations
+  auto mazeLocation = semiPos.toMazeLocation();
+  int mazeX = mazeLocation.first;
+  int mazeY = mazeLocation.second;
+
+  // Should never be inside a corner
+  if (semiPos.x % 2 == 0 && semiPos.y % 2 == 0) {
+    ASSERT_NEVER_RUNS();
+  }
+  // We're in the center of the cell
+  else if (semiPos.x % 2 == 1 && semiPos.y % 2 == 1) {
+    if (ORDINAL_DIRECTIONS().contains(semiDir)) {
+      // We're aiming at a corner
+      return true;
+    }
+    Direction d = SEMI_TO_CARDINAL().value(semiDir);
+    return maze->isWall(mazeX, mazeY, d);
+  }
+  // We're on the vertical edge of a cell
+  else if (semiPos.x % 2 == 0 && semiPos.y % 2 == 1) {
+    // Facing a corner post
+    if (semiDir == SemiDirection::NORTH || semiDir == SemiDirection::SOUTH) {
+      return true;
+    }
+    // Facing center of cell
+    else if (semiDir == SemiDirection::EAST || semiDir == SemiDirection::WEST) {
+      return false;
+    } else if (semiDir == SemiDirection::NORTHEAST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.x == maze->getWidth() * 2) {
+        return false;
+      }
+      return maze->isWall(mazeX, mazeY, Direction::NORTH);
+    } else if (semiDir == SemiDirection::SOUTHEAST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.x == maze->getWidth() * 2) {
+        return false;
+      }
+      return maze->isWall(mazeX, mazeY, Direction::SOUTH);
+    } else if (semiDir == SemiDirection::NORTHWEST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.x == 0) {
+        return false;
+      }
+      return maze->isWall(mazeX - 1, mazeY, Direction::NORTH);
+    } else if (semiDir == SemiDirection::SOUTHWEST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.x == 0) {
+        return false;
+      }
+      return maze->isWall(mazeX - 1, mazeY, Direction::SOUTH);
+    }
+  }
+  // We're on the horizontal edge of a cell
+  else if (semiPos.x % 2 == 1 && semiPos.y % 2 == 0) {
+    // Facing a corner post
+    if (semiDir == SemiDirection::EAST || semiDir == SemiDirection::WEST) {
+      return true;
+    }
+    // Facing center of cell
+    else if (semiDir == SemiDirection::NORTH ||
+             semiDir == SemiDirection::SOUTH) {
+      return false;
+    } else if (semiDir == SemiDirection::NORTHEAST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.y == maze->getHeight() * 2) {
+        return false;
+      }
+      return maze->isWall(mazeX, mazeY, Direction::EAST);
+    } else if (semiDir == SemiDirection::NORTHWEST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.y == maze->getHeight() * 2) {
+        return false;
+      }
+      return maze->isWall(mazeX, mazeY, Direction::WEST);
+    } else if (semiDir == SemiDirection::SOUTHEAST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.y == 0) {
+        return false;
+      }
+      return maze->isWall(mazeX, mazeY - 1, Direction::EAST);
+    } else if (semiDir == SemiDirection::SOUTHWEST) {
+      // On the edge of the maze, no walls outside
+      if (semiPos.y == 0) {
+        return false;
+      }
+      return maze->isWall(mazeX, mazeY - 1, Direction::WEST);
+    }
+  } else {
+    ASSERT_NEVER_RUNS();
+  }
+}
+
+QPair<int, int> Simulation::getSemiStep(SemiDirection semiDir) {
+  switch (semiDir) {
+    case SemiDirection::NORTH:
+      return {0, 1};
+    case SemiDirection::SOUTH:
+      return {0, -1};
+    case SemiDirection::EAST:
+      return {1, 0};
+    case SemiDirection::WEST:
+      return {-1, 0};
+    case SemiDirection::NORTHEAST:
+      return {1, 1};
+    case SemiDirection::NORTHWEST:
+      return {-1, 1};
+    case SemiDirection::SOUTHEAST:
+      return {1, -1};
+    case SemiDirection::SOUTHWEST:
+      return {-1, -1};
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+bool Simulation::isWithinMaze(int x, int y) const {
+  return (0 <= x && x < m_maze->getWidth() && 0 <= y &&
+          y < m_maze->getHeight());
+}
+
+Wall Simulation::getOpposingWall(Wall wall) const {
+  switch (wall.d) {
+    case Direction::NORTH:
+      return {wall.x, wall.y + 1, Direction::SOUTH};
+    case Direction::EAST:
+      return {wall.x + 1, wall.y, Direction::WEST};
+    case Direction::SOUTH:
+      return {wall.x, wall.y - 1, Direction::NORTH};
+    case Direction::WEST:
+      return {wall.x - 1, wall.y, Direction::EAST};
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+Coordinate Simulation::getCoordinate(SemiPosition semiPos) const {
+  QPair<int, int> mazeLocation = semiPos.toMazeLocation();
+  ASSERT_TR(isWithinMaze(mazeLocation.first, mazeLocation.second));
+  Coordinate coordinate = Coordinate::Cartesian(
+      Dimensions::halfTileLength() * static_cast<double>(semiPos.x),
+      Dimensions::halfTileLength() * static_cast<double>(semiPos.y));
+  return coordinate;
+}
+
+
+}  // namespace mms
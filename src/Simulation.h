@@ -0,0 +1,560 @@
+#pragma once
+
+#include <QByteArray>
+#include <QChar>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include "AlgoMetrics.h"
+#include "Command.h"
+#include "CommandParser.h"
+#include "CommandQueue.h"
+#include "LatencyHistogram.h"
+#include "Maze.h"
+#include "MazeGraphic.h"
+#include "Mouse.h"
+#include "ReplayLog.h"
+#include "ResetInjection.h"
+#include "RunTrace.h"
+#include "SensorArray.h"
+#include "Stats.h"
+#include "TileSet.h"
+#include "VisitCounts.h"
+#include "WallAccuracy.h"
+#include "Watchpoints.h"
+
+namespace mms {
+
+enum class Movement {
+  MOVE_STRAIGHT,
+  MOVE_DIAGONAL,
+  TURN_RIGHT_45,
+  TURN_RIGHT_90,
+  TURN_LEFT_45,
+  TURN_LEFT_90,
+  NONE,
+};
+
+struct Wall {
+  int x;
+  int y;
+  Direction d;
+};
+
+// The Simulation class contains all of the state for a single run of a mouse
+// algo: the mouse, its movement, the command queue, and the stats. It has no
+// dependency on any widget, so it can be driven by the GUI or run headless,
+// and it's cheap to create, so many simulations can run in one process.
+class Simulation : public QObject {
+  Q_OBJECT
+
+ public:
+  // None of the arguments are owned by the simulation. The view may be null,
+  // in which case visualization commands are validated but have no effect.
+  // Responses to the algo are written to the output device.
+  Simulation(const Maze *maze, MazeGraphic *view, Stats *stats,
+             QIODevice *output, QObject *parent = nullptr);
+
+  const Mouse *getMouse() const;
+
+  // Where the mouse has been, counted as each movement completes; not const,
+  // so that whatever draws the counts can clear their dirty ranges
+  VisitCounts *getVisitCounts();
+  const VisitCounts *getVisitCounts() const;
+
+  // Processes bytes that the algo wrote to stdout. Once the command queue is
+  // full, the rest are left unparsed until a command is answered, so the
+  // owner should stop reading from the algo (see getCommandQueueRoom).
+  void processOutput(const QByteArray &bytes);
+
+  // Processes output that was already parsed elsewhere, e.g., by an
+  // AlgoChannel, along with the reason that parsing stopped. Returns whether
+  // a handshake was accepted, in which case the parser must switch to binary.
+  // A handshake that arrives while earlier commands are still queued is
+  // accepted once they've all been answered, with handshakeAccepted, and
+  // there's no room for more commands until then. There must be room in the
+  // queue for every command (see below).
+  bool processCommands(const QVector<Command> &commands,
+                       CommandParser::Status status);
+
+  // How many more commands can be queued; whoever reads or parses the algo's
+  // output should stop once there's no room, and wait for readyForCommands,
+  // so that the output backs up into the pipe (or socket, or ring) instead of
+  // into memory. There's also no room while processing is deferred (see
+  // setTimeBudget). The most commands that were ever queued at once is a
+  // measure of how far ahead the algo got.
+  int getCommandQueueRoom() const;
+  int getMaxQueuedCommands() const;
+  qint64 getCommandQueueMemoryBytes() const;
+
+  // Use the binary protocol from the start, without a handshake
+  void useBinaryProtocol();
+  bool isBinaryProtocol() const;
+
+  // Executes the command immediately and returns its response, rather than
+  // writing it to the output device; used by in-process algos. Movements are
+  // completed before returning, so the simulation must be instant.
+  Response execute(const Command &command);
+
+  // Stop consuming commands and writing responses, e.g., once the algo exits
+  void stop();
+
+  void setPaused(bool paused);
+  bool isPaused() const;
+
+  // Simulates a crash; the algo is notified via wasReset
+  void requestReset();
+
+  // Resets are also requested whenever the schedule says so, e.g., in a
+  // headless batch, where there's no reset button. Triggers that come due
+  // while a reset is still unacknowledged are dropped. Movements are counted
+  // from when the simulation is created, so a restored snapshot starts the
+  // schedule over.
+  void setResetInjection(const ResetInjection &injection);
+
+  // The run pauses itself, as if by setPaused, whenever one of the
+  // watchpoints is hit, and emits watchpointHit; commands and movements are
+  // counted from when the simulation is created, as for resets. May be
+  // changed at any time, which starts the watchpoints over.
+  void setWatchpoints(const Watchpoints &watchpoints);
+
+  // Everything random in the run, e.g., sensor noise and injected resets, is
+  // drawn from streams of the key (see RandomStream), which is zero unless
+  // it's set, so the run is the same wherever and whenever it's simulated;
+  // must be set before any commands arrive
+  void setRandomKey(quint64 key);
+
+  // The resets that the schedule requested, the resets that the algo
+  // acknowledged (whether injected or not), and the movements from the first
+  // acknowledgment until the mouse next reached the center, which is the
+  // cost of recovering, or -1 if it hasn't yet
+  int getNumInjectedResets() const;
+  int getNumAcknowledgedResets() const;
+  int getRecoveryMovements() const;
+
+  // Marks the run as having been resumed from a checkpoint (see
+  // SimulationCheckpoint), which a restarted algo can ask about via
+  // wasResumed before picking up where its previous process left off
+  void setResumed();
+
+  // Answers a nextMaze command, once nextMazeRequested has been emitted. If
+  // there's another maze, the algo starts over on it, so the owner must
+  // replace this simulation with a fresh one on the same output (in the same
+  // protocol); otherwise the algo is expected to exit, as if it had never
+  // asked. Commands after nextMaze are held until it's answered.
+  void answerNextMaze(bool isNextMaze);
+
+  // The rate at which movements are animated
+  void setProgressPerSecond(double progressPerSecond);
+
+  // If instant, movements complete in a single step and are acknowledged
+  // immediately, rather than being animated
+  void setInstant(bool instant);
+
+  // If lockstep, each tick of the clock advances virtual time by exactly the
+  // amount that was scheduled, no matter how much real time passed, so that
+  // the mouse is sampled at the same virtual times on every run
+  void setLockstep(bool lockstep);
+
+  // If frame-paced, and not instant, movements take a frame apiece, however
+  // long they'd take at the current speed: each one completes only once the
+  // previous one was drawn, which the owner signals via onFrameShown, so that
+  // no state of the mouse is ever skipped but none is shown for longer than
+  // necessary. Movements wait while no frames are drawn, e.g., while the
+  // window is minimized.
+  void setFramePaced(bool framePaced);
+  void onFrameShown();
+
+  // If positive, commands are only processed for about this long, in real
+  // time, per turn of the event loop, and the rest are deferred to the next
+  // turn, so that a flood of commands can't keep the GUI from redrawing. If
+  // zero (the default), everything that's ready is processed at once.
+  void setTimeBudget(double seconds);
+
+  // The virtual time that the mouse has spent moving, which advances at the
+  // same rate as real time (unless in lockstep) but only while moving
+  double getVirtualSeconds() const;
+
+  // If set, every command, response, and reset is appended to the log, which
+  // isn't owned by the simulation
+  void setReplayLog(ReplayLog *log);
+
+  // Likewise for the trace, which also has the pose and stats of the mouse
+  // at each record
+  void setTrace(RunTrace *trace);
+
+  // If tracking, each command is timed in real time, from when it arrives to
+  // when it's answered (the simulator's service time), and each response from
+  // when it's written until the next command arrives, if the algo had nothing
+  // else to wait for (the algo's think time). Must be set before any
+  // commands arrive.
+  void setLatencyTracking(bool tracking);
+  const LatencyHistogram &getServiceTimes() const;
+  const LatencyHistogram &getThinkTimes() const;
+
+  // The samples of the metric command, in virtual time
+  const AlgoMetrics *getAlgoMetrics() const;
+
+  // If positive, hung is emitted once the algo has kept the simulator waiting
+  // for this long, in real time, either for its first command or for the one
+  // after a response; starts counting right away
+  void setHangTimeout(double seconds);
+
+  // The state of the simulation between commands, apart from the view
+  struct Snapshot {
+    SemiPosition position;
+    SemiDirection direction;
+    bool wasReset;
+    qint64 elapsedClockSteps;
+    Stats::State stats;
+    VisitCounts visits;
+    WallAccuracy walls;
+  };
+
+  // Whether the mouse is stopped and there are no commands in progress, in
+  // which case a snapshot completely describes the simulation
+  bool isIdle() const;
+  Snapshot getSnapshot() const;
+
+  // Abandons any commands in progress and resumes from the snapshot. The
+  // view must already have been restored to the same point.
+  void restoreSnapshot(const Snapshot &snapshot);
+
+  // Must be called whenever the walls of the maze change, e.g., by an editor
+  void refreshWalls();
+
+  static const double MIN_PROGRESS_PER_SECOND;
+  static const double MAX_PROGRESS_PER_SECOND;
+
+  // The progress required for each movement, i.e., how long it takes
+  static const double PROGRESS_PER_STRAIGHT_HALF_STEP;
+  static const double PROGRESS_PER_DIAGONAL_HALF_STEP;
+  static const double PROGRESS_PER_45_DEGREE_TURN;
+  static const double PROGRESS_PER_90_DEGREE_TURN;
+
+  // Whether a half-step in the semi-direction from the semi-position, which
+  // must not be a corner, would hit a wall of the maze
+  static bool isWallInMaze(const Maze *maze, SemiPosition semiPos,
+                           SemiDirection semiDir);
+
+  // The change in semi-position of a half-step in the semi-direction
+  static QPair<int, int> getSemiStep(SemiDirection semiDir);
+
+  // The wall tables of the maze, as kept by every simulation of it, indexed
+  // by semiHeight * x + y, and 8 * that + semiDir for the clear half-steps
+  // (see m_blockedSemiDirections); e.g., to check moves without a simulation
+  static void getWallTables(const Maze *maze,
+                            QVector<unsigned char> *blockedSemiDirections,
+                            QVector<unsigned short> *clearHalfSteps);
+
+  // Where every run starts
+  static const SemiPosition INITIAL_STARTING_POSITION;
+  static const SemiDirection INITIAL_STARTING_DIRECTION;
+
+ signals:
+  void resetAcknowledged();
+
+  // See setWatchpoints; the watchpoint is as written in the list
+  void watchpointHit(const QString &watchpoint);
+
+  // See setHangTimeout
+  void hung();
+
+  // Emitted once the algo is done with the maze and asks for another one,
+  // see answerNextMaze
+  void nextMazeRequested();
+
+  // Emitted once a command is answered while the queue was full, or once
+  // deferred processing resumes, i.e., once there's room for more, see
+  // getCommandQueueRoom
+  void readyForCommands();
+
+  // Emitted once a handshake that had to wait for the queue to drain is
+  // accepted, see processCommands
+  void handshakeAccepted();
+
+  // Emitted whenever the mouse is moved or the view is modified, i.e., when
+  // they need to be redrawn
+  void mouseMoved();
+  void viewChanged();
+
+ private:
+  // ----- Inputs and outputs -----
+
+  const Maze *m_maze;
+  MazeGraphic *m_view;
+  Stats *m_stats;
+  QIODevice *m_output;
+
+  // ----- Pause/reset ----
+
+  bool m_isPaused;
+  bool m_wasReset;
+  bool m_wasResumed;
+  bool m_isAwaitingNextMaze;
+  ResetInjection m_resetInjection;
+  Watchpoints m_watchpoints;
+  int m_numCommands;
+  quint64 m_randomKey;
+  int m_numMovements;
+  int m_numInjectedResets;
+  int m_numAcknowledgedResets;
+  int m_firstAcknowledgedMovement;  // -1 until a reset is acknowledged
+  int m_recoveryMovements;
+
+  // ----- Communication -----
+
+  // Whether the algo switched to the binary protocol
+  bool m_isBinary;
+
+  CommandParser m_parser;
+  bool m_isParsing;  // so that output isn't parsed again while dispatching
+
+  // Bounded, so that an algo that gets far ahead, e.g., while paused or
+  // during a long movement, is held back rather than growing the queue
+  static const int MAX_QUEUED_COMMANDS;
+  CommandQueue m_commandQueue;
+  QTimer *m_commandQueueTimer;
+
+  // Responses are batched and written together once the current chunk of
+  // output (or tick of the clock) has been processed, so that pipelined
+  // algos get one write per batch rather than one per response
+  QByteArray m_responseBuffer;
+
+  ReplayLog *m_replayLog;
+  RunTrace *m_trace;
+
+  // Arrival times of the queued commands, if tracking latency, and the time
+  // of the last response that left the algo with nothing to wait for, or -1
+  bool m_isTrackingLatency;
+  QQueue<qint64> m_commandArrivals;
+  qint64 m_lastResponseNanoseconds;
+  LatencyHistogram m_serviceTimes;
+  LatencyHistogram m_thinkTimes;
+  AlgoMetrics m_algoMetrics;
+  QTimer *m_hangTimer;  // null unless there's a hang timeout
+
+  // Processing that runs past the budget is deferred until the event loop
+  // has had a turn; a slice of the budget starts with the first command
+  // that's processed after that
+  qint64 m_timeBudgetNanoseconds;
+  qint64 m_sliceStartNanoseconds;  // -1 once the event loop has had a turn
+  bool m_isDeferred;
+
+  // An algo may pipeline commands ahead of the handshake, which is answered
+  // in order, after them, so nothing after it is parsed until then
+  bool m_isHandshakePending;
+
+  void onCommandArrived(bool isQueued);
+  void onCommandAnswered();
+
+  void parseOutput();
+  void dispatchCommand(const Command &command);
+  void dequeueCommand();
+  void acceptHandshake();
+  bool isOverBudget();
+  void deferProcessing();
+  void resumeProcessing();
+  bool performInlineCommand(const Command &command);
+  Response executeCommand(const Command &command);
+  void processQueuedCommands();
+  void writeResponse(const Response &response);
+  void flushResponses();
+  void recordCommand(const Command &command);
+  void recordResponse(const Response &response);
+  void recordReset();
+  void traceRecord(RunTrace::Kind kind, int code, double value);
+
+  // ----- Movement -----
+
+  // At most Mouse::DRAW_DELAY_SECONDS, so that the drawn mouse always has a
+  // pose to move toward
+  static const double MAX_SLEEP_SECONDS;
+
+  Mouse m_mouse;
+  SensorArray m_sensors;  // as configured by the algo, else the default
+  VisitCounts m_visitCounts;
+  SemiPosition m_startingPosition;
+  SemiDirection m_startingDirection;
+  Movement m_movement;
+  bool m_doomedToCrash;  // if the requested movement will result in a crash
+  int m_halfStepsToMoveForward;  // the number of allowable half-steps for the
+                                 // movement
+  int m_sequenceStep;  // the next step of the move sequence in progress
+  bool m_isAsync;             // see isAnsweredWhileMoving
+  bool m_isMovementAnswered;  // when it started, since moves were async
+  bool m_hasWallAcks;  // movements are acked with the walls around the mouse
+  double m_movementProgress;
+  double m_progressPerSecond;
+  bool m_isInstant;
+  bool m_isFramePaced;
+  bool m_isFrameShown;     // since the last movement completed
+  bool m_isAwaitingFrame;  // a movement is waiting for onFrameShown
+
+  // With async moves, a move is answered as soon as it starts, with whether
+  // it will crash, and the grid queries that follow it are answered while it
+  // drives, against where the mouse will be once it stops. Anything else
+  // waits for the mouse to stop, as do moves in the first place.
+  static bool isAnsweredWhileMoving(CommandType type);
+  SemiPosition getPlannedTranslation() const;
+  SemiDirection getPlannedRotation() const;
+
+  double progressRequired(Movement movement);
+  void updateMouseProgress(double progress);
+  void completeMovement();
+
+  // A move sequence is answered once, after its last step, or as soon as one
+  // of its steps crashes. Each step is started when the previous one ends.
+  Response startSequenceStep(const Command &command);
+  Response finishMovement(const Command &command);
+  Response getCrash(const Command &command) const;
+  Response getAck();
+
+  // Counts the movement that just completed, and requests a reset if the
+  // schedule says so (see setResetInjection)
+  void injectResets();
+
+  // Pauses the run at the watchpoint, unless it's null, i.e., none was hit
+  void pauseAt(const QString &watchpoint);
+  void scheduleMouseProgressUpdate();
+  double getPoseTimestamp() const;
+  bool isMoving();
+
+  // ----- Clock -----
+
+  // Movements advance in fixed steps of virtual time. Time is banked as it
+  // passes and spent on the current movement, and whatever a movement doesn't
+  // use carries over to the next one, so the rate of movement doesn't depend
+  // on the granularity of the timer.
+  static const qint64 CLOCK_STEP_NANOSECONDS;
+  static const qint64 MAX_CATCH_UP_NANOSECONDS;
+
+  QElapsedTimer m_clock;
+  bool m_isClockRunning;
+  bool m_isLockstep;
+  qint64 m_lastTickNanoseconds;
+  qint64 m_bankedNanoseconds;
+  qint64 m_scheduledClockSteps;
+  qint64 m_elapsedClockSteps;
+
+  void onClockTick();
+  void spendClockSteps();
+  qint64 getVirtualMicroseconds() const;
+  qint64 getRequiredClockSteps();
+  double getProgressPerClockStep() const;
+
+  // ----- API -----
+
+  int mazeWidth();
+  int mazeHeight();
+
+  // Is there a wall in front of the mouse N half-steps ahead of where it
+  // currently is? Zero means current position of the mouse.
+  bool wallFront(int halfStepsAhead);
+  bool wallRight(int halfStepsAhead);
+  bool wallLeft(int halfStepsAhead);
+  bool wallBack(int halfStepsAhead);
+  bool wallFrontRight(int halfStepsAhead);
+  bool wallFrontLeft(int halfStepsAhead);
+  bool wallBackRight(int halfStepsAhead);
+  bool wallBackLeft(int halfStepsAhead);
+
+  // All of the above as a bitmask, in order: front, right, back, left,
+  // front-right, front-left, back-right, back-left
+  int walls(int halfStepsAhead);
+
+  // The number of half-steps that the mouse could move in each direction
+  // before hitting a wall, in the same order as walls()
+  QVector<int> sensorScan();
+
+  // The readings of the mouse's distance sensors, in millimeters, see
+  // SensorArray::read
+  QVector<int> readSensors();
+
+  // Replaces the sensors with those given by five integers each: the
+  // position of the sensor forward and left of the mouse's center, its
+  // counterclockwise rotation in degrees, its range, and the standard
+  // deviation of its noise, all in millimeters. Returns false, keeping the
+  // current sensors, if they're invalid (see SensorArray::setSensors).
+  bool setSensors(const QVector<int> &values);
+
+  bool moveForward(int numHalfSteps);
+  void turn(Movement movement);
+
+  void setWall(int x, int y, QChar direction);
+  void clearWall(int x, int y, QChar direction);
+
+  // All four walls of a tile at once, as a bitmask (see Maze::getWallBit),
+  // and every tile's mask at once, as a hex digit, column by column. Each
+  // wall between two tiles of a grid is taken from the tile below it or to
+  // the left of it, so it's only declared and drawn once. Grids of the wrong
+  // size are ignored.
+  void setWallMask(int x, int y, int mask);
+  void setWallGrid(const QString &masks);
+
+  void setColor(int x, int y, QChar color);
+  void clearColor(int x, int y);
+  void clearAllColor();
+
+  void setText(int x, int y, QString text);
+  void clearText(int x, int y);
+  void clearAllText();
+
+  // Every tile at once, column by column; see MazeGraphic::setColorGrid.
+  // Tiles without a color are given GRID_NO_COLOR, and text fields are
+  // padded with trailing spaces. Grids of the wrong size are ignored.
+  static const QChar GRID_NO_COLOR;
+  void setColorGrid(const QString &colors);
+  void setTextGrid(int fieldWidth, const QString &texts);
+
+  // The points of a path are semi-positions, and are only drawn if all of
+  // them are within the maze
+  void drawPath(QChar color, const QVector<Cell> &points);
+  void clearPath();
+
+  bool wasReset();
+  void ackReset();
+
+  // ----- Helpers -----
+
+  // The tiles that an algo has colored or labeled, so that clearing them
+  // all only visits the tiles that were touched
+  TileSet m_tilesWithColor;
+  TileSet m_tilesWithText;
+
+  // The walls that the algo declared, compared against the maze's as they
+  // change, whether or not there's a view to draw them in
+  WallAccuracy m_wallAccuracy;
+  void updateWallStats();
+
+  // Declares the wall and draws both of its sides, without the stats
+  void declareWall(Wall wall, bool isWall);
+
+  // For each semi-position, a bitmask of the semi-directions (by value) that
+  // are blocked, and for each semi-position and semi-direction, the number
+  // of half-steps that can be taken before being blocked. These make all
+  // wall queries O(1), no matter how far ahead they look.
+  int m_semiHeight;
+  QVector<unsigned char> m_blockedSemiDirections;
+  QVector<unsigned short> m_clearHalfSteps;
+
+  Response boolResponse(bool value) const;
+  static QString getPrintableText(QString text);
+  bool isWall(SemiPosition semiPos, SemiDirection semiDir) const;
+  bool isWall(SemiPosition semiPos, SemiDirection semiDir,
+              int halfStepsAhead) const;
+  int getClearHalfSteps(SemiPosition semiPos, SemiDirection semiDir) const;
+  int getSemiIndex(SemiPosition semiPos) const;
+  int getTileIndex(int x, int y) const;
+  bool isWithinMaze(int x, int y) const;
+  Wall getOpposingWall(Wall wall) const;
+  Coordinate getCoordinate(SemiPosition semiPos) const;
+};
+
+}  // namespace mms
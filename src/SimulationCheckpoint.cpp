@@ -0,0 +1,337 @@
+#include "SimulationCheckpoint.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+
+namespace mms {
+
+// Layout (all integers are little-endian):
+//   [0, 4)     magic ("MMSC")
+//   [4, 6)     version
+//   [6, 8)     reserved, zero
+//   [8, ...)   five sections, each prefixed by four bytes of size: the maze,
+//              in the binary maze format; the snapshot; the visit counts (see
+//              VisitCounts::toBytes); the declared walls (see
+//              WallAccuracy::toBytes); and the view, which is empty if there
+//              was none
+//
+// The snapshot is the semi-position (four bytes for each of x and y), the
+// semi-direction and whether a reset is pending (a byte each), the elapsed
+// clock steps (eight bytes), and the stats: their count, that many values,
+// then the rest of Stats::State, in order. The count lets a later version
+// with more stats read the checkpoint, with the new stats left as they were.
+//
+// The view is a tile at a time, column by column: a byte of walls (see
+// Maze::getWallBit), a byte of color (or NO_COLOR), and size-prefixed UTF-8
+// text; then the path, as a byte of color, a count of semi-positions, and
+// four bytes for each of their x and y.
+const quint32 SimulationCheckpoint::MAGIC = 0x43534d4d;  // "MMSC"
+const quint16 SimulationCheckpoint::VERSION = 1;
+const int SimulationCheckpoint::HEADER_SIZE = 8;
+const unsigned char SimulationCheckpoint::NO_COLOR = 0xff;
+
+QByteArray SimulationCheckpoint::save(const Maze *maze,
+                                      const Simulation *simulation,
+                                      const MazeGraphic *view) {
+  Simulation::Snapshot snapshot = simulation->getSnapshot();
+  QByteArray bytes(HEADER_SIZE, 0);
+  qToLittleEndian<quint32>(MAGIC, bytes.data());
+  qToLittleEndian<quint16>(VERSION, bytes.data() + 4);
+  appendBytes(&bytes, maze->toBinary());
+  appendBytes(&bytes, saveSnapshot(snapshot));
+  appendBytes(&bytes, snapshot.visits.toBytes());
+  appendBytes(&bytes, snapshot.walls.toBytes());
+  appendBytes(&bytes,
+              view == nullptr ? QByteArray() : saveView(maze, view));
+  return bytes;
+}
+
+bool SimulationCheckpoint::restore(const QByteArray &bytes, const Maze *maze,
+                                   Simulation *simulation, MazeGraphic *view,
+                                   QString *error) {
+  if (bytes.size() < HEADER_SIZE ||
+      qFromLittleEndian<quint32>(bytes.constData()) != MAGIC) {
+    *error = "Not a checkpoint.";
+    return false;
+  }
+  if (qFromLittleEndian<quint16>(bytes.constData() + 4) != VERSION) {
+    *error = "The checkpoint is of an unsupported version.";
+    return false;
+  }
+  int position = HEADER_SIZE;
+  QByteArray mazeBytes;
+  QByteArray snapshotBytes;
+  QByteArray visitBytes;
+  QByteArray wallBytes;
+  QByteArray viewBytes;
+  bool ok = readBytes(bytes, &position, &mazeBytes) &&
+            readBytes(bytes, &position, &snapshotBytes) &&
+            readBytes(bytes, &position, &visitBytes) &&
+            readBytes(bytes, &position, &wallBytes) &&
+            readBytes(bytes, &position, &viewBytes) &&
+            position == bytes.size();
+  if (!ok) {
+    *error = "The checkpoint is truncated.";
+    return false;
+  }
+  if (mazeBytes != maze->toBinary()) {
+    *error = "The checkpoint is of a different maze.";
+    return false;
+  }
+
+  // Everything is read before anything is changed, so that a corrupt
+  // checkpoint leaves the run as it was
+  Simulation::Snapshot snapshot = simulation->getSnapshot();
+  if (!readSnapshot(snapshotBytes, maze, &snapshot) ||
+      !snapshot.visits.fromBytes(visitBytes) ||
+      !snapshot.walls.fromBytes(wallBytes)) {
+    *error = "The checkpoint is corrupt.";
+    return false;
+  }
+  int numTiles = maze->getWidth() * maze->getHeight();
+  QVector<TileState> tiles;
+  QVector<SemiPosition> path;
+  unsigned char pathColor = NO_COLOR;
+  if (!viewBytes.isEmpty()) {
+    position = 0;
+    tiles.reserve(numTiles);
+    for (int i = 0; ok && i < numTiles; i += 1) {
+      unsigned char walls = 0;
+      unsigned char color = 0;
+      QByteArray text;
+      ok = readUInt8(viewBytes, &position, &walls) && walls <= 0x0f &&
+           readUInt8(viewBytes, &position, &color) &&
+           (color == NO_COLOR ||
+            color <= static_cast<int>(Color::DARK_YELLOW)) &&
+           readBytes(viewBytes, &position, &text);
+      bool hasColor = color != NO_COLOR;
+      tiles.append({walls, hasColor,
+                    hasColor ? static_cast<Color>(color) : Color::BLACK,
+                    QString::fromUtf8(text)});
+    }
+    quint32 count = 0;
+    ok = ok && readUInt8(viewBytes, &position, &pathColor) &&
+         pathColor <= static_cast<int>(Color::DARK_YELLOW) &&
+         readUInt32(viewBytes, &position, &count) &&
+         8 * static_cast<qint64>(count) == viewBytes.size() - position;
+    for (quint32 i = 0; ok && i < count; i += 1) {
+      quint32 x = 0;
+      quint32 y = 0;
+      ok = readUInt32(viewBytes, &position, &x) &&
+           readUInt32(viewBytes, &position, &y) &&
+           x <= 2 * static_cast<quint32>(maze->getWidth()) &&
+           y <= 2 * static_cast<quint32>(maze->getHeight());
+      path.append({static_cast<int>(x), static_cast<int>(y)});
+    }
+    if (!ok) {
+      *error = "The checkpoint's view is corrupt.";
+      return false;
+    }
+  }
+
+  // The view must be restored first, see Simulation::restoreSnapshot
+  if (view != nullptr && !tiles.isEmpty()) {
+    int height = maze->getHeight();
+    for (int i = 0; i < numTiles; i += 1) {
+      view->setTileState(i / height, i % height, tiles.at(i));
+    }
+    if (path.isEmpty()) {
+      view->clearPath();
+    } else {
+      view->setPath(path, static_cast<Color>(pathColor));
+    }
+  }
+  simulation->restoreSnapshot(snapshot);
+  simulation->setResumed();
+  return true;
+}
+
+bool SimulationCheckpoint::toFile(const QString &path, const Maze *maze,
+                                  const Simulation *simulation,
+                                  const MazeGraphic *view) {
+  QByteArray bytes = save(maze, simulation, view);
+  QSaveFile file(path);
+  return file.open(QFile::WriteOnly) && file.write(bytes) == bytes.size() &&
+         file.commit();
+}
+
+bool SimulationCheckpoint::fromFile(const QString &path, const Maze *maze,
+                                    Simulation *simulation, MazeGraphic *view,
+                                    QString *error) {
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly)) {
+    *error = QString("Could not open \"%1\".").arg(path);
+    return false;
+  }
+  return restore(file.readAll(), maze, simulation, view, error);
+}
+
+QByteArray SimulationCheckpoint::saveSnapshot(
+    const Simulation::Snapshot &snapshot) {
+  QByteArray bytes;
+  appendUInt32(&bytes, snapshot.position.x);
+  appendUInt32(&bytes, snapshot.position.y);
+  bytes.append(static_cast<char>(snapshot.direction));
+  bytes.append(snapshot.wasReset ? 1 : 0);
+  quint64 steps = snapshot.elapsedClockSteps;
+  appendUInt32(&bytes, steps & 0xffffffff);
+  appendUInt32(&bytes, steps >> 32);
+  const Stats::State &stats = snapshot.stats;
+  appendUInt32(&bytes, NUM_STATS);
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    appendFloat(&bytes, stats.values[i]);
+  }
+  bytes.append(stats.startedRun ? 1 : 0);
+  bytes.append(stats.solved ? 1 : 0);
+  bytes.append(stats.bestRunRecorded ? 1 : 0);
+  appendFloat(&bytes, stats.penalty);
+  appendFloat(&bytes, stats.straightMeters);
+  appendFloat(&bytes, stats.straightEntrySpeed);
+  appendFloat(&bytes, stats.straightSeconds);
+  return bytes;
+}
+
+bool SimulationCheckpoint::readSnapshot(const QByteArray &bytes,
+                                        const Maze *maze,
+                                        Simulation::Snapshot *snapshot) {
+  int position = 0;
+  quint32 x = 0;
+  quint32 y = 0;
+  unsigned char direction = 0;
+  unsigned char wasReset = 0;
+  quint32 lowSteps = 0;
+  quint32 highSteps = 0;
+  quint32 numStats = 0;
+  bool ok = readUInt32(bytes, &position, &x) &&
+            readUInt32(bytes, &position, &y) &&
+            readUInt8(bytes, &position, &direction) &&
+            readUInt8(bytes, &position, &wasReset) &&
+            readUInt32(bytes, &position, &lowSteps) &&
+            readUInt32(bytes, &position, &highSteps) &&
+            readUInt32(bytes, &position, &numStats);
+
+  // The mouse is never at a corner, see Simulation::isWallInMaze
+  ok = ok && x <= 2 * static_cast<quint32>(maze->getWidth()) &&
+       y <= 2 * static_cast<quint32>(maze->getHeight()) &&
+       (x % 2 == 1 || y % 2 == 1) &&
+       direction <= static_cast<int>(SemiDirection::SOUTHWEST) &&
+       numStats <= static_cast<quint32>(NUM_STATS);
+  if (!ok) {
+    return false;
+  }
+  Stats::State stats = snapshot->stats;
+  for (quint32 i = 0; ok && i < numStats; i += 1) {
+    ok = readFloat(bytes, &position, &stats.values[i]);
+  }
+  unsigned char startedRun = 0;
+  unsigned char solved = 0;
+  unsigned char bestRunRecorded = 0;
+  ok = ok && readUInt8(bytes, &position, &startedRun) &&
+       readUInt8(bytes, &position, &solved) &&
+       readUInt8(bytes, &position, &bestRunRecorded) &&
+       readFloat(bytes, &position, &stats.penalty) &&
+       readFloat(bytes, &position, &stats.straightMeters) &&
+       readFloat(bytes, &position, &stats.straightEntrySpeed) &&
+       readFloat(bytes, &position, &stats.straightSeconds) &&
+       position == bytes.size();
+  if (!ok) {
+    return false;
+  }
+  stats.startedRun = startedRun != 0;
+  stats.solved = solved != 0;
+  stats.bestRunRecorded = bestRunRecorded != 0;
+  snapshot->position = {static_cast<int>(x), static_cast<int>(y)};
+  snapshot->direction = static_cast<SemiDirection>(direction);
+  snapshot->wasReset = wasReset != 0;
+  snapshot->elapsedClockSteps =
+      static_cast<qint64>((static_cast<quint64>(highSteps) << 32) | lowSteps);
+  snapshot->stats = stats;
+  return true;
+}
+
+QByteArray SimulationCheckpoint::saveView(const Maze *maze,
+                                          const MazeGraphic *view) {
+  QByteArray bytes;
+  for (int x = 0; x < maze->getWidth(); x += 1) {
+    for (int y = 0; y < maze->getHeight(); y += 1) {
+      TileState state = view->getTileState(x, y);
+      bytes.append(static_cast<char>(state.walls));
+      bytes.append(state.hasColor ? static_cast<char>(state.color)
+                                  : static_cast<char>(NO_COLOR));
+      appendBytes(&bytes, state.text.toUtf8());
+    }
+  }
+  QVector<SemiPosition> path = view->getPath();
+  bytes.append(static_cast<char>(view->getPathColor()));
+  appendUInt32(&bytes, path.size());
+  for (const SemiPosition &position : path) {
+    appendUInt32(&bytes, position.x);
+    appendUInt32(&bytes, position.y);
+  }
+  return bytes;
+}
+
+void SimulationCheckpoint::appendUInt32(QByteArray *bytes, quint32 value) {
+  int start = bytes->size();
+  bytes->resize(start + 4);
+  qToLittleEndian<quint32>(value, bytes->data() + start);
+}
+
+void SimulationCheckpoint::appendFloat(QByteArray *bytes, float value) {
+  int start = bytes->size();
+  bytes->resize(start + 4);
+  qToLittleEndian<float>(value, bytes->data() + start);
+}
+
+void SimulationCheckpoint::appendBytes(QByteArray *bytes,
+                                       const QByteArray &value) {
+  appendUInt32(bytes, value.size());
+  bytes->append(value);
+}
+
+bool SimulationCheckpoint::readUInt8(const QByteArray &bytes, int *position,
+                                     unsigned char *value) {
+  if (bytes.size() < *position + 1) {
+    return false;
+  }
+  *value = static_cast<unsigned char>(bytes.at(*position));
+  *position += 1;
+  return true;
+}
+
+bool SimulationCheckpoint::readUInt32(const QByteArray &bytes, int *position,
+                                      quint32 *value) {
+  if (bytes.size() < *position + 4) {
+    return false;
+  }
+  *value = qFromLittleEndian<quint32>(bytes.constData() + *position);
+  *position += 4;
+  return true;
+}
+
+bool SimulationCheckpoint::readFloat(const QByteArray &bytes, int *position,
+                                     float *value) {
+  if (bytes.size() < *position + 4) {
+    return false;
+  }
+  *value = qFromLittleEndian<float>(bytes.constData() + *position);
+  *position += 4;
+  return true;
+}
+
+bool SimulationCheckpoint::readBytes(const QByteArray &bytes, int *position,
+                                     QByteArray *value) {
+  int start = *position;
+  quint32 size = 0;
+  if (!readUInt32(bytes, &start, &size) ||
+      static_cast<quint32>(bytes.size() - start) < size) {
+    return false;
+  }
+  *value = bytes.mid(start, size);
+  *position = start + size;
+  return true;
+}
+
+}  // namespace mms
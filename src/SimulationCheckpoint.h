@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "Maze.h"
+#include "MazeGraphic.h"
+#include "Simulation.h"
+
+namespace mms {
+
+// A checkpoint of a run in progress: its maze, the simulation's snapshot (the
+// mouse, the stats, the visit counts, and the walls that the algo declared),
+// and, if there is one, the algo's view (every tile's walls, color, and text,
+// and the path). It's a compact binary record of the state itself, rather
+// than of the commands that led to it, so it's cheap to write during a long
+// run and can be restored by a later version of the simulator, or on another
+// machine, e.g., to resume a run after a crash.
+//
+// Checkpoints are only taken between commands (see Simulation::isIdle), with
+// nothing queued or in motion, since the algo process that sent any pending
+// commands wouldn't be around to read their responses. A resumed run starts a
+// new algo process, which can tell that it was resumed via wasResumed.
+class SimulationCheckpoint {
+ public:
+  // The SimulationCheckpoint class is not constructible
+  SimulationCheckpoint() = delete;
+
+  // The simulation must be idle, and the view, which may be null, must be of
+  // the same maze
+  static QByteArray save(const Maze *maze, const Simulation *simulation,
+                         const MazeGraphic *view);
+
+  // Restores the view (if both it and the checkpoint have one) and then the
+  // simulation, which must be idle, and marks the simulation as resumed.
+  // Returns false, changing nothing, if the bytes aren't a checkpoint of a
+  // run of the same maze.
+  static bool restore(const QByteArray &bytes, const Maze *maze,
+                      Simulation *simulation, MazeGraphic *view,
+                      QString *error);
+
+  // The same as above, to and from files; the file is replaced atomically,
+  // so that a crash while saving leaves the previous checkpoint intact
+  static bool toFile(const QString &path, const Maze *maze,
+                     const Simulation *simulation, const MazeGraphic *view);
+  static bool fromFile(const QString &path, const Maze *maze,
+                       Simulation *simulation, MazeGraphic *view,
+                       QString *error);
+
+ private:
+  static const quint32 MAGIC;
+  static const quint16 VERSION;
+  static const int HEADER_SIZE;
+  static const unsigned char NO_COLOR;
+
+  static QByteArray saveSnapshot(const Simulation::Snapshot &snapshot);
+  static bool readSnapshot(const QByteArray &bytes, const Maze *maze,
+                           Simulation::Snapshot *snapshot);
+  static QByteArray saveView(const Maze *maze, const MazeGraphic *view);
+
+  static void appendUInt32(QByteArray *bytes, quint32 value);
+  static void appendFloat(QByteArray *bytes, float value);
+  static void appendBytes(QByteArray *bytes, const QByteArray &value);
+  static bool readUInt8(const QByteArray &bytes, int *position,
+                        unsigned char *value);
+  static bool readUInt32(const QByteArray &bytes, int *position,
+                         quint32 *value);
+  static bool readFloat(const QByteArray &bytes, int *position,
+                        float *value);
+  static bool readBytes(const QByteArray &bytes, int *position,
+                        QByteArray *value);
+};
+
+}  // namespace mms
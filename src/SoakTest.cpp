@@ -0,0 +1,209 @@
+#include "SoakTest.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+
+#include "AssertMacros.h"
+#include "ProcessUtilities.h"
+
+namespace mms {
+
+const int SoakTest::SAMPLE_INTERVAL_MILLISECONDS = 5000;
+const double SoakTest::MAX_DRIFT_FRACTION = 0.25;
+const qint64 SoakTest::RESIDENT_DRIFT_FLOOR_BYTES = 16 * 1024 * 1024;
+const qint64 SoakTest::LATENCY_DRIFT_FLOOR_NANOSECONDS = 5000;
+const qint64 SoakTest::QUEUE_DRIFT_FLOOR_COMMANDS = 16;
+const qint64 SoakTest::LAG_DRIFT_FLOOR_MILLISECONDS = 50;
+
+SoakTest::SoakTest(const QStringList &mazeFiles, const QString &directory,
+                   const QString &runCommand, double timeoutSeconds,
+                   int maxJobs, bool useSharedMemory, double soakSeconds,
+                   QTextStream *series, QObject *parent)
+    : QObject(parent),
+      m_mazeFiles(mazeFiles),
+      m_directory(directory),
+      m_runCommand(runCommand),
+      m_timeoutSeconds(timeoutSeconds),
+      m_maxJobs(maxJobs),
+      m_useSharedMemory(useSharedMemory),
+      m_soakSeconds(soakSeconds),
+      m_series(series),
+      m_clock(QElapsedTimer()),
+      m_sampleTimer(new QTimer(this)),
+      m_nextSampleMilliseconds(0),
+      m_runner(nullptr),
+      m_rows(nullptr),
+      m_rowText(QString()),
+      m_numCycles(0),
+      m_numRuns(0),
+      m_cycleStartRuns(0),
+      m_serviceTimes(LatencyHistogram()),
+      m_maxQueued(-1),
+      m_samples(QVector<Sample>()) {
+  ASSERT_LT(0.0, soakSeconds);
+  m_sampleTimer->setInterval(SAMPLE_INTERVAL_MILLISECONDS);
+  connect(m_sampleTimer, &QTimer::timeout, this, &SoakTest::sample);
+}
+
+void SoakTest::start() {
+  *m_series << "seconds,cycles,runs,resident-kib,service-p50-us,"
+               "service-p99-us,max-queued,lag-ms"
+            << Qt::endl;
+  m_clock.start();
+  m_nextSampleMilliseconds = SAMPLE_INTERVAL_MILLISECONDS;
+  m_sampleTimer->start();
+  startCycle();
+}
+
+void SoakTest::startCycle() {
+  // Each cycle runs the mazes in a different, but repeatable, order, with a
+  // different seed, so that nothing stays warm by accident
+  m_cycleStartRuns = m_numRuns;
+  QStringList mazeFiles = m_mazeFiles;
+  QRandomGenerator generator(m_numCycles);
+  std::shuffle(mazeFiles.begin(), mazeFiles.end(), generator);
+  m_rows = new QTextStream(&m_rowText);
+  m_runner = new BatchRunner(mazeFiles, m_directory, m_runCommand,
+                             m_timeoutSeconds, m_maxJobs, m_useSharedMemory,
+                             nullptr, QString(), m_rows, this);
+  m_runner->setLatencyColumns(true);
+  m_runner->setSeed(m_numCycles);
+  connect(m_runner, &BatchRunner::simulationFinished, this,
+          &SoakTest::addSimulation);
+  connect(m_runner, &BatchRunner::finished, this,
+          &SoakTest::onCycleFinished);
+  m_runner->start();
+}
+
+void SoakTest::onCycleFinished() {
+  // The runner is still on the stack of its own signal
+  m_runner->deleteLater();
+  m_runner = nullptr;
+  delete m_rows;
+  m_rows = nullptr;
+  m_rowText.clear();
+  m_numCycles += 1;
+  if (m_numRuns == m_cycleStartRuns) {
+    // Nothing would ever be sampled
+    m_sampleTimer->stop();
+    QTextStream(stderr) << "No run of the soak could be started."
+                        << Qt::endl;
+    emit finished(1);
+  } else if (m_clock.elapsed() < 1000 * m_soakSeconds) {
+    startCycle();
+  } else {
+    finish();
+  }
+}
+
+void SoakTest::addSimulation(const Simulation *simulation) {
+  m_serviceTimes.add(simulation->getServiceTimes());
+  m_maxQueued = qMax(m_maxQueued, simulation->getMaxQueuedCommands());
+  m_numRuns += 1;
+}
+
+void SoakTest::sample() {
+  // The timer is late by however long the event loop was busy
+  qint64 now = m_clock.elapsed();
+  qint64 lag = qMax<qint64>(0, now - m_nextSampleMilliseconds);
+  m_nextSampleMilliseconds = now + SAMPLE_INTERVAL_MILLISECONDS;
+
+  ProcessUtilities::Usage usage = {0.0, 0.0, 0, 0};
+  ProcessUtilities::getUsage(QCoreApplication::applicationPid(), &usage);
+  bool hasRuns = 0 < m_serviceTimes.getCount();
+  Sample sample = {
+      usage.residentBytes,
+      hasRuns ? m_serviceTimes.getPercentile(0.50) : -1,
+      hasRuns ? m_serviceTimes.getPercentile(0.99) : -1,
+      hasRuns ? m_maxQueued : -1,
+      lag,
+  };
+  m_samples.append(sample);
+  m_serviceTimes = LatencyHistogram();
+  m_maxQueued = -1;
+
+  auto toField = [](qint64 value, qint64 divisor) {
+    return value < 0 ? QString() : QString::number(value / divisor);
+  };
+  *m_series << QString::number(now / 1000.0, 'f', 1) << "," << m_numCycles
+            << "," << m_numRuns << "," << sample.residentBytes / 1024 << ","
+            << toField(sample.serviceP50, 1000) << ","
+            << toField(sample.serviceP99, 1000) << ","
+            << toField(sample.maxQueued, 1) << "," << sample.lagMilliseconds
+            << Qt::endl;
+}
+
+void SoakTest::finish() {
+  sample();
+  m_sampleTimer->stop();
+  QVector<qint64> resident;
+  QVector<qint64> p50;
+  QVector<qint64> p99;
+  QVector<qint64> queued;
+  QVector<qint64> lag;
+  for (const Sample &sample : m_samples) {
+    resident.append(sample.residentBytes);
+    p50.append(sample.serviceP50);
+    p99.append(sample.serviceP99);
+    queued.append(sample.maxQueued);
+    lag.append(sample.lagMilliseconds);
+  }
+
+  // Every column is checked, so that every drift is reported
+  bool drifted = false;
+  drifted |= hasDrifted("resident memory (bytes)", resident,
+                        RESIDENT_DRIFT_FLOOR_BYTES);
+  drifted |= hasDrifted("service time p50 (ns)", p50,
+                        LATENCY_DRIFT_FLOOR_NANOSECONDS);
+  drifted |= hasDrifted("service time p99 (ns)", p99,
+                        LATENCY_DRIFT_FLOOR_NANOSECONDS);
+  drifted |= hasDrifted("command queue depth", queued,
+                        QUEUE_DRIFT_FLOOR_COMMANDS);
+  drifted |= hasDrifted("event loop lag (ms)", lag,
+                        LAG_DRIFT_FLOOR_MILLISECONDS);
+  QTextStream err(stderr);
+  err << QString("Soaked for %1 cycles, %2 runs, %3 samples: %4.")
+             .arg(m_numCycles)
+             .arg(m_numRuns)
+             .arg(m_samples.size())
+             .arg(drifted ? "drifted" : "no drift")
+      << Qt::endl;
+  emit finished(drifted ? 1 : 0);
+}
+
+bool SoakTest::hasDrifted(const QString &name, const QVector<qint64> &values,
+                          qint64 floor) const {
+  QVector<qint64> present;
+  for (qint64 value : values) {
+    if (0 <= value) {
+      present.append(value);
+    }
+  }
+  int quarter = present.size() / 4;
+  if (quarter == 0) {
+    return false;
+  }
+  qint64 before = getMedian(present.mid(quarter, quarter));
+  qint64 after = getMedian(present.mid(present.size() - quarter));
+  qint64 tolerance =
+      qMax(floor, static_cast<qint64>(MAX_DRIFT_FRACTION * before));
+  if (after - before <= tolerance) {
+    return false;
+  }
+  QTextStream(stderr) << QString("%1 drifted from %2 to %3.")
+                             .arg(name)
+                             .arg(before)
+                             .arg(after)
+                      << Qt::endl;
+  return true;
+}
+
+qint64 SoakTest::getMedian(QVector<qint64> values) {
+  ASSERT_FA(values.isEmpty());
+  std::sort(values.begin(), values.end());
+  return values.at(values.size() / 2);
+}
+
+}  // namespace mms
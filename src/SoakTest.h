@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include "BatchRunner.h"
+#include "LatencyHistogram.h"
+#include "Simulation.h"
+
+namespace mms {
+
+// Runs a batch over and over for a long time, e.g., hours of the synthetic
+// flood algo (see util/mms-flood.c), to catch the leaks and slowdowns that
+// only show up in a simulator that has been running for a while. Each cycle
+// is a BatchRunner over the mazes in a new order, whose rows are dropped;
+// instead, every SAMPLE_INTERVAL_MILLISECONDS, the simulator's resident
+// memory, the percentiles of the service times of the commands of the runs
+// that finished since the last sample, the deepest command queue among them,
+// and how late the sample itself was, i.e., how long the event loop was
+// stalled, are written as a CSV row of a time series. Once the time is up,
+// the last quarter of the series is compared to the second (the first being
+// the warm-up), and the test fails if any of them drifted upwards.
+class SoakTest : public QObject {
+  Q_OBJECT
+
+ public:
+  // The runs are as in BatchRunner; the series isn't owned by the test
+  SoakTest(const QStringList &mazeFiles, const QString &directory,
+           const QString &runCommand, double timeoutSeconds, int maxJobs,
+           bool useSharedMemory, double soakSeconds, QTextStream *series,
+           QObject *parent = nullptr);
+
+  void start();
+
+ signals:
+  // The exit code is nonzero if anything drifted, or if the runs couldn't
+  // be started at all; runs that merely fail, e.g., because the flood algo
+  // never solves its maze, don't count
+  void finished(int exitCode);
+
+ private:
+  static const int SAMPLE_INTERVAL_MILLISECONDS;
+
+  // Something has drifted if the median of the last quarter of the series
+  // exceeds that of the second quarter by this fraction and by at least the
+  // floor of its kind, so that noise in small values doesn't count
+  static const double MAX_DRIFT_FRACTION;
+  static const qint64 RESIDENT_DRIFT_FLOOR_BYTES;
+  static const qint64 LATENCY_DRIFT_FLOOR_NANOSECONDS;
+  static const qint64 QUEUE_DRIFT_FLOOR_COMMANDS;
+  static const qint64 LAG_DRIFT_FLOOR_MILLISECONDS;
+
+  struct Sample {
+    qint64 residentBytes;
+    qint64 serviceP50;  // nanoseconds, or -1 if no runs finished
+    qint64 serviceP99;
+    qint64 maxQueued;   // or -1 if no runs finished
+    qint64 lagMilliseconds;
+  };
+
+  QStringList m_mazeFiles;
+  QString m_directory;
+  QString m_runCommand;
+  double m_timeoutSeconds;
+  int m_maxJobs;
+  bool m_useSharedMemory;
+  double m_soakSeconds;
+  QTextStream *m_series;
+
+  QElapsedTimer m_clock;
+  QTimer *m_sampleTimer;
+  qint64 m_nextSampleMilliseconds;
+  BatchRunner *m_runner;  // of the current cycle
+  QTextStream *m_rows;    // of the current cycle, dropped
+  QString m_rowText;
+  int m_numCycles;
+  int m_numRuns;
+  int m_cycleStartRuns;  // the runs before the current cycle
+
+  // Of the runs that finished since the last sample
+  LatencyHistogram m_serviceTimes;
+  int m_maxQueued;
+
+  QVector<Sample> m_samples;
+
+  void startCycle();
+  void onCycleFinished();
+  void addSimulation(const Simulation *simulation);
+  void sample();
+  void finish();
+
+  // Writes the drift of one column of the series to stderr, if it drifted,
+  // and returns whether it did; samples without a value are skipped
+  bool hasDrifted(const QString &name, const QVector<qint64> &values,
+                  qint64 floor) const;
+  static qint64 getMedian(QVector<qint64> values);
+};
+
+}  // namespace mms
@@ -2,45 +2,84 @@
 
 #include <limits>
 
+#include "MotionProfile.h"
+#include "ScoringPolicy.h"
+
 namespace mms {
 
-Stats::Stats() : startedRun(false), solved(false), penalty(0.0) {}
+const QMap<QString, StatsEnum> &STRING_TO_STAT() {
+#define MMS_STAT_NAME(name, text) {text, StatsEnum::name},
+  static const QMap<QString, StatsEnum> map = {
+      MMS_PROTOCOL_STATS(MMS_STAT_NAME)};
+#undef MMS_STAT_NAME
+  return map;
+}
+
+const int Stats::REFRESH_INTERVAL_MILLISECONDS = 16;
+
+Stats::Stats()
+    : startedRun(false),
+      solved(false),
+      bestRunRecorded(false),
+      penalty(0.0),
+      straightMeters(0.0),
+      straightEntrySpeed(0.0),
+      straightSeconds(0.0),
+      scoring(&ClassicScoring::score),
+      staleTexts(0) {
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    statValues[i] = 0;
+    textFields[i] = nullptr;
+  }
+  refreshTimer.setSingleShot(true);
+  refreshTimer.setInterval(REFRESH_INTERVAL_MILLISECONDS);
+  QObject::connect(&refreshTimer, &QTimer::timeout, [=]() { refreshTexts(); });
+}
+
+float &Stats::statValue(StatsEnum stat) {
+  return statValues[static_cast<int>(stat)];
+}
+
+float Stats::statValue(StatsEnum stat) const {
+  return statValues[static_cast<int>(stat)];
+}
 
-void Stats::reset(StatsEnum stat) {
-  setStat(stat, 0);
-  updateScore();
+float Stats::getValue(StatsEnum stat) const {
+  if (stat == StatsEnum::SCORE) {
+    return scoring(getState());
+  }
+  return statValue(stat);
 }
 
+void Stats::setScoring(Scoring scoring) {
+  this->scoring = scoring;
+  markTextStale(StatsEnum::SCORE);
+}
+
+void Stats::reset(StatsEnum stat) { setStat(stat, 0); }
+
 void Stats::resetAll() {
   startedRun = false;
   solved = false;
-  QMapIterator<StatsEnum, QLineEdit *> i(textField);
-  while (i.hasNext()) {
-    i.next();
-    StatsEnum key = i.key();
+  bestRunRecorded = false;
+  stopStraight();
+  // Reset every stat, regardless of whether or not it's bound to a text box
+  for (StatsEnum key : STRING_TO_STAT().values()) {
     // Set best run equal to max value as a placeholder
     // Display no value until a start-to-finish run is recorded
     if (key == StatsEnum::BEST_RUN_TURNS) {
-      statValues[key] = std::numeric_limits<float>::max();
-      textField[key]->setText("");
-    } else if (key == StatsEnum::BEST_RUN_DISTANCE) {
-      statValues[key] = 0;
-      textField[key]->setText("");
-    } else if (key == StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE) {
-      statValues[key] = 0;
-      textField[key]->setText("");
+      setStat(key, std::numeric_limits<float>::max());
     } else if (key == StatsEnum::SCORE) {
-      // Score is set in updateScore()
+      // The score is derived from the rest, see getValue
       continue;
     } else {
       // Display zero for all other values
       setStat(key, 0);
     }
   }
-  updateScore();
 }
 
-void Stats::addDistance(int distance) {
+void Stats::addDistance(int distance, Distance length) {
   float effectiveDistance = getEffectiveDistance(distance);
   increment(StatsEnum::TOTAL_DISTANCE, distance);
   increment(StatsEnum::TOTAL_EFFECTIVE_DISTANCE, effectiveDistance);
@@ -48,43 +87,90 @@ void Stats::addDistance(int distance) {
     increment(StatsEnum::CURRENT_RUN_DISTANCE, distance);
     increment(StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE, effectiveDistance);
   }
-  updateScore();
+  straightMeters += length.getMeters();
+  updateStraight(0.0);
 }
 
-void Stats::addTurn() {
+void Stats::addTurn(Angle angle) {
   increment(StatsEnum::TOTAL_TURNS, 1);
   if (startedRun) {
     increment(StatsEnum::CURRENT_RUN_TURNS, 1);
   }
-  updateScore();
+  // The straightaway before the turn brakes to the turn's speed rather than
+  // to a stop, and the one after it starts from that speed
+  updateStraight(MotionProfile::TURN_SPEED);
+  addSeconds(MotionProfile::getTurnSeconds(angle));
+  straightMeters = 0.0;
+  straightEntrySpeed = MotionProfile::TURN_SPEED;
+  straightSeconds = 0.0;
+}
+
+void Stats::addSeconds(float seconds) {
+  increment(StatsEnum::TOTAL_TIME, seconds);
+  if (startedRun) {
+    increment(StatsEnum::CURRENT_RUN_TIME, seconds);
+  }
+}
+
+void Stats::updateStraight(double exitSpeed) {
+  float seconds = MotionProfile::getStraightSeconds(
+      Distance::Meters(straightMeters), straightEntrySpeed, exitSpeed);
+  addSeconds(seconds - straightSeconds);
+  straightSeconds = seconds;
+}
+
+void Stats::stopStraight() {
+  // The straightaway was already timed as if it ended at rest
+  straightMeters = 0.0;
+  straightEntrySpeed = 0.0;
+  straightSeconds = 0.0;
 }
 
 void Stats::increment(StatsEnum stat, float increase) {
-  setStat(stat, statValues[stat] + increase);
+  setStat(stat, statValue(stat) + increase);
 }
 
 void Stats::setStat(StatsEnum stat, float value) {
-  statValues[stat] = value;
-  textField[stat]->setText(QString::number(statValues[stat]));
+  statValue(stat) = value;
+  markTextStale(stat);
+
+  // Nearly every stat affects the score, which is cheaper to refresh than to
+  // work out whether it changed
+  markTextStale(StatsEnum::SCORE);
 }
 
-void Stats::bindText(StatsEnum stat, QLineEdit *uiText) {
-  textField[stat] = uiText;
-}
-
-void Stats::updateScore() {
-  // if solved, score = best_run_turns + best_run_effective_distance +
-  // 0.1*(total_turns + total_effective_distance)
-  float score;
-  if (solved) {
-    score = statValues[StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE] +
-            statValues[StatsEnum::BEST_RUN_TURNS] +
-            0.1 * (statValues[StatsEnum::TOTAL_EFFECTIVE_DISTANCE] +
-                   statValues[StatsEnum::TOTAL_TURNS]);
-  } else {
-    score = 2000;  // default score
+void Stats::markTextStale(StatsEnum stat) {
+  // Stats aren't necessarily bound to a text box, e.g., in headless mode
+  int index = static_cast<int>(stat);
+  if (textFields[index] == nullptr) {
+    return;
+  }
+  staleTexts |= 1u << index;
+  if (!refreshTimer.isActive()) {
+    refreshTimer.start();
+  }
+}
+
+void Stats::refreshTexts() {
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    if (staleTexts & (1u << i)) {
+      textFields[i]->setText(getText(static_cast<StatsEnum>(i)));
+    }
   }
-  textField[StatsEnum::SCORE]->setText(QString::number(score));
+  staleTexts = 0;
+}
+
+QString Stats::getText(StatsEnum stat) const {
+  // Best run stats are displayed once a run is recorded, like getStat
+  if (!bestRunRecorded && isBestRunStat(stat)) {
+    return "";
+  }
+  return QString::number(getValue(stat));
+}
+
+void Stats::bindText(StatsEnum stat, QLineEdit *uiText) {
+  textFields[static_cast<int>(stat)] = uiText;
+  markTextStale(stat);
 }
 
 float Stats::getEffectiveDistance(int distance) {
@@ -95,6 +181,7 @@ void Stats::startRun() {
   reset(StatsEnum::CURRENT_RUN_TURNS);
   reset(StatsEnum::CURRENT_RUN_DISTANCE);
   reset(StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE);
+  reset(StatsEnum::CURRENT_RUN_TIME);
   // add penalty to next run if necessary
   increment(StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE, penalty);
   increment(StatsEnum::TOTAL_EFFECTIVE_DISTANCE, penalty);
@@ -103,42 +190,95 @@ void Stats::startRun() {
 }
 
 void Stats::finishRun() {
+  stopStraight();
   startedRun = false;
   solved = true;
-  float currentScore = statValues[StatsEnum::CURRENT_RUN_TURNS] +
-                       statValues[StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE];
-  float bestScore = statValues[StatsEnum::BEST_RUN_TURNS] +
-                    statValues[StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE];
+  float currentScore = statValue(StatsEnum::CURRENT_RUN_TURNS) +
+                       statValue(StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE);
+  float bestScore = statValue(StatsEnum::BEST_RUN_TURNS) +
+                    statValue(StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE);
   if (currentScore < bestScore) {
     // new best run
+    bestRunRecorded = true;
     setStat(StatsEnum::BEST_RUN_TURNS,
-            statValues[StatsEnum::CURRENT_RUN_TURNS]);
+            statValue(StatsEnum::CURRENT_RUN_TURNS));
     setStat(StatsEnum::BEST_RUN_DISTANCE,
-            statValues[StatsEnum::CURRENT_RUN_DISTANCE]);
+            statValue(StatsEnum::CURRENT_RUN_DISTANCE));
     setStat(StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE,
-            statValues[StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE]);
+            statValue(StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE));
+    setStat(StatsEnum::BEST_RUN_TIME,
+            statValue(StatsEnum::CURRENT_RUN_TIME));
   }
-  updateScore();
+  markTextStale(StatsEnum::SCORE);
 }
 
 void Stats::endUnfinishedRun() {
+  stopStraight();
   startedRun = false;
-  updateScore();
 }
 
 void Stats::penalizeForReset() { penalty = 15; }
 
+void Stats::setWallCounts(int correct, int wrong, int undiscovered) {
+  setStat(StatsEnum::CORRECT_WALLS, correct);
+  setStat(StatsEnum::WRONG_WALLS, wrong);
+  setStat(StatsEnum::UNDISCOVERED_WALLS, undiscovered);
+}
+
 bool Stats::isInteger(StatsEnum stat) {
   // Returns true if the stat represents an integer value
   return (stat == StatsEnum::TOTAL_DISTANCE || stat == StatsEnum::TOTAL_TURNS ||
           stat == StatsEnum::BEST_RUN_DISTANCE ||
           stat == StatsEnum::BEST_RUN_TURNS ||
           stat == StatsEnum::CURRENT_RUN_DISTANCE ||
-          stat == StatsEnum::CURRENT_RUN_TURNS);
+          stat == StatsEnum::CURRENT_RUN_TURNS ||
+          stat == StatsEnum::CORRECT_WALLS || stat == StatsEnum::WRONG_WALLS ||
+          stat == StatsEnum::UNDISCOVERED_WALLS);
+}
+
+Stats::State Stats::getState() const {
+  State state;
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    state.values[i] = statValues[i];
+  }
+  state.startedRun = startedRun;
+  state.solved = solved;
+  state.bestRunRecorded = bestRunRecorded;
+  state.penalty = penalty;
+  state.straightMeters = straightMeters;
+  state.straightEntrySpeed = straightEntrySpeed;
+  state.straightSeconds = straightSeconds;
+  state.values[static_cast<int>(StatsEnum::SCORE)] = scoring(state);
+  return state;
+}
+
+void Stats::setState(const State &state) {
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    statValues[i] = state.values[i];
+    markTextStale(static_cast<StatsEnum>(i));
+  }
+  startedRun = state.startedRun;
+  solved = state.solved;
+  bestRunRecorded = state.bestRunRecorded;
+  penalty = state.penalty;
+  straightMeters = state.straightMeters;
+  straightEntrySpeed = state.straightEntrySpeed;
+  straightSeconds = state.straightSeconds;
+}
+
+bool Stats::isBestRunStat(StatsEnum stat) {
+  return stat == StatsEnum::BEST_RUN_DISTANCE ||
+         stat == StatsEnum::BEST_RUN_TURNS ||
+         stat == StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE ||
+         stat == StatsEnum::BEST_RUN_TIME;
 }
 
 QString Stats::getStat(StatsEnum stat) {
-  QString statText = textField[stat]->text();
+  // Best run stats have no value until a start-to-finish run is recorded
+  if (!bestRunRecorded && isBestRunStat(stat)) {
+    return "";
+  }
+  QString statText = QString::number(getValue(stat));
   // Cast the stat to an integer if it's supposed to be an integer
   if (isInteger(stat)) {
     bool converted;
@@ -2,50 +2,111 @@
 
 #include <QLineEdit>
 #include <QMap>
+#include <QString>
+#include <QTimer>
+
+#include "../util/mms-protocol.h"
+#include "units/Angle.h"
+#include "units/Distance.h"
 
 namespace mms {
 
-enum class StatsEnum {
-  TOTAL_DISTANCE,
-  TOTAL_TURNS,
-  BEST_RUN_DISTANCE,
-  BEST_RUN_TURNS,
-  CURRENT_RUN_DISTANCE,
-  CURRENT_RUN_TURNS,
-  TOTAL_EFFECTIVE_DISTANCE,
-  BEST_RUN_EFFECTIVE_DISTANCE,
-  CURRENT_RUN_EFFECTIVE_DISTANCE,
-  SCORE  // has a text box but is not saved in an array
-};
+// Generated from the schema, whose order is part of the binary protocol (see
+// util/mms-protocol.h), so that it matches the clients' mms_stat. The score
+// is derived from the others when needed (see ScoringPolicy.h), the times are
+// of MotionProfile, and the walls are counted by WallAccuracy.
+#define MMS_STATS_ENUM(name, text) name,
+enum class StatsEnum { MMS_PROTOCOL_STATS(MMS_STATS_ENUM) };
+#undef MMS_STATS_ENUM
+
+const int NUM_STATS = static_cast<int>(StatsEnum::UNDISCOVERED_WALLS) + 1;
+static_assert(NUM_STATS == MMS_NUM_STATS,
+              "the last stat must be the last of the schema's");
+
+// Maps the names accepted by the getStat command to stats
+const QMap<QString, StatsEnum> &STRING_TO_STAT();
 
 class Stats {
  public:
+  // Everything that determines the stats, e.g., to restore them later
+  struct State {
+    float values[NUM_STATS];  // indexed by stat
+    bool startedRun;
+    bool solved;
+    bool bestRunRecorded;
+    float penalty;
+
+    // The straightaway that the mouse is on, which is timed as if it ended
+    // at rest until whatever follows it is known
+    float straightMeters;
+    float straightEntrySpeed;
+    float straightSeconds;
+  };
+
+  // A scoring policy, which derives the score from the rest of the state
+  typedef float (*Scoring)(const State &state);
+
   Stats();
+
+  // The score is only computed when it's needed, by ClassicScoring unless
+  // another policy is set
+  void setScoring(Scoring scoring);
   void resetAll();  // Reset all score stats
-  void addDistance(
-      int distance);  // Increase the distance and effective distance
-  void addTurn();     // Increment the number of turns
+  void addDistance(int distance,
+                   Distance length);  // Increase the distance, effective
+                                      // distance, and time
+  void addTurn(Angle angle);  // Increment the number of turns, and add to
+                              // the time
   void bindText(
       StatsEnum stat,
-      QLineEdit *uiText);  // Indicate which QLineEdit to use for that stat
+      QLineEdit *uiText);  // Indicate which QLineEdit to use for that stat;
+                           // bound text boxes are refreshed at most once per
+                           // frame, and unbound stats cost nothing to display
   void startRun();   // A run starts when the mouse exits the starting tile.
   void finishRun();  // A run finishes when the mouse enters the goal.
   void endUnfinishedRun();  // A run ends unfinished when the mouse returns to
                             // the start tile
   void penalizeForReset();  // Applies a penalty when the mouse resets to the
                             // start tile
+  void setWallCounts(int correct, int wrong,
+                     int undiscovered);  // Set by the simulation whenever the
+                                         // declared walls change
   QString getStat(
       StatsEnum stat);  // Return the current value of the requested stat
+  State getState() const;  // includes the score
+  void setState(const State &state);  // Also refreshes the bound text boxes
+
+  // Whether the stat has no value until a start-to-finish run is recorded
+  static bool isBestRunStat(StatsEnum stat);
 
  private:
-  QMap<StatsEnum, float> statValues;
-  QMap<StatsEnum, QLineEdit *> textField;
+  static const int REFRESH_INTERVAL_MILLISECONDS;
+
+  float statValues[NUM_STATS];
+  QLineEdit *textFields[NUM_STATS];
   bool startedRun;
   bool solved;
+  bool bestRunRecorded;
   float penalty;
-  void updateScore();
+  float straightMeters;
+  float straightEntrySpeed;
+  float straightSeconds;
+  Scoring scoring;
+  float &statValue(StatsEnum stat);
+  float statValue(StatsEnum stat) const;
+  float getValue(StatsEnum stat) const;  // computes the score if need be
   void increment(StatsEnum stat, float increase);
   void setStat(StatsEnum stat, float value);
+  void addSeconds(float seconds);
+  void updateStraight(double exitSpeed);
+  void stopStraight();
+
+  // The text of each bound stat is only written when the refresh timer fires
+  unsigned int staleTexts;  // a bitmask, indexed by stat
+  QTimer refreshTimer;
+  void markTextStale(StatsEnum stat);
+  void refreshTexts();
+  QString getText(StatsEnum stat) const;
   static float getEffectiveDistance(int distance);
   void reset(StatsEnum stat);
   bool isInteger(StatsEnum stat);
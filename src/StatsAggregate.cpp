@@ -0,0 +1,142 @@
+#include "StatsAggregate.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mms {
+
+const char *StatsAggregate::COMPLETE_STATUS = "complete";
+const QVector<double> StatsAggregate::QUANTILES = {0.5, 0.9, 0.99};
+
+StatsAggregate::StatsAggregate()
+    : m_numRuns(0), m_numComplete(0), m_numSolved(0) {
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    m_summaries[i].count = 0;
+    m_summaries[i].mean = 0.0;
+    m_summaries[i].sumOfSquares = 0.0;
+    m_summaries[i].min = 0.0;
+    m_summaries[i].max = 0.0;
+  }
+}
+
+void StatsAggregate::add(const QString &status, const Stats *stats) {
+  m_numRuns += 1;
+  if (status == COMPLETE_STATUS) {
+    m_numComplete += 1;
+  }
+  if (stats == nullptr) {
+    return;
+  }
+  Stats::State state = stats->getState();
+  if (state.solved) {
+    m_numSolved += 1;
+  }
+  for (int i = 0; i < NUM_STATS; i += 1) {
+    StatsEnum stat = static_cast<StatsEnum>(i);
+    // Best run stats have no value until a start-to-finish run is recorded
+    if (!state.bestRunRecorded && Stats::isBestRunStat(stat)) {
+      continue;
+    }
+    add(&m_summaries[i], state.values[i]);
+  }
+}
+
+int StatsAggregate::getNumRuns() const { return m_numRuns; }
+
+void StatsAggregate::add(Summary *summary, double value) {
+  if (summary->count == 0) {
+    summary->min = value;
+    summary->max = value;
+  } else {
+    summary->min = std::min(summary->min, value);
+    summary->max = std::max(summary->max, value);
+  }
+  summary->count += 1;
+  double difference = value - summary->mean;
+  summary->mean += difference / summary->count;
+  summary->sumOfSquares += difference * (value - summary->mean);
+  summary->sketch.add(value);
+}
+
+double StatsAggregate::getStandardDeviation(const Summary &summary) {
+  // The sample standard deviation, which is undefined for a single value
+  if (summary.count < 2) {
+    return 0.0;
+  }
+  return std::sqrt(summary.sumOfSquares / (summary.count - 1));
+}
+
+QString StatsAggregate::getQuantileName(double quantile) {
+  return "p" + QString::number(quantile * 100);
+}
+
+QStringList StatsAggregate::getCsvHeader() {
+  QStringList fields = {"runs", "complete", "solved"};
+  for (const QString &name : STRING_TO_STAT().keys()) {
+    QStringList columns = {"count", "mean", "stddev", "min"};
+    for (double quantile : QUANTILES) {
+      columns.append(getQuantileName(quantile));
+    }
+    columns.append("max");
+    for (const QString &column : columns) {
+      fields.append(name + "-" + column);
+    }
+  }
+  return fields;
+}
+
+QStringList StatsAggregate::getCsvFields() const {
+  QStringList fields = {QString::number(m_numRuns),
+                        QString::number(m_numComplete),
+                        QString::number(m_numSolved)};
+  for (StatsEnum stat : STRING_TO_STAT().values()) {
+    const Summary &summary = m_summaries[static_cast<int>(stat)];
+    fields.append(QString::number(summary.count));
+    // The other columns (mean, stddev, min, quantiles, and max) are empty if
+    // the stat never had a value
+    if (summary.count == 0) {
+      for (int i = 0; i < 4 + QUANTILES.size(); i += 1) {
+        fields.append("");
+      }
+      continue;
+    }
+    fields.append(QString::number(summary.mean));
+    fields.append(QString::number(getStandardDeviation(summary)));
+    fields.append(QString::number(summary.min));
+    for (double quantile : QUANTILES) {
+      fields.append(QString::number(summary.sketch.getQuantile(quantile)));
+    }
+    fields.append(QString::number(summary.max));
+  }
+  return fields;
+}
+
+QJsonObject StatsAggregate::toJson() const {
+  QJsonObject stats;
+  for (const QString &name : STRING_TO_STAT().keys()) {
+    const Summary &summary =
+        m_summaries[static_cast<int>(STRING_TO_STAT().value(name))];
+    QJsonObject object;
+    object.insert("count", summary.count);
+    // The other fields are left out if the stat never had a value
+    if (0 < summary.count) {
+      object.insert("mean", summary.mean);
+      object.insert("stddev", getStandardDeviation(summary));
+      object.insert("min", summary.min);
+      for (double quantile : QUANTILES) {
+        object.insert(getQuantileName(quantile),
+                      summary.sketch.getQuantile(quantile));
+      }
+      object.insert("max", summary.max);
+    }
+    stats.insert(name, object);
+  }
+  QJsonObject object;
+  object.insert("runs", m_numRuns);
+  object.insert("complete", m_numComplete);
+  object.insert("solved", m_numSolved);
+  object.insert("stats", stats);
+  return object;
+}
+
+}  // namespace mms
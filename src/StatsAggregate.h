@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "QuantileSketch.h"
+#include "Stats.h"
+
+namespace mms {
+
+// A StatsAggregate summarizes the stats of many runs, e.g., the repeats of a
+// single maze or a whole batch, in constant memory: the mean and variance of
+// each stat are computed incrementally, and its quantiles are estimated by a
+// sketch. Stats that have no value for a run (i.e., best run stats of a run
+// that never reached the goal) are left out of that stat's summary.
+class StatsAggregate {
+ public:
+  StatsAggregate();
+
+  // The stats may be null if the maze couldn't be run at all
+  void add(const QString &status, const Stats *stats);
+  int getNumRuns() const;
+
+  // The fields of a CSV row, in the same order as the header
+  static QStringList getCsvHeader();
+  QStringList getCsvFields() const;
+  QJsonObject toJson() const;
+
+ private:
+  static const char *COMPLETE_STATUS;
+  static const QVector<double> QUANTILES;
+
+  // Welford's algorithm, which is numerically stable, plus a sketch
+  struct Summary {
+    int count;
+    double mean;
+    double sumOfSquares;  // of the differences from the mean
+    double min;
+    double max;
+    QuantileSketch sketch;
+  };
+
+  int m_numRuns;
+  int m_numComplete;
+  int m_numSolved;
+  Summary m_summaries[NUM_STATS];  // indexed by stat
+
+  static void add(Summary *summary, double value);
+  static double getStandardDeviation(const Summary &summary);
+  static QString getQuantileName(double quantile);
+};
+
+}  // namespace mms
@@ -0,0 +1,383 @@
+#include "TextProtocol.h"
+
+#include <charconv>
+#include <system_error>
+
+#include <QByteArrayList>
+#include <QtNumeric>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+const QByteArray TextProtocol::BINARY_HANDSHAKE = "useBinaryProtocol";
+
+const QHash<QByteArrayView, const CommandSchema *> &
+TextProtocol::SIGNATURES() {
+  // The keys view the schema's string literals, which live for the life of
+  // the program
+  static const QHash<QByteArrayView, const CommandSchema *> map = []() {
+    QHash<QByteArrayView, const CommandSchema *> hash;
+    for (const CommandSchema &schema : COMMAND_SCHEMAS) {
+      hash.insert(schema.name, &schema);
+    }
+    for (const CommandAlias &alias : COMMAND_ALIASES) {
+      hash.insert(alias.name, &getCommandSchema(alias.type));
+    }
+    return hash;
+  }();
+  return map;
+}
+
+bool TextProtocol::parse(QByteArrayView line, Command *command) {
+  // Views into the line are used throughout, so nothing is allocated, and
+  // only text arguments are decoded
+  QByteArrayView remaining = line;
+  QByteArrayView function = nextToken(&remaining);
+  const CommandSchema *schema = SIGNATURES().value(function, nullptr);
+  if (schema == nullptr) {
+    return false;
+  }
+  command->type = schema->type;
+
+  bool ok = true;
+  switch (schema->args) {
+    case Args::NONE:
+      break;
+    case Args::COUNT:
+      command->n = 1;
+      if (!isBlank(remaining)) {
+        command->n = toInt(nextToken(&remaining), &ok);
+      }
+      break;
+    case Args::POSITION:
+    case Args::POSITION_AND_CHAR:
+    case Args::POSITION_AND_INTEGER:
+      command->x = toInt(nextToken(&remaining), &ok);
+      command->y = toInt(nextToken(&remaining), &ok);
+      if (!ok) {
+        return false;
+      }
+      if (schema->args == Args::POSITION_AND_INTEGER) {
+        command->n = toInt(nextToken(&remaining), &ok);
+      } else if (schema->args == Args::POSITION_AND_CHAR) {
+        QByteArrayView c = nextToken(&remaining);
+        if (c.size() != 1) {
+          return false;
+        }
+        command->c = QChar::fromLatin1(c.at(0));
+      }
+      break;
+    case Args::POSITION_AND_TEXT: {
+      // Special parsing to allow space characters in the text: the position
+      // and text are separated by single spaces, not split into tokens
+      int space = remaining.indexOf(' ');
+      if (space < 0) {
+        return false;
+      }
+      command->x = toInt(remaining.first(space), &ok);
+      remaining = remaining.sliced(space + 1);
+      space = remaining.indexOf(' ');
+      if (space < 0) {
+        return false;
+      }
+      command->y = toInt(remaining.first(space), &ok);
+      if (!ok) {
+        return false;
+      }
+      command->text = QString::fromUtf8(remaining.sliced(space + 1));
+      return true;
+    }
+    case Args::STAT: {
+      auto stat = STATS().constFind(nextToken(&remaining));
+      if (stat == STATS().constEnd()) {
+        return false;
+      }
+      command->stat = *stat;
+      break;
+    }
+    case Args::INTEGERS:
+      while (!isBlank(remaining)) {
+        command->values.append(toInt(nextToken(&remaining), &ok));
+      }
+      if (!ok) {
+        return false;
+      }
+      break;
+    case Args::CELLS_AND_CHARS:
+      while (!isBlank(remaining)) {
+        Cell cell;
+        bool okX = true;
+        bool okY = true;
+        cell.x = toInt(nextToken(&remaining), &okX);
+        cell.y = toInt(nextToken(&remaining), &okY);
+        QByteArrayView c = nextToken(&remaining);
+        if (!okX || !okY || c.size() != 1) {
+          return false;
+        }
+        cell.c = QChar::fromLatin1(c.at(0));
+        command->cells.append(cell);
+      }
+      break;
+    case Args::CELLS_AND_TEXTS:
+      while (!isBlank(remaining)) {
+        Cell cell;
+        bool okX = true;
+        bool okY = true;
+        bool okLength = true;
+        cell.x = toInt(nextToken(&remaining), &okX);
+        cell.y = toInt(nextToken(&remaining), &okY);
+        int length = toInt(nextToken(&remaining), &okLength);
+        if (!okX || !okY || !okLength || length < 0) {
+          return false;
+        }
+        // The text is length-prefixed (so it may contain spaces) and
+        // separated from its length by a single space
+        if (remaining.size() < 1 + length || remaining.at(0) != ' ') {
+          return false;
+        }
+        cell.text = QString::fromUtf8(remaining.sliced(1, length));
+        remaining = remaining.sliced(1 + length);
+        command->cells.append(cell);
+      }
+      break;
+    case Args::CHAR_AND_CELLS: {
+      QByteArrayView c = nextToken(&remaining);
+      if (c.size() != 1) {
+        return false;
+      }
+      command->c = QChar::fromLatin1(c.at(0));
+      while (!isBlank(remaining)) {
+        Cell cell;
+        bool okX = true;
+        bool okY = true;
+        cell.x = toInt(nextToken(&remaining), &okX);
+        cell.y = toInt(nextToken(&remaining), &okY);
+        if (!okX || !okY) {
+          return false;
+        }
+        command->cells.append(cell);
+      }
+      break;
+    }
+    case Args::GRID_OF_CHARS:
+      command->text = QString::fromLatin1(nextToken(&remaining));
+      break;
+    case Args::GRID_OF_TEXTS: {
+      // The fields are fixed-width (so they may contain spaces), and follow
+      // their width after a single space, up to the end of the line
+      command->n = toInt(nextToken(&remaining), &ok);
+      if (!ok || command->n < 1 || remaining.size() < 1 ||
+          remaining.at(0) != ' ') {
+        return false;
+      }
+      QByteArrayView fields = remaining.sliced(1);
+      if (fields.size() % command->n != 0) {
+        return false;
+      }
+      command->text = QString::fromLatin1(fields);
+      return true;
+    }
+    case Args::MOVES:
+      while (!isBlank(remaining)) {
+        if (!appendMove(nextToken(&remaining), &command->values)) {
+          return false;
+        }
+      }
+      if (command->values.isEmpty()) {
+        return false;
+      }
+      break;
+    case Args::NAME_AND_NUMBER: {
+      // Valid names are ASCII (see AlgoMetrics::isValidName), which the
+      // simulation checks, so the name needn't be decoded as UTF-8
+      QByteArrayView name = nextToken(&remaining);
+      command->value = toDouble(nextToken(&remaining), &ok);
+      if (!ok || name.isEmpty()) {
+        return false;
+      }
+      command->text = QString::fromLatin1(name);
+      break;
+    }
+  }
+
+  // Extra arguments make the command invalid
+  return isBlank(remaining);
+}
+
+const QHash<QByteArrayView, StatsEnum> &TextProtocol::STATS() {
+  // The keys view the names, which are kept alongside them for the life of
+  // the program
+  static const QByteArrayList names = []() {
+    QByteArrayList list;
+    for (const QString &name : STRING_TO_STAT().keys()) {
+      list.append(name.toLatin1());
+    }
+    return list;
+  }();
+  static const QHash<QByteArrayView, StatsEnum> map = []() {
+    QHash<QByteArrayView, StatsEnum> hash;
+    for (const QByteArray &name : names) {
+      hash.insert(name, STRING_TO_STAT().value(QString::fromLatin1(name)));
+    }
+    return hash;
+  }();
+  return map;
+}
+
+QByteArrayView TextProtocol::nextToken(QByteArrayView *text) {
+  int start = 0;
+  while (start < text->size() && text->at(start) == ' ') {
+    start += 1;
+  }
+  int end = start;
+  while (end < text->size() && text->at(end) != ' ') {
+    end += 1;
+  }
+  QByteArrayView token = text->sliced(start, end - start);
+  *text = text->sliced(end);
+  return token;
+}
+
+bool TextProtocol::isBlank(QByteArrayView text) {
+  for (int i = 0; i < text.size(); i += 1) {
+    if (text.at(i) != ' ') {
+      return false;
+    }
+  }
+  return true;
+}
+
+int TextProtocol::toInt(QByteArrayView token, bool *ok) {
+  // A decimal integer with an optional sign, like QString::toInt; ok is
+  // only ever cleared, so that a sequence of conversions can share it.
+  // from_chars reads straight from the line, and takes a minus sign but not
+  // a plus sign, which mustn't be followed by another sign either.
+  const char *first = token.data();
+  const char *last = first + token.size();
+  if (first != last && *first == '+') {
+    first += 1;
+    if (first != last && *first == '-') {
+      *ok = false;
+      return 0;
+    }
+  }
+  int value = 0;
+  std::from_chars_result result = std::from_chars(first, last, value);
+  if (result.ec != std::errc() || result.ptr != last) {
+    *ok = false;
+    return 0;
+  }
+  return value;
+}
+
+double TextProtocol::toDouble(QByteArrayView token, bool *ok) {
+  // Read in place, as for toInt; numbers that aren't finite are invalid
+  bool isNumber = false;
+  double value = QByteArray::fromRawData(token.data(), token.size())
+                     .toDouble(&isNumber);
+  if (!isNumber || !qIsFinite(value)) {
+    *ok = false;
+    return 0.0;
+  }
+  return value;
+}
+
+bool TextProtocol::appendMove(QByteArrayView token, QVector<int> *values) {
+  // A letter, then a distance for moves, defaulting to 1, or the degrees of
+  // a turn, defaulting to 90; D is a half-step move, as used on diagonals
+  if (token.isEmpty()) {
+    return false;
+  }
+  bool ok = true;
+  bool hasNumber = 1 < token.size();
+  int number = hasNumber ? toInt(token.sliced(1), &ok) : 1;
+  if (!ok) {
+    return false;
+  }
+  CommandType type;
+  switch (token.at(0)) {
+    case 'F':
+      type = CommandType::MOVE_FORWARD;
+      break;
+    case 'H':
+    case 'D':
+      type = CommandType::MOVE_FORWARD_HALF;
+      break;
+    case 'R':
+    case 'L':
+      if (hasNumber && number != 45 && number != 90) {
+        return false;
+      }
+      if (token.at(0) == 'R') {
+        type = number == 45 ? CommandType::TURN_RIGHT_45
+                            : CommandType::TURN_RIGHT_90;
+      } else {
+        type = number == 45 ? CommandType::TURN_LEFT_45
+                            : CommandType::TURN_LEFT_90;
+      }
+      number = 0;
+      break;
+    default:
+      return false;
+  }
+  values->append(static_cast<int>(type));
+  values->append(number);
+  return true;
+}
+
+QByteArray TextProtocol::encode(const Response &response) {
+  QByteArray bytes;
+  append(response, &bytes);
+  return bytes;
+}
+
+void TextProtocol::append(const Response &response, QByteArray *bytes) {
+  switch (response.type) {
+    case ResponseType::ACK:
+      // A movement also says which walls are around the mouse, if asked to
+      if (response.values.isEmpty()) {
+        bytes->append("ack\n", 4);
+      } else {
+        bytes->append("ack ", 4);
+        bytes->append(QByteArray::number(response.values.first()));
+        bytes->append('\n');
+      }
+      break;
+    case ResponseType::CRASH:
+      // A move sequence also says which of its steps crashed
+      if (response.values.isEmpty()) {
+        bytes->append("crash\n", 6);
+      } else {
+        bytes->append("crash ", 6);
+        bytes->append(QByteArray::number(response.values.first()));
+        bytes->append('\n');
+      }
+      break;
+    case ResponseType::BOOL:
+      if (response.value) {
+        bytes->append("true\n", 5);
+      } else {
+        bytes->append("false\n", 6);
+      }
+      break;
+    case ResponseType::INTEGER:
+    case ResponseType::FLOAT:
+      bytes->append(QByteArray::number(response.value));
+      bytes->append('\n');
+      break;
+    case ResponseType::INTEGERS:
+      for (int i = 0; i < response.values.size(); i += 1) {
+        if (0 < i) {
+          bytes->append(' ');
+        }
+        bytes->append(QByteArray::number(response.values.at(i)));
+      }
+      bytes->append('\n');
+      break;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
+
+}  // namespace mms
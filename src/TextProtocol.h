@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+
+#include "Command.h"
+#include "ProtocolSchema.h"
+
+namespace mms {
+
+// The default protocol: newline-delimited, human-readable commands and
+// responses, as documented in the README
+class TextProtocol {
+ public:
+  TextProtocol() = delete;
+
+  // Sent by the algo to switch both directions to the binary protocol
+  static const QByteArray BINARY_HANDSHAKE;
+
+  // Returns false if the line isn't a valid command. The line is UTF-8, but
+  // only text arguments need to be decoded.
+  static bool parse(QByteArrayView line, Command *command);
+
+  static QByteArray encode(const Response &response);
+
+  // Appends the encoded response, e.g., to a batch of responses, without
+  // allocating a temporary array for each one
+  static void append(const Response &response, QByteArray *bytes);
+
+ private:
+  // Maps each command name, and each alias, to its schema, so that a line is
+  // dispatched with a single lookup
+  static const QHash<QByteArrayView, const CommandSchema *> &SIGNATURES();
+
+  // Maps each name that getStat accepts to its stat, as STRING_TO_STAT does,
+  // but without decoding the name first
+  static const QHash<QByteArrayView, StatsEnum> &STATS();
+
+  // Returns the next space-separated token, and advances past it
+  static QByteArrayView nextToken(QByteArrayView *text);
+
+  // Whether the text is empty or only spaces
+  static bool isBlank(QByteArrayView text);
+
+  // Clears ok if the token isn't a decimal integer that fits in an int
+  static int toInt(QByteArrayView token, bool *ok);
+
+  // Likewise for a decimal number, e.g., "2.5" or "-1e3"
+  static double toDouble(QByteArrayView token, bool *ok);
+
+  // Appends the type and distance of a step of a move sequence to the
+  // values, e.g., "F6" is moveForward 6; returns false if it's invalid
+  static bool appendMove(QByteArrayView token, QVector<int> *values);
+};
+
+}  // namespace mms
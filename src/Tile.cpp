@@ -5,30 +5,37 @@
 
 namespace mms {
 
-Tile::Tile() { ASSERT_NEVER_RUNS(); }
-
-Tile::Tile(int x, int y, int distance, QMap<Direction, bool> walls)
-    : m_x(x), m_y(y), m_distance(distance), m_walls(walls) {}
+Tile::Tile(int x, int y, int mazeWidth, int mazeHeight)
+    : m_x(x), m_y(y), m_mazeWidth(mazeWidth), m_mazeHeight(mazeHeight) {}
 
 int Tile::getX() const { return m_x; }
 
 int Tile::getY() const { return m_y; }
 
-int Tile::getDistance() const { return m_distance; }
-
-bool Tile::isWall(Direction direction) const {
-  return m_walls.value(direction);
+Polygon Tile::getFullPolygon() const {
+  Rectangle full = getFullRectangle();
+  return Polygon({
+      full.lowerLeft,
+      full.upperLeft,
+      full.upperRight,
+      full.lowerRight,
+  });
 }
 
-Polygon Tile::getFullPolygon() const { return m_fullPolygon; }
-
-Polygon Tile::getWallPolygon(Direction direction) const {
-  return m_wallPolygons.value(direction);
+bool Tile::ownsWall(Direction direction) const {
+  // Each wall between two tiles belongs to the tile to its south or west
+  return (direction != Direction::WEST || getX() == 0) &&
+         (direction != Direction::SOUTH || getY() == 0);
 }
 
-QVector<Polygon> Tile::getCornerPolygons() const { return m_cornerPolygons; }
+bool Tile::ownsCorner(int cornerNumber) const {
+  // Likewise, each post belongs to the tile to its southwest, if any
+  bool isLeft = cornerNumber == 0 || cornerNumber == 1;
+  bool isLower = cornerNumber == 0 || cornerNumber == 3;
+  return (!isLeft || getX() == 0) && (!isLower || getY() == 0);
+}
 
-void Tile::initPolygons(int mazeWidth, int mazeHeight) {
+Polygon Tile::getWallPolygon(Direction direction) const {
   //  The polygons associated with each tile are as follows:
   //
   //      full: 05af
@@ -56,15 +63,106 @@ void Tile::initPolygons(int mazeWidth, int mazeHeight) {
   //      1---2-------------d---e
   //      |   |             |   |
   //      0---3-------------c---f
+  //
+  //  except that the walls and corners on the north and east sides extend
+  //  past the full polygon, into the neighboring tiles, which don't have
+  //  their own polygons for them.
+  ASSERT_TR(ownsWall(direction));
+  Rectangle outer = getFullRectangle();
+  Rectangle inner = getInteriorRectangle(outer);
+  switch (direction) {
+    case Direction::NORTH: {
+      Distance top = getTop(outer);
+      return Polygon({
+          inner.upperLeft,
+          Coordinate::Cartesian(inner.upperLeft.getX(), top),
+          Coordinate::Cartesian(inner.upperRight.getX(), top),
+          inner.upperRight,
+      });
+    }
+    case Direction::EAST: {
+      Distance right = getRight(outer);
+      return Polygon({
+          inner.lowerRight,
+          inner.upperRight,
+          Coordinate::Cartesian(right, inner.upperRight.getY()),
+          Coordinate::Cartesian(right, inner.lowerRight.getY()),
+      });
+    }
+    case Direction::SOUTH:
+      return Polygon({
+          Coordinate::Cartesian(inner.lowerLeft.getX(),
+                                outer.lowerLeft.getY()),
+          inner.lowerLeft,
+          inner.lowerRight,
+          Coordinate::Cartesian(inner.lowerRight.getX(),
+                                outer.lowerRight.getY()),
+      });
+    case Direction::WEST:
+      return Polygon({
+          Coordinate::Cartesian(outer.lowerLeft.getX(),
+                                inner.lowerLeft.getY()),
+          Coordinate::Cartesian(outer.upperLeft.getX(),
+                                inner.upperLeft.getY()),
+          inner.upperLeft,
+          inner.lowerLeft,
+      });
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+}
 
-  // Order is important
-  initFullPolygon(mazeWidth, mazeHeight);
-  initInteriorPolygon(mazeWidth, mazeHeight);
-  initWallPolygons();
-  initCornerPolygons();
+Polygon Tile::getCornerPolygon(int cornerNumber) const {
+  // Like the walls, the posts extend across the edges, into the next tiles
+  ASSERT_TR(ownsCorner(cornerNumber));
+  Rectangle outer = getFullRectangle();
+  Rectangle inner = getInteriorRectangle(outer);
+  switch (cornerNumber) {
+    case 0:
+      return Polygon({
+          outer.lowerLeft,
+          Coordinate::Cartesian(outer.lowerLeft.getX(),
+                                inner.lowerLeft.getY()),
+          inner.lowerLeft,
+          Coordinate::Cartesian(inner.lowerLeft.getX(),
+                                outer.lowerLeft.getY()),
+      });
+    case 1: {
+      Distance top = getTop(outer);
+      return Polygon({
+          Coordinate::Cartesian(outer.upperLeft.getX(),
+                                inner.upperLeft.getY()),
+          Coordinate::Cartesian(outer.upperLeft.getX(), top),
+          Coordinate::Cartesian(inner.upperLeft.getX(), top),
+          inner.upperLeft,
+      });
+    }
+    case 2: {
+      Distance top = getTop(outer);
+      Distance right = getRight(outer);
+      return Polygon({
+          inner.upperRight,
+          Coordinate::Cartesian(inner.upperRight.getX(), top),
+          Coordinate::Cartesian(right, top),
+          Coordinate::Cartesian(right, inner.upperRight.getY()),
+      });
+    }
+    case 3: {
+      Distance right = getRight(outer);
+      return Polygon({
+          Coordinate::Cartesian(inner.lowerRight.getX(),
+                                outer.lowerRight.getY()),
+          inner.lowerRight,
+          Coordinate::Cartesian(right, inner.lowerRight.getY()),
+          Coordinate::Cartesian(right, outer.lowerRight.getY()),
+      });
+    }
+    default:
+      ASSERT_NEVER_RUNS();
+  }
 }
 
-void Tile::initFullPolygon(int mazeWidth, int mazeHeight) {
+Tile::Rectangle Tile::getFullRectangle() const {
   Distance halfWallWidth = Dimensions::halfWallWidth();
   Distance tileLength = Dimensions::tileLength();
   Coordinate lowerLeftPoint = Coordinate::Cartesian(
@@ -72,140 +170,46 @@ void Tile::initFullPolygon(int mazeWidth, int mazeHeight) {
       tileLength * getY() - halfWallWidth * (getY() == 0 ? 1 : 0));
   Coordinate upperRightPoint = Coordinate::Cartesian(
       tileLength * (getX() + 1) +
-          halfWallWidth * (getX() == mazeWidth - 1 ? 1 : 0),
+          halfWallWidth * (getX() == m_mazeWidth - 1 ? 1 : 0),
       tileLength * (getY() + 1) +
-          halfWallWidth * (getY() == mazeHeight - 1 ? 1 : 0));
-  Coordinate lowerRightPoint =
-      Coordinate::Cartesian(upperRightPoint.getX(), lowerLeftPoint.getY());
-  Coordinate upperLeftPoint =
-      Coordinate::Cartesian(lowerLeftPoint.getX(), upperRightPoint.getY());
-  m_fullPolygon = Polygon({
+          halfWallWidth * (getY() == m_mazeHeight - 1 ? 1 : 0));
+  return {
       lowerLeftPoint,
-      upperLeftPoint,
+      Coordinate::Cartesian(lowerLeftPoint.getX(), upperRightPoint.getY()),
       upperRightPoint,
-      lowerRightPoint,
-  });
+      Coordinate::Cartesian(upperRightPoint.getX(), lowerLeftPoint.getY()),
+  };
 }
 
-void Tile::initInteriorPolygon(int mazeWidth, int mazeHeight) {
+Tile::Rectangle Tile::getInteriorRectangle(const Rectangle &full) const {
   Distance halfWallWidth = Dimensions::halfWallWidth();
-  Coordinate lowerLeftPoint = m_fullPolygon.getVertices().at(0);
-  Coordinate upperLeftPoint = m_fullPolygon.getVertices().at(1);
-  Coordinate upperRightPoint = m_fullPolygon.getVertices().at(2);
-  Coordinate lowerRightPoint = m_fullPolygon.getVertices().at(3);
-
-  m_interiorPolygon = Polygon({
-      lowerLeftPoint +
-          Coordinate::Cartesian(halfWallWidth * (getX() == 0 ? 2 : 1),
-                                halfWallWidth * (getY() == 0 ? 2 : 1)),
-      upperLeftPoint +
-          Coordinate::Cartesian(
-              halfWallWidth * (getX() == 0 ? 2 : 1),
-              halfWallWidth * (getY() == mazeHeight - 1 ? -2 : -1)),
-      upperRightPoint +
-          Coordinate::Cartesian(
-              halfWallWidth * (getX() == mazeWidth - 1 ? -2 : -1),
-              halfWallWidth * (getY() == mazeHeight - 1 ? -2 : -1)),
-      lowerRightPoint + Coordinate::Cartesian(
-                            halfWallWidth * (getX() == mazeWidth - 1 ? -2 : -1),
-                            halfWallWidth * (getY() == 0 ? 2 : 1)),
-  });
+  Distance left = halfWallWidth * (getX() == 0 ? 2 : 1);
+  Distance right = halfWallWidth * (getX() == m_mazeWidth - 1 ? -2 : -1);
+  Distance lower = halfWallWidth * (getY() == 0 ? 2 : 1);
+  Distance upper = halfWallWidth * (getY() == m_mazeHeight - 1 ? -2 : -1);
+  return {
+      full.lowerLeft + Coordinate::Cartesian(left, lower),
+      full.upperLeft + Coordinate::Cartesian(left, upper),
+      full.upperRight + Coordinate::Cartesian(right, upper),
+      full.lowerRight + Coordinate::Cartesian(right, lower),
+  };
+}
+
+Distance Tile::getTop(const Rectangle &full) const {
+  return getFarEdge(full.upperLeft.getY(), getY(), m_mazeHeight);
 }
 
-void Tile::initWallPolygons() {
-  Coordinate outerLowerLeftPoint = m_fullPolygon.getVertices().at(0);
-  Coordinate outerUpperLeftPoint = m_fullPolygon.getVertices().at(1);
-  Coordinate outerUpperRightPoint = m_fullPolygon.getVertices().at(2);
-  Coordinate outerLowerRightPoint = m_fullPolygon.getVertices().at(3);
-
-  Coordinate innerLowerLeftPoint = m_interiorPolygon.getVertices().at(0);
-  Coordinate innerUpperLeftPoint = m_interiorPolygon.getVertices().at(1);
-  Coordinate innerUpperRightPoint = m_interiorPolygon.getVertices().at(2);
-  Coordinate innerLowerRightPoint = m_interiorPolygon.getVertices().at(3);
-
-  QVector<Coordinate> northWall;
-  northWall.append(innerUpperLeftPoint);
-  northWall.append(Coordinate::Cartesian(innerUpperLeftPoint.getX(),
-                                         outerUpperLeftPoint.getY()));
-  northWall.append(Coordinate::Cartesian(innerUpperRightPoint.getX(),
-                                         outerUpperRightPoint.getY()));
-  northWall.append(innerUpperRightPoint);
-  m_wallPolygons.insert(Direction::NORTH, Polygon(northWall));
-
-  QVector<Coordinate> eastWall;
-  eastWall.append(innerLowerRightPoint);
-  eastWall.append(innerUpperRightPoint);
-  eastWall.append(Coordinate::Cartesian(outerUpperRightPoint.getX(),
-                                        innerUpperRightPoint.getY()));
-  eastWall.append(Coordinate::Cartesian(outerLowerRightPoint.getX(),
-                                        innerLowerRightPoint.getY()));
-  m_wallPolygons.insert(Direction::EAST, Polygon(eastWall));
-
-  QVector<Coordinate> southWall;
-  southWall.append(Coordinate::Cartesian(innerLowerLeftPoint.getX(),
-                                         outerLowerLeftPoint.getY()));
-  southWall.append(innerLowerLeftPoint);
-  southWall.append(innerLowerRightPoint);
-  southWall.append(Coordinate::Cartesian(innerLowerRightPoint.getX(),
-                                         outerLowerRightPoint.getY()));
-  m_wallPolygons.insert(Direction::SOUTH, Polygon(southWall));
-
-  QVector<Coordinate> westWall;
-  westWall.append(Coordinate::Cartesian(outerLowerLeftPoint.getX(),
-                                        innerLowerLeftPoint.getY()));
-  westWall.append(Coordinate::Cartesian(outerUpperLeftPoint.getX(),
-                                        innerUpperLeftPoint.getY()));
-  westWall.append(innerUpperLeftPoint);
-  westWall.append(innerLowerLeftPoint);
-  m_wallPolygons.insert(Direction::WEST, Polygon(westWall));
+Distance Tile::getRight(const Rectangle &full) const {
+  return getFarEdge(full.upperRight.getX(), getX(), m_mazeWidth);
 }
 
-void Tile::initCornerPolygons() {
-  Coordinate outerLowerLeftPoint = m_fullPolygon.getVertices().at(0);
-  Coordinate outerUpperLeftPoint = m_fullPolygon.getVertices().at(1);
-  Coordinate outerUpperRightPoint = m_fullPolygon.getVertices().at(2);
-  Coordinate outerLowerRightPoint = m_fullPolygon.getVertices().at(3);
-
-  Coordinate innerLowerLeftPoint = m_interiorPolygon.getVertices().at(0);
-  Coordinate innerUpperLeftPoint = m_interiorPolygon.getVertices().at(1);
-  Coordinate innerUpperRightPoint = m_interiorPolygon.getVertices().at(2);
-  Coordinate innerLowerRightPoint = m_interiorPolygon.getVertices().at(3);
-
-  QVector<Coordinate> lowerLeftCorner;
-  lowerLeftCorner.append(outerLowerLeftPoint);
-  lowerLeftCorner.append(Coordinate::Cartesian(outerLowerLeftPoint.getX(),
-                                               innerLowerLeftPoint.getY()));
-  lowerLeftCorner.append(innerLowerLeftPoint);
-  lowerLeftCorner.append(Coordinate::Cartesian(innerLowerLeftPoint.getX(),
-                                               outerLowerLeftPoint.getY()));
-  m_cornerPolygons.append(Polygon(lowerLeftCorner));
-
-  QVector<Coordinate> upperLeftCorner;
-  upperLeftCorner.append(Coordinate::Cartesian(outerUpperLeftPoint.getX(),
-                                               innerUpperLeftPoint.getY()));
-  upperLeftCorner.append(outerUpperLeftPoint);
-  upperLeftCorner.append(Coordinate::Cartesian(innerUpperLeftPoint.getX(),
-                                               outerUpperLeftPoint.getY()));
-  upperLeftCorner.append(innerUpperLeftPoint);
-  m_cornerPolygons.append(Polygon(upperLeftCorner));
-
-  QVector<Coordinate> upperRightCorner;
-  upperRightCorner.append(innerUpperRightPoint);
-  upperRightCorner.append(Coordinate::Cartesian(innerUpperRightPoint.getX(),
-                                                outerUpperRightPoint.getY()));
-  upperRightCorner.append(outerUpperRightPoint);
-  upperRightCorner.append(Coordinate::Cartesian(outerUpperRightPoint.getX(),
-                                                innerUpperRightPoint.getY()));
-  m_cornerPolygons.append(Polygon(upperRightCorner));
-
-  QVector<Coordinate> lowerRightCorner;
-  lowerRightCorner.append(Coordinate::Cartesian(innerLowerRightPoint.getX(),
-                                                outerLowerRightPoint.getY()));
-  lowerRightCorner.append(innerLowerRightPoint);
-  lowerRightCorner.append(Coordinate::Cartesian(outerLowerRightPoint.getX(),
-                                                innerLowerRightPoint.getY()));
-  lowerRightCorner.append(outerLowerRightPoint);
-  m_cornerPolygons.append(Polygon(lowerRightCorner));
+Distance Tile::getFarEdge(const Distance &edge, int position, int mazeLength) {
+  // Along the boundary of the maze, the edge of the tile is already the far
+  // side of the wall; otherwise, the wall is split evenly between the tiles
+  if (position == mazeLength - 1) {
+    return edge;
+  }
+  return edge + Dimensions::halfWallWidth();
 }
 
 }  // namespace mms
@@ -1,44 +1,59 @@
 #pragma once
 
-#include <QMap>
-#include <QVector>
-
 #include "Direction.h"
+#include "units/Coordinate.h"
+#include "units/Distance.h"
 #include "Polygon.h"
 
 namespace mms {
 
+// Generates the polygons of a single tile; these are only needed for drawing,
+// so the maze itself doesn't hold them (see TileGraphic). Walls and corner
+// posts are shared with the neighboring tiles, so each is drawn, at its full
+// width, by just one of the tiles that it touches.
+//
+// A tile is just its position and the size of the maze: each polygon is
+// computed when it's asked for, and held by no one but the caller, which is
+// only ever a view that is building its geometry (see MazeGeometry).
 class Tile {
  public:
-  Tile();
-  Tile(int x, int y, int distance, QMap<Direction, bool> walls);
+  Tile(int x, int y, int mazeWidth, int mazeHeight);
 
   int getX() const;
   int getY() const;
-  int getDistance() const;
-  bool isWall(Direction direction) const;
 
   Polygon getFullPolygon() const;
-  Polygon getWallPolygon(Direction direction) const;
-  QVector<Polygon> getCornerPolygons() const;
 
-  void initPolygons(int mazeWidth, int mazeHeight);
+  // Corners are numbered lower-left, upper-left, upper-right, lower-right.
+  // Only the walls and corners that the tile owns have polygons.
+  bool ownsWall(Direction direction) const;
+  bool ownsCorner(int cornerNumber) const;
+  Polygon getWallPolygon(Direction direction) const;
+  Polygon getCornerPolygon(int cornerNumber) const;
 
  private:
   int m_x;
   int m_y;
-  int m_distance;
-  QMap<Direction, bool> m_walls;
-
-  Polygon m_fullPolygon;
-  Polygon m_interiorPolygon;
-  QMap<Direction, Polygon> m_wallPolygons;
-  QVector<Polygon> m_cornerPolygons;
-
-  void initFullPolygon(int mazeWidth, int mazeHeight);
-  void initInteriorPolygon(int mazeWidth, int mazeHeight);
-  void initWallPolygons();
-  void initCornerPolygons();
+  int m_mazeWidth;
+  int m_mazeHeight;
+
+  // The corners of the full and interior polygons (see getWallPolygon)
+  struct Rectangle {
+    Coordinate lowerLeft;
+    Coordinate upperLeft;
+    Coordinate upperRight;
+    Coordinate lowerRight;
+  };
+  Rectangle getFullRectangle() const;
+  Rectangle getInteriorRectangle(const Rectangle &full) const;
+
+  // The far sides of the walls at the top and right edges of the tile
+  Distance getTop(const Rectangle &full) const;
+  Distance getRight(const Rectangle &full) const;
+
+  // The far side of the wall at the given edge of a tile, along one axis
+  static Distance getFarEdge(const Distance &edge, int position,
+                             int mazeLength);
 };
 
 }  // namespace mms
@@ -1,90 +1,138 @@
 #include "TileGraphic.h"
 
+#include <algorithm>
+
 #include <QPair>
 
 #include "AssertMacros.h"
 #include "Color.h"
 #include "ColorManager.h"
-#include "FontImage.h"
 
 namespace mms {
 
 TileGraphic::TileGraphic() { ASSERT_NEVER_RUNS(); }
 
-TileGraphic::TileGraphic(const Tile *tile, BufferInterface *bufferInterface,
-                         bool isTruthView)
-    : m_tile(tile),
+TileGraphic::TileGraphic(const Maze *maze, int x, int y,
+                         BufferInterface *bufferInterface, bool isTruthView)
+    : m_maze(maze),
+      m_x(x),
+      m_y(y),
       m_bufferInterface(bufferInterface),
+      m_walls(0),
       m_color(ColorManager::get()->getTileBaseColor()),
       m_colorWasSet(false),
+      m_text({{}, 0}),
+      m_drawnText({{}, 0}),
       m_isTruthView(isTruthView) {}
 
-void TileGraphic::setWall(Direction direction) {
-  m_walls[direction] = true;
-  updateWall(direction);
+bool TileGraphic::setWall(Direction direction) {
+  unsigned char walls = m_walls | Maze::getWallBit(direction);
+  if (walls == m_walls) {
+    return false;
+  }
+  m_walls = walls;
+  return true;
 }
 
-void TileGraphic::clearWall(Direction direction) {
-  m_walls.remove(direction);
-  updateWall(direction);
+bool TileGraphic::clearWall(Direction direction) {
+  unsigned char walls = m_walls & ~Maze::getWallBit(direction);
+  if (walls == m_walls) {
+    return false;
+  }
+  m_walls = walls;
+  return true;
 }
 
-void TileGraphic::setColor(Color color) {
+bool TileGraphic::setColor(Color color) {
+  // Algos often redraw every tile, even the ones that haven't changed
+  if (m_colorWasSet && m_color == color) {
+    return false;
+  }
   m_color = color;
   m_colorWasSet = true;
-  updateColor();
+  return true;
 }
 
-void TileGraphic::clearColor() {
+bool TileGraphic::clearColor() {
+  if (!m_colorWasSet) {
+    return false;
+  }
   m_color = ColorManager::get()->getTileBaseColor();
   m_colorWasSet = false;
-  updateColor();
+  return true;
 }
 
-void TileGraphic::setText(const QString &text) {
-  m_text = text;
-  updateText();
+bool TileGraphic::setText(const QString &text) {
+  Text converted = toText(text);
+  if (converted == m_text) {
+    return false;
+  }
+  m_text = converted;
+  return true;
 }
 
-void TileGraphic::clearText() {
-  m_text = "";
-  updateText();
+bool TileGraphic::clearText() { return setText(""); }
+
+unsigned char TileGraphic::getWalls() const { return m_walls; }
+
+bool TileGraphic::hasColor() const { return m_colorWasSet; }
+
+Color TileGraphic::getColor() const { return m_color; }
+
+QString TileGraphic::getText() const {
+  return QString::fromLatin1(m_text.chars, m_text.length);
 }
 
 void TileGraphic::drawPolygons() const {
   // Note that the order in which we call insertIntoGraphicCpuBuffer
   // determines the order in which the polygons are drawn. Also note that the
-  // *StartingIndex methods in GrahicsUtilities.h depend upon this order.
+  // *PolygonIndex methods in BufferInterface.h depend upon this order.
+
+  // The polygons are only generated if they're needed for the geometry, and
+  // only held for as long as it takes to insert them
+  Tile tile(m_x, m_y, m_maze->getWidth(), m_maze->getHeight());
+  bool isBuilding = m_bufferInterface->isBuildingGeometry();
 
   // Draw the base of the tile
-  m_bufferInterface->insertIntoGraphicCpuBuffer(m_tile->getFullPolygon(),
-                                                m_color, 255);
+  m_bufferInterface->insertIntoGraphicCpuBuffer(
+      isBuilding ? tile.getFullPolygon() : Polygon(), getBaseColor(), 255,
+      getBaseTheme());
 
-  // Draw each of the walls of the tile
+  // Draw each of the walls of the tile; walls that are shared with another
+  // tile are drawn by just one of them, but still take up a polygon index
   for (Direction direction : CARDINAL_DIRECTIONS()) {
-    m_bufferInterface->insertIntoGraphicCpuBuffer(
-        m_tile->getWallPolygon(direction), getWallColor(direction),
-        getWallAlpha(direction));
+    if (tile.ownsWall(direction)) {
+      m_bufferInterface->insertIntoGraphicCpuBuffer(
+          isBuilding ? tile.getWallPolygon(direction) : Polygon(),
+          getWallColor(direction), getWallAlpha(direction),
+          getWallTheme(direction));
+    } else {
+      m_bufferInterface->insertEmptyIntoGraphicCpuBuffer();
+    }
   }
 
-  // Draw the corners of the tile
-  for (Polygon polygon : m_tile->getCornerPolygons()) {
-    m_bufferInterface->insertIntoGraphicCpuBuffer(
-        polygon, ColorManager::get()->getTileCornerColor(), 255);
+  // Draw the corners of the tile, likewise
+  for (int i = 0; i < 4; i += 1) {
+    if (tile.ownsCorner(i)) {
+      m_bufferInterface->insertIntoGraphicCpuBuffer(
+          isBuilding ? tile.getCornerPolygon(i) : Polygon(),
+          ColorManager::get()->getTileCornerColor(), 255,
+          ThemeColor::TILE_CORNER);
+    } else {
+      m_bufferInterface->insertEmptyIntoGraphicCpuBuffer();
+    }
   }
 }
 
-void TileGraphic::drawTextures() const {
-  // Insert all of the triangle texture objects into the buffer ...
-  QPair<int, int> maxRowsAndCols =
-      m_bufferInterface->getTileGraphicTextMaxSize();
-  for (int row = 0; row < maxRowsAndCols.first; row += 1) {
-    for (int col = 0; col < maxRowsAndCols.second; col += 1) {
-      m_bufferInterface->insertIntoTextureCpuBuffer();
-    }
+void TileGraphic::drawTextures() {
+  // The buffer is empty after the text layout changes (see
+  // BufferInterface::initTileGraphicText), so only the glyphs that differ
+  // from an empty text are written, and tiles without text are skipped
+  if (0 < m_text.length) {
+    Text blank = {{}, 0};
+    updateText(&blank);
   }
-  // ... and then populate those triangle texture objects with data
-  updateText();
+  m_drawnText = m_text;
 }
 
 void TileGraphic::refreshColors() {
@@ -96,56 +144,98 @@ void TileGraphic::refreshColors() {
 
 void TileGraphic::updateWall(Direction direction) const {
   m_bufferInterface->updateTileGraphicWallColor(
-      m_tile->getX(), m_tile->getY(), direction, getWallColor(direction),
-      getWallAlpha(direction));
+      m_x, m_y, direction, getWallColor(direction), getWallAlpha(direction),
+      getWallTheme(direction));
 }
 
 void TileGraphic::updateColor() const {
-  Color default_ = ColorManager::get()->getTileBaseColor();
-  Color color = m_colorWasSet ? m_color : default_;
-  m_bufferInterface->updateTileGraphicBaseColor(m_tile->getX(), m_tile->getY(),
-                                                color);
+  m_bufferInterface->updateTileGraphicBaseColor(m_x, m_y, getBaseColor(),
+                                                getBaseTheme());
+}
+
+void TileGraphic::updateText() {
+  // The text may have changed any number of times since it was drawn
+  if (m_text != m_drawnText) {
+    updateText(&m_drawnText);
+    m_drawnText = m_text;
+  }
 }
 
-void TileGraphic::updateText() const {
+void TileGraphic::updateText(const Text *previous) const {
   // First, retrieve the maximum number of rows and cols of text allowed
   QPair<int, int> maxRowsAndCols =
       m_bufferInterface->getTileGraphicTextMaxSize();
 
-  // Then, generate the rows of text that will be displayed
-  QStringList rowsOfText;
-
-  // Split the text into rows
-  QString remaining = m_text;
-  while (!remaining.isEmpty() && rowsOfText.size() < maxRowsAndCols.first) {
-    QString row = remaining.left(maxRowsAndCols.second);
-    rowsOfText.append(row);
-    remaining = remaining.mid(maxRowsAndCols.second);
-  }
-
-  // For all possible character positions, insert some character
-  // (blank if necessary) into the tile text cpu buffer
+  // For all possible character positions, insert some character (blank if
+  // necessary) into the tile text cpu buffer. A glyph's quad depends on the
+  // number of rows of text and the length of its own row, so it only needs
+  // rewriting if one of those, or its character, has changed.
   for (int row = 0; row < maxRowsAndCols.first; row += 1) {
     for (int col = 0; col < maxRowsAndCols.second; col += 1) {
-      int numRows =
-          std::min(static_cast<int>(rowsOfText.size()), maxRowsAndCols.first);
-      int numCols =
-          std::min(static_cast<int>(
-                       row < rowsOfText.size() ? rowsOfText.at(row).size() : 0),
-                   maxRowsAndCols.second);
-      QChar c = ' ';
-      if (row < rowsOfText.size() && col < rowsOfText.at(row).size()) {
-        c = rowsOfText.at(row).at(col);
+      TextLayout layout = getTextLayout(m_text, maxRowsAndCols, row, col);
+      if (previous != nullptr &&
+          layout == getTextLayout(*previous, maxRowsAndCols, row, col)) {
+        continue;
       }
-      ASSERT_TR(FontImage::positions().contains(c));
-      m_bufferInterface->updateTileGraphicText(m_tile->getX(), m_tile->getY(),
-                                               numRows, numCols, row, col, c);
+      m_bufferInterface->updateTileGraphicText(
+          m_x, m_y, layout.numRows, layout.numCols, row, col, layout.c);
     }
   }
 }
 
+TileGraphic::TextLayout TileGraphic::getTextLayout(
+    const Text &text, QPair<int, int> maxRowsAndCols, int row, int col) {
+  // The text fills each row in turn, and whatever doesn't fit is cut off
+  int maxRows = maxRowsAndCols.first;
+  int maxCols = maxRowsAndCols.second;
+  int length = std::min(text.length, maxRows * maxCols);
+  int numRows = (length + maxCols - 1) / maxCols;
+  int numCols = std::max(0, std::min(length - row * maxCols, maxCols));
+  QChar c = col < numCols ? QLatin1Char(text.chars[row * maxCols + col])
+                          : QChar(' ');
+  return {numRows, numCols, c};
+}
+
+TileGraphic::Text TileGraphic::toText(const QString &text) {
+  // Simulations only set printable ASCII (see Simulation::getPrintableText),
+  // but anything else is shown as unprintable, too
+  Text converted = {{}, 0};
+  int length = text.size();
+  if (MAX_TEXT_LENGTH < length) {
+    length = MAX_TEXT_LENGTH;
+  }
+  for (int i = 0; i < length; i += 1) {
+    ushort unicode = text.at(i).unicode();
+    converted.chars[i] = unicode < 0x80 ? static_cast<char>(unicode) : '?';
+  }
+  converted.length = length;
+  return converted;
+}
+
+bool TileGraphic::Text::operator==(const Text &other) const {
+  return length == other.length &&
+         std::equal(chars, chars + length, other.chars);
+}
+
+bool TileGraphic::Text::operator!=(const Text &other) const {
+  return !(*this == other);
+}
+
+bool TileGraphic::TextLayout::operator==(const TextLayout &other) const {
+  return numRows == other.numRows && numCols == other.numCols &&
+         c == other.c;
+}
+
+Color TileGraphic::getBaseColor() const {
+  return m_colorWasSet ? m_color : ColorManager::get()->getTileBaseColor();
+}
+
+ThemeColor TileGraphic::getBaseTheme() const {
+  return m_colorWasSet ? ThemeColor::NONE : ThemeColor::TILE_BASE;
+}
+
 Color TileGraphic::getWallColor(Direction direction) const {
-  if (m_walls.value(direction)) {
+  if (m_walls & Maze::getWallBit(direction)) {
     if (m_isTruthView) {
       return ColorManager::get()->getTileWallColor();
     } else {
@@ -157,10 +247,10 @@ Color TileGraphic::getWallColor(Direction direction) const {
 }
 
 unsigned char TileGraphic::getWallAlpha(Direction direction) const {
-  if (m_walls.value(direction)) {
+  if (m_walls & Maze::getWallBit(direction)) {
     return 255;
   }
-  if (m_tile->isWall(direction)) {
+  if (m_maze->isWall(m_x, m_y, direction)) {
     if (m_isTruthView) {
       return 255;
     } else {
@@ -170,4 +260,16 @@ unsigned char TileGraphic::getWallAlpha(Direction direction) const {
   return 0;
 }
 
+ThemeColor TileGraphic::getWallTheme(Direction direction) const {
+  // Mirrors getWallColor and getWallAlpha
+  if (m_walls & Maze::getWallBit(direction)) {
+    return m_isTruthView ? ThemeColor::TILE_WALL : ThemeColor::TILE_WALL_IS_SET;
+  }
+  if (m_maze->isWall(m_x, m_y, direction) &&
+      !m_isTruthView) {
+    return ThemeColor::TILE_WALL_NOT_SET;
+  }
+  return ThemeColor::TILE_WALL;
+}
+
 }  // namespace mms
@@ -1,57 +1,104 @@
 #pragma once
 
-#include <QMap>
 #include <QPair>
+#include <QString>
 
 #include "BufferInterface.h"
 #include "Color.h"
+#include "Maze.h"
 #include "Tile.h"
+#include "TilePalette.h"
 
 namespace mms {
 
 class TileGraphic {
  public:
+  // The most characters of text that a tile holds; any more couldn't be
+  // shown, since every view has at most this many glyphs per tile (see
+  // MazeView::initTileGraphicText), so they're dropped
+  static constexpr int MAX_TEXT_LENGTH = 16;
+
   TileGraphic();
-  TileGraphic(const Tile *tile, BufferInterface *bufferInterface,
+  TileGraphic(const Maze *maze, int x, int y, BufferInterface *bufferInterface,
               bool isTruthView);
 
-  void setWall(Direction direction);
-  void clearWall(Direction direction);
+  // These only change the state of the tile, and return whether it changed;
+  // the buffers are written by the updates below, which the MazeGraphic
+  // defers until the next frame, so that only the last state is written
+  bool setWall(Direction direction);
+  bool clearWall(Direction direction);
+
+  bool setColor(const Color color);
+  bool clearColor();
 
-  void setColor(const Color color);
-  void clearColor();
+  bool setText(const QString &text);
+  bool clearText();
 
-  void setText(const QString &text);
-  void clearText();
+  // The state set above; walls are a bitmask, see Maze::getWallBit
+  unsigned char getWalls() const;
+  bool hasColor() const;
+  Color getColor() const;
+  QString getText() const;
 
   // TODO: upforgrabs
   // Rename these to "reload" or something
   void drawPolygons() const;
-  void drawTextures() const;
+
+  // Lays out the text again, e.g., once the text layout has changed
+  void drawTextures();
 
   void refreshColors();
 
+  // Write the current state to the buffers
+  void updateWall(Direction direction) const;
+  void updateColor() const;
+  void updateText();
+
  private:
   // Input and output objects
-  const Tile *m_tile;
+  const Maze *m_maze;
+  int m_x;
+  int m_y;
   BufferInterface *m_bufferInterface;
 
   // Visual state
-  QMap<Direction, bool> m_walls;
+  unsigned char m_walls;  // a bitmask, see Maze::getWallBit
   Color m_color;
   bool m_colorWasSet;
-  QString m_text;
 
-  // Helper functions
-  // TODO: upforgrabs
-  // Rename these to "refresh" or something
-  void updateWall(Direction direction) const;
-  void updateColor() const;
-  void updateText() const;
+  // Text is held inline, one byte per character of the font (see FontImage),
+  // so that setting it allocates nothing
+  struct Text {
+    char chars[MAX_TEXT_LENGTH];
+    int length;
+    bool operator==(const Text &other) const;
+    bool operator!=(const Text &other) const;
+  };
+  static Text toText(const QString &text);
+  Text m_text;
+  Text m_drawnText;  // the text in the buffers, as of the last update
+
+  // Only the glyphs that differ from the previous text are rewritten, unless
+  // there's no previous text, e.g., when the glyphs are first inserted
+  void updateText(const Text *previous) const;
+
+  // Where a glyph of text is drawn depends on all of these
+  struct TextLayout {
+    int numRows;
+    int numCols;  // in the glyph's row
+    QChar c;
+    bool operator==(const TextLayout &other) const;
+  };
+  static TextLayout getTextLayout(const Text &text,
+                                  QPair<int, int> maxRowsAndCols, int row,
+                                  int col);
 
   bool m_isTruthView;
+  Color getBaseColor() const;
+  ThemeColor getBaseTheme() const;
   Color getWallColor(Direction direction) const;
   unsigned char getWallAlpha(Direction direction) const;
+  ThemeColor getWallTheme(Direction direction) const;
 };
 
 }  // namespace mms
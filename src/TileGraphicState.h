@@ -0,0 +1,13 @@
+#pragma once
+
+namespace mms {
+
+// The colors of a single tile graphic, in the layout of the tile state texture
+// that the GPU samples them from. In order, these are the colors of the base,
+// the walls (in the order of CARDINAL_DIRECTIONS), and the corners. Each is an
+// index into the palette (see TilePalette), two unused bytes, and an alpha.
+struct TileGraphicState {
+  unsigned char colors[6][4];
+};
+
+}  // namespace mms
@@ -5,42 +5,71 @@
 
 namespace mms {
 
+const int TileGraphicTextCache::NUM_GLYPHS = 128;
+
+TileGraphicTextCache::TileGraphicTextCache()
+    : m_tileGraphicTextMaxSize({0, 0}),
+      m_glyphs(buildGlyphCache()),
+      m_quads(QVector<Quad>()) {}
+
 void TileGraphicTextCache::init(const Distance &wallLength,
                                 const Distance &wallWidth,
                                 QPair<int, int> tileGraphicTextMaxSize) {
   m_wallLength = wallLength;
   m_wallWidth = wallWidth;
   m_tileGraphicTextMaxSize = tileGraphicTextMaxSize;
-  m_tileGraphicTextPositions = buildPositionCache();
+  m_quads = buildQuadCache();
 }
 
 QPair<int, int> TileGraphicTextCache::getTileGraphicTextMaxSize() const {
   return m_tileGraphicTextMaxSize;
 }
 
-QPair<double, double> TileGraphicTextCache::getFontImageCharacterPosition(
+const TileGraphicTextCache::Glyph &TileGraphicTextCache::getFontImageGlyph(
     QChar c) const {
-  ASSERT_TR(FontImage::positions().contains(c));
-  return FontImage::positions().value(c);
+  ASSERT_LT(c.unicode(), NUM_GLYPHS);
+  const Glyph &glyph = m_glyphs.at(c.unicode());
+  ASSERT_LE(0.0, glyph.start);
+  return glyph;
 }
 
-QPair<Coordinate, Coordinate> TileGraphicTextCache::getTileGraphicTextPosition(
-    int x, int y, int numRows, int numCols, int row, int col) const {
-  // Get the character position in the maze for the starting tile
-  QPair<Coordinate, Coordinate> textPosition =
-      m_tileGraphicTextPositions.value({{numRows, numCols}, {row, col}});
+const TileGraphicTextCache::Quad &TileGraphicTextCache::getTileGraphicTextQuad(
+    int numRows, int numCols, int row, int col) const {
+  return m_quads.at(getQuadIndex(numRows, numCols, row, col));
+}
 
-  // Now get the character position in the maze for *this* tile
-  Distance tileLength = m_wallLength + m_wallWidth;
-  Coordinate offset = Coordinate::Cartesian(tileLength * x, tileLength * y);
-  Coordinate LL = textPosition.first + offset;
-  Coordinate UR = textPosition.second + offset;
+double TileGraphicTextCache::getTileLengthMeters() const {
+  return (m_wallLength + m_wallWidth).getMeters();
+}
 
-  return {LL, UR};
+qint64 TileGraphicTextCache::getMemoryBytes() const {
+  return sizeof(Glyph) * m_glyphs.capacity() +
+         sizeof(Quad) * m_quads.capacity();
 }
 
-QMap<QPair<QPair<int, int>, QPair<int, int>>, QPair<Coordinate, Coordinate>>
-TileGraphicTextCache::buildPositionCache() {
+int TileGraphicTextCache::getQuadIndex(int numRows, int numCols, int row,
+                                       int col) const {
+  int maxRows = m_tileGraphicTextMaxSize.first;
+  int maxCols = m_tileGraphicTextMaxSize.second;
+  return ((numRows * (maxCols + 1) + numCols) * maxRows + row) * maxCols + col;
+}
+
+QVector<TileGraphicTextCache::Glyph> TileGraphicTextCache::buildGlyphCache() {
+  // Map from char to fractional position in the image (from 0.0 to 1.0)
+  QVector<Glyph> glyphCache(NUM_GLYPHS, {-1.0f, -1.0f});
+  QString chars = FontImage::characters();
+  int size = chars.size();
+  for (int i = 0; i < size; i += 1) {
+    ASSERT_LT(chars.at(i).unicode(), NUM_GLYPHS);
+    glyphCache[chars.at(i).unicode()] = {
+        static_cast<float>(static_cast<double>(i) / size),
+        static_cast<float>(static_cast<double>(i + 1) / size),
+    };
+  }
+  return glyphCache;
+}
+
+QVector<TileGraphicTextCache::Quad> TileGraphicTextCache::buildQuadCache() {
   // The tile graphic text could look like either of the following, depending
   // on the layout, border, and max size
   //
@@ -62,9 +91,6 @@ TileGraphicTextCache::buildPositionCache() {
   //     *[A]--------------------------*-*    *[A]--------------------------*-*
   //     *-*---------------------------*-*    *-*---------------------------*-*
 
-  QMap<QPair<QPair<int, int>, QPair<int, int>>, QPair<Coordinate, Coordinate>>
-      positionCache;
-
   int maxRows = m_tileGraphicTextMaxSize.first;
   int maxCols = m_tileGraphicTextMaxSize.second;
   double borderFraction = 0.05;  // border padding
@@ -95,6 +121,9 @@ TileGraphicTextCache::buildPositionCache() {
                             (CD.getY() - characterHeight * maxRows) / 2.0);
   Coordinate E = C + scalingOffset;
 
+  QVector<Quad> quadCache((maxRows + 1) * (maxCols + 1) * maxRows * maxCols,
+                          {0.0, 0.0, 0.0, 0.0});
+
   // For all numbers of rows and columns of text
   for (int numRows = 0; numRows <= maxRows; numRows += 1) {
     for (int numCols = 0; numCols <= maxCols; numCols += 1) {
@@ -113,19 +142,18 @@ TileGraphicTextCache::buildPositionCache() {
                   characterHeight * ((numRows - row - 1) + rowOffset + 1));
 
           // Insert the position into the cache
-          positionCache.insert(
-              {
-                  {numRows, numCols},  // Num rows/cols to be drawn
-                  {row, col}           // Row and col of the current character
-              },
-              {LL, UR}  // Lower left and upper right texture coord
-          );
+          quadCache[getQuadIndex(numRows, numCols, row, col)] = {
+              LL.getX().getMeters(),
+              LL.getY().getMeters(),
+              UR.getX().getMeters(),
+              UR.getY().getMeters(),
+          };
         }
       }
     }
   }
 
-  return positionCache;
+  return quadCache;
 }
 
 }  // namespace mms
@@ -1,8 +1,8 @@
 #pragma once
 
 #include <QChar>
-#include <QMap>
 #include <QPair>
+#include <QVector>
 
 #include "units/Coordinate.h"
 
@@ -10,6 +10,22 @@ namespace mms {
 
 class TileGraphicTextCache {
  public:
+  // The lower left and upper right corners of a character, in meters
+  struct Quad {
+    double left;
+    double bottom;
+    double right;
+    double top;
+  };
+
+  // A character's starting and ending position in the font image
+  struct Glyph {
+    float start;
+    float end;
+  };
+
+  TileGraphicTextCache();
+
   // Initialize the cache
   void init(const Distance &wallLength, const Distance &wallWidth,
             QPair<int, int> tileGraphicTextMaxSize);
@@ -17,16 +33,22 @@ class TileGraphicTextCache {
   // Returns the max number of rows and columns of tile graphic text
   QPair<int, int> getTileGraphicTextMaxSize() const;
 
-  // Return a characters starting and ending position in the font image
-  QPair<double, double> getFontImageCharacterPosition(QChar c) const;
+  // The character must be in the font image
+  const Glyph &getFontImageGlyph(QChar c) const;
+
+  // Retrieve the corners of a character within the starting tile, namely
+  // tile (0, 0); offset them by the tile length for any other tile
+  const Quad &getTileGraphicTextQuad(int numRows, int numCols, int row,
+                                     int col) const;
+  double getTileLengthMeters() const;
 
-  // Retrieve the LL and UR coordinates for a particular location
-  QPair<Coordinate, Coordinate> getTileGraphicTextPosition(int x, int y,
-                                                           int numRows,
-                                                           int numCols, int row,
-                                                           int col) const;
+  // The heap memory of the caches
+  qint64 getMemoryBytes() const;
 
  private:
+  // Only ASCII characters can be in the font image
+  static const int NUM_GLYPHS;
+
   // The length and width of maze walls, respectively
   Distance m_wallLength;
   Distance m_wallWidth;
@@ -34,14 +56,19 @@ class TileGraphicTextCache {
   // The max rows and cols of text per tile
   QPair<int, int> m_tileGraphicTextMaxSize;
 
-  // A map of the number of rows/cols to be displayed and the current row/col
-  // to the LL/UR text coordinates for the starting tile, namely tile (0, 0)
-  QMap<QPair<QPair<int, int>, QPair<int, int>>, QPair<Coordinate, Coordinate>>
-      m_tileGraphicTextPositions;
+  // Indexed by character; the characters that aren't in the font image have
+  // a negative start
+  QVector<Glyph> m_glyphs;
+
+  // Indexed by the number of rows/cols to be displayed and the current
+  // row/col, see getQuadIndex; the quads of hidden rows/cols are empty
+  QVector<Quad> m_quads;
+
+  int getQuadIndex(int numRows, int numCols, int row, int col) const;
 
-  // Just a helper method for building the text position cache
-  QMap<QPair<QPair<int, int>, QPair<int, int>>, QPair<Coordinate, Coordinate>>
-  buildPositionCache();
+  // Just helper methods for building the caches
+  static QVector<Glyph> buildGlyphCache();
+  QVector<Quad> buildQuadCache();
 };
 
 }  // namespace mms
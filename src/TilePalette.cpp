@@ -0,0 +1,47 @@
+#include "TilePalette.h"
+
+#include "ColorManager.h"
+
+namespace mms {
+
+const int TilePalette::NUM_COLORS = static_cast<int>(Color::DARK_YELLOW) + 1;
+const int TilePalette::NUM_THEME_COLORS =
+    static_cast<int>(ThemeColor::TILE_CORNER);
+
+int TilePalette::size() { return NUM_COLORS + NUM_THEME_COLORS; }
+
+int TilePalette::getIndex(Color color, ThemeColor theme) {
+  if (theme == ThemeColor::NONE) {
+    return static_cast<int>(color);
+  }
+  return NUM_COLORS + static_cast<int>(theme) - 1;
+}
+
+bool TilePalette::hasThemeAlpha(ThemeColor theme) {
+  return theme == ThemeColor::TILE_WALL_NOT_SET;
+}
+
+QVector<QVector4D> TilePalette::getColors() {
+  auto toRgba = [](Color color, unsigned char alpha) {
+    RGB rgb = COLOR_TO_RGB(color);
+    return QVector4D(rgb.r / 255.0, rgb.g / 255.0, rgb.b / 255.0,
+                     alpha / 255.0);
+  };
+  QVector<QVector4D> colors;
+  colors.reserve(size());
+  for (int i = 0; i < NUM_COLORS; i += 1) {
+    colors.append(toRgba(static_cast<Color>(i), 255));
+  }
+
+  // In the order of the enum
+  ColorManager *theme = ColorManager::get();
+  colors.append(toRgba(theme->getTileBaseColor(), 255));
+  colors.append(toRgba(theme->getTileWallColor(), 255));
+  colors.append(toRgba(theme->getTileWallIsSetColor(), 255));
+  colors.append(toRgba(theme->getTileWallColor(),
+                       theme->getTileWallNotSetAlpha()));
+  colors.append(toRgba(theme->getTileCornerColor(), 255));
+  return colors;
+}
+
+}  // namespace mms
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QVector4D>
+#include <QVector>
+
+#include "Color.h"
+
+namespace mms {
+
+// The colors of a tile that come from the theme (see ColorManager) rather
+// than from an algo
+enum class ThemeColor {
+  NONE,  // not from the theme
+  TILE_BASE,
+  TILE_WALL,
+  TILE_WALL_IS_SET,
+  TILE_WALL_NOT_SET,  // the wall color, at the not-set alpha
+  TILE_CORNER,
+};
+
+// Vertices and the tile state texture hold an index into this palette for
+// each color, rather than the color itself: first the colors of the enum, in
+// order, and then the colors of the theme. A change of theme is then only a
+// change of the palette, no matter how big the maze is.
+class TilePalette {
+ public:
+  TilePalette() = delete;
+
+  static int size();
+
+  // The color is only used if it isn't from the theme
+  static int getIndex(Color color, ThemeColor theme);
+
+  // Whether the alpha of the entry is part of the theme, in which case the
+  // tile's own alpha is ignored
+  static bool hasThemeAlpha(ThemeColor theme);
+
+  // The current colors of every entry, as rgba in [0, 1]
+  static QVector<QVector4D> getColors();
+
+ private:
+  static const int NUM_COLORS;
+  static const int NUM_THEME_COLORS;
+};
+
+}  // namespace mms
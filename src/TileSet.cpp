@@ -0,0 +1,61 @@
+#include "TileSet.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+TileSet::TileSet()
+    : m_generation(1),
+      m_generations(QVector<unsigned int>()),
+      m_isMember(QVector<bool>()),
+      m_touched(QVector<int>()) {}
+
+void TileSet::resize(int numTiles) {
+  ASSERT_LE(0, numTiles);
+  m_generation = 1;
+  m_generations.fill(0, numTiles);
+  m_isMember.fill(false, numTiles);
+  m_touched.clear();
+}
+
+bool TileSet::contains(int index) const {
+  return m_generations.at(index) == m_generation && m_isMember.at(index);
+}
+
+void TileSet::insert(int index) {
+  touch(index);
+  m_isMember[index] = true;
+}
+
+void TileSet::remove(int index) {
+  // An untouched tile can't be a member, so there's nothing to reset
+  if (m_generations.at(index) == m_generation) {
+    m_isMember[index] = false;
+  }
+}
+
+void TileSet::clear() {
+  m_touched.resize(0);
+  m_generation += 1;
+
+  // Stamps from the generation before the counter wrapped around would look
+  // current again, so they're reset, once every four billion clears
+  if (m_generation == 0) {
+    m_generation = 1;
+    m_generations.fill(0);
+  }
+}
+
+const QVector<int> &TileSet::getTouched() const { return m_touched; }
+
+void TileSet::touch(int index) {
+  ASSERT_LE(0, index);
+  ASSERT_LT(index, m_generations.size());
+  if (m_generations.at(index) != m_generation) {
+    m_generations[index] = m_generation;
+    m_isMember[index] = false;
+    m_touched.append(index);
+  }
+}
+
+}  // namespace mms
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QVector>
+
+namespace mms {
+
+// A set of tiles, by index (x * height + y), that's cheap to update and to
+// clear. Membership is a dense per-tile flag, stamped with the generation in
+// which the tile was last touched, so clearing the set only means starting a
+// new generation; stale flags are reset lazily, the next time that their tile
+// is touched. The tiles touched in the current generation are also listed,
+// so that the members can be visited without scanning the whole maze.
+class TileSet {
+ public:
+  TileSet();
+
+  // Clears the set, which must then only hold indices less than the count
+  void resize(int numTiles);
+
+  bool contains(int index) const;
+  void insert(int index);
+  void remove(int index);
+  void clear();
+
+  // Every tile inserted since the last clear, each listed once, in the order
+  // that they were first inserted; some may since have been removed, so
+  // check contains() before using one
+  const QVector<int> &getTouched() const;
+
+ private:
+  unsigned int m_generation;
+  QVector<unsigned int> m_generations;  // in which each tile was touched
+  QVector<bool> m_isMember;             // only valid in the same generation
+  QVector<int> m_touched;
+
+  void touch(int index);
+};
+
+}  // namespace mms
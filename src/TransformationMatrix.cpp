@@ -39,22 +39,14 @@ QMatrix4x4 TransformationMatrix::get(int mazeWidth, int mazeHeight,
   };
 
   QPair<int, int> windowSize = {mapWidthPixels, mapHeightPixels};
-  QPair<int, int> fullMapPosition = {5, 5};
-  QPair<int, int> fullMapSize = {windowSize.first - 10, windowSize.second - 10};
-  QPair<double, double> physicalMazeSize = {
+  double physicalWidth =
       (Dimensions::wallWidth() + Dimensions::tileLength() * mazeWidth)
-          .getMeters(),
+          .getMeters();
+  double physicalHeight =
       (Dimensions::wallWidth() + Dimensions::tileLength() * mazeHeight)
-          .getMeters(),
-  };
-
-  // Ensure that the maze width and height always appear equally scaled. Note
-  // that this is not literally the number of pixels per meter of the screen.
-  // Rather, it's our desired number of pixels per simulation meter.
-  double physicalWidth = physicalMazeSize.first;
-  double physicalHeight = physicalMazeSize.second;
-  double pixelsPerMeter = std::min(fullMapSize.first / physicalWidth,
-                                   fullMapSize.second / physicalHeight);
+          .getMeters();
+  double pixelsPerMeter = getPixelsPerMeter(mazeWidth, mazeHeight,
+                                            mapWidthPixels, mapHeightPixels);
   double pixelWidth = pixelsPerMeter * physicalWidth;
   double pixelHeight = pixelsPerMeter * physicalHeight;
 
@@ -89,12 +81,10 @@ QMatrix4x4 TransformationMatrix::get(int mazeWidth, int mazeHeight,
 
   // Step 3: Construct the translation matrix. Note that here we ensure that
   // the maze is centered within the map boundaries.
-  double pixelLowerLeftCornerX =
-      fullMapPosition.first + 0.5 * (fullMapSize.first - pixelWidth);
-  double pixelLowerLeftCornerY =
-      fullMapPosition.second + 0.5 * (fullMapSize.second - pixelHeight);
-  QPair<double, double> openGlLowerLeftCorner =
-      pixelToOpenGl({pixelLowerLeftCornerX, pixelLowerLeftCornerY}, windowSize);
+  QPair<double, double> openGlLowerLeftCorner = pixelToOpenGl(
+      getPixelLowerLeftCorner(mazeWidth, mazeHeight, mapWidthPixels,
+                              mapHeightPixels),
+      windowSize);
   QVector<double> translationMatrix = {
       1.0, 0.0, 0.0, static_cast<double>(openGlLowerLeftCorner.first),
       0.0, 1.0, 0.0, static_cast<double>(openGlLowerLeftCorner.second),
@@ -111,6 +101,80 @@ QMatrix4x4 TransformationMatrix::get(int mazeWidth, int mazeHeight,
                     m.at(12), m.at(13), m.at(14), m.at(15));
 }
 
+double TransformationMatrix::getPixelsPerTile(int mazeWidth, int mazeHeight,
+                                              int mapWidthPixels,
+                                              int mapHeightPixels) {
+  return getPixelsPerMeter(mazeWidth, mazeHeight, mapWidthPixels,
+                           mapHeightPixels) *
+         Dimensions::tileLength().getMeters();
+}
+
+QPointF TransformationMatrix::getMapPoint(int mazeWidth, int mazeHeight,
+                                          int mapWidthPixels,
+                                          int mapHeightPixels, QPointF meters) {
+  // The same as the matrix, but in pixels rather than OpenGL coordinates
+  double pixelsPerMeter = getPixelsPerMeter(mazeWidth, mazeHeight,
+                                            mapWidthPixels, mapHeightPixels);
+  double halfWallWidth = 0.5 * Dimensions::wallWidth().getMeters();
+  QPair<double, double> corner = getPixelLowerLeftCorner(
+      mazeWidth, mazeHeight, mapWidthPixels, mapHeightPixels);
+  return QPointF(
+      (corner.first + pixelsPerMeter * (meters.x() + halfWallWidth)) /
+          mapWidthPixels,
+      (corner.second + pixelsPerMeter * (meters.y() + halfWallWidth)) /
+          mapHeightPixels);
+}
+
+QPointF TransformationMatrix::getMeters(int mazeWidth, int mazeHeight,
+                                        int mapWidthPixels, int mapHeightPixels,
+                                        QPointF mapPoint) {
+  double pixelsPerMeter = getPixelsPerMeter(mazeWidth, mazeHeight,
+                                            mapWidthPixels, mapHeightPixels);
+  double halfWallWidth = 0.5 * Dimensions::wallWidth().getMeters();
+  QPair<double, double> corner = getPixelLowerLeftCorner(
+      mazeWidth, mazeHeight, mapWidthPixels, mapHeightPixels);
+  return QPointF(
+      (mapPoint.x() * mapWidthPixels - corner.first) / pixelsPerMeter -
+          halfWallWidth,
+      (mapPoint.y() * mapHeightPixels - corner.second) / pixelsPerMeter -
+          halfWallWidth);
+}
+
+double TransformationMatrix::getPixelsPerMeter(int mazeWidth, int mazeHeight,
+                                               int mapWidthPixels,
+                                               int mapHeightPixels) {
+  // Ensure that the maze width and height always appear equally scaled. Note
+  // that this is not literally the number of pixels per meter of the screen.
+  // Rather, it's our desired number of pixels per simulation meter.
+  double physicalWidth =
+      (Dimensions::wallWidth() + Dimensions::tileLength() * mazeWidth)
+          .getMeters();
+  double physicalHeight =
+      (Dimensions::wallWidth() + Dimensions::tileLength() * mazeHeight)
+          .getMeters();
+  return std::min((mapWidthPixels - 10) / physicalWidth,
+                  (mapHeightPixels - 10) / physicalHeight);
+}
+
+QPair<double, double> TransformationMatrix::getPixelLowerLeftCorner(
+    int mazeWidth, int mazeHeight, int mapWidthPixels, int mapHeightPixels) {
+  // The maze is centered within a margin of 5 pixels on each side
+  QPair<int, int> fullMapPosition = {5, 5};
+  QPair<int, int> fullMapSize = {mapWidthPixels - 10, mapHeightPixels - 10};
+  double pixelsPerMeter = getPixelsPerMeter(mazeWidth, mazeHeight,
+                                            mapWidthPixels, mapHeightPixels);
+  double pixelWidth =
+      pixelsPerMeter *
+      (Dimensions::wallWidth() + Dimensions::tileLength() * mazeWidth)
+          .getMeters();
+  double pixelHeight =
+      pixelsPerMeter *
+      (Dimensions::wallWidth() + Dimensions::tileLength() * mazeHeight)
+          .getMeters();
+  return {fullMapPosition.first + 0.5 * (fullMapSize.first - pixelWidth),
+          fullMapPosition.second + 0.5 * (fullMapSize.second - pixelHeight)};
+}
+
 QPair<double, double> TransformationMatrix::pixelToOpenGl(
     QPair<double, double> coordinate, QPair<int, int> windowSize) {
   return {2 * coordinate.first / windowSize.first - 1,
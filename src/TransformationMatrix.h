@@ -2,6 +2,7 @@
 
 #include <QMatrix4x4>
 #include <QPair>
+#include <QPointF>
 
 namespace mms {
 
@@ -14,7 +15,31 @@ class TransformationMatrix {
   static QMatrix4x4 get(int mazeWidth, int mazeHeight, int mapWidthPixels,
                         int mapHeightPixels);
 
+  // The length of a tile on the map, in pixels, for the same arguments
+  static double getPixelsPerTile(int mazeWidth, int mazeHeight,
+                                 int mapWidthPixels, int mapHeightPixels);
+
+  // Converts between a physical coordinate, in meters, and a point of the
+  // map, in units of the map from (0, 0) at its lower left to (1, 1) at its
+  // upper right (see Camera), for the same arguments
+  static QPointF getMapPoint(int mazeWidth, int mazeHeight, int mapWidthPixels,
+                             int mapHeightPixels, QPointF meters);
+  static QPointF getMeters(int mazeWidth, int mazeHeight, int mapWidthPixels,
+                           int mapHeightPixels, QPointF mapPoint);
+
  private:
+  // The number of pixels per simulation meter that fits the whole maze, plus
+  // a margin, within the map
+  static double getPixelsPerMeter(int mazeWidth, int mazeHeight,
+                                  int mapWidthPixels, int mapHeightPixels);
+
+  // The pixel coordinate of the lower left corner of the maze, which is
+  // centered within the margin of the map
+  static QPair<double, double> getPixelLowerLeftCorner(int mazeWidth,
+                                                       int mazeHeight,
+                                                       int mapWidthPixels,
+                                                       int mapHeightPixels);
+
   // Translate from a pixel coordinate to an OpenGL coordinate
   // Pixel coordinate: LL is (0, 0), UR is (width, height)
   // OpenGL coordinate: LL is (-1, -1), UR is (1, 1)
@@ -0,0 +1,156 @@
+#include "VectorEnv.h"
+
+#include <QHash>
+
+#include "AssertMacros.h"
+#include "Direction.h"
+#include "Simulation.h"
+
+namespace mms {
+
+VectorEnv::VectorEnv(const QVector<const Maze *> &mazes, int maxSteps)
+    : m_blocked(QVector<unsigned char>()),
+      m_dxs(QVector<int>(8, 0)),
+      m_dys(QVector<int>(8, 0)),
+      m_rotations(QVector<int>(5 * 8, 0)),
+      m_maxSteps(maxSteps),
+      m_offsets(QVector<int>(mazes.size(), 0)),
+      m_semiHeights(QVector<int>(mazes.size(), 0)),
+      m_centerMinXs(QVector<int>(mazes.size(), 0)),
+      m_centerMaxXs(QVector<int>(mazes.size(), 0)),
+      m_centerMinYs(QVector<int>(mazes.size(), 0)),
+      m_centerMaxYs(QVector<int>(mazes.size(), 0)),
+      m_xs(QVector<int>(mazes.size(), 0)),
+      m_ys(QVector<int>(mazes.size(), 0)),
+      m_directions(QVector<int>(mazes.size(), 0)),
+      m_steps(QVector<int>(mazes.size(), 0)),
+      m_outcomes(QVector<Outcome>(mazes.size(), Outcome::RUNNING)) {
+  ASSERT_LT(0, maxSteps);
+  for (int i = 0; i < 8; i += 1) {
+    SemiDirection direction = static_cast<SemiDirection>(i);
+    QPair<int, int> step = Simulation::getSemiStep(direction);
+    m_dxs[i] = step.first;
+    m_dys[i] = step.second;
+    QVector<SemiDirection> rotations = {
+        direction,
+        DIRECTION_ROTATE_45_RIGHT().value(direction),
+        DIRECTION_ROTATE_90_RIGHT().value(direction),
+        DIRECTION_ROTATE_45_LEFT().value(direction),
+        DIRECTION_ROTATE_90_LEFT().value(direction),
+    };
+    for (int j = 0; j < rotations.size(); j += 1) {
+      m_rotations[8 * j + i] = static_cast<int>(rotations.at(j));
+    }
+  }
+
+  // A maze's tables are only copied once, however many episodes share it;
+  // the center is every semi-position within a center tile, including the
+  // edges on its west and south sides, as in PathScorer
+  QHash<const Maze *, int> offsets;
+  for (int i = 0; i < mazes.size(); i += 1) {
+    const Maze *maze = mazes.at(i);
+    ASSERT_FA(maze == nullptr);
+    if (!offsets.contains(maze)) {
+      offsets.insert(maze, m_blocked.size());
+      QVector<unsigned char> blockedSemiDirections;
+      QVector<unsigned short> clearHalfSteps;
+      Simulation::getWallTables(maze, &blockedSemiDirections, &clearHalfSteps);
+      m_blocked.append(blockedSemiDirections);
+    }
+    m_offsets[i] = offsets.value(maze);
+    m_semiHeights[i] = 2 * maze->getHeight() + 1;
+    QVector<QPair<int, int>> centers =
+        Maze::getCenterPositions(maze->getWidth(), maze->getHeight());
+    m_centerMinXs[i] = 2 * centers.first().first;
+    m_centerMaxXs[i] = 2 * centers.first().first + 1;
+    m_centerMinYs[i] = 2 * centers.first().second;
+    m_centerMaxYs[i] = 2 * centers.first().second + 1;
+    for (const QPair<int, int> &center : centers) {
+      m_centerMinXs[i] = qMin(m_centerMinXs.at(i), 2 * center.first);
+      m_centerMaxXs[i] = qMax(m_centerMaxXs.at(i), 2 * center.first + 1);
+      m_centerMinYs[i] = qMin(m_centerMinYs.at(i), 2 * center.second);
+      m_centerMaxYs[i] = qMax(m_centerMaxYs.at(i), 2 * center.second + 1);
+    }
+    restart(i);
+  }
+}
+
+int VectorEnv::getCount() const { return m_xs.size(); }
+
+void VectorEnv::reset(const Observations &observations) {
+  for (int i = 0; i < m_xs.size(); i += 1) {
+    restart(i);
+    observe(i, observations);
+  }
+}
+
+void VectorEnv::step(const int *actions, const Observations &observations) {
+  for (int i = 0; i < m_xs.size(); i += 1) {
+    if (m_outcomes.at(i) == Outcome::RUNNING) {
+      perform(i, actions[i]);
+    } else {
+      restart(i);
+    }
+    observe(i, observations);
+  }
+}
+
+void VectorEnv::restart(int index) {
+  m_xs[index] = Simulation::INITIAL_STARTING_POSITION.x;
+  m_ys[index] = Simulation::INITIAL_STARTING_POSITION.y;
+  m_directions[index] =
+      static_cast<int>(Simulation::INITIAL_STARTING_DIRECTION);
+  m_steps[index] = 0;
+  m_outcomes[index] = Outcome::RUNNING;
+}
+
+void VectorEnv::perform(int index, int action) {
+  // Unknown actions crash, rather than being ignored, so that a policy with
+  // the wrong number of outputs can't run forever
+  int x = m_xs.at(index);
+  int y = m_ys.at(index);
+  int direction = m_directions.at(index);
+  m_steps[index] += 1;
+  if (action < 0 || 5 <= action) {
+    m_outcomes[index] = Outcome::CRASHED;
+    return;
+  }
+  if (static_cast<Action>(action) == Action::MOVE_STRAIGHT) {
+    int blocked = m_blocked.at(m_offsets.at(index) +
+                               m_semiHeights.at(index) * x + y);
+    if (blocked & (1 << direction)) {
+      m_outcomes[index] = Outcome::CRASHED;
+      return;
+    }
+    x += m_dxs.at(direction);
+    y += m_dys.at(direction);
+    m_xs[index] = x;
+    m_ys[index] = y;
+  } else {
+    m_directions[index] = m_rotations.at(8 * action + direction);
+  }
+  if (m_centerMinXs.at(index) <= x && x <= m_centerMaxXs.at(index) &&
+      m_centerMinYs.at(index) <= y && y <= m_centerMaxYs.at(index)) {
+    m_outcomes[index] = Outcome::FINISHED;
+  } else if (m_maxSteps <= m_steps.at(index)) {
+    m_outcomes[index] = Outcome::TRUNCATED;
+  }
+}
+
+void VectorEnv::observe(int index, const Observations &observations) const {
+  int x = m_xs.at(index);
+  int y = m_ys.at(index);
+  Outcome outcome = m_outcomes.at(index);
+  observations.walls[index] =
+      m_blocked.at(m_offsets.at(index) + m_semiHeights.at(index) * x + y);
+  observations.xs[index] = x;
+  observations.ys[index] = y;
+  observations.directions[index] = m_directions.at(index);
+  observations.rewards[index] = outcome == Outcome::FINISHED  ? 1.0f
+                                : outcome == Outcome::CRASHED ? -1.0f
+                                                              : 0.0f;
+  observations.outcomes[index] = static_cast<int>(outcome);
+  observations.steps[index] = m_steps.at(index);
+}
+
+}  // namespace mms
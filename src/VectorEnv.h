@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QVector>
+
+#include "Maze.h"
+
+namespace mms {
+
+// Many independent episodes of a mouse in a maze, stepped together, e.g., to
+// train an exploration policy, which needs far more steps than an algo could
+// take through the text API. Like a LockstepBatch, there are no simulations
+// or mice: an episode is an index into flat arrays of poses, and the walls of
+// every maze are copied once into a single array of masks, but the mice move
+// on the simulation's semi-positions (see Simulation::getWallTables), so that
+// they can turn by 45 degrees and drive diagonals, a half-step at a time.
+//
+// Each step performs one action of every episode. Moving into a wall is a
+// crash, which ends the episode where it stands, and reaching the center
+// (as in PathScorer) ends it too; so does reaching the maximum number of
+// steps. An episode that has ended is restarted by its next step, whose
+// action is ignored, so that the caller never has to reset episodes itself.
+class VectorEnv {
+ public:
+  // The discrete actions, as in Movement, without the diagonal moves, which
+  // are just straight moves while the mouse faces an ordinal direction
+  enum class Action {
+    MOVE_STRAIGHT,
+    TURN_RIGHT_45,
+    TURN_RIGHT_90,
+    TURN_LEFT_45,
+    TURN_LEFT_90,
+  };
+
+  // How each step left an episode; any but running ends it
+  enum class Outcome {
+    RUNNING,
+    FINISHED,
+    CRASHED,
+    TRUNCATED,
+  };
+
+  // The arrays written by each step, indexed by episode; the walls are the
+  // blocked semi-directions around the mouse, one bit per SemiDirection,
+  // and the pose is its semi-position and semi-direction
+  struct Observations {
+    int *walls;
+    int *xs;
+    int *ys;
+    int *directions;
+    float *rewards;  // one for finishing, minus one for crashing
+    int *outcomes;
+    int *steps;  // of the episode so far
+  };
+
+  // One maze per episode, none of them null, and the same maze can be given
+  // for many episodes; the mazes aren't needed once the env is constructed
+  VectorEnv(const QVector<const Maze *> &mazes, int maxSteps);
+
+  int getCount() const;
+
+  // Restarts every episode, and writes their observations
+  void reset(const Observations &observations);
+
+  // Performs one action of every episode, and writes their observations
+  void step(const int *actions, const Observations &observations);
+
+ private:
+  // The blocked semi-directions of every maze, after which each episode's
+  // maze starts, in the column-major order of the simulation's tables
+  QVector<unsigned char> m_blocked;
+
+  // The step and the rotations of each semi-direction, as plain tables, so
+  // that stepping doesn't look anything up in the maps of Direction.h
+  QVector<int> m_dxs;
+  QVector<int> m_dys;
+  QVector<int> m_rotations;  // by action, then by semi-direction
+
+  int m_maxSteps;
+
+  // Indexed by episode
+  QVector<int> m_offsets;
+  QVector<int> m_semiHeights;
+  QVector<int> m_centerMinXs;  // the semi-positions that count as the center
+  QVector<int> m_centerMaxXs;
+  QVector<int> m_centerMinYs;
+  QVector<int> m_centerMaxYs;
+  QVector<int> m_xs;
+  QVector<int> m_ys;
+  QVector<int> m_directions;
+  QVector<int> m_steps;
+  QVector<Outcome> m_outcomes;
+
+  void restart(int index);
+  void perform(int index, int action);
+  void observe(int index, const Observations &observations) const;
+};
+
+}  // namespace mms
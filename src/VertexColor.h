@@ -0,0 +1,12 @@
+#pragma once
+
+namespace mms {
+
+// The color of a vertex of a view, apart from its position, which is shared
+// with every other view of the maze (see MazeGeometry)
+struct VertexColor {
+  unsigned char paletteIndex;  // see TilePalette
+  unsigned char a;             // alpha value
+};
+
+}  // namespace mms
@@ -1,14 +1,15 @@
 #pragma once
 
-#include "RGB.h"
-
 namespace mms {
 
+// The color of a vertex is an entry of the palette (see TilePalette), which
+// the shader looks up, so that it takes up two bytes rather than four, and so
+// that changes of theme don't touch any vertices
 struct VertexGraphic {
-  float x;          // x position
-  float y;          // y position
-  RGB rgb;          // rgb values
-  unsigned char a;  // alpha value
+  float x;                     // x position
+  float y;                     // y position
+  unsigned char paletteIndex;  // see TilePalette
+  unsigned char a;             // alpha value
 };
 
 }  // namespace mms
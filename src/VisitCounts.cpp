@@ -0,0 +1,190 @@
+#include "VisitCounts.h"
+
+#include <QStringList>
+#include <QtEndian>
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+VisitCounts::VisitCounts() : VisitCounts(0, 0) {}
+
+VisitCounts::VisitCounts(int width, int height)
+    : m_width(width),
+      m_height(height),
+      m_tileVisits(width * height, 0),
+      m_edgeCrossings((2 * width + 1) * (2 * height + 1), 0),
+      m_maxTileVisits(0),
+      m_numTilesVisited(0),
+      m_lastTile(-1),
+      m_dirtyRanges(DirtyRanges()) {
+  ASSERT_LE(0, width);
+  ASSERT_LE(0, height);
+}
+
+int VisitCounts::getWidth() const { return m_width; }
+
+int VisitCounts::getHeight() const { return m_height; }
+
+void VisitCounts::addVisit(int x, int y) {
+  ASSERT_LE(0, x);
+  ASSERT_LE(0, y);
+  ASSERT_LT(x, m_width);
+  ASSERT_LT(y, m_height);
+  int tile = m_height * x + y;
+  if (tile != m_lastTile) {
+    visit(tile);
+  }
+}
+
+void VisitCounts::addHalfStep(SemiPosition from, SemiPosition to) {
+  // The midpoint of the half-step, in semi-positions, is half of the sum of
+  // its ends, and each tile spans two semi-positions, so the sum is four
+  // times the tile's coordinate, rounded down
+  int x = (from.x + to.x) / 4;
+  int y = (from.y + to.y) / 4;
+  ASSERT_LT(x, m_width);
+  ASSERT_LT(y, m_height);
+  int tile = m_height * x + y;
+  if (tile != m_lastTile) {
+    visit(tile);
+  }
+
+  // Semi-positions with one odd and one even coordinate are the midpoints
+  // of edges; the others are centers and posts
+  if ((to.x + to.y) % 2 == 1) {
+    m_edgeCrossings[(2 * m_height + 1) * to.x + to.y] += 1;
+  }
+}
+
+int VisitCounts::getTileVisits(int x, int y) const {
+  return m_tileVisits.at(m_height * x + y);
+}
+
+int VisitCounts::getEdgeCrossings(int x, int y, Direction direction) const {
+  int semiX = 2 * x + 1;
+  int semiY = 2 * y + 1;
+  switch (direction) {
+    case Direction::NORTH:
+      semiY += 1;
+      break;
+    case Direction::EAST:
+      semiX += 1;
+      break;
+    case Direction::SOUTH:
+      semiY -= 1;
+      break;
+    case Direction::WEST:
+      semiX -= 1;
+      break;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+  return m_edgeCrossings.at((2 * m_height + 1) * semiX + semiY);
+}
+
+int VisitCounts::getMaxTileVisits() const { return m_maxTileVisits; }
+
+int VisitCounts::getNumTilesVisited() const { return m_numTilesVisited; }
+
+const DirtyRanges &VisitCounts::getDirtyRanges() const {
+  return m_dirtyRanges;
+}
+
+void VisitCounts::markAllDirty() {
+  m_dirtyRanges.insert(0, m_tileVisits.size());
+}
+
+void VisitCounts::clearDirtyRanges() { m_dirtyRanges.clear(); }
+
+QString VisitCounts::toCsv() const {
+  QStringList rows = {"x,y,visits,north,east"};
+  rows.reserve(1 + m_width * m_height);
+  for (int x = 0; x < m_width; x += 1) {
+    for (int y = 0; y < m_height; y += 1) {
+      rows.append(QString("%1,%2,%3,%4,%5")
+                      .arg(x)
+                      .arg(y)
+                      .arg(getTileVisits(x, y))
+                      .arg(getEdgeCrossings(x, y, Direction::NORTH))
+                      .arg(getEdgeCrossings(x, y, Direction::EAST)));
+    }
+  }
+  return rows.join("\n") + "\n";
+}
+
+QByteArray VisitCounts::toBytes() const {
+  // The last tile, then the visits of each tile, then the crossings of each
+  // edge, in order of index; only midpoints of edges are written, since
+  // nothing else is ever crossed
+  QByteArray bytes;
+  auto append = [&bytes](quint32 value) {
+    char buffer[4];
+    qToLittleEndian<quint32>(value, buffer);
+    bytes.append(buffer, 4);
+  };
+  append(m_lastTile);
+  for (int visits : m_tileVisits) {
+    append(visits);
+  }
+  for (int i = 0; i < m_edgeCrossings.size(); i += 1) {
+    if (isMidpoint(i)) {
+      append(m_edgeCrossings.at(i));
+    }
+  }
+  return bytes;
+}
+
+bool VisitCounts::fromBytes(const QByteArray &bytes) {
+  int numMidpoints = 0;
+  for (int i = 0; i < m_edgeCrossings.size(); i += 1) {
+    if (isMidpoint(i)) {
+      numMidpoints += 1;
+    }
+  }
+  if (bytes.size() != 4 * (1 + m_tileVisits.size() + numMidpoints)) {
+    return false;
+  }
+  const char *data = bytes.constData();
+  qint32 lastTile = qFromLittleEndian<qint32>(data);
+  if (lastTile < -1 || m_tileVisits.size() <= lastTile) {
+    return false;
+  }
+  m_lastTile = lastTile;
+  m_maxTileVisits = 0;
+  m_numTilesVisited = 0;
+  int position = 4;
+  for (int i = 0; i < m_tileVisits.size(); i += 1) {
+    m_tileVisits[i] = qFromLittleEndian<quint32>(data + position);
+    m_maxTileVisits = qMax(m_maxTileVisits, m_tileVisits.at(i));
+    if (0 < m_tileVisits.at(i)) {
+      m_numTilesVisited += 1;
+    }
+    position += 4;
+  }
+  for (int i = 0; i < m_edgeCrossings.size(); i += 1) {
+    if (isMidpoint(i)) {
+      m_edgeCrossings[i] = qFromLittleEndian<quint32>(data + position);
+      position += 4;
+    }
+  }
+  markAllDirty();
+  return true;
+}
+
+bool VisitCounts::isMidpoint(int edgeIndex) const {
+  int semiHeight = 2 * m_height + 1;
+  return (edgeIndex / semiHeight + edgeIndex % semiHeight) % 2 == 1;
+}
+
+void VisitCounts::visit(int tile) {
+  if (m_tileVisits.at(tile) == 0) {
+    m_numTilesVisited += 1;
+  }
+  m_tileVisits[tile] += 1;
+  m_maxTileVisits = qMax(m_maxTileVisits, m_tileVisits.at(tile));
+  m_lastTile = tile;
+  m_dirtyRanges.insert(tile, 1);
+}
+
+}  // namespace mms
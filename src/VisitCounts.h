@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "Direction.h"
+#include "DirtyRanges.h"
+#include "Mouse.h"
+
+namespace mms {
+
+// How often the mouse entered each tile, and crossed each edge between two
+// tiles, over a run, e.g., to tell how efficiently an algo searches. Counts
+// are added as the mouse arrives at the end of each movement, for every
+// half-step along it, so a long move counts every tile that it passes.
+class VisitCounts {
+ public:
+  VisitCounts();
+  VisitCounts(int width, int height);
+
+  int getWidth() const;
+  int getHeight() const;
+
+  // Records the mouse being placed in a tile, e.g., at the start of a run,
+  // which counts as a visit unless it's already there
+  void addVisit(int x, int y);
+
+  // Records a half-step between adjacent semi-positions (see SemiPosition).
+  // Each half-step lies within a single tile, which is visited if the
+  // previous one lay within some other tile, and an edge is crossed if the
+  // half-step ends at its midpoint.
+  void addHalfStep(SemiPosition from, SemiPosition to);
+
+  int getTileVisits(int x, int y) const;
+  int getEdgeCrossings(int x, int y, Direction direction) const;
+  int getMaxTileVisits() const;
+  int getNumTilesVisited() const;
+
+  // The tiles, by index (x * height + y), whose visits changed since the
+  // ranges were last cleared, e.g., once they're uploaded (see MapRenderer)
+  const DirtyRanges &getDirtyRanges() const;
+  void markAllDirty();
+  void clearDirtyRanges();
+
+  // A row for each tile, column by column, after the header row:
+  // "x,y,visits,north,east", where north and east are the crossings of those
+  // edges; the west and south edges are those of the neighboring tiles
+  QString toCsv() const;
+
+  // Every count, compactly, e.g., for a checkpoint (see SimulationCheckpoint).
+  // Returns false, leaving the counts unchanged, if the bytes aren't the
+  // counts of a maze of the same size; otherwise every tile is marked dirty.
+  QByteArray toBytes() const;
+  bool fromBytes(const QByteArray &bytes);
+
+ private:
+  int m_width;
+  int m_height;
+  QVector<int> m_tileVisits;  // by tile index
+
+  // By the index of the edge's midpoint among the semi-positions, i.e.,
+  // (2 * height + 1) * x + y, so that only midpoints are ever used
+  QVector<int> m_edgeCrossings;
+
+  int m_maxTileVisits;
+  int m_numTilesVisited;
+  int m_lastTile;  // the tile that the mouse was last in, or -1
+  DirtyRanges m_dirtyRanges;
+
+  void visit(int tile);
+  bool isMidpoint(int edgeIndex) const;
+};
+
+}  // namespace mms
@@ -0,0 +1,138 @@
+#include "WallAccuracy.h"
+
+#include "AssertMacros.h"
+
+namespace mms {
+
+WallAccuracy::WallAccuracy()
+    : m_maze(nullptr),
+      m_semiHeight(0),
+      m_isDeclared(QVector<bool>()),
+      m_numCorrect(0),
+      m_numWrong(0),
+      m_numUndiscovered(0) {}
+
+WallAccuracy::WallAccuracy(const Maze *maze)
+    : m_maze(maze),
+      m_semiHeight(2 * maze->getHeight() + 1),
+      m_isDeclared((2 * maze->getWidth() + 1) * m_semiHeight, false),
+      m_numCorrect(0),
+      m_numWrong(0),
+      m_numUndiscovered(0) {
+  recount();
+}
+
+void WallAccuracy::declare(int x, int y, Direction direction, bool isWall) {
+  ASSERT_FA(m_maze == nullptr);
+  int index = getIndex(x, y, direction);
+  if (m_isDeclared.at(index) == isWall) {
+    return;
+  }
+  m_isDeclared[index] = isWall;
+  int change = isWall ? 1 : -1;
+  if (m_maze->isWall(x, y, direction)) {
+    m_numCorrect += change;
+    m_numUndiscovered -= change;
+  } else {
+    m_numWrong += change;
+  }
+}
+
+void WallAccuracy::recount() {
+  m_numCorrect = 0;
+  m_numWrong = 0;
+  m_numUndiscovered = 0;
+  if (m_maze == nullptr) {
+    return;
+  }
+
+  // The north and east walls of every tile, and the south and west walls of
+  // the tiles on the border, cover every wall exactly once
+  int width = m_maze->getWidth();
+  int height = m_maze->getHeight();
+  for (int x = 0; x < width; x += 1) {
+    for (int y = 0; y < height; y += 1) {
+      for (Direction direction : {Direction::NORTH, Direction::EAST,
+                                  Direction::SOUTH, Direction::WEST}) {
+        if ((direction == Direction::SOUTH && 0 < y) ||
+            (direction == Direction::WEST && 0 < x)) {
+          continue;
+        }
+        bool isWall = m_maze->isWall(x, y, direction);
+        if (m_isDeclared.at(getIndex(x, y, direction))) {
+          if (isWall) {
+            m_numCorrect += 1;
+          } else {
+            m_numWrong += 1;
+          }
+        } else if (isWall) {
+          m_numUndiscovered += 1;
+        }
+      }
+    }
+  }
+}
+
+int WallAccuracy::getNumCorrect() const { return m_numCorrect; }
+
+int WallAccuracy::getNumWrong() const { return m_numWrong; }
+
+int WallAccuracy::getNumUndiscovered() const { return m_numUndiscovered; }
+
+QByteArray WallAccuracy::toBytes() const {
+  QVector<int> midpoints = getMidpoints();
+  QByteArray bytes((midpoints.size() + 7) / 8, 0);
+  for (int i = 0; i < midpoints.size(); i += 1) {
+    if (m_isDeclared.at(midpoints.at(i))) {
+      bytes[i / 8] = bytes.at(i / 8) | (1 << (i % 8));
+    }
+  }
+  return bytes;
+}
+
+bool WallAccuracy::fromBytes(const QByteArray &bytes) {
+  QVector<int> midpoints = getMidpoints();
+  if (bytes.size() != (midpoints.size() + 7) / 8) {
+    return false;
+  }
+  for (int i = 0; i < midpoints.size(); i += 1) {
+    m_isDeclared[midpoints.at(i)] = (bytes.at(i / 8) >> (i % 8)) & 1;
+  }
+  recount();
+  return true;
+}
+
+int WallAccuracy::getIndex(int x, int y, Direction direction) const {
+  int semiX = 2 * x + 1;
+  int semiY = 2 * y + 1;
+  switch (direction) {
+    case Direction::NORTH:
+      semiY += 1;
+      break;
+    case Direction::EAST:
+      semiX += 1;
+      break;
+    case Direction::SOUTH:
+      semiY -= 1;
+      break;
+    case Direction::WEST:
+      semiX -= 1;
+      break;
+    default:
+      ASSERT_NEVER_RUNS();
+  }
+  return m_semiHeight * semiX + semiY;
+}
+
+QVector<int> WallAccuracy::getMidpoints() const {
+  // Semi-positions with one odd and one even coordinate, see SemiPosition
+  QVector<int> midpoints;
+  for (int i = 0; i < m_isDeclared.size(); i += 1) {
+    if ((i / m_semiHeight + i % m_semiHeight) % 2 == 1) {
+      midpoints.append(i);
+    }
+  }
+  return midpoints;
+}
+
+}  // namespace mms
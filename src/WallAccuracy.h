@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+#include "Direction.h"
+#include "Maze.h"
+
+namespace mms {
+
+// How well the walls that an algo declared (via setWall and clearWall) match
+// the walls of the maze. Each wall is shared by the tiles on either side of
+// it, so it's tracked once, by the index of its midpoint among the
+// semi-positions, and every declaration only adjusts the counts by the
+// difference that it makes, so they never need a diff of the whole maze.
+class WallAccuracy {
+ public:
+  WallAccuracy();
+  explicit WallAccuracy(const Maze *maze);
+
+  // Declares whether there's a wall on the given side of the tile, which has
+  // no effect if it was already declared that way
+  void declare(int x, int y, Direction direction, bool isWall);
+
+  // Must be called whenever the walls of the maze change, e.g., by an editor;
+  // the declarations are kept, but the cost is linear in the size of the maze
+  void recount();
+
+  // Declared walls that are, and aren't, walls of the maze, and walls of the
+  // maze that haven't been declared
+  int getNumCorrect() const;
+  int getNumWrong() const;
+  int getNumUndiscovered() const;
+
+  // The declarations, a bit for each wall, e.g., for a checkpoint (see
+  // SimulationCheckpoint). Returns false, leaving them unchanged, if the
+  // bytes aren't the declarations of a maze of the same size.
+  QByteArray toBytes() const;
+  bool fromBytes(const QByteArray &bytes);
+
+ private:
+  const Maze *m_maze;
+  int m_semiHeight;
+  QVector<bool> m_isDeclared;  // by semi-position index, see getIndex
+  int m_numCorrect;
+  int m_numWrong;
+  int m_numUndiscovered;
+
+  int getIndex(int x, int y, Direction direction) const;
+  QVector<int> getMidpoints() const;
+};
+
+}  // namespace mms
@@ -0,0 +1,113 @@
+#include "Watchpoints.h"
+
+#include <QStringList>
+
+namespace mms {
+
+Watchpoints::Watchpoints() : m_hasStats(false), m_lastX(0), m_lastY(0) {}
+
+bool Watchpoints::fromSpec(const QString &spec, Watchpoints *watchpoints,
+                           QString *error) {
+  Watchpoints parsed;
+  parsed.m_spec = spec;
+  for (const QString &text : spec.split(',', Qt::SkipEmptyParts)) {
+    QStringList parts = text.split(':');
+    Watchpoint watchpoint = {Kind::WRONG_WALL, text, 0, 0,
+                             StatsEnum::TOTAL_DISTANCE, 0.0, false};
+    bool ok = false;
+    if (parts.first() == "tile" && parts.size() == 3) {
+      bool yOk = false;
+      watchpoint.kind = Kind::TILE;
+      watchpoint.x = parts.at(1).toInt(&ok);
+      watchpoint.y = parts.at(2).toInt(&yOk);
+      ok = ok && yOk && 0 <= watchpoint.x && 0 <= watchpoint.y;
+    } else if ((parts.first() == "moves" || parts.first() == "commands") &&
+               parts.size() == 2) {
+      watchpoint.kind =
+          parts.first() == "moves" ? Kind::MOVES : Kind::COMMANDS;
+      watchpoint.x = parts.at(1).toInt(&ok);
+      ok = ok && 0 < watchpoint.x;
+    } else if (parts.first() == "stat" && parts.size() == 2) {
+      QString comparison = parts.at(1);
+      int index = qMax(comparison.indexOf('>'), comparison.indexOf('<'));
+      if (0 < index) {
+        watchpoint.kind = comparison.at(index) == '>' ? Kind::STAT_ABOVE
+                                                      : Kind::STAT_BELOW;
+        watchpoint.value = comparison.mid(index + 1).toDouble(&ok);
+        ok = ok && STRING_TO_STAT().contains(comparison.left(index));
+        watchpoint.stat = STRING_TO_STAT().value(comparison.left(index));
+        parsed.m_hasStats = true;
+      }
+    } else if (parts.first() == "wrong-wall" && parts.size() == 1) {
+      ok = true;
+    }
+    if (!ok) {
+      *error = QString("Invalid watchpoint: \"%1\"").arg(text);
+      return false;
+    }
+    parsed.m_watchpoints.append(watchpoint);
+  }
+  *watchpoints = parsed;
+  return true;
+}
+
+QString Watchpoints::getSpec() const { return m_spec; }
+
+bool Watchpoints::isEmpty() const { return m_watchpoints.isEmpty(); }
+
+QString Watchpoints::onMovementCompleted(int numMovements, int x, int y) {
+  // A tile is only entered by a movement that ends on it from elsewhere, so
+  // turning in place doesn't hit its watchpoint again
+  QString hit = check(Kind::MOVES, numMovements, 0);
+  bool isEntered = numMovements == 1 || x != m_lastX || y != m_lastY;
+  m_lastX = x;
+  m_lastY = y;
+  if (hit.isNull() && isEntered) {
+    hit = check(Kind::TILE, x, y);
+  }
+  return hit;
+}
+
+QString Watchpoints::onCommandArrived(int numCommands) {
+  return check(Kind::COMMANDS, numCommands, 0);
+}
+
+QString Watchpoints::onStatsChanged(const Stats *stats) {
+  // The state is only computed if it's needed, since it includes the score
+  if (!m_hasStats) {
+    return QString();
+  }
+  Stats::State state = stats->getState();
+  for (Watchpoint &watchpoint : m_watchpoints) {
+    if (watchpoint.isDone || (watchpoint.kind != Kind::STAT_ABOVE &&
+                              watchpoint.kind != Kind::STAT_BELOW)) {
+      continue;
+    }
+    double value = state.values[static_cast<int>(watchpoint.stat)];
+    if (watchpoint.kind == Kind::STAT_ABOVE ? watchpoint.value < value
+                                            : value < watchpoint.value) {
+      watchpoint.isDone = true;
+      return watchpoint.text;
+    }
+  }
+  return QString();
+}
+
+QString Watchpoints::onWallDeclared(bool isWrong) {
+  return isWrong ? check(Kind::WRONG_WALL, 0, 0) : QString();
+}
+
+QString Watchpoints::check(Kind kind, int x, int y) {
+  // Counts only ever go up, so their watchpoints can only fire once, while
+  // tiles and wrong walls fire every time
+  for (Watchpoint &watchpoint : m_watchpoints) {
+    if (watchpoint.kind == kind && !watchpoint.isDone &&
+        watchpoint.x == x && watchpoint.y == y) {
+      watchpoint.isDone = kind == Kind::MOVES || kind == Kind::COMMANDS;
+      return watchpoint.text;
+    }
+  }
+  return QString();
+}
+
+}  // namespace mms
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include "Stats.h"
+
+namespace mms {
+
+// Points of a run at which to pause it, so that it can run at full speed up
+// to the moment of interest, e.g., when debugging an algo that goes wrong
+// after thousands of moves. The watchpoints are a comma-separated list, like
+// a schedule of resets (see ResetInjection):
+//
+//   tile:X:Y         whenever a movement ends on the tile, coming from
+//                    another one
+//   moves:N          once the Nth movement ends
+//   commands:N       once the Nth command arrives
+//   stat:NAME>VALUE  once the stat (see getStat) is above the value, or
+//   stat:NAME<VALUE  below it
+//   wrong-wall       whenever the algo declares a wall that the maze
+//                    doesn't have
+//
+// The list is parsed once, into a flat list of predicates, and each of the
+// simulation's checks only looks at the predicates of its own kind, so that
+// watching costs next to nothing, and nothing at all if the list is empty.
+class Watchpoints {
+ public:
+  // Never hit
+  Watchpoints();
+
+  // Returns false if the list can't be parsed
+  static bool fromSpec(const QString &spec, Watchpoints *watchpoints,
+                       QString *error);
+  QString getSpec() const;
+  bool isEmpty() const;
+
+  // Each check returns the watchpoint that was hit, as written in the list,
+  // or a null string; watchpoints that fire once are then done
+  QString onMovementCompleted(int numMovements, int x, int y);
+  QString onCommandArrived(int numCommands);
+  QString onStatsChanged(const Stats *stats);
+  QString onWallDeclared(bool isWrong);
+
+ private:
+  enum class Kind {
+    TILE,
+    MOVES,
+    COMMANDS,
+    STAT_ABOVE,
+    STAT_BELOW,
+    WRONG_WALL,
+  };
+
+  struct Watchpoint {
+    Kind kind;
+    QString text;
+    int x;  // or the count, for moves and commands
+    int y;
+    StatsEnum stat;
+    double value;
+    bool isDone;
+  };
+
+  QString m_spec;
+  QVector<Watchpoint> m_watchpoints;
+  bool m_hasStats;  // whether onStatsChanged needs to look at anything
+  int m_lastX;      // the tile of the last movement, if any
+  int m_lastY;
+
+  QString check(Kind kind, int x, int y);
+};
+
+}  // namespace mms
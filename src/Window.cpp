@@ -1,8 +1,8 @@
 #include <QAction>
 #include <QDebug>
 #include <QDoubleSpinBox>
+#include <QFile>
 #include <QFileDialog>
-#include <QFileInfo>
 #include <QFrame>
 #include <QGroupBox>
 #include <QHBoxLayout>
@@ -10,12 +10,15 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QPixmap>
-#include <QRegularExpression>
+#include <QSaveFile>
 #include <QShortcut>
 #include <QSplitter>
+#include <QStandardItemModel>
 #include <QTabWidget>
-#include <QTimer>
+#include <QFutureWatcher>
 #include <QVBoxLayout>
+#include <QWindow>
+#include <QtConcurrent>
 #include <QtMath>
 
 #include "AssertMacros.h"
@@ -23,13 +26,13 @@
 #include "ColorDialog.h"
 #include "ColorManager.h"
 #include "ConfigDialog.h"
-#include "Dimensions.h"
-#include "FontImage.h"
+#include "MazeSolver.h"
 #include "ProcessUtilities.h"
+#include "Profiler.h"
+#include "ResultsView.h"
 #include "SettingsMazeFiles.h"
 #include "SettingsMisc.h"
 #include "SettingsMouseAlgos.h"
-#include "SimUtilities.h"
 #include "Window.h"
 
 namespace mms {
@@ -44,29 +47,39 @@ const QString Window::FAILED_STYLE_SHEET =
     "QLabel { background: rgb(255, 150, 150); }";
 const QString Window::ERROR_STYLE_SHEET =
     "QLabel { background: rgb(230, 150, 230); }";
+const QString Window::INVALID_EDIT_STYLE_SHEET =
+    "QLineEdit { background: rgb(255, 150, 150); }";
 
-const QString Window::ACK = "ack";
-const QString Window::CRASH = "crash";
-const QString Window::INVALID = "invalid";
+const int Window::USAGE_INTERVAL_MILLISECONDS = 500;
+
+const int Window::MAZE_RELOAD_DELAY_MILLISECONDS = 100;
+
+const int Window::MAX_RIVALS = 7;
+const QVector<Color> Window::RIVAL_COLORS = {
+    Color::RED,  Color::GREEN, Color::ORANGE, Color::YELLOW,
+    Color::CYAN, Color::WHITE, Color::GRAY,
+};
 
 const int Window::SPEED_SLIDER_MAX = 99;
 const int Window::SPEED_SLIDER_DEFAULT = 33;
-const double Window::MIN_PROGRESS_PER_SECOND = 10.0;
-const double Window::MAX_PROGRESS_PER_SECOND = 5000.0;
-const double Window::MAX_SLEEP_SECONDS = 0.008;
-
-const SemiPosition Window::INITIAL_STARTING_POSITION = {1, 1};
-const SemiDirection Window::INITIAL_STARTING_DIRECTION = SemiDirection::NORTH;
 
 Window::Window(QWidget *parent)
     : QMainWindow(parent),
       m_map(new Map()),
+      m_splitViewCheckBox(new QCheckBox("Split")),
+      m_gridViewCheckBox(new QCheckBox("Grid")),
 
       // Maze
       m_maze(nullptr),
-      m_truth(nullptr),
       m_currentMazeFile(QString()),
       m_mazeFileComboBox(new QComboBox()),
+      m_mazeFileCache(new MazeFileCache(this)),
+      m_mazeFileWatcher(new QFileSystemWatcher(this)),
+      m_mazeReloadTimer(new QTimer(this)),
+      m_editCheckBox(new QCheckBox("Edit")),
+      m_saveMazeButton(new QToolButton()),
+      m_truth(nullptr),
+      m_geometry(),
 
       // Algo config
       m_mouseAlgoComboBox(new QComboBox()),
@@ -76,6 +89,9 @@ Window::Window(QWidget *parent)
       m_mouseAlgoOutputTabWidget(new QTabWidget()),
       m_buildOutput(new QPlainTextEdit()),
       m_runOutput(new QPlainTextEdit()),
+      m_buildLog(new LogPane(m_buildOutput, this)),
+      m_runLog(new LogPane(m_runOutput, this)),
+      m_metricsPlot(new MetricsPlot()),
 
       // Algo build
       m_buildButton(new QPushButton("Build")),
@@ -84,43 +100,77 @@ Window::Window(QWidget *parent)
 
       // Algo run
       m_runButton(new QPushButton("Run")),
-      m_runProcess(nullptr),
+      m_runChannel(nullptr),
       m_runStatus(new QLabel()),
-      m_mouse(nullptr),
+      m_usageTimer(new QTimer(this)),
+      m_cpuTimeBox(new QLineEdit()),
+      m_peakMemoryBox(new QLineEdit()),
+      m_simulation(nullptr),
       m_view(nullptr),
       m_mouseGraphic(nullptr),
 
+      // Rivals
+      m_rivalsButton(new QToolButton()),
+      m_rivalsMenu(new QMenu(this)),
+      m_rivalsLayout(new QGridLayout()),
+      m_rivals(QVector<Rival *>()),
+
+      // Replay
+      m_replayLog(nullptr),
+      m_replayPlayer(nullptr),
+      m_replayTimeline(nullptr),
+      m_isReplaying(false),
+      m_replayButton(new QPushButton("Replay")),
+      m_saveReplayButton(new QPushButton("Save Replay")),
+      m_replaySlider(new QSlider(Qt::Horizontal)),
+
       // Pause/reset
       m_isPaused(false),
-      m_wasReset(false),
       m_pauseButton(new QPushButton("Pause")),
       m_resetButton(new QPushButton("Reset")),
+      m_watchpointsEdit(new QLineEdit()),
+      m_watchpoints(Watchpoints()),
 
       // Communication
-      m_logBuffer(QStringList()),
-      m_commandBuffer(QStringList()),
-      m_commandQueue(QQueue<QString>()),
-      m_commandQueueTimer(new QTimer()),
+      m_logBuffer(LineBuffer()),
 
       // Movement
-      m_startingPosition(INITIAL_STARTING_POSITION),
-      m_startingDirection(INITIAL_STARTING_DIRECTION),
-      m_movement(Movement::NONE),
-      m_doomedToCrash(false),
-      m_halfStepsToMoveForward(0),
-      m_movementProgress(0.0),
-      m_movementStepSize(0.0),
       m_speedSlider(new QSlider(Qt::Horizontal)),
+      m_instantCheckBox(new QCheckBox("Instant")),
+      m_lockstepCheckBox(new QCheckBox("Lockstep")),
+      m_maxVisibleCheckBox(new QCheckBox("Max Visible")),
+      m_isWatched(true) {
+  PROFILE_SCOPE("Window::Window");
 
-      // Helpers
-      m_tilesWithColor(QSet<QPair<int, int>>()),
-      m_tilesWithText(QSet<QPair<int, int>>()) {
   // Keyboard shortcuts for closing the window
   QShortcut *ctrl_q = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_Q), this);
   QShortcut *ctrl_w = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_W), this);
   connect(ctrl_q, &QShortcut::activated, this, &QMainWindow::close);
   connect(ctrl_w, &QShortcut::activated, this, &QMainWindow::close);
 
+  // Keyboard shortcut for the frame timing overlay
+  QShortcut *f3 = new QShortcut(QKeySequence(Qt::Key_F3), this);
+  connect(f3, &QShortcut::activated, this, [=]() {
+    m_map->setFrameOverlayShown(!m_map->isFrameOverlayShown());
+  });
+
+  // Keyboard shortcut for keeping the map centered on the mouse
+  QShortcut *f4 = new QShortcut(QKeySequence(Qt::Key_F4), this);
+  connect(f4, &QShortcut::activated, this,
+          [=]() { m_map->setFollowingMouse(!m_map->isFollowingMouse()); });
+
+  // Keyboard shortcut for the heatmap of the tiles that the mouse visited
+  QShortcut *f5 = new QShortcut(QKeySequence(Qt::Key_F5), this);
+  connect(f5, &QShortcut::activated, this,
+          [=]() { m_map->setHeatmapShown(!m_map->isHeatmapShown()); });
+
+  // Keyboard shortcut for rendering the map at a lower resolution when
+  // frames run over their budget
+  QShortcut *f6 = new QShortcut(QKeySequence(Qt::Key_F6), this);
+  connect(f6, &QShortcut::activated, this, [=]() {
+    m_map->setRenderScaleAdaptive(!m_map->isRenderScaleAdaptive());
+  });
+
   // Add the map and panel to the window
   QVBoxLayout *panelLayout = new QVBoxLayout();
   panelLayout->setContentsMargins(0, 6, 6, 6);
@@ -162,6 +212,20 @@ Window::Window(QWidget *parent)
     label->setMinimumWidth(90);
   }
 
+  // Add the replay buttons and timeline, saving is only possible once
+  // there's a log, and seeking once there's a replay
+  m_saveReplayButton->setEnabled(false);
+  m_replaySlider->setEnabled(false);
+  controlsLayout->addWidget(m_replayButton, 2, 0);
+  controlsLayout->addWidget(m_saveReplayButton, 2, 1);
+  controlsLayout->addWidget(m_replaySlider, 2, 2, 1, 2);
+  connect(m_replaySlider, &QSlider::sliderReleased, this,
+          &Window::onReplaySliderReleased);
+  connect(m_replayButton, &QPushButton::clicked, this,
+          &Window::onReplayButtonPressed);
+  connect(m_saveReplayButton, &QPushButton::clicked, this,
+          &Window::onSaveReplayButtonPressed);
+
   // Add mouse algo pause and reset buttons
   m_pauseButton->setEnabled(false);
   m_resetButton->setEnabled(false);
@@ -181,9 +245,33 @@ Window::Window(QWidget *parent)
   speedLayout->addWidget(turtle);
   speedLayout->addWidget(m_speedSlider);
   speedLayout->addWidget(rabbit);
+  speedLayout->addWidget(m_instantCheckBox);
+  speedLayout->addWidget(m_lockstepCheckBox);
+  speedLayout->addWidget(m_maxVisibleCheckBox);
+  speedLayout->addWidget(m_splitViewCheckBox);
+  speedLayout->addWidget(m_gridViewCheckBox);
+  speedLayout->addWidget(m_editCheckBox);
   controlsLayout->addLayout(speedLayout, 1, 2, 1, 2);
   m_speedSlider->setRange(0, SPEED_SLIDER_MAX);
   m_speedSlider->setValue(SPEED_SLIDER_DEFAULT);
+  connect(m_speedSlider, &QSlider::valueChanged, this,
+          &Window::onSpeedSliderChanged);
+  connect(m_instantCheckBox, &QCheckBox::toggled, this,
+          &Window::onInstantCheckBoxChanged);
+  connect(m_lockstepCheckBox, &QCheckBox::toggled, this,
+          &Window::onLockstepCheckBoxChanged);
+  m_maxVisibleCheckBox->setToolTip("Move once per frame, as fast as shown");
+  connect(m_maxVisibleCheckBox, &QCheckBox::toggled, this,
+          &Window::onMaxVisibleCheckBoxChanged);
+  m_splitViewCheckBox->setToolTip("Draw the truth beside the mouse's view");
+  connect(m_splitViewCheckBox, &QCheckBox::toggled, this,
+          &Window::refreshMapViews);
+  m_gridViewCheckBox->setToolTip("Draw the rivals' views beside the mouse's");
+  connect(m_gridViewCheckBox, &QCheckBox::toggled, this,
+          &Window::refreshMapViews);
+  m_editCheckBox->setToolTip("Click the map to toggle walls");
+  connect(m_editCheckBox, &QCheckBox::toggled, m_map, &Map::setEditing);
+  connect(m_map, &Map::wallClicked, this, &Window::onWallClicked);
 
   // Add config box labels
   QLabel *mazeLabel = new QLabel("Maze");
@@ -199,6 +287,23 @@ Window::Window(QWidget *parent)
   configLayout->addWidget(m_mazeFileComboBox, 0, 1, 1, 2);
   connect(m_mazeFileComboBox, &QComboBox::textActivated, this,
           &Window::onMazeFileComboBoxChanged);
+  connect(m_mazeFileCache, &MazeFileCache::validated, this,
+          &Window::onMazeFileValidated);
+  m_mazeReloadTimer->setSingleShot(true);
+  m_mazeReloadTimer->setInterval(MAZE_RELOAD_DELAY_MILLISECONDS);
+  connect(m_mazeReloadTimer, &QTimer::timeout, this, &Window::reloadMazeFile);
+  connect(m_mazeFileWatcher, &QFileSystemWatcher::fileChanged, this,
+          [=](const QString &path) {
+            if (path == m_currentMazeFile) {
+              m_mazeReloadTimer->start();
+            }
+          });
+
+  // Add maze file save button, e.g., for edited mazes
+  m_saveMazeButton->setText("Save");
+  configLayout->addWidget(m_saveMazeButton, 0, 5, 1, 1);
+  connect(m_saveMazeButton, &QToolButton::clicked, this,
+          &Window::onSaveMazeButtonPressed);
 
   // Add color dialog button
   QToolButton *colorButton = new QToolButton();
@@ -233,6 +338,39 @@ Window::Window(QWidget *parent)
   connect(mouseAlgoImportButton, &QPushButton::clicked, this,
           &Window::onMouseAlgoImportButtonPressed);
 
+  // Add the rivals menu, which lists the mouse algos to run alongside
+  QLabel *rivalsLabel = new QLabel("Rivals");
+  configLayout->addWidget(rivalsLabel, 2, 0, 1, 1);
+  rivalsLabel->setSizePolicy(policy);
+  m_rivalsButton->setMenu(m_rivalsMenu);
+  m_rivalsButton->setPopupMode(QToolButton::InstantPopup);
+  m_rivalsButton->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+  configLayout->addWidget(m_rivalsButton, 2, 1, 1, 2);
+  connect(m_rivalsMenu, &QMenu::triggered, this,
+          &Window::onRivalsMenuTriggered);
+
+  // Add the watchpoints, which are checked as they're typed
+  QLabel *watchpointsLabel = new QLabel("Watch");
+  configLayout->addWidget(watchpointsLabel, 3, 0, 1, 1);
+  watchpointsLabel->setSizePolicy(policy);
+  m_watchpointsEdit->setPlaceholderText("e.g., tile:7:8,moves:8000");
+  m_watchpointsEdit->setToolTip(
+      "Pause at any of these: tile:X:Y, moves:N, commands:N, "
+      "stat:NAME>VALUE, stat:NAME<VALUE, wrong-wall");
+  configLayout->addWidget(m_watchpointsEdit, 3, 1, 1, 2);
+  connect(m_watchpointsEdit, &QLineEdit::textChanged, this,
+          &Window::onWatchpointsEdited);
+
+  // Add the rivals header, each rival adds a row once it's started
+  QWidget *rivalsWidget = new QWidget();
+  rivalsWidget->setLayout(m_rivalsLayout);
+  m_rivalsLayout->setAlignment(Qt::AlignTop);
+  QStringList rivalsHeader = {"Algo",        "Status",         "Total Distance",
+                              "Total Turns", "Best Run Turns", "Score"};
+  for (int i = 0; i < rivalsHeader.size(); i += 1) {
+    m_rivalsLayout->addWidget(new QLabel(rivalsHeader.at(i)), 0, i + 1);
+  }
+
   // Add stats labels
   stats = new Stats();
   createStat("Total Distance", StatsEnum::TOTAL_DISTANCE, 0, 0, 0, 1,
@@ -254,12 +392,30 @@ Window::Window(QWidget *parent)
   createStat("Best Run Turns", StatsEnum::BEST_RUN_TURNS, 5, 0, 5, 1,
              statsLayout);
   createStat("Score", StatsEnum::SCORE, 6, 0, 6, 1, statsLayout);
+  createStat("Current Run Time", StatsEnum::CURRENT_RUN_TIME, 3, 2, 3, 3,
+             statsLayout);
+  createStat("Best Run Time", StatsEnum::BEST_RUN_TIME, 4, 2, 4, 3,
+             statsLayout);
+  createStat("Total Time", StatsEnum::TOTAL_TIME, 5, 2, 5, 3, statsLayout);
+
+  // Add the algo process's usage, which isn't part of the stats
+  statsLayout->addWidget(new QLabel("Algo CPU Time"), 6, 2);
+  m_cpuTimeBox->setReadOnly(true);
+  statsLayout->addWidget(m_cpuTimeBox, 6, 3);
+  statsLayout->addWidget(new QLabel("Algo Peak Memory"), 7, 0);
+  m_peakMemoryBox->setReadOnly(true);
+  statsLayout->addWidget(m_peakMemoryBox, 7, 1);
+  m_usageTimer->setInterval(USAGE_INTERVAL_MILLISECONDS);
+  connect(m_usageTimer, &QTimer::timeout, this, &Window::updateUsage);
 
   // Add the build and run outputs to the panel
   panelLayout->addWidget(m_mouseAlgoOutputTabWidget);
   m_mouseAlgoOutputTabWidget->addTab(m_buildOutput, "Build Output");
   m_mouseAlgoOutputTabWidget->addTab(m_runOutput, "Run Output");
   m_mouseAlgoOutputTabWidget->addTab(statsWidget, "Stats");
+  m_mouseAlgoOutputTabWidget->addTab(m_metricsPlot, "Metrics");
+  m_mouseAlgoOutputTabWidget->addTab(rivalsWidget, "Rivals");
+  m_mouseAlgoOutputTabWidget->addTab(new ResultsView(), "Results");
   for (QPlainTextEdit *output : {m_buildOutput, m_runOutput}) {
     output->setReadOnly(true);
     output->setLineWrapMode(QPlainTextEdit::NoWrap);
@@ -274,45 +430,47 @@ Window::Window(QWidget *parent)
   resize(windowWidth, windowHeight);
   splitter->setSizes({windowHeight, windowWidth - windowHeight});
 
-  // Remove maze files that no longer exist
-  for (const auto &path : SettingsMazeFiles::getAllPaths()) {
-    if (path.isEmpty() || !QFileInfo::exists(path)) {
-      SettingsMazeFiles::removePath(path);
-    }
-  }
+  // The recently used maze, the maze files, and the mouse algos are loaded
+  // once the window is shown, so that it's shown as soon as possible; until
+  // then, there's no maze to run or replay on
+  m_buildButton->setEnabled(false);
+  m_runButton->setEnabled(false);
+  m_replayButton->setEnabled(false);
+  QTimer::singleShot(0, this, &Window::loadRecent);
+}
 
-  // Load the recently used maze
+void Window::loadRecent() {
+  // The maze is parsed on another thread, and the maze files are validated
+  // on others still (see MazeFileCache)
   QString path = SettingsMisc::getRecentMazeFile();
-  Maze *maze = Maze::fromFile(path);
-  if (maze == nullptr) {
-    path = ":/resources/mazes/blank.num";
-    maze = Maze::fromFile(path);
-  }
-  refreshMazeFileComboBox(path);
-  updateMazeAndPath(maze, path);
-
-  // Add the mouse algos
-  refreshMouseAlgoComboBox(SettingsMisc::getRecentMouseAlgo());
-
-  // Configure command queue timer
-  m_commandQueueTimer->setSingleShot(true);
-  connect(m_commandQueueTimer, &QTimer::timeout, this,
-          &Window::processQueuedCommands);
-
-  // Start the graphics loop
-  double secondsPerFrame = 1.0 / 60;
-  QTimer *mapTimer = new QTimer();
-  connect(mapTimer, &QTimer::timeout, this, [=]() {
-    // Hack to prevent file dialog from locking up...
-    static double then = SimUtilities::getHighResTimestamp();
-    double now = SimUtilities::getHighResTimestamp();
-    if (now - then < secondsPerFrame) {
-      return;
+  QFutureWatcher<Maze *> *watcher = new QFutureWatcher<Maze *>(this);
+  connect(watcher, &QFutureWatcher<Maze *>::finished, this, [=]() {
+    PROFILE_SCOPE("Window::loadRecent");
+    watcher->deleteLater();
+    Maze *maze = watcher->result();
+
+    // Unless another maze was opened in the meantime
+    if (m_maze != nullptr) {
+      delete maze;
+    } else {
+      QString loaded = path;
+      if (maze == nullptr) {
+        loaded = ":/resources/mazes/blank.num";
+        maze = Maze::fromFile(loaded);
+      }
+      refreshMazeFileComboBox(loaded);
+      updateMazeAndPath(maze, loaded);
     }
-    m_map->update();
-    then = now;
+    refreshMouseAlgoComboBox(SettingsMisc::getRecentMouseAlgo());
+    m_replayButton->setEnabled(true);
   });
-  mapTimer->start(secondsPerFrame * 1000);
+  watcher->setFuture(QtConcurrent::run([=]() {
+    PROFILE_SCOPE("Maze::fromFile");
+    return Maze::fromFile(path);
+  }));
+
+  // Shown right away, validated in the background
+  refreshMazeFileComboBox(path);
 }
 
 void Window::resizeEvent(QResizeEvent *event) {
@@ -326,6 +484,36 @@ void Window::closeEvent(QCloseEvent *event) {
   QMainWindow::closeEvent(event);
 }
 
+void Window::changeEvent(QEvent *event) {
+  QMainWindow::changeEvent(event);
+  if (event->type() == QEvent::WindowStateChange) {
+    refreshWatched();
+  }
+}
+
+void Window::showEvent(QShowEvent *event) {
+  // The native window only exists once shown, and only it is told whether
+  // it's exposed; filtering the same object twice has no effect
+  QMainWindow::showEvent(event);
+  if (windowHandle() != nullptr) {
+    windowHandle()->installEventFilter(this);
+  }
+  refreshWatched();
+}
+
+void Window::hideEvent(QHideEvent *event) {
+  QMainWindow::hideEvent(event);
+  refreshWatched();
+}
+
+bool Window::eventFilter(QObject *object, QEvent *event) {
+  if (event->type() == QEvent::Expose) {
+    // Handled after the window, which updates whether it's exposed
+    QTimer::singleShot(0, this, &Window::refreshWatched);
+  }
+  return QMainWindow::eventFilter(object, event);
+}
+
 void Window::onMazeFileButtonPressed() {
   QString path = QFileDialog::getOpenFileName(this, tr("Load Maze"));
   if (path.isNull()) {
@@ -352,6 +540,53 @@ void Window::onMazeFileComboBoxChanged(QString path) {
   stats->resetAll();
 }
 
+void Window::onWallClicked(int x, int y, Direction direction) {
+  // The maze must stay enclosed, and clearing a wall sets both of its sides,
+  // so it stays consistent without validating the whole maze
+  if (m_maze == nullptr ||
+      (direction == Direction::NORTH && y + 1 == m_maze->getHeight()) ||
+      (direction == Direction::EAST && x + 1 == m_maze->getWidth()) ||
+      (direction == Direction::SOUTH && y == 0) ||
+      (direction == Direction::WEST && x == 0)) {
+    return;
+  }
+  setTruthWall(x, y, direction, !m_maze->isWall(x, y, direction));
+}
+
+void Window::onSaveMazeButtonPressed() {
+  if (m_maze == nullptr) {
+    return;
+  }
+  // The format is chosen by the extension, and is binary by default
+  QString path = QFileDialog::getSaveFileName(
+      this, tr("Save Maze"),
+      m_currentMazeFile.startsWith(":") ? QString() : m_currentMazeFile,
+      tr("Map files (*.map);;Num files (*.num);;Binary files (*)"));
+  if (path.isNull()) {
+    return;
+  }
+  QByteArray bytes;
+  if (path.endsWith(".map", Qt::CaseInsensitive)) {
+    bytes = m_maze->toMapFile();
+  } else if (path.endsWith(".num", Qt::CaseInsensitive)) {
+    bytes = m_maze->toNumFile();
+  } else {
+    bytes = m_maze->toBinary();
+  }
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() ||
+      !file.commit()) {
+    QMessageBox::warning(this, "Could Not Save Maze",
+                         QString("Could not write \"%1\".").arg(path));
+    return;
+  }
+  SettingsMazeFiles::addPath(path);
+  m_currentMazeFile = path;
+  SettingsMisc::setRecentMazeFile(path);
+  refreshMazeFileComboBox(path);
+  watchMazeFile(path);
+}
+
 void Window::onColorButtonPressed() {
   ColorDialog dialog(
       CHAR_TO_COLOR().key(ColorManager::get()->getTileBaseColor()),
@@ -375,13 +610,9 @@ void Window::onColorButtonPressed() {
       CHAR_TO_COLOR().value(dialog.getTileWallIsSetColor()),
       dialog.getTileWallNotSetAlpha());
 
-  // Redraw the "truth" view with the new colors
-  m_truth->getMazeGraphic()->refreshColors();
-
-  // Redraw the mouse's view with the new colors
-  if (m_view != nullptr) {
-    m_view->getMazeGraphic()->refreshColors();
-  }
+  // The views refer to the theme by palette entry, so they're redrawn with
+  // the new colors as they are, but the mice are rewritten
+  m_map->refreshMouseGraphics();
 }
 
 void Window::showInvalidMazeFileWarning(QString path) {
@@ -393,65 +624,245 @@ void Window::showInvalidMazeFileWarning(QString path) {
 }
 
 void Window::refreshMazeFileComboBox(QString selected) {
-  m_mazeFileComboBox->clear();
+  // Add all of the items at once, rather than one insertion at a time
+  QStringList paths;
   for (const auto &info : QDir(":/resources/mazes/").entryInfoList()) {
-    m_mazeFileComboBox->addItem(info.absoluteFilePath());
-  }
-  for (const auto &path : SettingsMazeFiles::getAllPaths()) {
-    m_mazeFileComboBox->addItem(path);
+    paths.append(info.absoluteFilePath());
   }
+  paths.append(SettingsMazeFiles::getAllPaths());
+  m_mazeFileComboBox->clear();
+  m_mazeFileComboBox->addItems(paths);
   m_mazeFileComboBox->setCurrentText(selected);
+
+  // Show what's known about each file now, and revalidate them all in the
+  // background, since they may have changed since they were last validated
+  for (int i = 0; i < paths.size(); i += 1) {
+    MazeFileCache::Info info;
+    if (m_mazeFileCache->get(paths.at(i), &info)) {
+      showMazeFileInfo(i, info);
+    }
+    m_mazeFileCache->validate(paths.at(i));
+  }
+}
+
+void Window::onMazeFileValidated(QString path,
+                                 const MazeFileCache::Info &info) {
+  int index = m_mazeFileComboBox->findText(path);
+  if (index == -1) {
+    return;
+  }
+  if (!info.exists && path != m_currentMazeFile) {
+    SettingsMazeFiles::removePath(path);
+    m_mazeFileComboBox->removeItem(index);
+    return;
+  }
+  showMazeFileInfo(index, info);
+}
+
+void Window::showMazeFileInfo(int index, const MazeFileCache::Info &info) {
+  // Invalid files can't be selected, and valid ones show their dimensions
+  QStandardItemModel *model =
+      qobject_cast<QStandardItemModel *>(m_mazeFileComboBox->model());
+  if (model != nullptr) {
+    model->item(index)->setEnabled(info.isValid);
+  }
+  if (info.isValid) {
+    m_mazeFileComboBox->setItemIcon(index,
+                                    QPixmap::fromImage(info.thumbnail));
+    m_mazeFileComboBox->setItemData(
+        index, QString("%1 x %2").arg(info.width).arg(info.height),
+        Qt::ToolTipRole);
+  } else {
+    m_mazeFileComboBox->setItemIcon(index, QIcon());
+    m_mazeFileComboBox->setItemData(index, "Invalid maze file",
+                                    Qt::ToolTipRole);
+  }
 }
 
 void Window::updateMazeAndPath(Maze *maze, QString path) {
   updateMaze(maze);
   m_currentMazeFile = path;
   SettingsMisc::setRecentMazeFile(path);
+  watchMazeFile(path);
+}
+
+void Window::watchMazeFile(const QString &path) {
+  m_mazeReloadTimer->stop();
+  QStringList watched = m_mazeFileWatcher->files();
+  if (!watched.isEmpty()) {
+    m_mazeFileWatcher->removePaths(watched);
+  }
+
+  // Resources, and entries of corpora, can't change
+  if (!path.startsWith(":") && QFile::exists(path)) {
+    m_mazeFileWatcher->addPath(path);
+  }
+}
+
+void Window::reloadMazeFile() {
+  // Editors that save by replacing the file leave it unwatched, and may
+  // leave it briefly invalid, in which case the next save reloads it
+  watchMazeFile(m_currentMazeFile);
+  Maze *loaded = Maze::fromFile(m_currentMazeFile);
+  if (loaded == nullptr) {
+    return;
+  }
+  if (loaded->getWidth() != m_maze->getWidth() ||
+      loaded->getHeight() != m_maze->getHeight()) {
+    updateMaze(loaded);
+    return;
+  }
+
+  // Each interior wall is compared once, from the tile south or west of it,
+  // and the walls on the border are always set
+  bool isChanged = false;
+  for (int x = 0; x < loaded->getWidth(); x += 1) {
+    for (int y = 0; y < loaded->getHeight(); y += 1) {
+      for (Direction direction : {Direction::NORTH, Direction::EAST}) {
+        bool isWall = loaded->isWall(x, y, direction);
+        if (isWall != m_maze->isWall(x, y, direction)) {
+          applyTruthWall(x, y, direction, isWall);
+          isChanged = true;
+        }
+      }
+    }
+  }
+  delete loaded;
+  if (isChanged) {
+    if (m_simulation != nullptr) {
+      m_simulation->refreshWalls();
+    }
+    refreshTruthPath();
+    m_map->markFrameDirty();
+  }
 }
 
 void Window::updateMaze(Maze *maze) {
   // Stop running maze/mouse algos
   cancelAllProcesses();
 
-  // Next, update the maze and truth
+  // The mouse's view is only valid for the maze that it was made for
+  delete m_view;
+  m_view = nullptr;
+
+  // Next, update the maze, and drop the truth until it's displayed, once
+  // control returns to the event loop, unless a run has started by then
   Maze *oldMaze = m_maze;
   MazeView *oldTruth = m_truth;
   m_maze = maze;
-  m_truth = new MazeView(m_maze, true);
+  m_truth = nullptr;
+  m_geometry = QSharedPointer<MazeGeometry>::create();
+  m_truthPathTiles.clear();
+  m_map->setMaze(m_maze);
+  QTimer::singleShot(0, this, &Window::showTruth);
 
+  // Delete the old objects
+  delete oldMaze;
+  delete oldTruth;
+}
+
+MazeView *Window::getTruth() {
+  if (m_truth != nullptr) {
+    return m_truth;
+  }
   // The truth has walls declared and distance as text
-  MazeGraphic *mazeGraphic = m_truth->getMazeGraphic();
+  m_truth = new MazeView(m_maze, true, m_geometry);
   for (int x = 0; x < m_maze->getWidth(); x += 1) {
     for (int y = 0; y < m_maze->getHeight(); y += 1) {
-      const Tile *tile = m_maze->getTile(x, y);
-      for (Direction d : CARDINAL_DIRECTIONS()) {
-        if (tile->isWall(d)) {
-          mazeGraphic->setWall(x, y, d);
-        }
-      }
-      int distance = tile->getDistance();
-      QString text = 0 <= distance ? QString::number(distance) : "inf";
-      mazeGraphic->setText(x, y, text);
+      refreshTruthWalls(x, y);
+      refreshTruthDistance(x, y);
     }
   }
+  refreshTruthPath();
+  return m_truth;
+}
 
-  // Update pointers held by other objects
-  m_map->setMaze(m_maze);
-  m_map->setView(m_truth);
+void Window::showTruth() {
+  // No-op if the mouse's view is displayed instead
+  if (m_maze == nullptr || m_simulation != nullptr) {
+    return;
+  }
+  m_map->setView(getTruth());
+}
 
-  // Delete the old objects
-  delete oldMaze;
-  delete oldTruth;
+void Window::setTruthWall(int x, int y, Direction direction, bool isWall) {
+  applyTruthWall(x, y, direction, isWall);
+  if (m_simulation != nullptr) {
+    m_simulation->refreshWalls();
+  }
+  refreshTruthPath();
+  m_map->markFrameDirty();
+}
+
+void Window::applyTruthWall(int x, int y, Direction direction,
+                            bool isWall) {
+  QVector<QPair<int, int>> changed = m_maze->setWall(x, y, direction, isWall);
+  if (m_truth == nullptr) {
+    return;
+  }
+
+  // The wall is drawn by both of the tiles that share it
+  refreshTruthWalls(x, y);
+  if (direction == Direction::NORTH && y + 1 < m_maze->getHeight()) {
+    refreshTruthWalls(x, y + 1);
+  }
+  if (direction == Direction::EAST && x + 1 < m_maze->getWidth()) {
+    refreshTruthWalls(x + 1, y);
+  }
+  if (direction == Direction::SOUTH && 0 < y) {
+    refreshTruthWalls(x, y - 1);
+  }
+  if (direction == Direction::WEST && 0 < x) {
+    refreshTruthWalls(x - 1, y);
+  }
+  for (const QPair<int, int> &tile : changed) {
+    refreshTruthDistance(tile.first, tile.second);
+  }
+}
+
+void Window::refreshTruthWalls(int x, int y) {
+  MazeGraphic *mazeGraphic = m_truth->getMazeGraphic();
+  for (Direction d : CARDINAL_DIRECTIONS()) {
+    if (m_maze->isWall(x, y, d)) {
+      mazeGraphic->setWall(x, y, d);
+    } else {
+      mazeGraphic->clearWall(x, y, d);
+    }
+  }
+}
+
+void Window::refreshTruthDistance(int x, int y) {
+  int distance = m_maze->getDistance(x, y);
+  QString text = 0 <= distance ? QString::number(distance) : "inf";
+  m_truth->getMazeGraphic()->setText(x, y, text);
+}
+
+void Window::refreshTruthPath() {
+  if (m_truth == nullptr) {
+    return;
+  }
+  MazeGraphic *mazeGraphic = m_truth->getMazeGraphic();
+  for (const QPair<int, int> &tile : m_truthPathTiles) {
+    mazeGraphic->clearColor(tile.first, tile.second);
+  }
+  m_truthPathTiles.clear();
+  for (SemiPosition semiPos : MazeSolver::solve(m_maze).path) {
+    QPair<int, int> tile = semiPos.toMazeLocation();
+    if (m_truthPathTiles.isEmpty() || m_truthPathTiles.last() != tile) {
+      m_truthPathTiles.append(tile);
+      mazeGraphic->setColor(tile.first, tile.second, Color::DARK_GREEN);
+    }
+  }
 }
 
 void Window::onMouseAlgoComboBoxChanged(QString name) {
   cancelAllProcesses();
   m_buildStatus->setText("");
   m_buildStatus->setStyleSheet("");
-  m_buildOutput->clear();
+  m_buildLog->clear();
   m_runStatus->setText("");
   m_runStatus->setStyleSheet("");
-  m_runOutput->clear();
+  m_runLog->clear();
   stats->resetAll();
   SettingsMisc::setRecentMouseAlgo(name);
 }
@@ -504,15 +915,14 @@ void Window::onMouseAlgoImportButtonPressed() {
 
 void Window::refreshMouseAlgoComboBox(QString selected) {
   m_mouseAlgoComboBox->clear();
-  for (const auto &name : SettingsMouseAlgos::names()) {
-    m_mouseAlgoComboBox->addItem(name);
-  }
+  m_mouseAlgoComboBox->addItems(SettingsMouseAlgos::names());
   m_mouseAlgoComboBox->setCurrentText(selected);
   bool isNonempty = m_mouseAlgoComboBox->count();
   m_mouseAlgoComboBox->setEnabled(isNonempty);
   m_mouseAlgoEditButton->setEnabled(isNonempty);
   m_buildButton->setEnabled(isNonempty);
   m_runButton->setEnabled(isNonempty);
+  refreshRivalsMenu();
 }
 
 void Window::cancelProcess(QProcess *process, QLabel *status) {
@@ -562,14 +972,14 @@ void Window::startBuild() {
     if (output.endsWith("\n")) {
       output.truncate(output.size() - 1);
     }
-    m_buildOutput->appendPlainText(output);
+    m_buildLog->appendLine(output);
   });
   connect(process, &QProcess::readyReadStandardError, this, [=]() {
     QString output = process->readAllStandardError();
     if (output.endsWith("\n")) {
       output.truncate(output.size() - 1);
     }
-    m_buildOutput->appendPlainText(output);
+    m_buildLog->appendLine(output);
   });
 
   // Clean up on exit
@@ -579,7 +989,7 @@ void Window::startBuild() {
           this, &Window::onBuildExit);
 
   // Clear the ouput and bring it to the front
-  m_buildOutput->clear();
+  m_buildLog->clear();
   m_mouseAlgoOutputTabWidget->setCurrentWidget(m_buildOutput);
 
   // Start the build process
@@ -597,7 +1007,7 @@ void Window::startBuild() {
     m_buildStatus->setStyleSheet(IN_PROGRESS_STYLE_SHEET);
   } else {
     // Clean up the failed process
-    m_buildOutput->appendPlainText(process->errorString());
+    m_buildLog->appendLine(process->errorString());
     m_buildStatus->setText("ERROR");
     m_buildStatus->setStyleSheet(ERROR_STYLE_SHEET);
     delete process;
@@ -628,7 +1038,7 @@ void Window::onBuildExit(int exitCode, QProcess::ExitStatus exitStatus) {
 
 void Window::startRun() {
   // Only one algo running at a time
-  ASSERT_TR(m_runProcess == nullptr);
+  ASSERT_TR(m_runChannel == nullptr);
 
   // Extract the relevant config
   QString name = m_mouseAlgoComboBox->currentText();
@@ -648,52 +1058,79 @@ void Window::startRun() {
   }
   ASSERT_FA(m_maze == nullptr);
 
-  // Remove the old mouse, add a new mouse
-  removeMouseFromMaze();
-  m_mouse = new Mouse();
-  m_view = new MazeView(m_maze, false);
-  m_mouseGraphic = new MouseGraphic(m_mouse);
-  m_map->setView(m_view);
-  m_map->setMouseGraphic(m_mouseGraphic);
+  // Instantiate a new channel, which runs the process on its own thread
+  AlgoChannel *channel = new AlgoChannel();
 
-  // Instantiate a new process
-  QProcess *process = new QProcess();
+  // Remove the old mouse, add a new mouse, and record everything it does
+  removeMouseFromMaze();
+  delete m_replayLog;
+  m_replayLog = new ReplayLog(m_maze);
+  addMouseToMaze(channel);
+  m_simulation->setReplayLog(m_replayLog);
+  m_saveReplayButton->setEnabled(true);
 
   // Print stderr
-  connect(process, &QProcess::readyReadStandardError, this, [=]() {
-    QString output = process->readAllStandardError();
-    QStringList logs = processText(output, &m_logBuffer);
-    for (QString log : logs) {
-      m_runOutput->appendPlainText(log);
-    }
-  });
-
-  // Process commands from stdout
-  connect(process, &QProcess::readyReadStandardOutput, this, [=]() {
-    QString output = process->readAllStandardOutput();
-    QStringList commands = processText(output, &m_commandBuffer);
-    for (QString command : commands) {
-      dispatchCommand(command);
-    }
-  });
+  connect(channel, &AlgoChannel::standardErrorRead, this,
+          [=](const QByteArray &bytes) {
+            m_logBuffer.append(bytes);
+            QByteArrayView log;
+            while (m_logBuffer.nextLine(&log)) {
+              m_runLog->appendLine(QString::fromUtf8(log));
+            }
+          });
+
+  // Process the commands that the channel parsed from stdout. Batches (and
+  // the exit) can still be in flight once the run is over, so ignore them.
+  connect(channel, &AlgoChannel::commandsParsed, this,
+          [=](const QVector<Command> &commands, CommandParser::Status status) {
+            if (m_runChannel != channel) {
+              return;
+            }
+            // A handshake behind queued commands is accepted later
+            if (m_simulation->processCommands(commands, status)) {
+              channel->resolveHandshake(true);
+            }
+            channel->allowCommands(commands.size(),
+                                   m_simulation->getCommandQueueRoom());
+          });
 
   // Clean up on exit
-  connect(process,
-          static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
-              &QProcess::finished),
-          this, &Window::onRunExit);
+  connect(channel, &AlgoChannel::finished, this,
+          [=](int exitCode, QProcess::ExitStatus exitStatus) {
+            if (m_runChannel == channel) {
+              onRunExit(exitCode, exitStatus);
+            }
+          });
 
   // Clear the ouput and bring it to the front
-  m_runOutput->clear();
+  m_runLog->clear();
   m_mouseAlgoOutputTabWidget->setCurrentWidget(m_runOutput);
 
   // reset score
   stats->resetAll();
 
-  // Start the run process
-  if (ProcessUtilities::start(runCommand, directory, process)) {
-    // Save a pointer to the process
-    m_runProcess = process;
+  // Only as many commands are handed over as the simulation has room for
+  Simulation *simulation = m_simulation;
+  connect(simulation, &Simulation::readyForCommands, channel, [=]() {
+    channel->allowCommands(0, simulation->getCommandQueueRoom());
+  });
+  connect(simulation, &Simulation::handshakeAccepted, channel,
+          [=]() { channel->resolveHandshake(true); });
+
+  // Start the run process, whose output is only processed once control
+  // returns to the event loop
+  if (channel->start(runCommand, directory)) {
+    // Save a pointer to the channel
+    m_runChannel = channel;
+    channel->allowCommands(0, simulation->getCommandQueueRoom());
+
+    // Sample the algo's usage from the start, scripts have none
+    m_cpuTimeBox->clear();
+    m_peakMemoryBox->clear();
+    if (0 < channel->getProcessId()) {
+      updateUsage();
+      m_usageTimer->start();
+    }
 
     // Update the run button
     disconnect(m_runButton, &QPushButton::clicked, this, &Window::startRun);
@@ -707,22 +1144,35 @@ void Window::startRun() {
     // Only enabled while mouse is running
     m_pauseButton->setEnabled(true);
     m_resetButton->setEnabled(true);
+
+    // The rivals start at the same time, in the same maze
+    startRivals();
   } else {
     // Clean up the failed process
-    m_runOutput->appendPlainText(process->errorString());
+    m_runLog->appendLine(channel->errorString());
     m_runStatus->setText("ERROR");
     m_runStatus->setStyleSheet(ERROR_STYLE_SHEET);
     removeMouseFromMaze();
-    delete process;
+    delete channel;
   }
 }
 
 void Window::cancelRun() {
-  cancelProcess(m_runProcess, m_runStatus);
+  if (m_runChannel != nullptr) {
+    m_runChannel->kill();
+    m_runStatus->setText("CANCELED");
+    m_runStatus->setStyleSheet(CANCELED_STYLE_SHEET);
+  }
+  if (m_isReplaying) {
+    finishReplay("CANCELED", CANCELED_STYLE_SHEET);
+  }
   removeMouseFromMaze();
 }
 
 void Window::onRunExit(int exitCode, QProcess::ExitStatus exitStatus) {
+  // Stop consuming queued commands, the mouse remains in the maze
+  m_simulation->stop();
+
   // Always unpause on exit
   if (m_isPaused) {
     onPauseButtonPressed();
@@ -732,7 +1182,6 @@ void Window::onRunExit(int exitCode, QProcess::ExitStatus exitStatus) {
   m_pauseButton->setEnabled(false);
   m_resetButton->setEnabled(false);
   m_resetButton->setText("Reset");
-  m_wasReset = false;
 
   // Update the run button
   disconnect(m_runButton, &QPushButton::clicked, this, &Window::cancelRun);
@@ -748,949 +1197,611 @@ void Window::onRunExit(int exitCode, QProcess::ExitStatus exitStatus) {
     m_runStatus->setStyleSheet(FAILED_STYLE_SHEET);
   }
 
-  // Clean up (stop producing commands)
-  delete m_runProcess;
-  m_runProcess = nullptr;
+  // Clean up (stop producing commands); this may be called from within the
+  // channel's kill, so it can't be deleted until control returns
+  m_usageTimer->stop();
+  m_runChannel->deleteLater();
+  m_runChannel = nullptr;
+}
+
+void Window::updateUsage() {
+  // By the time the exit is seen, the process is gone and can't be sampled
+  ProcessUtilities::Usage usage;
+  if (m_runChannel == nullptr ||
+      !ProcessUtilities::getUsage(m_runChannel->getProcessId(), &usage)) {
+    return;
+  }
+  m_cpuTimeBox->setText(QString("%1 s user, %2 s system")
+                            .arg(usage.userSeconds, 0, 'f', 2)
+                            .arg(usage.systemSeconds, 0, 'f', 2));
+  m_peakMemoryBox->setText(
+      QString("%1 MiB").arg(usage.peakResidentBytes / 1048576.0, 0, 'f', 1));
+}
 
-  // Stop consuming queued commands
-  m_commandQueueTimer->stop();
-  m_commandQueue.clear();
+void Window::addMouseToMaze(QIODevice *output) {
+  ASSERT_TR(m_simulation == nullptr);
+  if (m_view == nullptr) {
+    m_view = new MazeView(m_maze, false, m_geometry);
+  } else {
+    m_view->reset();
+  }
+  m_simulation =
+      new Simulation(m_maze, m_view->getMazeGraphic(), stats, output);
+  m_metricsPlot->setMetrics(m_simulation->getAlgoMetrics());
+  m_simulation->setProgressPerSecond(getProgressPerSecond());
+  m_simulation->setInstant(isInstant());
+  m_simulation->setLockstep(m_lockstepCheckBox->isChecked());
+  m_simulation->setFramePaced(m_maxVisibleCheckBox->isChecked());
+  m_simulation->setTimeBudget(
+      SettingsMisc::getCommandTimeBudgetMicroseconds() / 1e6);
+  connect(m_simulation, &Simulation::resetAcknowledged, this,
+          &Window::onResetAcknowledged);
+  m_simulation->setWatchpoints(m_watchpoints);
+  connect(m_simulation, &Simulation::watchpointHit, this,
+          &Window::onWatchpointHit);
+
+  // Only one maze is run at a time, so an algo that asks for another one is
+  // told that there are none, and is expected to exit
+  Simulation *simulation = m_simulation;
+  connect(
+      simulation, &Simulation::nextMazeRequested, simulation,
+      [=]() { simulation->answerNextMaze(false); }, Qt::QueuedConnection);
+  connect(m_simulation, &Simulation::mouseMoved, m_map, &Map::markFrameDirty);
+  connect(m_map, &Map::frameSwapped, m_simulation, &Simulation::onFrameShown);
+  connect(m_simulation, &Simulation::viewChanged, m_map, &Map::markFrameDirty);
+  m_mouseGraphic = new MouseGraphic(m_simulation->getMouse());
+  m_map->setVisitCounts(m_simulation->getVisitCounts());
+  refreshMapViews();
+  refreshMapMouseGraphics();
 }
 
 void Window::removeMouseFromMaze() {
   // No-op if no mouse
-  if (m_mouse == nullptr) {
+  if (m_simulation == nullptr) {
     return;
   }
 
   // Update some objects
-  m_map->setView(m_truth);
-  m_map->setMouseGraphic(nullptr);
-
-  // Delete some objects
+  m_map->setOtherViews({});
+  m_map->setView(getTruth());
+  m_map->setMouseGraphics({});
+  m_map->setVisitCounts(nullptr);
+
+  // The player may be emitting a signal, so defer deletion
+  delete m_replayTimeline;
+  m_replayTimeline = nullptr;
+  if (m_replayPlayer != nullptr) {
+    m_replayPlayer->stop();
+    m_replayPlayer->deleteLater();
+    m_replayPlayer = nullptr;
+  }
+  m_replaySlider->setEnabled(false);
+  m_replaySlider->setValue(0);
+
+  // The rivals are removed along with the mouse, once the map is done with
+  // their views
+  removeRivalsFromMaze();
+
+  // Delete some objects, but keep the view for the next run
   ASSERT_FA(m_view == nullptr);
   ASSERT_FA(m_mouseGraphic == nullptr);
-  delete m_mouse;
-  m_mouse = nullptr;
-  delete m_view;
-  m_view = nullptr;
   delete m_mouseGraphic;
   m_mouseGraphic = nullptr;
+  m_metricsPlot->setMetrics(nullptr);
+  delete m_simulation;
+  m_simulation = nullptr;
 
   // Reset communication state
   m_logBuffer.clear();
-  m_commandBuffer.clear();
-
-  // Reset movement state
-  m_startingPosition = INITIAL_STARTING_POSITION;
-  m_startingDirection = INITIAL_STARTING_DIRECTION;
-  m_movement = Movement::NONE;
-  m_movementProgress = 0.0;
-  m_movementStepSize = 0.0;
-
-  // Reset other mouse state
-  m_tilesWithColor.clear();
-  m_tilesWithText.clear();
 }
 
-void Window::onPauseButtonPressed() {
-  m_isPaused = !m_isPaused;
-  if (m_isPaused) {
-    m_pauseButton->setText("Resume");
-    m_runStatus->setText("PAUSED");
-  } else {
-    m_pauseButton->setText("Pause");
-    m_runStatus->setText("RUNNING");
-    processQueuedCommands();
+void Window::refreshMapMouseGraphics() {
+  // The mouse algo's mouse is drawn last, i.e., on top
+  QVector<const MouseGraphic *> mouseGraphics;
+  for (Rival *rival : m_rivals) {
+    if (rival->mouseGraphic != nullptr) {
+      mouseGraphics.append(rival->mouseGraphic);
+    }
+  }
+  if (m_mouseGraphic != nullptr) {
+    mouseGraphics.append(m_mouseGraphic);
   }
+  m_map->setMouseGraphics(mouseGraphics);
 }
 
-void Window::onResetButtonPressed() {
-  m_resetButton->setEnabled(false);
-  m_resetButton->setText("Waiting");
-  m_wasReset = true;
+void Window::refreshMapViews() {
+  // The views share their geometry, so each cell of the grid only costs its
+  // colors, text, and path
+  if (m_simulation == nullptr) {
+    return;
+  }
+  QVector<MazeView *> others;
+  if (m_splitViewCheckBox->isChecked()) {
+    others.append(getTruth());
+  }
+  if (m_gridViewCheckBox->isChecked()) {
+    for (Rival *rival : m_rivals) {
+      if (rival->view != nullptr) {
+        others.append(rival->view);
+      }
+    }
+  }
+  m_map->setOtherViews({});
+  m_map->setView(m_view);
+  m_map->setOtherViews(others);
 }
 
-QStringList Window::processText(QString text, QStringList *buffer) {
-  QStringList lines;
-
-  // Separate the text by line
-  text.replace("\r", "");  // Windows compatibility
-  QStringList parts = text.split("\n");
-
-  // If the text has at least one newline character, we definitely have a
-  // complete line; combine it with the contents of the buffer and append
-  // it to the list of lines to be returned
-  if (1 < parts.size()) {
-    lines.append(buffer->join("") + parts.at(0));
-    buffer->clear();
+void Window::refreshRivalsMenu() {
+  // Rivals stay selected for as long as they're still mouse algos
+  QStringList selected = getRivalNames();
+  m_rivalsMenu->clear();
+  for (const QString &name : SettingsMouseAlgos::names()) {
+    QAction *action = m_rivalsMenu->addAction(name);
+    action->setCheckable(true);
+    action->setChecked(selected.contains(name));
   }
+  onRivalsMenuTriggered();
+}
 
-  // All newline-separated parts in the text are lines
-  for (int i = 1; i < parts.size() - 1; i += 1) {
-    lines.append(parts.at(i));
+void Window::onRivalsMenuTriggered() {
+  // Only so many mice can be told apart
+  QStringList names = getRivalNames();
+  bool isFull = MAX_RIVALS <= names.size();
+  for (QAction *action : m_rivalsMenu->actions()) {
+    action->setEnabled(action->isChecked() || !isFull);
   }
+  m_rivalsButton->setText(names.isEmpty() ? "None" : names.join(", "));
+  m_rivalsButton->setEnabled(!m_rivalsMenu->isEmpty());
+}
 
-  // Store the last part of the text (empty string if the text ended
-  // with newline) in the buffer, to be combined with future input
-  buffer->append(parts.at(parts.size() - 1));
+QStringList Window::getRivalNames() const {
+  QStringList names;
+  for (QAction *action : m_rivalsMenu->actions()) {
+    if (action->isChecked()) {
+      names.append(action->text());
+    }
+  }
+  return names;
+}
 
-  return lines;
+void Window::startRivals() {
+  // The rows of the previous rivals are kept until now, so that their results
+  // can still be read once they're removed from the maze
+  for (Rival *rival : m_rivals) {
+    ASSERT_TR(rival->channel == nullptr);
+    ASSERT_TR(rival->simulation == nullptr);
+    ASSERT_TR(rival->view == nullptr);
+    delete rival->stats;
+    qDeleteAll(rival->widgets);
+    delete rival;
+  }
+  m_rivals.clear();
+
+  QStringList names = getRivalNames();
+  ASSERT_LE(names.size(), MAX_RIVALS);
+  for (int i = 0; i < names.size(); i += 1) {
+    startRival(names.at(i), RIVAL_COLORS.at(i), i + 1);
+  }
+  refreshMapViews();
+  refreshMapMouseGraphics();
 }
 
-void Window::dispatchCommand(QString command) {
-  // For performance reasons, handle no-response commands inline (don't queue
-  // them with the commands that elicit a response, just perform the action)
-  if (command.startsWith("setWall") || command.startsWith("clearWall")) {
-    QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 4) {
-      return;
-    }
-    if (!(tokens.at(0) == "setWall" || tokens.at(0) == "clearWall")) {
-      return;
-    }
-    bool ok = true;
-    int x = tokens.at(1).toInt(&ok);
-    int y = tokens.at(2).toInt(&ok);
-    if (!ok) {
-      return;
-    }
-    if (tokens.at(3).size() != 1) {
-      return;
-    }
-    QChar direction = tokens.at(3).at(0);
-    if (!CHAR_TO_DIRECTION().contains(direction)) {
-      return;
-    }
-    if (command.startsWith("setWall")) {
-      setWall(x, y, direction);
-    } else if (command.startsWith("clearWall")) {
-      clearWall(x, y, direction);
-    } else {
-      ASSERT_NEVER_RUNS();
-    }
-  } else if (command.startsWith("setColor")) {
-    QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 4) {
-      return;
-    }
-    if (tokens.at(0) != "setColor") {
-      return;
-    }
-    bool ok = true;
-    int x = tokens.at(1).toInt(&ok);
-    int y = tokens.at(2).toInt(&ok);
-    if (!ok) {
-      return;
-    }
-    if (tokens.at(3).size() != 1) {
-      return;
-    }
-    QChar color = tokens.at(3).at(0);
-    if (!CHAR_TO_COLOR().contains(color)) {
-      return;
-    }
-    setColor(x, y, color);
-  } else if (command.startsWith("clearColor")) {
-    QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 3) {
-      return;
-    }
-    if (tokens.at(0) != "clearColor") {
-      return;
-    }
-    bool ok = true;
-    int x = tokens.at(1).toInt(&ok);
-    int y = tokens.at(2).toInt(&ok);
-    if (!ok) {
-      return;
-    }
-    clearColor(x, y);
-  } else if (command.startsWith("clearAllColor")) {
-    QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 1) {
-      return;
-    }
-    if (tokens.at(0) != "clearAllColor") {
-      return;
-    }
-    clearAllColor();
-  } else if (command.startsWith("setText")) {
-    // Special parsing to allow space characters in the text
-    int firstSpace = command.indexOf(" ");
-    int secondSpace = command.indexOf(" ", firstSpace + 1);
-    int thirdSpace = command.indexOf(" ", secondSpace + 1);
-    QString function = command.left(firstSpace);
-    if (function != "setText") {
-      return;
-    }
-    QString xString = command.mid(firstSpace + 1, secondSpace - firstSpace);
-    QString yString = command.mid(secondSpace + 1, thirdSpace - secondSpace);
-    bool ok = true;
-    int x = xString.toInt(&ok);
-    int y = yString.toInt(&ok);
-    if (!ok) {
-      return;
-    }
-    QString text = command.mid(thirdSpace + 1);
-    setText(x, y, text);
-  } else if (command.startsWith("clearText")) {
-    QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 3) {
-      return;
-    }
-    if (tokens.at(0) != "clearText") {
-      return;
-    }
-    bool ok = true;
-    int x = tokens.at(1).toInt(&ok);
-    int y = tokens.at(2).toInt(&ok);
-    if (!ok) {
-      return;
-    }
-    clearText(x, y);
-  } else if (command.startsWith("clearAllText")) {
-    QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-    if (tokens.size() != 1) {
-      return;
-    }
-    if (tokens.at(0) != "clearAllText") {
-      return;
-    }
-    clearAllText();
+void Window::startRival(const QString &name, Color color, int row) {
+  Rival *rival = new Rival();
+  rival->channel = nullptr;
+  rival->stats = new Stats();
+  rival->stats->resetAll();
+  m_rivals.append(rival);
+
+  // The rival's row, with a swatch of its mouse's color
+  QLabel *swatch = new QLabel();
+  RGB rgb = COLOR_TO_RGB(color);
+  swatch->setFixedSize(12, 12);
+  swatch->setStyleSheet(QString("QLabel { background: rgb(%1, %2, %3); }")
+                            .arg(rgb.r)
+                            .arg(rgb.g)
+                            .arg(rgb.b));
+  rival->status = new QLabel();
+  rival->status->setAlignment(Qt::AlignCenter);
+  rival->status->setFrameStyle(QFrame::StyledPanel | QFrame::Plain);
+  rival->widgets = {swatch, new QLabel(name), rival->status};
+  for (StatsEnum stat : {StatsEnum::TOTAL_DISTANCE, StatsEnum::TOTAL_TURNS,
+                         StatsEnum::BEST_RUN_TURNS, StatsEnum::SCORE}) {
+    QLineEdit *textbox = new QLineEdit();
+    textbox->setReadOnly(true);
+    rival->stats->bindText(stat, textbox);
+    rival->widgets.append(textbox);
+  }
+  for (int i = 0; i < rival->widgets.size(); i += 1) {
+    m_rivalsLayout->addWidget(rival->widgets.at(i), row, i);
+  }
+
+  // The rival's view is only drawn in the grid, but is kept up to date
+  // either way, so that the grid can be shown at any time
+  AlgoChannel *channel = new AlgoChannel();
+  rival->view = new MazeView(m_maze, false, m_geometry);
+  rival->simulation = new Simulation(m_maze, rival->view->getMazeGraphic(),
+                                     rival->stats, channel);
+  rival->simulation->setProgressPerSecond(getProgressPerSecond());
+  rival->simulation->setInstant(isInstant());
+  rival->simulation->setLockstep(m_lockstepCheckBox->isChecked());
+  rival->simulation->setFramePaced(m_maxVisibleCheckBox->isChecked());
+  rival->simulation->setTimeBudget(
+      SettingsMisc::getCommandTimeBudgetMicroseconds() / 1e6);
+  connect(rival->simulation, &Simulation::mouseMoved, m_map,
+          &Map::markFrameDirty);
+  connect(rival->simulation, &Simulation::viewChanged, m_map,
+          &Map::markFrameDirty);
+  connect(m_map, &Map::frameSwapped, rival->simulation,
+          &Simulation::onFrameShown);
+  Simulation *simulation = rival->simulation;
+  connect(
+      simulation, &Simulation::nextMazeRequested, simulation,
+      [=]() { simulation->answerNextMaze(false); }, Qt::QueuedConnection);
+  rival->mouseGraphic =
+      new MouseGraphic(rival->simulation->getMouse(), color);
+
+  // Process the commands that the channel parsed from stdout, unless the
+  // rival was removed in the meantime; stderr is discarded
+  connect(channel, &AlgoChannel::commandsParsed, this,
+          [=](const QVector<Command> &commands, CommandParser::Status status) {
+            Rival *current = getRival(channel);
+            if (current == nullptr) {
+              return;
+            }
+            if (current->simulation->processCommands(commands, status)) {
+              channel->resolveHandshake(true);
+            }
+            channel->allowCommands(commands.size(),
+                                   current->simulation->getCommandQueueRoom());
+          });
+  connect(simulation, &Simulation::readyForCommands, channel, [=]() {
+    channel->allowCommands(0, simulation->getCommandQueueRoom());
+  });
+  connect(simulation, &Simulation::handshakeAccepted, channel,
+          [=]() { channel->resolveHandshake(true); });
+  connect(channel, &AlgoChannel::finished, this,
+          [=](int exitCode, QProcess::ExitStatus exitStatus) {
+            onRivalExit(channel, exitCode, exitStatus);
+          });
+
+  QString directory = SettingsMouseAlgos::getDirectory(name);
+  QString runCommand = SettingsMouseAlgos::getRunCommand(name);
+  if (!directory.isEmpty() && !runCommand.isEmpty() &&
+      channel->start(runCommand, directory)) {
+    rival->channel = channel;
+    channel->allowCommands(0, simulation->getCommandQueueRoom());
+    rival->status->setText("RUNNING");
+    rival->status->setStyleSheet(IN_PROGRESS_STYLE_SHEET);
   } else {
-    // Enqueue the serial command, process it if
-    // future processing is not already scheduled
-    m_commandQueue.enqueue(command);
-    if (!m_commandQueueTimer->isActive()) {
-      processQueuedCommands();
-    }
+    m_runLog->appendLine(QString("Could not start rival \"%1\".").arg(name));
+    rival->simulation->stop();
+    rival->status->setText("ERROR");
+    rival->status->setStyleSheet(ERROR_STYLE_SHEET);
+    delete channel;
   }
 }
 
-QString Window::executeCommand(QString command) {
-  QStringList tokens = command.split(" ", Qt::SkipEmptyParts);
-  if (tokens.size() < 1 || tokens.size() > 2) {
-    return INVALID;
-  }
-  QString function = tokens.at(0);
-  if (tokens.size() == 2 && function != "getStat" &&
-      function != "moveForward" && function != "moveForwardHalf" &&
-      function != "wallFront" && function != "wallBack" &&
-      function != "wallLeft" && function != "wallRight" &&
-      function != "wallFrontRight" && function != "wallFrontLeft" &&
-      function != "wallBackRight" && function != "wallBackLeft") {
-    return INVALID;
-  }
-  if (function == "mazeWidth") {
-    return QString::number(mazeWidth());
-  } else if (function == "mazeHeight") {
-    return QString::number(mazeHeight());
-  } else if (function == "wallFront") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    // The "wallFront" and such methods take "halfStepsAway", which represents
-    // the number of moves "head" of the current move to simulator before
-    // checking if a wall is a half-step away. To check if a wall is directly
-    // in front of the mouse, we provide halfStepsAhead=0. The potential wall
-    // would be 1 half-step away, which is a bit more intuitive from the
-    // perspective of the API, hence the -1 here.
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallFront(halfStepsAhead));
-  } else if (function == "wallBack") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallBack(halfStepsAhead));
-  } else if (function == "wallLeft") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallLeft(halfStepsAhead));
-  } else if (function == "wallRight") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallRight(halfStepsAhead));
-  } else if (function == "wallFrontRight") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallFrontRight(halfStepsAhead));
-  } else if (function == "wallFrontLeft") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallFrontLeft(halfStepsAhead));
-  } else if (function == "wallBackRight") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallBackRight(halfStepsAhead));
-  } else if (function == "wallBackLeft") {
-    int halfStepsAway = 1;
-    if (tokens.size() == 2) {
-      halfStepsAway = tokens.at(1).toInt();
-    }
-    int halfStepsAhead = halfStepsAway - 1;
-    return boolToString(wallBackLeft(halfStepsAhead));
-  } else if (function == "moveForward") {
-    int distance = 1;
-    if (tokens.size() == 2) {
-      distance = tokens.at(1).toInt();
-    }
-    int numHalfSteps = distance * 2;
-    bool success = moveForward(numHalfSteps);
-    return success ? "" : CRASH;
-  } else if (function == "moveForwardHalf") {
-    int numHalfSteps = 1;
-    if (tokens.size() == 2) {
-      numHalfSteps = tokens.at(1).toInt();
-    }
-    bool success = moveForward(numHalfSteps);
-    return success ? "" : CRASH;
-  } else if (function == "turnRight" || function == "turnRight90") {
-    turn(Movement::TURN_RIGHT_90);
-    return "";
-  } else if (function == "turnLeft" || function == "turnLeft90") {
-    turn(Movement::TURN_LEFT_90);
-    return "";
-  } else if (function == "turnRight45") {
-    turn(Movement::TURN_RIGHT_45);
-    return "";
-  } else if (function == "turnLeft45") {
-    turn(Movement::TURN_LEFT_45);
-    return "";
-  } else if (function == "wasReset") {
-    return boolToString(wasReset());
-  } else if (function == "ackReset") {
-    ackReset();
-    return ACK;
-  } else if (function == "getStat") {
-    if (tokens.size() != 2) {
-      return INVALID;
-    }
-    QString stat = tokens.at(1);
-    // Convert stat to a StatsEnum
-    StatsEnum statsEnum;
-    if (stat == "total-distance") {
-      statsEnum = StatsEnum::TOTAL_DISTANCE;
-    } else if (stat == "total-turns") {
-      statsEnum = StatsEnum::TOTAL_TURNS;
-    } else if (stat == "best-run-distance") {
-      statsEnum = StatsEnum::BEST_RUN_DISTANCE;
-    } else if (stat == "best-run-turns") {
-      statsEnum = StatsEnum::BEST_RUN_TURNS;
-    } else if (stat == "current-run-distance") {
-      statsEnum = StatsEnum::CURRENT_RUN_DISTANCE;
-    } else if (stat == "current-run-turns") {
-      statsEnum = StatsEnum::CURRENT_RUN_TURNS;
-    } else if (stat == "total-effective-distance") {
-      statsEnum = StatsEnum::TOTAL_EFFECTIVE_DISTANCE;
-    } else if (stat == "best-run-effective-distance") {
-      statsEnum = StatsEnum::BEST_RUN_EFFECTIVE_DISTANCE;
-    } else if (stat == "current-run-effective-distance") {
-      statsEnum = StatsEnum::CURRENT_RUN_EFFECTIVE_DISTANCE;
-    } else if (stat == "score") {
-      statsEnum = StatsEnum::SCORE;
-    } else {
-      return INVALID;
-    }
-    QString statValue = stats->getStat(statsEnum);
-    if (statValue == "") {
-      // Cannot return an empty string. Return -1 to indicate empty field.
-      return "-1";
-    }
-    return statValue;
+void Window::onRivalExit(AlgoChannel *channel, int exitCode,
+                         QProcess::ExitStatus exitStatus) {
+  // Rivals that were removed were already cleaned up
+  Rival *rival = getRival(channel);
+  if (rival == nullptr) {
+    return;
+  }
+
+  // Stop consuming queued commands, the mouse remains in the maze
+  rival->simulation->stop();
+  if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+    rival->status->setText("COMPLETE");
+    rival->status->setStyleSheet(COMPLETE_STYLE_SHEET);
   } else {
-    return INVALID;
+    rival->status->setText("FAILED");
+    rival->status->setStyleSheet(FAILED_STYLE_SHEET);
   }
+
+  // This may be called from within the channel's kill, so defer deletion
+  rival->channel->deleteLater();
+  rival->channel = nullptr;
 }
 
-void Window::processQueuedCommands() {
-  while (!m_commandQueue.isEmpty() && !m_isPaused) {
-    QString response = "";
-    if (isMoving()) {
-      updateMouseProgress(m_movementStepSize);
-      if (!isMoving()) {
-        if (m_doomedToCrash) {
-          response = CRASH;
-        } else {
-          response = ACK;
-        }
-      }
-    } else {
-      response = executeCommand(m_commandQueue.head());
-    }
-    if (!response.isEmpty()) {
-      // Drop all invalid commands on the floor
-      if (response != INVALID) {
-        m_runProcess->write((response + "\n").toStdString().c_str());
-      }
-      m_commandQueue.dequeue();
-    } else {
-      scheduleMouseProgressUpdate();
-      break;
+void Window::removeRivalsFromMaze() {
+  // The rows and stats are kept until the next rivals are started
+  for (Rival *rival : m_rivals) {
+    if (rival->channel != nullptr) {
+      AlgoChannel *channel = rival->channel;
+      rival->channel = nullptr;
+      channel->kill();
+      channel->deleteLater();
+      rival->status->setText("CANCELED");
+      rival->status->setStyleSheet(CANCELED_STYLE_SHEET);
     }
+    delete rival->mouseGraphic;
+    rival->mouseGraphic = nullptr;
+    delete rival->simulation;
+    rival->simulation = nullptr;
+    delete rival->view;
+    rival->view = nullptr;
   }
 }
 
-double Window::progressRequired(Movement movement) {
-  switch (movement) {
-    case Movement::MOVE_STRAIGHT:
-      return 50.0 * m_halfStepsToMoveForward;
-    case Movement::MOVE_DIAGONAL:
-      return 70.71 * m_halfStepsToMoveForward;
-    case Movement::TURN_RIGHT_45:
-    case Movement::TURN_LEFT_45:
-      return 16.66;
-    case Movement::TURN_RIGHT_90:
-    case Movement::TURN_LEFT_90:
-      return 33.33;
-    default:
-      ASSERT_NEVER_RUNS();
-  }
-}
-
-void Window::updateMouseProgress(double progress) {
-  // Determine the destination of the mouse.
-  SemiPosition destinationLocation = m_startingPosition;
-  Angle destinationRotation = DIRECTION_TO_ANGLE().value(m_startingDirection);
-  if (m_movement == Movement::MOVE_STRAIGHT) {
-    if (m_startingDirection == SemiDirection::NORTH) {
-      destinationLocation.y += m_halfStepsToMoveForward;
-    } else if (m_startingDirection == SemiDirection::EAST) {
-      destinationLocation.x += m_halfStepsToMoveForward;
-    } else if (m_startingDirection == SemiDirection::SOUTH) {
-      destinationLocation.y -= m_halfStepsToMoveForward;
-    } else if (m_startingDirection == SemiDirection::WEST) {
-      destinationLocation.x -= m_halfStepsToMoveForward;
-    } else {
-      ASSERT_NEVER_RUNS();
-    }
-  } else if (m_movement == Movement::MOVE_DIAGONAL) {
-    if (m_startingDirection == SemiDirection::NORTHEAST) {
-      destinationLocation.x += m_halfStepsToMoveForward;
-      destinationLocation.y += m_halfStepsToMoveForward;
-    } else if (m_startingDirection == SemiDirection::NORTHWEST) {
-      destinationLocation.x -= m_halfStepsToMoveForward;
-      destinationLocation.y += m_halfStepsToMoveForward;
-    } else if (m_startingDirection == SemiDirection::SOUTHEAST) {
-      destinationLocation.x += m_halfStepsToMoveForward;
-      destinationLocation.y -= m_halfStepsToMoveForward;
-    } else if (m_startingDirection == SemiDirection::SOUTHWEST) {
-      destinationLocation.x -= m_halfStepsToMoveForward;
-      destinationLocation.y -= m_halfStepsToMoveForward;
-    } else {
-      ASSERT_NEVER_RUNS();
-    }
-  }
-  // Explicity add or subtract depending on direction so that the mouse is
-  // guaranteed to only rotate that much (using DIRECTION_ROTATE can cause
-  // the mouse to rotate 270 degrees in the opposite direction in some cases)
-  else if (m_movement == Movement::TURN_RIGHT_45) {
-    destinationRotation -= Angle::Degrees(45);
-  } else if (m_movement == Movement::TURN_LEFT_45) {
-    destinationRotation += Angle::Degrees(45);
-  } else if (m_movement == Movement::TURN_RIGHT_90) {
-    destinationRotation -= Angle::Degrees(90);
-  } else if (m_movement == Movement::TURN_LEFT_90) {
-    destinationRotation += Angle::Degrees(90);
-  } else {
-    ASSERT_NEVER_RUNS();
-  }
-
-  // Increment the movement progress, calculate fraction complete
-  m_movementProgress += progress;
-  double required = progressRequired(m_movement);
-  double remaining = required - m_movementProgress;
-  if (remaining < 0) {
-    remaining = 0;
-  }
-  double fraction = 1.0 - (remaining / required);
-
-  // Calculate the current translation and rotation
-  Coordinate startingTranslation = getCoordinate(m_startingPosition);
-  Coordinate destinationTranslation = getCoordinate(destinationLocation);
-
-  Angle startingRotation = DIRECTION_TO_ANGLE().value(m_startingDirection);
-  Coordinate currentTranslation = startingTranslation * (1.0 - fraction) +
-                                  destinationTranslation * fraction;
-  Angle currentRotation =
-      startingRotation * (1.0 - fraction) + destinationRotation * fraction;
-
-  // Teleport the mouse, reset movement state if done
-  m_mouse->teleport(currentTranslation, currentRotation);
-  if (remaining == 0.0) {
-    m_startingPosition = m_mouse->getCurrentDiscretizedTranslation();
-    m_startingDirection = m_mouse->getCurrentDiscretizedRotation();
-    m_movementProgress = 0.0;
-    m_movementStepSize = 0.0;
-    m_movement = Movement::NONE;
-    m_halfStepsToMoveForward = 0;
-    // TODO: upforgrabs
-    // This if-else can probably be moved outside of the enclosing if-block
-    // determine if the goal was reached
-    if (m_maze->isInCenter(m_startingPosition.toMazeLocation())) {
-      stats->finishRun();  // record a completed start-to-finish run
-    } else if (m_startingPosition.toMazeLocation().first == 0 &&
-               m_startingPosition.toMazeLocation().second == 0) {
-      stats->endUnfinishedRun();
+Window::Rival *Window::getRival(AlgoChannel *channel) const {
+  for (Rival *rival : m_rivals) {
+    if (rival->channel == channel) {
+      return rival;
     }
   }
+  return nullptr;
 }
 
-void Window::scheduleMouseProgressUpdate() {
-  // Calculate progressRemaining, should be nonzero
-  double required = progressRequired(m_movement);
-  double progressRemaining = required - m_movementProgress;
-  ASSERT_LT(0.0, progressRemaining);
-
-  // Calculate progressPerSecond for non-linear slider
-  double value = static_cast<double>(m_speedSlider->value());
-  double fraction = value / SPEED_SLIDER_MAX;
-  double rangeMin = qPow(MIN_PROGRESS_PER_SECOND, .25);
-  double rangeMax = qPow(MAX_PROGRESS_PER_SECOND, .25);
-  double rangeValue = (1.0 - fraction) * rangeMin + fraction * rangeMax;
-  double progressPerSecond = qPow(rangeValue, 4);
-
-  // Determine seconds remaing
-  double secondsRemaining = progressRemaining / progressPerSecond;
-  if (secondsRemaining > MAX_SLEEP_SECONDS) {
-    secondsRemaining = MAX_SLEEP_SECONDS;
-    progressRemaining = secondsRemaining * progressPerSecond;
+void Window::onReplayButtonPressed() {
+  QString path = QFileDialog::getOpenFileName(this, tr("Load Replay"));
+  if (path.isNull()) {
+    return;
   }
-
-  // Update step size, set the timer
-  m_movementStepSize = progressRemaining;
-  m_commandQueueTimer->start(secondsRemaining * 1000);
+  ReplayLog *log = ReplayLog::fromFile(path);
+  if (log == nullptr) {
+    QMessageBox::warning(
+        this, "Invalid Replay",
+        QString("\"%1\" is not a valid replay.").arg(path));
+    return;
+  }
+  startReplay(log);
 }
 
-bool Window::isMoving() { return m_movement != Movement::NONE; }
-
-void Window::createStat(QString name, enum StatsEnum stat, int labelRow,
-                        int labelCol, int valueRow, int valueCol,
-                        QGridLayout *layout) {
-  QLabel *label = new QLabel(name);
-  layout->addWidget(label, labelRow, labelCol);
-  QLineEdit *textbox = new QLineEdit();
-  textbox->setReadOnly(true);
-  stats->bindText(stat, textbox);
-  layout->addWidget(textbox, valueRow, valueCol);
+void Window::onSaveReplayButtonPressed() {
+  ASSERT_FA(m_replayLog == nullptr);
+  QString path = QFileDialog::getSaveFileName(this, tr("Save Replay"));
+  if (path.isNull()) {
+    return;
+  }
+  if (!m_replayLog->toFile(path)) {
+    QMessageBox::warning(this, "Could Not Save Replay",
+                         QString("Could not write \"%1\".").arg(path));
+  }
 }
 
-int Window::mazeWidth() { return m_maze->getWidth(); }
+void Window::startReplay(ReplayLog *log) {
+  // Show the maze of the replay, which also stops any run
+  updateMaze(Maze::fromBinary(log->getMaze()));
+  ASSERT_TR(m_runChannel == nullptr);
+  ASSERT_TR(m_replayPlayer == nullptr);
+  delete m_replayLog;
+  m_replayLog = log;
+  m_saveReplayButton->setEnabled(true);
+
+  // The player stands in for the algo process
+  m_replayPlayer = new ReplayPlayer(m_replayLog);
+  addMouseToMaze(m_replayPlayer->getOutput());
+  m_replayTimeline = new ReplayTimeline(m_maze, m_view->getMazeGraphic(),
+                                        m_simulation, m_replayPlayer);
+  connect(m_replayPlayer, &ReplayPlayer::played, this,
+          &Window::onReplayPlayed);
+  connect(m_replayPlayer, &ReplayPlayer::seekFinished, this,
+          &Window::onReplaySeekFinished);
+  connect(m_replayPlayer, &ReplayPlayer::finished, this,
+          &Window::onReplayFinished);
+  m_runLog->clear();
+  stats->resetAll();
 
-int Window::mazeHeight() { return m_maze->getHeight(); }
+  // The timeline covers the whole log
+  m_replaySlider->setRange(0, m_replayLog->getDuration() / 1000);
+  m_replaySlider->setValue(0);
+  m_replaySlider->setEnabled(true);
 
-bool Window::wallFront(int halfStepsAhead) {
-  return isWall(m_mouse->getCurrentDiscretizedTranslation(),
-                m_mouse->getCurrentDiscretizedRotation(), halfStepsAhead);
+  showReplayInProgress();
+  m_replayPlayer->start(m_simulation);
 }
 
-bool Window::wallRight(int halfStepsAhead) {
-  return isWall(m_mouse->getCurrentDiscretizedTranslation(),
-                DIRECTION_ROTATE_90_RIGHT().value(
-                    m_mouse->getCurrentDiscretizedRotation()),
-                halfStepsAhead);
-}
+void Window::showReplayInProgress() {
+  ASSERT_FA(m_isReplaying);
+  m_isReplaying = true;
 
-bool Window::wallLeft(int halfStepsAhead) {
-  return isWall(m_mouse->getCurrentDiscretizedTranslation(),
-                DIRECTION_ROTATE_90_LEFT().value(
-                    m_mouse->getCurrentDiscretizedRotation()),
-                halfStepsAhead);
-}
+  // Update the run button
+  disconnect(m_runButton, &QPushButton::clicked, this, &Window::startRun);
+  connect(m_runButton, &QPushButton::clicked, this, &Window::cancelRun);
+  m_runButton->setText("Cancel");
 
-bool Window::wallBack(int halfStepsAhead) {
-  return isWall(
-      m_mouse->getCurrentDiscretizedTranslation(),
-      DIRECTION_ROTATE_180().value(m_mouse->getCurrentDiscretizedRotation()),
-      halfStepsAhead);
-}
+  // Update the run status
+  m_runStatus->setText("REPLAYING");
+  m_runStatus->setStyleSheet(IN_PROGRESS_STYLE_SHEET);
 
-bool Window::wallFrontRight(int halfStepsAhead) {
-  return isWall(m_mouse->getCurrentDiscretizedTranslation(),
-                DIRECTION_ROTATE_45_RIGHT().value(
-                    m_mouse->getCurrentDiscretizedRotation()),
-                halfStepsAhead);
+  // Resets are part of the replay, so only pausing is possible
+  m_pauseButton->setEnabled(true);
 }
 
-bool Window::wallFrontLeft(int halfStepsAhead) {
-  return isWall(m_mouse->getCurrentDiscretizedTranslation(),
-                DIRECTION_ROTATE_45_LEFT().value(
-                    m_mouse->getCurrentDiscretizedRotation()),
-                halfStepsAhead);
+void Window::onReplayPlayed(qint64 microseconds) {
+  m_replayTimeline->update();
+  if (!m_replaySlider->isSliderDown()) {
+    m_replaySlider->setValue(microseconds / 1000);
+  }
 }
 
-bool Window::wallBackRight(int halfStepsAhead) {
-  return isWall(
-      m_mouse->getCurrentDiscretizedTranslation(),
-      DIRECTION_ROTATE_90_RIGHT().value(DIRECTION_ROTATE_45_RIGHT().value(
-          m_mouse->getCurrentDiscretizedRotation())),
-      halfStepsAhead);
+void Window::onReplaySliderReleased() {
+  // Seeking after the end plays the rest of the replay again
+  if (!m_isReplaying) {
+    showReplayInProgress();
+  }
+  m_replayTimeline->seek(static_cast<qint64>(m_replaySlider->value()) * 1000);
 }
 
-bool Window::wallBackLeft(int halfStepsAhead) {
-  return isWall(
-      m_mouse->getCurrentDiscretizedTranslation(),
-      DIRECTION_ROTATE_90_LEFT().value(DIRECTION_ROTATE_45_LEFT().value(
-          m_mouse->getCurrentDiscretizedRotation())),
-      halfStepsAhead);
+void Window::onReplaySeekFinished() {
+  // Seeking is instant, so go back to the configured speed
+  m_simulation->setInstant(isInstant());
 }
 
-bool Window::moveForward(int numHalfSteps) {
-  // Non-positive distances aren't allowed
-  if (numHalfSteps < 1) {
-    return false;
-  }
-  // Special case for a wall directly in front of the mouse, else
-  // the wall won't be detected until after the mouse starts moving
-  if (wallFront(0)) {
-    return false;
-  }
-
-  // Compute the number of allowable moves
-  int allowableHalfSteps = 1;
-  while (allowableHalfSteps < numHalfSteps) {
-    if (wallFront(allowableHalfSteps)) {
-      break;
-    }
-    allowableHalfSteps += 1;
-  }
-  m_doomedToCrash = (allowableHalfSteps != numHalfSteps);
-  m_halfStepsToMoveForward = allowableHalfSteps;
-
-  // Update m_movement based on current direction and requested steps
-  SemiDirection semiDir = m_mouse->getCurrentDiscretizedRotation();
-  if (!ORDINAL_DIRECTIONS().contains(semiDir)) {
-    m_movement = Movement::MOVE_STRAIGHT;
+void Window::onReplayFinished(int mismatches) {
+  if (mismatches == 0) {
+    finishReplay("COMPLETE", COMPLETE_STYLE_SHEET);
   } else {
-    m_movement = Movement::MOVE_DIAGONAL;
-  }
-
-  // TODO: upforgrabs
-  // Starting position shouldn't be hardcoded here since it can depend on maze
-  if (m_startingPosition.toMazeLocation().first == 0 &&
-      m_startingPosition.toMazeLocation().second == 0) {
-    stats->startRun();
+    m_runLog->appendLine(
+        QString("%1 responses differed from the recording.").arg(mismatches));
+    finishReplay("DIVERGED", FAILED_STYLE_SHEET);
   }
-  // TODO: upforgrabs
-  // Half steps shouldn't count as a full move
-  // increase the stats by the distance that will be travelled
-  stats->addDistance(numHalfSteps);
-
-  // Return true so that the allowable movement can be executed
-  return true;
 }
 
-void Window::turn(Movement movement) {
-  ASSERT_TR(movement == Movement::TURN_LEFT_45 ||
-            movement == Movement::TURN_LEFT_90 ||
-            movement == Movement::TURN_RIGHT_45 ||
-            movement == Movement::TURN_RIGHT_90);
-
-  m_movement = movement;
-  // TODO: upforgrabs
-  // Setting these member variables should be unnecessary here
-  m_doomedToCrash = false;
-  m_halfStepsToMoveForward = 0;
-  // TODO: upforgrabs
-  // Half turns shouldn't count as full turn
-  stats->addTurn();
-}
+void Window::finishReplay(const QString &status, const QString &styleSheet) {
+  ASSERT_TR(m_isReplaying);
+  m_isReplaying = false;
 
-void Window::setWall(int x, int y, QChar direction) {
-  if (!isWithinMaze(x, y)) {
-    return;
-  }
-  if (!CHAR_TO_DIRECTION().contains(direction)) {
-    return;
-  }
-  Direction d = CHAR_TO_DIRECTION().value(direction);
-  m_view->getMazeGraphic()->setWall(x, y, d);
-  Wall opposingWall = getOpposingWall({x, y, d});
-  if (isWithinMaze(opposingWall.x, opposingWall.y)) {
-    m_view->getMazeGraphic()->setWall(opposingWall.x, opposingWall.y,
-                                      opposingWall.d);
+  // Always unpause on exit
+  if (m_isPaused) {
+    onPauseButtonPressed();
   }
+  m_pauseButton->setEnabled(false);
+
+  // Update the run button
+  disconnect(m_runButton, &QPushButton::clicked, this, &Window::cancelRun);
+  connect(m_runButton, &QPushButton::clicked, this, &Window::startRun);
+  m_runButton->setText("Run");
+
+  // Update the status label
+  m_runStatus->setText(status);
+  m_runStatus->setStyleSheet(styleSheet);
 }
 
-void Window::clearWall(int x, int y, QChar direction) {
-  if (!isWithinMaze(x, y)) {
-    return;
-  }
-  if (!CHAR_TO_DIRECTION().contains(direction)) {
-    return;
+void Window::onPauseButtonPressed() {
+  m_isPaused = !m_isPaused;
+  if (m_isPaused) {
+    m_pauseButton->setText("Resume");
+    m_runStatus->setText("PAUSED");
+  } else {
+    m_pauseButton->setText("Pause");
+    m_runStatus->setText("RUNNING");
   }
-  Direction d = CHAR_TO_DIRECTION().value(direction);
-  m_view->getMazeGraphic()->clearWall(x, y, d);
-  Wall opposingWall = getOpposingWall({x, y, d});
-  if (isWithinMaze(opposingWall.x, opposingWall.y)) {
-    m_view->getMazeGraphic()->clearWall(opposingWall.x, opposingWall.y,
-                                        opposingWall.d);
+  m_simulation->setPaused(m_isPaused);
+  for (Rival *rival : m_rivals) {
+    if (rival->simulation != nullptr) {
+      rival->simulation->setPaused(m_isPaused);
+    }
   }
 }
 
-void Window::setColor(int x, int y, QChar color) {
-  if (!isWithinMaze(x, y)) {
+void Window::onWatchpointsEdited() {
+  // Invalid watchpoints are marked, and the last valid ones stay in effect
+  QString error;
+  if (!Watchpoints::fromSpec(m_watchpointsEdit->text(), &m_watchpoints,
+                             &error)) {
+    m_watchpointsEdit->setStyleSheet(INVALID_EDIT_STYLE_SHEET);
+    m_watchpointsEdit->setToolTip(error);
     return;
   }
-  if (!CHAR_TO_COLOR().contains(color)) {
-    return;
+  m_watchpointsEdit->setStyleSheet("");
+  m_watchpointsEdit->setToolTip(QString());
+  if (m_simulation != nullptr) {
+    m_simulation->setWatchpoints(m_watchpoints);
   }
-  m_view->getMazeGraphic()->setColor(x, y, CHAR_TO_COLOR().value(color));
-  m_tilesWithColor.insert({x, y});
 }
 
-void Window::clearColor(int x, int y) {
-  if (!isWithinMaze(x, y)) {
-    return;
+void Window::onWatchpointHit(const QString &watchpoint) {
+  // The simulation has already paused itself, so only the rivals and the
+  // controls need to catch up
+  m_runLog->appendLine(
+      QString("Paused at watchpoint \"%1\".").arg(watchpoint));
+  if (!m_isPaused) {
+    onPauseButtonPressed();
   }
-  m_view->getMazeGraphic()->clearColor(x, y);
-  m_tilesWithColor -= {x, y};
 }
 
-void Window::clearAllColor() {
-  for (QPair<int, int> position : m_tilesWithColor) {
-    m_view->getMazeGraphic()->clearColor(position.first, position.second);
-  }
-  m_tilesWithColor.clear();
+void Window::onResetButtonPressed() {
+  m_resetButton->setEnabled(false);
+  m_resetButton->setText("Waiting");
+  m_simulation->requestReset();
 }
 
-void Window::setText(int x, int y, QString text) {
-  if (!isWithinMaze(x, y)) {
+void Window::onResetAcknowledged() {
+  // Resets are part of a replay, so the button stays disabled
+  if (m_replayPlayer != nullptr) {
     return;
   }
-  static QRegularExpression regex = QRegularExpression(
-      QString("[^") + FontImage::characters() + QString("]"));
-  text.replace(regex, "?");
-  m_view->getMazeGraphic()->setText(x, y, text);
-  m_tilesWithText.insert({x, y});
+  m_resetButton->setEnabled(true);
+  m_resetButton->setText("Reset");
 }
 
-void Window::clearText(int x, int y) {
-  if (!isWithinMaze(x, y)) {
-    return;
+void Window::onSpeedSliderChanged() {
+  if (m_simulation != nullptr) {
+    m_simulation->setProgressPerSecond(getProgressPerSecond());
   }
-  m_view->getMazeGraphic()->clearText(x, y);
-  m_tilesWithText -= {x, y};
-}
-
-void Window::clearAllText() {
-  for (QPair<int, int> position : m_tilesWithText) {
-    m_view->getMazeGraphic()->clearText(position.first, position.second);
+  for (Rival *rival : m_rivals) {
+    if (rival->simulation != nullptr) {
+      rival->simulation->setProgressPerSecond(getProgressPerSecond());
+    }
   }
-  m_tilesWithText.clear();
 }
 
-bool Window::wasReset() { return m_wasReset; }
-
-void Window::ackReset() {
-  m_mouse->reset();
-  m_startingPosition = INITIAL_STARTING_POSITION;
-  m_startingDirection = INITIAL_STARTING_DIRECTION;
-  m_movement = Movement::NONE;
-  m_movementProgress = 0.0;
-  m_movementStepSize = 0.0;
-  m_resetButton->setEnabled(true);
-  m_resetButton->setText("Reset");
-  m_wasReset = false;
-  stats->penalizeForReset();
-  stats->endUnfinishedRun();
+void Window::refreshWatched() {
+  bool isWatched = isVisible() && !isMinimized() &&
+                   windowHandle() != nullptr && windowHandle()->isExposed();
+  if (isWatched == m_isWatched) {
+    return;
+  }
+  m_isWatched = isWatched;
+  m_map->setSuspended(!m_isWatched);
+  onInstantCheckBoxChanged();
 }
 
-QString Window::boolToString(bool value) const {
-  return value ? "true" : "false";
+bool Window::isInstant() const {
+  return m_instantCheckBox->isChecked() || !m_isWatched;
 }
 
-bool Window::isWall(SemiPosition semiPos, SemiDirection semiDir) const {
-  ASSERT_LE(0, semiPos.x);
-  ASSERT_LE(semiPos.x, m_maze->getWidth() * 2);
-  ASSERT_LE(0, semiPos.y);
-  ASSERT_LE(semiPos.y, m_maze->getHeight() * 2);
-
-  // Maze locations
-  auto mazeLocation = semiPos.toMazeLocation();
-  int mazeX = mazeLocation.first;
-  int mazeY = mazeLocation.second;
-
-  // Should never be inside a corner
-  if (semiPos.x % 2 == 0 && semiPos.y % 2 == 0) {
-    ASSERT_NEVER_RUNS();
+void Window::onInstantCheckBoxChanged() {
+  // The slider has no effect while movement is instant
+  m_speedSlider->setEnabled(!m_instantCheckBox->isChecked() &&
+                            !m_maxVisibleCheckBox->isChecked());
+  if (m_simulation != nullptr) {
+    m_simulation->setInstant(isInstant());
   }
-  // We're in the center of the cell
-  else if (semiPos.x % 2 == 1 && semiPos.y % 2 == 1) {
-    if (ORDINAL_DIRECTIONS().contains(semiDir)) {
-      // We're aiming at a corner
-      return true;
-    }
-    Direction d = SEMI_TO_CARDINAL().value(semiDir);
-    return m_maze->getTile(mazeX, mazeY)->isWall(d);
-  }
-  // We're on the vertical edge of a cell
-  else if (semiPos.x % 2 == 0 && semiPos.y % 2 == 1) {
-    // Facing a corner post
-    if (semiDir == SemiDirection::NORTH || semiDir == SemiDirection::SOUTH) {
-      return true;
-    }
-    // Facing center of cell
-    else if (semiDir == SemiDirection::EAST || semiDir == SemiDirection::WEST) {
-      return false;
-    } else if (semiDir == SemiDirection::NORTHEAST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.x == m_maze->getWidth() * 2) {
-        return false;
-      }
-      return m_maze->getTile(mazeX, mazeY)->isWall(Direction::NORTH);
-    } else if (semiDir == SemiDirection::SOUTHEAST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.x == m_maze->getWidth() * 2) {
-        return false;
-      }
-      return m_maze->getTile(mazeX, mazeY)->isWall(Direction::SOUTH);
-    } else if (semiDir == SemiDirection::NORTHWEST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.x == 0) {
-        return false;
-      }
-      return m_maze->getTile(mazeX - 1, mazeY)->isWall(Direction::NORTH);
-    } else if (semiDir == SemiDirection::SOUTHWEST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.x == 0) {
-        return false;
-      }
-      return m_maze->getTile(mazeX - 1, mazeY)->isWall(Direction::SOUTH);
+  for (Rival *rival : m_rivals) {
+    if (rival->simulation != nullptr) {
+      rival->simulation->setInstant(isInstant());
     }
   }
-  // We're on the horizontal edge of a cell
-  else if (semiPos.x % 2 == 1 && semiPos.y % 2 == 0) {
-    // Facing a corner post
-    if (semiDir == SemiDirection::EAST || semiDir == SemiDirection::WEST) {
-      return true;
-    }
-    // Facing center of cell
-    else if (semiDir == SemiDirection::NORTH ||
-             semiDir == SemiDirection::SOUTH) {
-      return false;
-    } else if (semiDir == SemiDirection::NORTHEAST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.y == m_maze->getHeight() * 2) {
-        return false;
-      }
-      return m_maze->getTile(mazeX, mazeY)->isWall(Direction::EAST);
-    } else if (semiDir == SemiDirection::NORTHWEST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.y == m_maze->getHeight() * 2) {
-        return false;
-      }
-      return m_maze->getTile(mazeX, mazeY)->isWall(Direction::WEST);
-    } else if (semiDir == SemiDirection::SOUTHEAST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.y == 0) {
-        return false;
-      }
-      return m_maze->getTile(mazeX, mazeY - 1)->isWall(Direction::EAST);
-    } else if (semiDir == SemiDirection::SOUTHWEST) {
-      // On the edge of the maze, no walls outside
-      if (semiPos.y == 0) {
-        return false;
-      }
-      return m_maze->getTile(mazeX, mazeY - 1)->isWall(Direction::WEST);
-    }
-  } else {
-    ASSERT_NEVER_RUNS();
-  }
-}
-
-bool Window::isWall(SemiPosition semiPos, SemiDirection semiDir,
-                    int halfStepsAhead) const {
-  // Check all possible wall locations between the starting position and the
-  // ending position; if any, then there is a wall obstructing the path.
-  if (isWall(semiPos, semiDir)) {
-    return true;
-  }
-  for (int i = 1; i <= halfStepsAhead; i += 1) {
-    switch (semiDir) {
-      case SemiDirection::NORTH:
-        semiPos.y += 1;
-        break;
-      case SemiDirection::SOUTH:
-        semiPos.y -= 1;
-        break;
-      case SemiDirection::EAST:
-        semiPos.x += 1;
-        break;
-      case SemiDirection::WEST:
-        semiPos.x -= 1;
-        break;
-      case SemiDirection::NORTHEAST:
-        semiPos.x += 1;
-        semiPos.y += 1;
-        break;
-      case SemiDirection::NORTHWEST:
-        semiPos.x -= 1;
-        semiPos.y += 1;
-        break;
-      case SemiDirection::SOUTHEAST:
-        semiPos.x += 1;
-        semiPos.y -= 1;
-        break;
-      case SemiDirection::SOUTHWEST:
-        semiPos.x -= 1;
-        semiPos.y -= 1;
-        break;
-      default:
-        ASSERT_NEVER_RUNS();
-    }
-    if (isWall(semiPos, semiDir)) {
-      return true;
+}
+
+void Window::onLockstepCheckBoxChanged() {
+  if (m_simulation != nullptr) {
+    m_simulation->setLockstep(m_lockstepCheckBox->isChecked());
+  }
+  for (Rival *rival : m_rivals) {
+    if (rival->simulation != nullptr) {
+      rival->simulation->setLockstep(m_lockstepCheckBox->isChecked());
     }
   }
-  return false;
 }
 
-bool Window::isWithinMaze(int x, int y) const {
-  return (0 <= x && x < m_maze->getWidth() && 0 <= y &&
-          y < m_maze->getHeight());
+void Window::onMaxVisibleCheckBoxChanged() {
+  // The slider has no effect while movement is paced by frames either
+  m_speedSlider->setEnabled(!m_instantCheckBox->isChecked() &&
+                            !m_maxVisibleCheckBox->isChecked());
+  if (m_simulation != nullptr) {
+    m_simulation->setFramePaced(m_maxVisibleCheckBox->isChecked());
+  }
+  for (Rival *rival : m_rivals) {
+    if (rival->simulation != nullptr) {
+      rival->simulation->setFramePaced(m_maxVisibleCheckBox->isChecked());
+    }
+  }
 }
 
-Wall Window::getOpposingWall(Wall wall) const {
-  switch (wall.d) {
-    case Direction::NORTH:
-      return {wall.x, wall.y + 1, Direction::SOUTH};
-    case Direction::EAST:
-      return {wall.x + 1, wall.y, Direction::WEST};
-    case Direction::SOUTH:
-      return {wall.x, wall.y - 1, Direction::NORTH};
-    case Direction::WEST:
-      return {wall.x - 1, wall.y, Direction::EAST};
-    default:
-      ASSERT_NEVER_RUNS();
-  }
+double Window::getProgressPerSecond() const {
+  // Calculate progressPerSecond for non-linear slider
+  double value = static_cast<double>(m_speedSlider->value());
+  double fraction = value / SPEED_SLIDER_MAX;
+  double rangeMin = qPow(Simulation::MIN_PROGRESS_PER_SECOND, .25);
+  double rangeMax = qPow(Simulation::MAX_PROGRESS_PER_SECOND, .25);
+  double rangeValue = (1.0 - fraction) * rangeMin + fraction * rangeMax;
+  return qPow(rangeValue, 4);
 }
 
-Coordinate Window::getCoordinate(SemiPosition semiPos) const {
-  QPair<int, int> mazeLocation = semiPos.toMazeLocation();
-  ASSERT_TR(isWithinMaze(mazeLocation.first, mazeLocation.second));
-  Coordinate coordinate = Coordinate::Cartesian(
-      Dimensions::halfTileLength() * static_cast<double>(semiPos.x),
-      Dimensions::halfTileLength() * static_cast<double>(semiPos.y));
-  return coordinate;
+void Window::createStat(QString name, enum StatsEnum stat, int labelRow,
+                        int labelCol, int valueRow, int valueCol,
+                        QGridLayout *layout) {
+  QLabel *label = new QLabel(name);
+  layout->addWidget(label, labelRow, labelCol);
+  QLineEdit *textbox = new QLineEdit();
+  textbox->setReadOnly(true);
+  stats->bindText(stat, textbox);
+  layout->addWidget(textbox, valueRow, valueCol);
 }
 
 }  // namespace mms
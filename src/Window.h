@@ -1,45 +1,42 @@
 #pragma once
 
-#include <QChar>
 #include <QCloseEvent>
+#include <QEvent>
 #include <QComboBox>
+#include <QFileSystemWatcher>
 #include <QGridLayout>
 #include <QLabel>
+#include <QLineEdit>
+#include <QCheckBox>
 #include <QMainWindow>
-#include <QPair>
+#include <QMenu>
 #include <QPlainTextEdit>
 #include <QProcess>
 #include <QPushButton>
-#include <QQueue>
-#include <QSet>
+#include <QShowEvent>
+#include <QSlider>
 #include <QTimer>
 #include <QToolButton>
 
+#include "AlgoChannel.h"
+#include "Color.h"
+#include "LineBuffer.h"
+#include "LogPane.h"
 #include "Map.h"
 #include "Maze.h"
+#include "MazeFileCache.h"
 #include "MazeView.h"
-#include "Mouse.h"
+#include "MetricsPlot.h"
 #include "MouseGraphic.h"
+#include "ReplayLog.h"
+#include "ReplayPlayer.h"
+#include "ReplayTimeline.h"
+#include "Simulation.h"
 #include "Stats.h"
+#include "Watchpoints.h"
 
 namespace mms {
 
-enum class Movement {
-  MOVE_STRAIGHT,
-  MOVE_DIAGONAL,
-  TURN_RIGHT_45,
-  TURN_RIGHT_90,
-  TURN_LEFT_45,
-  TURN_LEFT_90,
-  NONE,
-};
-
-struct Wall {
-  int x;
-  int y;
-  Direction d;
-};
-
 class Window : public QMainWindow {
   Q_OBJECT
 
@@ -47,27 +44,82 @@ class Window : public QMainWindow {
   Window(QWidget *parent = 0);
   void closeEvent(QCloseEvent *event);
   void resizeEvent(QResizeEvent *event);
+  void changeEvent(QEvent *event);
+  void showEvent(QShowEvent *event);
+  void hideEvent(QHideEvent *event);
+  bool eventFilter(QObject *object, QEvent *event);
+
+  // Edits the truth maze, e.g., from a maze editor; only the tiles whose
+  // distances changed have their text redrawn
+  void setTruthWall(int x, int y, Direction direction, bool isWall);
 
  private:
+  // Edits a wall of the truth without refreshing its path or the frame, so
+  // that many walls can be edited at once
+  void applyTruthWall(int x, int y, Direction direction, bool isWall);
+
   // ----- Graphics -----
 
   Map *m_map;
   void scheduleMapUpdate();
 
+  // While a mouse is in the maze, its view can be drawn beside the truth, and
+  // beside the views of the rivals, in a grid
+  QCheckBox *m_splitViewCheckBox;
+  QCheckBox *m_gridViewCheckBox;
+  void refreshMapViews();
+
   // ----- Maze -----
 
   Maze *m_maze;
-  MazeView *m_truth;
   QString m_currentMazeFile;
   QComboBox *m_mazeFileComboBox;
+  MazeFileCache *m_mazeFileCache;
+
+  // The current maze file is reloaded whenever it changes on disk, e.g., when
+  // it's saved in an editor, once it has stopped changing for a moment; if
+  // it's the same size, only the walls that changed are redrawn
+  static const int MAZE_RELOAD_DELAY_MILLISECONDS;
+  QFileSystemWatcher *m_mazeFileWatcher;
+  QTimer *m_mazeReloadTimer;
+  void watchMazeFile(const QString &path);
+  void reloadMazeFile();
+
+  // While editing, clicking the map toggles the walls of the truth (see
+  // setTruthWall), other than those on its border, and the edited maze can
+  // be saved in any of the formats
+  QCheckBox *m_editCheckBox;
+  QToolButton *m_saveMazeButton;
+  void onWallClicked(int x, int y, Direction direction);
+  void onSaveMazeButtonPressed();
 
   void onMazeFileButtonPressed();
   void onMazeFileComboBoxChanged(QString path);
+  void onMazeFileValidated(QString path, const MazeFileCache::Info &info);
   void showInvalidMazeFileWarning(QString path);
   void refreshMazeFileComboBox(QString selected);
+  void showMazeFileInfo(int index, const MazeFileCache::Info &info);
   void updateMazeAndPath(Maze *maze, QString path);
+  void loadRecent();
   void updateMaze(Maze *maze);
 
+  // The truth, with its walls and distances, is only built once it's first
+  // displayed, which it may never be if a run replaces it straight away, and
+  // its geometry is built by whichever of it and the mouse's view is first.
+  // Until then, changes to the maze aren't drawn, since it's built from the
+  // maze as it is.
+  MazeView *m_truth;
+  QSharedPointer<MazeGeometry> m_geometry;
+  MazeView *getTruth();
+  void showTruth();
+  void refreshTruthWalls(int x, int y);
+  void refreshTruthDistance(int x, int y);
+
+  // The tiles of the fastest run (see MazeSolver), which are colored in the
+  // truth and recolored whenever its walls change
+  QVector<QPair<int, int>> m_truthPathTiles;
+  void refreshTruthPath();
+
   // ----- Colors -----
 
   void onColorButtonPressed();
@@ -89,10 +141,14 @@ class Window : public QMainWindow {
   static const QString CANCELED_STYLE_SHEET;
   static const QString FAILED_STYLE_SHEET;
   static const QString ERROR_STYLE_SHEET;
+  static const QString INVALID_EDIT_STYLE_SHEET;
 
   QTabWidget *m_mouseAlgoOutputTabWidget;
   QPlainTextEdit *m_buildOutput;
   QPlainTextEdit *m_runOutput;
+  LogPane *m_buildLog;
+  LogPane *m_runLog;
+  MetricsPlot *m_metricsPlot;  // of the algo's metric commands
 
   void cancelProcess(QProcess *process, QLabel *status);
   void cancelAllProcesses();
@@ -109,128 +165,147 @@ class Window : public QMainWindow {
 
   // ----- Algo run -----
 
+  // The algo's output is read and parsed on the channel's thread
   QPushButton *m_runButton;
-  QProcess *m_runProcess;
+  AlgoChannel *m_runChannel;
   QLabel *m_runStatus;
 
   void startRun();
   void cancelRun();
   void onRunExit(int exitCode, QProcess::ExitStatus exitStatus);
 
-  Mouse *m_mouse;
+  // The algo process's usage (see ProcessUtilities::getUsage) is sampled
+  // while it runs, and the last sample stays shown once it has exited
+  static const int USAGE_INTERVAL_MILLISECONDS;
+  QTimer *m_usageTimer;
+  QLineEdit *m_cpuTimeBox;
+  QLineEdit *m_peakMemoryBox;
+
+  void updateUsage();
+
+  // The view is kept (and reset) from one run to the next, until the maze
+  // changes
+  Simulation *m_simulation;
   MazeView *m_view;
   MouseGraphic *m_mouseGraphic;
 
+  void addMouseToMaze(QIODevice *output);
   void removeMouseFromMaze();
 
+  // Hands every mouse, the rivals' and then the algo's, to the map
+  void refreshMapMouseGraphics();
+
+  // ----- Rivals -----
+
+  // Other algos that run alongside the mouse algo, in the same maze, so that
+  // they can be compared head to head. Each one has its own mouse, drawn in
+  // its own color, its own stats, and its own view, which shares the truth's
+  // geometry and is only drawn in the grid. Rivals are started with the
+  // mouse algo, and keep running until they exit or the mouse is removed
+  // from the maze.
+  static const int MAX_RIVALS;
+  static const QVector<Color> RIVAL_COLORS;
+
+  struct Rival {
+    AlgoChannel *channel;  // null once the algo has exited
+    Simulation *simulation;
+    MazeView *view;
+    Stats *stats;
+    MouseGraphic *mouseGraphic;
+    QLabel *status;
+    QVector<QWidget *> widgets;  // the rival's row of the rivals tab
+  };
+
+  QToolButton *m_rivalsButton;
+  QMenu *m_rivalsMenu;  // a checkable action for each mouse algo
+  QGridLayout *m_rivalsLayout;
+  QVector<Rival *> m_rivals;
+
+  void refreshRivalsMenu();
+  void onRivalsMenuTriggered();
+  QStringList getRivalNames() const;
+  void startRivals();
+  void startRival(const QString &name, Color color, int row);
+  void onRivalExit(AlgoChannel *channel, int exitCode,
+                   QProcess::ExitStatus exitStatus);
+  void removeRivalsFromMaze();
+  Rival *getRival(AlgoChannel *channel) const;
+
+  // ----- Replay -----
+
+  // The log of the most recent run, or of the replay that was loaded. The
+  // player and timeline exist for as long as the replay's mouse does, so
+  // the replay can still be scrubbed once it's finished.
+  ReplayLog *m_replayLog;
+  ReplayPlayer *m_replayPlayer;
+  ReplayTimeline *m_replayTimeline;
+  bool m_isReplaying;  // whether the player hasn't reached the end
+  QPushButton *m_replayButton;
+  QPushButton *m_saveReplayButton;
+  QSlider *m_replaySlider;  // virtual time, in milliseconds
+
+  void onReplayButtonPressed();
+  void onSaveReplayButtonPressed();
+  void startReplay(ReplayLog *log);
+  void showReplayInProgress();
+  void onReplayPlayed(qint64 microseconds);
+  void onReplaySliderReleased();
+  void onReplaySeekFinished();
+  void onReplayFinished(int mismatches);
+  void finishReplay(const QString &status, const QString &styleSheet);
+
   // ----- Pause/reset ----
 
   bool m_isPaused;
-  bool m_wasReset;
   QPushButton *m_pauseButton;
   QPushButton *m_resetButton;
 
+  // The watchpoints of the mouse's simulation (see Watchpoints), which take
+  // effect as soon as they're edited; hitting one pauses every mouse, just
+  // as the pause button does
+  QLineEdit *m_watchpointsEdit;
+  Watchpoints m_watchpoints;
+
   void onPauseButtonPressed();
   void onResetButtonPressed();
+  void onWatchpointsEdited();
+  void onWatchpointHit(const QString &watchpoint);
+  void onResetAcknowledged();
 
   // ----- Communication -----
 
-  static const QString ACK;
-  static const QString CRASH;
-  static const QString INVALID;
-
-  // Buffers to hold incomplete output, only
+  // Buffer to hold incomplete output, only
   // process once terminated with a newline
-  QStringList m_logBuffer;
-  QStringList m_commandBuffer;
-  QStringList processText(QString text, QStringList *buffer);
-
-  QQueue<QString> m_commandQueue;
-  QTimer *m_commandQueueTimer;
-
-  void dispatchCommand(QString command);
-  QString executeCommand(QString command);
-  void processQueuedCommands();
+  LineBuffer m_logBuffer;
 
   // ----- Movement -----
 
   static const int SPEED_SLIDER_MAX;
   static const int SPEED_SLIDER_DEFAULT;
-  static const double MIN_PROGRESS_PER_SECOND;
-  static const double MAX_PROGRESS_PER_SECOND;
-  static const double MAX_SLEEP_SECONDS;
-
-  // TODO: upforgrabs
-  // Encapsulate this state in the mouse class
-
-  static const SemiPosition INITIAL_STARTING_POSITION;
-  static const SemiDirection INITIAL_STARTING_DIRECTION;
-
-  SemiPosition m_startingPosition;
-  SemiDirection m_startingDirection;
-  Movement m_movement;
-  bool m_doomedToCrash;  // if the requested movement will result in a crash
-  int m_halfStepsToMoveForward;  // the number of allowable half-steps for the
-                                 // movement
-  double m_movementProgress;
-  double m_movementStepSize;
-  QSlider *m_speedSlider;
 
-  double progressRequired(Movement movement);
-  void updateMouseProgress(double progress);
-  void scheduleMouseProgressUpdate();
-  bool isMoving();
+  QSlider *m_speedSlider;
+  QCheckBox *m_instantCheckBox;
+  QCheckBox *m_lockstepCheckBox;
+  QCheckBox *m_maxVisibleCheckBox;
+
+  // While nobody can see the window, i.e., it's hidden, minimized, or (on
+  // platforms that report it) covered, the map isn't drawn and movement is
+  // instant, whatever the checkbox says, so that unattended runs finish
+  // sooner; the checkbox's setting is restored once the window is seen again
+  bool m_isWatched;
+  void refreshWatched();
+  bool isInstant() const;
+
+  void onSpeedSliderChanged();
+  void onInstantCheckBoxChanged();
+  void onLockstepCheckBoxChanged();
+  void onMaxVisibleCheckBoxChanged();
+  double getProgressPerSecond() const;
 
   // ----- Scoreboard -----
   Stats *stats;
   void createStat(QString name, enum StatsEnum stat, int labelRow, int labelCol,
                   int valueRow, int valueCol, QGridLayout *layout);
-
-  // ----- API -----
-
-  int mazeWidth();
-  int mazeHeight();
-
-  // Is there a wall in front of the mouse N half-steps ahead of where it
-  // currently is? Zero means current position of the mouse.
-  bool wallFront(int halfStepsAhead);
-  bool wallRight(int halfStepsAhead);
-  bool wallLeft(int halfStepsAhead);
-  bool wallBack(int halfStepsAhead);
-  bool wallFrontRight(int halfStepsAhead);
-  bool wallFrontLeft(int halfStepsAhead);
-  bool wallBackRight(int halfStepsAhead);
-  bool wallBackLeft(int halfStepsAhead);
-
-  bool moveForward(int numHalfSteps);
-  void turn(Movement movement);
-
-  void setWall(int x, int y, QChar direction);
-  void clearWall(int x, int y, QChar direction);
-
-  void setColor(int x, int y, QChar color);
-  void clearColor(int x, int y);
-  void clearAllColor();
-
-  void setText(int x, int y, QString text);
-  void clearText(int x, int y);
-  void clearAllText();
-
-  bool wasReset();
-  void ackReset();
-
-  // ----- Helpers -----
-
-  QSet<QPair<int, int>> m_tilesWithColor;
-  QSet<QPair<int, int>> m_tilesWithText;
-
-  QString boolToString(bool value) const;
-  bool isWall(SemiPosition semiPos, SemiDirection semiDir) const;
-  bool isWall(SemiPosition semiPos, SemiDirection semiDir,
-              int halfStepsAhead) const;
-  bool isWithinMaze(int x, int y) const;
-  Wall getOpposingWall(Wall wall) const;
-  Coordinate getCoordinate(SemiPosition semiPos) const;
 };
 
 }  // namespace mms
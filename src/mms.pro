@@ -1,13 +1,17 @@
+QT += concurrent
 QT += core
 QT += gui
+QT += network
 QT += opengl
 QT += openglwidgets
+QT += qml
+QT += sql
 QT += widgets
 QT += xml
 
 TEMPLATE = app
 
-CONFIG += c++11
+CONFIG += c++17
 CONFIG += debug
 CONFIG += object_parallel_to_source
 CONFIG += qt
@@ -16,6 +20,28 @@ SOURCES += $$files(*.cpp, true)
 HEADERS += $$files(*.h, true)
 RESOURCES = resources.qrc
 
+# For AllocationCounter, e.g., qmake CONFIG+=count_allocations
+count_allocations: DEFINES += MMS_COUNT_ALLOCATIONS
+
+# For the zones of external profilers (see Profiler.h), e.g.,
+# qmake CONFIG+=tracy TRACY_DIR=/path/to/tracy, or
+# qmake CONFIG+=itt ITT_DIR=/path/to/ittapi
+tracy {
+  DEFINES += MMS_TRACY TRACY_ENABLE
+  INCLUDEPATH += $$TRACY_DIR/public
+  SOURCES += $$TRACY_DIR/public/TracyClient.cpp
+  unix: LIBS += -lpthread -ldl
+}
+itt {
+  DEFINES += MMS_ITT
+  INCLUDEPATH += $$ITT_DIR/include
+  LIBS += -L$$ITT_DIR/lib -littnotify
+  unix: LIBS += -ldl
+}
+
+# For ProcessUtilities::getUsage
+win32: LIBS += -lpsapi
+
 DESTDIR     = ../bin
 MOC_DIR     = ../build/moc
 OBJECTS_DIR = ../build/obj
@@ -1,33 +1,69 @@
 #pragma once
 
+#include <QtMath>
+
+#include "../AssertMacros.h"
+
 namespace mms {
 
+// See Distance.h
 class Angle {
  public:
-  Angle();
-  static Angle Radians(double radians);
-  static Angle Degrees(double degrees);
-
-  double getRadiansZeroTo2pi() const;
-  double getDegreesZeroTo360() const;
-  double getRadiansUnbounded() const;
-  double getDegreesUnbounded() const;
-  double getSin() const;
-  double getCos() const;
-
-  Angle operator*(double factor) const;
-  Angle operator/(double factor) const;
-  Angle operator+(const Angle &other) const;
-  Angle operator-(const Angle &other) const;
-  void operator+=(const Angle &other);
-  void operator-=(const Angle &other);
-  bool operator<(const Angle &other) const;
+  constexpr Angle() : m_radians(0.0) {}
+  static constexpr Angle Radians(double radians) { return Angle(radians); }
+  static constexpr Angle Degrees(double degrees) {
+    return Angle(2 * M_PI / 360.0 * degrees);
+  }
+
+  double getRadiansZeroTo2pi() const { return getRadians(true); }
+  double getDegreesZeroTo360() const { return getDegrees(true); }
+  double getRadiansUnbounded() const { return getRadians(false); }
+  double getDegreesUnbounded() const { return getDegrees(false); }
+  double getSin() const { return std::sin(getRadiansZeroTo2pi()); }
+  double getCos() const { return std::cos(getRadiansZeroTo2pi()); }
+
+  constexpr Angle operator*(double factor) const {
+    return Angle(m_radians * factor);
+  }
+  Angle operator/(double factor) const {
+    ASSERT_NE(factor, 0.0);
+    return Angle(m_radians / factor);
+  }
+  constexpr Angle operator+(const Angle &other) const {
+    return Angle(m_radians + other.m_radians);
+  }
+  constexpr Angle operator-(const Angle &other) const {
+    return Angle(m_radians - other.m_radians);
+  }
+  void operator+=(const Angle &other) { m_radians += other.m_radians; }
+  void operator-=(const Angle &other) { m_radians -= other.m_radians; }
+  bool operator<(const Angle &other) const {
+    return getRadiansZeroTo2pi() < other.getRadiansZeroTo2pi();
+  }
 
  private:
   double m_radians;
-  Angle(double radians);
-  double getRadians(bool zeroTo2pi) const;
-  double getDegrees(bool zeroTo360) const;
+  constexpr explicit Angle(double radians) : m_radians(radians) {}
+
+  double getRadians(bool zeroTo2pi) const {
+    double radians = m_radians;
+    if (zeroTo2pi) {
+      radians = std::fmod(radians, 2 * M_PI);
+      if (radians < 0) {
+        radians += 2 * M_PI;
+      }
+      if (2 * M_PI <= radians) {
+        radians -= 2 * M_PI;
+      }
+      ASSERT_LE(0, radians);
+      ASSERT_LT(radians, 2 * M_PI);
+    }
+    return radians;
+  }
+
+  double getDegrees(bool zeroTo360) const {
+    return 360.0 / (2 * M_PI) * getRadians(zeroTo360);
+  }
 };
 
 }  // namespace mms
@@ -1,34 +1,64 @@
 #pragma once
 
+#include <cmath>
+
+#include "../AssertMacros.h"
 #include "Angle.h"
 #include "Distance.h"
 
 namespace mms {
 
+// See Distance.h
 class Coordinate {
  public:
-  Coordinate();
-  static Coordinate Cartesian(const Distance &x, const Distance &y);
-  static Coordinate Polar(const Distance &rho, const Angle &theta);
-
-  Distance getX() const;
-  Distance getY() const;
-  Distance getRho() const;
-  Angle getTheta() const;
-
-  Coordinate operator*(double factor) const;
-  Coordinate operator/(double factor) const;
-  Coordinate operator+(const Coordinate &other) const;
-  Coordinate operator-(const Coordinate &other) const;
-  bool operator==(const Coordinate &other) const;
-  bool operator!=(const Coordinate &other) const;
-  bool operator<(const Coordinate &other) const;
-  void operator+=(const Coordinate &other);
+  constexpr Coordinate() : m_x(), m_y() {}
+  static constexpr Coordinate Cartesian(const Distance &x, const Distance &y) {
+    return Coordinate(x, y);
+  }
+  static Coordinate Polar(const Distance &rho, const Angle &theta) {
+    return Coordinate(rho * theta.getCos(), rho * theta.getSin());
+  }
+
+  constexpr Distance getX() const { return m_x; }
+  constexpr Distance getY() const { return m_y; }
+  Distance getRho() const {
+    return Distance::Meters(std::hypot(m_x.getMeters(), m_y.getMeters()));
+  }
+  Angle getTheta() const {
+    return Angle::Radians(std::atan2(m_y.getMeters(), m_x.getMeters()));
+  }
+
+  constexpr Coordinate operator*(double factor) const {
+    return Coordinate(m_x * factor, m_y * factor);
+  }
+  Coordinate operator/(double factor) const {
+    ASSERT_NE(factor, 0.0);
+    return Coordinate(m_x / factor, m_y / factor);
+  }
+  constexpr Coordinate operator+(const Coordinate &other) const {
+    return Coordinate(m_x + other.m_x, m_y + other.m_y);
+  }
+  constexpr Coordinate operator-(const Coordinate &other) const {
+    return Coordinate(m_x - other.m_x, m_y - other.m_y);
+  }
+  constexpr bool operator==(const Coordinate &other) const {
+    return m_x == other.m_x && m_y == other.m_y;
+  }
+  constexpr bool operator!=(const Coordinate &other) const {
+    return !operator==(other);
+  }
+  constexpr bool operator<(const Coordinate &other) const {
+    return m_x != other.m_x ? m_x < other.m_x : m_y < other.m_y;
+  }
+  void operator+=(const Coordinate &other) {
+    m_x += other.m_x;
+    m_y += other.m_y;
+  }
 
  private:
   Distance m_x;
   Distance m_y;
-  Coordinate(const Distance &x, const Distance &y);
+  constexpr Coordinate(const Distance &x, const Distance &y) : m_x(x), m_y(y) {}
 };
 
 }  // namespace mms
@@ -1,27 +1,49 @@
 #pragma once
 
+#include "../AssertMacros.h"
+
 namespace mms {
 
+// The unit types are header-only, trivially copyable wrappers of a double, so
+// that geometry code compiles down to plain floating point arithmetic
 class Distance {
  public:
-  Distance();
-  static Distance Meters(double meters);
+  constexpr Distance() : m_meters(0.0) {}
+  static constexpr Distance Meters(double meters) { return Distance(meters); }
 
-  double getMeters() const;
+  constexpr double getMeters() const { return m_meters; }
 
-  Distance operator*(double factor) const;
-  Distance operator/(double factor) const;
-  Distance operator+(const Distance &other) const;
-  Distance operator-(const Distance &other) const;
-  double operator/(const Distance &other) const;
-  bool operator==(const Distance &other) const;
-  bool operator!=(const Distance &other) const;
-  bool operator<(const Distance &other) const;
-  void operator+=(const Distance &other);
+  constexpr Distance operator*(double factor) const {
+    return Distance(m_meters * factor);
+  }
+  Distance operator/(double factor) const {
+    ASSERT_NE(factor, 0.0);
+    return Distance(m_meters / factor);
+  }
+  constexpr Distance operator+(const Distance &other) const {
+    return Distance(m_meters + other.m_meters);
+  }
+  constexpr Distance operator-(const Distance &other) const {
+    return Distance(m_meters - other.m_meters);
+  }
+  double operator/(const Distance &other) const {
+    ASSERT_NE(other.m_meters, 0.0);
+    return m_meters / other.m_meters;
+  }
+  constexpr bool operator==(const Distance &other) const {
+    return m_meters == other.m_meters;
+  }
+  constexpr bool operator!=(const Distance &other) const {
+    return !operator==(other);
+  }
+  constexpr bool operator<(const Distance &other) const {
+    return m_meters < other.m_meters;
+  }
+  void operator+=(const Distance &other) { m_meters += other.m_meters; }
 
  private:
   double m_meters;
-  Distance(double meters);
+  constexpr explicit Distance(double meters) : m_meters(meters) {}
 };
 
 }  // namespace mms
@@ -0,0 +1,490 @@
+/*
+ * Client for the mouse API (POSIX, C11 or C++11), so that algos in either
+ * language call functions instead of printing commands and parsing responses
+ * themselves.
+ *
+ * Everything is sent in the binary protocol (see the README): through shared
+ * memory if the simulator gave the algo a ring (see mms-shm.h), and through
+ * stdin/stdout, after the handshake, otherwise. Commands without a response,
+ * like mms_set_color, are buffered rather than written one at a time, and the
+ * buffer is only written once a command needs a response, once it fills up,
+ * on mms_flush, or at exit, so a burst of them costs a single write. The
+ * batched commands, like mms_set_colors, go further and send many cells as a
+ * single command.
+ *
+ * Usage:
+ *
+ *   #include "mms-client.h"
+ *
+ *   int main(void) {
+ *     if (mms_open() != 0) { return 1; }
+ *     while (!mms_wall_front()) {
+ *       mms_set_color(0, 0, 'G');
+ *       if (!mms_move_forward(1)) { break; }  // crashed
+ *     }
+ *     return 0;
+ *   }
+ *
+ * Since stdout carries the protocol, log to stderr instead. A buffered
+ * command takes effect once it's written, so call mms_flush before doing a
+ * lot of work without asking the simulator anything, e.g., to see the colors
+ * of a long search as it happens.
+ */
+
+#ifndef MMS_CLIENT_H
+#define MMS_CLIENT_H
+
+#include "mms-shm.h"
+#include "mms-protocol.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MMS_CLIENT_BUFFER_SIZE 4096
+
+/* The most cells that a single batched command can carry */
+#define MMS_CLIENT_MAX_CELLS 65535
+
+/* A cell of mms_set_walls (c is a direction) or mms_set_colors (a color) */
+typedef struct {
+  int x;
+  int y;
+  char c;
+} mms_cell;
+
+/* A cell of mms_set_texts; only the first 255 bytes of the text are sent */
+typedef struct {
+  int x;
+  int y;
+  const char *text;
+} mms_text_cell;
+
+/* A semi-position of mms_draw_path (see drawPath) */
+typedef struct {
+  int x;
+  int y;
+} mms_point;
+
+static struct {
+  int is_shm;
+  mms_shm shm;
+  unsigned char buffer[MMS_CLIENT_BUFFER_SIZE];
+  size_t size;
+} mms_client;
+
+/* ----- Transport ----- */
+
+static inline void mms_write_all(const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  if (mms_client.is_shm) {
+    mms_shm_write(&mms_client.shm, bytes, size);
+    return;
+  }
+  while (size > 0) {
+    ssize_t count = write(STDOUT_FILENO, bytes, size);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      exit(1);
+    }
+    bytes += count;
+    size -= (size_t)count;
+  }
+}
+
+static inline void mms_read_all(void *data, size_t size) {
+  unsigned char *bytes = (unsigned char *)data;
+  if (mms_client.is_shm) {
+    mms_shm_read_exact(&mms_client.shm, bytes, size);
+    return;
+  }
+  while (size > 0) {
+    ssize_t count = read(STDIN_FILENO, bytes, size);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      /* The simulator is gone, so there's nothing left to do */
+      exit(1);
+    }
+    bytes += count;
+    size -= (size_t)count;
+  }
+}
+
+/* Writes every buffered command */
+static inline void mms_flush(void) {
+  mms_write_all(mms_client.buffer, mms_client.size);
+  mms_client.size = 0;
+}
+
+static inline void mms_put(const void *data, size_t size) {
+  if (MMS_CLIENT_BUFFER_SIZE - mms_client.size < size) {
+    mms_flush();
+    if (MMS_CLIENT_BUFFER_SIZE < size) {
+      mms_write_all(data, size);
+      return;
+    }
+  }
+  memcpy(mms_client.buffer + mms_client.size, data, size);
+  mms_client.size += size;
+}
+
+static inline void mms_put_uint8(int value) {
+  unsigned char byte = (unsigned char)value;
+  mms_put(&byte, 1);
+}
+
+static inline void mms_put_uint16(int value) {
+  unsigned char bytes[2] = {(unsigned char)(value & 0xff),
+                            (unsigned char)((value >> 8) & 0xff)};
+  mms_put(bytes, 2);
+}
+
+/* A command's position arguments, and the char after them, if any */
+static inline void mms_put_cell(int x, int y, char c) {
+  mms_put_uint16(x);
+  mms_put_uint16(y);
+  mms_put_uint8(c);
+}
+
+/* Flushes, since the response can't arrive until the command is written */
+static inline void mms_receive(void *data, size_t size) {
+  mms_flush();
+  mms_read_all(data, size);
+}
+
+static inline int mms_receive_uint8(void) {
+  unsigned char byte;
+  mms_receive(&byte, 1);
+  return byte;
+}
+
+static inline int mms_receive_uint16(void) {
+  unsigned char bytes[2];
+  mms_receive(bytes, 2);
+  return bytes[0] | (bytes[1] << 8);
+}
+
+static inline void mms_flush_at_exit(void) { mms_flush(); }
+
+/* Chooses the transport, and switches to the binary protocol if it's
+ * stdin/stdout; must be called before any other function. Returns 0 on
+ * success. */
+static inline int mms_open(void) {
+  mms_client.size = 0;
+  mms_client.is_shm = 0;
+  if (getenv("MMS_SHM_PATH") != NULL) {
+    /* Shared memory always uses the binary protocol, with no handshake */
+    if (mms_shm_open(&mms_client.shm) != 0) {
+      return -1;
+    }
+    mms_client.is_shm = 1;
+  } else {
+    static const char request[] = "useBinaryProtocol\n";
+    mms_write_all(request, sizeof(request) - 1);
+    char line[8];
+    size_t length = 0;
+    for (;;) {
+      char c;
+      mms_read_all(&c, 1);
+      if (c == '\n') {
+        break;
+      }
+      if (length < sizeof(line) - 1) {
+        line[length] = c;
+        length += 1;
+      }
+    }
+    line[length] = '\0';
+    if (strcmp(line, "ack") != 0) {
+      return -1;
+    }
+  }
+  atexit(mms_flush_at_exit);
+  return 0;
+}
+
+/* ----- Commands ----- */
+
+static inline int mms_query(unsigned char opcode, int half_steps_away) {
+  mms_put_uint8(opcode);
+  mms_put_uint16(half_steps_away);
+  return mms_receive_uint8() == MMS_RESPONSE_TRUE;
+}
+
+/* Returns 1 if the mouse moved, or 0 if it crashed */
+static inline int mms_move(unsigned char opcode, int distance,
+                           int has_distance) {
+  mms_put_uint8(opcode);
+  if (has_distance) {
+    mms_put_uint16(distance);
+  }
+  return mms_receive_uint8() == MMS_RESPONSE_ACK;
+}
+
+static inline int mms_maze_width(void) {
+  mms_put_uint8(MMS_OP_MAZE_WIDTH);
+  return mms_receive_uint16();
+}
+
+static inline int mms_maze_height(void) {
+  mms_put_uint8(MMS_OP_MAZE_HEIGHT);
+  return mms_receive_uint16();
+}
+
+static inline int mms_wall_front(void) {
+  return mms_query(MMS_OP_WALL_FRONT, 1);
+}
+static inline int mms_wall_right(void) {
+  return mms_query(MMS_OP_WALL_RIGHT, 1);
+}
+static inline int mms_wall_left(void) { return mms_query(MMS_OP_WALL_LEFT, 1); }
+static inline int mms_wall_back(void) { return mms_query(MMS_OP_WALL_BACK, 1); }
+
+/* As above, for the wall the given number of half-steps away (see wallFront),
+ * and for the diagonals */
+static inline int mms_wall_front_at(int n) {
+  return mms_query(MMS_OP_WALL_FRONT, n);
+}
+static inline int mms_wall_right_at(int n) {
+  return mms_query(MMS_OP_WALL_RIGHT, n);
+}
+static inline int mms_wall_left_at(int n) {
+  return mms_query(MMS_OP_WALL_LEFT, n);
+}
+static inline int mms_wall_back_at(int n) {
+  return mms_query(MMS_OP_WALL_BACK, n);
+}
+static inline int mms_wall_front_right(int n) {
+  return mms_query(MMS_OP_WALL_FRONT_RIGHT, n);
+}
+static inline int mms_wall_front_left(int n) {
+  return mms_query(MMS_OP_WALL_FRONT_LEFT, n);
+}
+static inline int mms_wall_back_right(int n) {
+  return mms_query(MMS_OP_WALL_BACK_RIGHT, n);
+}
+static inline int mms_wall_back_left(int n) {
+  return mms_query(MMS_OP_WALL_BACK_LEFT, n);
+}
+
+/* Every wall around the mouse at once, as a bitmask (see walls) */
+static inline int mms_walls(int half_steps_away) {
+  mms_put_uint8(MMS_OP_WALLS);
+  mms_put_uint16(half_steps_away);
+  return mms_receive_uint16();
+}
+
+/* The distance to the nearest wall in each of the eight directions */
+static inline void mms_sensor_scan(int distances[8]) {
+  unsigned char bytes[16];
+  mms_put_uint8(MMS_OP_SENSOR_SCAN);
+  mms_receive(bytes, sizeof(bytes));
+  for (int i = 0; i < 8; i += 1) {
+    distances[i] = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+  }
+}
+
+static inline int mms_move_forward(int distance) {
+  return mms_move(MMS_OP_MOVE_FORWARD, distance, 1);
+}
+static inline int mms_move_forward_half(int num_half_steps) {
+  return mms_move(MMS_OP_MOVE_FORWARD_HALF, num_half_steps, 1);
+}
+static inline int mms_turn_right(void) {
+  return mms_move(MMS_OP_TURN_RIGHT_90, 0, 0);
+}
+static inline int mms_turn_left(void) {
+  return mms_move(MMS_OP_TURN_LEFT_90, 0, 0);
+}
+static inline int mms_turn_right_45(void) {
+  return mms_move(MMS_OP_TURN_RIGHT_45, 0, 0);
+}
+static inline int mms_turn_left_45(void) {
+  return mms_move(MMS_OP_TURN_LEFT_45, 0, 0);
+}
+
+static inline void mms_set_wall(int x, int y, char direction) {
+  mms_put_uint8(MMS_OP_SET_WALL);
+  mms_put_cell(x, y, direction);
+}
+
+static inline void mms_clear_wall(int x, int y, char direction) {
+  mms_put_uint8(MMS_OP_CLEAR_WALL);
+  mms_put_cell(x, y, direction);
+}
+
+static inline void mms_set_color(int x, int y, char color) {
+  mms_put_uint8(MMS_OP_SET_COLOR);
+  mms_put_cell(x, y, color);
+}
+
+static inline void mms_clear_color(int x, int y) {
+  mms_put_uint8(MMS_OP_CLEAR_COLOR);
+  mms_put_uint16(x);
+  mms_put_uint16(y);
+}
+
+static inline void mms_clear_all_color(void) {
+  mms_put_uint8(MMS_OP_CLEAR_ALL_COLOR);
+}
+
+static inline void mms_put_text(const char *text) {
+  size_t length = strlen(text);
+  if (255 < length) {
+    length = 255;
+  }
+  mms_put_uint8((int)length);
+  mms_put(text, length);
+}
+
+static inline void mms_set_text(int x, int y, const char *text) {
+  mms_put_uint8(MMS_OP_SET_TEXT);
+  mms_put_uint16(x);
+  mms_put_uint16(y);
+  mms_put_text(text);
+}
+
+static inline void mms_clear_text(int x, int y) {
+  mms_put_uint8(MMS_OP_CLEAR_TEXT);
+  mms_put_uint16(x);
+  mms_put_uint16(y);
+}
+
+static inline void mms_clear_all_text(void) {
+  mms_put_uint8(MMS_OP_CLEAR_ALL_TEXT);
+}
+
+/* Any number of cells, split into as few commands as they fit in */
+static inline void mms_put_cells(unsigned char opcode,
+                                 const mms_cell *cells, int count) {
+  while (count > 0) {
+    int batch = count < MMS_CLIENT_MAX_CELLS ? count : MMS_CLIENT_MAX_CELLS;
+    mms_put_uint8(opcode);
+    mms_put_uint16(batch);
+    for (int i = 0; i < batch; i += 1) {
+      mms_put_cell(cells[i].x, cells[i].y, cells[i].c);
+    }
+    cells += batch;
+    count -= batch;
+  }
+}
+
+static inline void mms_set_walls(const mms_cell *cells, int count) {
+  mms_put_cells(MMS_OP_SET_WALLS, cells, count);
+}
+
+static inline void mms_set_colors(const mms_cell *cells, int count) {
+  mms_put_cells(MMS_OP_SET_COLORS, cells, count);
+}
+
+static inline void mms_set_texts(const mms_text_cell *cells, int count) {
+  while (count > 0) {
+    int batch = count < MMS_CLIENT_MAX_CELLS ? count : MMS_CLIENT_MAX_CELLS;
+    mms_put_uint8(MMS_OP_SET_TEXTS);
+    mms_put_uint16(batch);
+    for (int i = 0; i < batch; i += 1) {
+      mms_put_uint16(cells[i].x);
+      mms_put_uint16(cells[i].y);
+      mms_put_text(cells[i].text);
+    }
+    cells += batch;
+    count -= batch;
+  }
+}
+
+/* Replaces any path drawn before, so at most MMS_CLIENT_MAX_CELLS points */
+static inline void mms_draw_path(char color, const mms_point *points,
+                                 int count) {
+  if (MMS_CLIENT_MAX_CELLS < count) {
+    count = MMS_CLIENT_MAX_CELLS;
+  }
+  mms_put_uint8(MMS_OP_DRAW_PATH);
+  mms_put_uint8(color);
+  mms_put_uint16(count);
+  for (int i = 0; i < count; i += 1) {
+    mms_put_uint16(points[i].x);
+    mms_put_uint16(points[i].y);
+  }
+}
+
+static inline void mms_clear_path(void) { mms_put_uint8(MMS_OP_CLEAR_PATH); }
+
+/* A color for every cell, column by column (see setColorGrid) */
+static inline void mms_set_color_grid(const char *colors, int count) {
+  mms_put_uint8(MMS_OP_SET_COLOR_GRID);
+  mms_put_uint16(count);
+  mms_put(colors, (size_t)count);
+}
+
+/* A field of the given width for every cell, column by column (see
+ * setTextGrid), so width * count chars in all */
+static inline void mms_set_text_grid(int width, const char *texts, int count) {
+  mms_put_uint8(MMS_OP_SET_TEXT_GRID);
+  mms_put_uint8(width);
+  mms_put_uint16(count);
+  mms_put(texts, (size_t)width * (size_t)count);
+}
+
+/* A sample of one of the algo's own metrics (see metric), e.g., the time its
+ * planner took; nothing is sent back */
+static inline void mms_metric(const char *name, double value) {
+  uint64_t bits;
+  unsigned char bytes[8];
+  memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 8; i += 1) {
+    bytes[i] = (unsigned char)(bits >> (8 * i));
+  }
+  mms_put_uint8(MMS_OP_METRIC);
+  mms_put(bytes, sizeof(bytes));
+  mms_put_text(name);
+}
+
+static inline int mms_was_reset(void) {
+  mms_put_uint8(MMS_OP_WAS_RESET);
+  return mms_receive_uint8() == MMS_RESPONSE_TRUE;
+}
+
+static inline void mms_ack_reset(void) {
+  mms_put_uint8(MMS_OP_ACK_RESET);
+  mms_receive_uint8();
+}
+
+/* The value of the stat, or -1 if it has none yet */
+static inline float mms_get_stat(mms_stat stat) {
+  unsigned char bytes[4];
+  mms_put_uint8(MMS_OP_GET_STAT);
+  mms_put_uint8(stat);
+  mms_receive(bytes, sizeof(bytes));
+  uint32_t bits = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+                  ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/* Returns 1 once the next maze has started, or 0 if there are no more */
+static inline int mms_next_maze(void) {
+  mms_put_uint8(MMS_OP_NEXT_MAZE);
+  return mms_receive_uint8() == MMS_RESPONSE_TRUE;
+}
+
+static inline int mms_was_resumed(void) {
+  mms_put_uint8(MMS_OP_WAS_RESUMED);
+  return mms_receive_uint8() == MMS_RESPONSE_TRUE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MMS_CLIENT_H */
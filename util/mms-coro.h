@@ -0,0 +1,252 @@
+/*
+ * Coroutine interface for in-process mouse algos (C++20).
+ *
+ * The algo is a coroutine that suspends at every movement instead of blocking
+ * in it: "co_await mouse.moveForward(3)" hands the movement to the simulator
+ * and only returns once the simulator has completed it, with whether the
+ * mouse moved. There's no thread per algo, so the simulator can interleave
+ * many runs on a few threads, a few movements at a time. Queries and
+ * annotations are answered right away, as for mms_plugin_run.
+ *
+ * Usage:
+ *
+ *   #include "mms-coro.h"
+ *
+ *   mms::Algo run(mms::Mouse &mouse) {
+ *     while (!mouse.stopped()) {
+ *       if (!mouse.wallLeft()) {
+ *         co_await mouse.turnLeft();
+ *       }
+ *       while (mouse.wallFront()) {
+ *         co_await mouse.turnRight();
+ *       }
+ *       co_await mouse.moveForward();
+ *     }
+ *   }
+ *
+ *   MMS_CORO_PLUGIN(run)
+ *
+ * Build it with, e.g., "c++ -std=c++20 -shared -fPIC -o libalgo.so algo.cpp",
+ * and load it with --plugin. The macro exports the functions that the
+ * simulator resumes the algo with (see mms-plugin.h), so the plugin doesn't
+ * export mms_plugin_run. Each run has its own coroutine and mouse, but still
+ * shares any globals with the runs in progress alongside it, which may be on
+ * other threads; a run is only ever resumed by one thread at a time, though
+ * not always by the same one.
+ *
+ * GCC 12 miscompiles a negated co_await in a condition within a while loop,
+ * e.g., "if (!co_await mouse.moveForward())", so assign the result first.
+ */
+
+#ifndef MMS_CORO_H
+#define MMS_CORO_H
+
+#include <coroutine>
+#include <exception>
+
+#include "mms-plugin.h"
+
+namespace mms {
+
+/* The coroutine of a single run; its body is the algo */
+class Algo {
+ public:
+  struct promise_type {
+    mms_move move = {MMS_MOVE_NONE, 0}; /* the movement being awaited */
+    bool moved = false;                 /* and whether it happened */
+
+    Algo get_return_object() {
+      return Algo(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  Algo(Algo &&other) noexcept : m_handle(other.m_handle) {
+    other.m_handle = nullptr;
+  }
+  Algo(const Algo &) = delete;
+  Algo &operator=(const Algo &) = delete;
+  ~Algo() {
+    if (m_handle) {
+      m_handle.destroy();
+    }
+  }
+
+  /* Runs the algo until its next movement, given whether the last one
+   * happened; returns MMS_MOVE_NONE once the algo has returned */
+  mms_move resume(bool moved) {
+    promise_type &promise = m_handle.promise();
+    promise.move = {MMS_MOVE_NONE, 0};
+    promise.moved = moved;
+    if (!m_handle.done()) {
+      m_handle.resume();
+    }
+    return promise.move;
+  }
+
+ private:
+  explicit Algo(std::coroutine_handle<promise_type> handle)
+      : m_handle(handle) {}
+
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+/* Awaiting a movement suspends the algo until the simulator completes it */
+class Movement {
+ public:
+  Movement(int movement, int distance) : m_move{movement, distance} {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<Algo::promise_type> handle) {
+    m_promise = &handle.promise();
+    m_promise->move = m_move;
+  }
+
+  /* False if the mouse crashed */
+  bool await_resume() const { return m_promise->moved; }
+
+ private:
+  mms_move m_move;
+  Algo::promise_type *m_promise = nullptr;
+};
+
+/* The API of a single run (see mms-plugin.h), minus the blocking movements */
+class Mouse {
+ public:
+  explicit Mouse(const mms_api *api) : m_api(api) {}
+
+  /* True once the run has timed out; return soon */
+  bool stopped() const { return m_api->stopped(m_api->context) != 0; }
+
+  int mazeWidth() const { return m_api->maze_width(m_api->context); }
+  int mazeHeight() const { return m_api->maze_height(m_api->context); }
+
+  bool wallFront(int halfSteps = 1) const {
+    return m_api->wall_front(m_api->context, halfSteps) != 0;
+  }
+  bool wallRight(int halfSteps = 1) const {
+    return m_api->wall_right(m_api->context, halfSteps) != 0;
+  }
+  bool wallLeft(int halfSteps = 1) const {
+    return m_api->wall_left(m_api->context, halfSteps) != 0;
+  }
+  bool wallBack(int halfSteps = 1) const {
+    return m_api->wall_back(m_api->context, halfSteps) != 0;
+  }
+  bool wallFrontRight(int halfSteps = 1) const {
+    return m_api->wall_front_right(m_api->context, halfSteps) != 0;
+  }
+  bool wallFrontLeft(int halfSteps = 1) const {
+    return m_api->wall_front_left(m_api->context, halfSteps) != 0;
+  }
+  bool wallBackRight(int halfSteps = 1) const {
+    return m_api->wall_back_right(m_api->context, halfSteps) != 0;
+  }
+  bool wallBackLeft(int halfSteps = 1) const {
+    return m_api->wall_back_left(m_api->context, halfSteps) != 0;
+  }
+  int walls(int halfSteps = 1) const {
+    return m_api->walls(m_api->context, halfSteps);
+  }
+
+  Movement moveForward(int distance = 1) const {
+    return Movement(MMS_MOVE_FORWARD, distance);
+  }
+  Movement moveForwardHalf(int numHalfSteps = 1) const {
+    return Movement(MMS_MOVE_FORWARD_HALF, numHalfSteps);
+  }
+  Movement turnRight() const { return Movement(MMS_MOVE_TURN_RIGHT, 0); }
+  Movement turnLeft() const { return Movement(MMS_MOVE_TURN_LEFT, 0); }
+  Movement turnRight45() const { return Movement(MMS_MOVE_TURN_RIGHT_45, 0); }
+  Movement turnLeft45() const { return Movement(MMS_MOVE_TURN_LEFT_45, 0); }
+
+  void setWall(int x, int y, char direction) const {
+    m_api->set_wall(m_api->context, x, y, direction);
+  }
+  void clearWall(int x, int y, char direction) const {
+    m_api->clear_wall(m_api->context, x, y, direction);
+  }
+  void setColor(int x, int y, char color) const {
+    m_api->set_color(m_api->context, x, y, color);
+  }
+  void clearColor(int x, int y) const {
+    m_api->clear_color(m_api->context, x, y);
+  }
+  void clearAllColor() const { m_api->clear_all_color(m_api->context); }
+  void setText(int x, int y, const char *text) const {
+    m_api->set_text(m_api->context, x, y, text);
+  }
+  void clearText(int x, int y) const {
+    m_api->clear_text(m_api->context, x, y);
+  }
+  void clearAllText() const { m_api->clear_all_text(m_api->context); }
+  void drawPath(char color, const int *points, int count) const {
+    m_api->draw_path(m_api->context, color, points, count);
+  }
+  void clearPath() const { m_api->clear_path(m_api->context); }
+  void setColorGrid(const char *colors) const {
+    m_api->set_color_grid(m_api->context, colors);
+  }
+  void setTextGrid(int fieldWidth, const char *texts) const {
+    m_api->set_text_grid(m_api->context, fieldWidth, texts);
+  }
+
+  bool wasReset() const { return m_api->was_reset(m_api->context) != 0; }
+  void ackReset() const { m_api->ack_reset(m_api->context); }
+
+  double getStat(const char *name) const {
+    return m_api->get_stat(m_api->context, name);
+  }
+
+  void metric(const char *name, double value) const {
+    m_api->metric(m_api->context, name, value);
+  }
+
+ private:
+  const mms_api *m_api;
+};
+
+namespace detail {
+
+/* A run's mouse, and its coroutine, which refers to the mouse */
+struct Instance {
+  Mouse mouse;
+  Algo algo;
+
+  Instance(const mms_api *api, Algo (*function)(Mouse &))
+      : mouse(api), algo(function(mouse)) {}
+};
+
+inline void *start(const mms_api *api, Algo (*function)(Mouse &)) {
+  return new Instance(api, function);
+}
+
+inline mms_move resume(void *instance, int moved) {
+  return static_cast<Instance *>(instance)->algo.resume(moved != 0);
+}
+
+inline void destroy(void *instance) {
+  delete static_cast<Instance *>(instance);
+}
+
+}  // namespace detail
+
+}  // namespace mms
+
+/* Exports the function, of type mms::Algo(mms::Mouse &), as the algo */
+#define MMS_CORO_PLUGIN(function)                                 \
+  MMS_PLUGIN_EXPORT void *mms_plugin_start(const mms_api *api) {  \
+    return mms::detail::start(api, &function);                    \
+  }                                                               \
+  MMS_PLUGIN_EXPORT mms_move mms_plugin_resume(void *instance,    \
+                                               int moved) {       \
+    return mms::detail::resume(instance, moved);                  \
+  }                                                               \
+  MMS_PLUGIN_EXPORT void mms_plugin_destroy(void *instance) {     \
+    mms::detail::destroy(instance);                               \
+  }
+
+#endif /* MMS_CORO_H */
@@ -0,0 +1,294 @@
+/*
+ * A synthetic mouse algo that floods the simulator with commands, to measure
+ * the throughput and latency of the whole algo <-> simulator loop (POSIX,
+ * C11). It issues a fixed number of commands, drawn in a repeatable order
+ * from a weighted mix of wall queries, movements, setColor, and setText, then
+ * writes a report and exits.
+ *
+ * Usage:
+ *
+ *   mms-flood [-n COUNT] [-m WALL,MOVE,COLOR,TEXT] [-p text|binary|shm]
+ *             [-o FILE]
+ *
+ *   -n  the number of commands to send (default 100000)
+ *   -m  the relative weights of each kind of command (default 4,1,2,1)
+ *   -p  the protocol: text, binary (after the handshake), or shm (binary via
+ *       shared memory, for when the simulator is run with --shared-memory)
+ *   -o  where to write the report (default stderr, which is discarded in
+ *       headless mode)
+ *
+ * Movements are a moveForward if the wall in front is open and a turnRight
+ * otherwise, so the mouse never crashes. Every command that has a response
+ * is timed from the write of the command to the read of the response; the
+ * others are buffered, as a real algo's would be. Movements only complete
+ * immediately if the simulator is in instant mode (always true in headless
+ * mode), so use that to measure the transport rather than the animation.
+ *
+ * Build it with "cc -O2 -std=c11 -o mms-flood mms-flood.c", or see
+ * mms-flood.sh, which builds it and runs it against each transport.
+ */
+
+#include "mms-shm.h"
+#include "mms-protocol.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef enum { PROTOCOL_TEXT, PROTOCOL_BINARY, PROTOCOL_SHM } protocol;
+
+static protocol flood_protocol = PROTOCOL_TEXT;
+static mms_shm flood_shm;
+
+static long num_commands;
+static double *latencies;
+static long num_latencies;
+
+static double now_seconds(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/* ----- Transport ----- */
+
+static void send_bytes(const void *data, size_t size) {
+  if (flood_protocol == PROTOCOL_SHM) {
+    mms_shm_write(&flood_shm, data, size);
+  } else {
+    fwrite(data, 1, size, stdout);
+  }
+}
+
+static void receive_bytes(void *data, size_t size) {
+  if (flood_protocol == PROTOCOL_SHM) {
+    mms_shm_read_exact(&flood_shm, data, size);
+  } else {
+    fflush(stdout);
+    if (fread(data, 1, size, stdin) != size) {
+      exit(1);
+    }
+  }
+}
+
+static void receive_line(char *line, int size) {
+  fflush(stdout);
+  if (fgets(line, size, stdin) == NULL) {
+    exit(1);
+  }
+}
+
+/* Sends a command that has a response and times the round trip */
+static void round_trip(const char *text, const unsigned char *binary,
+                       size_t binary_size, void *response,
+                       size_t response_size) {
+  double start = now_seconds();
+  num_commands += 1;
+  if (flood_protocol == PROTOCOL_TEXT) {
+    send_bytes(text, strlen(text));
+    receive_line((char *)response, (int)response_size);
+  } else {
+    send_bytes(binary, binary_size);
+    receive_bytes(response, response_size);
+  }
+  latencies[num_latencies] = now_seconds() - start;
+  num_latencies += 1;
+}
+
+static void put_uint16(unsigned char *bytes, int value) {
+  bytes[0] = value & 0xff;
+  bytes[1] = (value >> 8) & 0xff;
+}
+
+/* ----- Commands ----- */
+
+/* mazeWidth or mazeHeight */
+static int maze_size(const char *text, unsigned char command) {
+  char line[32];
+  if (flood_protocol == PROTOCOL_TEXT) {
+    round_trip(text, NULL, 0, line, sizeof(line));
+    return atoi(line);
+  }
+  unsigned char response[2];
+  round_trip(NULL, &command, 1, response, sizeof(response));
+  return response[0] | (response[1] << 8);
+}
+
+static int wall_front(void) {
+  char line[32];
+  if (flood_protocol == PROTOCOL_TEXT) {
+    round_trip("wallFront\n", NULL, 0, line, sizeof(line));
+    return strncmp(line, "true", 4) == 0;
+  }
+  unsigned char command[3] = {MMS_OP_WALL_FRONT, 0x01, 0x00};
+  unsigned char response;
+  round_trip(NULL, command, sizeof(command), &response, 1);
+  return response == MMS_RESPONSE_TRUE;
+}
+
+static void move(void) {
+  char line[32];
+  unsigned char response;
+  if (!wall_front()) {
+    unsigned char command[3] = {MMS_OP_MOVE_FORWARD, 0x01, 0x00};
+    round_trip("moveForward\n", command, sizeof(command),
+               flood_protocol == PROTOCOL_TEXT ? (void *)line : &response,
+               flood_protocol == PROTOCOL_TEXT ? sizeof(line) : 1);
+  } else {
+    unsigned char command = MMS_OP_TURN_RIGHT_90;
+    round_trip("turnRight\n", &command, 1,
+               flood_protocol == PROTOCOL_TEXT ? (void *)line : &response,
+               flood_protocol == PROTOCOL_TEXT ? sizeof(line) : 1);
+  }
+}
+
+static void set_color(int x, int y) {
+  num_commands += 1;
+  if (flood_protocol == PROTOCOL_TEXT) {
+    char line[64];
+    int size = snprintf(line, sizeof(line), "setColor %d %d G\n", x, y);
+    send_bytes(line, size);
+    return;
+  }
+  unsigned char command[6] = {MMS_OP_SET_COLOR};
+  put_uint16(command + 1, x);
+  put_uint16(command + 3, y);
+  command[5] = 'G';
+  send_bytes(command, sizeof(command));
+}
+
+static void set_text(int x, int y) {
+  num_commands += 1;
+  if (flood_protocol == PROTOCOL_TEXT) {
+    char line[64];
+    int size = snprintf(line, sizeof(line), "setText %d %d %d\n", x, y, x);
+    send_bytes(line, size);
+    return;
+  }
+  char text[8];
+  int length = snprintf(text, sizeof(text), "%d", x);
+  unsigned char command[6 + sizeof(text)] = {MMS_OP_SET_TEXT};
+  put_uint16(command + 1, x);
+  put_uint16(command + 3, y);
+  command[5] = (unsigned char)length;
+  memcpy(command + 6, text, length);
+  send_bytes(command, 6 + length);
+}
+
+/* ----- Report ----- */
+
+static int compare_doubles(const void *a, const void *b) {
+  double difference = *(const double *)a - *(const double *)b;
+  return (difference > 0) - (difference < 0);
+}
+
+static double percentile(double fraction) {
+  if (num_latencies == 0) {
+    return 0.0;
+  }
+  return latencies[(long)(fraction * (num_latencies - 1))];
+}
+
+static void report(FILE *file, const char *protocol_name, double seconds) {
+  qsort(latencies, num_latencies, sizeof(double), compare_doubles);
+  fprintf(file, "protocol %s\n", protocol_name);
+  fprintf(file, "commands %ld\n", num_commands);
+  fprintf(file, "seconds %.3f\n", seconds);
+  fprintf(file, "commands_per_second %.0f\n", num_commands / seconds);
+  fprintf(file, "round_trips %ld\n", num_latencies);
+  fprintf(file, "latency_us_p50 %.1f\n", percentile(0.50) * 1e6);
+  fprintf(file, "latency_us_p90 %.1f\n", percentile(0.90) * 1e6);
+  fprintf(file, "latency_us_p99 %.1f\n", percentile(0.99) * 1e6);
+  fprintf(file, "latency_us_max %.1f\n", percentile(1.0) * 1e6);
+}
+
+int main(int argc, char *argv[]) {
+  long count = 100000;
+  int weights[4] = {4, 1, 2, 1};
+  const char *protocol_name = "text";
+  const char *output = NULL;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-n") == 0) {
+      count = atol(argv[i + 1]);
+    } else if (strcmp(argv[i], "-m") == 0) {
+      if (sscanf(argv[i + 1], "%d,%d,%d,%d", &weights[0], &weights[1],
+                 &weights[2], &weights[3]) != 4) {
+        fprintf(stderr, "Invalid mix \"%s\"\n", argv[i + 1]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-p") == 0) {
+      protocol_name = argv[i + 1];
+    } else if (strcmp(argv[i], "-o") == 0) {
+      output = argv[i + 1];
+    }
+  }
+  int total_weight = weights[0] + weights[1] + weights[2] + weights[3];
+  if (count <= 0 || total_weight <= 0) {
+    fprintf(stderr, "Nothing to send\n");
+    return 1;
+  }
+
+  /* Full buffering, so that commands without a response are batched */
+  static char buffer[1 << 16];
+  setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+  if (strcmp(protocol_name, "text") == 0) {
+    flood_protocol = PROTOCOL_TEXT;
+  } else if (strcmp(protocol_name, "binary") == 0) {
+    char line[32];
+    fputs("useBinaryProtocol\n", stdout);
+    receive_line(line, sizeof(line));
+    flood_protocol = PROTOCOL_BINARY;
+  } else if (strcmp(protocol_name, "shm") == 0) {
+    if (mms_shm_open(&flood_shm) != 0) {
+      fprintf(stderr, "Could not open shared memory (see --shared-memory)\n");
+      return 1;
+    }
+    flood_protocol = PROTOCOL_SHM;
+  } else {
+    fprintf(stderr, "Unknown protocol \"%s\"\n", protocol_name);
+    return 1;
+  }
+
+  /* Movements also query the wall in front, so there are at most two round
+   * trips per command, plus the three outside of the loop */
+  latencies = malloc(sizeof(double) * (2 * count + 3));
+  if (latencies == NULL) {
+    return 1;
+  }
+
+  double start = now_seconds();
+  int width = maze_size("mazeWidth\n", MMS_OP_MAZE_WIDTH);
+  int height = maze_size("mazeHeight\n", MMS_OP_MAZE_HEIGHT);
+  long tiles = (long)width * height;
+  unsigned state = 12345;
+  for (long i = 0; i < count; i += 1) {
+    /* A fixed-seed LCG, so that every run sends the same commands */
+    state = state * 1103515245u + 12345u;
+    int pick = (int)((state >> 16) % (unsigned)total_weight);
+    int x = (int)(i % tiles % width);
+    int y = (int)(i % tiles / width);
+    if (pick < weights[0]) {
+      wall_front();
+    } else if (pick < weights[0] + weights[1]) {
+      move();
+    } else if (pick < weights[0] + weights[1] + weights[2]) {
+      set_color(x, y);
+    } else {
+      set_text(x, y);
+    }
+  }
+
+  /* Wait for everything that was buffered to be processed */
+  wall_front();
+  double seconds = now_seconds() - start;
+
+  FILE *file = output == NULL ? stderr : fopen(output, "w");
+  if (file == NULL) {
+    return 1;
+  }
+  report(file, protocol_name, seconds);
+  if (file != stderr) {
+    fclose(file);
+  }
+  return 0;
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Builds mms-flood and runs it headlessly against a maze once per transport,
+# printing the throughput and latency of each, e.g.:
+#
+#   util/mms-flood.sh [maze] [mms-flood options...]
+#
+# The simulator is found at ../bin/mms (relative to the repo, where qmake
+# puts it), unless MMS is set.
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MMS=${MMS:-$ROOT/../bin/mms}
+MAZE=${1:-$ROOT/src/resources/mazes/example1.num}
+if [ $# -gt 0 ]; then
+  shift
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cc -O2 -std=c11 -o "$WORK/mms-flood" "$ROOT/util/mms-flood.c" || exit 1
+
+for protocol in text binary shm; do
+  flags=
+  if [ "$protocol" = shm ]; then
+    flags=--shared-memory
+  fi
+  # The algo never solves the maze, so the run's status doesn't matter
+  "$MMS" --headless $flags --directory "$WORK" \
+    --run-command "$WORK/mms-flood -p $protocol -o report-$protocol.txt $*" \
+    "$MAZE" > /dev/null
+  if [ -f "$WORK/report-$protocol.txt" ]; then
+    cat "$WORK/report-$protocol.txt"
+  else
+    echo "protocol $protocol failed"
+  fi
+  echo
+done
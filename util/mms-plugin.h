@@ -0,0 +1,178 @@
+/*
+ * Interface for in-process mouse algos (C99 or C++).
+ *
+ * When the simulator is run with --plugin, the algo is loaded as a shared
+ * library rather than started as a process. The library must export
+ * mms_plugin_run, which is called once per maze with a table of functions
+ * that mirror the text API (see the README). Each function is answered
+ * directly by the simulator, so there's no process startup or pipe I/O.
+ *
+ * Usage:
+ *
+ *   #include "mms-plugin.h"
+ *
+ *   MMS_PLUGIN_EXPORT void mms_plugin_run(const mms_api *api) {
+ *     while (!api->stopped(api->context)) {
+ *       if (!api->wall_left(api->context, 1)) {
+ *         api->turn_left(api->context);
+ *       }
+ *       while (api->wall_front(api->context, 1)) {
+ *         api->turn_right(api->context);
+ *       }
+ *       api->move_forward(api->context, 1);
+ *     }
+ *   }
+ *
+ * Build it with, e.g., "cc -shared -fPIC -o libalgo.so algo.c". Runs happen
+ * one at a time, but a fresh call is made for every maze, so any global state
+ * must be reset at the start of mms_plugin_run. The simulator's stdout may be
+ * the CSV output, so log to stderr. Algos that suspend instead of blocking
+ * (see below) can have many runs in progress at once, and batched algos (see
+ * further below) can step many mice at once.
+ */
+
+#ifndef MMS_PLUGIN_H
+#define MMS_PLUGIN_H
+
+#ifdef __cplusplus
+#define MMS_PLUGIN_EXTERN extern "C"
+#else
+#define MMS_PLUGIN_EXTERN
+#endif
+
+#ifdef _WIN32
+#define MMS_PLUGIN_EXPORT MMS_PLUGIN_EXTERN __declspec(dllexport)
+#else
+#define MMS_PLUGIN_EXPORT \
+  MMS_PLUGIN_EXTERN __attribute__((visibility("default")))
+#endif
+
+/* Incremented whenever the table changes incompatibly */
+#define MMS_PLUGIN_VERSION 1
+
+/*
+ * Booleans are returned as nonzero for true. Counts are the same as in the
+ * text API, e.g., wall_front(context, 1) checks the wall directly in front
+ * of the mouse. Movements return zero if the mouse crashed.
+ */
+typedef struct {
+  int version;
+  void *context; /* pass as the first argument to every function */
+
+  /* Nonzero once the run has timed out; return from mms_plugin_run soon */
+  int (*stopped)(void *context);
+
+  int (*maze_width)(void *context);
+  int (*maze_height)(void *context);
+
+  int (*wall_front)(void *context, int half_steps);
+  int (*wall_right)(void *context, int half_steps);
+  int (*wall_left)(void *context, int half_steps);
+  int (*wall_back)(void *context, int half_steps);
+  int (*wall_front_right)(void *context, int half_steps);
+  int (*wall_front_left)(void *context, int half_steps);
+  int (*wall_back_right)(void *context, int half_steps);
+  int (*wall_back_left)(void *context, int half_steps);
+  int (*walls)(void *context, int half_steps);
+
+  int (*move_forward)(void *context, int distance);
+  int (*move_forward_half)(void *context, int distance);
+  void (*turn_right)(void *context);
+  void (*turn_left)(void *context);
+  void (*turn_right_45)(void *context);
+  void (*turn_left_45)(void *context);
+
+  void (*set_wall)(void *context, int x, int y, char direction);
+  void (*clear_wall)(void *context, int x, int y, char direction);
+  void (*set_color)(void *context, int x, int y, char color);
+  void (*clear_color)(void *context, int x, int y);
+  void (*clear_all_color)(void *context);
+  void (*set_text)(void *context, int x, int y, const char *text);
+  void (*clear_text)(void *context, int x, int y);
+  void (*clear_all_text)(void *context);
+
+  int (*was_reset)(void *context);
+  void (*ack_reset)(void *context);
+
+  /* The name is the same as for getStat; -1 if it's unknown or empty */
+  double (*get_stat)(void *context, const char *name);
+
+  /* The points are count pairs of x and y, in semi-positions, as for
+   * drawPath. Appended, so that older plugins still work. */
+  void (*draw_path)(void *context, char color, const int *points, int count);
+  void (*clear_path)(void *context);
+
+  /* Every tile at once, column by column, i.e., the tile at x, y is at index
+   * x * height + y, as for setColorGrid and setTextGrid. Colors are a string
+   * of a char per tile, and texts a string of field_width chars per tile. */
+  void (*set_color_grid)(void *context, const char *colors);
+  void (*set_text_grid)(void *context, int field_width, const char *texts);
+
+  /* A sample of one of the algo's own metrics, as for metric */
+  void (*metric)(void *context, const char *name, double value);
+} mms_api;
+
+typedef void (*mms_plugin_run_function)(const mms_api *api);
+
+/*
+ * Instead of mms_plugin_run, a plugin may export mms_plugin_start,
+ * mms_plugin_resume, and mms_plugin_destroy, for an algo that suspends at
+ * each movement rather than blocking in it (see mms-coro.h). The simulator
+ * starts an instance of the algo for each maze, with a table that stays valid
+ * until the instance is destroyed, then resumes it repeatedly: resume runs
+ * the algo until its next movement, which it returns rather than calling
+ * move_forward and the like, and the simulator performs the movement and
+ * passes whether the mouse moved (nonzero) to the next resume. The run is
+ * over once resume returns MMS_MOVE_NONE, or once the run times out, in which
+ * case the instance is destroyed while it's suspended. Many instances may be
+ * in progress at once, interleaved on the same thread, so each must keep all
+ * of its state to itself.
+ */
+typedef enum {
+  MMS_MOVE_NONE,
+  MMS_MOVE_FORWARD,
+  MMS_MOVE_FORWARD_HALF,
+  MMS_MOVE_TURN_RIGHT,
+  MMS_MOVE_TURN_LEFT,
+  MMS_MOVE_TURN_RIGHT_45,
+  MMS_MOVE_TURN_LEFT_45
+} mms_movement;
+
+typedef struct {
+  int movement; /* an mms_movement */
+  int distance; /* for MMS_MOVE_FORWARD and MMS_MOVE_FORWARD_HALF */
+} mms_move;
+
+typedef void *(*mms_plugin_start_function)(const mms_api *api);
+typedef mms_move (*mms_plugin_resume_function)(void *instance, int moved);
+typedef void (*mms_plugin_destroy_function)(void *instance);
+
+/*
+ * A plugin may also export mms_plugin_batch_start, mms_plugin_batch_step, and
+ * mms_plugin_batch_destroy, to drive many mice at once, one per run, in
+ * lockstep, e.g., to tune an algo's parameters across a large corpus; the
+ * simulator then runs the batch that way instead of maze by maze. Start is
+ * called with the number of mice, the index of the first among all of the
+ * runs (in which each maze's repeats are in a row), and the size of each
+ * mouse's maze. Each step is given what every mouse senses, in arrays indexed
+ * by mouse, and fills in the next movement of every mouse that's still
+ * running. A mouse that's given MMS_MOVE_NONE is done. Only the grid is
+ * simulated: mice move by whole tiles and turn by 90 degrees, and any other
+ * movement stops the mouse with an error.
+ */
+typedef struct {
+  int count;          /* the number of mice */
+  const int *running; /* nonzero for the mice that are still running */
+  const int *walls;   /* the low four bits of walls(context, 1) */
+  const int *moved;   /* whether the last movement happened */
+} mms_batch;
+
+typedef void *(*mms_plugin_batch_start_function)(int count, int first,
+                                                 const int *widths,
+                                                 const int *heights);
+typedef void (*mms_plugin_batch_step_function)(void *batch,
+                                               const mms_batch *mice,
+                                               mms_move *moves);
+typedef void (*mms_plugin_batch_destroy_function)(void *batch);
+
+#endif /* MMS_PLUGIN_H */
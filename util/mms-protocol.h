@@ -0,0 +1,151 @@
+/*
+ * The schema of the mouse API (C99 or later, or C++), shared by the simulator
+ * and the clients, so that the commands of the text and binary protocols
+ * (see the README) are only ever listed here.
+ *
+ * MMS_PROTOCOL_COMMANDS(X) expands X once per command, as
+ *
+ *   X(NAME, OPCODE, TEXT, ARGS, REPLY)
+ *
+ * where OPCODE is the command's byte in the binary protocol, TEXT its name in
+ * the text protocol, ARGS the layout of its arguments in both protocols, and
+ * REPLY what the simulator sends back, NONE meaning nothing at all. Opcodes
+ * must never change, and new commands must take opcodes that aren't used.
+ *
+ * Usage, e.g., to name each opcode:
+ *
+ *   #define NAME_OF(name, opcode, text, args, reply) case opcode: return text;
+ *   switch (opcode) { MMS_PROTOCOL_COMMANDS(NAME_OF) }
+ */
+
+#ifndef MMS_PROTOCOL_H
+#define MMS_PROTOCOL_H
+
+/* The layouts of arguments; in the text protocol, they're separated by
+ * spaces, and in the binary protocol, integers are little-endian uint16s,
+ * chars are single bytes, and texts are prefixed with a byte of length:
+ *
+ *   NONE                  no arguments
+ *   COUNT                 n, which is optional as text, defaulting to 1
+ *   POSITION              x y
+ *   POSITION_AND_CHAR     x y c
+ *   POSITION_AND_TEXT     x y text
+ *   POSITION_AND_INTEGER  x y n, whose binary n is a single byte
+ *   STAT                  a stat's name, or its number as a single byte
+ *   INTEGERS              n1 n2 ..., five per sensor; binary is a count of
+ *                         sensors, then signed integers
+ *   CELLS_AND_CHARS       x1 y1 c1 ...; binary is a count, then cells
+ *   CELLS_AND_TEXTS       x1 y1 n1 text1 ...; likewise
+ *   CHAR_AND_CELLS        c x1 y1 ...; binary is c, then a count, then cells
+ *   GRID_OF_CHARS         ccc...; binary is a count, then the chars
+ *   GRID_OF_TEXTS         n text...; binary n is a byte before the count
+ *   MOVES                 F6 R45 ...; binary is a count, then an opcode and
+ *                         a distance for each step
+ *   NAME_AND_NUMBER       name 1.5; binary is a double, then the name
+ *
+ * and the replies:
+ *
+ *   NONE                  nothing; the command is performed as it arrives
+ *   ACK                   ack
+ *   BOOL                  true or false
+ *   INTEGER               a number, a uint16 in binary
+ *   FLOAT                 a number, a float in binary
+ *   INTEGERS              numbers separated by spaces, uint16s in binary
+ *   MOVE                  ack once the move is done, or crash
+ */
+#define MMS_PROTOCOL_COMMANDS(X)                                           \
+  X(MAZE_WIDTH, 0x01, "mazeWidth", NONE, INTEGER)                          \
+  X(MAZE_HEIGHT, 0x02, "mazeHeight", NONE, INTEGER)                        \
+  X(WALL_FRONT, 0x10, "wallFront", COUNT, BOOL)                            \
+  X(WALL_RIGHT, 0x11, "wallRight", COUNT, BOOL)                            \
+  X(WALL_LEFT, 0x12, "wallLeft", COUNT, BOOL)                              \
+  X(WALL_BACK, 0x13, "wallBack", COUNT, BOOL)                              \
+  X(WALL_FRONT_RIGHT, 0x14, "wallFrontRight", COUNT, BOOL)                 \
+  X(WALL_FRONT_LEFT, 0x15, "wallFrontLeft", COUNT, BOOL)                   \
+  X(WALL_BACK_RIGHT, 0x16, "wallBackRight", COUNT, BOOL)                   \
+  X(WALL_BACK_LEFT, 0x17, "wallBackLeft", COUNT, BOOL)                     \
+  X(WALLS, 0x18, "walls", COUNT, INTEGER)                                  \
+  X(SENSOR_SCAN, 0x19, "sensorScan", NONE, INTEGERS)                       \
+  X(READ_SENSORS, 0x1A, "readSensors", NONE, INTEGERS)                     \
+  X(SET_SENSORS, 0x1B, "setSensors", INTEGERS, BOOL)                       \
+  X(MOVE_FORWARD, 0x20, "moveForward", COUNT, MOVE)                        \
+  X(MOVE_FORWARD_HALF, 0x21, "moveForwardHalf", COUNT, MOVE)               \
+  X(TURN_RIGHT_90, 0x22, "turnRight", NONE, MOVE)                          \
+  X(TURN_LEFT_90, 0x23, "turnLeft", NONE, MOVE)                            \
+  X(TURN_RIGHT_45, 0x24, "turnRight45", NONE, MOVE)                        \
+  X(TURN_LEFT_45, 0x25, "turnLeft45", NONE, MOVE)                          \
+  X(MOVE_SEQUENCE, 0x26, "moveSequence", MOVES, MOVE)                      \
+  X(SET_ASYNC_MOVES, 0x27, "setAsyncMoves", COUNT, ACK)                    \
+  X(WAIT_FOR_MOVES, 0x28, "waitForMoves", NONE, ACK)                       \
+  X(SET_WALL_ACKS, 0x29, "setWallAcks", COUNT, ACK)                        \
+  X(SET_WALL, 0x30, "setWall", POSITION_AND_CHAR, NONE)                    \
+  X(CLEAR_WALL, 0x31, "clearWall", POSITION_AND_CHAR, NONE)                \
+  X(SET_COLOR, 0x32, "setColor", POSITION_AND_CHAR, NONE)                  \
+  X(CLEAR_COLOR, 0x33, "clearColor", POSITION, NONE)                       \
+  X(CLEAR_ALL_COLOR, 0x34, "clearAllColor", NONE, NONE)                    \
+  X(SET_TEXT, 0x35, "setText", POSITION_AND_TEXT, NONE)                    \
+  X(CLEAR_TEXT, 0x36, "clearText", POSITION, NONE)                         \
+  X(CLEAR_ALL_TEXT, 0x37, "clearAllText", NONE, NONE)                      \
+  X(SET_WALLS, 0x38, "setWalls", CELLS_AND_CHARS, NONE)                    \
+  X(SET_COLORS, 0x39, "setColors", CELLS_AND_CHARS, NONE)                  \
+  X(SET_TEXTS, 0x3A, "setTexts", CELLS_AND_TEXTS, NONE)                    \
+  X(DRAW_PATH, 0x3B, "drawPath", CHAR_AND_CELLS, NONE)                     \
+  X(CLEAR_PATH, 0x3C, "clearPath", NONE, NONE)                             \
+  X(SET_COLOR_GRID, 0x3D, "setColorGrid", GRID_OF_CHARS, NONE)             \
+  X(SET_TEXT_GRID, 0x3E, "setTextGrid", GRID_OF_TEXTS, NONE)               \
+  X(SET_WALL_MASK, 0x3F, "setWallMask", POSITION_AND_INTEGER, NONE)        \
+  X(WAS_RESET, 0x40, "wasReset", NONE, BOOL)                               \
+  X(ACK_RESET, 0x41, "ackReset", NONE, ACK)                                \
+  X(GET_STAT, 0x42, "getStat", STAT, FLOAT)                                \
+  X(NEXT_MAZE, 0x43, "nextMaze", NONE, BOOL)                               \
+  X(WAS_RESUMED, 0x44, "wasResumed", NONE, BOOL)                           \
+  X(SET_WALL_GRID, 0x50, "setWallGrid", GRID_OF_CHARS, NONE)               \
+  X(METRIC, 0x51, "metric", NAME_AND_NUMBER, NONE)
+
+/* The stats of getStat, as X(NAME, TEXT), where TEXT is the stat's name in
+ * the text protocol and its position is its number in the binary protocol,
+ * so stats must never be reordered, and new ones must go at the end. The
+ * times are of a real mouse driving the same moves, in seconds, and the
+ * walls are those that the algo declared, compared to the maze's. */
+#define MMS_PROTOCOL_STATS(X)                                              \
+  X(TOTAL_DISTANCE, "total-distance")                                      \
+  X(TOTAL_TURNS, "total-turns")                                            \
+  X(BEST_RUN_DISTANCE, "best-run-distance")                                \
+  X(BEST_RUN_TURNS, "best-run-turns")                                      \
+  X(CURRENT_RUN_DISTANCE, "current-run-distance")                          \
+  X(CURRENT_RUN_TURNS, "current-run-turns")                                \
+  X(TOTAL_EFFECTIVE_DISTANCE, "total-effective-distance")                  \
+  X(BEST_RUN_EFFECTIVE_DISTANCE, "best-run-effective-distance")            \
+  X(CURRENT_RUN_EFFECTIVE_DISTANCE, "current-run-effective-distance")      \
+  X(SCORE, "score")                                                        \
+  X(TOTAL_TIME, "total-time")                                              \
+  X(BEST_RUN_TIME, "best-run-time")                                        \
+  X(CURRENT_RUN_TIME, "current-run-time")                                  \
+  X(CORRECT_WALLS, "correct-walls")                                        \
+  X(WRONG_WALLS, "wrong-walls")                                            \
+  X(UNDISCOVERED_WALLS, "undiscovered-walls")
+
+/* Other names that the text protocol accepts, as X(TEXT, NAME) */
+#define MMS_PROTOCOL_ALIASES(X)          \
+  X("turnRight90", TURN_RIGHT_90)        \
+  X("turnLeft90", TURN_LEFT_90)
+
+/* The single-byte responses of the binary protocol */
+#define MMS_RESPONSE_FALSE 0x00
+#define MMS_RESPONSE_TRUE 0x01
+#define MMS_RESPONSE_ACK 0x02
+#define MMS_RESPONSE_CRASH 0x03
+#define MMS_RESPONSE_INVALID 0xFF
+
+/* The opcodes, e.g., MMS_OP_WALL_FRONT */
+#define MMS_PROTOCOL_OPCODE(name, opcode, text, args, reply) \
+  MMS_OP_##name = opcode,
+typedef enum { MMS_PROTOCOL_COMMANDS(MMS_PROTOCOL_OPCODE) } mms_opcode;
+#undef MMS_PROTOCOL_OPCODE
+
+/* The stats' binary numbers, e.g., MMS_TOTAL_DISTANCE, then their count */
+#define MMS_PROTOCOL_STAT(name, text) MMS_##name,
+typedef enum { MMS_PROTOCOL_STATS(MMS_PROTOCOL_STAT) MMS_NUM_STATS } mms_stat;
+#undef MMS_PROTOCOL_STAT
+
+#endif /* MMS_PROTOCOL_H */
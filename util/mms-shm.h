@@ -0,0 +1,181 @@
+/*
+ * Client for the simulator's shared-memory transport (POSIX, C11 or C++11).
+ *
+ * When the simulator is run with --shared-memory, each algo process is given
+ * the path of a memory-mapped file in the MMS_SHM_PATH environment variable.
+ * Commands and responses use the binary protocol (see the README), passed
+ * through a pair of single-producer, single-consumer ring buffers in the file:
+ *
+ *   [0, 64)             magic ("MMS1"), capacity
+ *   [64, 192 + C)       command ring: head at +0, tail at +64, data at +128
+ *   [192 + C, 320 + 2C) response ring: same as above
+ *
+ * Usage:
+ *
+ *   mms_shm shm;
+ *   if (mms_shm_open(&shm) != 0) { ... }
+ *   unsigned char command[3] = {0x10, 0x01, 0x00};  // wallFront 1
+ *   mms_shm_write(&shm, command, sizeof(command));
+ *   unsigned char response;
+ *   mms_shm_read_exact(&shm, &response, 1);
+ */
+
+#ifndef MMS_SHM_H
+#define MMS_SHM_H
+
+/* For nanosleep in strict C11 mode; include this header first */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The rings' counters are plain aligned words, which C and C++ each access
+ * through their own atomics, as the simulator does */
+#ifdef __cplusplus
+#include <atomic>
+typedef std::atomic<uint32_t> mms_shm_word;
+#define MMS_SHM_LOAD(word, order) (word)->load(std::memory_order_##order)
+#define MMS_SHM_STORE(word, value, order) \
+  (word)->store(value, std::memory_order_##order)
+#else
+#include <stdatomic.h>
+typedef _Atomic uint32_t mms_shm_word;
+#define MMS_SHM_LOAD(word, order) \
+  atomic_load_explicit(word, memory_order_##order)
+#define MMS_SHM_STORE(word, value, order) \
+  atomic_store_explicit(word, value, memory_order_##order)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MMS_SHM_MAGIC 0x31534d4du
+#define MMS_SHM_HEADER_SIZE 64
+#define MMS_SHM_RING_HEADER_SIZE 128
+
+typedef struct {
+  unsigned char *memory;
+  uint32_t capacity;
+} mms_shm;
+
+static mms_shm_word *mms_shm_atomic(const mms_shm *shm, size_t offset) {
+  return (mms_shm_word *)(shm->memory + offset);
+}
+
+/* Spin briefly, then sleep, so that an idle algo doesn't hog a core */
+static void mms_shm_wait(unsigned *spins) {
+  if (*spins < 1000) {
+    *spins += 1;
+    sched_yield();
+  } else {
+    struct timespec duration = {0, 50000};
+    nanosleep(&duration, NULL);
+  }
+}
+
+/* Returns 0 on success */
+static int mms_shm_open(mms_shm *shm) {
+  const char *path = getenv("MMS_SHM_PATH");
+  if (path == NULL) {
+    return -1;
+  }
+  int fd = open(path, O_RDWR);
+  if (fd < 0) {
+    return -1;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return -1;
+  }
+  void *memory =
+      mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return -1;
+  }
+  shm->memory = (unsigned char *)memory;
+  if (MMS_SHM_LOAD(mms_shm_atomic(shm, 0), acquire) != MMS_SHM_MAGIC) {
+    return -1;
+  }
+  shm->capacity = MMS_SHM_LOAD(mms_shm_atomic(shm, 4), relaxed);
+  return 0;
+}
+
+/* Writes all of the bytes, waiting for space if the ring is full */
+static void mms_shm_write(mms_shm *shm, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  size_t offset = MMS_SHM_HEADER_SIZE;
+  mms_shm_word *head = mms_shm_atomic(shm, offset);
+  mms_shm_word *tail = mms_shm_atomic(shm, offset + 64);
+  unsigned char *buffer = shm->memory + offset + MMS_SHM_RING_HEADER_SIZE;
+  unsigned spins = 0;
+  while (size > 0) {
+    uint32_t start = MMS_SHM_LOAD(head, relaxed);
+    uint32_t end = MMS_SHM_LOAD(tail, acquire);
+    uint32_t space = shm->capacity - (start - end);
+    if (space == 0) {
+      mms_shm_wait(&spins);
+      continue;
+    }
+    uint32_t count = size < space ? (uint32_t)size : space;
+    for (uint32_t i = 0; i < count; i += 1) {
+      buffer[(start + i) % shm->capacity] = bytes[i];
+    }
+    MMS_SHM_STORE(head, start + count, release);
+    bytes += count;
+    size -= count;
+  }
+}
+
+/* Reads at least one byte (and at most size), waiting if none are ready */
+static size_t mms_shm_read(mms_shm *shm, void *data, size_t size) {
+  unsigned char *bytes = (unsigned char *)data;
+  size_t offset =
+      MMS_SHM_HEADER_SIZE + MMS_SHM_RING_HEADER_SIZE + shm->capacity;
+  mms_shm_word *head = mms_shm_atomic(shm, offset);
+  mms_shm_word *tail = mms_shm_atomic(shm, offset + 64);
+  unsigned char *buffer = shm->memory + offset + MMS_SHM_RING_HEADER_SIZE;
+  unsigned spins = 0;
+  for (;;) {
+    uint32_t end = MMS_SHM_LOAD(head, acquire);
+    uint32_t start = MMS_SHM_LOAD(tail, relaxed);
+    uint32_t used = end - start;
+    if (used == 0) {
+      mms_shm_wait(&spins);
+      continue;
+    }
+    uint32_t count = size < used ? (uint32_t)size : used;
+    for (uint32_t i = 0; i < count; i += 1) {
+      bytes[i] = buffer[(start + i) % shm->capacity];
+    }
+    MMS_SHM_STORE(tail, start + count, release);
+    return count;
+  }
+}
+
+/* Reads exactly size bytes, e.g., a whole response */
+static void mms_shm_read_exact(mms_shm *shm, void *data, size_t size) {
+  unsigned char *bytes = (unsigned char *)data;
+  while (size > 0) {
+    size_t count = mms_shm_read(shm, bytes, size);
+    bytes += count;
+    size -= count;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MMS_SHM_H */
@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Builds mms-flood and soaks the simulator with it for a while, writing the
+# time series to stdout and failing if the simulator's memory or latency
+# drifts (see --soak), e.g., for an hour against the bundled mazes:
+#
+#   util/mms-soak.sh 3600 [mazes...]
+#
+# The simulator is found at ../bin/mms (relative to the repo, where qmake
+# puts it), unless MMS is set; FLOOD is passed to mms-flood, e.g., "-n 20000".
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MMS=${MMS:-$ROOT/../bin/mms}
+SECONDS_TO_SOAK=${1:-3600}
+if [ $# -gt 0 ]; then
+  shift
+fi
+if [ $# -eq 0 ]; then
+  set -- "$ROOT"/src/resources/mazes/*
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cc -O2 -std=c11 -o "$WORK/mms-flood" "$ROOT/util/mms-flood.c" || exit 1
+
+"$MMS" --headless --soak "$SECONDS_TO_SOAK" --directory "$WORK" \
+  --run-command "$WORK/mms-flood -p binary $FLOOD" "$@"
@@ -0,0 +1,133 @@
+"""Vectorized environments of the simulator, for training policies.
+
+Many episodes of a mouse in a maze are stepped together by the simulator, run
+headless with --env-server, through a memory-mapped file that this module
+creates (see src/EnvServer.cpp for its layout). Each call is one handoff of
+contiguous arrays, which numpy views in place, so nothing is copied or parsed.
+
+Usage:
+
+    from mms_env import VectorEnv
+    env = VectorEnv("bin/mms", ["mazes/a.txt", "mazes/b.txt"], count=4096)
+    observations = env.reset()
+    while training:
+        actions = policy(observations)  # e.g., MOVE_STRAIGHT or TURN_LEFT_90
+        observations, rewards, outcomes = env.step(actions)
+    env.close()
+
+Episode i is run on maze i modulo the number of mazes. The observations are
+a dict of int32 arrays, indexed by episode: "walls", a mask of the blocked
+semi-directions around the mouse (bit i is SEMI_DIRECTIONS[i]), "x" and "y",
+its semi-position (tile centers are odd, edges are even), "direction", an
+index into SEMI_DIRECTIONS, and "steps", of the episode so far. Moving into
+a wall is a crash (a reward of -1) and reaching the center is a finish (a
+reward of 1), and either ends the episode, as does reaching max_steps; the
+next step then restarts it, ignoring its action.
+"""
+
+import mmap
+import os
+import subprocess
+import tempfile
+import time
+
+import numpy as np
+
+MOVE_STRAIGHT = 0
+TURN_RIGHT_45 = 1
+TURN_RIGHT_90 = 2
+TURN_LEFT_45 = 3
+TURN_LEFT_90 = 4
+
+RUNNING = 0
+FINISHED = 1
+CRASHED = 2
+TRUNCATED = 3
+
+SEMI_DIRECTIONS = ("N", "S", "E", "W", "NE", "SE", "NW", "SW")
+
+MAGIC = 0x45534D4D
+HEADER_SIZE = 64
+NUM_ARRAYS = 8
+RESET = 0
+STEP = 1
+CLOSE = 2
+
+
+class VectorEnv:
+    def __init__(self, mms, mazes, count, max_steps=10000):
+        fd, self._path = tempfile.mkstemp(prefix="mms-env-")
+        size = HEADER_SIZE + NUM_ARRAYS * 4 * count
+        os.ftruncate(fd, size)
+        self._memory = mmap.mmap(fd, size)
+        os.close(fd)
+        header = np.frombuffer(self._memory, np.uint32, 16, 0)
+        header[1] = count
+        header[2] = max_steps
+        header[0] = MAGIC
+
+        def array(index, dtype=np.int32):
+            return np.frombuffer(
+                self._memory, dtype, count, HEADER_SIZE + 4 * count * index
+            )
+
+        self._header = header
+        self._actions = array(0)
+        self._observations = {
+            "walls": array(1),
+            "x": array(2),
+            "y": array(3),
+            "direction": array(4),
+            "steps": array(7),
+        }
+        self._rewards = array(5, np.float32)
+        self._outcomes = array(6)
+        self._server = subprocess.Popen(
+            [mms, "--headless", "--env-server", self._path, *mazes]
+        )
+
+    def reset(self):
+        self._request(RESET)
+        return self._observations
+
+    def step(self, actions):
+        self._actions[:] = actions
+        self._request(STEP)
+        return self._observations, self._rewards, self._outcomes
+
+    def close(self):
+        if self._server is None:
+            return
+        try:
+            self._request(CLOSE)
+            self._server.wait()
+        finally:
+            self._release()
+
+    def __del__(self):
+        if getattr(self, "_server", None) is not None:
+            self._server.kill()
+            self._server.wait()
+            self._release()
+
+    def _release(self):
+        # The views of the arrays have to go before the mapping can close
+        self._server = None
+        del self._header, self._actions, self._observations
+        del self._rewards, self._outcomes
+        os.remove(self._path)
+        self._memory.close()
+
+    def _request(self, command):
+        # The arrays are only valid until the next request, as the server
+        # writes them in place; spin briefly, then sleep, like the server
+        self._header[3] = command
+        request = (int(self._header[4]) + 1) & 0xFFFFFFFF
+        self._header[4] = request
+        spins = 0
+        while self._header[5] != request:
+            if self._server.poll() is not None:
+                raise RuntimeError("The env server exited")
+            spins += 1
+            if 1000 < spins:
+                time.sleep(0.001)